@@ -0,0 +1,115 @@
+/**
+ * Unit tests for engine log decoding
+ * Tests record layout decoding and printf-style formatting
+ */
+
+import {
+  ARG_KIND_DOUBLE,
+  ARG_KIND_INT,
+  ARG_KIND_STRING,
+  LOG_RECORD_SIZE,
+  decodeLogRecords,
+  formatLogMessage,
+  readCString,
+} from "@/app/lib/engineLog";
+
+function writeCString(bytes: Uint8Array, ptr: number, str: string): void {
+  for (let i = 0; i < str.length; i++) {
+    bytes[ptr + i] = str.charCodeAt(i);
+  }
+  bytes[ptr + str.length] = 0;
+}
+
+describe("engineLog", () => {
+  describe("formatLogMessage", () => {
+    it("should substitute integer, float and string arguments", () => {
+      const message = formatLogMessage(
+        "state %s after %d frames (%.2f ms)",
+        [0, 42, 16.6667],
+        [ARG_KIND_STRING, ARG_KIND_INT, ARG_KIND_DOUBLE],
+        ["speaking"]
+      );
+      expect(message).toBe("state speaking after 42 frames (16.67 ms)");
+    });
+
+    it("should give each string argument its own text", () => {
+      const message = formatLogMessage(
+        "transition not allowed: %s -> %s (%d)",
+        [0, 0, 3],
+        [ARG_KIND_STRING, ARG_KIND_STRING, ARG_KIND_INT],
+        ["idle", "talking"]
+      );
+      expect(message).toBe("transition not allowed: idle -> talking (3)");
+    });
+
+    it("should keep literal percent signs and missing arguments", () => {
+      expect(formatLogMessage("100%% %d %d", [7], [ARG_KIND_INT], [])).toBe(
+        "100% 7 %d"
+      );
+    });
+  });
+
+  describe("decodeLogRecords", () => {
+    it("should decode records from the wasm32 layout", () => {
+      const buffer = new ArrayBuffer(1024);
+      const bytes = new Uint8Array(buffer);
+      const view = new DataView(buffer);
+
+      const formatPtr = 16;
+      writeCString(bytes, formatPtr, "Failed to load avatar model: %s");
+
+      const recordPtr = 256;
+      view.setFloat64(recordPtr, 1234.5, true);
+      view.setUint32(recordPtr + 8, formatPtr, true);
+      view.setUint32(recordPtr + 12, 3, true); // error
+      view.setUint32(recordPtr + 16, 1, true);
+      view.setUint32(recordPtr + 20, ARG_KIND_STRING, true);
+      writeCString(bytes, recordPtr + 56, "bad magic");
+
+      const cache = new Map<number, string>();
+      const records = decodeLogRecords(buffer, recordPtr, 1, cache);
+
+      expect(records).toEqual([
+        {
+          timeMs: 1234.5,
+          level: "error",
+          message: "Failed to load avatar model: bad magic",
+        },
+      ]);
+      expect(cache.get(formatPtr)).toBe("Failed to load avatar model: %s");
+      expect(LOG_RECORD_SIZE).toBe(120);
+    });
+
+    it("should read the Nth string argument from the Nth text slot", () => {
+      const buffer = new ArrayBuffer(1024);
+      const bytes = new Uint8Array(buffer);
+      const view = new DataView(buffer);
+
+      const formatPtr = 16;
+      writeCString(bytes, formatPtr, "Preloaded clip %s for state %s");
+
+      const recordPtr = 256;
+      view.setUint32(recordPtr + 8, formatPtr, true);
+      view.setUint32(recordPtr + 12, 0, true); // debug
+      view.setUint32(recordPtr + 16, 2, true);
+      view.setUint32(
+        recordPtr + 20,
+        ARG_KIND_STRING | (ARG_KIND_STRING << 2),
+        true
+      );
+      writeCString(bytes, recordPtr + 56, "wave");
+      writeCString(bytes, recordPtr + 88, "greeting");
+
+      const records = decodeLogRecords(buffer, recordPtr, 1, new Map());
+      expect(records[0].message).toBe("Preloaded clip wave for state greeting");
+    });
+  });
+
+  describe("readCString", () => {
+    it("should stop at the null terminator", () => {
+      const buffer = new ArrayBuffer(32);
+      writeCString(new Uint8Array(buffer), 4, "idle");
+      expect(readCString(buffer, 4)).toBe("idle");
+    });
+  });
+});
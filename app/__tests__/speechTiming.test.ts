@@ -0,0 +1,47 @@
+/**
+ * Unit tests for speech cache timing encoding
+ * Tests the base64 round trip and rejection of malformed timing
+ */
+
+import {
+  MAX_TIMING_VALUES,
+  decodeSpeechTiming,
+  encodeSpeechTiming,
+  isSpeechCacheKey,
+  isValidTiming,
+} from "@/app/lib/speechTiming";
+
+describe("speechTiming", () => {
+  it("should round-trip timing through base64", () => {
+    const timing = new Float32Array([0, 0.12, 0.31, 0.58, 1.25]);
+    const decoded = decodeSpeechTiming(encodeSpeechTiming(timing));
+    expect(decoded).not.toBeNull();
+    expect(Array.from(decoded!)).toEqual(Array.from(timing));
+  });
+
+  it("should encode little-endian float32", () => {
+    // 1.0f is 00 00 80 3f
+    expect(encodeSpeechTiming(new Float32Array([0, 1]))).toBe("AAAAAAAAgD8=");
+  });
+
+  it("should reject malformed timing", () => {
+    expect(decodeSpeechTiming("not base64!")).toBeNull();
+    expect(decodeSpeechTiming("AAAAAAA=")).toBeNull(); // 5 bytes
+    expect(decodeSpeechTiming(encodeSpeechTiming(new Float32Array([0.5, 0.2])))).toBeNull();
+    expect(decodeSpeechTiming(encodeSpeechTiming(new Float32Array([0, NaN])))).toBeNull();
+    expect(decodeSpeechTiming(encodeSpeechTiming(new Float32Array([0.1])))).toBeNull();
+  });
+
+  it("should bound the number of values", () => {
+    const ramp = (n: number) => new Float32Array(n).map((_, i) => i * 0.01);
+    expect(isValidTiming(ramp(MAX_TIMING_VALUES))).toBe(true);
+    expect(isValidTiming(ramp(MAX_TIMING_VALUES + 1))).toBe(false);
+  });
+
+  it("should accept only 16 lowercase hex digit keys", () => {
+    expect(isSpeechCacheKey("0dacb180b9dde1fe")).toBe(true);
+    expect(isSpeechCacheKey("0DACB180B9DDE1FE")).toBe(false);
+    expect(isSpeechCacheKey("0dacb180")).toBe(false);
+    expect(isSpeechCacheKey(null)).toBe(false);
+  });
+});
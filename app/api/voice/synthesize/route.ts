@@ -6,8 +6,20 @@
  *
  * Request: { text: string, voice_id: string, emotion?: string }
  * Response: Audio blob (MP3 format)
+ *
+ * With SPEECH_CACHE_SOCKET set, replies are served from the native speech
+ * cache when the same text was voiced before. X-Speech-Cache says hit or
+ * miss, and X-Speech-Cache-Key names the entry. A hit also carries the
+ * viseme timing a client aligned to that audio (X-Viseme-Timing), if one
+ * was uploaded to /api/voice/synthesize/timing.
  */
 
+import { lookupSpeech, storeSpeech } from "@/app/lib/speechCache";
+import {
+  SPEECH_CACHE_KEY_HEADER,
+  SPEECH_TIMING_HEADER,
+} from "@/app/lib/speechTiming";
+
 export const runtime = "nodejs";
 export const maxDuration = 60; // 1 minute timeout for synthesis
 
@@ -30,6 +42,22 @@ export async function POST(req: Request) {
       );
     }
 
+    // Repeated replies skip synthesis (and the client's alignment)
+    const cached = await lookupSpeech(String(voice_id), String(emotion), text);
+    if (cached?.audio) {
+      const headers: Record<string, string> = {
+        "Content-Type": "audio/mpeg",
+        "Content-Length": cached.audio.byteLength.toString(),
+        "Cache-Control": "public, max-age=86400",
+        "X-Speech-Cache": "hit",
+        [SPEECH_CACHE_KEY_HEADER]: cached.key,
+      };
+      if (cached.timing) {
+        headers[SPEECH_TIMING_HEADER] = Buffer.from(cached.timing).toString("base64");
+      }
+      return new Response(cached.audio, { status: 200, headers });
+    }
+
     const apiKey = process.env.ELEVENLABS_API_KEY;
     if (!apiKey) {
       return Response.json(
@@ -102,15 +130,25 @@ export async function POST(req: Request) {
     // Stream audio directly to client
     const audioBuffer = await response.arrayBuffer();
 
+    const headers: Record<string, string> = {
+      "Content-Type": "audio/mpeg",
+      "Content-Length": audioBuffer.byteLength.toString(),
+      "Cache-Control": "public, max-age=86400", // Cache for 24 hours
+    };
+    if (cached) {
+      // The reply doesn't wait for the store
+      void storeSpeech(
+        String(voice_id),
+        String(emotion),
+        text,
+        new Uint8Array(audioBuffer)
+      );
+      headers["X-Speech-Cache"] = "miss";
+      headers[SPEECH_CACHE_KEY_HEADER] = cached.key;
+    }
+
     // Return audio as MP3
-    return new Response(audioBuffer, {
-      status: 200,
-      headers: {
-        "Content-Type": "audio/mpeg",
-        "Content-Length": audioBuffer.byteLength.toString(),
-        "Cache-Control": "public, max-age=86400", // Cache for 24 hours
-      },
-    });
+    return new Response(audioBuffer, { status: 200, headers });
   } catch (error) {
     console.error("Synthesis error:", error);
 
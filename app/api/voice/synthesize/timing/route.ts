@@ -0,0 +1,41 @@
+/**
+ * POST /api/voice/synthesize/timing
+ *
+ * Attach the viseme timing a client aligned to synthesized speech to its
+ * speech cache entry, so the next hit for the same reply plays it
+ * without aligning again.
+ *
+ * Request: { key: string, timing: string }
+ *   key: X-Speech-Cache-Key of the synthesis response
+ *   timing: base64 float32 timing (see app/lib/speechTiming.ts)
+ * Response: { stored: boolean }
+ */
+
+import { storeSpeechTiming } from "@/app/lib/speechCache";
+import { decodeSpeechTiming, isSpeechCacheKey } from "@/app/lib/speechTiming";
+
+export const runtime = "nodejs";
+
+export async function POST(req: Request) {
+  try {
+    const { key, timing } = await req.json();
+    const values = typeof timing === "string" ? decodeSpeechTiming(timing) : null;
+
+    if (!isSpeechCacheKey(key) || !values) {
+      return Response.json(
+        { error: "key and valid timing required" },
+        { status: 400 }
+      );
+    }
+
+    const bytes = new Uint8Array(values.buffer, values.byteOffset, values.byteLength);
+    const stored = await storeSpeechTiming(key, bytes);
+    return Response.json({ stored }, { status: 200 });
+  } catch (error) {
+    console.error("Speech timing error:", error);
+    return Response.json(
+      { error: "Failed to store speech timing" },
+      { status: 500 }
+    );
+  }
+}
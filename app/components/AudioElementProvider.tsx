@@ -1,19 +1,55 @@
 "use client";
 
 import React, { createContext, useContext, useState } from "react";
+import type { SpeechCacheEntry } from "@/app/lib/speechTiming";
 
 interface AudioElementContextType {
   audioElement: HTMLAudioElement | null;
   setAudioElement: (element: HTMLAudioElement | null) => void;
+  // Text of the reply being voiced, known before its audio arrives
+  speechText: string;
+  setSpeechText: (text: string) => void;
+  // Its synthesized audio, for aligning the planned mouth shapes
+  speechAudio: Blob | null;
+  setSpeechAudio: (audio: Blob | null) => void;
+  // The same audio as it downloads (MP3), for streamed playback
+  speechStream: ReadableStream<Uint8Array> | null;
+  setSpeechStream: (stream: ReadableStream<Uint8Array> | null) => void;
+  // Its speech cache entry; cached timing replaces alignment
+  speechCache: SpeechCacheEntry | null;
+  setSpeechCache: (entry: SpeechCacheEntry | null) => void;
+  // Live microphone while VoiceRecorder records, for voice activity
+  microphoneStream: MediaStream | null;
+  setMicrophoneStream: (stream: MediaStream | null) => void;
 }
 
 const AudioElementContext = createContext<AudioElementContextType | undefined>(undefined);
 
 export function AudioElementProvider({ children }: { children: React.ReactNode }) {
   const [audioElement, setAudioElement] = useState<HTMLAudioElement | null>(null);
+  const [speechText, setSpeechText] = useState("");
+  const [speechAudio, setSpeechAudio] = useState<Blob | null>(null);
+  const [speechStream, setSpeechStream] = useState<ReadableStream<Uint8Array> | null>(null);
+  const [speechCache, setSpeechCache] = useState<SpeechCacheEntry | null>(null);
+  const [microphoneStream, setMicrophoneStream] = useState<MediaStream | null>(null);
 
   return (
-    <AudioElementContext.Provider value={{ audioElement, setAudioElement }}>
+    <AudioElementContext.Provider
+      value={{
+        audioElement,
+        setAudioElement,
+        speechText,
+        setSpeechText,
+        speechAudio,
+        setSpeechAudio,
+        speechStream,
+        setSpeechStream,
+        speechCache,
+        setSpeechCache,
+        microphoneStream,
+        setMicrophoneStream,
+      }}
+    >
       {children}
     </AudioElementContext.Provider>
   );
@@ -7,6 +7,8 @@ import {
   type AnimationState,
 } from "@/app/lib/avatarController";
 import { getWasmLazyLoader } from "@/app/lib/wasmLazyLoader";
+import { getPerformanceMonitor } from "@/app/lib/performanceMonitor";
+import { encodeSpeechTiming, type SpeechCacheEntry } from "@/app/lib/speechTiming";
 import { useAvatarConfig } from "./AvatarConfigProvider";
 
 interface MorphTargets {
@@ -14,6 +16,12 @@ interface MorphTargets {
   mouthRound: number;
   eyesLookUp: number;
   eyesClose: number;
+  audioTimeMs?: number;
+  analysisTimeMs?: number;
+  audioSamples?: Float32Array;
+  audioSampleRate?: number;
+  speechTimeSeconds?: number;
+  speechDurationSeconds?: number;
 }
 
 interface AvatarCanvasProps {
@@ -21,6 +29,41 @@ interface AvatarCanvasProps {
   morphTargets?: MorphTargets;
   onReady?: () => void;
   onError?: (error: Error) => void;
+  /** Show the engine's perf overlay (also enabled by ?perfhud in the URL) */
+  showPerfHud?: boolean;
+  /** Microphone to watch for speech; the avatar listens while it hears some */
+  microphoneStream?: MediaStream | null;
+  /** Text about to be spoken; the mouth is planned from it before audio */
+  speechText?: string;
+  /** Synthesized audio of speechText; the planned mouth is aligned to it */
+  speechAudio?: Blob | null;
+  /** The same audio as it downloads; played (and analysed) while streaming */
+  speechStream?: ReadableStream<Uint8Array> | null;
+  /** Speech cache entry of that audio; its timing replaces alignment */
+  speechCache?: SpeechCacheEntry | null;
+}
+
+/**
+ * Give the speech cache the timing this client aligned, so the next hit
+ * for the same reply skips alignment. timedKey remembers the entry that
+ * has timing already (cached or uploaded).
+ */
+function offerSpeechTiming(
+  controller: AvatarInstance | null,
+  entry: SpeechCacheEntry | null,
+  timedKey: { current: string | null }
+): void {
+  if (!controller || !entry || entry.key === timedKey.current) return;
+  const timing = controller.getSpeechTiming();
+  if (!timing) return;
+  timedKey.current = entry.key;
+  fetch("/api/voice/synthesize/timing", {
+    method: "POST",
+    headers: { "Content-Type": "application/json" },
+    body: JSON.stringify({ key: entry.key, timing: encodeSpeechTiming(timing) }),
+  }).catch((error) => {
+    console.warn("[AvatarCanvas] Speech timing upload failed:", error);
+  });
 }
 
 export default function AvatarCanvas({
@@ -28,13 +71,22 @@ export default function AvatarCanvas({
   morphTargets,
   onReady,
   onError,
+  showPerfHud = false,
+  microphoneStream = null,
+  speechText,
+  speechAudio = null,
+  speechStream = null,
+  speechCache = null,
 }: AvatarCanvasProps) {
   const canvasRef = useRef<HTMLCanvasElement>(null);
   const controllerRef = useRef<AvatarInstance | null>(null);
+  const speechCacheRef = useRef<SpeechCacheEntry | null>(null);
+  const timedCacheKeyRef = useRef<string | null>(null);  // has timing
   const [isLoading, setIsLoading] = useState(true);
   const [error, setError] = useState<string | null>(null);
   const [fps, setFps] = useState(0);
   const fpsIntervalRef = useRef<NodeJS.Timeout | null>(null);
+  const telemetryIntervalRef = useRef<NodeJS.Timeout | null>(null);
 
   const { config } = useAvatarConfig();
 
@@ -113,6 +165,23 @@ export default function AvatarCanvas({
             setFps(Math.round(controllerRef.current.getFrameRate()));
           }
         }, 500);
+
+        // Sample engine frame time percentiles into telemetry once a minute
+        telemetryIntervalRef.current = setInterval(() => {
+          if (controllerRef.current) {
+            const stats = controllerRef.current.getFrameTimeStats();
+            if (stats.count > 0) {
+              getPerformanceMonitor().recordEngineFrameTimes(stats);
+            }
+            controllerRef.current.resetFrameTimeStats();
+
+            const latency = controllerRef.current.getAudioLatencyStats();
+            if (latency.count > 0) {
+              getPerformanceMonitor().recordAudioLatency(latency.p50);
+            }
+            controllerRef.current.resetAudioLatencyStats();
+          }
+        }, 60000);
       } catch (err) {
         if (!cancelled) {
           const errorMsg = err instanceof Error ? err.message : String(err);
@@ -131,6 +200,9 @@ export default function AvatarCanvas({
       if (fpsIntervalRef.current) {
         clearInterval(fpsIntervalRef.current);
       }
+      if (telemetryIntervalRef.current) {
+        clearInterval(telemetryIntervalRef.current);
+      }
       if (controllerRef.current) {
         controllerRef.current.cleanup();
         controllerRef.current = null;
@@ -145,6 +217,63 @@ export default function AvatarCanvas({
     }
   }, [animationState, isLoading]);
 
+  // Toggle the engine perf overlay
+  useEffect(() => {
+    if (controllerRef.current && !isLoading) {
+      const fromUrl = new URLSearchParams(window.location.search).has("perfhud");
+      controllerRef.current.setPerfHudEnabled(showPerfHud || fromUrl);
+    }
+  }, [showPerfHud, isLoading]);
+
+  // Feed the microphone to the engine's voice activity detector
+  useEffect(() => {
+    const controller = controllerRef.current;
+    if (!controller || isLoading) return;
+    controller.setMicrophoneStream(microphoneStream);
+    return () => controller.setMicrophoneStream(null);
+  }, [microphoneStream, isLoading]);
+
+  // Plan lip-sync from the reply text while its audio is synthesized
+  useEffect(() => {
+    if (controllerRef.current && !isLoading && speechText) {
+      controllerRef.current.planSpeech(speechText);
+    }
+  }, [speechText, isLoading]);
+
+  // A cache hit brings timing aligned earlier; it replaces alignment
+  useEffect(() => {
+    speechCacheRef.current = speechCache;
+    const controller = controllerRef.current;
+    if (controller && !isLoading && speechCache?.timing &&
+        controller.applySpeechTiming(speechCache.timing)) {
+      timedCacheKeyRef.current = speechCache.key;
+    }
+  }, [speechCache, isLoading]);
+
+  // Retime that plan to the synthesized audio once it arrives
+  useEffect(() => {
+    if (controllerRef.current && !isLoading && speechAudio) {
+      controllerRef.current.alignSpeech(speechAudio).then((keys) => {
+        if (keys > 0) {
+          offerSpeechTiming(controllerRef.current, speechCacheRef.current,
+                            timedCacheKeyRef);
+        }
+      });
+    }
+  }, [speechAudio, isLoading]);
+
+  // Speak the reply while it downloads (aligning it as decoding ends)
+  useEffect(() => {
+    if (controllerRef.current && !isLoading && speechStream) {
+      controllerRef.current.playSpeechStream(speechStream).then((streamed) => {
+        if (streamed) {
+          offerSpeechTiming(controllerRef.current, speechCacheRef.current,
+                            timedCacheKeyRef);
+        }
+      });
+    }
+  }, [speechStream, isLoading]);
+
   // Update morph targets for lip-sync
   useEffect(() => {
     if (controllerRef.current && !isLoading && morphTargets) {
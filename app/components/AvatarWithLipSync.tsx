@@ -27,7 +27,14 @@ export default function AvatarWithLipSync({
   onAvatarReady,
   onAvatarError,
 }: AvatarWithLipSyncProps) {
-  const { audioElement: contextAudioElement } = useAudioElement();
+  const {
+    audioElement: contextAudioElement,
+    speechText,
+    speechAudio,
+    speechStream,
+    speechCache,
+    microphoneStream,
+  } = useAudioElement();
   const [activeAudioElement, setActiveAudioElement] = useState<HTMLAudioElement | null>(null);
 
   // Use provided audio element or fall back to context
@@ -68,6 +75,11 @@ export default function AvatarWithLipSync({
         morphTargets={morphTargets}
         onReady={handleAvatarReady}
         onError={handleAvatarError}
+        speechText={speechText}
+        speechAudio={speechAudio}
+        speechStream={speechStream}
+        speechCache={speechCache}
+        microphoneStream={microphoneStream}
         threshold={0}
         rootMargin="100px"
       />
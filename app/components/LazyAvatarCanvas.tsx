@@ -3,12 +3,15 @@
 import { useEffect, useRef, useState } from "react";
 import AvatarCanvas from "./AvatarCanvas";
 import type { AnimationState } from "@/app/lib/avatarController";
+import type { SpeechCacheEntry } from "@/app/lib/speechTiming";
 
 interface MorphTargets {
   mouthOpen: number;
   mouthRound: number;
   eyesLookUp: number;
   eyesClose: number;
+  audioTimeMs?: number;
+  analysisTimeMs?: number;
 }
 
 interface LazyAvatarCanvasProps {
@@ -16,6 +19,16 @@ interface LazyAvatarCanvasProps {
   morphTargets?: MorphTargets;
   onReady?: () => void;
   onError?: (error: Error) => void;
+  /** Microphone to watch for speech (see AvatarCanvas) */
+  microphoneStream?: MediaStream | null;
+  /** Text about to be spoken (see AvatarCanvas) */
+  speechText?: string;
+  /** Synthesized audio of speechText (see AvatarCanvas) */
+  speechAudio?: Blob | null;
+  /** The same audio as it downloads (see AvatarCanvas) */
+  speechStream?: ReadableStream<Uint8Array> | null;
+  /** Speech cache entry of that audio (see AvatarCanvas) */
+  speechCache?: SpeechCacheEntry | null;
   /** Threshold for IntersectionObserver (default: "0px", meaning trigger when 1px is visible) */
   threshold?: number | number[];
   /** Root margin for IntersectionObserver (default: "100px", start loading 100px before visible) */
@@ -40,6 +53,11 @@ export default function LazyAvatarCanvas({
   morphTargets,
   onReady,
   onError,
+  microphoneStream,
+  speechText,
+  speechAudio,
+  speechStream,
+  speechCache,
   threshold = 0,
   rootMargin = "100px", // Start loading 100px before visible
 }: LazyAvatarCanvasProps) {
@@ -118,6 +136,11 @@ export default function LazyAvatarCanvas({
           morphTargets={morphTargets}
           onReady={handleReady}
           onError={handleError}
+          microphoneStream={microphoneStream}
+          speechText={speechText}
+          speechAudio={speechAudio}
+          speechStream={speechStream}
+          speechCache={speechCache}
         />
       ) : (
         // Placeholder while waiting for intersection
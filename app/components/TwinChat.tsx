@@ -4,6 +4,12 @@ import { useMemo, useState, useRef } from "react";
 import AudioPlayer from "./AudioPlayer";
 import { useAvatarConfig } from "./AvatarConfigProvider";
 import { useAudioElement } from "./AudioElementProvider";
+import {
+  SPEECH_CACHE_KEY_HEADER,
+  SPEECH_TIMING_HEADER,
+  decodeSpeechTiming,
+  isSpeechCacheKey,
+} from "@/app/lib/speechTiming";
 
 type Turn = {
   id: string;
@@ -19,7 +25,13 @@ function makeId(): string {
 
 export default function TwinChat() {
   const { config } = useAvatarConfig();
-  const { setAudioElement } = useAudioElement();
+  const {
+    setAudioElement,
+    setSpeechText,
+    setSpeechAudio,
+    setSpeechStream,
+    setSpeechCache,
+  } = useAudioElement();
 
   const [turns, setTurns] = useState<Turn[]>([
     {
@@ -63,6 +75,24 @@ export default function TwinChat() {
         return null;
       }
 
+      // A cached reply may bring the mouth timing aligned last time
+      const cacheKey = response.headers.get(SPEECH_CACHE_KEY_HEADER);
+      if (isSpeechCacheKey(cacheKey)) {
+        const timing = response.headers.get(SPEECH_TIMING_HEADER);
+        setSpeechCache({
+          key: cacheKey,
+          timing: timing ? decodeSpeechTiming(timing) : null,
+        });
+      }
+
+      // The avatar plays the reply as it downloads; the other branch
+      // becomes the blob kept for replay
+      if (response.body) {
+        const [live, saved] = response.body.tee();
+        setSpeechStream(live);
+        return await new Response(saved).blob();
+      }
+
       const audioBlob = await response.blob();
       return audioBlob;
     } catch (error) {
@@ -109,7 +139,13 @@ export default function TwinChat() {
       // Synthesize voice for response (non-blocking)
       let audioBlob: Blob | null = null;
       if (config.voiceId && config.isConfigured) {
+        // The avatar plans its mouth from the text while audio is made
+        setSpeechText(reply);
+        setSpeechAudio(null);
+        setSpeechCache(null);
         audioBlob = await synthesizeVoice(reply);
+        // ...and retimes that plan to the audio once it is decoded
+        setSpeechAudio(audioBlob);
       }
 
       // Add assistant turn with optional audio
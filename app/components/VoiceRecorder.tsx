@@ -1,6 +1,7 @@
 "use client";
 
-import { useState, useRef } from "react";
+import { useEffect, useState, useRef } from "react";
+import { useAudioElement } from "./AudioElementProvider";
 
 const PROMPTS = [
   "Hi, I'm Alex. I teach people to think clearly and build with confidence.",
@@ -28,11 +29,16 @@ export default function VoiceRecorder({
   const audioChunksRef = useRef<Blob[]>([]);
   const streamRef = useRef<MediaStream | null>(null);
   const timerRef = useRef<NodeJS.Timeout | null>(null);
+  // Shared so a mounted avatar can hear the speaker (voice activity)
+  const { setMicrophoneStream } = useAudioElement();
+
+  useEffect(() => () => setMicrophoneStream(null), [setMicrophoneStream]);
 
   const startRecording = async () => {
     try {
       const stream = await navigator.mediaDevices.getUserMedia({ audio: true });
       streamRef.current = stream;
+      setMicrophoneStream(stream);
 
       const mediaRecorder = new MediaRecorder(stream);
       mediaRecorderRef.current = mediaRecorder;
@@ -49,6 +55,7 @@ export default function VoiceRecorder({
 
         // Stop all tracks
         stream.getTracks().forEach((track) => track.stop());
+        setMicrophoneStream(null);
 
         // Move to next prompt or complete
         if (currentPromptIndex + 1 < PROMPTS.length) {
@@ -16,6 +16,18 @@ export interface AvatarMorphTargets {
   eyesLookUp: number;
   eyesClose: number;
   // Add more as needed based on avatar model
+
+  // Lip-sync timing, carried to the engine for latency measurement
+  audioTimeMs?: number;
+  analysisTimeMs?: number;
+
+  // Speech PCM since the last update, for engine prosody tracking
+  audioSamples?: Float32Array;
+  audioSampleRate?: number;
+
+  // Playback clock for the engine's text-planned visemes
+  speechTimeSeconds?: number;
+  speechDurationSeconds?: number;
 }
 
 interface UseAvatarAnimationConfig {
@@ -103,6 +115,18 @@ export function useAvatarAnimation(
       newTargets.mouthOpen = audioTargets.mouthOpen;
       newTargets.mouthRound = audioTargets.mouthRound;
       newTargets.eyesLookUp = 0.15 + audioTargets.speechIntensity * 0.2;
+      newTargets.audioTimeMs = audioTargets.audioTimeMs;
+      newTargets.analysisTimeMs = audioTargets.analysisTimeMs;
+      newTargets.audioSamples = audioTargets.samples;
+      newTargets.audioSampleRate = audioTargets.sampleRate;
+
+      const audio = config.audioElement;
+      if (audio) {
+        newTargets.speechTimeSeconds = audio.currentTime;
+        newTargets.speechDurationSeconds = Number.isFinite(audio.duration)
+          ? audio.duration
+          : 0;
+      }
 
       // Slight head nod based on intensity (simulated via eye position)
       if (audioTargets.speechIntensity > 0.7) {
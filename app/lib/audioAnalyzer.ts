@@ -9,6 +9,10 @@ export interface MouthTargets {
   mouthOpen: number;      // 0-1: Jaw opening amplitude
   mouthRound: number;     // 0-1: Lip rounding
   speechIntensity: number; // 0-1: Overall speech volume
+  audioTimeMs?: number;     // performance.now() time the analysed audio is audible
+  analysisTimeMs?: number;  // performance.now() time of the analysis
+  samples?: Float32Array;   // PCM played since the last analysis (pooled, read before next call)
+  sampleRate?: number;      // Hz, for samples
 }
 
 export interface AudioAnalyzerConfig {
@@ -24,6 +28,12 @@ export class AudioAnalyzer {
   private frequencyData: Uint8Array | null = null;
   private frequencyDataPool: Uint8Array[] = [];
   private readonly MAX_POOL_SIZE = 3;
+  // Time-domain tap for engine-side prosody tracking
+  private waveform: AnalyserNode | null = null;
+  private sampleBuffers: Float32Array[] = [];
+  private sampleBufferIndex = 0;
+  private lastSampleTime = 0;
+  private readonly WAVEFORM_SIZE = 2048;
   private smoothingFactor: number;
   private lastMouthOpen: number = 0;
   private lastMouthRound: number = 0;
@@ -66,6 +76,15 @@ export class AudioAnalyzer {
       source.connect(this.analyser);
       this.analyser.connect(this.audioContext.destination);
 
+      // Second analyser for raw PCM; the mouth analyser's window is too
+      // short to hold a frame of audio at low frame rates
+      this.waveform = this.audioContext.createAnalyser();
+      this.waveform.fftSize = this.WAVEFORM_SIZE;
+      source.connect(this.waveform);
+      for (let i = 0; i < this.MAX_POOL_SIZE; i++) {
+        this.sampleBuffers.push(new Float32Array(this.WAVEFORM_SIZE));
+      }
+
       // Allocate frequency data buffer
       this.frequencyData = new Uint8Array(this.analyser.frequencyBinCount);
 
@@ -130,6 +149,7 @@ export class AudioAnalyzer {
     }
 
     // Get frequency data
+    const analysisTimeMs = performance.now();
     this.analyser.getByteFrequencyData(this.frequencyData);
 
     // Calculate mouth opening from low-mid frequencies
@@ -152,10 +172,60 @@ export class AudioAnalyzer {
     return {
       mouthOpen: smoothedMouthOpen,
       mouthRound: smoothedMouthRound,
-      speechIntensity: speechIntensity
+      speechIntensity: speechIntensity,
+      audioTimeMs: this.getAudibleTimeMs(analysisTimeMs),
+      analysisTimeMs,
+      samples: this.readNewSamples(),
+      sampleRate: this.audioContext?.sampleRate
     };
   }
 
+  /**
+   * PCM played since the previous call, newest WAVEFORM_SIZE samples at most
+   * Returned views rotate through a small pool instead of allocating, so
+   * callers must consume them before the next analysis.
+   */
+  private readNewSamples(): Float32Array | undefined {
+    const ctx = this.audioContext;
+    if (!ctx || !this.waveform || this.sampleBuffers.length === 0) {
+      return undefined;
+    }
+
+    const elapsed = ctx.currentTime - this.lastSampleTime;
+    this.lastSampleTime = ctx.currentTime;
+    const count = Math.min(this.WAVEFORM_SIZE, Math.round(elapsed * ctx.sampleRate));
+    if (!(count > 0)) return undefined;
+
+    const buffer = this.sampleBuffers[this.sampleBufferIndex];
+    this.sampleBufferIndex = (this.sampleBufferIndex + 1) % this.sampleBuffers.length;
+    this.waveform.getFloatTimeDomainData(buffer);
+    return buffer.subarray(this.WAVEFORM_SIZE - count);
+  }
+
+  /**
+   * Estimate when the analysed audio is audible, in performance.now() time
+   * The analyser window ends at currentTime, so its centre is half a window
+   * earlier; getOutputTimestamp() maps context time to the output clock.
+   * Carried through to the engine for audio-to-mouth latency measurement.
+   */
+  private getAudibleTimeMs(analysisTimeMs: number): number {
+    const ctx = this.audioContext;
+    if (!ctx) return 0;
+
+    const windowCentre = ctx.currentTime - this.fftSize / 2 / ctx.sampleRate;
+
+    if (typeof ctx.getOutputTimestamp === "function") {
+      const output = ctx.getOutputTimestamp();
+      if (output.contextTime !== undefined && output.performanceTime) {
+        return output.performanceTime + (windowCentre - output.contextTime) * 1000;
+      }
+    }
+
+    // Fallback: assume audio reaches the speakers after the reported latency
+    const outputLatency = (ctx.outputLatency ?? 0) + (ctx.baseLatency ?? 0);
+    return analysisTimeMs + (windowCentre - ctx.currentTime + outputLatency) * 1000;
+  }
+
   /**
    * Calculate mouth opening amplitude from low-mid frequencies (0-500 Hz)
    * Corresponds to vowel formants and jaw opening
@@ -261,6 +331,10 @@ export class AudioAnalyzer {
     this.frequencyData = null;
     this.frequencyDataPool = [];
     this.analyser = null;
+    this.waveform = null;
+    this.sampleBuffers = [];
+    this.sampleBufferIndex = 0;
+    this.lastSampleTime = 0;
     if (this.audioContext) {
       // Note: We don't close the context as it might be shared
       this.audioContext = null;
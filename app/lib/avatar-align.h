@@ -0,0 +1,381 @@
+/**
+ * avatar-align.h - Forced alignment of a viseme plan to its speech audio
+ *
+ * The text plan (avatar-visemes.h) uses typical phoneme durations and, at
+ * best, one uniform stretch to the audio length. Once the synthesized
+ * audio has been decoded, this module retimes each key to where it
+ * actually is.
+ *
+ * Both sides become the same kind of feature: loudness in four bands
+ * (voicing, first formant, second formant, frication) per 10 ms hop. The
+ * audio side is measured. The plan side comes from a per-viseme template,
+ * with silence margins around the plan so leading and trailing silence
+ * in the audio has somewhere to go. Dynamic time warping then finds the
+ * cheapest monotonic match inside a Sakoe-Chiba band around the diagonal,
+ * and each key start moves to the audio frame its first planned frame
+ * matched.
+ *
+ * The band keeps cost linear in duration: about 3000 x 600 cells for 30 s
+ * of audio. Each row computes distances and diagonal/vertical candidates
+ * four columns at a time with avatar-simd.h. The horizontal recurrence
+ * then runs as a short scalar pass. Backtracking uses one step code byte
+ * per band cell, not a full cost matrix.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "avatar-fft.h"
+#include "avatar-simd.h"
+#include "avatar-visemes.h"
+
+namespace avatar {
+
+constexpr uint32_t kAlignFeatures = 4;
+
+/**
+ * Expected band loudness (0-1, re. the utterance peak) per viseme:
+ * <500 Hz, 500-1500, 1500-3500, >3500
+ */
+inline const float kVisemeFeatures[kVisemeCount][kAlignFeatures] = {
+    {0.0f, 0.0f, 0.0f, 0.0f},    // sil
+    {0.15f, 0.05f, 0.0f, 0.0f},  // PP  closure
+    {0.2f, 0.15f, 0.3f, 0.55f},  // FF
+    {0.3f, 0.2f, 0.3f, 0.5f},    // TH
+    {0.3f, 0.2f, 0.25f, 0.35f},  // DD  closure and burst
+    {0.3f, 0.25f, 0.35f, 0.3f},  // kk
+    {0.3f, 0.35f, 0.7f, 0.8f},   // CH
+    {0.15f, 0.15f, 0.45f, 0.9f}, // SS
+    {0.85f, 0.5f, 0.3f, 0.1f},   // nn  nasal murmur
+    {0.85f, 0.75f, 0.6f, 0.2f},  // RR
+    {0.9f, 1.0f, 0.75f, 0.3f},   // aa
+    {0.9f, 0.85f, 0.8f, 0.3f},   // E
+    {0.9f, 0.65f, 0.8f, 0.3f},   // ih
+    {0.95f, 0.9f, 0.5f, 0.2f},   // oh
+    {0.95f, 0.7f, 0.4f, 0.15f},  // ou
+};
+
+/**
+ * Band loudness per 10 ms hop of a whole utterance, stored one array per
+ * band (structure of arrays) and zero-padded for 4-wide loads
+ */
+class SpeechFeatures {
+ public:
+  static constexpr float kTargetRate = 16000.0f;
+  static constexpr uint32_t kFrame = 256;
+  static constexpr float kHopSeconds = 0.01f;
+  static constexpr float kRangeDb = 50.0f;  // below the peak maps to 0
+
+  void extract(const float* samples, size_t count, float sampleRate) {
+    const uint32_t factor =
+        std::max(1u, static_cast<uint32_t>(sampleRate / kTargetRate));
+    const float rate = sampleRate / static_cast<float>(factor);
+    const uint32_t hop = static_cast<uint32_t>(rate * kHopSeconds + 0.5f);
+
+    // Box-filter decimation, as in the streaming analysers
+    decimated_.resize(count / factor);
+    for (size_t i = 0; i < decimated_.size(); ++i) {
+      float sum = 0.0f;
+      for (uint32_t k = 0; k < factor; ++k) sum += samples[i * factor + k];
+      decimated_[i] = sum / static_cast<float>(factor);
+    }
+
+    if (fft_.size() != kFrame) fft_.configure(kFrame);
+    power_.resize(kFrame / 2 + 1);
+    frame_.resize(kFrame);
+    uint32_t edges[kAlignFeatures + 1] = {1};
+    const float bandHz[kAlignFeatures] = {500.0f, 1500.0f, 3500.0f,
+                                          rate * 0.5f};
+    for (uint32_t b = 0; b < kAlignFeatures; ++b) {
+      edges[b + 1] = std::min(
+          kFrame / 2 + 1,
+          static_cast<uint32_t>(bandHz[b] * kFrame / rate + 0.5f));
+    }
+
+    frames_ = static_cast<uint32_t>(decimated_.size() / hop);
+    const size_t padded = (frames_ + 7) & ~size_t{3};
+    for (auto& band : bands_) band.assign(padded, 0.0f);
+    float peakDb = -120.0f;
+    for (uint32_t f = 0; f < frames_; ++f) {
+      // Window centred on the hop, zero outside the signal
+      const int64_t start = static_cast<int64_t>(f) * hop + hop / 2 -
+                            static_cast<int64_t>(kFrame / 2);
+      for (uint32_t i = 0; i < kFrame; ++i) {
+        const int64_t at = start + i;
+        frame_[i] = at >= 0 && at < static_cast<int64_t>(decimated_.size())
+                        ? decimated_[static_cast<size_t>(at)]
+                        : 0.0f;
+      }
+      fft_.powerSpectrum(frame_.data(), power_.data());
+      for (uint32_t b = 0; b < kAlignFeatures; ++b) {
+        float sum = 1e-10f;
+        for (uint32_t k = edges[b]; k < edges[b + 1]; ++k) sum += power_[k];
+        const float db = 10.0f * std::log10(sum);
+        bands_[b][f] = db;
+        peakDb = std::max(peakDb, db);
+      }
+    }
+
+    // Loudness relative to the utterance, so synthesis gain is irrelevant
+    for (uint32_t b = 0; b < kAlignFeatures; ++b) {
+      for (uint32_t f = 0; f < frames_; ++f) {
+        bands_[b][f] = std::clamp(
+            (bands_[b][f] - (peakDb - kRangeDb)) / kRangeDb, 0.0f, 1.0f);
+      }
+    }
+  }
+
+  uint32_t frames() const { return frames_; }
+  const float* band(uint32_t b) const { return bands_[b].data(); }
+
+  size_t memoryBytes() const {
+    size_t floats = decimated_.capacity() + power_.capacity() +
+                    frame_.capacity();
+    for (const auto& band : bands_) floats += band.capacity();
+    return floats * sizeof(float) + fft_.memoryBytes();
+  }
+
+ private:
+  Fft fft_;
+  std::vector<float> decimated_;
+  std::vector<float> power_;
+  std::vector<float> frame_;
+  std::vector<float> bands_[kAlignFeatures];
+  uint32_t frames_{0};
+};
+
+/**
+ * Banded dynamic time warping over kAlignFeatures-dimensional frames
+ */
+class DtwAligner {
+ public:
+  static constexpr float kStepPenalty = 0.01f;  // per non-diagonal step
+
+  /**
+   * Match rows (planned frames) to columns (audio frames), both stored
+   * one array per feature and readable 4 past the end. Only cells within
+   * band columns of the diagonal are considered. rowToColumn[i] receives
+   * the first column row i matched. Returns false if either side is
+   * empty.
+   */
+  bool align(const float* const rows[kAlignFeatures], uint32_t n,
+             const float* const columns[kAlignFeatures], uint32_t m,
+             uint32_t band, std::vector<uint32_t>& rowToColumn) {
+    if (n == 0 || m == 0) return false;
+    // Consecutive bands must overlap however steep the diagonal is
+    band = std::max(band, (m + n - 1) / n + 1);
+    const uint32_t width = 2 * band + 1;
+    const float inf = std::numeric_limits<float>::infinity();
+
+    lo_.resize(n);
+    steps_.resize(static_cast<size_t>(n) * width);
+    // Cost rows indexed by column + 1 (index 0 is column -1), padded for
+    // the 4-wide stores that run past a row's last column
+    rowA_.assign(m + 8, inf);
+    rowB_.assign(m + 8, inf);
+    distance_.resize(m + 8);
+    float* prev = rowA_.data();
+    float* cur = rowB_.data();
+    prev[0] = 0.0f;  // the path enters at (0, 0) diagonally
+    uint32_t curDirtyLo = 0, curDirtyHi = 0;
+    uint32_t prevDirtyLo = 0, prevDirtyHi = 0;
+    cells_ = 0;
+
+    const simd::f32x4 penalty = simd::splat(kStepPenalty);
+    for (uint32_t i = 0; i < n; ++i) {
+      const uint32_t center = n > 1 ? static_cast<uint32_t>(
+                                          static_cast<uint64_t>(i) * (m - 1) /
+                                          (n - 1))
+                                    : 0;
+      const uint32_t lo = center > band ? center - band : 0;
+      const uint32_t hi = std::min(m - 1, center + band);
+      lo_[i] = lo;
+      cells_ += hi - lo + 1;
+
+      // What this buffer held two rows ago must read as unreachable
+      for (uint32_t k = curDirtyLo; k <= std::min(curDirtyHi, lo); ++k) {
+        cur[k] = inf;
+      }
+      for (uint32_t k = std::max(curDirtyLo, hi + 2); k <= curDirtyHi; ++k) {
+        cur[k] = inf;
+      }
+
+      // Distances plus the best of diagonal and vertical, 4 columns a time
+      simd::f32x4 p[kAlignFeatures];
+      for (uint32_t b = 0; b < kAlignFeatures; ++b) {
+        p[b] = simd::splat(rows[b][i]);
+      }
+      for (uint32_t j = lo; j <= hi; j += 4) {
+        simd::f32x4 d = simd::splat(0.0f);
+        for (uint32_t b = 0; b < kAlignFeatures; ++b) {
+          const simd::f32x4 diff = simd::sub(simd::load(columns[b] + j), p[b]);
+          d = simd::madd(diff, diff, d);
+        }
+        simd::store(distance_.data() + j, d);
+        const simd::f32x4 diagonal = simd::load(prev + j);
+        const simd::f32x4 vertical = simd::add(simd::load(prev + j + 1),
+                                               penalty);
+        simd::store(cur + j + 1, simd::add(d, simd::min(diagonal, vertical)));
+      }
+
+      // Horizontal steps depend on the previous column: scalar pass
+      uint8_t* step = steps_.data() + static_cast<size_t>(i) * width;
+      for (uint32_t j = lo; j <= hi; ++j) {
+        const float horizontal = cur[j] + distance_[j] + kStepPenalty;
+        if (horizontal < cur[j + 1]) {
+          cur[j + 1] = horizontal;
+          step[j - lo] = kLeft;
+        } else {
+          step[j - lo] = prev[j] <= prev[j + 1] + kStepPenalty ? kDiagonal
+                                                                : kUp;
+        }
+      }
+      // 4-wide stores may have written up to hi + 4
+      const uint32_t writtenHi = std::min(m + 7, hi + 4);
+      for (uint32_t k = hi + 2; k <= writtenHi; ++k) cur[k] = inf;
+
+      std::swap(prev, cur);
+      std::swap(prevDirtyLo, curDirtyLo);
+      std::swap(prevDirtyHi, curDirtyHi);
+      prevDirtyLo = lo;
+      prevDirtyHi = hi + 1;
+    }
+    if (!(prev[m] < inf)) return false;
+
+    rowToColumn.assign(n, 0);
+    int64_t i = n - 1, j = m - 1;
+    while (i >= 0 && j >= 0) {
+      rowToColumn[static_cast<size_t>(i)] = static_cast<uint32_t>(j);
+      const uint8_t s =
+          steps_[static_cast<size_t>(i) * width +
+                 static_cast<size_t>(j - lo_[static_cast<size_t>(i)])];
+      if (s == kDiagonal) {
+        --i;
+        --j;
+      } else if (s == kUp) {
+        --i;
+      } else {
+        --j;
+      }
+    }
+    return true;
+  }
+
+  /** Band cells evaluated by the last align() */
+  uint64_t cells() const { return cells_; }
+
+  size_t memoryBytes() const {
+    return steps_.capacity() + lo_.capacity() * sizeof(uint32_t) +
+           (rowA_.capacity() + rowB_.capacity() + distance_.capacity()) *
+               sizeof(float);
+  }
+
+ private:
+  static constexpr uint8_t kDiagonal = 0;
+  static constexpr uint8_t kUp = 1;    // previous row, same column
+  static constexpr uint8_t kLeft = 2;  // same row, previous column
+
+  std::vector<uint8_t> steps_;  // n x width step codes
+  std::vector<uint32_t> lo_;    // first column of each row's band
+  std::vector<float> rowA_;
+  std::vector<float> rowB_;
+  std::vector<float> distance_;
+  uint64_t cells_{0};
+};
+
+/**
+ * Retimes a viseme timeline to decoded speech audio
+ */
+class SpeechAligner {
+ public:
+  static constexpr float kMarginSeconds = 0.3f;  // silence around the plan
+  static constexpr float kBandFraction = 0.1f;   // of the utterance
+  static constexpr uint32_t kMinBand = 50;       // frames (0.5 s)
+  static constexpr float kMinKeySeconds = 0.02f;
+
+  /**
+   * Returns false (timeline untouched) if the timeline is empty or the
+   * audio shorter than a few hops
+   */
+  bool align(VisemeTimeline& timeline, const float* samples, size_t count,
+             float sampleRate) {
+    if (timeline.empty() || !samples || sampleRate <= 0.0f) return false;
+    audio_.extract(samples, count, sampleRate);
+    const uint32_t m = audio_.frames();
+    if (m < 8) return false;
+
+    // Plan stretched into the audio between silence margins
+    const float hop = SpeechFeatures::kHopSeconds;
+    const float audioSeconds = static_cast<float>(m) * hop;
+    const float margin = std::min(kMarginSeconds, 0.1f * audioSeconds);
+    const float scale = (audioSeconds - 2.0f * margin) / timeline.seconds();
+    const uint32_t n = m;
+    for (auto& row : planned_) row.assign((n + 7) & ~3u, 0.0f);
+    size_t key = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+      const float t = ((static_cast<float>(i) + 0.5f) * hop - margin) / scale;
+      uint8_t viseme = kVisSil;
+      if (t >= 0.0f && t < timeline.seconds()) {
+        while (timeline.key(key).end <= t) ++key;
+        viseme = timeline.key(key).viseme;
+      }
+      for (uint32_t b = 0; b < kAlignFeatures; ++b) {
+        planned_[b][i] = kVisemeFeatures[viseme][b];
+      }
+    }
+
+    const float* rows[kAlignFeatures];
+    const float* columns[kAlignFeatures];
+    for (uint32_t b = 0; b < kAlignFeatures; ++b) {
+      rows[b] = planned_[b].data();
+      columns[b] = audio_.band(b);
+    }
+    const uint32_t band = std::max(
+        kMinBand, static_cast<uint32_t>(kBandFraction * static_cast<float>(m)));
+    if (!dtw_.align(rows, n, columns, m, band, rowToColumn_)) return false;
+
+    // Each key starts where its first planned frame landed
+    auto landed = [&](float planSeconds) {
+      const float frame = (margin + planSeconds * scale) / hop;
+      const uint32_t row = std::min(
+          n - 1, static_cast<uint32_t>(std::max(0.0f, frame + 0.5f)));
+      return static_cast<float>(rowToColumn_[row]) * hop;
+    };
+    starts_.resize(timeline.size());
+    for (size_t k = 0; k < timeline.size(); ++k) {
+      starts_[k] = landed(timeline.key(k).start);
+      if (k > 0) {
+        starts_[k] = std::max(starts_[k], starts_[k - 1] + kMinKeySeconds);
+      }
+    }
+    const float end = std::max(landed(timeline.seconds()),
+                               starts_.back() + kMinKeySeconds);
+    timeline.retime(starts_.data(), end);
+    return true;
+  }
+
+  const SpeechFeatures& features() const { return audio_; }
+  const DtwAligner& dtw() const { return dtw_; }
+
+  size_t memoryBytes() const {
+    size_t bytes = audio_.memoryBytes() + dtw_.memoryBytes() +
+                   rowToColumn_.capacity() * sizeof(uint32_t) +
+                   starts_.capacity() * sizeof(float);
+    for (const auto& row : planned_) bytes += row.capacity() * sizeof(float);
+    return bytes;
+  }
+
+ private:
+  SpeechFeatures audio_;
+  DtwAligner dtw_;
+  std::vector<float> planned_[kAlignFeatures];
+  std::vector<uint32_t> rowToColumn_;
+  std::vector<float> starts_;
+};
+
+}  // namespace avatar
@@ -0,0 +1,392 @@
+/**
+ * avatar-anim-graph.h - Data-driven animation state machine
+ *
+ * States, transitions, blend times, clip layers and procedural channel
+ * weights come from a JSON asset. The asset is compiled once at load
+ * into flat tables indexed by integer state and layer ids, so the
+ * per-frame code never branches on state names:
+ *
+ *   targetWeights(state)   layerCount floats, the layer mix of a state
+ *   procedural(state)      kProceduralCount floats
+ *   blendSeconds(from, to) fade time, < 0 if the transition is not allowed
+ *   exitAfter / exitState  optional automatic transition (one-shots)
+ *   transitionHint(from, to) how strongly the asset implies the path, for
+ *                          predictive preloading
+ *
+ * Asset format:
+ *   {
+ *     "defaultBlend": 0.25,
+ *     "layers": [{"name", "clip", "mode": "override"|"additive",
+ *                 "mask": "full"|"head", "loop", "restart", "speed"}],
+ *     "states": [{"name", "layers": {"<layer>": weight},
+ *                 "procedural": {"<channel>": weight},
+ *                 "exit": {"after": seconds, "to": "<state>"}}],
+ *     "transitions": [{"from": "<state>"|"*", "to": "<state>"|"*",
+ *                      "blend": seconds, "allowed": bool}]
+ *   }
+ * Transitions are applied in order, so later entries override earlier
+ * ones. Pairs that are not listed use defaultBlend.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "avatar-json.h"
+#include "avatar-pose-layers.h"
+
+namespace avatar {
+
+/**
+ * Procedural animation channels a state can weight
+ */
+enum ProceduralChannel : int {
+  kProcLookAt = 0,
+  kProcHeadNod,
+  kProcBrows,
+  kProcSpringBones,
+  kProceduralCount
+};
+
+inline const char* proceduralChannelName(int channel) {
+  static const char* const kNames[kProceduralCount] = {
+      "lookAt", "headNod", "brows", "springBones"};
+  return channel >= 0 && channel < kProceduralCount ? kNames[channel] : "";
+}
+
+struct AnimLayerDef {
+  std::string name;
+  std::string clip;
+  LayerMode mode{kLayerOverride};
+  bool headOnly{false};
+  bool loop{true};
+  bool restart{false};  // rewind when faded in from zero
+  float speed{1.0f};
+};
+
+/**
+ * Built-in graph matching the original idle/listening/speaking behaviour
+ * Used until an asset is loaded.
+ */
+inline constexpr const char kDefaultAnimationGraph[] = R"json({
+  "defaultBlend": 0.25,
+  "layers": [
+    {"name": "idle", "clip": "Armature|ArmatureAction", "speed": 0.3},
+    {"name": "headTilt", "clip": "HeadTilt", "mode": "additive",
+     "mask": "head", "loop": false, "restart": true, "speed": 0.5},
+    {"name": "talking", "clip": "Talking", "mask": "head"}
+  ],
+  "states": [
+    {"name": "idle", "layers": {"idle": 1},
+     "procedural": {"lookAt": 0.5, "springBones": 1}},
+    {"name": "listening", "layers": {"idle": 1, "headTilt": 1},
+     "procedural": {"lookAt": 1, "springBones": 1}},
+    {"name": "speaking", "layers": {"idle": 1, "talking": 1},
+     "procedural": {"lookAt": 0.8, "headNod": 1, "brows": 1,
+                    "springBones": 1}}
+  ]
+})json";
+
+class AnimationGraph {
+ public:
+  static constexpr int32_t kNoState = -1;
+
+  /**
+   * Parse and compile an asset
+   * On failure returns false with a message in error. The previously
+   * compiled graph is left untouched.
+   */
+  bool compile(const char* text, size_t length, std::string* error) {
+    json::Value doc;
+    if (!json::parse(text, length, doc, error)) return false;
+    AnimationGraph next;
+    if (!next.compileDocument(doc, error)) return false;
+    *this = std::move(next);
+    return true;
+  }
+
+  bool empty() const { return stateNames_.empty(); }
+  uint32_t stateCount() const {
+    return static_cast<uint32_t>(stateNames_.size());
+  }
+  uint32_t layerCount() const { return static_cast<uint32_t>(layers_.size()); }
+
+  const std::string& stateName(uint32_t state) const {
+    return stateNames_[state];
+  }
+  const AnimLayerDef& layer(uint32_t index) const { return layers_[index]; }
+
+  /** State index by name, or kNoState (load-time/API boundary only) */
+  int32_t findState(const char* name) const {
+    return indexOf(stateNames_, name);
+  }
+
+  const float* targetWeights(uint32_t state) const {
+    return weights_.data() + state * layers_.size();
+  }
+  const float* procedural(uint32_t state) const {
+    return procedural_.data() + state * kProceduralCount;
+  }
+  float blendSeconds(uint32_t from, uint32_t to) const {
+    return blend_[from * stateNames_.size() + to];
+  }
+  /**
+   * Authoring hint for from -> to: 3 = automatic exit, 2 = transition
+   * naming both states, 1 = transition naming one of them, 0 = default
+   */
+  uint8_t transitionHint(uint32_t from, uint32_t to) const {
+    return hint_[from * stateNames_.size() + to];
+  }
+  float exitAfter(uint32_t state) const { return exitAfter_[state]; }
+  uint32_t exitState(uint32_t state) const { return exitTo_[state]; }
+
+  /**
+   * Layer to play when there is no flat skeleton and the animator plays a
+   * single clip: the state's heaviest layer, later layers winning ties
+   */
+  uint32_t fallbackLayer(uint32_t state) const { return fallback_[state]; }
+
+  size_t memoryBytes() const {
+    size_t bytes = (weights_.capacity() + procedural_.capacity() +
+                    blend_.capacity() + exitAfter_.capacity()) *
+                       sizeof(float) +
+                   (exitTo_.capacity() + fallback_.capacity()) *
+                       sizeof(uint32_t) +
+                   hint_.capacity() +
+                   stateNames_.capacity() * sizeof(std::string) +
+                   layers_.capacity() * sizeof(AnimLayerDef);
+    for (const auto& name : stateNames_) bytes += name.capacity();
+    for (const auto& layer : layers_) {
+      bytes += layer.name.capacity() + layer.clip.capacity();
+    }
+    return bytes;
+  }
+
+ private:
+  template <typename T>
+  static int32_t indexOf(const std::vector<T>& items, const std::string& name) {
+    for (size_t i = 0; i < items.size(); ++i) {
+      if (nameOf(items[i]) == name) return static_cast<int32_t>(i);
+    }
+    return kNoState;
+  }
+  static const std::string& nameOf(const std::string& s) { return s; }
+  static const std::string& nameOf(const AnimLayerDef& l) { return l.name; }
+
+  static bool fail(std::string* error, const std::string& message) {
+    if (error) *error = message;
+    return false;
+  }
+
+  bool compileLayers(const json::Value& list, std::string* error) {
+    if (!list.isArray() || list.items.empty()) {
+      return fail(error, "\"layers\" must be a non-empty array");
+    }
+    for (size_t i = 0; i < list.items.size(); ++i) {
+      const json::Value& item = list.items[i];
+      const std::string where = "layers[" + std::to_string(i) + "]";
+      const json::Value* name = item.find("name");
+      const json::Value* clip = item.find("clip");
+      if (!name || !name->isString() || !clip || !clip->isString()) {
+        return fail(error, where + ": needs string \"name\" and \"clip\"");
+      }
+      if (indexOf(layers_, name->string) != kNoState) {
+        return fail(error, where + ": duplicate layer '" + name->string + "'");
+      }
+      AnimLayerDef def;
+      def.name = name->string;
+      def.clip = clip->string;
+
+      const json::Value* mode = item.find("mode");
+      const std::string modeName = mode ? mode->stringOr("") : "override";
+      if (modeName == "additive") {
+        def.mode = kLayerAdditive;
+      } else if (modeName != "override") {
+        return fail(error, where + ": unknown mode '" + modeName + "'");
+      }
+      const json::Value* mask = item.find("mask");
+      const std::string maskName = mask ? mask->stringOr("") : "full";
+      if (maskName == "head") {
+        def.headOnly = true;
+      } else if (maskName != "full") {
+        return fail(error, where + ": unknown mask '" + maskName + "'");
+      }
+      if (const json::Value* v = item.find("loop")) def.loop = v->boolOr(true);
+      if (const json::Value* v = item.find("restart")) {
+        def.restart = v->boolOr(false);
+      }
+      if (const json::Value* v = item.find("speed")) {
+        def.speed = static_cast<float>(v->numberOr(1.0));
+      }
+      layers_.push_back(std::move(def));
+    }
+    return true;
+  }
+
+  bool compileStates(const json::Value& list, std::string* error) {
+    if (!list.isArray() || list.items.empty()) {
+      return fail(error, "\"states\" must be a non-empty array");
+    }
+    // Names first so exits can refer to later states
+    for (size_t i = 0; i < list.items.size(); ++i) {
+      const json::Value* name = list.items[i].find("name");
+      if (!name || !name->isString()) {
+        return fail(error,
+                    "states[" + std::to_string(i) + "]: needs string \"name\"");
+      }
+      if (indexOf(stateNames_, name->string) != kNoState) {
+        return fail(error, "duplicate state '" + name->string + "'");
+      }
+      stateNames_.push_back(name->string);
+    }
+
+    const size_t states = stateNames_.size();
+    weights_.assign(states * layers_.size(), 0.0f);
+    procedural_.assign(states * kProceduralCount, 0.0f);
+    exitAfter_.assign(states, 0.0f);
+    exitTo_.assign(states, 0);
+    fallback_.assign(states, 0);
+
+    for (size_t s = 0; s < states; ++s) {
+      const json::Value& item = list.items[s];
+      const std::string where = "state '" + stateNames_[s] + "'";
+
+      float* weights = weights_.data() + s * layers_.size();
+      if (const json::Value* mix = item.find("layers")) {
+        for (const json::Member& m : mix->members) {
+          const int32_t layer = indexOf(layers_, m.key);
+          if (layer == kNoState) {
+            return fail(error, where + ": unknown layer '" + m.key + "'");
+          }
+          weights[layer] = static_cast<float>(m.value.numberOr(0.0));
+        }
+      }
+      for (uint32_t l = 0; l < layers_.size(); ++l) {
+        if (weights[l] > 0.0f && weights[l] >= weights[fallback_[s]]) {
+          fallback_[s] = l;
+        }
+      }
+
+      if (const json::Value* channels = item.find("procedural")) {
+        for (const json::Member& m : channels->members) {
+          int channel = 0;
+          while (channel < kProceduralCount &&
+                 m.key != proceduralChannelName(channel)) {
+            ++channel;
+          }
+          if (channel == kProceduralCount) {
+            return fail(error, where + ": unknown procedural channel '" +
+                                   m.key + "'");
+          }
+          procedural_[s * kProceduralCount + channel] =
+              static_cast<float>(m.value.numberOr(0.0));
+        }
+      }
+
+      if (const json::Value* exit = item.find("exit")) {
+        const json::Value* after = exit->find("after");
+        const json::Value* to = exit->find("to");
+        const int32_t target =
+            to && to->isString() ? indexOf(stateNames_, to->string) : kNoState;
+        if (!after || after->numberOr(0.0) <= 0.0 || target == kNoState) {
+          return fail(error, where +
+                                 ": \"exit\" needs \"after\" > 0 and a known "
+                                 "\"to\" state");
+        }
+        exitAfter_[s] = static_cast<float>(after->number);
+        exitTo_[s] = static_cast<uint32_t>(target);
+      }
+    }
+    return true;
+  }
+
+  bool compileTransitions(const json::Value* list, float defaultBlend,
+                          std::string* error) {
+    const size_t states = stateNames_.size();
+    blend_.assign(states * states, defaultBlend);
+    hint_.assign(states * states, 0);
+    if (list && !list->isArray()) {
+      return fail(error, "\"transitions\" must be an array");
+    }
+
+    const size_t count = list ? list->items.size() : 0;
+    for (size_t i = 0; i < count; ++i) {
+      const json::Value& item = list->items[i];
+      const std::string where = "transitions[" + std::to_string(i) + "]";
+      int32_t range[2][2];  // [from|to][begin, end)
+      uint8_t hint = 0;     // explicit (non-wildcard) endpoints
+      const char* keys[2] = {"from", "to"};
+      for (int k = 0; k < 2; ++k) {
+        const json::Value* v = item.find(keys[k]);
+        const std::string name = v ? v->stringOr("") : "*";
+        if (name == "*") {
+          range[k][0] = 0;
+          range[k][1] = static_cast<int32_t>(states);
+          continue;
+        }
+        const int32_t state = indexOf(stateNames_, name);
+        if (state == kNoState) {
+          return fail(error, where + ": unknown state '" + name + "'");
+        }
+        range[k][0] = state;
+        range[k][1] = state + 1;
+        ++hint;
+      }
+      float blend = defaultBlend;
+      if (const json::Value* v = item.find("blend")) {
+        blend = static_cast<float>(v->numberOr(defaultBlend));
+      }
+      if (blend < 0.0f) return fail(error, where + ": negative blend time");
+      if (const json::Value* v = item.find("allowed")) {
+        if (!v->boolOr(true)) blend = -1.0f;
+      }
+      for (int32_t from = range[0][0]; from < range[0][1]; ++from) {
+        for (int32_t to = range[1][0]; to < range[1][1]; ++to) {
+          uint8_t& pairHint = hint_[from * states + to];
+          blend_[from * states + to] = blend;
+          if (blend < 0.0f) {
+            pairHint = 0;
+          } else if (hint > pairHint) {
+            pairHint = hint;
+          }
+        }
+      }
+    }
+    for (size_t s = 0; s < states; ++s) {
+      if (exitAfter_[s] > 0.0f) hint_[s * states + exitTo_[s]] = 3;
+    }
+    return true;
+  }
+
+  bool compileDocument(const json::Value& doc, std::string* error) {
+    if (!doc.isObject()) return fail(error, "graph must be a JSON object");
+    const json::Value* layers = doc.find("layers");
+    const json::Value* states = doc.find("states");
+    if (!layers || !states) {
+      return fail(error, "graph needs \"layers\" and \"states\"");
+    }
+    float defaultBlend = 0.25f;
+    if (const json::Value* v = doc.find("defaultBlend")) {
+      defaultBlend = static_cast<float>(v->numberOr(defaultBlend));
+    }
+    if (defaultBlend < 0.0f) return fail(error, "negative \"defaultBlend\"");
+    return compileLayers(*layers, error) && compileStates(*states, error) &&
+           compileTransitions(doc.find("transitions"), defaultBlend, error);
+  }
+
+  std::vector<std::string> stateNames_;
+  std::vector<AnimLayerDef> layers_;
+  std::vector<float> weights_;     // [state][layer]
+  std::vector<float> procedural_;  // [state][ProceduralChannel]
+  std::vector<float> blend_;       // [from][to] seconds, < 0 = not allowed
+  std::vector<uint8_t> hint_;      // [from][to] transitionHint()
+  std::vector<float> exitAfter_;   // seconds, 0 = stay
+  std::vector<uint32_t> exitTo_;
+  std::vector<uint32_t> fallback_;
+};
+
+}  // namespace avatar
@@ -0,0 +1,77 @@
+/**
+ * avatar-anim-predict.h - Next-state prediction for animation preloading
+ *
+ * Ranks the states likely to follow the current one, so their clips can
+ * be decompressed and their entry poses sampled during idle frame time
+ * instead of on the first frame of the transition. Transitions seen this
+ * session count most. The graph's authoring hints (automatic exits,
+ * explicitly listed transitions) break ties and cover the cold start.
+ * Forbidden transitions are never predicted.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "avatar-anim-graph.h"
+
+namespace avatar {
+
+class TransitionPredictor {
+ public:
+  void reset(uint32_t stateCount) {
+    states_ = stateCount;
+    counts_.assign(static_cast<size_t>(stateCount) * stateCount, 0);
+  }
+
+  void observe(uint32_t from, uint32_t to) {
+    if (from >= states_ || to >= states_ || from == to) return;
+    uint16_t& count = counts_[from * states_ + to];
+    if (count < 0xFFFF) ++count;
+  }
+
+  uint32_t observed(uint32_t from, uint32_t to) const {
+    return counts_[from * states_ + to];
+  }
+
+  /**
+   * Up to max likely successors of `from`, best first
+   * Returns the number written to out.
+   */
+  uint32_t predict(const AnimationGraph& graph, uint32_t from, uint32_t* out,
+                   uint32_t max) const {
+    if (from >= states_ || graph.stateCount() != states_) return 0;
+    uint32_t score[kMaxPredictions];
+    uint32_t written = 0;
+    if (max > kMaxPredictions) max = kMaxPredictions;
+    for (uint32_t to = 0; to < states_; ++to) {
+      if (to == from || graph.blendSeconds(from, to) < 0.0f) continue;
+      // Observations dominate; the hint (0-3) orders unseen paths
+      const uint32_t s = observed(from, to) * 4 + graph.transitionHint(from, to);
+      uint32_t pos = written < max ? written++ : max;
+      while (pos > 0 && score[pos - 1] < s) {
+        if (pos < max) {
+          score[pos] = score[pos - 1];
+          out[pos] = out[pos - 1];
+        }
+        --pos;
+      }
+      if (pos < max) {
+        score[pos] = s;
+        out[pos] = to;
+      }
+    }
+    return written;
+  }
+
+  size_t memoryBytes() const { return counts_.capacity() * sizeof(uint16_t); }
+
+ private:
+  static constexpr uint32_t kMaxPredictions = 8;
+
+  uint32_t states_{0};
+  std::vector<uint16_t> counts_;  // [from][to] transitions seen
+};
+
+}  // namespace avatar
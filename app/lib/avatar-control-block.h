@@ -0,0 +1,39 @@
+/**
+ * avatar-control-block.h - Engine inputs written by JavaScript in one block
+ *
+ * The counterpart of EngineStateBlock. JS writes fields through typed views
+ * whenever its inputs change (cursor moves, focus changes) without an export
+ * call, and the engine reads the block once per updateFrame(). Every field is
+ * 4 bytes wide, so Uint32Array and Float32Array views share indices
+ * (index = byte offset / 4). Append-only layout.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace avatar {
+
+enum LookAtMode : uint32_t {
+  kLookAtOff = 0,
+  kLookAtPoint = 1,   // lookAtTarget is a model-space point
+  kLookAtScreen = 2,  // lookAtTarget xy is a canvas point in NDC [-1, 1]
+};
+
+struct EngineControlBlock {
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t version{kVersion};                      // [0]
+  uint32_t sizeBytes{sizeof(EngineControlBlock)};  // [1]
+  uint32_t lookAtMode{kLookAtOff};                 // [2] LookAtMode
+  float lookAtTarget[3]{};                         // [3..5]
+  float lookAtWeight{1.0f};                        // [6] 0-1
+};
+
+static_assert(offsetof(EngineControlBlock, lookAtTarget) == 3 * 4,
+              "EngineControlBlock indices are mirrored in avatarController.ts");
+static_assert(sizeof(EngineControlBlock) == 7 * 4,
+              "EngineControlBlock must stay a flat array of 4-byte fields");
+
+}  // namespace avatar
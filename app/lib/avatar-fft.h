@@ -0,0 +1,112 @@
+/**
+ * avatar-fft.h - Small radix-2 FFT for audio analysis frames
+ *
+ * In-place iterative complex FFT with precomputed twiddles and bit
+ * reversal, plus a Hann-windowed power spectrum of a real frame. Sized
+ * for analysis frames of 64-1024 points, where table setup is paid once
+ * at configure() and each transform allocates nothing.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace avatar {
+
+class Fft {
+ public:
+  /**
+   * n must be a power of two (>= 4)
+   */
+  void configure(uint32_t n) {
+    n_ = n;
+    bits_ = 0;
+    while ((1u << bits_) < n) ++bits_;
+    const double kTwoPi = 6.283185307179586;
+    twiddleRe_.resize(n / 2);
+    twiddleIm_.resize(n / 2);
+    for (uint32_t k = 0; k < n / 2; ++k) {
+      twiddleRe_[k] = static_cast<float>(std::cos(kTwoPi * k / n));
+      twiddleIm_[k] = static_cast<float>(-std::sin(kTwoPi * k / n));
+    }
+    reversed_.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+      uint32_t r = 0;
+      for (uint32_t b = 0; b < bits_; ++b) r |= ((i >> b) & 1u) << (bits_ - 1 - b);
+      reversed_[i] = r;
+    }
+    window_.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+      window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(kTwoPi * i / n));
+    }
+    re_.assign(n, 0.0f);
+    im_.assign(n, 0.0f);
+  }
+
+  uint32_t size() const { return n_; }
+
+  /**
+   * Forward transform of re/im in place (unnormalised)
+   */
+  void forward(float* re, float* im) const {
+    for (uint32_t i = 0; i < n_; ++i) {
+      const uint32_t j = reversed_[i];
+      if (j > i) {
+        std::swap(re[i], re[j]);
+        std::swap(im[i], im[j]);
+      }
+    }
+    for (uint32_t half = 1, stride = n_ / 2; half < n_;
+         half <<= 1, stride >>= 1) {
+      for (uint32_t start = 0; start < n_; start += half * 2) {
+        for (uint32_t k = 0; k < half; ++k) {
+          const float wr = twiddleRe_[k * stride];
+          const float wi = twiddleIm_[k * stride];
+          const uint32_t a = start + k, b = a + half;
+          const float tr = re[b] * wr - im[b] * wi;
+          const float ti = re[b] * wi + im[b] * wr;
+          re[b] = re[a] - tr;
+          im[b] = im[a] - ti;
+          re[a] += tr;
+          im[a] += ti;
+        }
+      }
+    }
+  }
+
+  /**
+   * Hann-windowed power spectrum of n real samples into n/2 + 1 bins
+   */
+  void powerSpectrum(const float* frame, float* power) {
+    for (uint32_t i = 0; i < n_; ++i) {
+      re_[i] = frame[i] * window_[i];
+      im_[i] = 0.0f;
+    }
+    forward(re_.data(), im_.data());
+    for (uint32_t k = 0; k <= n_ / 2; ++k) {
+      power[k] = re_[k] * re_[k] + im_[k] * im_[k];
+    }
+  }
+
+  size_t memoryBytes() const {
+    return (twiddleRe_.capacity() + twiddleIm_.capacity() +
+            window_.capacity() + re_.capacity() + im_.capacity()) *
+               sizeof(float) +
+           reversed_.capacity() * sizeof(uint32_t);
+  }
+
+ private:
+  uint32_t n_{0};
+  uint32_t bits_{0};
+  std::vector<float> twiddleRe_;
+  std::vector<float> twiddleIm_;
+  std::vector<uint32_t> reversed_;
+  std::vector<float> window_;
+  std::vector<float> re_;  // scratch
+  std::vector<float> im_;
+};
+
+}  // namespace avatar
@@ -0,0 +1,51 @@
+/**
+ * avatar-frame-counters.h - Per-frame engine work counters
+ *
+ * Filled at the end of every updateFrame() and exposed to JavaScript as a
+ * single struct via getFrameCounters(). The layout is stable: new counters
+ * are only ever appended, and JS checks `version`/`sizeBytes` before
+ * reading past the fields it knows about.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace avatar {
+
+struct FrameCounters {
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t version{kVersion};
+  uint32_t sizeBytes{sizeof(FrameCounters)};
+  uint32_t frameIndex{0};
+
+  uint32_t drawCalls{0};
+  uint32_t triangles{0};
+  uint32_t skinnedVertices{0};
+  uint32_t activeMorphs{0};  // morph targets shown with a non-zero weight
+  uint32_t bonesEvaluated{0};
+  uint32_t bytesUploaded{0};
+  uint32_t pipelineBinds{0};
+  uint32_t culledPrimitives{0};
+
+  /**
+   * Clear per-frame counts, keeping the header and frame index
+   */
+  void beginFrame() {
+    ++frameIndex;
+    drawCalls = 0;
+    triangles = 0;
+    skinnedVertices = 0;
+    activeMorphs = 0;
+    bonesEvaluated = 0;
+    bytesUploaded = 0;
+    pipelineBinds = 0;
+    culledPrimitives = 0;
+  }
+};
+
+static_assert(sizeof(FrameCounters) == 11 * sizeof(uint32_t),
+              "FrameCounters is read from JS as a Uint32Array");
+
+}  // namespace avatar
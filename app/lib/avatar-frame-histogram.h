@@ -0,0 +1,161 @@
+/**
+ * avatar-frame-histogram.h - Log-bucketed frame time histograms
+ *
+ * HDR-style histogram for frame and per-phase timings. Values are recorded
+ * in microseconds into fixed log2 buckets with 16 linear sub-buckets each
+ * (~6% relative precision), so recording is a couple of integer ops and the
+ * whole histogram is a flat array with no allocation. Cheap enough to stay
+ * on in production; percentiles are only computed when JS asks for them.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace avatar {
+
+/**
+ * Phases timed inside updateFrame()
+ * kFrameInterval is the wall time between successive updateFrame() calls,
+ * kFrameCpu is the time spent inside one updateFrame() call.
+ */
+enum FramePhase : int {
+  kFrameInterval = 0,
+  kFrameCpu,
+  kPhaseAnimation,
+  kPhaseSceneUpdate,
+  kPhaseRender,
+  kPhasePresent,
+  kFramePhaseCount
+};
+
+/**
+ * Percentile snapshot returned to JavaScript
+ * Plain float layout so JS can read it as a Float32Array.
+ * All times are in milliseconds.
+ */
+struct FrameTimePercentiles {
+  float p50;
+  float p90;
+  float p99;
+  float p999;
+  float max;
+  float count;
+};
+
+class FrameHistogram {
+ public:
+  // Values below kLinearLimit get one bucket each, above that every power
+  // of two is split into kSubBuckets linear buckets.
+  static constexpr uint32_t kSubBucketBits = 4;
+  static constexpr uint32_t kSubBuckets = 1u << kSubBucketBits;
+  static constexpr uint32_t kLinearLimit = kSubBuckets * 2;
+  static constexpr uint32_t kBucketCount =
+      kLinearLimit + (32 - kSubBucketBits - 1) * kSubBuckets;
+
+  FrameHistogram() { reset(); }
+
+  void reset() {
+    std::memset(counts_, 0, sizeof(counts_));
+    total_ = 0;
+    max_ = 0;
+  }
+
+  void recordMicros(uint32_t value) {
+    ++counts_[bucketIndex(value)];
+    ++total_;
+    if (value > max_) max_ = value;
+  }
+
+  void recordMillis(double ms) {
+    if (!(ms > 0.0)) ms = 0.0;
+    const double us = ms * 1000.0;
+    recordMicros(us >= 4294967295.0 ? 0xFFFFFFFFu
+                                     : static_cast<uint32_t>(us + 0.5));
+  }
+
+  /**
+   * Value (microseconds) at quantile q in [0, 1]
+   * Nearest rank: the ceil(q * count)-th smallest sample, so p99 of 50
+   * samples is the largest. Reports the upper bound of its bucket,
+   * clamped to the exact recorded maximum.
+   */
+  uint32_t valueAtQuantile(double q) const {
+    if (total_ == 0) return 0;
+    if (q <= 0.0) q = 0.0;
+    if (q >= 1.0) return max_;
+
+    // The epsilon keeps e.g. 0.07 * 100 = 7.000000000000001 at rank 7
+    uint64_t target = static_cast<uint64_t>(
+        std::ceil(q * static_cast<double>(total_) - 1e-9));
+    if (target < 1) target = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < kBucketCount; ++i) {
+      seen += counts_[i];
+      if (seen >= target) {
+        const uint32_t upper = bucketUpperBound(i);
+        return upper < max_ ? upper : max_;
+      }
+    }
+    return max_;
+  }
+
+  void percentiles(FrameTimePercentiles& out) const {
+    out.p50 = valueAtQuantile(0.50) / 1000.0f;
+    out.p90 = valueAtQuantile(0.90) / 1000.0f;
+    out.p99 = valueAtQuantile(0.99) / 1000.0f;
+    out.p999 = valueAtQuantile(0.999) / 1000.0f;
+    out.max = max_ / 1000.0f;
+    out.count = static_cast<float>(total_);
+  }
+
+  uint64_t count() const { return total_; }
+  uint32_t maxMicros() const { return max_; }
+
+  static uint32_t bucketIndex(uint32_t value) {
+    if (value < kLinearLimit) return value;
+    const uint32_t msb = 31u - static_cast<uint32_t>(__builtin_clz(value));
+    const uint32_t shift = msb - kSubBucketBits;
+    const uint32_t top = value >> shift;  // in [kSubBuckets, 2*kSubBuckets)
+    return kLinearLimit + (shift - 1) * kSubBuckets + (top - kSubBuckets);
+  }
+
+  static uint32_t bucketUpperBound(uint32_t index) {
+    if (index < kLinearLimit) return index;
+    const uint32_t k = index - kLinearLimit;
+    const uint32_t shift = k / kSubBuckets + 1;
+    const uint64_t top = kSubBuckets + k % kSubBuckets;
+    const uint64_t upper = ((top + 1) << shift) - 1;
+    return upper > 0xFFFFFFFFull ? 0xFFFFFFFFu : static_cast<uint32_t>(upper);
+  }
+
+ private:
+  uint32_t counts_[kBucketCount];
+  uint64_t total_;
+  uint32_t max_;
+};
+
+/**
+ * One histogram per frame phase, the last frame's raw timings (for the
+ * perf HUD) and the start time of the last frame for the frame interval.
+ */
+struct FrameTimeStats {
+  FrameHistogram phases[kFramePhaseCount];
+  float lastMs[kFramePhaseCount]{};
+  double lastFrameStartMs{0.0};
+
+  void record(int phase, double ms) {
+    lastMs[phase] = static_cast<float>(ms);
+    phases[phase].recordMillis(ms);
+  }
+
+  void reset() {
+    // lastFrameStartMs is kept so the first interval after a reset counts
+    for (auto& h : phases) h.reset();
+  }
+};
+
+}  // namespace avatar
@@ -0,0 +1,939 @@
+/**
+ * avatar-g2p.h - Rule-based English grapheme-to-phoneme conversion
+ *
+ * Turns reply text into ARPAbet phonemes without waiting for audio, so
+ * the mouth can be planned as soon as the text is known. Words are first
+ * looked up in a small exception dictionary of irregular and very common
+ * words. The dictionary is a perfect hash (hash and displace), so a lookup
+ * is two hashes, one probe and one string compare. Everything else goes
+ * through letter-to-sound rules in the style of the NRL rules (Elovitz et
+ * al., 1976): for each letter, the first rule whose match string and
+ * left/right contexts fit emits its phonemes.
+ *
+ * Accuracy is that of a few hundred rules, which is enough for visemes:
+ * most confusions (vowel quality, voicing) land on the same mouth shape.
+ * Digits are read as cardinal numbers. Punctuation becomes short or long
+ * pause markers. Tables are compiled once at construction and conversion
+ * allocates only when the output vector grows.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace avatar {
+
+// ARPAbet phonemes without stress marks
+enum Phoneme : uint8_t {
+  kPhAA, kPhAE, kPhAH, kPhAO, kPhAW, kPhAY, kPhB, kPhCH, kPhD, kPhDH,
+  kPhEH, kPhER, kPhEY, kPhF, kPhG, kPhHH, kPhIH, kPhIY, kPhJH, kPhK,
+  kPhL, kPhM, kPhN, kPhNG, kPhOW, kPhOY, kPhP, kPhR, kPhS, kPhSH,
+  kPhT, kPhTH, kPhUH, kPhUW, kPhV, kPhW, kPhY, kPhZ, kPhZH,
+  kPhonemeCount
+};
+
+// Markers interleaved with phonemes in converter output
+constexpr uint8_t kPhWordEnd = 0x40;     // between words
+constexpr uint8_t kPhShortPause = 0x41;  // , ; : and line breaks
+constexpr uint8_t kPhLongPause = 0x42;   // . ! ?
+
+inline const char* const kPhonemeNames[kPhonemeCount] = {
+    "AA", "AE", "AH", "AO", "AW", "AY", "B",  "CH", "D",  "DH",
+    "EH", "ER", "EY", "F",  "G",  "HH", "IH", "IY", "JH", "K",
+    "L",  "M",  "N",  "NG", "OW", "OY", "P",  "R",  "S",  "SH",
+    "T",  "TH", "UH", "UW", "V",  "W",  "Y",  "Z",  "ZH"};
+
+inline bool isVowelPhoneme(uint8_t p) {
+  switch (p) {
+    case kPhAA: case kPhAE: case kPhAH: case kPhAO: case kPhAW: case kPhAY:
+    case kPhEH: case kPhER: case kPhEY: case kPhIH: case kPhIY: case kPhOW:
+    case kPhOY: case kPhUH: case kPhUW:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Parse space-separated ARPAbet ("DH AH") onto out
+ * Returns false on an unknown name.
+ */
+inline bool parsePhonemes(const char* text, std::vector<uint8_t>& out) {
+  while (*text) {
+    while (*text == ' ') ++text;
+    if (!*text) break;
+    size_t n = 0;
+    while (text[n] && text[n] != ' ') ++n;
+    int found = -1;
+    for (int p = 0; p < kPhonemeCount; ++p) {
+      if (std::strlen(kPhonemeNames[p]) == n &&
+          std::strncmp(kPhonemeNames[p], text, n) == 0) {
+        found = p;
+        break;
+      }
+    }
+    if (found < 0) return false;
+    out.push_back(static_cast<uint8_t>(found));
+    text += n;
+  }
+  return true;
+}
+
+/**
+ * Word -> phonemes dictionary with a minimal-probe perfect hash
+ * Keys are hashed into buckets; each bucket stores the seed that sends all
+ * of its keys to free slots. Built once from a static table.
+ */
+class PerfectHashDictionary {
+ public:
+  struct Entry {
+    const char* word;      // lowercase
+    const char* phonemes;  // ARPAbet, space-separated
+  };
+
+  /**
+   * Returns false if a phoneme string does not parse (the entry is
+   * skipped) or no seed is found for a bucket
+   */
+  bool build(const Entry* entries, uint32_t count) {
+    bool ok = true;
+    words_.clear();
+    phonemes_.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+      Word word;
+      word.text = entries[i].word;
+      word.length = static_cast<uint32_t>(std::strlen(word.text));
+      word.offset = static_cast<uint32_t>(phonemes_.size());
+      if (!parsePhonemes(entries[i].phonemes, phonemes_)) {
+        phonemes_.resize(word.offset);
+        ok = false;
+        continue;
+      }
+      word.count = static_cast<uint32_t>(phonemes_.size()) - word.offset;
+      words_.push_back(word);
+    }
+
+    const uint32_t n = static_cast<uint32_t>(words_.size());
+    bucketCount_ = std::max(1u, n / 2);
+    uint32_t slots = 8;
+    while (slots < n + n / 4) slots <<= 1;
+    mask_ = slots - 1;
+    slots_.assign(slots, kEmpty);
+    seeds_.assign(bucketCount_, 0);
+
+    // Largest buckets first, while the table is emptiest
+    std::vector<std::vector<uint32_t>> buckets(bucketCount_);
+    for (uint32_t i = 0; i < n; ++i) {
+      const Word& w = words_[i];
+      buckets[hash(w.text, w.length, 0) % bucketCount_].push_back(i);
+    }
+    std::vector<uint32_t> order(bucketCount_);
+    for (uint32_t b = 0; b < bucketCount_; ++b) order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<uint32_t> placed;
+    for (uint32_t b : order) {
+      const auto& keys = buckets[b];
+      if (keys.empty()) continue;
+      bool found = false;
+      for (uint32_t seed = 1; seed < kMaxSeed && !found; ++seed) {
+        placed.clear();
+        found = true;
+        for (uint32_t key : keys) {
+          const Word& w = words_[key];
+          const uint32_t slot = hash(w.text, w.length, seed) & mask_;
+          if (slots_[slot] != kEmpty ||
+              std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+            found = false;
+            break;
+          }
+          placed.push_back(slot);
+        }
+        if (found) {
+          seeds_[b] = seed;
+          for (size_t k = 0; k < keys.size(); ++k) slots_[placed[k]] = keys[k];
+        }
+      }
+      if (!found) ok = false;
+    }
+    return ok;
+  }
+
+  /**
+   * Look up a lowercase word; on a hit, points phonemes at its sequence
+   */
+  bool find(const char* word, uint32_t length, const uint8_t** phonemes,
+            uint32_t* count) const {
+    if (words_.empty()) return false;
+    const uint32_t seed = seeds_[hash(word, length, 0) % bucketCount_];
+    if (seed == 0) return false;
+    const uint32_t index = slots_[hash(word, length, seed) & mask_];
+    if (index == kEmpty) return false;
+    const Word& w = words_[index];
+    if (w.length != length || std::memcmp(w.text, word, length) != 0) {
+      return false;
+    }
+    *phonemes = phonemes_.data() + w.offset;
+    *count = w.count;
+    return true;
+  }
+
+  uint32_t size() const { return static_cast<uint32_t>(words_.size()); }
+  uint32_t slotCount() const { return static_cast<uint32_t>(slots_.size()); }
+
+  size_t memoryBytes() const {
+    return words_.capacity() * sizeof(Word) + phonemes_.capacity() +
+           (slots_.capacity() + seeds_.capacity()) * sizeof(uint32_t);
+  }
+
+  /**
+   * FNV-1a with a murmur3 finaliser; the seed picks the function
+   */
+  static uint32_t hash(const char* s, uint32_t n, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (uint32_t i = 0; i < n; ++i) {
+      h = (h ^ static_cast<uint8_t>(s[i])) * 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+  }
+
+ private:
+  static constexpr uint32_t kEmpty = 0xFFFFFFFFu;
+  static constexpr uint32_t kMaxSeed = 1u << 16;
+
+  struct Word {
+    const char* text;
+    uint32_t length;
+    uint32_t offset;  // into phonemes_
+    uint32_t count;
+  };
+
+  std::vector<Word> words_;
+  std::vector<uint8_t> phonemes_;
+  std::vector<uint32_t> slots_;  // word index or kEmpty
+  std::vector<uint32_t> seeds_;  // per bucket, 0 = empty bucket
+  uint32_t bucketCount_{1};
+  uint32_t mask_{0};
+};
+
+/**
+ * Irregular and very frequent words the rules get wrong or that are
+ * worth a single probe
+ */
+inline const PerfectHashDictionary::Entry kG2pExceptions[] = {
+    {"a", "AH"}, {"about", "AH B AW T"}, {"again", "AH G EH N"},
+    {"against", "AH G EH N S T"}, {"ai", "EY AY"}, {"almost", "AO L M OW S T"},
+    {"already", "AO L R EH D IY"}, {"also", "AO L S OW"},
+    {"although", "AO L DH OW"}, {"always", "AO L W EY Z"},
+    {"among", "AH M AH NG"}, {"an", "AE N"}, {"and", "AE N D"},
+    {"answer", "AE N S ER"}, {"any", "EH N IY"},
+    {"anything", "EH N IY TH IH NG"},
+    {"api", "EY P IY AY"}, {"are", "AA R"}, {"area", "EH R IY AH"},
+    {"as", "AE Z"}, {"because", "B IH K AH Z"}, {"been", "B IH N"},
+    {"before", "B IH F AO R"}, {"both", "B OW TH"}, {"break", "B R EY K"},
+    {"build", "B IH L D"}, {"built", "B IH L T"}, {"busy", "B IH Z IY"},
+    {"business", "B IH Z N AH S"}, {"buy", "B AY"}, {"can't", "K AE N T"},
+    {"climb", "K L AY M"}, {"color", "K AH L ER"}, {"come", "K AH M"},
+    {"could", "K UH D"}, {"create", "K R IY EY T"}, {"data", "D EY T AH"},
+    {"debt", "D EH T"}, {"do", "D UW"}, {"does", "D AH Z"},
+    {"doesn't", "D AH Z AH N T"}, {"don't", "D OW N T"}, {"done", "D AH N"},
+    {"doubt", "D AW T"}, {"eight", "EY T"}, {"enough", "IH N AH F"},
+    {"every", "EH V R IY"}, {"eye", "AY"}, {"eyes", "AY Z"},
+    {"father", "F AA DH ER"}, {"five", "F AY V"}, {"four", "F AO R"},
+    {"friend", "F R EH N D"}, {"from", "F R AH M"}, {"give", "G IH V"},
+    {"gone", "G AO N"}, {"great", "G R EY T"}, {"half", "HH AE F"},
+    {"has", "HH AE Z"}, {"have", "HH AE V"}, {"he", "HH IY"},
+    {"heart", "HH AA R T"}, {"hello", "HH AH L OW"}, {"here", "HH IY R"},
+    {"honest", "AA N AH S T"}, {"hour", "AW ER"}, {"i", "AY"},
+    {"i'd", "AY D"}, {"i'll", "AY L"}, {"i'm", "AY M"}, {"i've", "AY V"},
+    {"idea", "AY D IY AH"}, {"island", "AY L AH N D"}, {"into", "IH N T UW"},
+    {"is", "IH Z"}, {"isn't", "IH Z AH N T"}, {"it's", "IH T S"},
+    {"key", "K IY"}, {"know", "N OW"}, {"laugh", "L AE F"},
+    {"learn", "L ER N"}, {"listen", "L IH S AH N"}, {"live", "L IH V"},
+    {"love", "L AH V"}, {"machine", "M AH SH IY N"}, {"many", "M EH N IY"},
+    {"me", "M IY"}, {"minute", "M IH N AH T"}, {"money", "M AH N IY"},
+    {"most", "M OW S T"}, {"mother", "M AH DH ER"}, {"move", "M UW V"},
+    {"nine", "N AY N"}, {"none", "N AH N"}, {"nothing", "N AH TH IH NG"},
+    {"of", "AH V"}, {"often", "AO F AH N"}, {"oh", "OW"}, {"ok", "OW K EY"},
+    {"okay", "OW K EY"}, {"once", "W AH N S"}, {"one", "W AH N"},
+    {"only", "OW N L IY"}, {"other", "AH DH ER"}, {"our", "AW ER"},
+    {"people", "P IY P AH L"}, {"piece", "P IY S"}, {"please", "P L IY Z"},
+    {"police", "P AH L IY S"}, {"pretty", "P R IH T IY"},
+    {"question", "K W EH S CH AH N"}, {"quiet", "K W AY AH T"},
+    {"really", "R IH L IY"}, {"right", "R AY T"}, {"said", "S EH D"},
+    {"says", "S EH Z"}, {"science", "S AY AH N S"}, {"seven", "S EH V AH N"},
+    {"she", "SH IY"}, {"should", "SH UH D"}, {"six", "S IH K S"},
+    {"some", "S AH M"}, {"someone", "S AH M W AH N"},
+    {"something", "S AH M TH IH NG"}, {"son", "S AH N"},
+    {"steak", "S T EY K"}, {"sugar", "SH UH G ER"}, {"sure", "SH UH R"},
+    {"talk", "T AO K"}, {"ten", "T EH N"}, {"than", "DH AE N"},
+    {"that", "DH AE T"}, {"the", "DH AH"}, {"their", "DH EH R"},
+    {"them", "DH EH M"}, {"then", "DH EH N"}, {"there", "DH EH R"},
+    {"these", "DH IY Z"}, {"they", "DH EY"}, {"think", "TH IH NG K"},
+    {"this", "DH IH S"}, {"those", "DH OW Z"}, {"though", "DH OW"},
+    {"thought", "TH AO T"}, {"three", "TH R IY"}, {"through", "TH R UW"},
+    {"to", "T UW"}, {"today", "T AH D EY"}, {"together", "T AH G EH DH ER"},
+    {"two", "T UW"}, {"understand", "AH N D ER S T AE N D"},
+    {"until", "AH N T IH L"}, {"video", "V IH D IY OW"}, {"walk", "W AO K"},
+    {"want", "W AA N T"}, {"was", "W AA Z"}, {"water", "W AO T ER"},
+    {"we", "W IY"}, {"we're", "W IY R"}, {"were", "W ER"},
+    {"what", "W AH T"}, {"where", "W EH R"}, {"who", "HH UW"},
+    {"whole", "HH OW L"}, {"whom", "HH UW M"}, {"whose", "HH UW Z"},
+    {"why", "W AY"}, {"woman", "W UH M AH N"}, {"women", "W IH M AH N"},
+    {"won't", "W OW N T"}, {"word", "W ER D"}, {"work", "W ER K"},
+    {"world", "W ER L D"}, {"would", "W UH D"}, {"you", "Y UW"},
+    {"you're", "Y UH R"}, {"young", "Y AH NG"}, {"your", "Y AO R"},
+    {"zero", "Z IY R OW"},
+};
+
+/**
+ * One letter-to-sound rule: left[match]right -> phonemes
+ * Context symbols: ' ' word boundary, '#' one or more vowels, ':' zero or
+ * more consonants, '^' one consonant, '.' voiced consonant, '+' front
+ * vowel (E I Y), '@' T S R D L Z N J, '&' sibilant, '%' suffix (ER E ES
+ * ED ING ELY, right context only).
+ */
+struct LetterRule {
+  const char* left;
+  const char* match;  // uppercase, starts with the rule's letter
+  const char* right;
+  const char* phonemes;
+};
+
+// Grouped by first letter; within a letter the first fit wins
+inline const LetterRule kLetterRules[] = {
+    {" ", "A", " ", "AH"},
+    {" ", "ARE", " ", "AA R"},
+    {" ", "AR", "O", "AH R"},
+    {"", "AR", "#", "EH R"},
+    {" :", "ANY", "", "EH N IY"},
+    {"", "A", "WA", "AH"},
+    {"", "AW", "", "AO"},
+    {"", "A", "^+#", "EY"},
+    {"#:", "ALLY", "", "AH L IY"},
+    {" ", "AL", "#", "AH L"},
+    {"#:", "AG", "E", "IH JH"},
+    {"", "A", "^+:#", "AE"},
+    {" :", "A", "^+ ", "EY"},
+    {"", "A", "^%", "EY"},
+    {" ", "ARR", "", "AH R"},
+    {"", "ARR", "", "AE R"},
+    {" :", "AR", " ", "AA R"},
+    {"", "AR", " ", "ER"},
+    {"", "AR", "", "AA R"},
+    {"", "AIR", "", "EH R"},
+    {"", "AI", "", "EY"},
+    {"", "AY", "", "EY"},
+    {"", "AU", "", "AO"},
+    {"#:", "AL", " ", "AH L"},
+    {"#:", "ALS", " ", "AH L Z"},
+    {"", "ALK", "", "AO K"},
+    {"", "AL", "^", "AO L"},
+    {" :", "ABLE", "", "EY B AH L"},
+    {"", "ABLE", "", "AH B AH L"},
+    {"", "ANG", "+", "EY N JH"},
+    {"", "A", "", "AE"},
+
+    {" ", "BE", "^#", "B IH"},
+    {"", "BEING", "", "B IY IH NG"},
+    {" ", "BUS", "#", "B IH Z"},
+    {"", "BUIL", "", "B IH L"},
+    {"M", "B", " ", ""},
+    {"", "BB", "", "B"},
+    {"", "B", "", "B"},
+
+    {" ", "CH", "^", "K"},
+    {"^E", "CH", "", "K"},
+    {"", "CH", "", "CH"},
+    {" S", "CI", "#", "S AY"},
+    {"", "CI", "A", "SH"},
+    {"", "CI", "O", "SH"},
+    {"", "CI", "EN", "SH"},
+    {"", "C", "+", "S"},
+    {"", "CK", "", "K"},
+    {"", "COM", "%", "K AH M"},
+    {"", "CC", "+", "K S"},
+    {"", "C", "", "K"},
+
+    {"#:", "DED", " ", "D IH D"},
+    {".E", "D", " ", "D"},
+    {"#^:E", "D", " ", "T"},
+    {" ", "DE", "^#", "D IH"},
+    {" ", "DOW", "", "D AW"},
+    {"", "DU", "A", "JH UW"},
+    {"", "DG", "E", "JH"},
+    {"", "DD", "", "D"},
+    {"", "D", "", "D"},
+
+    {"#:", "E", " ", ""},
+    {" :", "E", " ", "IY"},
+    {"#", "ED", " ", "D"},
+    {"#:", "E", "D ", ""},
+    {"", "EV", "ER", "EH V"},
+    {"", "E", "^%", "IY"},
+    {"", "ERI", "#", "IY R IY"},
+    {"", "ERI", "", "EH R IH"},
+    {"#:", "ER", "#", "ER"},
+    {"", "ER", "#", "EH R"},
+    {"", "ER", "", "ER"},
+    {" ", "EVEN", "", "IY V EH N"},
+    {"#:", "E", "W", ""},
+    {"@", "EW", "", "UW"},
+    {"", "EW", "", "Y UW"},
+    {"", "E", "O", "IY"},
+    {"#:&", "ES", " ", "IH Z"},
+    {"#:", "E", "S ", ""},
+    {"#:", "ELY", " ", "L IY"},
+    {"#:", "EMENT", "", "M EH N T"},
+    {"", "EFUL", "", "F UH L"},
+    {"", "EE", "", "IY"},
+    {"", "EARN", "", "ER N"},
+    {" ", "EAR", "^", "ER"},
+    {"", "EAD", "", "EH D"},
+    {"#:", "EA", " ", "IY AH"},
+    {"", "EA", "SU", "EH"},
+    {"", "EA", "", "IY"},
+    {"", "EIGH", "", "EY"},
+    {"", "EI", "", "IY"},
+    {" ", "EYE", "", "AY"},
+    {"", "EY", "", "IY"},
+    {"", "EU", "", "Y UW"},
+    {"", "E", "", "EH"},
+
+    {"", "FUL", "", "F UH L"},
+    {"", "FF", "", "F"},
+    {"", "F", "", "F"},
+
+    {"", "GIV", "", "G IH V"},
+    {" ", "G", "I^", "G"},
+    {"", "GE", "T", "G EH"},
+    {"SU", "GGES", "", "G JH EH S"},
+    {"", "GG", "", "G"},
+    {" B#", "G", "", "G"},
+    {"", "G", "+", "JH"},
+    {"#", "GH", "", ""},
+    {"", "G", "", "G"},
+
+    {" ", "HAV", "", "HH AE V"},
+    {" ", "HOUR", "", "AW ER"},
+    {"", "HOW", "", "HH AW"},
+    {"", "H", "#", "HH"},
+    {"", "H", "", ""},
+
+    {" ", "IN", "", "IH N"},
+    {" ", "I", " ", "AY"},
+    {"", "IN", "D", "AY N"},
+    {"", "IER", "", "IY ER"},
+    {"#:R", "IED", " ", "IY D"},
+    {"", "IED", " ", "AY D"},
+    {"", "IEN", "", "IY EH N"},
+    {"", "IE", "T", "AY EH"},
+    {" :", "I", "%", "AY"},
+    {"", "I", "%", "IY"},
+    {"", "IE", "", "IY"},
+    {"", "I", "^+:#", "IH"},
+    {"", "IR", "#", "AY R"},
+    {"", "IZ", "%", "AY Z"},
+    {"", "IS", "%", "AY Z"},
+    {"", "I", "D%", "AY"},
+    {"+^", "I", "^+", "IH"},
+    {"", "I", "T%", "AY"},
+    {"#^:", "I", "^+", "IH"},
+    {"", "I", "TY", "IH"},
+    {"", "I", "^+", "AY"},
+    {"", "IR", "", "ER"},
+    {"", "IGH", "", "AY"},
+    {"", "ILD", "", "AY L D"},
+    {"", "IGN", " ", "AY N"},
+    {"", "IGN", "^", "AY N"},
+    {"", "IGN", "%", "AY N"},
+    {"", "IQUE", "", "IY K"},
+    {"", "ION", "", "Y AH N"},
+    {"", "I", "", "IH"},
+
+    {"", "J", "", "JH"},
+
+    {" ", "K", "N", ""},
+    {"", "K", "", "K"},
+
+    {"", "LO", "C#", "L OW"},
+    {"L", "L", "", ""},
+    {"#^:", "L", "%", "AH L"},
+    {"", "LEAD", "", "L IY D"},
+    {"", "L", "", "L"},
+
+    {"", "MOV", "", "M UW V"},
+    {"", "MM", "", "M"},
+    {"", "M", "", "M"},
+
+    {"E", "NG", "+", "N JH"},
+    {"", "NG", "R", "NG G"},
+    {"", "NG", "#", "NG G"},
+    {"", "NGL", "%", "NG G AH L"},
+    {"", "NG", "", "NG"},
+    {"", "NK", "", "NG K"},
+    {" ", "NOW", " ", "N AW"},
+    {"", "NN", "", "N"},
+    {"", "N", "", "N"},
+
+    {"", "OF", " ", "AH V"},
+    {"", "OROUGH", "", "ER OW"},
+    {"#:", "OR", " ", "ER"},
+    {"#:", "ORS", " ", "ER Z"},
+    {"", "OR", "", "AO R"},
+    {" ", "ONE", "", "W AH N"},
+    {"", "OW", "", "OW"},
+    {" ", "OVER", "", "OW V ER"},
+    {"", "OV", "", "AH V"},
+    {"", "O", "^%", "OW"},
+    {"", "O", "^EN", "OW"},
+    {"", "O", "^I#", "OW"},
+    {"", "OL", "D", "OW L"},
+    {"", "OUGHT", "", "AO T"},
+    {"", "OUGH", "", "AH F"},
+    {" ", "OU", "", "AW"},
+    {"H", "OU", "S#", "AW"},
+    {"", "OUS", "", "AH S"},
+    {"", "OUR", "", "AO R"},
+    {"", "OULD", "", "UH D"},
+    {"^", "OU", "^L", "AH"},
+    {"", "OUP", "", "UW P"},
+    {"", "OU", "", "AW"},
+    {"", "OY", "", "OY"},
+    {"", "OING", "", "OW IH NG"},
+    {"", "OI", "", "OY"},
+    {"", "OOR", "", "AO R"},
+    {"", "OOK", "", "UH K"},
+    {"", "OOD", "", "UH D"},
+    {"", "OO", "", "UW"},
+    {"", "O", "E", "OW"},
+    {"", "O", " ", "OW"},
+    {"", "OA", "", "OW"},
+    {" ", "ONLY", "", "OW N L IY"},
+    {" ", "ONCE", "", "W AH N S"},
+    {"C", "O", "N", "AA"},
+    {"", "O", "NG", "AO"},
+    {" :^", "O", "N", "AH"},
+    {"I", "ON", "", "AH N"},
+    {"#:", "ON", " ", "AH N"},
+    {"#^", "ON", "", "AH N"},
+    {"", "O", "ST ", "OW"},
+    {"", "OF", "^", "AO F"},
+    {"", "OTHER", "", "AH DH ER"},
+    {"", "OSS", " ", "AO S"},
+    {"#^:", "OM", "", "AH M"},
+    {"", "O", "", "AA"},
+
+    {"", "PH", "", "F"},
+    {"", "PEOP", "", "P IY P"},
+    {"", "POW", "", "P AW"},
+    {"", "PUT", " ", "P UH T"},
+    {"", "PP", "", "P"},
+    {"", "P", "", "P"},
+
+    {"", "QUAR", "", "K W AO R"},
+    {"", "QU", "", "K W"},
+    {"", "Q", "", "K"},
+
+    {" ", "RE", "^#", "R IY"},
+    {"", "RR", "", "R"},
+    {"", "R", "", "R"},
+
+    {"", "SH", "", "SH"},
+    {"#", "SION", "", "ZH AH N"},
+    {"", "SOME", "", "S AH M"},
+    {"#", "SUR", "#", "ZH ER"},
+    {"", "SUR", "#", "SH ER"},
+    {"#", "SU", "#", "ZH UW"},
+    {"#", "SSU", "#", "SH UW"},
+    {"#", "SED", " ", "Z D"},
+    {"#", "S", "#", "Z"},
+    {"^", "SION", "", "SH AH N"},
+    {"", "S", "S", ""},
+    {".", "S", " ", "Z"},
+    {"#:.E", "S", " ", "Z"},
+    {"#^:#", "S", " ", "S"},
+    {"U", "S", " ", "S"},
+    {" :#", "S", " ", "Z"},
+    {" ", "SCH", "", "S K"},
+    {"", "S", "C+", ""},
+    {"#", "SM", "", "Z M"},
+    {"", "S", "", "S"},
+
+    {"", "THER", "", "DH ER"},
+    {"", "TH", "", "TH"},
+    {"#:", "TED", " ", "T IH D"},
+    {"S", "TI", "#N", "CH"},
+    {"", "TI", "O", "SH"},
+    {"", "TI", "A", "SH"},
+    {"", "TIEN", "", "SH AH N"},
+    {"", "TUR", "#", "CH ER"},
+    {"", "TU", "A", "CH UW"},
+    {"", "TCH", "", "CH"},
+    {"", "TT", "", "T"},
+    {"", "T", "", "T"},
+
+    {" ", "UN", "I", "Y UW N"},
+    {" ", "UN", "", "AH N"},
+    {" ", "UPON", "", "AH P AO N"},
+    {"@", "UR", "#", "UH R"},
+    {"", "UR", "#", "Y UH R"},
+    {"", "UR", "", "ER"},
+    {"", "U", "^ ", "AH"},
+    {"", "U", "^^", "AH"},
+    {"", "UY", "", "AY"},
+    {" G", "U", "#", ""},
+    {"G", "U", "%", ""},
+    {"G", "U", "#", "W"},
+    {"#N", "U", "", "Y UW"},
+    {"@", "U", "", "UW"},
+    {"", "U", "", "Y UW"},
+
+    {"", "VIEW", "", "V Y UW"},
+    {"", "V", "", "V"},
+
+    {"", "WA", "S", "W AA"},
+    {"", "WA", "T", "W AA"},
+    {"", "WHO", "", "HH UW"},
+    {"", "WH", "", "W"},
+    {"", "WAR", "", "W AO R"},
+    {"", "WOR", "^", "W ER"},
+    {"", "WR", "", "R"},
+    {"", "W", "", "W"},
+
+    {" ", "X", "", "Z"},
+    {"", "X", "", "K S"},
+
+    {" ", "YES", "", "Y EH S"},
+    {" ", "Y", "", "Y"},
+    {"#^:", "Y", " ", "IY"},
+    {"#^:", "Y", "I", "IY"},
+    {" :", "Y", " ", "AY"},
+    {" :", "Y", "#", "AY"},
+    {" :", "Y", "^+:#", "IH"},
+    {" :", "Y", "^#", "AY"},
+    {"", "Y", "", "IH"},
+
+    {"", "ZZ", "", "Z"},
+    {"", "Z", "", "Z"},
+};
+
+class GraphemeToPhoneme {
+ public:
+  static constexpr uint32_t kMaxWord = 48;  // longer words are split
+
+  GraphemeToPhoneme() {
+    tablesOk_ = dictionary_.build(
+        kG2pExceptions, sizeof(kG2pExceptions) / sizeof(kG2pExceptions[0]));
+    compileRules();
+  }
+
+  /** Every table entry parsed and hashed (checked by g2p-test) */
+  bool tablesOk() const { return tablesOk_; }
+  const PerfectHashDictionary& dictionary() const { return dictionary_; }
+
+  /**
+   * Convert UTF-8 text, appending phonemes and markers to out
+   * Non-ASCII characters are treated as word breaks.
+   */
+  void convert(const char* text, size_t length,
+               std::vector<uint8_t>& out) const {
+    char word[kMaxWord];
+    uint32_t n = 0;
+    auto flush = [&]() {
+      if (n) convertWord(word, n, out);
+      n = 0;
+    };
+
+    for (size_t i = 0; i < length; ++i) {
+      const char c = text[i];
+      if (isLetter(c) || (c == '\'' && n > 0 && i + 1 < length &&
+                          isLetter(text[i + 1]))) {
+        if (n == kMaxWord) flush();
+        word[n++] = lower(c);
+      } else if (isDigit(c)) {
+        flush();
+        i = readNumber(text, length, i, out) - 1;
+      } else {
+        flush();
+        if (c == '.' || c == '!' || c == '?') {
+          pause(out, kPhLongPause);
+        } else if (c == ',' || c == ';' || c == ':' || c == '\n') {
+          pause(out, kPhShortPause);
+        }
+      }
+    }
+    flush();
+  }
+
+  /**
+   * Convert one lowercase word (letters and apostrophes), then a word end
+   */
+  void convertWord(const char* word, uint32_t length,
+                   std::vector<uint8_t>& out) const {
+    const uint8_t* phonemes = nullptr;
+    uint32_t count = 0;
+    if (dictionary_.find(word, length, &phonemes, &count)) {
+      out.insert(out.end(), phonemes, phonemes + count);
+    } else {
+      applyRules(word, length, out);
+    }
+    out.push_back(kPhWordEnd);
+  }
+
+  size_t memoryBytes() const {
+    return dictionary_.memoryBytes() + rules_.capacity() * sizeof(Rule) +
+           rulePhonemes_.capacity();
+  }
+
+ private:
+  struct Rule {
+    const char* left;
+    const char* match;
+    const char* right;
+    uint8_t leftLength;
+    uint8_t matchLength;
+    uint8_t rightLength;
+    uint16_t offset;  // into rulePhonemes_
+    uint8_t count;
+  };
+
+  void compileRules() {
+    for (auto& range : letterRange_) range[0] = range[1] = 0;
+    rules_.clear();
+    rulePhonemes_.clear();
+    for (const LetterRule& r : kLetterRules) {
+      Rule rule;
+      rule.left = r.left;
+      rule.match = r.match;
+      rule.right = r.right;
+      rule.leftLength = static_cast<uint8_t>(std::strlen(r.left));
+      rule.matchLength = static_cast<uint8_t>(std::strlen(r.match));
+      rule.rightLength = static_cast<uint8_t>(std::strlen(r.right));
+      rule.offset = static_cast<uint16_t>(rulePhonemes_.size());
+      if (!parsePhonemes(r.phonemes, rulePhonemes_) || !isLetter(r.match[0])) {
+        tablesOk_ = false;
+        rulePhonemes_.resize(rule.offset);
+        continue;
+      }
+      rule.count = static_cast<uint8_t>(rulePhonemes_.size() - rule.offset);
+      const int letter = r.match[0] - 'A';
+      if (letterRange_[letter][1] == 0) {
+        letterRange_[letter][0] = static_cast<uint16_t>(rules_.size());
+      } else if (letterRange_[letter][1] != rules_.size()) {
+        tablesOk_ = false;  // letter's rules are not contiguous
+      }
+      rules_.push_back(rule);
+      letterRange_[letter][1] = static_cast<uint16_t>(rules_.size());
+    }
+    for (int letter = 0; letter < 26; ++letter) {
+      if (letterRange_[letter][1] == 0) tablesOk_ = false;
+    }
+  }
+
+  /**
+   * Letter-to-sound rules over an uppercased, space-padded copy
+   */
+  void applyRules(const char* word, uint32_t length,
+                  std::vector<uint8_t>& out) const {
+    char padded[kMaxWord + 2];
+    uint32_t n = 0;
+    padded[n++] = ' ';
+    for (uint32_t i = 0; i < length; ++i) {
+      if (word[i] != '\'') padded[n++] = static_cast<char>(word[i] - 32);
+    }
+    padded[n++] = ' ';
+
+    for (uint32_t i = 1; i + 1 < n;) {
+      const int letter = padded[i] - 'A';
+      uint32_t advance = 1;
+      for (uint32_t r = letterRange_[letter][0]; r < letterRange_[letter][1];
+           ++r) {
+        const Rule& rule = rules_[r];
+        if (i + rule.matchLength > n - 1 ||
+            std::memcmp(padded + i, rule.match, rule.matchLength) != 0 ||
+            !matchContext(rule.left, rule.leftLength - 1, -1, -1, padded,
+                          static_cast<int>(n), static_cast<int>(i) - 1) ||
+            !matchContext(rule.right, 0, rule.rightLength, 1, padded,
+                          static_cast<int>(n),
+                          static_cast<int>(i + rule.matchLength))) {
+          continue;
+        }
+        out.insert(out.end(), rulePhonemes_.begin() + rule.offset,
+                   rulePhonemes_.begin() + rule.offset + rule.count);
+        advance = rule.matchLength;
+        break;
+      }
+      i += advance;
+    }
+  }
+
+  /**
+   * Match context pattern[k..end) stepping dir (-1 reads a left context
+   * backwards from its last symbol); '#' and ':' backtrack over their
+   * runs, so "#^:" also fits when ':' has to match nothing
+   */
+  static bool matchContext(const char* pattern, int k, int end, int dir,
+                           const char* s, int n, int pos) {
+    if (k == end) return true;
+    const char c = pattern[k];
+    const char at = pos >= 0 && pos < n ? s[pos] : ' ';
+    switch (c) {
+      case ' ':
+        return at == ' ' &&
+               matchContext(pattern, k + dir, end, dir, s, n, pos + dir);
+      case '#':
+        if (!isVowel(at)) return false;
+        for (int q = pos + dir;; q += dir) {
+          if (matchContext(pattern, k + dir, end, dir, s, n, q)) return true;
+          if (q < 0 || q >= n || !isVowel(s[q])) return false;
+        }
+      case ':':
+        for (int q = pos;; q += dir) {
+          if (matchContext(pattern, k + dir, end, dir, s, n, q)) return true;
+          if (q < 0 || q >= n || !isConsonant(s[q])) return false;
+        }
+      case '%': {
+        static const char* const kSuffixes[] = {"ING", "ELY", "ER", "ES",
+                                                "ED", "E"};
+        for (const char* suffix : kSuffixes) {
+          const int len = static_cast<int>(std::strlen(suffix));
+          if (pos + len <= n && std::memcmp(s + pos, suffix, len) == 0 &&
+              matchContext(pattern, k + dir, end, dir, s, n, pos + len)) {
+            return true;
+          }
+        }
+        return false;
+      }
+      default:
+        return matchClass(c, at) &&
+               matchContext(pattern, k + dir, end, dir, s, n, pos + dir);
+    }
+  }
+
+  static bool matchClass(char c, char at) {
+    switch (c) {
+      case '^': return isConsonant(at);
+      case '.': return at && std::strchr("BDVGJLMNRWZ", at);
+      case '+': return at == 'E' || at == 'I' || at == 'Y';
+      case '@': return at && std::strchr("TSRDLZNJ", at);
+      case '&': return at && std::strchr("SCGZXJ", at);
+      default: return c == at;
+    }
+  }
+
+  static bool isLetter(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+  static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+  static uint32_t digit(char c) { return static_cast<uint32_t>(c - '0'); }
+  static char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c + 32) : c;
+  }
+  static bool isVowel(char c) {
+    return c == 'A' || c == 'E' || c == 'I' || c == 'O' || c == 'U';
+  }
+  static bool isConsonant(char c) {
+    return c >= 'A' && c <= 'Z' && !isVowel(c);
+  }
+
+  static void pause(std::vector<uint8_t>& out, uint8_t marker) {
+    if (out.empty()) return;  // no leading pause
+    uint8_t& last = out.back();
+    if (last == kPhShortPause || last == kPhLongPause) {
+      last = std::max(last, marker);
+    } else {
+      out.push_back(marker);
+    }
+  }
+
+  /**
+   * Read digits at text[i] as a cardinal number (with "point" decimals
+   * and thousands commas); returns the index after the number
+   */
+  size_t readNumber(const char* text, size_t length, size_t i,
+                    std::vector<uint8_t>& out) const {
+    uint64_t value = 0;
+    uint32_t digits = 0;
+    const size_t start = i;
+    for (; i < length; ++i) {
+      if (isDigit(text[i])) {
+        if (digits < 19) value = value * 10 + digit(text[i]);
+        ++digits;
+      } else if (text[i] == ',' && i + 3 < length && isDigit(text[i + 1]) &&
+                 isDigit(text[i + 2]) && isDigit(text[i + 3]) &&
+                 (i + 4 >= length || !isDigit(text[i + 4]))) {
+        continue;  // thousands separator
+      } else {
+        break;
+      }
+    }
+
+    if (digits <= 6) {
+      sayNumber(static_cast<uint32_t>(value), out);
+    } else {
+      for (size_t k = start; k < i; ++k) {
+        if (isDigit(text[k])) sayNumber(digit(text[k]), out);
+      }
+    }
+
+    if (i + 1 < length && text[i] == '.' && isDigit(text[i + 1])) {
+      say("point", out);
+      for (++i; i < length && isDigit(text[i]); ++i) {
+        sayNumber(digit(text[i]), out);
+      }
+    }
+    return i;
+  }
+
+  void say(const char* word, std::vector<uint8_t>& out) const {
+    convertWord(word, static_cast<uint32_t>(std::strlen(word)), out);
+  }
+
+  void sayNumber(uint32_t value, std::vector<uint8_t>& out) const {
+    static const char* const kOnes[] = {
+        "zero", "one", "two", "three", "four", "five", "six", "seven",
+        "eight", "nine", "ten", "eleven", "twelve", "thirteen", "fourteen",
+        "fifteen", "sixteen", "seventeen", "eighteen", "nineteen"};
+    static const char* const kTens[] = {"", "", "twenty", "thirty", "forty",
+                                        "fifty", "sixty", "seventy",
+                                        "eighty", "ninety"};
+    if (value >= 1000) {
+      sayNumber(value / 1000, out);
+      say("thousand", out);
+      value %= 1000;
+      if (value == 0) return;
+    }
+    if (value >= 100) {
+      say(kOnes[value / 100], out);
+      say("hundred", out);
+      value %= 100;
+      if (value == 0) return;
+    }
+    if (value >= 20) {
+      say(kTens[value / 10], out);
+      if (value % 10) say(kOnes[value % 10], out);
+    } else {
+      say(kOnes[value], out);
+    }
+  }
+
+  PerfectHashDictionary dictionary_;
+  std::vector<Rule> rules_;
+  std::vector<uint8_t> rulePhonemes_;
+  uint16_t letterRange_[26][2];  // [first, end) into rules_
+  bool tablesOk_{true};
+};
+
+}  // namespace avatar
@@ -0,0 +1,95 @@
+/**
+ * avatar-hop-framer.h - Decimate streaming PCM and cut it into hopped frames
+ *
+ * Shared front end of the audio analysers (prosody, voice activity). Input
+ * arrives in whatever chunks JS or the microphone ring hand over. It is
+ * box-filter decimated, buffered, and each complete frame is passed to a
+ * callback once per hop. A single push delivers at most maxHops frames,
+ * the newest ones. Any older backlog (a stalled tab) is counted and
+ * skipped, so a late frame costs a bounded amount of CPU.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace avatar {
+
+class HopFramer {
+ public:
+  /**
+   * factor input samples per analysis sample; frame and hop in analysis
+   * samples
+   */
+  void configure(uint32_t factor, uint32_t frame, uint32_t hop,
+                 uint32_t maxHops) {
+    factor_ = std::max(1u, factor);
+    frame_ = frame;
+    hop_ = std::max(1u, hop);
+    maxHops_ = std::max(1u, maxHops);
+    buffer_.reserve(frame_ + hop_ * maxHops_);
+    reset();
+  }
+
+  bool configured() const { return frame_ > 0; }
+  uint32_t factor() const { return factor_; }
+  uint32_t frameSize() const { return frame_; }
+  uint32_t hopSize() const { return hop_; }
+
+  void reset() {
+    buffer_.clear();
+    phase_ = 0;
+    sum_ = 0.0f;
+    dropped_ = 0;
+  }
+
+  /**
+   * Append input; calls onFrame(const float* frame) for each whole hop,
+   * oldest first
+   */
+  template <typename OnFrame>
+  void push(const float* samples, uint32_t count, OnFrame&& onFrame) {
+    if (frame_ == 0) return;
+    for (uint32_t i = 0; i < count; ++i) {
+      sum_ += samples[i];
+      if (++phase_ < factor_) continue;
+      // Box-filter decimation: enough anti-aliasing for pitch and energy
+      buffer_.push_back(sum_ / static_cast<float>(factor_));
+      phase_ = 0;
+      sum_ = 0.0f;
+    }
+
+    // Frames end hop_ apart; the first one ends at frame_
+    const uint32_t size = static_cast<uint32_t>(buffer_.size());
+    uint32_t end = frame_;
+    if (size >= end) {
+      const uint32_t ready = (size - end) / hop_ + 1;
+      if (ready > maxHops_) {
+        end += (ready - maxHops_) * hop_;
+        dropped_ += ready - maxHops_;
+      }
+      for (; end <= size; end += hop_) onFrame(&buffer_[end - frame_]);
+    }
+    // Keep what the next unfinished frame needs
+    buffer_.erase(buffer_.begin(), buffer_.begin() + (end - frame_));
+  }
+
+  /** Hops skipped because a push carried more than maxHops */
+  uint64_t dropped() const { return dropped_; }
+
+  size_t memoryBytes() const { return buffer_.capacity() * sizeof(float); }
+
+ private:
+  uint32_t factor_{1};
+  uint32_t frame_{0};
+  uint32_t hop_{1};
+  uint32_t maxHops_{1};
+  std::vector<float> buffer_;  // decimated samples, oldest first
+  uint32_t phase_{0};
+  float sum_{0.0f};
+  uint64_t dropped_{0};
+};
+
+}  // namespace avatar
@@ -0,0 +1,329 @@
+/**
+ * avatar-json.h - Minimal JSON reader for engine assets
+ *
+ * Parses a complete document into a small DOM. Meant for load-time
+ * assets (animation graphs, tuning tables) that are compiled into flat
+ * runtime structures right away. It is not a general-purpose or
+ * streaming parser. Object members keep document order. The input does
+ * not need to be NUL-terminated.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace avatar {
+namespace json {
+
+enum class Type { kNull, kBool, kNumber, kString, kArray, kObject };
+
+struct Member;
+
+struct Value {
+  Type type{Type::kNull};
+  bool boolean{false};
+  double number{0.0};
+  std::string string;
+  std::vector<Value> items;     // kArray
+  std::vector<Member> members;  // kObject, document order
+
+  bool isNull() const { return type == Type::kNull; }
+  bool isBool() const { return type == Type::kBool; }
+  bool isNumber() const { return type == Type::kNumber; }
+  bool isString() const { return type == Type::kString; }
+  bool isArray() const { return type == Type::kArray; }
+  bool isObject() const { return type == Type::kObject; }
+
+  /** Member by key, or nullptr (also for non-objects) */
+  inline const Value* find(const char* key) const;
+
+  double numberOr(double fallback) const {
+    return isNumber() ? number : fallback;
+  }
+  bool boolOr(bool fallback) const { return isBool() ? boolean : fallback; }
+  const char* stringOr(const char* fallback) const {
+    return isString() ? string.c_str() : fallback;
+  }
+};
+
+struct Member {
+  std::string key;
+  Value value;
+};
+
+inline const Value* Value::find(const char* key) const {
+  for (const Member& m : members) {
+    if (m.key == key) return &m.value;
+  }
+  return nullptr;
+}
+
+namespace detail {
+
+class Parser {
+ public:
+  Parser(const char* text, size_t length)
+      : p_(text), begin_(text), end_(text + length) {}
+
+  bool parseDocument(Value& out, std::string* error) {
+    skipSpace();
+    if (!parseValue(out, 0)) return report(error);
+    skipSpace();
+    if (p_ != end_) {
+      fail("trailing characters");
+      return report(error);
+    }
+    return true;
+  }
+
+ private:
+  static constexpr int kMaxDepth = 64;
+
+  bool fail(const char* message) {
+    if (!message_) {
+      message_ = message;
+      at_ = p_;
+    }
+    return false;
+  }
+
+  bool report(std::string* error) {
+    if (error) {
+      *error = "offset " + std::to_string(at_ - begin_) + ": " + message_;
+    }
+    return false;
+  }
+
+  void skipSpace() {
+    while (p_ != end_ &&
+           (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+      ++p_;
+    }
+  }
+
+  bool literal(const char* word) {
+    const char* q = p_;
+    for (; *word; ++word, ++q) {
+      if (q == end_ || *q != *word) return fail("invalid literal");
+    }
+    p_ = q;
+    return true;
+  }
+
+  bool parseValue(Value& out, int depth) {
+    if (depth > kMaxDepth) return fail("nesting too deep");
+    if (p_ == end_) return fail("unexpected end of input");
+    switch (*p_) {
+      case '{': return parseObject(out, depth);
+      case '[': return parseArray(out, depth);
+      case '"':
+        out.type = Type::kString;
+        return parseString(out.string);
+      case 't':
+        out.type = Type::kBool;
+        out.boolean = true;
+        return literal("true");
+      case 'f':
+        out.type = Type::kBool;
+        out.boolean = false;
+        return literal("false");
+      case 'n':
+        out.type = Type::kNull;
+        return literal("null");
+      default:
+        return parseNumber(out);
+    }
+  }
+
+  bool parseObject(Value& out, int depth) {
+    out.type = Type::kObject;
+    ++p_;  // '{'
+    skipSpace();
+    if (p_ != end_ && *p_ == '}') {
+      ++p_;
+      return true;
+    }
+    for (;;) {
+      skipSpace();
+      if (p_ == end_ || *p_ != '"') return fail("expected member name");
+      out.members.emplace_back();
+      Member& member = out.members.back();
+      if (!parseString(member.key)) return false;
+      skipSpace();
+      if (p_ == end_ || *p_ != ':') return fail("expected ':'");
+      ++p_;
+      skipSpace();
+      if (!parseValue(member.value, depth + 1)) return false;
+      skipSpace();
+      if (p_ == end_) return fail("unterminated object");
+      if (*p_ == ',') {
+        ++p_;
+        continue;
+      }
+      if (*p_ != '}') return fail("expected ',' or '}'");
+      ++p_;
+      return true;
+    }
+  }
+
+  bool parseArray(Value& out, int depth) {
+    out.type = Type::kArray;
+    ++p_;  // '['
+    skipSpace();
+    if (p_ != end_ && *p_ == ']') {
+      ++p_;
+      return true;
+    }
+    for (;;) {
+      skipSpace();
+      out.items.emplace_back();
+      if (!parseValue(out.items.back(), depth + 1)) return false;
+      skipSpace();
+      if (p_ == end_) return fail("unterminated array");
+      if (*p_ == ',') {
+        ++p_;
+        continue;
+      }
+      if (*p_ != ']') return fail("expected ',' or ']'");
+      ++p_;
+      return true;
+    }
+  }
+
+  bool hex4(uint32_t& out) {
+    if (end_ - p_ < 4) return fail("truncated \\u escape");
+    out = 0;
+    for (int i = 0; i < 4; ++i, ++p_) {
+      const char c = *p_;
+      out <<= 4;
+      if (c >= '0' && c <= '9') out |= c - '0';
+      else if (c >= 'a' && c <= 'f') out |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') out |= c - 'A' + 10;
+      else return fail("invalid \\u escape");
+    }
+    return true;
+  }
+
+  static void appendUtf8(std::string& s, uint32_t cp) {
+    if (cp < 0x80) {
+      s += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+      s += static_cast<char>(0xC0 | (cp >> 6));
+      s += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+      s += static_cast<char>(0xE0 | (cp >> 12));
+      s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      s += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+      s += static_cast<char>(0xF0 | (cp >> 18));
+      s += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+      s += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      s += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+  }
+
+  bool parseString(std::string& out) {
+    ++p_;  // opening quote
+    for (;;) {
+      if (p_ == end_) return fail("unterminated string");
+      const char c = *p_++;
+      if (c == '"') return true;
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return fail("control character in string");
+      }
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (p_ == end_) return fail("unterminated string");
+      switch (*p_++) {
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          uint32_t cp;
+          if (!hex4(cp)) return false;
+          if (cp >= 0xD800 && cp < 0xDC00) {
+            uint32_t low;
+            if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') {
+              return fail("unpaired surrogate");
+            }
+            p_ += 2;
+            if (!hex4(low)) return false;
+            if (low < 0xDC00 || low >= 0xE000) {
+              return fail("unpaired surrogate");
+            }
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+          }
+          appendUtf8(out, cp);
+          break;
+        }
+        default:
+          return fail("invalid escape");
+      }
+    }
+  }
+
+  bool parseNumber(Value& out) {
+    const char* start = p_;
+    if (p_ != end_ && *p_ == '-') ++p_;
+    const char* digits = p_;
+    while (p_ != end_ && ((*p_ >= '0' && *p_ <= '9') || *p_ == '.' ||
+                          *p_ == 'e' || *p_ == 'E' || *p_ == '+' ||
+                          *p_ == '-')) {
+      ++p_;
+    }
+    if (p_ == digits || *digits < '0' || *digits > '9') {
+      p_ = start;
+      return fail("unexpected character");
+    }
+    // strtod needs a terminated copy; numbers in assets are short
+    char buffer[64];
+    const size_t length = static_cast<size_t>(p_ - start);
+    if (length >= sizeof(buffer)) {
+      p_ = start;
+      return fail("number too long");
+    }
+    for (size_t i = 0; i < length; ++i) buffer[i] = start[i];
+    buffer[length] = '\0';
+    char* parsedEnd = nullptr;
+    out.type = Type::kNumber;
+    out.number = std::strtod(buffer, &parsedEnd);
+    if (parsedEnd != buffer + length) {
+      p_ = start;
+      return fail("invalid number");
+    }
+    return true;
+  }
+
+  const char* p_;
+  const char* begin_;
+  const char* end_;
+  const char* message_{nullptr};
+  const char* at_{nullptr};
+};
+
+}  // namespace detail
+
+/**
+ * Parse a complete JSON document
+ * On failure returns false and, if error is non-null, sets it to
+ * "offset N: message".
+ */
+inline bool parse(const char* text, size_t length, Value& out,
+                  std::string* error = nullptr) {
+  out = Value{};
+  return detail::Parser(text, length).parseDocument(out, error);
+}
+
+}  // namespace json
+}  // namespace avatar
@@ -0,0 +1,112 @@
+/**
+ * avatar-latency.h - Audio-to-mouth latency tracking
+ *
+ * Every lip-sync morph update carries two timestamps from JavaScript (both
+ * in the performance.now() clock, which is also emscripten_get_now()):
+ *   audioTimeMs    - when the analysed audio is audible at the output
+ *   analysisTimeMs - when the analyser produced the mouth values
+ * The engine stamps the update when it arrives and again when the frame
+ * that first shows it is presented. Each presented update becomes one
+ * latency sample, split into stages and recorded into histograms.
+ *
+ * The analyser reads audio that is still in the output pipeline, so the
+ * analysis often comes before the audio is audible. Histograms hold
+ * non-negative times, so that lead is recorded in its own stage.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "avatar-frame-histogram.h"
+
+namespace avatar {
+
+enum LatencyStage : int {
+  kLatencyTotal = 0,     // audio audible -> frame presented
+  kLatencyAnalysis,      // audio audible -> analysis, if analysed after
+  kLatencyBridge,        // analysis -> morph update received by engine
+  kLatencyPresent,       // morph update received -> frame presented
+  kLatencyAnalysisAhead, // analysis -> audio audible, if analysed before
+  kLatencyStageCount
+};
+
+class AudioMouthLatency {
+ public:
+  static constexpr uint32_t kRecentCapacity = 256;  // power of two
+
+  /**
+   * Record a morph update's timestamps; non-positive audioTimeMs means
+   * the update isn't driven by audio (idle/listening) and is ignored.
+   */
+  void onMorphUpdate(double audioTimeMs, double analysisTimeMs,
+                     double receivedMs) {
+    if (!(audioTimeMs > 0.0)) return;
+    // Several updates may land before one present; the frame shows the
+    // latest weights, so the latest update is the one measured.
+    pending_ = true;
+    audioTimeMs_ = audioTimeMs;
+    analysisTimeMs_ = analysisTimeMs > 0.0 ? analysisTimeMs : receivedMs;
+    receivedMs_ = receivedMs;
+  }
+
+  /**
+   * Close out the pending update when its frame is presented
+   */
+  void onPresent(double presentMs) {
+    if (!pending_) return;
+    pending_ = false;
+
+    const double total = presentMs - audioTimeMs_;
+    if (total < 0.0) ++earlyCount_;
+
+    stages_[kLatencyTotal].recordMillis(total);
+    const double analysis = analysisTimeMs_ - audioTimeMs_;
+    if (analysis < 0.0) {
+      stages_[kLatencyAnalysisAhead].recordMillis(-analysis);
+    } else {
+      stages_[kLatencyAnalysis].recordMillis(analysis);
+    }
+    stages_[kLatencyBridge].recordMillis(receivedMs_ - analysisTimeMs_);
+    stages_[kLatencyPresent].recordMillis(presentMs - receivedMs_);
+
+    recent_[recentHead_++ & (kRecentCapacity - 1)] =
+        static_cast<float>(total);
+  }
+
+  void reset() {
+    for (auto& h : stages_) h.reset();
+    recentHead_ = 0;
+    earlyCount_ = 0;
+    pending_ = false;
+  }
+
+  const FrameHistogram& stage(int index) const { return stages_[index]; }
+
+  /**
+   * Most recent total latency samples (ms), oldest first once wrapped
+   * Returns the number of valid samples in `recent()`.
+   */
+  uint32_t recentCount() const {
+    return recentHead_ < kRecentCapacity ? recentHead_ : kRecentCapacity;
+  }
+  const float* recent() const { return recent_; }
+  uint32_t recentHead() const { return recentHead_; }
+
+  // Samples where the mouth moved before the audio was audible; these
+  // are recorded as 0 ms in the histograms.
+  uint32_t earlyCount() const { return earlyCount_; }
+
+ private:
+  FrameHistogram stages_[kLatencyStageCount];
+  float recent_[kRecentCapacity]{};
+  uint32_t recentHead_{0};
+  uint32_t earlyCount_{0};
+
+  bool pending_{false};
+  double audioTimeMs_{0.0};
+  double analysisTimeMs_{0.0};
+  double receivedMs_{0.0};
+};
+
+}  // namespace avatar
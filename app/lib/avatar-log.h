@@ -0,0 +1,245 @@
+/**
+ * avatar-log.h - Ring-buffered, level-filtered engine logging
+ *
+ * Log calls store the static format string pointer plus raw arguments in a
+ * fixed ring of records; nothing is formatted and nothing crosses into
+ * JavaScript at the call site. AvatarController drains the ring once per
+ * frame (or on demand) and formats the records in JS.
+ *
+ * Levels below AVATAR_LOG_LEVEL compile to nothing:
+ *   0 = debug, 1 = info, 2 = warn, 3 = error, 4 = off
+ *
+ * Usage:
+ *   AVATAR_LOG_INFO("Animation state changed to: %s", stateName);
+ *   AVATAR_LOG_ERROR("Failed to load avatar model: %s", e.what());
+ *
+ * Supported conversions are %d %u %f %.Nf %s (up to LogRecord::kTextSlots
+ * string arguments per record, each truncated to LogRecord::kTextSize - 1
+ * bytes).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "avatar-platform.h"
+
+#ifndef AVATAR_LOG_LEVEL
+#ifdef NDEBUG
+#define AVATAR_LOG_LEVEL 2
+#else
+#define AVATAR_LOG_LEVEL 0
+#endif
+#endif
+
+namespace avatar {
+namespace log {
+
+enum Level : uint32_t {
+  kDebug = 0,
+  kInfo = 1,
+  kWarn = 2,
+  kError = 3,
+};
+
+enum ArgKind : uint32_t {
+  kArgInt = 0,
+  kArgDouble = 1,
+  kArgString = 2,
+};
+
+/**
+ * One log record, read directly by JavaScript
+ * wasm32 layout (120 bytes):
+ *   0 timeMs f64 | 8 format ptr | 12 level u32 | 16 argCount u32
+ *   20 argKinds u32 (2 bits per arg) | 24 args f64[4]
+ *   56 text char[2][32] (the Nth string argument goes in text[N])
+ */
+struct LogRecord {
+  static constexpr uint32_t kMaxArgs = 4;
+  static constexpr uint32_t kTextSlots = 2;
+  static constexpr uint32_t kTextSize = 32;
+
+  double timeMs;
+  const char* format;
+  uint32_t level;
+  uint32_t argCount;
+  uint32_t argKinds;
+  double args[kMaxArgs];
+  char text[kTextSlots][kTextSize];
+};
+
+#ifdef __EMSCRIPTEN__
+static_assert(sizeof(LogRecord) == 120, "LogRecord layout is read from JS");
+#endif
+
+class LogRing {
+ public:
+  static constexpr uint32_t kCapacity = 256;  // power of two
+
+  LogRecord& acquire() {
+    if (head_ - tail_ == kCapacity) {
+      ++tail_;  // Overwrite the oldest record
+      ++dropped_;
+    }
+    return records_[head_++ & (kCapacity - 1)];
+  }
+
+  /**
+   * Copy pending records in order into the drain buffer
+   * Returns the number of records copied.
+   */
+  uint32_t drain() {
+    const uint32_t count = head_ - tail_;
+    for (uint32_t i = 0; i < count; ++i) {
+      drained_[i] = records_[(tail_ + i) & (kCapacity - 1)];
+    }
+    tail_ = head_;
+    return count;
+  }
+
+  const LogRecord* drainBuffer() const { return drained_; }
+  uint32_t pending() const { return head_ - tail_; }
+
+  uint32_t takeDropped() {
+    const uint32_t dropped = dropped_;
+    dropped_ = 0;
+    return dropped;
+  }
+
+  void clear() {
+    head_ = tail_ = 0;
+    dropped_ = 0;
+  }
+
+ private:
+  LogRecord records_[kCapacity];
+  LogRecord drained_[kCapacity];
+  uint32_t head_{0};
+  uint32_t tail_{0};
+  uint32_t dropped_{0};
+};
+
+inline LogRing& ring() {
+  static LogRing instance;
+  return instance;
+}
+
+inline double nowMs() { return emscripten_get_now(); }
+
+inline void setArg(LogRecord& r, uint32_t i, double value) {
+  r.args[i] = value;
+  r.argKinds |= kArgDouble << (i * 2);
+}
+
+inline void setArg(LogRecord& r, uint32_t i, float value) {
+  setArg(r, i, static_cast<double>(value));
+}
+
+inline void setArg(LogRecord& r, uint32_t i, int value) {
+  r.args[i] = static_cast<double>(value);
+}
+
+inline void setArg(LogRecord& r, uint32_t i, unsigned value) {
+  r.args[i] = static_cast<double>(value);
+}
+
+inline void setArg(LogRecord& r, uint32_t i, long value) {
+  r.args[i] = static_cast<double>(value);
+}
+
+inline void setArg(LogRecord& r, uint32_t i, unsigned long value) {
+  r.args[i] = static_cast<double>(value);
+}
+
+inline void setArg(LogRecord& r, uint32_t i, long long value) {
+  r.args[i] = static_cast<double>(value);
+}
+
+inline void setArg(LogRecord& r, uint32_t i, unsigned long long value) {
+  r.args[i] = static_cast<double>(value);
+}
+
+inline void setArg(LogRecord& r, uint32_t i, const char* value) {
+  // Earlier string arguments took the lower slots
+  uint32_t slot = 0;
+  for (uint32_t j = 0; j < i; ++j) {
+    if (((r.argKinds >> (j * 2)) & 3) == kArgString) ++slot;
+  }
+  r.args[i] = 0.0;
+  r.argKinds |= kArgString << (i * 2);
+  if (!value) value = "(null)";
+  std::strncpy(r.text[slot], value, LogRecord::kTextSize - 1);
+  r.text[slot][LogRecord::kTextSize - 1] = '\0';
+}
+
+inline void setArg(LogRecord& r, uint32_t i, const std::string& value) {
+  setArg(r, i, value.c_str());
+}
+
+inline void setArgs(LogRecord&, uint32_t) {}
+
+template <typename T, typename... Rest>
+inline void setArgs(LogRecord& r, uint32_t i, const T& value,
+                    const Rest&... rest) {
+  setArg(r, i, value);
+  setArgs(r, i + 1, rest...);
+}
+
+template <typename T>
+constexpr bool isTextArg() {
+  using D = std::decay_t<T>;
+  return std::is_same_v<D, const char*> || std::is_same_v<D, char*> ||
+         std::is_same_v<D, std::string>;
+}
+
+template <typename... Args>
+inline void push(Level level, const char* format, const Args&... args) {
+  static_assert(sizeof...(Args) <= LogRecord::kMaxArgs,
+                "Too many log arguments");
+  static_assert((0u + ... + (isTextArg<Args>() ? 1u : 0u)) <=
+                    LogRecord::kTextSlots,
+                "Too many string log arguments");
+  LogRecord& r = ring().acquire();
+  r.timeMs = nowMs();
+  r.format = format;
+  r.level = level;
+  r.argCount = sizeof...(Args);
+  r.argKinds = 0;
+  setArgs(r, 0, args...);
+}
+
+}  // namespace log
+}  // namespace avatar
+
+#if AVATAR_LOG_LEVEL <= 0
+#define AVATAR_LOG_DEBUG(...) \
+  ::avatar::log::push(::avatar::log::kDebug, __VA_ARGS__)
+#else
+#define AVATAR_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if AVATAR_LOG_LEVEL <= 1
+#define AVATAR_LOG_INFO(...) \
+  ::avatar::log::push(::avatar::log::kInfo, __VA_ARGS__)
+#else
+#define AVATAR_LOG_INFO(...) ((void)0)
+#endif
+
+#if AVATAR_LOG_LEVEL <= 2
+#define AVATAR_LOG_WARN(...) \
+  ::avatar::log::push(::avatar::log::kWarn, __VA_ARGS__)
+#else
+#define AVATAR_LOG_WARN(...) ((void)0)
+#endif
+
+#if AVATAR_LOG_LEVEL <= 3
+#define AVATAR_LOG_ERROR(...) \
+  ::avatar::log::push(::avatar::log::kError, __VA_ARGS__)
+#else
+#define AVATAR_LOG_ERROR(...) ((void)0)
+#endif
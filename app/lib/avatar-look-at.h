@@ -0,0 +1,216 @@
+/**
+ * avatar-look-at.h - Analytic look-at for neck, head and eyes
+ *
+ * No iterative IK: the solver reads the yaw and pitch from the head to the
+ * target, clamps them to angular limits, damps them over time and writes
+ * them back as rotations. The neck and head split the head-chain
+ * rotation between them. The eyes cover what is left, within their own
+ * limits, and respond faster, so they lead and the head follows.
+ *
+ * Angles are measured in model space against the avatar's forward axis
+ * (+Z, the glTF convention), on top of the animated pose, so clips keep
+ * playing underneath. Runs after FlatSkeleton::computeWorld() and
+ * recomputes only the affected subtrees. A zero weight relaxes back to
+ * the animated pose with the same damping.
+ *
+ * A gesture offset (speech nods) is added to the head chain undamped,
+ * since its source is already smoothed. The eyes counter it, so the gaze
+ * stays on the target while the head moves.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "avatar-simd.h"
+#include "avatar-skeleton.h"
+
+namespace avatar {
+
+struct LookAtParams {
+  float neckShare{0.35f};     // fraction of the head-chain rotation
+  float headYawLimit{1.2f};   // radians, neck + head combined (~70 deg)
+  float headPitchLimit{0.6f};
+  float eyeYawLimit{0.5f};    // relative to the head (~30 deg)
+  float eyePitchLimit{0.35f};
+  float headResponse{6.0f};   // exponential approach rate, 1/s
+  float eyeResponse{25.0f};
+};
+
+class LookAtSolver {
+ public:
+  static constexpr int32_t kNone = -1;
+
+  /**
+   * Flat joint indices, kNone where the model lacks a joint (the head is
+   * required; without a neck the head takes the whole rotation)
+   */
+  void bind(int32_t neck, int32_t head, int32_t leftEye, int32_t rightEye) {
+    neck_ = neck;
+    head_ = head;
+    eyes_[0] = leftEye;
+    eyes_[1] = rightEye;
+    reset();
+  }
+
+  bool bound() const { return head_ != kNone; }
+  void reset() {
+    yaw_ = pitch_ = eyeYaw_ = eyePitch_ = 0.0f;
+    gestureYaw_ = gesturePitch_ = 0.0f;
+  }
+
+  /**
+   * Head-chain offset in radians on top of the aim, held until changed
+   */
+  void setGesture(float yaw, float pitch) {
+    gestureYaw_ = yaw;
+    gesturePitch_ = pitch;
+  }
+
+  LookAtParams& params() { return params_; }
+  float headYaw() const { return yaw_; }
+  float headPitch() const { return pitch_; }
+  float eyeYaw() const { return eyeYaw_; }
+  float eyePitch() const { return eyePitch_; }
+
+  /**
+   * Aim at target (model space, xyz) with weight in [0, 1]
+   * Rewrites the local rotations of the bound joints and the world
+   * matrices of their subtrees. Expects bound joints in pre-order (neck,
+   * head, then eyes), as FlatSkeleton lays them out.
+   */
+  void apply(FlatSkeleton& skeleton, const float* target, float weight,
+             float dt) {
+    if (!bound()) return;
+
+    float desiredYaw = 0.0f, desiredPitch = 0.0f;
+    if (weight > 0.0f) {
+      float head[4];
+      simd::store(head, skeleton.world()[head_].col[3]);
+      const float dx = target[0] - head[0];
+      const float dy = target[1] - head[1];
+      const float dz = target[2] - head[2];
+      const float flat = std::sqrt(dx * dx + dz * dz);
+      if (flat + std::fabs(dy) > 1e-4f) {
+        desiredYaw = weight * std::atan2(dx, dz);
+        desiredPitch = weight * std::atan2(dy, flat);
+      }
+    }
+
+    const float headYaw = clamp(desiredYaw, params_.headYawLimit);
+    const float headPitch = clamp(desiredPitch, params_.headPitchLimit);
+    yaw_ += (headYaw - yaw_) * approach(params_.headResponse, dt);
+    pitch_ += (headPitch - pitch_) * approach(params_.headResponse, dt);
+    // Eyes cover the gap left by the (lagging) head
+    const float eyeYaw = clamp(desiredYaw - yaw_, params_.eyeYawLimit);
+    const float eyePitch = clamp(desiredPitch - pitch_, params_.eyePitchLimit);
+    eyeYaw_ += (eyeYaw - eyeYaw_) * approach(params_.eyeResponse, dt);
+    eyePitch_ += (eyePitch - eyePitch_) * approach(params_.eyeResponse, dt);
+
+    constexpr float kEpsilon = 1e-5f;
+    if (std::fabs(yaw_) + std::fabs(pitch_) + std::fabs(eyeYaw_) +
+            std::fabs(eyePitch_) + std::fabs(gestureYaw_) +
+            std::fabs(gesturePitch_) < kEpsilon) {
+      return;  // relaxed: animated pose untouched
+    }
+
+    // Each joint adds the part of the aim its ancestors have not yet
+    // applied, so the chain ends exactly at yaw-then-pitch
+    const float chainYaw = yaw_ + gestureYaw_;
+    const float chainPitch = pitch_ + gesturePitch_;
+    const simd::Quat head = aim(chainYaw, chainPitch);
+    const simd::Quat eye =
+        aim(yaw_ + eyeYaw_, pitch_ + eyePitch_) * simd::conjugate(head);
+    Edit edits[4];
+    int count = 0;
+    if (neck_ != kNone) {
+      const simd::Quat neck =
+          aim(chainYaw * params_.neckShare, chainPitch * params_.neckShare);
+      edits[count++] = {neck_, neck};
+      edits[count++] = {head_, head * simd::conjugate(neck)};
+    } else {
+      edits[count++] = {head_, head};
+    }
+    for (int32_t joint : eyes_) {
+      if (joint != kNone) edits[count++] = {joint, eye};
+    }
+    rotate(skeleton, edits, count);
+  }
+
+ private:
+  struct Edit {
+    int32_t joint;
+    simd::Quat delta;  // model space
+  };
+
+  static float clamp(float v, float limit) {
+    return v < -limit ? -limit : (v > limit ? limit : v);
+  }
+
+  // Frame-rate independent exponential smoothing factor
+  static float approach(float rate, float dt) {
+    return 1.0f - std::exp(-rate * dt);
+  }
+
+  // Model-space yaw (about +Y) after pitch (up positive)
+  static simd::Quat aim(float yaw, float pitch) {
+    return simd::fromAxisAngle(0.0f, 1.0f, 0.0f, yaw) *
+           simd::fromAxisAngle(1.0f, 0.0f, 0.0f, -pitch);
+  }
+
+  /**
+   * Pre-apply model-space rotations to joints (ancestors first), then
+   * refresh the world matrices of the affected range in one pass
+   * A parent's new world rotation is derived from the edits above it
+   * rather than recomputed, so each subtree is walked once.
+   */
+  static void rotate(FlatSkeleton& skeleton, const Edit* edits, int count) {
+    uint32_t begin = static_cast<uint32_t>(edits[0].joint);
+    uint32_t end = begin;
+    uint32_t ends[4];
+    int32_t cachedParent = FlatSkeleton::kNoParent;
+    simd::Quat parentRotation = simd::Quat::identity();
+    for (int i = 0; i < count; ++i) {
+      const uint32_t joint = static_cast<uint32_t>(edits[i].joint);
+      const int32_t parent = skeleton.parents()[joint];
+      ends[i] = skeleton.subtreeEnd(joint);
+      if (joint < begin) begin = joint;
+      if (ends[i] > end) end = ends[i];
+
+      BoneTransform& local = skeleton.localPose()[joint];
+      if (parent == FlatSkeleton::kNoParent) {
+        local.rotation = simd::normalize(edits[i].delta * local.rotation);
+        continue;
+      }
+      if (parent != cachedParent) {
+        cachedParent = parent;
+        parentRotation = simd::rotationOf(skeleton.world()[parent]);
+        for (int k = 0; k < i; ++k) {
+          const uint32_t p = static_cast<uint32_t>(parent);
+          if (p >= static_cast<uint32_t>(edits[k].joint) && p < ends[k]) {
+            parentRotation = edits[k].delta * parentRotation;
+          }
+        }
+      }
+      // Model-space delta expressed in the parent's frame
+      local.rotation = simd::normalize(simd::conjugate(parentRotation) *
+                                       edits[i].delta * parentRotation *
+                                       local.rotation);
+    }
+    skeleton.computeWorldRange(begin, end);
+  }
+
+  LookAtParams params_;
+  int32_t neck_{kNone};
+  int32_t head_{kNone};
+  int32_t eyes_[2]{kNone, kNone};
+  float yaw_{0.0f};
+  float pitch_{0.0f};
+  float eyeYaw_{0.0f};
+  float eyePitch_{0.0f};
+  float gestureYaw_{0.0f};
+  float gesturePitch_{0.0f};
+};
+
+}  // namespace avatar
@@ -0,0 +1,323 @@
+/**
+ * avatar-lookahead-lipsync.h - Mouth analysis ahead of the playhead
+ *
+ * The <audio> path analyses what is audible right now, then smooths it
+ * with an EMA, so the mouth always trails the voice by the analysis
+ * window plus the smoothing lag. A streamed reply is decoded before it
+ * plays, so here the mouth is analysed from the decoded PCM as soon as
+ * it arrives:
+ *
+ *   decoded PCM -> 10 ms hops -> open/round -> centred smoothing
+ *               -> timestamped frames (jitter buffer) -> sample(playhead)
+ *
+ * The smoothing kernel is symmetric, so it costs no delay; it needs
+ * kSmoothHops of future audio, which the lookahead provides. The frames
+ * are kept in a small jitter buffer keyed by stream time and sampled at
+ * the audio clock, interpolating between neighbours. If decoding falls
+ * behind the playhead the last pose is held and relaxes closed, and the
+ * underrun is counted.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "avatar-fft.h"
+
+namespace avatar {
+
+struct MouthFrame {
+  float time{0.0f};  // stream seconds, hop centre
+  float open{0.0f};
+  float round{0.0f};
+};
+
+/**
+ * Mouth frames in stream time, consumed by sampling at the playhead
+ */
+class MouthFrameBuffer {
+ public:
+  /** How fast a held pose closes once the buffer runs dry */
+  static constexpr float kUnderrunRelease = 0.08f;
+
+  void reset() {
+    frames_.clear();
+    head_ = 0;
+    ended_ = false;
+    starved_ = false;
+    underruns_ = 0;
+  }
+
+  /** Append a frame; times must increase */
+  void push(const MouthFrame& frame) { frames_.push_back(frame); }
+
+  /** No more frames: past the last one the mouth is simply closed */
+  void end() { ended_ = true; }
+
+  /**
+   * Pose at stream time t, interpolated between the frames around it.
+   * Frames before t are released, so t must not go backwards.
+   */
+  MouthFrame sample(float t) {
+    while (frames_.size() - head_ > 1 && frames_[head_ + 1].time <= t) {
+      ++head_;
+    }
+    if (head_ > 64 && head_ * 2 > frames_.size()) {
+      frames_.erase(frames_.begin(), frames_.begin() + head_);
+      head_ = 0;
+    }
+
+    MouthFrame out;
+    out.time = t;
+    if (frames_.empty()) return out;  // nothing decoded yet
+    const MouthFrame& a = frames_[head_];
+    if (t <= a.time) {
+      starved_ = false;
+      out.open = a.open;
+      out.round = a.round;
+    } else if (head_ + 1 < frames_.size()) {
+      const MouthFrame& b = frames_[head_ + 1];
+      const float u = (t - a.time) / (b.time - a.time);
+      starved_ = false;
+      out.open = a.open + (b.open - a.open) * u;
+      out.round = a.round + (b.round - a.round) * u;
+    } else if (!ended_) {
+      markStarved(true);
+      const float hold = std::exp(-(t - a.time) / kUnderrunRelease);
+      out.open = a.open * hold;
+      out.round = a.round * hold;
+    }
+    return out;
+  }
+
+  /** Buffered seconds past t */
+  float lookahead(float t) const {
+    return head_ < frames_.size() ? std::max(0.0f, frames_.back().time - t)
+                                  : 0.0f;
+  }
+
+  /** Stream time of the last frame (0 when empty) */
+  float endTime() const {
+    return frames_.empty() ? 0.0f : frames_.back().time;
+  }
+
+  size_t size() const { return frames_.size() - head_; }
+  bool ended() const { return ended_; }
+  /** Times sampling ran past the buffered frames before the end */
+  uint32_t underruns() const { return underruns_; }
+
+  size_t memoryBytes() const {
+    return frames_.capacity() * sizeof(MouthFrame);
+  }
+
+ private:
+  void markStarved(bool starved) {
+    if (starved && !starved_) ++underruns_;
+    starved_ = starved;
+  }
+
+  std::vector<MouthFrame> frames_;
+  size_t head_{0};  // frame at or before the last sample time
+  bool ended_{false};
+  bool starved_{false};
+  uint32_t underruns_{0};
+};
+
+/**
+ * Analyses decoded speech into mouth frames and plays them back on the
+ * audio clock
+ */
+class LookaheadLipSync {
+ public:
+  static constexpr float kHopSeconds = 0.01f;
+  /** Smoothing half-width; the kernel spans 2 * kSmoothHops + 1 hops */
+  static constexpr uint32_t kSmoothHops = 3;
+  /** Loudness range, below the running peak, that opens the jaw 0-1 */
+  static constexpr float kOpenRangeDb = 30.0f;
+  /** Running peak decay, so a quiet passage is not judged by a shout */
+  static constexpr float kPeakDecayDbPerHop = 0.03f;
+  static constexpr float kPeakFloorDb = -50.0f;
+  /** Mouth held open for this long after the last frame, then let go */
+  static constexpr float kReleaseSeconds = 0.1f;
+
+  /**
+   * Size the analysis for a stream; a rate change starts over
+   */
+  void configure(float sampleRate) {
+    if (sampleRate == sampleRate_) return;
+    sampleRate_ = sampleRate;
+    hop_ = std::max(1u, static_cast<uint32_t>(sampleRate * kHopSeconds));
+    uint32_t n = 64;
+    while (n < hop_ * 2) n <<= 1;
+    fft_.configure(n);
+    frame_.assign(n, 0.0f);
+    power_.assign(n / 2 + 1, 0.0f);
+    const float binHz = sampleRate / static_cast<float>(n);
+    const auto bin = [&](float hz) {
+      return std::min(n / 2, static_cast<uint32_t>(hz / binHz + 0.5f));
+    };
+    voiceLo_ = std::max(1u, bin(100.0f));
+    roundLo_ = bin(250.0f);
+    roundHi_ = bin(900.0f);
+    spreadHi_ = bin(3000.0f);
+    voiceHi_ = bin(4000.0f);
+    reset();
+  }
+
+  void reset() {
+    buffer_.reset();
+    nextHop_ = 0;
+    raws_ = 0;
+    flushed_ = false;
+    peakDb_ = kPeakFloorDb;
+    for (MouthFrame& r : ring_) r = MouthFrame{};
+    pose_ = MouthFrame{};
+    owning_ = false;
+    released_ = false;
+  }
+
+  /**
+   * Playback stopped, at the end or early. The playhead then stops
+   * short of endTime() + kReleaseSeconds, so this, not sampling, lets go
+   * of the mouth; it stays released until reset().
+   */
+  void release() {
+    released_ = true;
+    owning_ = false;
+  }
+
+  /**
+   * Analyse the decoded PCM past what has been analysed, at most maxHops
+   * hops. A hop waits until its whole window has been decoded, unless
+   * the stream is complete. Returns the hops analysed.
+   */
+  uint32_t analyse(const float* pcm, size_t count, bool complete,
+                   uint32_t maxHops) {
+    if (hop_ == 0) return 0;
+    const size_t half = fft_.size() / 2;
+    uint32_t hops = 0;
+    while (hops < maxHops) {
+      const size_t centre = nextHop_ * hop_ + hop_ / 2;
+      if (centre >= count) {
+        if (complete && !flushed_) flush();
+        break;
+      }
+      if (centre + half > count && !complete) break;
+      pushRaw(measure(pcm, count, centre));
+      ++nextHop_;
+      ++hops;
+    }
+    return hops;
+  }
+
+  /**
+   * Pose at stream time t (the playhead); also kept as pose()
+   */
+  const MouthFrame& sample(float t) {
+    pose_ = buffer_.sample(t);
+    owning_ = raws_ > 0 && !released_ &&
+              !(buffer_.ended() && t > buffer_.endTime() + kReleaseSeconds);
+    return pose_;
+  }
+
+  const MouthFrame& pose() const { return pose_; }
+  /** Whether the stream should drive the mouth (playing or about to) */
+  bool owning() const { return owning_; }
+  float lookaheadSeconds(float t) const { return buffer_.lookahead(t); }
+  const MouthFrameBuffer& buffer() const { return buffer_; }
+  uint32_t hopSamples() const { return hop_; }
+
+  size_t memoryBytes() const {
+    return fft_.memoryBytes() + buffer_.memoryBytes() +
+           (frame_.capacity() + power_.capacity()) * sizeof(float);
+  }
+
+ private:
+  static constexpr uint32_t kKernel = 2 * kSmoothHops + 1;
+
+  // Raw open/round of the window centred on sample `centre`
+  MouthFrame measure(const float* pcm, size_t count, size_t centre) {
+    const size_t n = fft_.size();
+    const ptrdiff_t start =
+        static_cast<ptrdiff_t>(centre) - static_cast<ptrdiff_t>(n / 2);
+    for (size_t i = 0; i < n; ++i) {
+      const ptrdiff_t at = start + static_cast<ptrdiff_t>(i);
+      frame_[i] = at >= 0 && static_cast<size_t>(at) < count ? pcm[at] : 0.0f;
+    }
+    fft_.powerSpectrum(frame_.data(), power_.data());
+
+    float voice = 0.0f, rounded = 0.0f, spread = 0.0f;
+    for (uint32_t k = voiceLo_; k < voiceHi_; ++k) {
+      voice += power_[k];
+      if (k >= roundLo_ && k < spreadHi_) {
+        (k < roundHi_ ? rounded : spread) += power_[k];
+      }
+    }
+    // Hann window power gain is 3/8; scale so a full-scale sine is ~0 dB
+    const float norm = 8.0f / (3.0f * static_cast<float>(n * n));
+    const float db = 10.0f * std::log10(voice * norm + 1e-10f);
+    peakDb_ = std::max({db, peakDb_ - kPeakDecayDbPerHop, kPeakFloorDb});
+
+    MouthFrame raw;
+    raw.open = std::clamp((db - (peakDb_ - kOpenRangeDb)) / kOpenRangeDb,
+                          0.0f, 1.0f);
+    // Rounded vowels keep their energy under ~900 Hz (low F2)
+    const float share = rounded / (rounded + spread + 1e-20f);
+    raw.round = raw.open * std::clamp((share - 0.6f) / 0.3f, 0.0f, 1.0f);
+    return raw;
+  }
+
+  // Ring of the last kKernel raw hops; emits the hop kSmoothHops back
+  void pushRaw(const MouthFrame& raw) {
+    static const float kWeights[kKernel] = {1, 2, 3, 4, 3, 2, 1};
+    const float kWeightSum = 16.0f;
+    ring_[raws_ % kKernel] = raw;
+    ++raws_;
+    if (raws_ <= kSmoothHops) return;
+    const size_t hop = raws_ - 1 - kSmoothHops;
+    MouthFrame out;
+    out.time = (static_cast<float>(hop * hop_) + 0.5f * hop_) / sampleRate_;
+    for (uint32_t j = 0; j < kKernel; ++j) {
+      if (raws_ + j < kKernel) continue;  // before the start: silence
+      const MouthFrame& r = ring_[(raws_ + j - kKernel) % kKernel];
+      out.open += kWeights[j] * r.open;
+      out.round += kWeights[j] * r.round;
+    }
+    out.open /= kWeightSum;
+    out.round /= kWeightSum;
+    buffer_.push(out);
+  }
+
+  // Silence past the end lets the last hops leave the kernel
+  void flush() {
+    for (uint32_t i = 0; i < kSmoothHops && raws_ > 0; ++i) {
+      pushRaw(MouthFrame{});
+    }
+    buffer_.end();
+    flushed_ = true;
+  }
+
+  float sampleRate_{0.0f};
+  uint32_t hop_{0};
+  Fft fft_;
+  std::vector<float> frame_;
+  std::vector<float> power_;
+  uint32_t voiceLo_{0}, voiceHi_{0};
+  uint32_t roundLo_{0}, roundHi_{0}, spreadHi_{0};
+
+  MouthFrameBuffer buffer_;
+  size_t nextHop_{0};
+  size_t raws_{0};
+  bool flushed_{false};
+  float peakDb_{kPeakFloorDb};
+  MouthFrame ring_[kKernel];
+  MouthFrame pose_;
+  bool owning_{false};
+  bool released_{false};
+};
+
+}  // namespace avatar
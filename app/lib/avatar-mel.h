@@ -0,0 +1,401 @@
+/**
+ * avatar-mel.h - STFT, mel filterbank, log-mel and MFCC features
+ *
+ * One feature front end for the engine and the native tools, with the
+ * conventions of librosa's defaults so features computed here match what
+ * training code expects:
+ *
+ *   frame -> periodic Hann -> |FFT|^2 -> mel filterbank (Slaney scale and
+ *   area norm, or HTK) -> 10 log10(max(mel, floor)) dB -> DCT-II (ortho)
+ *
+ * MelExtractor turns one frame into all four representations. MelStream
+ * wraps it around a HopFramer for runtime audio that arrives in chunks
+ * (causal frames, no padding). computeLogMel / computeMfcc are the batch
+ * API for whole clips, with librosa's centred framing (zero padding of
+ * half a frame at both ends) and optional top_db clamping.
+ *
+ * The filterbank is stored sparse: each band keeps only its non-zero
+ * bins, padded to a multiple of four, so both the filterbank and the DCT
+ * run as four-wide dot products.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "avatar-fft.h"
+#include "avatar-hop-framer.h"
+#include "avatar-simd.h"
+
+namespace avatar {
+
+enum class MelScale : uint8_t { kSlaney, kHtk };
+
+struct MelConfig {
+  float sampleRate{16000.0f};
+  uint32_t fftSize{512};  // power of two; also the frame length
+  uint32_t hop{160};
+  uint32_t melBands{40};
+  float fMin{0.0f};
+  float fMax{0.0f};  // 0 = Nyquist
+  uint32_t mfccCount{13};
+  MelScale scale{MelScale::kSlaney};
+  bool areaNorm{true};     // Slaney-style: each band sums to 2 / width
+  float floor{1e-10f};     // power floor before the log (librosa amin)
+};
+
+/** Hz to mel: Slaney (linear to 1 kHz, then log) or HTK */
+inline double hzToMel(double hz, MelScale scale) {
+  if (scale == MelScale::kHtk) return 2595.0 * std::log10(1.0 + hz / 700.0);
+  const double kStep = 200.0 / 3.0;
+  const double kLogStep = std::log(6.4) / 27.0;
+  return hz < 1000.0 ? hz / kStep
+                     : 15.0 + std::log(hz / 1000.0) / kLogStep;
+}
+
+inline double melToHz(double mel, MelScale scale) {
+  if (scale == MelScale::kHtk) {
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+  }
+  const double kStep = 200.0 / 3.0;
+  const double kLogStep = std::log(6.4) / 27.0;
+  return mel < 15.0 ? mel * kStep
+                    : 1000.0 * std::exp(kLogStep * (mel - 15.0));
+}
+
+/**
+ * Triangular mel filters over the bins of a power spectrum
+ */
+class MelFilterbank {
+ public:
+  void configure(const MelConfig& config) {
+    const uint32_t bins = config.fftSize / 2 + 1;
+    const double fMax =
+        config.fMax > 0.0f ? config.fMax : config.sampleRate / 2.0;
+    const double lo = hzToMel(config.fMin, config.scale);
+    const double hi = hzToMel(fMax, config.scale);
+    const uint32_t bands = config.melBands;
+    std::vector<double> edges(bands + 2);
+    for (uint32_t m = 0; m < bands + 2; ++m) {
+      edges[m] = melToHz(lo + (hi - lo) * m / (bands + 1), config.scale);
+    }
+
+    bins_ = bins;
+    start_.assign(bands, 0);
+    length_.assign(bands, 0);
+    offset_.assign(bands, 0);
+    weights_.clear();
+    for (uint32_t m = 0; m < bands; ++m) {
+      const double left = edges[m], centre = edges[m + 1],
+                   right = edges[m + 2];
+      const double norm = config.areaNorm ? 2.0 / (right - left) : 1.0;
+      std::vector<double> w(bins, 0.0);
+      uint32_t first = bins, last = 0;
+      for (uint32_t k = 0; k < bins; ++k) {
+        const double hz = static_cast<double>(k) * config.sampleRate /
+                          config.fftSize;
+        const double up = (hz - left) / (centre - left);
+        const double down = (right - hz) / (right - centre);
+        w[k] = std::max(0.0, std::min(up, down)) * norm;
+        if (w[k] > 0.0) {
+          first = std::min(first, k);
+          last = k;
+        }
+      }
+      if (first > last) {  // narrower than a bin: stays all zero
+        first = 0;
+        last = 0;
+      }
+      // Pad to whole registers, without reading past the spectrum
+      uint32_t length = ((last - first + 1) + 3) & ~3u;
+      if (first + length > paddedBins()) first = paddedBins() - length;
+      start_[m] = first;
+      length_[m] = length;
+      offset_[m] = static_cast<uint32_t>(weights_.size());
+      for (uint32_t k = 0; k < length; ++k) {
+        weights_.push_back(
+            first + k < bins ? static_cast<float>(w[first + k]) : 0.0f);
+      }
+    }
+  }
+
+  uint32_t bands() const { return static_cast<uint32_t>(start_.size()); }
+  /** Spectrum length apply() reads: bins rounded up to a register */
+  uint32_t paddedBins() const { return (bins_ + 3) & ~3u; }
+
+  /**
+   * mel[m] = sum_k weight[m][k] * power[k]; power must hold paddedBins()
+   * values (the tail zero)
+   */
+  void apply(const float* power, float* mel) const {
+    for (uint32_t m = 0; m < bands(); ++m) {
+      const float* w = weights_.data() + offset_[m];
+      const float* p = power + start_[m];
+      simd::f32x4 acc = simd::splat(0.0f);
+      for (uint32_t k = 0; k < length_[m]; k += 4) {
+        acc = simd::madd(simd::load(w + k), simd::load(p + k), acc);
+      }
+      mel[m] = simd::lane<0>(simd::hsum(acc));
+    }
+  }
+
+  /** Weight of band m at bin k (0 outside the band) */
+  float weight(uint32_t m, uint32_t k) const {
+    if (k < start_[m] || k >= start_[m] + length_[m]) return 0.0f;
+    return weights_[offset_[m] + k - start_[m]];
+  }
+
+  size_t memoryBytes() const {
+    return weights_.capacity() * sizeof(float) +
+           (start_.capacity() + length_.capacity() + offset_.capacity()) *
+               sizeof(uint32_t);
+  }
+
+ private:
+  uint32_t bins_{0};
+  std::vector<uint32_t> start_, length_, offset_;
+  std::vector<float> weights_;
+};
+
+/**
+ * Orthonormal DCT-II, as scipy.fft.dct(type=2, norm="ortho")
+ */
+class OrthoDct {
+ public:
+  void configure(uint32_t inputs, uint32_t outputs) {
+    inputs_ = inputs;
+    stride_ = (inputs + 3) & ~3u;
+    outputs_ = outputs;
+    basis_.assign(static_cast<size_t>(outputs) * stride_, 0.0f);
+    const double kPi = 3.141592653589793;
+    for (uint32_t k = 0; k < outputs; ++k) {
+      const double scale = std::sqrt((k == 0 ? 1.0 : 2.0) / inputs);
+      for (uint32_t n = 0; n < inputs; ++n) {
+        basis_[k * stride_ + n] = static_cast<float>(
+            scale * std::cos(kPi * k * (2.0 * n + 1.0) / (2.0 * inputs)));
+      }
+    }
+  }
+
+  /** Input must hold stride() values, the tail zero */
+  void apply(const float* in, float* out) const {
+    for (uint32_t k = 0; k < outputs_; ++k) {
+      const float* b = basis_.data() + static_cast<size_t>(k) * stride_;
+      simd::f32x4 acc = simd::splat(0.0f);
+      for (uint32_t n = 0; n < stride_; n += 4) {
+        acc = simd::madd(simd::load(b + n), simd::load(in + n), acc);
+      }
+      out[k] = simd::lane<0>(simd::hsum(acc));
+    }
+  }
+
+  uint32_t stride() const { return stride_; }
+  size_t memoryBytes() const { return basis_.capacity() * sizeof(float); }
+
+ private:
+  uint32_t inputs_{0}, outputs_{0}, stride_{0};
+  std::vector<float> basis_;
+};
+
+/**
+ * All features of one frame
+ */
+class MelExtractor {
+ public:
+  void configure(const MelConfig& config) {
+    config_ = config;
+    fft_.configure(config.fftSize);
+    filterbank_.configure(config);
+    dct_.configure(config.melBands, config.mfccCount);
+    power_.assign(filterbank_.paddedBins(), 0.0f);
+    mel_.assign(config.melBands, 0.0f);
+    logMel_.assign(dct_.stride(), 0.0f);
+    mfcc_.assign(config.mfccCount, 0.0f);
+  }
+
+  const MelConfig& config() const { return config_; }
+
+  /**
+   * Analyse fftSize samples; mfcc() is only filled when withMfcc is set
+   */
+  void analyse(const float* frame, bool withMfcc = true) {
+    fft_.powerSpectrum(frame, power_.data());
+    filterbank_.apply(power_.data(), mel_.data());
+    const float floor = config_.floor;
+    for (uint32_t m = 0; m < config_.melBands; ++m) {
+      logMel_[m] = 10.0f * std::log10(std::max(mel_[m], floor));
+    }
+    if (withMfcc) dct_.apply(logMel_.data(), mfcc_.data());
+  }
+
+  /** |X(k)|^2 for k = 0..fftSize/2 */
+  const float* power() const { return power_.data(); }
+  const float* mel() const { return mel_.data(); }
+  /** dB (10 log10 power, unclamped) */
+  const float* logMel() const { return logMel_.data(); }
+  const float* mfcc() const { return mfcc_.data(); }
+
+  const MelFilterbank& filterbank() const { return filterbank_; }
+  const OrthoDct& dct() const { return dct_; }
+
+  size_t memoryBytes() const {
+    return fft_.memoryBytes() + filterbank_.memoryBytes() +
+           dct_.memoryBytes() +
+           (power_.capacity() + mel_.capacity() + logMel_.capacity() +
+            mfcc_.capacity()) *
+               sizeof(float);
+  }
+
+ private:
+  MelConfig config_;
+  Fft fft_;
+  MelFilterbank filterbank_;
+  OrthoDct dct_;
+  std::vector<float> power_;
+  std::vector<float> mel_;
+  std::vector<float> logMel_;  // padded to the DCT stride
+  std::vector<float> mfcc_;
+};
+
+/**
+ * Runtime features: frames of audio pushed in arbitrary chunks, one
+ * callback per hop once a whole frame is buffered
+ */
+class MelStream {
+ public:
+  void configure(const MelConfig& config, uint32_t maxHops = 64) {
+    extractor_.configure(config);
+    framer_.configure(1, config.fftSize, config.hop, maxHops);
+    frames_ = 0;
+  }
+
+  void reset() {
+    framer_.reset();
+    frames_ = 0;
+  }
+
+  /**
+   * Calls onFrame(const MelExtractor&) per completed hop, oldest first;
+   * a push backlog beyond maxHops is skipped (see HopFramer)
+   */
+  template <typename OnFrame>
+  void push(const float* samples, uint32_t count, OnFrame&& onFrame,
+            bool withMfcc = true) {
+    framer_.push(samples, count, [&](const float* frame) {
+      extractor_.analyse(frame, withMfcc);
+      ++frames_;
+      onFrame(static_cast<const MelExtractor&>(extractor_));
+    });
+  }
+
+  const MelExtractor& extractor() const { return extractor_; }
+  uint64_t frames() const { return frames_; }
+  uint64_t dropped() const { return framer_.dropped(); }
+
+ private:
+  MelExtractor extractor_;
+  HopFramer framer_;
+  uint64_t frames_{0};
+};
+
+/**
+ * Row-major frames x columns feature matrix
+ */
+struct FeatureMatrix {
+  uint32_t frames{0};
+  uint32_t columns{0};
+  std::vector<float> data;
+
+  const float* row(uint32_t i) const {
+    return data.data() + static_cast<size_t>(i) * columns;
+  }
+};
+
+namespace detail {
+
+// librosa framing: centred frames pad fftSize/2 zeros at both ends
+template <typename Emit>
+inline void forEachFrame(const float* x, size_t count,
+                         const MelConfig& config, bool centre,
+                         MelExtractor& extractor, bool withMfcc,
+                         Emit&& emit) {
+  const size_t n = config.fftSize;
+  const size_t pad = centre ? n / 2 : 0;
+  const size_t total = count + 2 * pad;
+  if (total < n) return;
+  const size_t frames = 1 + (total - n) / config.hop;
+  std::vector<float> frame(n);
+  for (size_t f = 0; f < frames; ++f) {
+    const size_t start = f * config.hop;  // in padded coordinates
+    const float* src = nullptr;
+    if (start >= pad && start - pad + n <= count) {
+      src = x + (start - pad);  // wholly inside: no copy
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        const size_t at = start + i;
+        frame[i] = at >= pad && at - pad < count ? x[at - pad] : 0.0f;
+      }
+      src = frame.data();
+    }
+    extractor.analyse(src, withMfcc);
+    emit(f, frames);
+  }
+}
+
+inline void clampTopDb(FeatureMatrix& out, float topDb) {
+  if (topDb <= 0.0f || out.data.empty()) return;
+  const float peak = *std::max_element(out.data.begin(), out.data.end());
+  for (float& v : out.data) v = std::max(v, peak - topDb);
+}
+
+}  // namespace detail
+
+/**
+ * Log-mel spectrogram (dB) of a whole clip. topDb > 0 clamps to that
+ * far below the clip's peak, as librosa.power_to_db(top_db=...).
+ */
+inline void computeLogMel(const float* x, size_t count,
+                          const MelConfig& config, FeatureMatrix& out,
+                          bool centre = true, float topDb = 0.0f) {
+  MelExtractor extractor;
+  extractor.configure(config);
+  out.columns = config.melBands;
+  out.frames = 0;
+  out.data.clear();
+  detail::forEachFrame(x, count, config, centre, extractor, false,
+                       [&](size_t, size_t frames) {
+                         if (out.data.empty()) {
+                           out.data.reserve(frames * out.columns);
+                         }
+                         out.data.insert(out.data.end(), extractor.logMel(),
+                                         extractor.logMel() + out.columns);
+                         ++out.frames;
+                       });
+  detail::clampTopDb(out, topDb);
+}
+
+/**
+ * MFCCs of a whole clip (librosa.feature.mfcc with the same top_db)
+ */
+inline void computeMfcc(const float* x, size_t count,
+                        const MelConfig& config, FeatureMatrix& out,
+                        bool centre = true, float topDb = 80.0f) {
+  FeatureMatrix logMel;
+  computeLogMel(x, count, config, logMel, centre, topDb);
+  OrthoDct dct;
+  dct.configure(config.melBands, config.mfccCount);
+  std::vector<float> padded(dct.stride(), 0.0f);
+  out.columns = config.mfccCount;
+  out.frames = logMel.frames;
+  out.data.assign(static_cast<size_t>(out.frames) * out.columns, 0.0f);
+  for (uint32_t f = 0; f < logMel.frames; ++f) {
+    std::copy(logMel.row(f), logMel.row(f) + logMel.columns, padded.begin());
+    dct.apply(padded.data(),
+              out.data.data() + static_cast<size_t>(f) * out.columns);
+  }
+}
+
+}  // namespace avatar
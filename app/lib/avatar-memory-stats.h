@@ -0,0 +1,40 @@
+/**
+ * avatar-memory-stats.h - Engine memory by category
+ *
+ * Collected on demand (getMemoryStats export, perf HUD, soak harness)
+ * rather than every frame, since walking the allocator isn't free.
+ * Read from JavaScript as a Uint32Array of kMemoryCategoryCount bytes
+ * values, so keep categories append-only.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace avatar {
+
+enum MemoryCategory : int {
+  kMemHeap = 0,    // all malloc'd bytes in use (includes the rest)
+  kMemGeometry,    // vertex/index/morph buffers owned by the model
+  kMemTextures,    // texture storage owned by the model
+  kMemAnimation,   // clips, pose buffers and skeleton data
+  kMemEngine,      // fixed engine tables: log ring, histograms, HUD
+  kMemoryCategoryCount
+};
+
+struct MemoryStats {
+  uint32_t bytes[kMemoryCategoryCount]{};
+};
+
+inline const char* memoryCategoryName(int category) {
+  switch (category) {
+    case kMemHeap: return "HEAP";
+    case kMemGeometry: return "GEO";
+    case kMemTextures: return "TEX";
+    case kMemAnimation: return "ANIM";
+    case kMemEngine: return "ENG";
+    default: return "?";
+  }
+}
+
+}  // namespace avatar
@@ -0,0 +1,86 @@
+/**
+ * avatar-pcm-ring.h - Single-producer PCM ring shared with JavaScript
+ *
+ * JS (the microphone feed) writes mono float samples straight into
+ * engine-owned memory through typed views and advances writeIndex. The
+ * engine consumes them once per frame and advances readIndex. Indices
+ * count samples since the start and wrap at 2^32. The capacity is a power
+ * of two, so a position maps to a slot with a mask and the difference of
+ * two indices is the fill level even across the wrap. A writer that laps
+ * the reader overwrites the oldest samples. The reader then skips ahead
+ * and counts the loss in overruns, so the writer never has to wait.
+ *
+ * The header fields are 4 bytes wide like the state and control blocks
+ * (index = byte offset / 4); samples start at index kHeaderWords.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace avatar {
+
+struct PcmRing {
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kCapacity = 8192;  // ~170 ms at 48 kHz
+  static constexpr uint32_t kHeaderWords = 8;
+
+  uint32_t version{kVersion};     // [0]
+  uint32_t capacity{kCapacity};   // [1] samples, power of two
+  uint32_t writeIndex{0};         // [2] samples written (JS)
+  uint32_t readIndex{0};          // [3] samples consumed (engine)
+  float sampleRate{0.0f};         // [4] Hz, set by the writer
+  uint32_t overruns{0};           // [5] samples lost to a lapping writer
+  uint32_t reserved[2]{};         // [6..7]
+  float samples[kCapacity]{};     // [8..]
+
+  uint32_t available() const { return writeIndex - readIndex; }
+
+  /**
+   * Writer side (native tools; JS does the same through its views)
+   */
+  void write(const float* data, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+      samples[(writeIndex + i) & (kCapacity - 1)] = data[i];
+    }
+    writeIndex += count;
+  }
+
+  /**
+   * Consume up to maxCount of the newest samples as at most two
+   * contiguous spans, calling fn(const float* data, uint32_t count) on
+   * each; anything older is skipped. Returns the number consumed.
+   */
+  template <typename Fn>
+  uint32_t consume(uint32_t maxCount, Fn&& fn) {
+    uint32_t count = available();
+    if (count > kCapacity) {
+      overruns += count - kCapacity;
+      readIndex = writeIndex - kCapacity;
+      count = kCapacity;
+    }
+    if (count > maxCount) {
+      readIndex += count - maxCount;
+      count = maxCount;
+    }
+    const uint32_t start = readIndex & (kCapacity - 1);
+    const uint32_t first = count < kCapacity - start ? count : kCapacity - start;
+    if (first > 0) fn(samples + start, first);
+    if (count > first) fn(samples, count - first);
+    readIndex += count;
+    return count;
+  }
+
+  void reset() {
+    writeIndex = readIndex = overruns = 0;
+    sampleRate = 0.0f;
+  }
+};
+
+static_assert(offsetof(PcmRing, samples) == PcmRing::kHeaderWords * 4,
+              "PcmRing layout is mirrored in avatarController.ts");
+static_assert((PcmRing::kCapacity & (PcmRing::kCapacity - 1)) == 0,
+              "PcmRing capacity must be a power of two");
+
+}  // namespace avatar
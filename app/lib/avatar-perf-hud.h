@@ -0,0 +1,267 @@
+/**
+ * avatar-perf-hud.h - Immediate-mode performance overlay
+ *
+ * Builds one batch of textured quads per frame: a frame-time graph,
+ * per-phase bars, counters and memory categories. Text uses a 3x5 pixel
+ * font packed into a tiny single-channel atlas whose first cell is solid,
+ * so rectangles and glyphs share one texture and one draw call.
+ *
+ * When disabled the engine only tests `enabled()`; the atlas and vertex
+ * storage are created on first enable.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "avatar-frame-counters.h"
+#include "avatar-frame-histogram.h"
+#include "avatar-memory-stats.h"
+
+namespace avatar {
+
+struct HudVertex {
+  float x, y;     // normalized device coordinates
+  float u, v;     // atlas coordinates
+  uint32_t rgba;  // unorm8x4, bytes R, G, B, A in memory
+};
+
+class PerfHud {
+ public:
+  static constexpr int kGlyphWidth = 3;
+  static constexpr int kGlyphHeight = 5;
+  static constexpr int kCellWidth = kGlyphWidth + 1;
+  static constexpr int kCellHeight = kGlyphHeight + 1;
+  static constexpr int kScale = 2;  // screen pixels per font pixel
+  static constexpr int kHistoryLength = 120;
+
+  static constexpr uint32_t color(uint32_t r, uint32_t g, uint32_t b,
+                                  uint32_t a = 255) {
+    return r | (g << 8) | (b << 16) | (a << 24);
+  }
+
+  bool enabled() const { return enabled_; }
+
+  void setEnabled(bool enabled) {
+    enabled_ = enabled;
+    if (enabled_ && atlas_.empty()) {
+      buildAtlas();
+      vertices_.reserve(4096);
+    }
+    historyCount_ = 0;
+  }
+
+  /**
+   * Record the last frame's timings; call only when enabled
+   */
+  void pushFrame(float intervalMs, const float* phaseMs) {
+    history_[historyHead_] = intervalMs;
+    historyHead_ = (historyHead_ + 1) % kHistoryLength;
+    if (historyCount_ < kHistoryLength) ++historyCount_;
+    for (int i = 0; i < kFramePhaseCount; ++i) phaseMs_[i] = phaseMs[i];
+  }
+
+  /**
+   * Rebuild the vertex batch for the current frame
+   */
+  void build(int canvasWidth, int canvasHeight, float p99Ms,
+             const FrameCounters& counters, const MemoryStats& memory) {
+    vertices_.clear();
+    invWidth_ = 2.0f / static_cast<float>(canvasWidth > 0 ? canvasWidth : 1);
+    invHeight_ =
+        2.0f / static_cast<float>(canvasHeight > 0 ? canvasHeight : 1);
+
+    const float left = 8.0f;
+    const float top = 8.0f;
+    const float width = kHistoryLength * 2.0f + 16.0f;
+    const float lineHeight = kCellHeight * kScale + 2.0f;
+    const float graphTop = top + 8.0f;
+    const float graphHeight = 60.0f;
+    const float graphBottom = graphTop + graphHeight;
+
+    // Frame line, phase bars, two counter lines, memory two per line
+    const int lines = 1 + 4 + 2 + (kMemoryCategoryCount + 1) / 2;
+    const float height = graphBottom + 6.0f + lines * lineHeight + 6.0f - top;
+    rect(left, top, width, height, color(0, 0, 0, 176));
+
+    // Frame-time graph: 2px bars, 2px per ms, 16.7ms reference line
+    for (int i = 0; i < historyCount_; ++i) {
+      const int index =
+          (historyHead_ - historyCount_ + i + kHistoryLength) % kHistoryLength;
+      const float ms = history_[index];
+      float h = ms * 2.0f;
+      if (h > graphHeight) h = graphHeight;
+      rect(left + 8.0f + i * 2.0f, graphBottom - h, 2.0f, h, frameColor(ms));
+    }
+    rect(left + 8.0f, graphBottom - 16.7f * 2.0f, kHistoryLength * 2.0f, 1.0f,
+         color(255, 255, 255, 128));
+
+    float y = graphBottom + 6.0f;
+    char line[64];
+
+    const float lastMs =
+        historyCount_ ? history_[(historyHead_ + kHistoryLength - 1) %
+                                 kHistoryLength]
+                      : 0.0f;
+    std::snprintf(line, sizeof(line), "FRAME %.1fMS P99 %.1fMS", lastMs,
+                  p99Ms);
+    text(left + 8.0f, y, line, color(255, 255, 255));
+    y += lineHeight;
+
+    // Per-phase bars: 8px per ms
+    static const char* const kPhaseLabels[] = {"ANIM", "SCENE", "RENDER",
+                                               "PRESENT"};
+    static const uint32_t kPhaseColors[] = {
+        color(79, 195, 247), color(129, 199, 132), color(255, 183, 77),
+        color(229, 115, 115)};
+    for (int i = 0; i < 4; ++i) {
+      const float ms = phaseMs_[kPhaseAnimation + i];
+      text(left + 8.0f, y, kPhaseLabels[i], color(255, 255, 255));
+      float barWidth = ms * 8.0f;
+      if (barWidth > width - 80.0f) barWidth = width - 80.0f;
+      rect(left + 72.0f, y, barWidth < 1.0f ? 1.0f : barWidth,
+           kGlyphHeight * kScale, kPhaseColors[i]);
+      y += lineHeight;
+    }
+
+    std::snprintf(line, sizeof(line), "DRAW %u TRI %u BONE %u",
+                  counters.drawCalls, counters.triangles,
+                  counters.bonesEvaluated);
+    text(left + 8.0f, y, line, color(255, 255, 255));
+    y += lineHeight;
+
+    std::snprintf(line, sizeof(line), "MORPH %u UPLOAD %uB CULL %u",
+                  counters.activeMorphs, counters.bytesUploaded,
+                  counters.culledPrimitives);
+    text(left + 8.0f, y, line, color(255, 255, 255));
+    y += lineHeight;
+
+    // Memory categories, two per line, in MB
+    for (int i = 0; i < kMemoryCategoryCount; i += 2) {
+      int n = std::snprintf(line, sizeof(line), "%s %.1fM",
+                            memoryCategoryName(i),
+                            memory.bytes[i] / 1048576.0f);
+      if (i + 1 < kMemoryCategoryCount && n > 0) {
+        std::snprintf(line + n, sizeof(line) - n, " %s %.1fM",
+                      memoryCategoryName(i + 1),
+                      memory.bytes[i + 1] / 1048576.0f);
+      }
+      text(left + 8.0f, y, line, color(176, 190, 197));
+      y += lineHeight;
+    }
+  }
+
+  const std::vector<HudVertex>& vertices() const { return vertices_; }
+  const std::vector<uint8_t>& atlasPixels() const { return atlas_; }
+  int atlasWidth() const { return kGlyphCount * kCellWidth; }
+  int atlasHeight() const { return kCellHeight; }
+
+  size_t memoryBytes() const {
+    return atlas_.capacity() + vertices_.capacity() * sizeof(HudVertex) +
+           sizeof(*this);
+  }
+
+ private:
+  // Cell 0 is solid (used for rectangles); glyphs follow in kGlyphChars order
+  static constexpr const char* kGlyphChars =
+      " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/%-";
+  static constexpr int kGlyphCount = 43;  // solid cell + 42 characters
+
+  static const uint8_t* glyphRows(int glyph) {
+    // 3-bit rows, top to bottom, MSB = left column
+    static const uint8_t kFont[42][kGlyphHeight] = {
+        {0, 0, 0, 0, 0}, {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7},
+        {7, 1, 3, 1, 7}, {5, 5, 7, 1, 1}, {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7},
+        {7, 1, 1, 1, 1}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7}, {2, 5, 7, 5, 5},
+        {6, 5, 6, 5, 6}, {3, 4, 4, 4, 3}, {6, 5, 5, 5, 6}, {7, 4, 6, 4, 7},
+        {7, 4, 6, 4, 4}, {3, 4, 5, 5, 3}, {5, 5, 7, 5, 5}, {7, 2, 2, 2, 7},
+        {1, 1, 1, 5, 2}, {5, 5, 6, 5, 5}, {4, 4, 4, 4, 7}, {5, 7, 7, 5, 5},
+        {6, 5, 5, 5, 5}, {2, 5, 5, 5, 2}, {6, 5, 6, 4, 4}, {2, 5, 5, 6, 3},
+        {6, 5, 6, 5, 5}, {3, 4, 2, 1, 6}, {7, 2, 2, 2, 2}, {5, 5, 5, 5, 7},
+        {5, 5, 5, 5, 2}, {5, 5, 7, 7, 5}, {5, 5, 2, 5, 5}, {5, 5, 2, 2, 2},
+        {7, 1, 2, 4, 7}, {0, 0, 0, 0, 2}, {0, 2, 0, 2, 0}, {1, 1, 2, 4, 4},
+        {5, 1, 2, 4, 5}, {0, 0, 7, 0, 0}};
+    return kFont[glyph];
+  }
+
+  static int glyphIndex(char c) {
+    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+    for (int i = 0; kGlyphChars[i]; ++i) {
+      if (kGlyphChars[i] == c) return i + 1;
+    }
+    return 1;  // space
+  }
+
+  void buildAtlas() {
+    const int w = atlasWidth();
+    atlas_.assign(static_cast<size_t>(w * kCellHeight), 0);
+    for (int y = 0; y < kCellHeight; ++y) {
+      for (int x = 0; x < kCellWidth; ++x) atlas_[y * w + x] = 255;
+    }
+    for (int g = 1; g < kGlyphCount; ++g) {
+      const uint8_t* rows = glyphRows(g - 1);
+      for (int y = 0; y < kGlyphHeight; ++y) {
+        for (int x = 0; x < kGlyphWidth; ++x) {
+          if (rows[y] & (4 >> x)) {
+            atlas_[y * w + g * kCellWidth + x] = 255;
+          }
+        }
+      }
+    }
+  }
+
+  static uint32_t frameColor(float ms) {
+    if (ms <= 16.7f) return color(102, 187, 106);
+    if (ms <= 33.3f) return color(255, 202, 40);
+    return color(239, 83, 80);
+  }
+
+  void quad(float x, float y, float w, float h, float u0, float v0, float u1,
+            float v1, uint32_t rgba) {
+    const float x0 = x * invWidth_ - 1.0f;
+    const float x1 = (x + w) * invWidth_ - 1.0f;
+    const float y0 = 1.0f - y * invHeight_;
+    const float y1 = 1.0f - (y + h) * invHeight_;
+    vertices_.push_back({x0, y0, u0, v0, rgba});
+    vertices_.push_back({x1, y0, u1, v0, rgba});
+    vertices_.push_back({x1, y1, u1, v1, rgba});
+    vertices_.push_back({x0, y0, u0, v0, rgba});
+    vertices_.push_back({x1, y1, u1, v1, rgba});
+    vertices_.push_back({x0, y1, u0, v1, rgba});
+  }
+
+  void rect(float x, float y, float w, float h, uint32_t rgba) {
+    // Sample the centre of the solid cell
+    const float u = 1.5f / atlasWidth();
+    const float v = 1.5f / atlasHeight();
+    quad(x, y, w, h, u, v, u, v, rgba);
+  }
+
+  void text(float x, float y, const char* str, uint32_t rgba) {
+    const float du = 1.0f / atlasWidth();
+    const float dv = 1.0f / atlasHeight();
+    for (; *str; ++str) {
+      if (*str != ' ') {
+        const int g = glyphIndex(*str);
+        quad(x, y, kGlyphWidth * kScale, kGlyphHeight * kScale,
+             g * kCellWidth * du, 0.0f, (g * kCellWidth + kGlyphWidth) * du,
+             kGlyphHeight * dv, rgba);
+      }
+      x += kCellWidth * kScale;
+    }
+  }
+
+  bool enabled_{false};
+  std::vector<uint8_t> atlas_;
+  std::vector<HudVertex> vertices_;
+  float history_[kHistoryLength]{};
+  int historyHead_{0};
+  int historyCount_{0};
+  float phaseMs_[kFramePhaseCount]{};
+  float invWidth_{0.0f};
+  float invHeight_{0.0f};
+};
+
+}  // namespace avatar
@@ -0,0 +1,50 @@
+/**
+ * avatar-platform.h - Emscripten / native portability shims
+ *
+ * The avatar scene is built with Emscripten for the browser, but the native
+ * harnesses in native/ compile the same translation unit against the
+ * desktop LIT-LAND backend. This header supplies the few Emscripten
+ * symbols the scene uses when building natively, plus a portable view of
+ * the allocator's in-use bytes.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(__EMSCRIPTEN__) || defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#else
+#include <chrono>
+
+#ifndef EMSCRIPTEN_KEEPALIVE
+#define EMSCRIPTEN_KEEPALIVE
+#endif
+
+inline double emscripten_get_now() {
+  using namespace std::chrono;
+  return duration<double, std::milli>(steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+namespace avatar {
+
+/**
+ * Bytes currently allocated through malloc (0 where unsupported)
+ */
+inline size_t heapBytesInUse() {
+#if defined(__EMSCRIPTEN__)
+  return static_cast<size_t>(mallinfo().uordblks);
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace avatar
@@ -0,0 +1,293 @@
+/**
+ * avatar-pose-layers.h - Layered pose blending over SoA pose buffers
+ *
+ * A base pose (e.g. full-body idle) plus any number of override and
+ * additive layers, each with a weight and an optional bone mask (e.g.
+ * face-only talking, head-only listening tilt). All layers are applied
+ * in one fused pass: each block of four joints is loaded once, run
+ * through every layer in registers, and stored once. Blocks no active
+ * layer touches are copied from the base, and a base with no active
+ * layers is copied whole.
+ *
+ * Pose buffers are structure-of-arrays, one stream per component, in
+ * flat skeleton order. Streams are padded to a multiple of four joints.
+ * Padding lanes hold the identity, so they stay well-formed through
+ * normalisation.
+ *
+ *   override: pose = blend(pose, layer, w)
+ *   additive: pose = pose (+) w * (layer - reference)
+ *
+ * Translation and scale are lerped and rotations are nlerped along the
+ * shorter arc. w is layer.weight * mask[joint].
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "avatar-simd.h"
+#include "avatar-skeleton.h"
+
+namespace avatar {
+
+enum PoseStream : int {
+  kPoseTx = 0, kPoseTy, kPoseTz,
+  kPoseRx, kPoseRy, kPoseRz, kPoseRw,
+  kPoseSx, kPoseSy, kPoseSz,
+  kPoseStreamCount
+};
+
+class PoseBuffer {
+ public:
+  void resize(size_t joints) {
+    joints_ = joints;
+    stride_ = (joints + 3) & ~static_cast<size_t>(3);
+    data_.assign(stride_ * kPoseStreamCount, 0.0f);
+    setIdentity();
+  }
+
+  size_t size() const { return joints_; }
+  size_t stride() const { return stride_; }
+  float* stream(int s) { return data_.data() + s * stride_; }
+  const float* stream(int s) const { return data_.data() + s * stride_; }
+
+  void setIdentity() {
+    for (int s = 0; s < kPoseStreamCount; ++s) {
+      const float value =
+          (s == kPoseRw || s >= kPoseSx) ? 1.0f : 0.0f;
+      float* out = stream(s);
+      for (size_t j = 0; j < stride_; ++j) out[j] = value;
+    }
+  }
+
+  void setJoint(size_t joint, const float* t, const float* q,
+                const float* s) {
+    for (int k = 0; k < 3; ++k) stream(kPoseTx + k)[joint] = t[k];
+    for (int k = 0; k < 4; ++k) stream(kPoseRx + k)[joint] = q[k];
+    for (int k = 0; k < 3; ++k) stream(kPoseSx + k)[joint] = s[k];
+  }
+
+  /**
+   * Transpose to BoneTransforms (flat order) for the skeleton passes
+   */
+  void toTransforms(BoneTransform* out) const {
+    for (size_t j = 0; j < joints_; ++j) {
+      out[j].translation = simd::Vec4::make(stream(kPoseTx)[j],
+                                            stream(kPoseTy)[j],
+                                            stream(kPoseTz)[j], 0.0f);
+      out[j].rotation = simd::Quat::make(stream(kPoseRx)[j],
+                                         stream(kPoseRy)[j],
+                                         stream(kPoseRz)[j],
+                                         stream(kPoseRw)[j]);
+      out[j].scale = simd::Vec4::make(stream(kPoseSx)[j], stream(kPoseSy)[j],
+                                      stream(kPoseSz)[j], 0.0f);
+    }
+  }
+
+  size_t memoryBytes() const { return data_.capacity() * sizeof(float); }
+
+ private:
+  std::vector<float> data_;
+  size_t joints_{0};
+  size_t stride_{0};
+};
+
+/**
+ * Per-joint layer weights plus the joint range they cover
+ * Pre-order subtrees are contiguous, so the blend skips whole blocks
+ * outside [begin, end).
+ */
+struct BoneMask {
+  std::vector<float> weights;  // padded to the pose stride, 0 outside
+  uint32_t begin{0};
+  uint32_t end{0};
+
+  static BoneMask subtree(const FlatSkeleton& skeleton, uint32_t flatRoot,
+                          float weight = 1.0f) {
+    BoneMask mask;
+    const size_t stride = (skeleton.size() + 3) & ~static_cast<size_t>(3);
+    mask.weights.assign(stride, 0.0f);
+    mask.begin = flatRoot;
+    mask.end = skeleton.subtreeEnd(flatRoot);
+    for (uint32_t j = mask.begin; j < mask.end; ++j) mask.weights[j] = weight;
+    return mask;
+  }
+};
+
+enum LayerMode : int { kLayerOverride = 0, kLayerAdditive };
+
+struct PoseLayer {
+  LayerMode mode{kLayerOverride};
+  float weight{0.0f};
+  const PoseBuffer* pose{nullptr};
+  const PoseBuffer* reference{nullptr};  // additive: pose the clip is relative to
+  const BoneMask* mask{nullptr};         // nullptr = every joint
+};
+
+namespace detail {
+
+using simd::f32x4;
+
+struct QuatX4 {
+  f32x4 x, y, z, w;
+};
+
+inline QuatX4 loadQuat(const PoseBuffer& p, size_t j) {
+  return {simd::load(p.stream(kPoseRx) + j), simd::load(p.stream(kPoseRy) + j),
+          simd::load(p.stream(kPoseRz) + j), simd::load(p.stream(kPoseRw) + j)};
+}
+
+inline QuatX4 normalize(const QuatX4& q) {
+  f32x4 len2 = simd::mul(q.x, q.x);
+  len2 = simd::madd(q.y, q.y, len2);
+  len2 = simd::madd(q.z, q.z, len2);
+  len2 = simd::madd(q.w, q.w, len2);
+  const f32x4 inv = simd::div(simd::splat(1.0f), simd::sqrt(len2));
+  return {simd::mul(q.x, inv), simd::mul(q.y, inv), simd::mul(q.z, inv),
+          simd::mul(q.w, inv)};
+}
+
+/**
+ * Four nlerps at once along the shorter arc
+ */
+inline QuatX4 nlerp(const QuatX4& a, QuatX4 b, f32x4 t) {
+  f32x4 d = simd::mul(a.x, b.x);
+  d = simd::madd(a.y, b.y, d);
+  d = simd::madd(a.z, b.z, d);
+  d = simd::madd(a.w, b.w, d);
+  const f32x4 flip = simd::less(d, simd::splat(0.0f));
+  const f32x4 minusOne = simd::splat(-1.0f);
+  b.x = simd::select(flip, simd::mul(b.x, minusOne), b.x);
+  b.y = simd::select(flip, simd::mul(b.y, minusOne), b.y);
+  b.z = simd::select(flip, simd::mul(b.z, minusOne), b.z);
+  b.w = simd::select(flip, simd::mul(b.w, minusOne), b.w);
+  return normalize({simd::madd(simd::sub(b.x, a.x), t, a.x),
+                    simd::madd(simd::sub(b.y, a.y), t, a.y),
+                    simd::madd(simd::sub(b.z, a.z), t, a.z),
+                    simd::madd(simd::sub(b.w, a.w), t, a.w)});
+}
+
+/**
+ * Four Hamilton products a * b at once
+ */
+inline QuatX4 multiply(const QuatX4& a, const QuatX4& b) {
+  using simd::madd;
+  using simd::mul;
+  using simd::sub;
+  QuatX4 r;
+  r.x = sub(madd(a.w, b.x, madd(a.x, b.w, mul(a.y, b.z))), mul(a.z, b.y));
+  r.y = madd(a.w, b.y, madd(a.y, b.w, sub(mul(a.z, b.x), mul(a.x, b.z))));
+  r.z = sub(madd(a.w, b.z, madd(a.x, b.y, mul(a.z, b.w))), mul(a.y, b.x));
+  r.w = sub(sub(sub(mul(a.w, b.w), mul(a.x, b.x)), mul(a.y, b.y)),
+            mul(a.z, b.z));
+  return r;
+}
+
+}  // namespace detail
+
+/**
+ * base, then each layer in order, into out (all sized to the same skeleton)
+ * out may alias base.
+ */
+inline void blendPoseLayers(const PoseBuffer& base, const PoseLayer* layers,
+                            int layerCount, PoseBuffer& out) {
+  using detail::QuatX4;
+  using simd::f32x4;
+
+  const size_t stride = base.stride();
+
+  // Joint blocks [first, last) are the ones some active layer touches
+  size_t first = stride;
+  size_t last = 0;
+  for (int l = 0; l < layerCount; ++l) {
+    const PoseLayer& layer = layers[l];
+    if (layer.weight <= 0.0f || !layer.pose) continue;
+    if (!layer.mask) {
+      first = 0;
+      last = stride;
+      break;
+    }
+    if (layer.mask->begin >= layer.mask->end) continue;
+    first = std::min<size_t>(first, layer.mask->begin & ~3u);
+    last = std::max<size_t>(last, (layer.mask->end + 3) & ~3u);
+  }
+  // Streams are contiguous, so one copy covers the untouched blocks
+  if (&out != &base) {
+    std::memcpy(out.stream(0), base.stream(0),
+                stride * kPoseStreamCount * sizeof(float));
+  }
+  if (first >= last) return;
+
+  const f32x4 one = simd::splat(1.0f);
+  const f32x4 zero = simd::splat(0.0f);
+  const QuatX4 identity{zero, zero, zero, one};
+  const float* in[kPoseStreamCount];
+  float* dst[kPoseStreamCount];
+  for (int k = 0; k < kPoseStreamCount; ++k) {
+    in[k] = base.stream(k);
+    dst[k] = out.stream(k);
+  }
+
+  for (size_t j = first; j < last; j += 4) {
+    f32x4 t[3], s[3];
+    for (int k = 0; k < 3; ++k) {
+      t[k] = simd::load(in[kPoseTx + k] + j);
+      s[k] = simd::load(in[kPoseSx + k] + j);
+    }
+    QuatX4 q{simd::load(in[kPoseRx] + j), simd::load(in[kPoseRy] + j),
+             simd::load(in[kPoseRz] + j), simd::load(in[kPoseRw] + j)};
+
+    for (int l = 0; l < layerCount; ++l) {
+      const PoseLayer& layer = layers[l];
+      if (layer.weight <= 0.0f || !layer.pose) continue;
+      f32x4 w = simd::splat(layer.weight);
+      if (layer.mask) {
+        if (j + 4 <= layer.mask->begin || j >= layer.mask->end) continue;
+        w = simd::mul(w, simd::load(layer.mask->weights.data() + j));
+      }
+      const PoseBuffer& p = *layer.pose;
+
+      if (layer.mode == kLayerOverride || !layer.reference) {
+        for (int k = 0; k < 3; ++k) {
+          const f32x4 lt = simd::load(p.stream(kPoseTx + k) + j);
+          const f32x4 ls = simd::load(p.stream(kPoseSx + k) + j);
+          t[k] = simd::madd(simd::sub(lt, t[k]), w, t[k]);
+          s[k] = simd::madd(simd::sub(ls, s[k]), w, s[k]);
+        }
+        q = detail::nlerp(q, detail::loadQuat(p, j), w);
+      } else {
+        const PoseBuffer& ref = *layer.reference;
+        for (int k = 0; k < 3; ++k) {
+          const f32x4 dt = simd::sub(simd::load(p.stream(kPoseTx + k) + j),
+                                     simd::load(ref.stream(kPoseTx + k) + j));
+          const f32x4 ds = simd::sub(simd::load(p.stream(kPoseSx + k) + j),
+                                     simd::load(ref.stream(kPoseSx + k) + j));
+          t[k] = simd::madd(dt, w, t[k]);
+          s[k] = simd::madd(ds, w, s[k]);
+        }
+        // delta = conj(reference) * layer, scaled by w from identity
+        QuatX4 conj = detail::loadQuat(ref, j);
+        conj.x = simd::sub(zero, conj.x);
+        conj.y = simd::sub(zero, conj.y);
+        conj.z = simd::sub(zero, conj.z);
+        const QuatX4 delta = detail::multiply(conj, detail::loadQuat(p, j));
+        q = detail::multiply(q, detail::nlerp(identity, delta, w));
+      }
+    }
+
+    for (int k = 0; k < 3; ++k) {
+      simd::store(dst[kPoseTx + k] + j, t[k]);
+      simd::store(dst[kPoseSx + k] + j, s[k]);
+    }
+    simd::store(dst[kPoseRx] + j, q.x);
+    simd::store(dst[kPoseRy] + j, q.y);
+    simd::store(dst[kPoseRz] + j, q.z);
+    simd::store(dst[kPoseRw] + j, q.w);
+  }
+}
+
+}  // namespace avatar
@@ -0,0 +1,288 @@
+/**
+ * avatar-prosody.h - Pitch and energy tracking for speech-driven head motion
+ *
+ * The mouth analysis only reads band energies, so while the avatar speaks
+ * its head stays still. This module follows the voice's prosody instead.
+ * A YIN pitch tracker and an energy envelope run on 10 ms hops of the
+ * speech PCM. Pitch accents, the syllables a speaker stresses by jumping
+ * above their own baseline, then drive a short head nod and a brow raise.
+ *
+ * CPU is bounded in two ways. Input is decimated to about 11-16 kHz
+ * before YIN, and the difference function sums four samples per register.
+ * A single push analyses at most kMaxHopsPerPush hops; any older backlog,
+ * such as after a stalled tab, is dropped.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "avatar-hop-framer.h"
+#include "avatar-simd.h"
+
+namespace avatar {
+
+/**
+ * YIN fundamental frequency estimator (de Cheveigne & Kawahara, 2002)
+ * over a fixed window of an already decimated signal
+ */
+class PitchTracker {
+ public:
+  struct Result {
+    float hz{0.0f};          // 0 = unvoiced
+    float periodicity{0.0f};  // 1 - CMND at the chosen lag, 0-1
+  };
+
+  /**
+   * sampleRate is the (decimated) rate the frames arrive at
+   */
+  void configure(float sampleRate, float minHz = 70.0f, float maxHz = 400.0f,
+                 float threshold = 0.15f) {
+    sampleRate_ = sampleRate;
+    threshold_ = threshold;
+    minLag_ = std::max(2u, static_cast<uint32_t>(sampleRate / maxHz));
+    maxLag_ = static_cast<uint32_t>(std::ceil(sampleRate / minHz));
+    // Integration window: one period of the lowest pitch, whole registers
+    window_ = (maxLag_ + 3) & ~3u;
+    diff_.assign(maxLag_ + 2, 0.0f);
+  }
+
+  /** Samples analyse() reads: window + max lag */
+  uint32_t frameSize() const { return window_ + maxLag_ + 1; }
+  float sampleRate() const { return sampleRate_; }
+
+  Result analyse(const float* x) {
+    // d(tau) = sum_j (x[j] - x[j + tau])^2 for tau in [1, maxLag]
+    for (uint32_t tau = 1; tau <= maxLag_; ++tau) {
+      simd::f32x4 acc = simd::splat(0.0f);
+      for (uint32_t j = 0; j < window_; j += 4) {
+        const simd::f32x4 d =
+            simd::sub(simd::load(x + j), simd::load(x + j + tau));
+        acc = simd::madd(d, d, acc);
+      }
+      diff_[tau] = simd::lane<0>(simd::hsum(acc));
+    }
+
+    // Cumulative mean normalized difference, in place
+    diff_[0] = 1.0f;
+    float running = 0.0f;
+    for (uint32_t tau = 1; tau <= maxLag_; ++tau) {
+      running += diff_[tau];
+      diff_[tau] = running > 0.0f
+                       ? diff_[tau] * static_cast<float>(tau) / running
+                       : 1.0f;
+    }
+
+    // First dip under the threshold, walked down to its local minimum;
+    // otherwise the global minimum, reported as unvoiced
+    uint32_t best = 0;
+    for (uint32_t tau = minLag_; tau <= maxLag_; ++tau) {
+      if (diff_[tau] < threshold_) {
+        while (tau + 1 <= maxLag_ && diff_[tau + 1] < diff_[tau]) ++tau;
+        best = tau;
+        break;
+      }
+    }
+    Result result;
+    if (best == 0) {
+      float lowest = 1.0f;
+      for (uint32_t tau = minLag_; tau <= maxLag_; ++tau) {
+        lowest = std::min(lowest, diff_[tau]);
+      }
+      result.periodicity = std::max(0.0f, 1.0f - lowest);
+      return result;
+    }
+
+    // Parabolic interpolation around the minimum
+    float lag = static_cast<float>(best);
+    if (best > minLag_ && best < maxLag_) {
+      const float a = diff_[best - 1], b = diff_[best], c = diff_[best + 1];
+      const float denom = a - 2.0f * b + c;
+      if (denom > 0.0f) lag += 0.5f * (a - c) / denom;
+    }
+    result.hz = sampleRate_ / lag;
+    result.periodicity = std::max(0.0f, 1.0f - diff_[best]);
+    return result;
+  }
+
+  size_t memoryBytes() const { return diff_.capacity() * sizeof(float); }
+
+ private:
+  float sampleRate_{0.0f};
+  float threshold_{0.15f};
+  uint32_t minLag_{0};
+  uint32_t maxLag_{0};
+  uint32_t window_{0};
+  std::vector<float> diff_;
+};
+
+struct ProsodyParams {
+  float accentSemitones{2.0f};  // rise above baseline that marks an accent
+  float accentRise{1.0f};       // semitones gained over the last ~80 ms
+  float gateDb{-45.0f};         // hops quieter than this are ignored
+  float refractorySeconds{0.35f};
+  float nodDecaySeconds{0.25f};
+  float nodAttack{18.0f};       // 1/s
+  float browAttack{10.0f};      // 1/s
+  float browRelease{4.0f};      // 1/s
+};
+
+/**
+ * Streaming prosody analysis: push PCM as it plays, read nod/brow drives
+ */
+class ProsodyAnalyzer {
+ public:
+  static constexpr float kHopSeconds = 0.01f;
+  static constexpr uint32_t kMaxHopsPerPush = 8;
+  static constexpr uint32_t kHistory = 8;  // hops of pitch kept (~80 ms)
+
+  ProsodyParams& params() { return params_; }
+
+  /**
+   * Set the input rate; decimates to the 11-16 kHz analysis rate
+   */
+  void configure(float sampleRate) {
+    if (sampleRate == inputRate_) return;
+    inputRate_ = sampleRate;
+    const uint32_t factor =
+        std::max(1u, static_cast<uint32_t>(sampleRate / 11000.0f));
+    tracker_.configure(sampleRate / static_cast<float>(factor));
+    framer_.configure(
+        factor, tracker_.frameSize(),
+        static_cast<uint32_t>(tracker_.sampleRate() * kHopSeconds),
+        kMaxHopsPerPush);
+    reset();
+  }
+
+  void reset() {
+    framer_.reset();
+    baselineLog2_ = 0.0f;
+    voicedHops_ = 0;
+    energyDb_ = -90.0f;
+    sinceAccent_ = 1e3f;
+    nodDrive_ = nod_ = brows_ = browTarget_ = 0.0f;
+    semitones_ = 0.0f;
+    lastHz_ = 0.0f;
+    hops_ = accents_ = 0;
+    for (float& s : history_) s = 0.0f;
+  }
+
+  /**
+   * Feed PCM (mono, -1..1) at the configured rate
+   * Analyses whole hops as they complete, newest kMaxHopsPerPush at most.
+   */
+  void push(const float* samples, uint32_t count) {
+    framer_.push(samples, count,
+                 [this](const float* frame) { analyseHop(frame); });
+  }
+
+  /**
+   * Advance the motion envelopes by frame time (call once per frame,
+   * also when no audio arrived, so nods and brows relax in silence)
+   */
+  void update(float dt) {
+    if (hopsThisFrame_ == 0) {
+      browTarget_ = 0.0f;
+      sinceAccent_ += dt;
+    }
+    hopsThisFrame_ = 0;
+    nodDrive_ *= std::exp(-dt / params_.nodDecaySeconds);
+    nod_ += (nodDrive_ - nod_) * (1.0f - std::exp(-params_.nodAttack * dt));
+    const float rate =
+        browTarget_ > brows_ ? params_.browAttack : params_.browRelease;
+    brows_ += (browTarget_ - brows_) * (1.0f - std::exp(-rate * dt));
+  }
+
+  /** Head nod drive, 0-1 (a dip that eases back) */
+  float nod() const { return nod_; }
+  /** Brow raise, 0-1 */
+  float brows() const { return brows_; }
+
+  float pitchHz() const { return lastHz_; }
+  float semitonesAboveBaseline() const { return semitones_; }
+  float energyDb() const { return energyDb_; }
+  float baselineHz() const {
+    return voicedHops_ ? std::exp2(baselineLog2_) : 0.0f;
+  }
+  uint64_t hops() const { return hops_; }
+  uint64_t droppedHops() const { return framer_.dropped(); }
+  uint32_t accents() const { return accents_; }
+  const PitchTracker& tracker() const { return tracker_; }
+
+  size_t memoryBytes() const {
+    return framer_.memoryBytes() + tracker_.memoryBytes();
+  }
+
+ private:
+  void analyseHop(const float* frame) {
+    ++hops_;
+    ++hopsThisFrame_;
+    sinceAccent_ += kHopSeconds;
+
+    // Energy over the newest hop
+    float sum = 0.0f;
+    const uint32_t hopSize = framer_.hopSize();
+    const float* hop = frame + framer_.frameSize() - hopSize;
+    for (uint32_t i = 0; i < hopSize; ++i) sum += hop[i] * hop[i];
+    energyDb_ = 10.0f * std::log10(sum / static_cast<float>(hopSize) + 1e-9f);
+
+    const PitchTracker::Result pitch = tracker_.analyse(frame);
+    lastHz_ = energyDb_ > params_.gateDb ? pitch.hz : 0.0f;
+    for (uint32_t i = kHistory - 1; i > 0; --i) history_[i] = history_[i - 1];
+    if (lastHz_ <= 0.0f) {
+      history_[0] = 0.0f;
+      semitones_ = 0.0f;
+      browTarget_ = 0.0f;
+      return;
+    }
+
+    // Speaker baseline: slow average of log pitch (~2 s of voicing)
+    const float log2Hz = std::log2(lastHz_);
+    baselineLog2_ = voicedHops_++ == 0
+                        ? log2Hz
+                        : baselineLog2_ + (log2Hz - baselineLog2_) * 0.005f;
+    semitones_ = 12.0f * (log2Hz - baselineLog2_);
+    history_[0] = semitones_;
+
+    // Accent: high above the baseline and still rising
+    const float oldest = history_[kHistory - 1];
+    const bool rising =
+        oldest != 0.0f && semitones_ - oldest > params_.accentRise;
+    if (semitones_ > params_.accentSemitones && rising &&
+        sinceAccent_ > params_.refractorySeconds) {
+      sinceAccent_ = 0.0f;
+      ++accents_;
+      nodDrive_ = std::max(
+          nodDrive_,
+          std::min(1.0f, (semitones_ - 1.0f) / 4.0f));
+    }
+    browTarget_ = std::clamp((semitones_ - 1.0f) / 5.0f, 0.0f, 1.0f);
+  }
+
+  ProsodyParams params_;
+  PitchTracker tracker_;
+  float inputRate_{0.0f};
+  HopFramer framer_;
+
+  float baselineLog2_{0.0f};
+  uint32_t voicedHops_{0};
+  float history_[kHistory]{};  // semitones, newest first, 0 = unvoiced
+  float semitones_{0.0f};
+  float lastHz_{0.0f};
+  float energyDb_{-90.0f};
+  float sinceAccent_{1e3f};
+  uint32_t hopsThisFrame_{0};
+
+  float nodDrive_{0.0f};
+  float nod_{0.0f};
+  float browTarget_{0.0f};
+  float brows_{0.0f};
+
+  uint64_t hops_{0};
+  uint32_t accents_{0};
+};
+
+}  // namespace avatar
@@ -0,0 +1,87 @@
+/**
+ * avatar-quality.h - Frame-time driven quality governor
+ *
+ * Watches smoothed CPU frame time against a budget. It steps quality down
+ * quickly when frames run over and back up slowly once there is headroom,
+ * with hysteresis so the level does not flap. Optional work, such as
+ * spring bones, checks the level before it runs.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace avatar {
+
+enum QualityLevel : uint32_t {
+  kQualityLow = 0,
+  kQualityMedium = 1,
+  kQualityHigh = 2,
+};
+
+struct QualityGovernorParams {
+  float budgetMs{12.0f};     // CPU time per frame
+  float upRatio{0.6f};       // raise while average < budget * upRatio
+  uint32_t downFrames{30};   // consecutive over-budget frames to lower
+  uint32_t upFrames{240};    // consecutive frames with headroom to raise
+  float smoothing{0.1f};     // EMA factor per frame
+};
+
+class QualityGovernor {
+ public:
+  QualityGovernorParams& params() { return params_; }
+  QualityLevel level() const { return level_; }
+  float averageMs() const { return averageMs_; }
+
+  /**
+   * Times the level has been raised; features that switched themselves
+   * off may re-arm when this changes
+   */
+  uint32_t raises() const { return raises_; }
+
+  /**
+   * Feed one frame's CPU time; returns true if the level changed
+   */
+  bool update(float frameMs) {
+    averageMs_ = samples_++ == 0
+                     ? frameMs
+                     : averageMs_ + (frameMs - averageMs_) * params_.smoothing;
+
+    if (averageMs_ > params_.budgetMs) {
+      under_ = 0;
+      if (++over_ >= params_.downFrames && level_ > kQualityLow) {
+        level_ = static_cast<QualityLevel>(level_ - 1);
+        over_ = 0;
+        return true;
+      }
+    } else if (averageMs_ < params_.budgetMs * params_.upRatio) {
+      over_ = 0;
+      if (++under_ >= params_.upFrames && level_ < kQualityHigh) {
+        level_ = static_cast<QualityLevel>(level_ + 1);
+        under_ = 0;
+        ++raises_;
+        return true;
+      }
+    } else {
+      over_ = under_ = 0;
+    }
+    return false;
+  }
+
+  void reset() {
+    level_ = kQualityHigh;
+    averageMs_ = 0.0f;
+    samples_ = over_ = under_ = raises_ = 0;
+  }
+
+ private:
+  QualityGovernorParams params_;
+  QualityLevel level_{kQualityHigh};
+  float averageMs_{0.0f};
+  uint32_t samples_{0};
+  uint32_t over_{0};
+  uint32_t under_{0};
+  uint32_t raises_{0};
+};
+
+}  // namespace avatar
@@ -12,10 +12,13 @@
  * This creates avatar.wasm which is loaded by AvatarCanvas.tsx
  */
 
-#include <emscripten/emscripten.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -28,7 +31,82 @@
 #include "lit-land/animation/animator.h"
 #include "lit-land/core/ecs.h"
 
+#include "avatar-align.h"
+#include "avatar-anim-graph.h"
+#include "avatar-anim-predict.h"
+#include "avatar-control-block.h"
+#include "avatar-frame-counters.h"
+#include "avatar-frame-histogram.h"
+#include "avatar-latency.h"
+#include "avatar-log.h"
+#include "avatar-look-at.h"
+#include "avatar-lookahead-lipsync.h"
+#include "avatar-memory-stats.h"
+#include "avatar-pcm-ring.h"
+#include "avatar-perf-hud.h"
+#include "avatar-platform.h"
+#include "avatar-pose-layers.h"
+#include "avatar-prosody.h"
+#include "avatar-quality.h"
+#include "avatar-sim-clock.h"
+#include "avatar-simd-glm.h"
+#include "avatar-skeleton.h"
+#include "avatar-speech-stream.h"
+#include "avatar-spring-bones.h"
+#include "avatar-state-block.h"
+#include "avatar-vad.h"
+#include "avatar-visemes.h"
+
 namespace {
+  /**
+   * Runtime state of one animation graph layer (same index as the graph's)
+   * Its clip is sampled into its own pose buffer and faded by weight.
+   */
+  struct AnimationLayerSlot {
+    bool enabled = false;  // false if the model lacks the clip
+    float duration = 0.0f;
+    float time = 0.0f;
+    float weight = 0.0f;
+    float targetWeight = 0.0f;
+    float fadeRate = 0.0f;  // weight per second
+    float sampledTime = -1.0f;  // clip time held in pose, < 0 = none
+    avatar::PoseBuffer pose;  // flat order
+  };
+
+  constexpr float kAnimationStep = 1.0f / 60.0f;  // Assuming 60 FPS
+
+  // Preloading for predicted transitions runs only on frames whose CPU
+  // time leaves this much headroom, one clip per frame
+  constexpr double kPrefetchMaxFrameMs = 8.0;
+  constexpr uint32_t kPrefetchStates = 2;
+
+  // Spring bones run at a fixed substep on real frame time. They switch
+  // off below medium quality, or when their own smoothed cost passes the
+  // ceiling; in that case they re-arm only after the governor next raises
+  // quality.
+  constexpr float kSpringStep = 1.0f / 120.0f;
+  constexpr uint32_t kSpringMaxSteps = 4;
+  constexpr float kSpringCostCeilingMs = 0.5f;
+  constexpr float kSpringFadeRate = 4.0f;  // weight per second
+  const char* const kSpringBonePrefixes[] = {"Hair", "Skirt", "Cloth"};
+
+  // Speech prosody: PCM JS pushes per frame, at most one analyser window
+  // of 48 kHz audio per call. A full nod dips the head by kNodPitch.
+  constexpr uint32_t kAudioInputCapacity = 2048;
+  constexpr float kNodPitch = 0.12f;  // radians (~7 deg)
+
+  // Streamed speech: engine-owned inputs for one fetch chunk of MP3
+  // bytes and one decoded AudioData of PCM (MPEG-1 frames hold 1152)
+  constexpr uint32_t kSpeechByteCapacity = 16384;
+  constexpr uint32_t kSpeechPcmCapacity = 4608;
+
+  // Streamed lip-sync: analysis hops per frame (a decode burst is worked
+  // off over a few frames), and the analysed openness at which the audio
+  // stops gating the viseme plan's jaw
+  constexpr uint32_t kLipSyncHopsPerFrame = 48;
+  constexpr float kLipSyncGateOpen = 0.3f;
+  const char* const kBrowMorphNames[] = {"browInnerUp", "browsUp"};
+
   // Global scene state
   struct SceneState {
     std::unique_ptr<litland::GraphicsDevice> graphicsDevice;
@@ -39,6 +117,38 @@ namespace {
 
     // Avatar entity
     litland::ECS::Entity avatarEntity;
+    std::shared_ptr<litland::Model> avatarModel;
+
+    // Flattened skeleton (parent-before-child), built at load; world and
+    // skinning matrices are computed here instead of in the animator
+    avatar::FlatSkeleton skeleton;
+
+    // Animation state machine, compiled from JSON into flat tables
+    avatar::AnimationGraph animGraph;
+    uint32_t animState{0};
+    float stateTime{0.0f};
+    float procedural[avatar::kProceduralCount]{};
+    float proceduralTarget[avatar::kProceduralCount]{};
+    float proceduralFadeRate{0.0f};
+    avatar::TransitionPredictor predictor;
+
+    // Pose layers over the flat skeleton, blended in one fused SoA pass
+    std::vector<AnimationLayerSlot> layers;
+    std::vector<avatar::PoseLayer> poseLayers;  // per-frame scratch
+    avatar::PoseBuffer restPose;     // base and additive reference
+    avatar::PoseBuffer blendedPose;
+    avatar::BoneMask headMask;
+    std::vector<litland::JointPose> sampleScratch;  // model order
+
+    // Camera frustum for avatar-level culling (skips pose evaluation
+    // while the avatar is off screen)
+    avatar::simd::Frustum cameraFrustum = avatar::simd::Frustum::
+        fromViewProjection(avatar::simd::Mat4::identity());
+
+    // Lip-sync morph targets, resolved to model indices at load
+    // Order matches the JS layout: mouthOpen, mouthRound, eyesLookUp, eyesClose
+    int morphTargetIndex[4]{-1, -1, -1, -1};
+    float morphWeights[4]{0.0f, 0.0f, 0.0f, 0.0f};
 
     // Camera properties
     glm::vec3 cameraPosition{0, 1.7f, 2.5f};
@@ -51,57 +161,796 @@ namespace {
     // Canvas dimensions
     int canvasWidth{1024};
     int canvasHeight{768};
+
+    // Frame timing histograms (always on, read via getFrameTimeStats)
+    avatar::FrameTimeStats frameStats;
+    avatar::FrameTimePercentiles frameStatsSnapshot{};
+
+    // Per-frame work counters (read via getFrameCounters)
+    avatar::FrameCounters counters;
+
+    // Audio-to-mouth latency (read via getAudioLatencyStats)
+    avatar::AudioMouthLatency audioLatency;
+    avatar::FrameTimePercentiles audioLatencySnapshot{};
+
+    // Memory by category (collected on demand via collectMemoryStats)
+    avatar::MemoryStats memoryStats;
+
+    // Optional perf overlay (toggled via setPerfHudEnabled)
+    avatar::PerfHud perfHud;
+    std::unique_ptr<litland::Texture> perfHudAtlas;
+
+    // Bulk state for JS typed views (getEngineStateBlock) and the
+    // engine-owned morph input buffer JS writes into each frame
+    avatar::EngineStateBlock stateBlock;
+    float morphInput[4]{0.0f, 0.0f, 0.0f, 0.0f};
+
+    // Inputs JS writes through typed views (getEngineControlBlock)
+    avatar::EngineControlBlock controlBlock;
+    avatar::LookAtSolver lookAt;
+
+    // Secondary motion and the governor that can switch it off
+    avatar::QualityGovernor quality;
+    avatar::SimClock springClock{kSpringStep, kSpringMaxSteps};
+    avatar::SpringBones springBones;
+    float springWeight{0.0f};
+    float springCostMs{0.0f};  // smoothed
+    bool springOverBudget{false};
+    uint32_t springRearm{0};  // quality.raises() when switched off
+
+    // Speech prosody (pitch accents -> head nods and brow raises) and
+    // the engine-owned PCM buffer JS copies samples into
+    avatar::ProsodyAnalyzer prosody;
+    float audioInput[kAudioInputCapacity]{};
+    int browMorphIndex{-1};
+
+    // Microphone PCM JS writes into (getMicrophoneRing) and the voice
+    // activity detector that moves idle -> listening and back
+    avatar::PcmRing micRing;
+    avatar::VoiceActivityDetector vad;
+    bool vadListening{false};  // listening was entered by the VAD
+
+    // Provisional mouth plan from the reply text (planSpeechText), played
+    // on the audio clock over the analysed mouthOpen/mouthRound weights
+    avatar::GraphemeToPhoneme g2p;
+    avatar::VisemeTrack visemes;
+    avatar::SpeechAligner aligner;  // retimes the plan to decoded audio
+
+    // Streamed MP3 reply: framed here, decoded by the platform codec,
+    // played by an AudioWorklet that reports the playhead
+    avatar::SpeechStream speech;
+    uint8_t speechByteInput[kSpeechByteCapacity]{};
+    float speechPcmInput[kSpeechPcmCapacity]{};
+    avatar::SpeechStream::Frame speechFrame{nullptr, 0};
+    size_t speechProsodyFed{0};  // played samples already analysed
+    double speechSyncedPlayhead{0.0};
+
+    // Mouth analysed from the decoded stream ahead of the playhead
+    avatar::LookaheadLipSync lipSync;
+    bool lipSyncShown{false};  // the stream drove the mouth last frame
   } g_scene;
 
   /**
-   * Log messages to browser console
+   * Lip-sync weight i as shown: mouthOpen and mouthRound fade to the
+   * viseme plan while it owns the mouth. A streamed reply's lookahead
+   * analysis replaces the analysed weights, and gates the plan's jaw so
+   * it closes wherever the audio is silent.
    */
-  void logInfo(const std::string& message) {
-    EM_ASM({
-      console.log("[LIT-LAND Avatar]", UTF8ToString($0));
-    }, message.c_str());
+  float mouthWeight(int i) {
+    const bool streamed = i <= 1 && g_scene.lipSync.owning();
+    const auto& heard = g_scene.lipSync.pose();
+    const float weight = streamed ? (i == 0 ? heard.open : heard.round)
+                                  : g_scene.morphWeights[i];
+    const float planWeight = g_scene.visemes.weight();
+    if (i > 1 || planWeight <= 0.0f) return weight;
+    const auto& pose = g_scene.visemes.pose();
+    float planned = i == 0 ? pose.open : pose.round;
+    if (streamed && i == 0) {
+      planned *= std::min(1.0f, heard.open / kLipSyncGateOpen);
+    }
+    return weight + (planned - weight) * planWeight;
   }
 
-  void logError(const std::string& message) {
-    EM_ASM({
-      console.error("[LIT-LAND Avatar]", UTF8ToString($0));
-    }, message.c_str());
+  /**
+   * Copy this frame's state into the block JS reads through typed views
+   */
+  void publishStateBlock() {
+    auto& block = g_scene.stateBlock;
+    block.logPending = avatar::log::ring().pending();
+    block.frameRate =
+        g_scene.graphicsDevice ? g_scene.graphicsDevice->getFrameRate() : 0.0f;
+    for (int i = 0; i < avatar::kFramePhaseCount; ++i) {
+      block.lastFrameMs[i] = g_scene.frameStats.lastMs[i];
+    }
+    for (int i = 0; i < 4; ++i) {
+      block.morphWeights[i] = mouthWeight(i);
+    }
+    block.counters = g_scene.counters;
+    block.qualityLevel = g_scene.quality.level();
+    block.springParticles =
+        g_scene.springWeight > 0.0f ? g_scene.springBones.particleCount() : 0;
+    block.voiceActive = g_scene.vad.active() ? 1 : 0;
+  }
+
+  size_t layerMemoryBytes() {
+    size_t bytes = g_scene.animGraph.memoryBytes() +
+                   g_scene.predictor.memoryBytes() +
+                   g_scene.layers.capacity() * sizeof(AnimationLayerSlot) +
+                   g_scene.poseLayers.capacity() * sizeof(avatar::PoseLayer) +
+                   g_scene.restPose.memoryBytes() +
+                   g_scene.blendedPose.memoryBytes() +
+                   g_scene.headMask.weights.capacity() * sizeof(float) +
+                   g_scene.springBones.memoryBytes() +
+                   g_scene.prosody.memoryBytes() +
+                   g_scene.vad.memoryBytes() +
+                   g_scene.sampleScratch.capacity() * sizeof(litland::JointPose);
+    for (const auto& slot : g_scene.layers) bytes += slot.pose.memoryBytes();
+    return bytes;
   }
 
   /**
-   * Setup idle animation state
-   * Subtle breathing, slight swaying
+   * Gather memory usage per category
+   * Walks allocator and model state, so only called on demand.
    */
-  void setupIdleAnimation() {
-    if (!g_scene.animator) return;
+  const avatar::MemoryStats& collectMemoryStats() {
+    auto& bytes = g_scene.memoryStats.bytes;
+    bytes[avatar::kMemHeap] =
+        static_cast<uint32_t>(avatar::heapBytesInUse());
+    bytes[avatar::kMemGeometry] =
+        g_scene.avatarModel ? g_scene.avatarModel->getGeometryMemoryUsage() : 0;
+    bytes[avatar::kMemTextures] =
+        g_scene.avatarModel ? g_scene.avatarModel->getTextureMemoryUsage() : 0;
+    bytes[avatar::kMemAnimation] = static_cast<uint32_t>(
+        (g_scene.animator ? g_scene.animator->getMemoryUsage() : 0) +
+        g_scene.skeleton.memoryBytes() +
+        layerMemoryBytes());
+    bytes[avatar::kMemEngine] = static_cast<uint32_t>(
+        sizeof(g_scene) + sizeof(avatar::log::LogRing) +
+        g_scene.perfHud.memoryBytes() + g_scene.g2p.memoryBytes() +
+        g_scene.visemes.memoryBytes() + g_scene.aligner.memoryBytes() +
+        g_scene.speech.memoryBytes() + g_scene.lipSync.memoryBytes());
+    return g_scene.memoryStats;
+  }
 
-    // Idle animation: subtle breathing cycle
-    g_scene.animator->setAnimationSpeed(0.3f);
-    g_scene.animator->playAnimation("Armature|ArmatureAction", true);
+  /**
+   * Build the perf HUD batch and draw it with a single overlay draw
+   * Shows the previous frame's counters; this frame's are not final yet.
+   */
+  void drawPerfHud() {
+    auto& hud = g_scene.perfHud;
+    if (!g_scene.perfHudAtlas) {
+      g_scene.perfHudAtlas = g_scene.graphicsDevice->createTexture(
+          hud.atlasWidth(), hud.atlasHeight(), litland::TextureFormat::R8Unorm,
+          hud.atlasPixels().data());
+    }
+
+    const avatar::FrameHistogram& interval =
+        g_scene.frameStats.phases[avatar::kFrameInterval];
+    hud.build(g_scene.canvasWidth, g_scene.canvasHeight,
+              interval.valueAtQuantile(0.99) / 1000.0f, g_scene.counters,
+              collectMemoryStats());
+
+    const auto& vertices = hud.vertices();
+    g_scene.graphicsDevice->drawOverlay(vertices.data(),
+        static_cast<uint32_t>(vertices.size()), g_scene.perfHudAtlas.get());
   }
 
+  const char* const kMorphTargetNames[4] = {
+      "mouthOpen", "mouthRound", "eyesLookUp", "eyesClose"};
+
   /**
-   * Setup listening animation state
-   * Head tilt, attention pose
+   * Gather per-frame work counters from the device, scene and animator
    */
-  void setupListeningAnimation() {
-    if (!g_scene.animator) return;
+  void collectFrameCounters() {
+    auto& counters = g_scene.counters;
+    counters.beginFrame();
+
+    if (g_scene.graphicsDevice) {
+      const litland::RenderStats& stats =
+          g_scene.graphicsDevice->getRenderStats();
+      counters.drawCalls = stats.drawCalls;
+      counters.triangles = stats.triangles;
+      counters.bytesUploaded = stats.bytesUploaded;
+      counters.pipelineBinds = stats.pipelineBinds;
+    }
 
-    // Listening animation: head tilt
-    g_scene.animator->setAnimationSpeed(0.5f);
-    g_scene.animator->playAnimation("HeadTilt", false);
+    if (g_scene.scene) {
+      counters.culledPrimitives = g_scene.scene->getCulledPrimitiveCount();
+    }
+
+    if (!g_scene.skeleton.empty()) {
+      counters.bonesEvaluated =
+          static_cast<uint32_t>(g_scene.skeleton.size());
+    } else if (g_scene.animator) {
+      counters.bonesEvaluated = g_scene.animator->getEvaluatedBoneCount();
+    }
+
+    if (g_scene.avatarModel) {
+      counters.skinnedVertices = g_scene.avatarModel->getSkinnedVertexCount();
+    }
+
+    // Weights as shown, after the viseme plan and streamed lip-sync
+    for (int i = 0; i < 4; ++i) {
+      if (g_scene.morphTargetIndex[i] >= 0 && mouthWeight(i) > 0.0f) {
+        ++counters.activeMorphs;
+      }
+    }
+    // applyProsody() drives the brow only with a skeleton
+    if (g_scene.browMorphIndex >= 0 && !g_scene.skeleton.empty() &&
+        g_scene.prosody.brows() * g_scene.procedural[avatar::kProcBrows] >
+            0.0f) {
+      ++counters.activeMorphs;
+    }
+  }
+
+  /**
+   * Copy a model-order joint pose array into a flat-order pose buffer
+   */
+  void copyJointPoses(const litland::JointPose* pose, avatar::PoseBuffer& out) {
+    const uint32_t* flatToModel = g_scene.skeleton.flatToModel();
+    for (size_t i = 0; i < g_scene.skeleton.size(); ++i) {
+      const litland::JointPose& joint = pose[flatToModel[i]];
+      const float t[3] = {joint.translation.x, joint.translation.y,
+                          joint.translation.z};
+      const float q[4] = {joint.rotation.x, joint.rotation.y,
+                          joint.rotation.z, joint.rotation.w};
+      const float s[3] = {joint.scale.x, joint.scale.y, joint.scale.z};
+      out.setJoint(i, t, q, s);
+    }
+  }
+
+  /**
+   * Size the layer slots to the graph, weights snapped to the current state
+   * Needs the flat skeleton; call after either changes.
+   */
+  void configureLayerSlots() {
+    const auto& graph = g_scene.animGraph;
+    g_scene.layers.assign(graph.layerCount(), AnimationLayerSlot{});
+    g_scene.poseLayers.assign(graph.layerCount(), avatar::PoseLayer{});
+    if (graph.empty()) return;
+
+    const float* targets = graph.targetWeights(g_scene.animState);
+    for (uint32_t i = 0; i < graph.layerCount(); ++i) {
+      const auto& def = graph.layer(i);
+      auto& slot = g_scene.layers[i];
+      slot.duration = g_scene.animator->getClipDuration(def.clip.c_str());
+      if (slot.duration <= 0.0f) {
+        AVATAR_LOG_WARN("Animation clip missing, layer '%s' disabled: %s",
+                        def.name.c_str(), def.clip.c_str());
+        continue;
+      }
+      slot.enabled = true;
+      slot.weight = slot.targetWeight = targets[i];
+      slot.pose.resize(g_scene.skeleton.size());
+    }
+  }
+
+  bool isSpringBoneName(const std::string& name) {
+    for (const char* prefix : kSpringBonePrefixes) {
+      if (name.compare(0, std::strlen(prefix), prefix) == 0) return true;
+    }
+    return false;
+  }
+
+  /**
+   * Find hair and clothing chains by joint name, with sphere colliders
+   * on the head and shoulders
+   * A chain starts at a spring joint whose parent is not one.
+   */
+  void configureSpringBones(const litland::Skeleton& source) {
+    const uint32_t count = source.getJointCount();
+    std::vector<int32_t> roots;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (!isSpringBoneName(source.getJointName(i))) continue;
+      const int32_t parent = source.getJointParent(i);
+      if (parent >= 0 &&
+          isSpringBoneName(source.getJointName(static_cast<uint32_t>(parent)))) {
+        continue;
+      }
+      roots.push_back(static_cast<int32_t>(g_scene.skeleton.flatIndex(i)));
+    }
+    std::sort(roots.begin(), roots.end());
+
+    auto& springs = g_scene.springBones;
+    springs.build(g_scene.skeleton, roots.data(),
+                  static_cast<uint32_t>(roots.size()));
+    g_scene.springWeight = 0.0f;
+    g_scene.springClock.reset();
+    if (springs.empty()) return;
+
+    struct ColliderDef {
+      const char* joint;
+      float offset[3];
+      float radius;
+    };
+    const ColliderDef colliders[] = {
+        {"Head", {0.0f, 0.09f, 0.01f}, 0.1f},
+        {"LeftShoulder", {0.0f, 0.0f, 0.0f}, 0.06f},
+        {"RightShoulder", {0.0f, 0.0f, 0.0f}, 0.06f},
+    };
+    for (const ColliderDef& c : colliders) {
+      const int32_t joint = source.findJoint(c.joint);
+      if (joint < 0) continue;
+      springs.addCollider(
+          static_cast<int32_t>(
+              g_scene.skeleton.flatIndex(static_cast<uint32_t>(joint))),
+          c.offset[0], c.offset[1], c.offset[2], c.radius);
+    }
+    AVATAR_LOG_DEBUG("Spring bones: %u chains, %u particles",
+                     springs.chainCount(), springs.particleCount());
   }
 
   /**
-   * Setup speaking animation state
-   * Facial animation prepared for lip-sync
+   * Set up the layer slots, head mask, look-at and spring bones for a
+   * freshly built skeleton
    */
-  void setupSpeakingAnimation() {
-    if (!g_scene.animator) return;
+  void configureLayers(const litland::Skeleton& source) {
+    const size_t count = g_scene.skeleton.size();
+    g_scene.sampleScratch.assign(count, litland::JointPose{});
+    g_scene.restPose.resize(count);
+    copyJointPoses(source.getRestPose(), g_scene.restPose);
+    g_scene.blendedPose.resize(count);
+
+    // Face and head layers cover the neck (or head) subtree; without one
+    // they fall back to the whole body
+    g_scene.headMask = avatar::BoneMask{};
+    for (const char* name : {"Neck", "Head"}) {
+      const int32_t joint = source.findJoint(name);
+      if (joint >= 0) {
+        g_scene.headMask = avatar::BoneMask::subtree(
+            g_scene.skeleton,
+            g_scene.skeleton.flatIndex(static_cast<uint32_t>(joint)));
+        break;
+      }
+    }
+    if (g_scene.headMask.weights.empty()) {
+      AVATAR_LOG_WARN("No Neck/Head joint; head layers affect the full body");
+    }
+
+    int32_t lookAtJoints[4];
+    const char* lookAtNames[4] = {"Neck", "Head", "LeftEye", "RightEye"};
+    for (int i = 0; i < 4; ++i) {
+      const int32_t joint = source.findJoint(lookAtNames[i]);
+      lookAtJoints[i] =
+          joint >= 0 ? static_cast<int32_t>(g_scene.skeleton.flatIndex(
+                           static_cast<uint32_t>(joint)))
+                     : avatar::LookAtSolver::kNone;
+    }
+    g_scene.lookAt.bind(lookAtJoints[0], lookAtJoints[1], lookAtJoints[2],
+                        lookAtJoints[3]);
+    if (!g_scene.lookAt.bound()) {
+      AVATAR_LOG_WARN("No Head joint; look-at disabled");
+    }
+
+    configureSpringBones(source);
+
+    configureLayerSlots();
+  }
+
+  /**
+   * Flatten the model's joint hierarchy for linear world-matrix passes
+   * Leaves the skeleton empty (animator computes matrices itself) if the
+   * hierarchy is malformed.
+   */
+  void buildFlatSkeleton(const litland::Skeleton& source) {
+    const uint32_t count = source.getJointCount();
+    std::vector<int32_t> parents(count);
+    for (uint32_t i = 0; i < count; ++i) {
+      parents[i] = source.getJointParent(i);
+    }
+
+    if (!g_scene.skeleton.build(parents.data(), parents.size())) {
+      AVATAR_LOG_ERROR("Skeleton has a cycle or invalid parent (%u joints)",
+                       count);
+      return;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      g_scene.skeleton.setInverseBind(
+          i, avatar::simd::fromGlm(source.getInverseBindMatrix(i)));
+    }
+    g_scene.animator->setWorldTransformsEnabled(false);
+    AVATAR_LOG_DEBUG("Flattened skeleton: %u joints, depth %u", count,
+                     g_scene.skeleton.maxDepth());
+    configureLayers(source);
+  }
+
+  /**
+   * Recompute the culling frustum; call whenever the camera changes
+   */
+  void updateCameraFrustum() {
+    const float aspect = static_cast<float>(g_scene.canvasWidth) /
+                         static_cast<float>(g_scene.canvasHeight);
+    const glm::mat4 viewProjection =
+        glm::perspective(glm::radians(g_scene.cameraFOV), aspect, 0.1f,
+                         100.0f) *
+        glm::lookAt(g_scene.cameraPosition, g_scene.cameraTarget,
+                    glm::vec3(0, 1, 0));
+    g_scene.cameraFrustum = avatar::simd::Frustum::fromViewProjection(
+        avatar::simd::fromGlm(viewProjection));
+  }
+
+  /**
+   * Whether the avatar's bounding sphere intersects the camera frustum
+   */
+  bool avatarVisible() {
+    const glm::vec4 sphere = g_scene.avatarModel->getBoundingSphere();
+    return g_scene.cameraFrustum.sphereVisible(sphere.x, sphere.y, sphere.z,
+                                               sphere.w);
+  }
 
-    // Speaking: prepare for lip-sync in Phase 4
-    g_scene.animator->setAnimationSpeed(1.0f);
-    g_scene.animator->playAnimation("Talking", true);
+  float fadeToward(float value, float target, float step) {
+    return value < target ? std::min(value + step, target)
+                          : std::max(value - step, target);
+  }
+
+  /**
+   * Enter a graph state: set layer/procedural targets and fade rates
+   * Returns false (state unchanged) if the graph forbids the transition.
+   */
+  bool enterState(uint32_t state) {
+    const auto& graph = g_scene.animGraph;
+    const float blend = graph.blendSeconds(g_scene.animState, state);
+    if (blend < 0.0f) {
+      AVATAR_LOG_WARN("Animation transition not allowed: %s -> %s",
+                      graph.stateName(g_scene.animState).c_str(),
+                      graph.stateName(state).c_str());
+      return false;
+    }
+    const float rate = blend > 0.0f ? 1.0f / blend
+                                    : std::numeric_limits<float>::infinity();
+    g_scene.predictor.observe(g_scene.animState, state);
+    g_scene.animState = state;
+    g_scene.stateTime = 0.0f;
+    g_scene.currentAnimationState = graph.stateName(state);
+    g_scene.stateBlock.animationState = state;
+
+    const float* targets = graph.targetWeights(state);
+    for (uint32_t i = 0; i < g_scene.layers.size(); ++i) {
+      auto& slot = g_scene.layers[i];
+      if (graph.layer(i).restart && targets[i] > 0.0f && slot.weight <= 0.0f) {
+        slot.time = 0.0f;
+      }
+      slot.targetWeight = targets[i];
+      slot.fadeRate = rate;
+    }
+    const float* procedural = graph.procedural(state);
+    for (int c = 0; c < avatar::kProceduralCount; ++c) {
+      g_scene.proceduralTarget[c] = procedural[c];
+    }
+    g_scene.proceduralFadeRate = rate;
+
+    // Without a flat skeleton the animator plays the state's main clip
+    if (g_scene.skeleton.empty() && g_scene.animator) {
+      const auto& def = graph.layer(graph.fallbackLayer(state));
+      g_scene.animator->setAnimationSpeed(def.speed);
+      g_scene.animator->playAnimation(def.clip.c_str(), def.loop);
+    }
+    return true;
+  }
+
+  /**
+   * Advance state time, procedural fades and automatic exits
+   */
+  void advanceAnimationState(float dt) {
+    const auto& graph = g_scene.animGraph;
+    if (graph.empty()) return;
+    const float step = dt * g_scene.proceduralFadeRate;
+    for (int c = 0; c < avatar::kProceduralCount; ++c) {
+      g_scene.procedural[c] = fadeToward(g_scene.procedural[c],
+                                         g_scene.proceduralTarget[c], step);
+    }
+    g_scene.stateTime += dt;
+    const float exitAfter = graph.exitAfter(g_scene.animState);
+    if (exitAfter > 0.0f && g_scene.stateTime >= exitAfter) {
+      enterState(graph.exitState(g_scene.animState));
+    }
+  }
+
+  float advanceClipTime(const AnimationLayerSlot& slot,
+                        const avatar::AnimLayerDef& def, float time,
+                        float dt) {
+    time += dt * def.speed;
+    if (time >= slot.duration) {
+      time = def.loop ? std::fmod(time, slot.duration) : slot.duration;
+    }
+    return time;
+  }
+
+  /**
+   * Fade layer weights toward their targets and advance clip time
+   * Runs even while culled so layers stay in sync when back on screen.
+   */
+  void advanceLayers(float dt) {
+    for (uint32_t i = 0; i < g_scene.layers.size(); ++i) {
+      auto& slot = g_scene.layers[i];
+      slot.weight =
+          fadeToward(slot.weight, slot.targetWeight, dt * slot.fadeRate);
+      if (!slot.enabled || slot.weight <= 0.0f) continue;
+      slot.time =
+          advanceClipTime(slot, g_scene.animGraph.layer(i), slot.time, dt);
+    }
+  }
+
+  void sampleLayer(uint32_t index, float time) {
+    auto& slot = g_scene.layers[index];
+    g_scene.animator->sampleClip(g_scene.animGraph.layer(index).clip.c_str(),
+                                 time, g_scene.sampleScratch.data());
+    copyJointPoses(g_scene.sampleScratch.data(), slot.pose);
+    slot.sampledTime = time;
+  }
+
+  /**
+   * Spend idle frame time on the states likely to come next
+   * For each layer a predicted state would fade in, make its clip
+   * resident (decompressed) and sample the pose it will show on its
+   * first frame, so the transition frame reuses the cached pose instead
+   * of decompressing and sampling. Does one unit of work per call.
+   */
+  void prefetchPredictedStates() {
+    const auto& graph = g_scene.animGraph;
+    uint32_t next[kPrefetchStates];
+    const uint32_t count = g_scene.predictor.predict(
+        graph, g_scene.animState, next, kPrefetchStates);
+    for (uint32_t n = 0; n < count; ++n) {
+      const float* targets = graph.targetWeights(next[n]);
+      for (uint32_t i = 0; i < g_scene.layers.size(); ++i) {
+        auto& slot = g_scene.layers[i];
+        // Active layers are sampled every frame anyway
+        if (!slot.enabled || targets[i] <= 0.0f || slot.weight > 0.0f) {
+          continue;
+        }
+        const auto& def = graph.layer(i);
+        if (!g_scene.animator->isClipResident(def.clip.c_str())) {
+          g_scene.animator->prepareClip(def.clip.c_str());
+          AVATAR_LOG_DEBUG("Preloaded clip %s for state %s", def.clip.c_str(),
+                           graph.stateName(next[n]).c_str());
+          return;
+        }
+        // Entering rewinds restart layers; the first evaluated frame has
+        // already advanced one step
+        const float firstTime = advanceClipTime(
+            slot, def, def.restart ? 0.0f : slot.time, kAnimationStep);
+        if (slot.sampledTime != firstTime) {
+          sampleLayer(i, firstTime);
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * Resolve the control block's look-at target to model space
+   * Screen targets are unprojected onto the plane through the camera
+   * target, so the avatar follows the cursor at conversational depth.
+   */
+  void resolveLookAtTarget(float* out) {
+    const auto& control = g_scene.controlBlock;
+    if (control.lookAtMode != avatar::kLookAtScreen) {
+      for (int i = 0; i < 3; ++i) out[i] = control.lookAtTarget[i];
+      return;
+    }
+    const glm::vec3 forward = g_scene.cameraTarget - g_scene.cameraPosition;
+    const float distance = std::sqrt(forward.x * forward.x +
+                                     forward.y * forward.y +
+                                     forward.z * forward.z);
+    const float aspect = static_cast<float>(g_scene.canvasWidth) /
+                         static_cast<float>(g_scene.canvasHeight);
+    const float halfHeight =
+        distance * std::tan(glm::radians(g_scene.cameraFOV) * 0.5f);
+    const glm::mat4 view = glm::lookAt(g_scene.cameraPosition,
+                                       g_scene.cameraTarget,
+                                       glm::vec3(0, 1, 0));
+    // Rows of the view rotation are the camera's right and up axes
+    const glm::vec3 right(view[0][0], view[1][0], view[2][0]);
+    const glm::vec3 up(view[0][1], view[1][1], view[2][1]);
+    const float x = control.lookAtTarget[0] * halfHeight * aspect;
+    const float y = control.lookAtTarget[1] * halfHeight;
+    const glm::vec3 point = g_scene.cameraTarget + right * x + up * y;
+    out[0] = point.x;
+    out[1] = point.y;
+    out[2] = point.z;
+  }
+
+  /**
+   * Run the VAD over the microphone samples JS wrote since last frame
+   * Speech while idle enters listening; silence after that returns to
+   * idle, unless the UI has moved the state on in the meantime.
+   */
+  void pollMicrophone() {
+    auto& ring = g_scene.micRing;
+    if (ring.sampleRate <= 0.0f || ring.available() == 0) return;
+    auto& vad = g_scene.vad;
+    vad.configure(ring.sampleRate);
+    bool changed = false;
+    ring.consume(avatar::PcmRing::kCapacity,
+                 [&vad, &changed](const float* samples, uint32_t count) {
+                   changed |= vad.push(samples, count);
+                 });
+    if (!changed) return;
+
+    const auto& graph = g_scene.animGraph;
+    const int32_t idle = graph.findState("idle");
+    const int32_t listening = graph.findState("listening");
+    if (idle < 0 || listening < 0) return;
+    if (vad.active() && g_scene.animState == static_cast<uint32_t>(idle)) {
+      g_scene.vadListening = enterState(static_cast<uint32_t>(listening));
+    } else if (!vad.active() && g_scene.vadListening) {
+      g_scene.vadListening = false;
+      if (g_scene.animState == static_cast<uint32_t>(listening)) {
+        enterState(static_cast<uint32_t>(idle));
+      }
+    }
+  }
+
+  /**
+   * Follow the streamed reply's playhead: newly played audio goes to the
+   * prosody analyser, and the viseme plan is synced while the playhead
+   * moves (a paused player lets the plan fade out). Decoded audio is
+   * analysed for the mouth as soon as it arrives and sampled here at the
+   * playhead.
+   */
+  void pollSpeechStream() {
+    auto& speech = g_scene.speech;
+    if (!speech.active()) return;
+    const float rate = static_cast<float>(speech.sampleRate());
+    g_scene.prosody.configure(rate);
+    size_t& fed = g_scene.speechProsodyFed;
+    while (fed < speech.playedSamples()) {
+      const size_t count = std::min<size_t>(speech.playedSamples() - fed,
+                                            kAudioInputCapacity);
+      g_scene.prosody.push(speech.pcm() + fed, count);
+      fed += count;
+    }
+    if (speech.playhead() > g_scene.speechSyncedPlayhead) {
+      g_scene.speechSyncedPlayhead = speech.playhead();
+      g_scene.visemes.sync(static_cast<float>(speech.playhead()),
+                           static_cast<float>(speech.durationSeconds()));
+    }
+
+    auto& lipSync = g_scene.lipSync;
+    lipSync.configure(rate);
+    lipSync.analyse(speech.pcm(), speech.decodedSamples(), speech.complete(),
+                    kLipSyncHopsPerFrame);
+    const bool wasOwning = lipSync.owning();
+    lipSync.sample(static_cast<float>(speech.playhead()));
+    if (wasOwning && !lipSync.owning()) {
+      AVATAR_LOG_INFO("Streamed lip-sync finished, %u underruns",
+                      lipSync.buffer().underruns());
+    }
+  }
+
+  /**
+   * Turn speech prosody into a head-nod gesture and a brow raise, scaled
+   * by the state's headNod and brows channels
+   */
+  void applyProsody() {
+    const auto& prosody = g_scene.prosody;
+    g_scene.lookAt.setGesture(
+        0.0f, -kNodPitch * prosody.nod() *
+                  g_scene.procedural[avatar::kProcHeadNod]);
+    if (g_scene.browMorphIndex >= 0) {
+      g_scene.avatarModel->setMorphTargetWeight(
+          g_scene.browMorphIndex,
+          prosody.brows() * g_scene.procedural[avatar::kProcBrows]);
+    }
+  }
+
+  /**
+   * Advance the viseme plan and show it, or the streamed lookahead
+   * analysis, on the mouth morphs; the frame both let go restores the
+   * analysed weights
+   */
+  void applyVisemes(float dt) {
+    auto& track = g_scene.visemes;
+    const bool wasActive = track.weight() > 0.0f || g_scene.lipSyncShown;
+    track.update(dt);
+    g_scene.lipSyncShown = g_scene.lipSync.owning();
+    const bool active = track.weight() > 0.0f || g_scene.lipSyncShown;
+    if (!g_scene.avatarModel || (!wasActive && !active)) return;
+    for (int i = 0; i < 2; ++i) {
+      if (g_scene.morphTargetIndex[i] >= 0) {
+        g_scene.avatarModel->setMorphTargetWeight(g_scene.morphTargetIndex[i],
+                                                  mouthWeight(i));
+      }
+    }
+  }
+
+  /**
+   * Aim the head and eyes after the animated pose is in world space
+   * Weighted by the control block and the state's lookAt channel, so a
+   * state without look-at relaxes back to the animation.
+   */
+  void applyLookAt() {
+    if (!g_scene.lookAt.bound()) return;
+    const auto& control = g_scene.controlBlock;
+    float weight = 0.0f;
+    float target[3]{0.0f, 0.0f, 0.0f};
+    if (control.lookAtMode != avatar::kLookAtOff) {
+      weight = std::clamp(control.lookAtWeight, 0.0f, 1.0f) *
+               g_scene.procedural[avatar::kProcLookAt];
+      resolveLookAtTarget(target);
+    }
+    g_scene.lookAt.apply(g_scene.skeleton, target, weight, kAnimationStep);
+  }
+
+  /**
+   * Step the spring bones on the fixed-step clock and write them back
+   * Fades in and out with the state's springBones channel; while off
+   * the chains follow the animation and cost nothing.
+   */
+  void applySpringBones() {
+    auto& springs = g_scene.springBones;
+    if (springs.empty()) return;
+
+    if (g_scene.springOverBudget &&
+        g_scene.quality.raises() != g_scene.springRearm) {
+      g_scene.springOverBudget = false;
+      g_scene.springCostMs = 0.0f;
+    }
+    const bool allowed = !g_scene.springOverBudget &&
+                         g_scene.quality.level() >= avatar::kQualityMedium;
+    // Real frame time, bounded so a stalled tab does not fling the hair
+    const float intervalMs =
+        g_scene.frameStats.lastMs[avatar::kFrameInterval];
+    const float dt = intervalMs > 0.0f
+                         ? std::min(intervalMs * 0.001f, 0.1f)
+                         : kAnimationStep;
+    g_scene.springWeight = fadeToward(
+        g_scene.springWeight,
+        allowed ? g_scene.procedural[avatar::kProcSpringBones] : 0.0f,
+        kSpringFadeRate * dt);
+    if (g_scene.springWeight <= 0.0f) {
+      springs.reset();
+      g_scene.springClock.reset();
+      return;
+    }
+
+    const double start = emscripten_get_now();
+    const uint32_t steps = g_scene.springClock.advance(dt);
+    springs.simulate(g_scene.skeleton, g_scene.springClock.step(), steps);
+    springs.apply(g_scene.skeleton, g_scene.springWeight);
+    const float costMs = static_cast<float>(emscripten_get_now() - start);
+
+    g_scene.springCostMs += (costMs - g_scene.springCostMs) * 0.1f;
+    if (g_scene.springCostMs > kSpringCostCeilingMs) {
+      g_scene.springOverBudget = true;
+      g_scene.springRearm = g_scene.quality.raises();
+      AVATAR_LOG_WARN("Spring bones over budget (%.2f ms); disabled",
+                      g_scene.springCostMs);
+    }
+  }
+
+  /**
+   * Sample active layers, blend them over the rest pose in one pass,
+   * apply prosody gestures, look-at and spring bones and compute skinning
+   */
+  void evaluateSkeleton() {
+    auto& skeleton = g_scene.skeleton;
+    const bool haveHeadMask = !g_scene.headMask.weights.empty();
+    int layerCount = 0;
+    for (uint32_t i = 0; i < g_scene.layers.size(); ++i) {
+      auto& slot = g_scene.layers[i];
+      if (!slot.enabled || slot.weight <= 0.0f) continue;
+      const auto& def = g_scene.animGraph.layer(i);
+      // Held or preloaded poses are reused as long as the time matches
+      if (slot.sampledTime != slot.time) sampleLayer(i, slot.time);
+      auto& layer = g_scene.poseLayers[layerCount++];
+      layer.mode = def.mode;
+      layer.weight = slot.weight;
+      layer.pose = &slot.pose;
+      layer.reference = &g_scene.restPose;
+      layer.mask = def.headOnly && haveHeadMask ? &g_scene.headMask : nullptr;
+    }
+
+    avatar::blendPoseLayers(g_scene.restPose, g_scene.poseLayers.data(),
+                            layerCount, g_scene.blendedPose);
+    g_scene.blendedPose.toTransforms(skeleton.localPose());
+    skeleton.computeWorld();
+    applyProsody();
+    applyLookAt();
+    applySpringBones();
+    g_scene.avatarModel->setSkinningMatrices(skeleton.computeSkinning(),
+        static_cast<uint32_t>(skeleton.size()));
   }
 }
 
@@ -111,7 +960,7 @@ namespace {
  */
 extern "C" EMSCRIPTEN_KEEPALIVE void initScene() {
   try {
-    logInfo("Initializing avatar scene...");
+    AVATAR_LOG_INFO("Initializing avatar scene...");
 
     // Create graphics device (WebGPU for browser)
     g_scene.graphicsDevice = litland::createGraphicsDevice(
@@ -149,13 +998,23 @@ extern "C" EMSCRIPTEN_KEEPALIVE void initScene() {
         static_cast<float>(g_scene.canvasWidth) /
             static_cast<float>(g_scene.canvasHeight),
         0.1f, 100.0f);
+    updateCameraFrustum();
 
-    // Start with idle animation state
-    setupIdleAnimation();
+    // Start in the graph's first state (idle); the built-in graph is used
+    // until loadAnimationGraph() supplies an asset
+    if (g_scene.animGraph.empty()) {
+      std::string error;
+      g_scene.animGraph.compile(avatar::kDefaultAnimationGraph,
+                                sizeof(avatar::kDefaultAnimationGraph) - 1,
+                                &error);
+      g_scene.predictor.reset(g_scene.animGraph.stateCount());
+    }
+    g_scene.animState = 0;
+    enterState(0);
 
-    logInfo("Avatar scene initialized successfully");
+    AVATAR_LOG_INFO("Avatar scene initialized successfully");
   } catch (const std::exception& e) {
-    logError(std::string("Failed to initialize scene: ") + e.what());
+    AVATAR_LOG_ERROR("Failed to initialize scene: %s", e.what());
   }
 }
 
@@ -166,7 +1025,7 @@ extern "C" EMSCRIPTEN_KEEPALIVE void initScene() {
 extern "C" EMSCRIPTEN_KEEPALIVE void loadAvatarModel(
     uint8_t* glbBuffer, size_t bufferSize) {
   try {
-    logInfo("Loading avatar model...");
+    AVATAR_LOG_INFO("Loading avatar model...");
 
     if (!g_scene.modelLoader) {
       throw std::runtime_error("Model loader not initialized");
@@ -189,43 +1048,101 @@ extern "C" EMSCRIPTEN_KEEPALIVE void loadAvatarModel(
 
     g_scene.registry->emplace<litland::RenderMesh>(
         g_scene.avatarEntity, model);
+    g_scene.avatarModel = model;
+
+    // Resolve lip-sync morph targets once so per-frame updates are indexed
+    for (int i = 0; i < 4; ++i) {
+      g_scene.morphTargetIndex[i] =
+          model->findMorphTarget(kMorphTargetNames[i]);
+      g_scene.morphWeights[i] = 0.0f;
+    }
+    g_scene.browMorphIndex = -1;
+    for (const char* name : kBrowMorphNames) {
+      g_scene.browMorphIndex = model->findMorphTarget(name);
+      if (g_scene.browMorphIndex >= 0) break;
+    }
 
     // Bind animator to avatar skeleton
     if (model->hasSkeleton()) {
       g_scene.animator->bindSkeleton(model->getSkeleton());
+      buildFlatSkeleton(model->getSkeleton());
     }
 
     // Add to scene
     g_scene.scene->addEntity(g_scene.avatarEntity,
         g_scene.registry->get<litland::Transform>(g_scene.avatarEntity));
 
-    logInfo("Avatar model loaded successfully");
+    AVATAR_LOG_INFO("Avatar model loaded successfully");
   } catch (const std::exception& e) {
-    logError(std::string("Failed to load avatar model: ") + e.what());
+    AVATAR_LOG_ERROR("Failed to load avatar model: %s", e.what());
   }
 }
 
 /**
- * Set animation state (idle, listening, speaking)
+ * Replace the animation graph with a JSON asset (see avatar-anim-graph.h)
+ * The text is compiled immediately and need not outlive the call. The
+ * current state is kept if the new graph has one of the same name.
+ * Returns 1 on success, 0 if the asset was rejected (old graph kept).
  */
-extern "C" EMSCRIPTEN_KEEPALIVE void setAnimationState(
-    const char* stateName) {
+extern "C" EMSCRIPTEN_KEEPALIVE int loadAnimationGraph(const char* json,
+                                                      uint32_t length) {
   try {
-    g_scene.currentAnimationState = stateName;
+    std::string error;
+    if (!g_scene.animGraph.compile(json, length, &error)) {
+      AVATAR_LOG_ERROR("Animation graph rejected: %s", error.c_str());
+      return 0;
+    }
+    const auto& graph = g_scene.animGraph;
+    g_scene.predictor.reset(graph.stateCount());
+    const int32_t state =
+        graph.findState(g_scene.currentAnimationState.c_str());
+    g_scene.animState = state >= 0 ? static_cast<uint32_t>(state) : 0;
+    if (!g_scene.skeleton.empty()) configureLayerSlots();
+    enterState(g_scene.animState);
 
-    if (g_scene.currentAnimationState == "idle") {
-      setupIdleAnimation();
-    } else if (g_scene.currentAnimationState == "listening") {
-      setupListeningAnimation();
-    } else if (g_scene.currentAnimationState == "speaking") {
-      setupSpeakingAnimation();
-    } else {
-      logError(std::string("Unknown animation state: ") + stateName);
+    AVATAR_LOG_INFO("Animation graph loaded: %u states, %u layers",
+                    graph.stateCount(), graph.layerCount());
+    return 1;
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error loading animation graph: %s", e.what());
+    return 0;
+  }
+}
+
+/**
+ * Set animation state by graph index (no string marshalling)
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void setAnimationStateIndex(uint32_t state) {
+  try {
+    if (state >= g_scene.animGraph.stateCount()) {
+      AVATAR_LOG_ERROR("Animation state index out of range: %u", state);
+      return;
     }
+    enterState(state);
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error setting animation state: %s", e.what());
+  }
+}
 
-    logInfo(std::string("Animation state changed to: ") + stateName);
+/**
+ * Set animation state by name (idle, listening, speaking, or any state
+ * in the loaded graph)
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void setAnimationState(
+    const char* stateName) {
+  try {
+    const int32_t state = g_scene.animGraph.findState(stateName);
+    if (state < 0) {
+      g_scene.currentAnimationState = stateName;
+      g_scene.stateBlock.animationState = avatar::kStateUnknown;
+      AVATAR_LOG_ERROR("Unknown animation state: %s", stateName);
+      return;
+    }
+    if (enterState(static_cast<uint32_t>(state))) {
+      AVATAR_LOG_DEBUG("Animation state changed to: %s", stateName);
+    }
   } catch (const std::exception& e) {
-    logError(std::string("Error setting animation state: ") + e.what());
+    AVATAR_LOG_ERROR("Error setting animation state: %s", e.what());
   }
 }
 
@@ -235,26 +1152,383 @@ extern "C" EMSCRIPTEN_KEEPALIVE void setAnimationState(
  */
 extern "C" EMSCRIPTEN_KEEPALIVE void updateFrame() {
   try {
+    auto& stats = g_scene.frameStats;
+    const double frameStart = emscripten_get_now();
+    if (stats.lastFrameStartMs > 0.0) {
+      stats.record(avatar::kFrameInterval, frameStart - stats.lastFrameStartMs);
+    }
+    stats.lastFrameStartMs = frameStart;
+
+    pollMicrophone();
+    pollSpeechStream();
+
     // Update animations
     if (g_scene.animator) {
-      g_scene.animator->update(1.0f / 60.0f); // Assuming 60 FPS
+      g_scene.animator->update(kAnimationStep);
+      advanceAnimationState(kAnimationStep);
+      g_scene.prosody.update(kAnimationStep);
+      if (!g_scene.skeleton.empty()) {
+        advanceLayers(kAnimationStep);
+        if (g_scene.avatarModel && avatarVisible()) evaluateSkeleton();
+      }
     }
+    applyVisemes(kAnimationStep);
+    const double animationEnd = emscripten_get_now();
+    stats.record(avatar::kPhaseAnimation, animationEnd - frameStart);
 
     // Update scene
     if (g_scene.scene) {
       g_scene.scene->update(1.0f / 60.0f);
     }
+    const double sceneEnd = emscripten_get_now();
+    stats.record(avatar::kPhaseSceneUpdate, sceneEnd - animationEnd);
 
     // Render scene
+    double renderEnd = sceneEnd;
     if (g_scene.graphicsDevice && g_scene.scene) {
       g_scene.graphicsDevice->beginFrame();
       g_scene.scene->render(g_scene.graphicsDevice.get());
+      if (g_scene.perfHud.enabled()) {
+        drawPerfHud();
+      }
       g_scene.graphicsDevice->endFrame();
+      renderEnd = emscripten_get_now();
       g_scene.graphicsDevice->present();
     }
+    const double frameEnd = emscripten_get_now();
+    g_scene.audioLatency.onPresent(frameEnd);
+    stats.record(avatar::kPhaseRender, renderEnd - sceneEnd);
+    stats.record(avatar::kPhasePresent, frameEnd - renderEnd);
+    stats.record(avatar::kFrameCpu, frameEnd - frameStart);
+
+    if (g_scene.quality.update(stats.lastMs[avatar::kFrameCpu])) {
+      AVATAR_LOG_INFO("Quality level %u (avg CPU %.1f ms)",
+                      g_scene.quality.level(), g_scene.quality.averageMs());
+    }
+
+    collectFrameCounters();
+
+    if (g_scene.animator && !g_scene.skeleton.empty() &&
+        stats.lastMs[avatar::kFrameCpu] < kPrefetchMaxFrameMs) {
+      prefetchPredictedStates();
+    }
+
+    if (g_scene.perfHud.enabled()) {
+      g_scene.perfHud.pushFrame(stats.lastMs[avatar::kFrameInterval],
+                                stats.lastMs);
+    }
+
+    publishStateBlock();
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error in update frame: %s", e.what());
+  }
+}
+
+/**
+ * Update lip-sync morph target weights
+ * Layout: [mouthOpen, mouthRound, eyesLookUp, eyesClose] as float32,
+ * already clamped to 0-1 by AvatarController. Weights are copied, so the
+ * caller may free the buffer immediately.
+ *
+ * audioTimeMs / analysisTimeMs are the performance.now() times at which
+ * the analysed audio is audible and was analysed (0 when the update is
+ * not audio-driven); they feed the audio-to-mouth latency histograms.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void updateMorphTargets(
+    const float* targets, double audioTimeMs, double analysisTimeMs) {
+  if (!targets) return;
+
+  g_scene.audioLatency.onMorphUpdate(audioTimeMs, analysisTimeMs,
+                                     emscripten_get_now());
+
+  for (int i = 0; i < 4; ++i) {
+    g_scene.morphWeights[i] = targets[i];
+    if (g_scene.avatarModel && g_scene.morphTargetIndex[i] >= 0) {
+      g_scene.avatarModel->setMorphTargetWeight(
+          g_scene.morphTargetIndex[i], targets[i]);
+    }
+  }
+}
+
+/**
+ * Get the engine-owned PCM input buffer (kAudioInputCapacity x float32)
+ * JS copies the speech samples played since the last frame here and
+ * passes the pointer to pushAudioSamples.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE float* getAudioInputBuffer() {
+  return g_scene.audioInput;
+}
+
+/**
+ * Feed mono speech PCM (-1..1) to the prosody analyser
+ * Analyses whole 10 ms hops as they complete; count is clamped to the
+ * input buffer capacity. sampleRate may change between calls (the
+ * analyser restarts when it does).
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void pushAudioSamples(const float* samples,
+                                                     uint32_t count,
+                                                     float sampleRate) {
+  try {
+    if (!samples || sampleRate <= 0.0f) return;
+    g_scene.prosody.configure(sampleRate);
+    g_scene.prosody.push(samples, std::min(count, kAudioInputCapacity));
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error pushing audio samples: %s", e.what());
+  }
+}
+
+/**
+ * Get the microphone PCM ring (avatar::PcmRing)
+ * JS writes mono samples and advances writeIndex through typed views;
+ * the engine runs voice activity detection on them each frame. Same
+ * lifetime rules as getEngineStateBlock.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE avatar::PcmRing* getMicrophoneRing() {
+  return &g_scene.micRing;
+}
+
+/**
+ * Plan the mouth for an utterance from its text (UTF-8, length bytes)
+ * Call as soon as the reply text is known; nothing moves until
+ * syncSpeechPlan. Replaces any previous plan. Returns the estimated
+ * duration in seconds, 0 if the text has nothing to say.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE float planSpeechText(const char* text,
+                                                    uint32_t length) {
+  try {
+    if (!text) length = 0;
+    return g_scene.visemes.plan(g_scene.g2p, text, length);
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error planning speech: %s", e.what());
+    return 0.0f;
+  }
+}
+
+/**
+ * Lock the planned utterance to playback: audioSeconds is the player's
+ * current time, durationSeconds the audio length (0 while unknown), which
+ * stretches the plan to fit unless alignSpeechPlan has retimed it. Call
+ * every frame or so while it plays; the plan fades out a quarter second
+ * after the last sync.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void syncSpeechPlan(double audioSeconds,
+                                                   double durationSeconds) {
+  g_scene.visemes.sync(static_cast<float>(audioSeconds),
+                       static_cast<float>(durationSeconds));
+}
+
+/**
+ * Retime the planned utterance to its decoded audio (mono, count samples
+ * at sampleRate) by forced alignment. Call once the synthesized audio is
+ * decoded, before or during playback; the keys then play at their
+ * aligned times instead of a uniform stretch. Returns the number of keys
+ * aligned, 0 if there was no plan or too little audio.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE int alignSpeechPlan(const float* samples,
+                                                    uint32_t count,
+                                                    float sampleRate) {
+  try {
+    auto& track = g_scene.visemes;
+    const double start = emscripten_get_now();
+    if (!g_scene.aligner.align(track.timeline(), samples, count,
+                               sampleRate)) {
+      return 0;
+    }
+    track.setAligned();
+    AVATAR_LOG_INFO("Speech plan aligned: %u keys over %.2f s in %.1f ms",
+                    static_cast<unsigned>(track.timeline().size()),
+                    track.timeline().seconds(),
+                    emscripten_get_now() - start);
+    return static_cast<int>(track.timeline().size());
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error aligning speech: %s", e.what());
+    return 0;
+  }
+}
+
+/**
+ * Copy the aligned plan's timing to out: each key's start, then the end
+ * of the last key (keys + 1 floats). Returns the floats written; 0 if
+ * the plan is not aligned yet or capacity is too small. The server
+ * caches this next to the audio it was aligned to.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getSpeechPlanTiming(
+    float* out, uint32_t capacity) {
+  const auto& track = g_scene.visemes;
+  const auto& timeline = track.timeline();
+  if (!out || !track.aligned() || timeline.empty() ||
+      capacity < timeline.size() + 1) {
+    return 0;
+  }
+  for (size_t i = 0; i < timeline.size(); ++i) {
+    out[i] = timeline.key(i).start;
+  }
+  out[timeline.size()] = timeline.seconds();
+  return static_cast<uint32_t>(timeline.size() + 1);
+}
+
+/**
+ * Retime the planned utterance from cached timing (the layout
+ * getSpeechPlanTiming writes) instead of aligning it again. Returns the
+ * number of keys retimed; 0 if the timing does not fit this plan (a
+ * different key count, or not ascending).
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE int setSpeechPlanTiming(const float* timing,
+                                                        uint32_t count) {
+  auto& track = g_scene.visemes;
+  const size_t keys = track.timeline().size();
+  if (!timing || keys == 0 || count != keys + 1) return 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!std::isfinite(timing[i]) || (i > 0 && timing[i] < timing[i - 1])) {
+      return 0;
+    }
+  }
+  track.timeline().retime(timing, timing[keys]);
+  track.setAligned();
+  AVATAR_LOG_INFO("Speech plan timing loaded: %u keys over %.2f s",
+                  static_cast<unsigned>(keys), track.timeline().seconds());
+  return static_cast<int>(keys);
+}
+
+/**
+ * Start a streamed reply (MP3), dropping any previous one
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void beginSpeechStream() {
+  g_scene.speech.reset();
+  g_scene.speechFrame = {nullptr, 0};
+  g_scene.speechProsodyFed = 0;
+  g_scene.speechSyncedPlayhead = 0.0;
+  g_scene.lipSync.reset();
+}
+
+/**
+ * Engine-owned input for encoded bytes (kSpeechByteCapacity); JS copies
+ * each fetch chunk here, in pieces if larger, and calls pushSpeechBytes
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint8_t* getSpeechByteInput() {
+  return g_scene.speechByteInput;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getSpeechByteCapacity() {
+  return kSpeechByteCapacity;
+}
+
+/**
+ * Append count bytes of the MP3 stream; returns frames ready to decode
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t pushSpeechBytes(const uint8_t* bytes,
+                                                        uint32_t count) {
+  try {
+    if (!bytes) return 0;
+    g_scene.speechFrame = {nullptr, 0};
+    return static_cast<uint32_t>(g_scene.speech.pushBytes(
+        bytes, std::min(count, kSpeechByteCapacity)));
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error pushing speech bytes: %s", e.what());
+    return 0;
+  }
+}
+
+/**
+ * The byte stream has ended; releases the last frame
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t endSpeechBytes() {
+  g_scene.speech.endBytes();
+  return static_cast<uint32_t>(g_scene.speech.framesReady());
+}
+
+/**
+ * Take the next whole frame to decode; returns its size in bytes (0 if
+ * none is ready). getSpeechFrame points at it until the next push.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t nextSpeechFrame() {
+  auto& frame = g_scene.speechFrame;
+  if (!g_scene.speech.nextFrame(frame)) frame = {nullptr, 0};
+  return frame.bytes;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE const uint8_t* getSpeechFrame() {
+  return g_scene.speechFrame.data;
+}
+
+/**
+ * Stream format for configuring the decoder; 0 until the first frame
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getSpeechSampleRate() {
+  return g_scene.speech.sampleRate();
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getSpeechChannels() {
+  return g_scene.speech.channels();
+}
+
+/**
+ * Engine-owned input for decoded PCM (kSpeechPcmCapacity x float32)
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE float* getSpeechPcmInput() {
+  return g_scene.speechPcmInput;
+}
+
+/**
+ * Append decoded mono PCM at getSpeechSampleRate(), in frame order
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void pushSpeechPcm(const float* samples,
+                                                  uint32_t count) {
+  try {
+    if (!samples) return;
+    g_scene.speech.pushPcm(samples, std::min(count, kSpeechPcmCapacity));
+  } catch (const std::exception& e) {
+    AVATAR_LOG_ERROR("Error pushing speech PCM: %s", e.what());
+  }
+}
+
+/**
+ * Every frame is decoded: the duration is now exact, and the viseme plan
+ * is aligned to the whole utterance unless that was already done.
+ * Returns the number of keys aligned.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE int endSpeechStream() {
+  try {
+    auto& speech = g_scene.speech;
+    speech.endPcm();
+    auto& track = g_scene.visemes;
+    if (track.aligned() || !speech.active()) return 0;
+    if (!g_scene.aligner.align(track.timeline(), speech.pcm(),
+                               speech.decodedSamples(),
+                               static_cast<float>(speech.sampleRate()))) {
+      return 0;
+    }
+    track.setAligned();
+    AVATAR_LOG_INFO("Streamed speech: %.2f s in %u frames, %u keys aligned",
+                    speech.durationSeconds(), speech.framesFound(),
+                    static_cast<unsigned>(track.timeline().size()));
+    return static_cast<int>(track.timeline().size());
   } catch (const std::exception& e) {
-    logError(std::string("Error in update frame: ") + e.what());
+    AVATAR_LOG_ERROR("Error ending speech stream: %s", e.what());
+    return 0;
+  }
+}
+
+/**
+ * Playback position of the streamed reply in seconds, from the player's
+ * audio clock; drives prosody, the viseme plan and the lookahead mouth
+ * each frame
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void setSpeechPlayhead(double seconds) {
+  g_scene.speech.setPlayhead(seconds);
+}
+
+/**
+ * The streamed reply stopped playing, finished or cut short. Its last
+ * playhead stays short of the lookahead mouth's release time, so this
+ * hands the mouth back to the speech plan and the <audio> path.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void endSpeechPlayback() {
+  if (g_scene.lipSync.owning()) {
+    AVATAR_LOG_INFO("Streamed lip-sync finished, %u underruns",
+                    g_scene.lipSync.buffer().underruns());
   }
+  g_scene.lipSync.release();
 }
 
 /**
@@ -280,8 +1554,9 @@ extern "C" EMSCRIPTEN_KEEPALIVE void setCanvasSize(int width, int height) {
           static_cast<float>(width) / static_cast<float>(height), 0.1f,
           100.0f);
     }
+    updateCameraFrustum();
   } catch (const std::exception& e) {
-    logError(std::string("Error setting canvas size: ") + e.what());
+    AVATAR_LOG_ERROR("Error setting canvas size: %s", e.what());
   }
 }
 
@@ -303,31 +1578,237 @@ extern "C" EMSCRIPTEN_KEEPALIVE float getFrameRate() {
   return 0.0f;
 }
 
+/**
+ * Get frame time percentiles for one phase since the last reset
+ * Returns a pointer to {p50, p90, p99, p99.9, max, count} as float32,
+ * times in milliseconds. The buffer is reused on every call.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const avatar::FrameTimePercentiles*
+getFrameTimeStats(int phase) {
+  if (phase < 0 || phase >= avatar::kFramePhaseCount) {
+    phase = avatar::kFrameInterval;
+  }
+  g_scene.frameStats.phases[phase].percentiles(g_scene.frameStatsSnapshot);
+  return &g_scene.frameStatsSnapshot;
+}
+
+/**
+ * Reset all frame time histograms
+ * Called by the telemetry sampler after each export
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void resetFrameTimeStats() {
+  g_scene.frameStats.reset();
+}
+
+/**
+ * Get audio-to-mouth latency percentiles for one stage (avatar::LatencyStage)
+ * Same {p50, p90, p99, p99.9, max, count} float32 layout as
+ * getFrameTimeStats, in milliseconds.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const avatar::FrameTimePercentiles*
+getAudioLatencyStats(int stage) {
+  if (stage < 0 || stage >= avatar::kLatencyStageCount) {
+    stage = avatar::kLatencyTotal;
+  }
+  g_scene.audioLatency.stage(stage).percentiles(
+      g_scene.audioLatencySnapshot);
+  return &g_scene.audioLatencySnapshot;
+}
+
+/**
+ * Recent per-frame total latency samples (float32 ms ring buffer)
+ * getAudioLatencySampleCapacity() gives the ring's length,
+ * getAudioLatencySampleCount() the number of valid entries and
+ * getAudioLatencySampleHead() the total written, so JS can unwrap the ring.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const float* getAudioLatencySamples() {
+  return g_scene.audioLatency.recent();
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getAudioLatencySampleCapacity() {
+  return avatar::AudioMouthLatency::kRecentCapacity;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getAudioLatencySampleCount() {
+  return g_scene.audioLatency.recentCount();
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getAudioLatencySampleHead() {
+  return g_scene.audioLatency.recentHead();
+}
+
+/**
+ * Reset audio-to-mouth latency histograms and samples
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void resetAudioLatencyStats() {
+  g_scene.audioLatency.reset();
+}
+
+/**
+ * Get the engine state block (avatar::EngineStateBlock)
+ * The address is stable for the module's lifetime; JS keeps typed views
+ * over it and only recreates them when linear memory grows.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const avatar::EngineStateBlock*
+getEngineStateBlock() {
+  return &g_scene.stateBlock;
+}
+
+/**
+ * Get the engine control block (avatar::EngineControlBlock)
+ * JS writes look-at targets here through typed views; the engine reads
+ * them once per frame. Same lifetime rules as getEngineStateBlock.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE avatar::EngineControlBlock*
+getEngineControlBlock() {
+  return &g_scene.controlBlock;
+}
+
+/**
+ * Get the engine-owned morph input buffer (4 x float32)
+ * JS writes weights here and passes the pointer to updateMorphTargets,
+ * avoiding a malloc/free pair per frame.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE float* getMorphInputBuffer() {
+  return g_scene.morphInput;
+}
+
+/**
+ * Get the work counters for the last rendered frame
+ * Returns a pointer to avatar::FrameCounters (11 x uint32)
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const avatar::FrameCounters*
+getFrameCounters() {
+  return &g_scene.counters;
+}
+
+/**
+ * Get engine memory usage by category (avatar::MemoryCategory)
+ * Returns a pointer to kMemoryCategoryCount uint32 byte counts
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const avatar::MemoryStats* getMemoryStats() {
+  return &collectMemoryStats();
+}
+
+/**
+ * Show or hide the in-engine perf HUD overlay
+ * Costs one branch per frame while hidden.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE void setPerfHudEnabled(int enabled) {
+  g_scene.perfHud.setEnabled(enabled != 0);
+}
+
+/**
+ * Drain pending log records into the drain buffer
+ * Returns the record count; records are read via getLogBuffer().
+ * Called by AvatarController once per frame and after lifecycle calls.
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t drainLog() {
+  return avatar::log::ring().drain();
+}
+
+/**
+ * Pointer to the drained log records (avatar::log::LogRecord[])
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE const avatar::log::LogRecord* getLogBuffer() {
+  return avatar::log::ring().drainBuffer();
+}
+
+/**
+ * Number of records overwritten since the last call
+ */
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t getLogDroppedCount() {
+  return avatar::log::ring().takeDropped();
+}
+
 /**
  * Cleanup and shutdown
  */
 extern "C" EMSCRIPTEN_KEEPALIVE void cleanup() {
   try {
-    logInfo("Cleaning up avatar scene...");
+    AVATAR_LOG_INFO("Cleaning up avatar scene...");
 
     // Cleanup in reverse order
+    g_scene.perfHud.setEnabled(false);
+    g_scene.perfHudAtlas.reset();
+    if (g_scene.scene && g_scene.avatarModel) {
+      g_scene.scene->removeEntity(g_scene.avatarEntity);
+    }
+    g_scene.avatarEntity = litland::ECS::Entity{};
+    g_scene.avatarModel.reset();
+    g_scene.skeleton = avatar::FlatSkeleton{};  // releases capacity too
+    g_scene.animGraph = avatar::AnimationGraph{};
+    g_scene.predictor = avatar::TransitionPredictor{};
+    g_scene.animState = 0;
+    g_scene.stateTime = 0.0f;
+    for (int c = 0; c < avatar::kProceduralCount; ++c) {
+      g_scene.procedural[c] = g_scene.proceduralTarget[c] = 0.0f;
+    }
+    g_scene.proceduralFadeRate = 0.0f;
+    g_scene.layers = std::vector<AnimationLayerSlot>{};
+    g_scene.poseLayers = std::vector<avatar::PoseLayer>{};
+    g_scene.restPose = avatar::PoseBuffer{};
+    g_scene.blendedPose = avatar::PoseBuffer{};
+    g_scene.headMask = avatar::BoneMask{};
+    g_scene.sampleScratch = std::vector<litland::JointPose>{};
     g_scene.registry.reset();
     g_scene.animator.reset();
     g_scene.modelLoader.reset();
     g_scene.scene.reset();
     g_scene.graphicsDevice.reset();
 
-    logInfo("Cleanup complete");
+    // Reset per-session state so a re-init starts from the same place
+    // as a fresh module (remounts call initScene/cleanup repeatedly)
+    g_scene.currentAnimationState = "idle";
+    for (int i = 0; i < 4; ++i) {
+      g_scene.morphTargetIndex[i] = -1;
+      g_scene.morphWeights[i] = 0.0f;
+      g_scene.morphInput[i] = 0.0f;
+    }
+    g_scene.frameStats.reset();
+    g_scene.frameStats.lastFrameStartMs = 0.0;
+    g_scene.counters = avatar::FrameCounters{};
+    g_scene.audioLatency.reset();
+    g_scene.stateBlock = avatar::EngineStateBlock{};
+    g_scene.controlBlock = avatar::EngineControlBlock{};
+    g_scene.lookAt = avatar::LookAtSolver{};
+    g_scene.quality.reset();
+    g_scene.springClock.reset();
+    g_scene.springBones = avatar::SpringBones{};
+    g_scene.springWeight = 0.0f;
+    g_scene.springCostMs = 0.0f;
+    g_scene.springOverBudget = false;
+    g_scene.springRearm = 0;
+    g_scene.prosody = avatar::ProsodyAnalyzer{};
+    std::fill(std::begin(g_scene.audioInput), std::end(g_scene.audioInput),
+              0.0f);
+    g_scene.browMorphIndex = -1;
+    g_scene.micRing.reset();
+    g_scene.vad = avatar::VoiceActivityDetector{};
+    g_scene.vadListening = false;
+    g_scene.visemes.reset();
+    g_scene.aligner = avatar::SpeechAligner{};
+    g_scene.speech.reset();
+    g_scene.speechFrame = {nullptr, 0};
+    g_scene.speechProsodyFed = 0;
+    g_scene.speechSyncedPlayhead = 0.0;
+    g_scene.lipSync = avatar::LookaheadLipSync{};
+    g_scene.lipSyncShown = false;
+
+    AVATAR_LOG_INFO("Cleanup complete");
   } catch (const std::exception& e) {
-    logError(std::string("Error during cleanup: ") + e.what());
+    AVATAR_LOG_ERROR("Error during cleanup: %s", e.what());
   }
 }
 
 /**
  * WebAssembly Module Initialization
  * Called automatically when the .wasm module loads
+ * (native harnesses provide their own main)
  */
+#ifndef AVATAR_NATIVE_HARNESS
 int main() {
-  logInfo("LIT-LAND Avatar Engine starting...");
+  AVATAR_LOG_INFO("LIT-LAND Avatar Engine starting...");
   return 0;
 }
+#endif
@@ -0,0 +1,65 @@
+/**
+ * avatar-sim-clock.h - Fixed-step clock for simulations
+ *
+ * Accumulates real frame time and hands out whole fixed steps, so a
+ * simulation (spring bones) behaves the same at 30, 60 or 144 Hz. Steps
+ * per frame are capped. After a stall the backlog is dropped and the
+ * simulation runs slow for that frame; it does not spiral.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace avatar {
+
+class SimClock {
+ public:
+  explicit SimClock(float step = 1.0f / 120.0f, uint32_t maxSteps = 4)
+      : step_(step), maxSteps_(maxSteps) {}
+
+  float step() const { return step_; }
+  uint32_t maxSteps() const { return maxSteps_; }
+  void setMaxSteps(uint32_t maxSteps) { maxSteps_ = maxSteps; }
+
+  /**
+   * Add dt seconds of real time; returns the number of steps to run now
+   */
+  uint32_t advance(float dt) {
+    if (dt > 0.0f) accumulator_ += dt;
+    uint32_t steps = static_cast<uint32_t>(accumulator_ / step_);
+    if (steps > maxSteps_) {
+      steps = maxSteps_;
+      dropped_ += static_cast<uint32_t>(accumulator_ / step_) - steps;
+      accumulator_ = std::fmod(accumulator_, step_);
+    } else {
+      accumulator_ -= static_cast<float>(steps) * step_;
+    }
+    total_ += steps;
+    return steps;
+  }
+
+  /**
+   * Fraction of a step left in the accumulator, for interpolation
+   */
+  float alpha() const { return accumulator_ / step_; }
+
+  uint64_t totalSteps() const { return total_; }
+  uint64_t droppedSteps() const { return dropped_; }
+
+  void reset() {
+    accumulator_ = 0.0f;
+    total_ = 0;
+    dropped_ = 0;
+  }
+
+ private:
+  float step_;
+  uint32_t maxSteps_;
+  float accumulator_{0.0f};
+  uint64_t total_{0};
+  uint64_t dropped_{0};
+};
+
+}  // namespace avatar
@@ -0,0 +1,50 @@
+/**
+ * avatar-simd-glm.h - Conversions between glm and avatar::simd types
+ *
+ * For the API boundary only (LIT-LAND calls, camera setup); engine hot
+ * paths stay in avatar::simd.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "avatar-simd.h"
+
+namespace avatar {
+namespace simd {
+
+inline Vec4 fromGlm(const glm::vec3& v, float w = 0.0f) {
+  return Vec4::make(v.x, v.y, v.z, w);
+}
+
+inline Quat fromGlm(const glm::quat& q) {
+  return Quat::make(q.x, q.y, q.z, q.w);
+}
+
+inline Mat4 fromGlm(const glm::mat4& m) {
+  return {{set(m[0][0], m[0][1], m[0][2], m[0][3]),
+           set(m[1][0], m[1][1], m[1][2], m[1][3]),
+           set(m[2][0], m[2][1], m[2][2], m[2][3]),
+           set(m[3][0], m[3][1], m[3][2], m[3][3])}};
+}
+
+inline glm::mat4 toGlm(const Mat4& m) {
+  float c[16];
+  m.store(c);
+  glm::mat4 r(1.0f);
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 4; ++j) r[i][j] = c[i * 4 + j];
+  }
+  return r;
+}
+
+inline glm::quat toGlm(Quat q) {
+  float v[4];
+  store(v, q.v);
+  return glm::quat(v[3], v[0], v[1], v[2]);
+}
+
+}  // namespace simd
+}  // namespace avatar
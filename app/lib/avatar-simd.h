@@ -0,0 +1,582 @@
+/**
+ * avatar-simd.h - Small 4-wide SIMD math layer for engine hot paths
+ *
+ * Vec4 / Quat / Mat4 over one 128-bit register type, mapped to WASM
+ * SIMD128 (build with -msimd128), SSE on x86 or NEON on ARM, with a
+ * scalar fallback (forced with -DAVATAR_SIMD_FORCE_SCALAR). Mat4 is
+ * column-major with the same layout as glm::mat4, so arrays of it can be
+ * handed to the renderer directly.
+ *
+ * Used by pose evaluation, the skeleton world/skinning passes and
+ * avatar culling. glm stays at the API boundary (LIT-LAND calls, camera
+ * setup); see avatar-simd-glm.h for the conversions.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(AVATAR_SIMD_FORCE_SCALAR)
+#define AVATAR_SIMD_SCALAR 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define AVATAR_SIMD_WASM 1
+#elif defined(__SSE__) || defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define AVATAR_SIMD_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AVATAR_SIMD_NEON 1
+#else
+#define AVATAR_SIMD_SCALAR 1
+#endif
+
+namespace avatar {
+namespace simd {
+
+#if defined(AVATAR_SIMD_WASM)
+using f32x4 = v128_t;
+#elif defined(AVATAR_SIMD_SSE)
+using f32x4 = __m128;
+#elif defined(AVATAR_SIMD_NEON)
+using f32x4 = float32x4_t;
+#else
+struct alignas(16) f32x4 {
+  float v[4];
+};
+#endif
+
+inline const char* backendName() {
+#if defined(AVATAR_SIMD_WASM)
+  return "wasm-simd128";
+#elif defined(AVATAR_SIMD_SSE)
+  return "sse";
+#elif defined(AVATAR_SIMD_NEON)
+  return "neon";
+#else
+  return "scalar";
+#endif
+}
+
+// Register-level primitives -----------------------------------------------
+
+inline f32x4 load(const float* p) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_v128_load(p);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_loadu_ps(p);
+#elif defined(AVATAR_SIMD_NEON)
+  return vld1q_f32(p);
+#else
+  f32x4 r;
+  std::memcpy(r.v, p, sizeof(r.v));
+  return r;
+#endif
+}
+
+inline void store(float* p, f32x4 a) {
+#if defined(AVATAR_SIMD_WASM)
+  wasm_v128_store(p, a);
+#elif defined(AVATAR_SIMD_SSE)
+  _mm_storeu_ps(p, a);
+#elif defined(AVATAR_SIMD_NEON)
+  vst1q_f32(p, a);
+#else
+  std::memcpy(p, a.v, sizeof(a.v));
+#endif
+}
+
+inline f32x4 set(float x, float y, float z, float w) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_f32x4_make(x, y, z, w);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_setr_ps(x, y, z, w);
+#else
+  const float v[4] = {x, y, z, w};
+  return load(v);
+#endif
+}
+
+inline f32x4 splat(float s) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_f32x4_splat(s);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_set1_ps(s);
+#elif defined(AVATAR_SIMD_NEON)
+  return vdupq_n_f32(s);
+#else
+  return f32x4{{s, s, s, s}};
+#endif
+}
+
+#define AVATAR_SIMD_BINARY(name, wasm, sse, neon, op)                    \
+  inline f32x4 name(f32x4 a, f32x4 b) {                                  \
+    AVATAR_SIMD_BINARY_BODY(wasm, sse, neon, op)                         \
+  }
+
+#if defined(AVATAR_SIMD_WASM)
+#define AVATAR_SIMD_BINARY_BODY(wasm, sse, neon, op) return wasm(a, b);
+#elif defined(AVATAR_SIMD_SSE)
+#define AVATAR_SIMD_BINARY_BODY(wasm, sse, neon, op) return sse(a, b);
+#elif defined(AVATAR_SIMD_NEON)
+#define AVATAR_SIMD_BINARY_BODY(wasm, sse, neon, op) return neon(a, b);
+#else
+#define AVATAR_SIMD_BINARY_BODY(wasm, sse, neon, op)                     \
+  f32x4 r;                                                               \
+  for (int i = 0; i < 4; ++i) r.v[i] = op(a.v[i], b.v[i]);               \
+  return r;
+#endif
+
+namespace detail {
+inline float addOp(float a, float b) { return a + b; }
+inline float subOp(float a, float b) { return a - b; }
+inline float mulOp(float a, float b) { return a * b; }
+inline float minOp(float a, float b) { return a < b ? a : b; }
+inline float maxOp(float a, float b) { return a > b ? a : b; }
+}  // namespace detail
+
+AVATAR_SIMD_BINARY(add, wasm_f32x4_add, _mm_add_ps, vaddq_f32, detail::addOp)
+AVATAR_SIMD_BINARY(sub, wasm_f32x4_sub, _mm_sub_ps, vsubq_f32, detail::subOp)
+AVATAR_SIMD_BINARY(mul, wasm_f32x4_mul, _mm_mul_ps, vmulq_f32, detail::mulOp)
+AVATAR_SIMD_BINARY(min, wasm_f32x4_min, _mm_min_ps, vminq_f32, detail::minOp)
+AVATAR_SIMD_BINARY(max, wasm_f32x4_max, _mm_max_ps, vmaxq_f32, detail::maxOp)
+
+#undef AVATAR_SIMD_BINARY
+#undef AVATAR_SIMD_BINARY_BODY
+
+inline f32x4 div(f32x4 a, f32x4 b) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_f32x4_div(a, b);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_div_ps(a, b);
+#elif defined(AVATAR_SIMD_NEON) && defined(__aarch64__)
+  return vdivq_f32(a, b);
+#else
+  float va[4], vb[4];
+  store(va, a);
+  store(vb, b);
+  for (int i = 0; i < 4; ++i) va[i] /= vb[i];
+  return load(va);
+#endif
+}
+
+inline f32x4 sqrt(f32x4 a) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_f32x4_sqrt(a);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_sqrt_ps(a);
+#elif defined(AVATAR_SIMD_NEON) && defined(__aarch64__)
+  return vsqrtq_f32(a);
+#else
+  float v[4];
+  store(v, a);
+  for (float& x : v) x = std::sqrt(x);
+  return load(v);
+#endif
+}
+
+/**
+ * Lane-wise mask (all bits set where a < b), for select()
+ */
+inline f32x4 less(f32x4 a, f32x4 b) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_f32x4_lt(a, b);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_cmplt_ps(a, b);
+#elif defined(AVATAR_SIMD_NEON)
+  return vreinterpretq_f32_u32(vcltq_f32(a, b));
+#else
+  f32x4 r;
+  for (int i = 0; i < 4; ++i) {
+    const uint32_t bits = a.v[i] < b.v[i] ? 0xFFFFFFFFu : 0u;
+    std::memcpy(&r.v[i], &bits, sizeof(bits));
+  }
+  return r;
+#endif
+}
+
+/**
+ * mask ? a : b per lane (mask from less())
+ */
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_v128_bitselect(a, b, mask);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+#elif defined(AVATAR_SIMD_NEON)
+  return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+#else
+  f32x4 r;
+  for (int i = 0; i < 4; ++i) {
+    uint32_t m, x, y;
+    std::memcpy(&m, &mask.v[i], 4);
+    std::memcpy(&x, &a.v[i], 4);
+    std::memcpy(&y, &b.v[i], 4);
+    const uint32_t bits = (m & x) | (~m & y);
+    std::memcpy(&r.v[i], &bits, 4);
+  }
+  return r;
+#endif
+}
+
+/**
+ * a * b + c (fused where the target has it)
+ */
+inline f32x4 madd(f32x4 a, f32x4 b, f32x4 c) {
+#if defined(AVATAR_SIMD_NEON) && defined(__aarch64__)
+  return vfmaq_f32(c, a, b);
+#else
+  return add(mul(a, b), c);
+#endif
+}
+
+/**
+ * Lanes (a[X], a[Y], a[Z], a[W])
+ */
+template <int X, int Y, int Z, int W>
+inline f32x4 shuffle(f32x4 a) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_i32x4_shuffle(a, a, X, Y, Z, W);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_shuffle_ps(a, a, _MM_SHUFFLE(W, Z, Y, X));
+#elif defined(AVATAR_SIMD_NEON) && defined(__clang__)
+  return __builtin_shufflevector(a, a, X, Y, Z, W);
+#else
+  float v[4], r[4];
+  store(v, a);
+  r[0] = v[X], r[1] = v[Y], r[2] = v[Z], r[3] = v[W];
+  return load(r);
+#endif
+}
+
+template <int I>
+inline f32x4 broadcast(f32x4 a) {
+#if defined(AVATAR_SIMD_NEON) && defined(__aarch64__)
+  return vdupq_laneq_f32(a, I);
+#else
+  return shuffle<I, I, I, I>(a);
+#endif
+}
+
+template <int I>
+inline float lane(f32x4 a) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_f32x4_extract_lane(a, I);
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_cvtss_f32(shuffle<I, I, I, I>(a));
+#elif defined(AVATAR_SIMD_NEON)
+  return vgetq_lane_f32(a, I);
+#else
+  return a.v[I];
+#endif
+}
+
+/**
+ * Horizontal sum of all four lanes, broadcast to every lane
+ */
+inline f32x4 hsum(f32x4 a) {
+  const f32x4 t = add(a, shuffle<1, 0, 3, 2>(a));
+  return add(t, shuffle<2, 3, 0, 1>(t));
+}
+
+/**
+ * Bitmask of lanes where a < b (bit i = lane i)
+ */
+inline int lessMask(f32x4 a, f32x4 b) {
+#if defined(AVATAR_SIMD_WASM)
+  return wasm_i32x4_bitmask(wasm_f32x4_lt(a, b));
+#elif defined(AVATAR_SIMD_SSE)
+  return _mm_movemask_ps(_mm_cmplt_ps(a, b));
+#else
+  float va[4], vb[4];
+  store(va, a);
+  store(vb, b);
+  int mask = 0;
+  for (int i = 0; i < 4; ++i) mask |= (va[i] < vb[i]) << i;
+  return mask;
+#endif
+}
+
+// Vec4 / Quat ---------------------------------------------------------------
+
+struct Vec4 {
+  f32x4 v;
+
+  static Vec4 zero() { return {splat(0.0f)}; }
+  static Vec4 make(float x, float y, float z, float w) {
+    return {set(x, y, z, w)};
+  }
+  static Vec4 load(const float* p) { return {simd::load(p)}; }
+  void store(float* p) const { simd::store(p, v); }
+
+  float x() const { return lane<0>(v); }
+  float y() const { return lane<1>(v); }
+  float z() const { return lane<2>(v); }
+  float w() const { return lane<3>(v); }
+};
+
+inline Vec4 operator+(Vec4 a, Vec4 b) { return {add(a.v, b.v)}; }
+inline Vec4 operator-(Vec4 a, Vec4 b) { return {sub(a.v, b.v)}; }
+inline Vec4 operator*(Vec4 a, Vec4 b) { return {mul(a.v, b.v)}; }
+inline Vec4 operator*(Vec4 a, float s) { return {mul(a.v, splat(s))}; }
+
+inline float dot(Vec4 a, Vec4 b) { return lane<0>(hsum(mul(a.v, b.v))); }
+
+/**
+ * a + (b - a) * t
+ */
+inline Vec4 lerp(Vec4 a, Vec4 b, float t) {
+  return {madd(sub(b.v, a.v), splat(t), a.v)};
+}
+
+// Quaternions are stored (x, y, z, w), the same as glm::quat's members
+struct Quat {
+  f32x4 v;
+
+  static Quat identity() { return {set(0.0f, 0.0f, 0.0f, 1.0f)}; }
+  static Quat make(float x, float y, float z, float w) {
+    return {set(x, y, z, w)};
+  }
+};
+
+/**
+ * Hamilton product a * b (apply b, then a)
+ */
+inline Quat operator*(Quat a, Quat b) {
+  const f32x4 b1 = mul(shuffle<3, 2, 1, 0>(b.v), set(1, -1, 1, -1));
+  const f32x4 b2 = mul(shuffle<2, 3, 0, 1>(b.v), set(1, 1, -1, -1));
+  const f32x4 b3 = mul(shuffle<1, 0, 3, 2>(b.v), set(-1, 1, 1, -1));
+  f32x4 r = mul(broadcast<3>(a.v), b.v);
+  r = madd(broadcast<0>(a.v), b1, r);
+  r = madd(broadcast<1>(a.v), b2, r);
+  r = madd(broadcast<2>(a.v), b3, r);
+  return {r};
+}
+
+inline Quat normalize(Quat q) {
+  const float len2 = lane<0>(hsum(mul(q.v, q.v)));
+  const float inv = len2 > 0.0f ? 1.0f / std::sqrt(len2) : 0.0f;
+  return {mul(q.v, splat(inv))};
+}
+
+inline Quat conjugate(Quat q) { return {mul(q.v, set(-1, -1, -1, 1))}; }
+
+/**
+ * Rotation of `angle` radians about a unit axis
+ */
+inline Quat fromAxisAngle(float ax, float ay, float az, float angle) {
+  const float s = std::sin(0.5f * angle);
+  return {set(ax * s, ay * s, az * s, std::cos(0.5f * angle))};
+}
+
+/**
+ * Shortest rotation taking direction `from` to direction `to` (xyz; need
+ * not be unit length). Identity if either is degenerate.
+ */
+inline Quat rotationBetween(Vec4 from, Vec4 to) {
+  float a[4], b[4];
+  store(a, from.v);
+  store(b, to.v);
+  const float la = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+  const float lb = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+  if (la < 1e-8f || lb < 1e-8f) return Quat::identity();
+  for (int i = 0; i < 3; ++i) {
+    a[i] /= la;
+    b[i] /= lb;
+  }
+  const float d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  if (d < -0.99999f) {
+    // Opposite: half turn about any axis perpendicular to `from`
+    const bool useX = std::fabs(a[0]) < 0.9f;
+    const float px = useX ? 0.0f : -a[2], py = useX ? a[2] : 0.0f,
+                pz = useX ? -a[1] : a[0];
+    return normalize(Quat::make(px, py, pz, 0.0f));
+  }
+  return normalize(Quat::make(a[1] * b[2] - a[2] * b[1],
+                              a[2] * b[0] - a[0] * b[2],
+                              a[0] * b[1] - a[1] * b[0], 1.0f + d));
+}
+
+/**
+ * Normalized lerp along the shorter arc; the blend primitive for poses
+ */
+inline Quat nlerp(Quat a, Quat b, float t) {
+  const float d = lane<0>(hsum(mul(a.v, b.v)));
+  const f32x4 target = d < 0.0f ? mul(b.v, splat(-1.0f)) : b.v;
+  return normalize({madd(sub(target, a.v), splat(t), a.v)});
+}
+
+// Mat4 ------------------------------------------------------------------------
+
+struct alignas(16) Mat4 {
+  f32x4 col[4];
+
+  static Mat4 identity() {
+    return {{set(1, 0, 0, 0), set(0, 1, 0, 0), set(0, 0, 1, 0),
+             set(0, 0, 0, 1)}};
+  }
+  static Mat4 load(const float* p) {
+    return {{simd::load(p), simd::load(p + 4), simd::load(p + 8),
+             simd::load(p + 12)}};
+  }
+  void store(float* p) const {
+    for (int c = 0; c < 4; ++c) simd::store(p + 4 * c, col[c]);
+  }
+};
+
+static_assert(sizeof(Mat4) == 16 * sizeof(float),
+              "Mat4 must match glm::mat4's layout");
+
+inline f32x4 transform(const Mat4& m, f32x4 v) {
+  f32x4 r = mul(m.col[0], broadcast<0>(v));
+  r = madd(m.col[1], broadcast<1>(v), r);
+  r = madd(m.col[2], broadcast<2>(v), r);
+  return madd(m.col[3], broadcast<3>(v), r);
+}
+
+inline Vec4 operator*(const Mat4& m, Vec4 v) { return {transform(m, v.v)}; }
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b) {
+  return {{transform(a, b.col[0]), transform(a, b.col[1]),
+           transform(a, b.col[2]), transform(a, b.col[3])}};
+}
+
+/**
+ * T * R * S from translation (w ignored), unit quaternion and scale
+ */
+inline Mat4 compose(Vec4 translation, Quat rotation, Vec4 scale) {
+  float q[4];
+  simd::store(q, rotation.v);
+  const float x = q[0], y = q[1], z = q[2], w = q[3];
+  const float xx = x * x, yy = y * y, zz = z * z;
+  const float xy = x * y, xz = x * z, yz = y * z;
+  const float wx = w * x, wy = w * y, wz = w * z;
+
+  Mat4 m;
+  m.col[0] = mul(set(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz),
+                     2.0f * (xz - wy), 0.0f),
+                 broadcast<0>(scale.v));
+  m.col[1] = mul(set(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz),
+                     2.0f * (yz + wx), 0.0f),
+                 broadcast<1>(scale.v));
+  m.col[2] = mul(set(2.0f * (xz + wy), 2.0f * (yz - wx),
+                     1.0f - 2.0f * (xx + yy), 0.0f),
+                 broadcast<2>(scale.v));
+  // Translation column with w forced to 1
+  m.col[3] = madd(translation.v, set(1, 1, 1, 0), set(0, 0, 0, 1));
+  return m;
+}
+
+/**
+ * Rotation part of an affine matrix (columns normalized, so scale is
+ * dropped; shear is not supported)
+ */
+inline Quat rotationOf(const Mat4& m) {
+  float c[3][4];
+  for (int i = 0; i < 3; ++i) {
+    simd::store(c[i], m.col[i]);
+    const float len =
+        std::sqrt(c[i][0] * c[i][0] + c[i][1] * c[i][1] + c[i][2] * c[i][2]);
+    const float inv = len > 0.0f ? 1.0f / len : 0.0f;
+    for (int k = 0; k < 3; ++k) c[i][k] *= inv;
+  }
+  // c[col][row]; pick the largest diagonal term for stability
+  const float trace = c[0][0] + c[1][1] + c[2][2];
+  float x, y, z, w;
+  if (trace > 0.0f) {
+    const float s = 2.0f * std::sqrt(trace + 1.0f);
+    w = 0.25f * s;
+    x = (c[1][2] - c[2][1]) / s;
+    y = (c[2][0] - c[0][2]) / s;
+    z = (c[0][1] - c[1][0]) / s;
+  } else if (c[0][0] > c[1][1] && c[0][0] > c[2][2]) {
+    const float s = 2.0f * std::sqrt(1.0f + c[0][0] - c[1][1] - c[2][2]);
+    w = (c[1][2] - c[2][1]) / s;
+    x = 0.25f * s;
+    y = (c[1][0] + c[0][1]) / s;
+    z = (c[2][0] + c[0][2]) / s;
+  } else if (c[1][1] > c[2][2]) {
+    const float s = 2.0f * std::sqrt(1.0f + c[1][1] - c[0][0] - c[2][2]);
+    w = (c[2][0] - c[0][2]) / s;
+    x = (c[1][0] + c[0][1]) / s;
+    y = 0.25f * s;
+    z = (c[2][1] + c[1][2]) / s;
+  } else {
+    const float s = 2.0f * std::sqrt(1.0f + c[2][2] - c[0][0] - c[1][1]);
+    w = (c[0][1] - c[1][0]) / s;
+    x = (c[2][0] + c[0][2]) / s;
+    y = (c[2][1] + c[1][2]) / s;
+    z = 0.25f * s;
+  }
+  return normalize(Quat::make(x, y, z, w));
+}
+
+// Culling ---------------------------------------------------------------------
+
+/**
+ * Six frustum planes in SoA form, four planes per register
+ * Planes point inward: a point is inside when n.p + d >= 0 for all.
+ */
+struct Frustum {
+  f32x4 nx[2], ny[2], nz[2], d[2];
+
+  /**
+   * Extract from a column-major view-projection matrix (Gribb-Hartmann)
+   */
+  static Frustum fromViewProjection(const Mat4& m) {
+    float c[16];
+    m.store(c);
+    auto row = [&](int r, int i) { return c[i * 4 + r]; };
+    float planes[8][4];
+    for (int i = 0; i < 4; ++i) {
+      planes[0][i] = row(3, i) + row(0, i);  // left
+      planes[1][i] = row(3, i) - row(0, i);  // right
+      planes[2][i] = row(3, i) + row(1, i);  // bottom
+      planes[3][i] = row(3, i) - row(1, i);  // top
+      planes[4][i] = row(3, i) + row(2, i);  // near
+      planes[5][i] = row(3, i) - row(2, i);  // far
+    }
+    for (int p = 0; p < 6; ++p) {
+      const float len = std::sqrt(planes[p][0] * planes[p][0] +
+                                  planes[p][1] * planes[p][1] +
+                                  planes[p][2] * planes[p][2]);
+      const float inv = len > 0.0f ? 1.0f / len : 0.0f;
+      for (int i = 0; i < 4; ++i) planes[p][i] *= inv;
+    }
+    // Pad the second group by repeating planes, which never culls more
+    for (int i = 0; i < 4; ++i) {
+      planes[6][i] = planes[4][i];
+      planes[7][i] = planes[5][i];
+    }
+
+    Frustum f;
+    for (int g = 0; g < 2; ++g) {
+      const float(*p)[4] = planes + g * 4;
+      f.nx[g] = set(p[0][0], p[1][0], p[2][0], p[3][0]);
+      f.ny[g] = set(p[0][1], p[1][1], p[2][1], p[3][1]);
+      f.nz[g] = set(p[0][2], p[1][2], p[2][2], p[3][2]);
+      f.d[g] = set(p[0][3], p[1][3], p[2][3], p[3][3]);
+    }
+    return f;
+  }
+
+  /**
+   * False when the sphere is entirely outside any plane
+   */
+  bool sphereVisible(float x, float y, float z, float radius) const {
+    const f32x4 px = splat(x), py = splat(y), pz = splat(z);
+    const f32x4 negR = splat(-radius);
+    for (int g = 0; g < 2; ++g) {
+      f32x4 dist = madd(nx[g], px, d[g]);
+      dist = madd(ny[g], py, dist);
+      dist = madd(nz[g], pz, dist);
+      if (lessMask(dist, negR)) return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace simd
+}  // namespace avatar
@@ -0,0 +1,217 @@
+/**
+ * avatar-skeleton.h - Flattened, parent-before-child skeleton
+ *
+ * Built once at load from the model's joint parent indices. Joints are
+ * reordered depth-first (pre-order), so every parent precedes its
+ * children and each subtree is a contiguous range. World transforms are
+ * then one linear pass over packed arrays, with no pointer chasing:
+ *
+ *   world[i] = world[parent[i]] * local[i]
+ *
+ * Local poses are written and skinning matrices are read in the model's
+ * joint order (the order JOINTS_0 indexes), and the flat order is purely
+ * internal. Matrices are avatar::simd::Mat4 (glm::mat4 layout).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "avatar-simd.h"
+
+namespace avatar {
+
+struct BoneTransform {
+  simd::Vec4 translation = simd::Vec4::zero();
+  simd::Quat rotation = simd::Quat::identity();
+  simd::Vec4 scale = simd::Vec4::make(1.0f, 1.0f, 1.0f, 0.0f);
+};
+
+inline simd::Mat4 composeTransform(const BoneTransform& t) {
+  return simd::compose(t.translation, t.rotation, t.scale);
+}
+
+class FlatSkeleton {
+ public:
+  static constexpr int32_t kNoParent = -1;
+
+  /**
+   * Build the flat order from per-joint parent indices (model order)
+   * Returns false, leaving the skeleton empty, if a parent index is out of
+   * range or the parents contain a cycle.
+   */
+  bool build(const int32_t* parents, size_t count) {
+    clear();
+    if (count == 0) return true;
+
+    // Children grouped per parent (counting sort keeps model order)
+    std::vector<uint32_t> childStart(count + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+      const int32_t p = parents[i];
+      if (p == kNoParent) continue;
+      if (p < 0 || static_cast<size_t>(p) >= count ||
+          static_cast<size_t>(p) == i) {
+        return false;
+      }
+      ++childStart[p + 1];
+    }
+    for (size_t i = 0; i < count; ++i) childStart[i + 1] += childStart[i];
+    std::vector<uint32_t> children(childStart[count]);
+    std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+      if (parents[i] != kNoParent) {
+        children[fill[parents[i]]++] = static_cast<uint32_t>(i);
+      }
+    }
+
+    // Depth-first pre-order from each root; joints in a cycle are never
+    // reached from a root
+    flatToModel_.reserve(count);
+    parent_.reserve(count);
+    depth_.reserve(count);
+    modelToFlat_.assign(count, kUnvisited);
+    std::vector<uint32_t> stack;
+    for (size_t root = 0; root < count; ++root) {
+      if (parents[root] != kNoParent) continue;
+      stack.push_back(static_cast<uint32_t>(root));
+      while (!stack.empty()) {
+        const uint32_t joint = stack.back();
+        stack.pop_back();
+        const int32_t p = parents[joint];
+        const int32_t flatParent =
+            p == kNoParent ? kNoParent : static_cast<int32_t>(modelToFlat_[p]);
+        modelToFlat_[joint] = static_cast<uint32_t>(flatToModel_.size());
+        flatToModel_.push_back(joint);
+        parent_.push_back(flatParent);
+        depth_.push_back(flatParent == kNoParent ? 1 : depth_[flatParent] + 1);
+        if (depth_.back() > maxDepth_) maxDepth_ = depth_.back();
+        // Push in reverse so children are visited in model order
+        for (uint32_t c = childStart[joint + 1]; c > childStart[joint]; --c) {
+          stack.push_back(children[c - 1]);
+        }
+      }
+    }
+    if (flatToModel_.size() != count) {
+      clear();
+      return false;
+    }
+
+    local_.assign(count, BoneTransform{});
+    world_.assign(count, simd::Mat4::identity());
+    inverseBind_.assign(count, simd::Mat4::identity());
+    skin_.assign(count, simd::Mat4::identity());
+    return true;
+  }
+
+  void clear() {
+    parent_.clear();
+    depth_.clear();
+    flatToModel_.clear();
+    modelToFlat_.clear();
+    local_.clear();
+    world_.clear();
+    inverseBind_.clear();
+    skin_.clear();
+    maxDepth_ = 0;
+  }
+
+  size_t size() const { return parent_.size(); }
+  bool empty() const { return parent_.empty(); }
+  uint32_t maxDepth() const { return maxDepth_; }
+
+  // Flat-order views
+  const int32_t* parents() const { return parent_.data(); }
+  const uint32_t* flatToModel() const { return flatToModel_.data(); }
+  BoneTransform* localPose() { return local_.data(); }
+  const simd::Mat4* world() const { return world_.data(); }
+
+  uint32_t flatIndex(uint32_t modelJoint) const {
+    return modelToFlat_[modelJoint];
+  }
+
+  /**
+   * One past the last joint of the subtree rooted at flat joint `root`
+   * (subtrees are contiguous in pre-order)
+   */
+  uint32_t subtreeEnd(uint32_t root) const {
+    uint32_t end = root + 1;
+    while (end < depth_.size() && depth_[end] > depth_[root]) ++end;
+    return end;
+  }
+
+  /**
+   * Copy a local pose given in model joint order
+   */
+  void setLocalPose(const BoneTransform* modelOrder) {
+    for (size_t i = 0; i < local_.size(); ++i) {
+      local_[i] = modelOrder[flatToModel_[i]];
+    }
+  }
+
+  void setInverseBind(uint32_t modelJoint, const simd::Mat4& inverseBind) {
+    inverseBind_[modelToFlat_[modelJoint]] = inverseBind;
+  }
+
+  /**
+   * Local -> world in one forward pass (parents are already final)
+   */
+  void computeWorld(const simd::Mat4& root = simd::Mat4::identity()) {
+    computeWorldRange(0, static_cast<uint32_t>(local_.size()), root);
+  }
+
+  /**
+   * Recompute world matrices for flat joints [begin, end) only, e.g. one
+   * subtree after a local edit; parents outside the range must be final
+   */
+  void computeWorldRange(uint32_t begin, uint32_t end,
+                         const simd::Mat4& root = simd::Mat4::identity()) {
+    for (uint32_t i = begin; i < end; ++i) {
+      const int32_t p = parent_[i];
+      world_[i] = (p == kNoParent ? root : world_[p]) *
+                  composeTransform(local_[i]);
+    }
+  }
+
+  /**
+   * world * inverseBind, written in model joint order for the GPU
+   * Returns 16 floats per joint, column-major.
+   */
+  const float* computeSkinning() {
+    const size_t n = world_.size();
+    for (size_t i = 0; i < n; ++i) {
+      skin_[flatToModel_[i]] = world_[i] * inverseBind_[i];
+    }
+    return skinMatrices();
+  }
+
+  const float* skinMatrices() const {
+    return reinterpret_cast<const float*>(skin_.data());
+  }
+
+  size_t memoryBytes() const {
+    return parent_.capacity() * sizeof(int32_t) +
+           depth_.capacity() * sizeof(uint32_t) +
+           flatToModel_.capacity() * sizeof(uint32_t) +
+           modelToFlat_.capacity() * sizeof(uint32_t) +
+           local_.capacity() * sizeof(BoneTransform) +
+           (world_.capacity() + inverseBind_.capacity() + skin_.capacity()) *
+               sizeof(simd::Mat4);
+  }
+
+ private:
+  static constexpr uint32_t kUnvisited = 0xFFFFFFFFu;
+
+  std::vector<int32_t> parent_;          // flat parent index or kNoParent
+  std::vector<uint32_t> depth_;          // 1 for roots
+  std::vector<uint32_t> flatToModel_;
+  std::vector<uint32_t> modelToFlat_;
+  std::vector<BoneTransform> local_;     // flat order
+  std::vector<simd::Mat4> world_;        // flat order
+  std::vector<simd::Mat4> inverseBind_;  // flat order
+  std::vector<simd::Mat4> skin_;         // model order
+  uint32_t maxDepth_{0};
+};
+
+}  // namespace avatar
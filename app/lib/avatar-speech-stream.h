@@ -0,0 +1,316 @@
+/**
+ * avatar-speech-stream.h - Streaming MP3 speech: framing and decoded PCM
+ *
+ * Synthesized replies arrive as an MP3 byte stream. The engine owns that
+ * stream's timeline end to end:
+ *
+ *   bytes (fetch chunks) -> pushBytes -> complete frames -> nextFrame
+ *   decoded PCM (mono)   -> pushPcm   -> pcm(), the whole utterance
+ *   playback position    -> setPlayhead
+ *
+ * Frame decoding itself (Huffman, IMDCT, synthesis filterbank) is left
+ * to the platform codec: JS hands each frame to WebCodecs and returns
+ * the PCM. The engine finds frames in arbitrarily split chunks, skips
+ * ID3v2 tags and junk. While hunting for sync it only trusts a sync
+ * word once the following frame's header agrees; frames that follow on
+ * directly from a trusted one are taken as they complete. It also reads
+ * the frame count of a Xing/Info header, so the duration is known before
+ * decoding finishes.
+ *
+ * Decoded audio stays available ahead of the playhead. Everything
+ * between the playhead and decodedSamples() is lookahead for analysis.
+ * Only Layer III is accepted, in MPEG-1, 2 and 2.5, with a fixed
+ * bitrate per frame (free-format streams are rejected).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace avatar {
+
+struct Mp3FrameHeader {
+  uint32_t sampleRate{0};
+  uint32_t channels{0};
+  uint32_t samples{0};  // per channel per frame
+  uint32_t bytes{0};    // whole frame including the header
+  uint32_t bitrateKbps{0};
+  uint8_t version{0};  // raw 2-bit field: 3 MPEG-1, 2 MPEG-2, 0 MPEG-2.5
+};
+
+/**
+ * Parse the 4-byte header at p; false if it is not a Layer III header
+ */
+inline bool parseMp3Header(const uint8_t* p, Mp3FrameHeader& out) {
+  static const uint16_t kBitrateV1[16] = {0,   32,  40,  48,  56,  64,
+                                          80,  96,  112, 128, 160, 192,
+                                          224, 256, 320, 0};
+  static const uint16_t kBitrateV2[16] = {0,  8,  16,  24,  32,  40,
+                                          48, 56, 64,  80,  96,  112,
+                                          128, 144, 160, 0};
+  static const uint32_t kRateV1[3] = {44100, 48000, 32000};
+
+  if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+  const uint8_t version = (p[1] >> 3) & 3;
+  const uint8_t layer = (p[1] >> 1) & 3;
+  const uint8_t bitrateIndex = p[2] >> 4;
+  const uint8_t rateIndex = (p[2] >> 2) & 3;
+  if (version == 1 || layer != 1 || bitrateIndex == 0 ||
+      bitrateIndex == 15 || rateIndex == 3) {
+    return false;
+  }
+
+  const bool mpeg1 = version == 3;
+  const uint32_t divisor = mpeg1 ? 1 : version == 2 ? 2 : 4;
+  out.version = version;
+  out.sampleRate = kRateV1[rateIndex] / divisor;
+  out.channels = (p[3] >> 6) == 3 ? 1 : 2;
+  out.samples = mpeg1 ? 1152 : 576;
+  out.bitrateKbps =
+      mpeg1 ? kBitrateV1[bitrateIndex] : kBitrateV2[bitrateIndex];
+  out.bytes = (mpeg1 ? 144000 : 72000) * out.bitrateKbps / out.sampleRate +
+              ((p[2] >> 1) & 1);
+  return true;
+}
+
+class SpeechStream {
+ public:
+  struct Frame {
+    const uint8_t* data;
+    uint32_t bytes;
+  };
+
+  void reset() {
+    bytes_.clear();
+    frames_.clear();
+    nextFrame_ = 0;
+    scan_ = 0;
+    skip_ = 0;
+    tagChecked_ = false;
+    bytesEnded_ = false;
+    locked_ = false;
+    format_ = Mp3FrameHeader{};
+    framesFound_ = 0;
+    declaredFrames_ = 0;
+    junkBytes_ = 0;
+    pcm_.clear();
+    complete_ = false;
+    playhead_ = 0.0;
+    playedSamples_ = 0;
+  }
+
+  /** Append encoded bytes (any split); returns frames ready to decode */
+  size_t pushBytes(const uint8_t* data, size_t count) {
+    compact();
+    bytes_.insert(bytes_.end(), data, data + count);
+    scan();
+    return framesReady();
+  }
+
+  /** No more bytes: the last frame no longer needs a successor */
+  void endBytes() {
+    bytesEnded_ = true;
+    scan();
+  }
+
+  /**
+   * Take the next frame to decode; its data stays valid until the next
+   * pushBytes() or reset()
+   */
+  bool nextFrame(Frame& out) {
+    if (nextFrame_ >= frames_.size()) return false;
+    const FrameRef& f = frames_[nextFrame_++];
+    out = {bytes_.data() + f.offset, f.bytes};
+    return true;
+  }
+
+  size_t framesReady() const { return frames_.size() - nextFrame_; }
+
+  /** Append decoded mono PCM at sampleRate() */
+  void pushPcm(const float* samples, size_t count) {
+    pcm_.insert(pcm_.end(), samples, samples + count);
+  }
+
+  /** Every frame has been decoded */
+  void endPcm() { complete_ = true; }
+
+  /** Seconds of the utterance played so far (from the audio clock) */
+  void setPlayhead(double seconds) {
+    playhead_ = std::max(0.0, seconds);
+    playedSamples_ = std::min(
+        pcm_.size(),
+        static_cast<size_t>(playhead_ * static_cast<double>(sampleRate())));
+  }
+
+  /** 0 until the first audio frame has been found */
+  uint32_t sampleRate() const { return format_.sampleRate; }
+  uint32_t channels() const { return format_.channels; }
+
+  const float* pcm() const { return pcm_.data(); }
+  size_t decodedSamples() const { return pcm_.size(); }
+  size_t playedSamples() const { return playedSamples_; }
+  double playhead() const { return playhead_; }
+  bool complete() const { return complete_; }
+  bool active() const { return format_.sampleRate > 0; }
+
+  /** Decoded audio not yet played, in seconds */
+  double lookaheadSeconds() const {
+    if (!active()) return 0.0;
+    return static_cast<double>(pcm_.size() - playedSamples_) /
+           static_cast<double>(format_.sampleRate);
+  }
+
+  /**
+   * Length of the utterance: exact once decoding completes, from the
+   * Xing/Info frame count before that, 0 while unknown
+   */
+  double durationSeconds() const {
+    if (!active()) return 0.0;
+    const double rate = static_cast<double>(format_.sampleRate);
+    if (complete_) return static_cast<double>(pcm_.size()) / rate;
+    if (declaredFrames_ > 0) {
+      return static_cast<double>(declaredFrames_) * format_.samples / rate;
+    }
+    return 0.0;
+  }
+
+  uint32_t framesFound() const { return framesFound_; }
+  /** Bytes skipped while hunting for sync (tags excluded) */
+  size_t junkBytes() const { return junkBytes_; }
+
+  size_t memoryBytes() const {
+    return bytes_.capacity() + frames_.capacity() * sizeof(FrameRef) +
+           pcm_.capacity() * sizeof(float);
+  }
+
+ private:
+  struct FrameRef {
+    size_t offset;
+    uint32_t bytes;
+  };
+
+  static bool sameStream(const Mp3FrameHeader& a, const Mp3FrameHeader& b) {
+    return a.version == b.version && a.sampleRate == b.sampleRate &&
+           a.channels == b.channels;
+  }
+
+  // Drop bytes no pending frame or the scanner still needs
+  void compact() {
+    const size_t keep =
+        nextFrame_ < frames_.size() ? frames_[nextFrame_].offset : scan_;
+    if (keep == 0) return;
+    bytes_.erase(bytes_.begin(), bytes_.begin() + keep);
+    frames_.erase(frames_.begin(), frames_.begin() + nextFrame_);
+    for (FrameRef& f : frames_) f.offset -= keep;
+    nextFrame_ = 0;
+    scan_ -= keep;
+  }
+
+  void scan() {
+    const size_t size = bytes_.size();
+    while (true) {
+      if (skip_ > 0) {
+        const size_t step = std::min(skip_, size - scan_);
+        scan_ += step;
+        skip_ -= step;
+        if (skip_ > 0) return;
+      }
+      if (!tagChecked_) {
+        if (size - scan_ < 10) {
+          if (!bytesEnded_) return;
+          tagChecked_ = true;
+          continue;
+        }
+        tagChecked_ = true;
+        const uint8_t* p = bytes_.data() + scan_;
+        if (std::memcmp(p, "ID3", 3) == 0) {
+          // Syncsafe size, plus the header and an optional footer
+          const size_t tag = (size_t{p[6]} & 0x7F) << 21 |
+                             (size_t{p[7]} & 0x7F) << 14 |
+                             (size_t{p[8]} & 0x7F) << 7 | (p[9] & 0x7F);
+          skip_ = 10 + tag + ((p[5] & 0x10) ? 10 : 0);
+          continue;
+        }
+      }
+      if (size - scan_ < 4) return;
+
+      Mp3FrameHeader h;
+      const uint8_t* p = bytes_.data() + scan_;
+      if (!parseMp3Header(p, h) || (active() && !sameStream(h, format_))) {
+        skipJunk();
+        continue;
+      }
+      if (scan_ + h.bytes > size) return;  // rest of the frame to come
+      if (!locked_) {
+        if (scan_ + h.bytes + 4 <= size) {
+          Mp3FrameHeader next;
+          if (!parseMp3Header(p + h.bytes, next) || !sameStream(h, next)) {
+            skipJunk();
+            continue;
+          }
+        } else if (!bytesEnded_) {
+          return;  // confirm against the next header first
+        }
+        locked_ = true;
+      }
+
+      if (!active()) {
+        format_ = h;
+        if (readXing(p, h)) {  // metadata frame, decodes to silence
+          scan_ += h.bytes;
+          continue;
+        }
+      }
+      frames_.push_back({scan_, h.bytes});
+      scan_ += h.bytes;
+      ++framesFound_;
+    }
+  }
+
+  void skipJunk() {
+    ++scan_;
+    ++junkBytes_;
+    locked_ = false;
+  }
+
+  // Frame count from a Xing or Info header in the first frame
+  bool readXing(const uint8_t* p, const Mp3FrameHeader& h) {
+    const size_t sideInfo = h.version == 3 ? (h.channels == 1 ? 17 : 32)
+                                           : (h.channels == 1 ? 9 : 17);
+    const size_t at = 4 + sideInfo;
+    if (at + 12 > h.bytes) return false;
+    const uint8_t* x = p + at;
+    if (std::memcmp(x, "Xing", 4) != 0 && std::memcmp(x, "Info", 4) != 0) {
+      return false;
+    }
+    if (x[7] & 1) {
+      declaredFrames_ = uint32_t{x[8]} << 24 | uint32_t{x[9]} << 16 |
+                        uint32_t{x[10]} << 8 | x[11];
+    }
+    return true;
+  }
+
+  std::vector<uint8_t> bytes_;
+  std::vector<FrameRef> frames_;
+  size_t nextFrame_{0};  // first frame not yet taken
+  size_t scan_{0};       // first byte not yet framed
+  size_t skip_{0};       // tag bytes still to skip
+  bool tagChecked_{false};
+  bool bytesEnded_{false};
+  bool locked_{false};  // scan_ is where the last trusted frame ended
+  Mp3FrameHeader format_;
+  uint32_t framesFound_{0};
+  uint32_t declaredFrames_{0};
+  size_t junkBytes_{0};
+
+  std::vector<float> pcm_;
+  bool complete_{false};
+  double playhead_{0.0};
+  size_t playedSamples_{0};
+};
+
+}  // namespace avatar
@@ -0,0 +1,348 @@
+/**
+ * avatar-spring-bones.h - Verlet spring-bone chains for hair and clothing
+ *
+ * Each chain is a run of single-child joints. Its first joint stays
+ * kinematic: it is the anchor, and the animation places it. The joints
+ * below it are particles: Verlet-integrated with drag, gravity and a
+ * spring pull back toward the animated pose. Distance constraints keep
+ * the bone lengths, and sphere colliders (head, shoulders) push the
+ * particles out. The result is written back as rotations, so the mesh
+ * stays skinned the usual way.
+ *
+ * Particles are stored SoA and depth-major: depth d of chain c lives at
+ * d * lanes + c. A depth's constraint only needs the depth above it, so
+ * four chains step together in one register, with no gather.
+ * Padding lanes have zero rest length and collapse onto their parent
+ * harmlessly.
+ *
+ * Call order per frame, after the world pose is final:
+ * simulate(skeleton, step, steps) with the SimClock's steps, then
+ * apply(skeleton, weight).
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "avatar-simd.h"
+#include "avatar-skeleton.h"
+
+namespace avatar {
+
+struct SpringParams {
+  float stiffness{3.0f};  // pull toward the animated pose, 1/s
+  float drag{3.0f};       // velocity damping, 1/s
+  float gravity{-3.0f};   // m/s^2 along model Y (light strands sag less)
+  float radius{0.015f};   // particle collision radius, m
+};
+
+class SpringBones {
+ public:
+  static constexpr uint32_t kMaxColliders = 8;
+  static constexpr uint32_t kMaxChainJoints = 16;
+
+  /**
+   * Build chains from flat joint indices of their first (anchor) joints
+   * Each chain follows first children down to a leaf or kMaxChainJoints.
+   * Chains shorter than two joints are skipped. Returns the chain count.
+   */
+  uint32_t build(const FlatSkeleton& skeleton, const int32_t* roots,
+                 uint32_t count) {
+    clear();
+    std::vector<std::vector<int32_t>> chains;
+    for (uint32_t r = 0; r < count; ++r) {
+      std::vector<int32_t> chain{roots[r]};
+      uint32_t joint = static_cast<uint32_t>(roots[r]);
+      while (chain.size() < kMaxChainJoints && joint + 1 < skeleton.size() &&
+             skeleton.parents()[joint + 1] == static_cast<int32_t>(joint)) {
+        chain.push_back(static_cast<int32_t>(++joint));
+      }
+      if (chain.size() >= 2) chains.push_back(std::move(chain));
+    }
+    if (chains.empty()) return 0;
+
+    chains_ = static_cast<uint32_t>(chains.size());
+    lanes_ = (chains_ + 3) & ~3u;
+    for (const auto& chain : chains) {
+      depth_ = std::max(depth_, static_cast<uint32_t>(chain.size()));
+    }
+    joints_.assign(static_cast<size_t>(depth_) * lanes_, -1);
+    for (uint32_t c = 0; c < chains_; ++c) {
+      for (size_t d = 0; d < chains[c].size(); ++d) {
+        joints_[d * lanes_ + c] = chains[c][d];
+      }
+    }
+    const size_t n = static_cast<size_t>(depth_) * lanes_;
+    for (auto* stream : {&px_, &py_, &pz_, &qx_, &qy_, &qz_, &tx_, &ty_,
+                         &tz_, &rest_}) {
+      stream->assign(n, 0.0f);
+    }
+    for (auto* stream : {&ax0_, &ay0_, &az0_}) stream->assign(lanes_, 0.0f);
+    particles_ = 0;
+    for (const auto& chain : chains) {
+      particles_ += static_cast<uint32_t>(chain.size()) - 1;
+    }
+    return chains_;
+  }
+
+  void clear() {
+    chains_ = lanes_ = depth_ = particles_ = colliders_ = 0;
+    joints_.clear();
+    primed_ = false;
+  }
+
+  bool empty() const { return chains_ == 0; }
+  uint32_t chainCount() const { return chains_; }
+  uint32_t particleCount() const { return particles_; }
+  SpringParams& params() { return params_; }
+
+  /**
+   * Sphere collider attached to a flat joint, offset in the joint's space
+   */
+  bool addCollider(int32_t joint, float ox, float oy, float oz,
+                   float radius) {
+    if (joint < 0 || colliders_ >= kMaxColliders) return false;
+    Collider& c = collider_[colliders_++];
+    c.joint = joint;
+    c.offset = simd::Vec4::make(ox, oy, oz, 1.0f);
+    c.radius = radius;
+    return true;
+  }
+
+  /**
+   * Snap particles to the animated pose on the next simulate(), e.g.
+   * after a teleport or when re-enabled
+   */
+  void reset() { primed_ = false; }
+
+  /**
+   * Advance `steps` fixed steps of `step` seconds against the current
+   * (animated) world pose; the anchors move linearly across the steps
+   */
+  void simulate(const FlatSkeleton& skeleton, float step, uint32_t steps) {
+    if (empty()) return;
+    const simd::Mat4* world = skeleton.world();
+    // Animated targets; depth 0 is the anchor
+    float pos[4];
+    for (size_t i = 0; i < joints_.size(); ++i) {
+      if (joints_[i] < 0) continue;
+      simd::store(pos, world[joints_[i]].col[3]);
+      tx_[i] = pos[0];
+      ty_[i] = pos[1];
+      tz_[i] = pos[2];
+    }
+    if (!primed_) {
+      px_ = qx_ = tx_;
+      py_ = qy_ = ty_;
+      pz_ = qz_ = tz_;
+      for (uint32_t d = 1; d < depth_; ++d) {
+        for (uint32_t c = 0; c < lanes_; ++c) {
+          const size_t i = d * lanes_ + c, p = i - lanes_;
+          const float dx = tx_[i] - tx_[p], dy = ty_[i] - ty_[p],
+                      dz = tz_[i] - tz_[p];
+          rest_[i] = joints_[i] < 0 ? 0.0f
+                                    : std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+      }
+      std::copy(tx_.begin(), tx_.begin() + lanes_, ax0_.begin());
+      std::copy(ty_.begin(), ty_.begin() + lanes_, ay0_.begin());
+      std::copy(tz_.begin(), tz_.begin() + lanes_, az0_.begin());
+      primed_ = true;
+    }
+    if (steps == 0) return;
+
+    // Collider centers this frame
+    float cx[kMaxColliders], cy[kMaxColliders], cz[kMaxColliders];
+    for (uint32_t s = 0; s < colliders_; ++s) {
+      simd::store(pos, simd::transform(world[collider_[s].joint],
+                                       collider_[s].offset.v));
+      cx[s] = pos[0];
+      cy[s] = pos[1];
+      cz[s] = pos[2];
+    }
+
+    namespace v = simd;
+    const v::f32x4 stiff = v::splat(1.0f - std::exp(-params_.stiffness * step));
+    const v::f32x4 keep = v::splat(std::exp(-params_.drag * step));
+    const v::f32x4 fall = v::splat(params_.gravity * step * step);
+    const v::f32x4 eps = v::splat(1e-12f);
+    for (uint32_t n = 0; n < steps; ++n) {
+      // Anchors (depth 0) slide from last frame's position to this one's
+      const float t = static_cast<float>(n + 1) / static_cast<float>(steps);
+      for (uint32_t c = 0; c < lanes_; ++c) {
+        px_[c] = ax0_[c] + (tx_[c] - ax0_[c]) * t;
+        py_[c] = ay0_[c] + (ty_[c] - ay0_[c]) * t;
+        pz_[c] = az0_[c] + (tz_[c] - az0_[c]) * t;
+      }
+      for (uint32_t d = 1; d < depth_; ++d) {
+        for (uint32_t c = 0; c < lanes_; c += 4) {
+          const size_t i = d * lanes_ + c, p = i - lanes_;
+          const v::f32x4 x = v::load(&px_[i]), y = v::load(&py_[i]),
+                         z = v::load(&pz_[i]);
+          // Verlet with drag, spring toward the animation and gravity
+          v::f32x4 nx = v::add(x, v::mul(v::sub(x, v::load(&qx_[i])), keep));
+          v::f32x4 ny = v::add(y, v::mul(v::sub(y, v::load(&qy_[i])), keep));
+          v::f32x4 nz = v::add(z, v::mul(v::sub(z, v::load(&qz_[i])), keep));
+          nx = v::madd(v::sub(v::load(&tx_[i]), nx), stiff, nx);
+          ny = v::add(v::madd(v::sub(v::load(&ty_[i]), ny), stiff, ny), fall);
+          nz = v::madd(v::sub(v::load(&tz_[i]), nz), stiff, nz);
+
+          const v::f32x4 ox = v::load(&px_[p]), oy = v::load(&py_[p]),
+                         oz = v::load(&pz_[p]);
+          const v::f32x4 rest = v::load(&rest_[i]);
+          constrain(ox, oy, oz, rest, eps, nx, ny, nz);
+          for (uint32_t s = 0; s < colliders_; ++s) {
+            collide(cx[s], cy[s], cz[s], collider_[s].radius + params_.radius,
+                    eps, nx, ny, nz);
+          }
+          constrain(ox, oy, oz, rest, eps, nx, ny, nz);
+
+          v::store(&qx_[i], x);
+          v::store(&qy_[i], y);
+          v::store(&qz_[i], z);
+          v::store(&px_[i], nx);
+          v::store(&py_[i], ny);
+          v::store(&pz_[i], nz);
+        }
+      }
+    }
+    std::copy(tx_.begin(), tx_.begin() + lanes_, ax0_.begin());
+    std::copy(ty_.begin(), ty_.begin() + lanes_, ay0_.begin());
+    std::copy(tz_.begin(), tz_.begin() + lanes_, az0_.begin());
+  }
+
+  /**
+   * Rotate each chain joint so its bone points at the simulated child,
+   * blended with the animated pose by weight, and refresh the chain
+   * subtrees' world matrices
+   */
+  void apply(FlatSkeleton& skeleton, float weight) {
+    if (empty() || !primed_ || weight <= 0.0f) return;
+    BoneTransform* local = skeleton.localPose();
+    const int32_t* parents = skeleton.parents();
+    const simd::f32x4 point = simd::set(0.0f, 0.0f, 0.0f, 1.0f);
+    const simd::f32x4 xyz = simd::set(1.0f, 1.0f, 1.0f, 0.0f);
+    for (uint32_t c = 0; c < chains_; ++c) {
+      const uint32_t root = static_cast<uint32_t>(joints_[c]);
+      const int32_t rootParent = parents[root];
+      // World rotation of the current joint's parent, carried down the
+      // chain instead of re-extracted from each matrix
+      simd::Quat parentRotation =
+          rootParent == FlatSkeleton::kNoParent
+              ? simd::Quat::identity()
+              : simd::rotationOf(skeleton.world()[rootParent]);
+      uint32_t tip = root;
+      for (uint32_t d = 0; d + 1 < depth_; ++d) {
+        const size_t i = d * lanes_ + c;
+        const int32_t child = joints_[i + lanes_];
+        if (child < 0) break;
+        const uint32_t joint = static_cast<uint32_t>(joints_[i]);
+        if (d > 0) skeleton.computeWorldRange(joint, joint + 1);
+
+        const simd::Mat4& w = skeleton.world()[joint];
+        const simd::Vec4 origin{w.col[3]};
+        const simd::Vec4 animated{simd::transform(
+            w, simd::madd(local[child].translation.v, xyz, point))};
+        const simd::Vec4 simulated = simd::Vec4::make(
+            px_[i + lanes_], py_[i + lanes_], pz_[i + lanes_], 1.0f);
+        simd::Quat delta = simd::rotationBetween(animated - origin,
+                                                 simulated - origin);
+        if (weight < 1.0f) delta = simd::nlerp(simd::Quat::identity(), delta,
+                                               weight);
+        // Model-space delta expressed in the parent's frame
+        const simd::Quat rotation = delta * parentRotation *
+                                    local[joint].rotation;
+        local[joint].rotation = simd::normalize(
+            simd::conjugate(parentRotation) * rotation);
+        skeleton.computeWorldRange(joint, joint + 1);
+        parentRotation = simd::normalize(rotation);
+        tip = static_cast<uint32_t>(child);
+      }
+      // The tip and any side branches (they follow the chain in pre-order)
+      skeleton.computeWorldRange(tip, skeleton.subtreeEnd(root));
+    }
+  }
+
+  /**
+   * Simulated position of flat joint `joint` if it is a particle
+   */
+  bool particlePosition(int32_t joint, float* out) const {
+    for (size_t i = lanes_; i < joints_.size(); ++i) {
+      if (joints_[i] != joint) continue;
+      out[0] = px_[i];
+      out[1] = py_[i];
+      out[2] = pz_[i];
+      return true;
+    }
+    return false;
+  }
+
+  size_t memoryBytes() const {
+    size_t floats = ax0_.capacity() + ay0_.capacity() + az0_.capacity();
+    for (const auto* stream : {&px_, &py_, &pz_, &qx_, &qy_, &qz_, &tx_,
+                               &ty_, &tz_, &rest_}) {
+      floats += stream->capacity();
+    }
+    return floats * sizeof(float) + joints_.capacity() * sizeof(int32_t);
+  }
+
+ private:
+  struct Collider {
+    int32_t joint;
+    simd::Vec4 offset;
+    float radius;
+  };
+
+  // Project (x, y, z) to distance `rest` from (ox, oy, oz)
+  static void constrain(simd::f32x4 ox, simd::f32x4 oy, simd::f32x4 oz,
+                        simd::f32x4 rest, simd::f32x4 eps, simd::f32x4& x,
+                        simd::f32x4& y, simd::f32x4& z) {
+    namespace v = simd;
+    const v::f32x4 dx = v::sub(x, ox), dy = v::sub(y, oy), dz = v::sub(z, oz);
+    const v::f32x4 len2 =
+        v::madd(dx, dx, v::madd(dy, dy, v::mul(dz, dz)));
+    const v::f32x4 scale = v::div(rest, v::sqrt(v::max(len2, eps)));
+    x = v::madd(dx, scale, ox);
+    y = v::madd(dy, scale, oy);
+    z = v::madd(dz, scale, oz);
+  }
+
+  // Push (x, y, z) out of the sphere at (cx, cy, cz) with radius r
+  static void collide(float cx, float cy, float cz, float r,
+                      simd::f32x4 eps, simd::f32x4& x, simd::f32x4& y,
+                      simd::f32x4& z) {
+    namespace v = simd;
+    const v::f32x4 sx = v::splat(cx), sy = v::splat(cy), sz = v::splat(cz);
+    const v::f32x4 dx = v::sub(x, sx), dy = v::sub(y, sy), dz = v::sub(z, sz);
+    const v::f32x4 dist2 =
+        v::madd(dx, dx, v::madd(dy, dy, v::mul(dz, dz)));
+    const v::f32x4 radius = v::splat(r);
+    const v::f32x4 r2 = v::mul(radius, radius);
+    if (!v::lessMask(dist2, r2)) return;  // common case: all clear
+    const v::f32x4 inside = v::less(dist2, r2);
+    const v::f32x4 push = v::div(radius, v::sqrt(v::max(dist2, eps)));
+    x = v::select(inside, v::madd(dx, push, sx), x);
+    y = v::select(inside, v::madd(dy, push, sy), y);
+    z = v::select(inside, v::madd(dz, push, sz), z);
+  }
+
+  SpringParams params_;
+  uint32_t chains_{0};
+  uint32_t lanes_{0};      // chains rounded up to a multiple of 4
+  uint32_t depth_{0};      // joints in the longest chain
+  uint32_t particles_{0};
+  bool primed_{false};
+  std::vector<int32_t> joints_;  // [depth][lane] flat joint, -1 = padding
+  std::vector<float> px_, py_, pz_;  // current positions
+  std::vector<float> qx_, qy_, qz_;  // previous positions
+  std::vector<float> tx_, ty_, tz_;  // animated positions this frame
+  std::vector<float> rest_;          // distance to the parent particle
+  std::vector<float> ax0_, ay0_, az0_;  // anchors last frame
+  Collider collider_[kMaxColliders]{};
+  uint32_t colliders_{0};
+};
+
+}  // namespace avatar
@@ -0,0 +1,60 @@
+/**
+ * avatar-state-block.h - Engine state published for JavaScript in one block
+ *
+ * Rewritten at the end of every updateFrame() so JS can read animation
+ * state, frame timings, morph weights and counters through typed views it
+ * creates once, instead of making one export call per value. Every field
+ * is 4 bytes wide so Uint32Array and Float32Array views over the block
+ * share indices (index = byte offset / 4). Append-only layout.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "avatar-frame-counters.h"
+#include "avatar-frame-histogram.h"
+#include "avatar-quality.h"
+
+namespace avatar {
+
+/**
+ * Animation graph state index; these are the built-in graph's states and
+ * a loaded graph (avatar-anim-graph.h) may define more
+ */
+enum AnimationStateId : uint32_t {
+  kStateIdle = 0,
+  kStateListening = 1,
+  kStateSpeaking = 2,
+  kStateUnknown = 0xFFFFFFFFu,
+};
+
+struct EngineStateBlock {
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t version{kVersion};           // [0]
+  uint32_t sizeBytes{sizeof(EngineStateBlock)};  // [1]
+  uint32_t animationState{kStateIdle};  // [2] graph state index
+  uint32_t logPending{0};               // [3] records waiting in the log ring
+  float frameRate{0.0f};                // [4]
+  float lastFrameMs[kFramePhaseCount]{};  // [5..10] by FramePhase
+  float morphWeights[4]{};              // [11..14] lip-sync weights
+  FrameCounters counters;               // [15..25]
+  uint32_t qualityLevel{kQualityHigh};  // [26] QualityLevel
+  uint32_t springParticles{0};          // [27] simulated joints, 0 = off
+  uint32_t voiceActive{0};              // [28] microphone VAD, 1 = speech
+};
+
+static_assert(offsetof(EngineStateBlock, lastFrameMs) == 5 * 4,
+              "EngineStateBlock indices are mirrored in avatarController.ts");
+static_assert(offsetof(EngineStateBlock, morphWeights) == 11 * 4,
+              "EngineStateBlock indices are mirrored in avatarController.ts");
+static_assert(offsetof(EngineStateBlock, counters) == 15 * 4,
+              "EngineStateBlock indices are mirrored in avatarController.ts");
+static_assert(offsetof(EngineStateBlock, qualityLevel) == 26 * 4,
+              "EngineStateBlock indices are mirrored in avatarController.ts");
+static_assert(sizeof(EngineStateBlock) == 29 * 4,
+              "EngineStateBlock must stay a flat array of 4-byte fields");
+
+}  // namespace avatar
@@ -0,0 +1,178 @@
+/**
+ * avatar-vad.h - Voice activity detection on the microphone stream
+ *
+ * Each 10 ms hop of 8 kHz audio is classed as speech or not. A speech hop
+ * must be clearly above the tracked noise floor, and its 300-3400 Hz
+ * spectrum must be peaky rather than flat (spectral flatness), which
+ * rejects fans, hiss and other steady broadband noise. Loud enough hops
+ * pass regardless of flatness, so fricatives are not cut off.
+ *
+ * A few speech hops within a short window start activity. Hangover holds
+ * it through the gaps between words. The noise floor drops at once to
+ * quieter hops and creeps up slowly through non-speech, so a room that
+ * gets louder is relearned in a few seconds without speech pulling the
+ * floor up. Each hop costs one 256-point FFT.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "avatar-fft.h"
+#include "avatar-hop-framer.h"
+
+namespace avatar {
+
+struct VadParams {
+  float marginDb{9.0f};        // energy above the noise floor for speech
+  float loudMarginDb{20.0f};   // above this, flatness is not required
+  float gateDb{-60.0f};        // absolute minimum speech energy
+  float flatnessDb{-6.0f};     // speech spectra are peakier than this
+  uint32_t onsetHops{3};       // speech hops among the last kOnsetWindow
+  float hangoverSeconds{0.35f};
+  float floorRiseDbPerSecond{3.0f};
+};
+
+class VoiceActivityDetector {
+ public:
+  static constexpr float kAnalysisRate = 8000.0f;
+  static constexpr uint32_t kFrame = 256;  // ~32 ms
+  static constexpr float kHopSeconds = 0.01f;
+  static constexpr uint32_t kOnsetWindow = 5;
+  static constexpr uint32_t kMaxHopsPerPush = 8;
+
+  VadParams& params() { return params_; }
+
+  /**
+   * Set the input rate; decimates to roughly 8 kHz
+   */
+  void configure(float sampleRate) {
+    if (sampleRate == inputRate_) return;
+    inputRate_ = sampleRate;
+    const uint32_t factor =
+        std::max(1u, static_cast<uint32_t>(sampleRate / kAnalysisRate));
+    rate_ = sampleRate / static_cast<float>(factor);
+    hop_ = static_cast<uint32_t>(rate_ * kHopSeconds + 0.5f);
+    framer_.configure(factor, kFrame, hop_, kMaxHopsPerPush);
+    fft_.configure(kFrame);
+    power_.assign(kFrame / 2 + 1, 0.0f);
+    const float binHz = rate_ / static_cast<float>(kFrame);
+    lowBin_ = static_cast<uint32_t>(300.0f / binHz);
+    highBin_ = std::min(kFrame / 2, static_cast<uint32_t>(3400.0f / binHz));
+    reset();
+  }
+
+  void reset() {
+    framer_.reset();
+    active_ = false;
+    history_ = 0;
+    sinceSpeech_ = 1e3f;
+    floorDb_ = levelDb_ = 0.0f;
+    energyDb_ = -120.0f;
+    flatnessDb_ = 0.0f;
+    hops_ = 0;
+    onsets_ = 0;
+  }
+
+  /**
+   * Feed microphone PCM (mono, -1..1) at the configured rate
+   * Returns true if activity started or stopped during this push.
+   */
+  bool push(const float* samples, uint32_t count) {
+    const bool before = active_;
+    framer_.push(samples, count,
+                 [this](const float* frame) { analyseHop(frame); });
+    return active_ != before;
+  }
+
+  /** Speech in progress (including hangover) */
+  bool active() const { return active_; }
+  float energyDb() const { return energyDb_; }
+  float flatnessDb() const { return flatnessDb_; }
+  float noiseFloorDb() const { return floorDb_; }
+  uint64_t hops() const { return hops_; }
+  uint64_t droppedHops() const { return framer_.dropped(); }
+  uint32_t onsets() const { return onsets_; }
+
+  size_t memoryBytes() const {
+    return framer_.memoryBytes() + fft_.memoryBytes() +
+           power_.capacity() * sizeof(float);
+  }
+
+ private:
+  void analyseHop(const float* frame) {
+    // Energy over the newest hop, for a fast onset
+    float sum = 0.0f;
+    const float* hop = frame + kFrame - hop_;
+    for (uint32_t i = 0; i < hop_; ++i) sum += hop[i] * hop[i];
+    energyDb_ = 10.0f * std::log10(sum / static_cast<float>(hop_) + 1e-12f);
+    if (hops_++ == 0) floorDb_ = levelDb_ = energyDb_;
+
+    // Spectral flatness: geometric over arithmetic mean of the band power
+    fft_.powerSpectrum(frame, power_.data());
+    float logSum = 0.0f, linearSum = 0.0f;
+    for (uint32_t k = lowBin_; k <= highBin_; ++k) {
+      const float p = power_[k] + 1e-12f;
+      logSum += std::log(p);
+      linearSum += p;
+    }
+    const float bins = static_cast<float>(highBin_ - lowBin_ + 1);
+    flatnessDb_ = 4.3429448f * (logSum / bins - std::log(linearSum / bins));
+
+    const float above = energyDb_ - floorDb_;
+    const bool speech =
+        energyDb_ > params_.gateDb && above > params_.marginDb &&
+        (flatnessDb_ < params_.flatnessDb || above > params_.loudMarginDb);
+
+    // The floor follows a ~50 ms smoothed level, so single quiet hops
+    // in noise do not drag it below the noise itself
+    levelDb_ += (energyDb_ - levelDb_) * 0.2f;
+    if (levelDb_ < floorDb_) {
+      floorDb_ = levelDb_;
+    } else if (!speech) {
+      floorDb_ = std::min(levelDb_, floorDb_ + params_.floorRiseDbPerSecond *
+                                                   kHopSeconds);
+    }
+
+    history_ = ((history_ << 1) | (speech ? 1u : 0u)) &
+               ((1u << kOnsetWindow) - 1);
+    sinceSpeech_ = speech ? 0.0f : sinceSpeech_ + kHopSeconds;
+    if (!active_ && popcount(history_) >= params_.onsetHops) {
+      active_ = true;
+      ++onsets_;
+    } else if (active_ && sinceSpeech_ > params_.hangoverSeconds) {
+      active_ = false;
+    }
+  }
+
+  static uint32_t popcount(uint32_t v) {
+    uint32_t n = 0;
+    for (; v; v &= v - 1) ++n;
+    return n;
+  }
+
+  VadParams params_;
+  float inputRate_{0.0f};
+  float rate_{kAnalysisRate};
+  uint32_t hop_{80};
+  HopFramer framer_;
+  Fft fft_;
+  std::vector<float> power_;
+  uint32_t lowBin_{0};
+  uint32_t highBin_{0};
+
+  bool active_{false};
+  uint32_t history_{0};  // speech bits, newest in bit 0
+  float sinceSpeech_{1e3f};
+  float floorDb_{0.0f};
+  float levelDb_{0.0f};
+  float energyDb_{-120.0f};
+  float flatnessDb_{0.0f};
+  uint64_t hops_{0};
+  uint32_t onsets_{0};
+};
+
+}  // namespace avatar
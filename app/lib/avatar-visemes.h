@@ -0,0 +1,318 @@
+/**
+ * avatar-visemes.h - Provisional viseme timeline from text
+ *
+ * The reply text is known seconds before its synthesized audio arrives,
+ * and band-energy lip-sync can only start once audio plays. This module
+ * plans the mouth from the text instead. Phonemes from avatar-g2p.h map
+ * to 15 viseme classes, each with a mouthOpen/mouthRound pose. Every
+ * phoneme gets a typical duration, lengthened before pauses, which gives
+ * a timeline at a normal speaking rate.
+ *
+ * The timeline is provisional. When playback starts, the caller syncs it
+ * to the audio clock and, once known, the audio duration, and the track
+ * stretches the whole plan to fit. Syncs then keep it locked to the
+ * clock. Without syncs the track fades out, so a paused or stalled
+ * player never leaves the mouth talking on its own. Once the audio is
+ * decoded, avatar-align.h can retime the keys individually, which
+ * replaces the uniform stretch.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "avatar-g2p.h"
+
+namespace avatar {
+
+// Classes follow the common 15-viseme set (MPEG-4 / Oculus)
+enum Viseme : uint8_t {
+  kVisSil, kVisPP, kVisFF, kVisTH, kVisDD, kVisKK, kVisCH, kVisSS,
+  kVisNN, kVisRR, kVisAA, kVisE, kVisIH, kVisOH, kVisOU,
+  kVisemeCount
+};
+
+struct VisemePose {
+  float open;
+  float round;
+};
+
+inline const VisemePose kVisemePoses[kVisemeCount] = {
+    {0.0f, 0.0f},    // sil
+    {0.0f, 0.0f},    // PP  p b m (lips closed)
+    {0.1f, 0.0f},    // FF  f v
+    {0.2f, 0.0f},    // TH
+    {0.25f, 0.0f},   // DD  t d
+    {0.3f, 0.0f},    // kk  k g ng
+    {0.2f, 0.5f},    // CH  ch jh sh zh
+    {0.12f, 0.0f},   // SS  s z
+    {0.2f, 0.0f},    // nn  n l
+    {0.2f, 0.4f},    // RR  r er
+    {0.8f, 0.0f},    // aa
+    {0.5f, 0.0f},    // E
+    {0.35f, 0.0f},   // ih
+    {0.6f, 0.6f},    // oh
+    {0.3f, 0.85f},   // ou
+};
+
+inline Viseme visemeForPhoneme(uint8_t phoneme) {
+  switch (phoneme) {
+    case kPhP: case kPhB: case kPhM: return kVisPP;
+    case kPhF: case kPhV: return kVisFF;
+    case kPhTH: case kPhDH: return kVisTH;
+    case kPhT: case kPhD: return kVisDD;
+    case kPhK: case kPhG: case kPhNG: case kPhHH: return kVisKK;
+    case kPhCH: case kPhJH: case kPhSH: case kPhZH: return kVisCH;
+    case kPhS: case kPhZ: return kVisSS;
+    case kPhN: case kPhL: return kVisNN;
+    case kPhR: case kPhER: return kVisRR;
+    case kPhAA: case kPhAE: case kPhAH: case kPhAY: case kPhAW:
+      return kVisAA;
+    case kPhEH: case kPhEY: return kVisE;
+    case kPhIH: case kPhIY: case kPhY: return kVisIH;
+    case kPhAO: case kPhOW: case kPhOY: return kVisOH;
+    case kPhUH: case kPhUW: case kPhW: return kVisOU;
+    default: return kVisSil;
+  }
+}
+
+/**
+ * Typical phoneme duration in seconds at a conversational rate
+ */
+inline float phonemeSeconds(uint8_t phoneme) {
+  switch (phoneme) {
+    case kPhAA: case kPhAE: case kPhAO: case kPhAW: case kPhAY:
+    case kPhEY: case kPhOW: case kPhOY:
+      return 0.16f;  // long vowels and diphthongs
+    case kPhIY: case kPhUW: case kPhER:
+      return 0.13f;
+    case kPhAH: case kPhEH: case kPhIH: case kPhUH:
+      return 0.09f;
+    case kPhS: case kPhZ: case kPhSH: case kPhZH: case kPhF: case kPhV:
+    case kPhTH: case kPhCH: case kPhJH:
+      return 0.10f;  // fricatives and affricates
+    case kPhL: case kPhR: case kPhW: case kPhY: case kPhHH: case kPhDH:
+      return 0.07f;
+    default:
+      return 0.08f;  // stops and nasals
+  }
+}
+
+struct VisemeKey {
+  float start;  // seconds from the start of speech
+  float end;
+  uint8_t viseme;
+};
+
+class VisemeTimeline {
+ public:
+  static constexpr float kShortPauseSeconds = 0.18f;
+  static constexpr float kLongPauseSeconds = 0.35f;
+  static constexpr float kPhraseFinalStretch = 1.4f;
+  static constexpr float kBlendSeconds = 0.06f;  // coarticulation ramp
+
+  /**
+   * Build from converter output; repeated visemes merge into one key
+   */
+  void build(const std::vector<uint8_t>& phonemes) {
+    keys_.clear();
+    cursor_ = 0;
+    float t = 0.0f;
+    for (size_t i = 0; i < phonemes.size(); ++i) {
+      const uint8_t p = phonemes[i];
+      float seconds;
+      uint8_t viseme;
+      if (p == kPhShortPause || p == kPhLongPause) {
+        seconds = p == kPhLongPause ? kLongPauseSeconds : kShortPauseSeconds;
+        viseme = kVisSil;
+      } else if (p < kPhonemeCount) {
+        seconds = phonemeSeconds(p);
+        if (isVowelPhoneme(p) && finalVowel(phonemes, i)) {
+          seconds *= kPhraseFinalStretch;
+        }
+        viseme = visemeForPhoneme(p);
+      } else {
+        continue;  // word end
+      }
+      if (!keys_.empty() && keys_.back().viseme == viseme) {
+        keys_.back().end = t + seconds;
+      } else {
+        keys_.push_back({t, t + seconds, viseme});
+      }
+      t += seconds;
+    }
+    // Trailing pauses would only delay the end of speech
+    while (!keys_.empty() && keys_.back().viseme == kVisSil) keys_.pop_back();
+  }
+
+  void clear() {
+    keys_.clear();
+    cursor_ = 0;
+  }
+
+  bool empty() const { return keys_.empty(); }
+  size_t size() const { return keys_.size(); }
+  const VisemeKey& key(size_t i) const { return keys_[i]; }
+  float seconds() const { return keys_.empty() ? 0.0f : keys_.back().end; }
+
+  /**
+   * Mouth pose at time t, easing into the next key over its last
+   * kBlendSeconds; mostly sequential, so the key search starts at the
+   * previous hit
+   */
+  VisemePose sample(float t) const {
+    if (keys_.empty() || t < 0.0f || t >= seconds()) {
+      return kVisemePoses[kVisSil];
+    }
+    if (cursor_ >= keys_.size() || keys_[cursor_].start > t) cursor_ = 0;
+    while (keys_[cursor_].end <= t) ++cursor_;
+    const VisemeKey& k = keys_[cursor_];
+    VisemePose pose = kVisemePoses[k.viseme];
+    const VisemePose& next = cursor_ + 1 < keys_.size()
+                                 ? kVisemePoses[keys_[cursor_ + 1].viseme]
+                                 : kVisemePoses[kVisSil];
+    const float ramp = std::min(kBlendSeconds, 0.5f * (k.end - k.start));
+    const float x = (t - (k.end - ramp)) / ramp;
+    if (x > 0.0f) {
+      const float s = x * x * (3.0f - 2.0f * x);
+      pose.open += (next.open - pose.open) * s;
+      pose.round += (next.round - pose.round) * s;
+    }
+    return pose;
+  }
+
+  /**
+   * Move key i to start at starts[i] (ascending); the last key ends at
+   * end. Each key ends where the next one starts.
+   */
+  void retime(const float* starts, float end) {
+    for (size_t i = 0; i < keys_.size(); ++i) {
+      keys_[i].start = starts[i];
+      keys_[i].end = i + 1 < keys_.size() ? starts[i + 1] : end;
+    }
+    cursor_ = 0;
+  }
+
+  size_t memoryBytes() const { return keys_.capacity() * sizeof(VisemeKey); }
+
+ private:
+  // Last vowel before a pause or the end of the text
+  static bool finalVowel(const std::vector<uint8_t>& phonemes, size_t i) {
+    for (size_t j = i + 1; j < phonemes.size(); ++j) {
+      const uint8_t p = phonemes[j];
+      if (p == kPhShortPause || p == kPhLongPause) return true;
+      if (p < kPhonemeCount && isVowelPhoneme(p)) return false;
+    }
+    return true;
+  }
+
+  std::vector<VisemeKey> keys_;
+  mutable size_t cursor_{0};
+};
+
+/**
+ * Plays a timeline against the audio clock
+ */
+class VisemeTrack {
+ public:
+  static constexpr float kLeadSeconds = 0.04f;  // lips move before sound
+  static constexpr float kSyncTimeout = 0.25f;
+  static constexpr float kFadeRate = 10.0f;  // weight per second
+  static constexpr float kMinScale = 0.5f;
+  static constexpr float kMaxScale = 2.0f;
+
+  /**
+   * Plan text for the next utterance; playback waits for sync()
+   * Returns the estimated duration in seconds (0 for nothing to say).
+   */
+  float plan(const GraphemeToPhoneme& g2p, const char* text, size_t length) {
+    phonemes_.clear();
+    g2p.convert(text, length, phonemes_);
+    timeline_.build(phonemes_);
+    synced_ = false;
+    aligned_ = false;
+    scale_ = 1.0f;
+    playhead_ = 0.0f;
+    sinceSync_ = kSyncTimeout;
+    return timeline_.seconds();
+  }
+
+  /**
+   * Lock to the audio clock: audioSeconds into playback of the planned
+   * utterance, durationSeconds its full length (0 while unknown). An
+   * aligned timeline is already in audio time and ignores the duration.
+   */
+  void sync(float audioSeconds, float durationSeconds) {
+    if (timeline_.empty()) return;
+    if (durationSeconds > 0.0f && !aligned_) {
+      scale_ = std::clamp(durationSeconds / timeline_.seconds(), kMinScale,
+                          kMaxScale);
+    }
+    synced_ = true;
+    playhead_ = audioSeconds;
+    sinceSync_ = 0.0f;
+  }
+
+  void update(float dt) {
+    float target = 0.0f;
+    if (synced_) {
+      playhead_ += dt;
+      sinceSync_ += dt;
+      if (sinceSync_ < kSyncTimeout && playhead_ >= 0.0f &&
+          playhead_ < timeline_.seconds() * scale_) {
+        target = 1.0f;
+      }
+    }
+    const float step = kFadeRate * dt;
+    weight_ = std::clamp(target, weight_ - step, weight_ + step);
+    if (weight_ > 0.0f) {
+      pose_ = timeline_.sample((playhead_ + kLeadSeconds) / scale_);
+    }
+  }
+
+  void reset() {
+    phonemes_.clear();
+    timeline_.clear();
+    synced_ = false;
+    aligned_ = false;
+    scale_ = 1.0f;
+    playhead_ = 0.0f;
+    sinceSync_ = kSyncTimeout;
+    weight_ = 0.0f;
+    pose_ = kVisemePoses[kVisSil];
+  }
+
+  /** How much the plan owns the mouth (0-1) */
+  float weight() const { return weight_; }
+  const VisemePose& pose() const { return pose_; }
+  float scale() const { return scale_; }
+  float estimatedSeconds() const { return timeline_.seconds(); }
+  const VisemeTimeline& timeline() const { return timeline_; }
+  VisemeTimeline& timeline() { return timeline_; }
+
+  /** Keys were retimed to the audio; play them unscaled from now on */
+  void setAligned() {
+    aligned_ = true;
+    scale_ = 1.0f;
+  }
+  bool aligned() const { return aligned_; }
+
+  size_t memoryBytes() const {
+    return phonemes_.capacity() + timeline_.memoryBytes();
+  }
+
+ private:
+  std::vector<uint8_t> phonemes_;
+  VisemeTimeline timeline_;
+  bool synced_{false};
+  bool aligned_{false};
+  float scale_{1.0f};
+  float playhead_{0.0f};
+  float sinceSync_{kSyncTimeout};
+  float weight_{0.0f};
+  VisemePose pose_{0.0f, 0.0f};
+};
+
+}  // namespace avatar
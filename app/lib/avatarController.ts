@@ -6,15 +6,221 @@
  * and scene management.
  */
 
-export type AnimationState = "idle" | "listening" | "speaking";
+import {
+  decodeLogRecords,
+  printLogRecords,
+  readCString,
+  type EngineLogRecord,
+} from "@/app/lib/engineLog";
+import { MicrophoneFeed } from "@/app/lib/microphoneFeed";
+import { SpeechStreamPlayer, SpeechStreamSink } from "@/app/lib/speechStreamPlayer";
+import { MAX_TIMING_VALUES } from "@/app/lib/speechTiming";
+
+// Built-in states; a loaded animation graph may add more (thinking, ...)
+export type AnimationState = "idle" | "listening" | "speaking" | (string & {});
 
 export interface MorphTargets {
   mouthOpen: number;
   mouthRound: number;
   eyesLookUp: number;
   eyesClose: number;
+  // performance.now() times the analysed audio is audible / was analysed
+  audioTimeMs?: number;
+  analysisTimeMs?: number;
+  // Speech PCM played since the last update (mono, -1..1), pushed to the
+  // engine's prosody tracker for head nods and brow raises
+  audioSamples?: Float32Array;
+  audioSampleRate?: number;
+  // Playback position and length of the utterance passed to planSpeech
+  // (seconds; duration 0 while unknown), syncing the viseme plan
+  speechTimeSeconds?: number;
+  speechDurationSeconds?: number;
 }
 
+/**
+ * Frame phases timed by the engine (matches avatar::FramePhase)
+ */
+export type FramePhase =
+  | "frameInterval"
+  | "frameCpu"
+  | "animation"
+  | "sceneUpdate"
+  | "render"
+  | "present";
+
+const FRAME_PHASE_INDEX: Record<FramePhase, number> = {
+  frameInterval: 0,
+  frameCpu: 1,
+  animation: 2,
+  sceneUpdate: 3,
+  render: 4,
+  present: 5,
+};
+
+/**
+ * Frame time percentiles since the last reset (milliseconds)
+ */
+export interface FrameTimeStats {
+  p50: number;
+  p90: number;
+  p99: number;
+  p999: number;
+  max: number;
+  count: number;
+}
+
+/**
+ * Work done by the engine in the last rendered frame
+ * Mirrors avatar::FrameCounters (uint32 fields, append-only layout)
+ */
+export interface FrameCounters {
+  frameIndex: number;
+  drawCalls: number;
+  triangles: number;
+  skinnedVertices: number;
+  activeMorphs: number;
+  bonesEvaluated: number;
+  bytesUploaded: number;
+  pipelineBinds: number;
+  culledPrimitives: number;
+}
+
+const FRAME_COUNTERS_VERSION = 1;
+const FRAME_COUNTER_FIELDS: (keyof FrameCounters)[] = [
+  "frameIndex",
+  "drawCalls",
+  "triangles",
+  "skinnedVertices",
+  "activeMorphs",
+  "bonesEvaluated",
+  "bytesUploaded",
+  "pipelineBinds",
+  "culledPrimitives",
+];
+
+/**
+ * Quality governor level (matches avatar::QualityLevel)
+ */
+export type QualityLevel = "low" | "medium" | "high";
+
+const QUALITY_LEVELS: QualityLevel[] = ["low", "medium", "high"];
+
+/**
+ * Engine state published once per frame (matches avatar::EngineStateBlock)
+ * Read through typed views instead of one export call per value.
+ */
+export interface EngineState {
+  animationState: AnimationState | null;
+  frameRate: number;
+  lastFrameMs: Record<FramePhase, number>;
+  morphWeights: [number, number, number, number];
+  qualityLevel: QualityLevel;
+  // Spring-bone joints being simulated this frame (0 = off)
+  springParticles: number;
+  // Microphone voice activity detector hears speech
+  voiceActive: boolean;
+}
+
+// Uint32/Float32 indices into the state block (byte offset / 4)
+const STATE_BLOCK_VERSION = 1;
+const STATE_BLOCK_WORDS = 29;
+const STATE_INDEX = {
+  version: 0,
+  sizeBytes: 1,
+  animationState: 2,
+  logPending: 3,
+  frameRate: 4,
+  lastFrameMs: 5,
+  morphWeights: 11,
+  counters: 15,
+  qualityLevel: 26,
+  springParticles: 27,
+  voiceActive: 28,
+} as const;
+
+// Uint32/Float32 indices into the control block (avatar-control-block.h)
+const CONTROL_BLOCK_VERSION = 1;
+const CONTROL_BLOCK_WORDS = 7;
+const CONTROL_INDEX = {
+  version: 0,
+  sizeBytes: 1,
+  lookAtMode: 2,
+  lookAtTarget: 3,
+  lookAtWeight: 6,
+} as const;
+
+// Capacity of the engine's PCM input buffer (kAudioInputCapacity)
+const AUDIO_INPUT_CAPACITY = 2048;
+
+// Microphone PCM ring (avatar-pcm-ring.h); samples follow the header
+const MIC_RING_VERSION = 1;
+const MIC_RING_HEADER_WORDS = 8;
+const MIC_RING_CAPACITY = 8192;
+const MIC_INDEX = {
+  version: 0,
+  capacity: 1,
+  writeIndex: 2,
+  readIndex: 3,
+  sampleRate: 4,
+  overruns: 5,
+} as const;
+
+// Capacity of the engine's decoded speech input (kSpeechPcmCapacity)
+const SPEECH_PCM_CAPACITY = 4608;
+
+// Speech is decoded for alignment at the aligner's analysis rate
+// (SpeechFeatures::kTargetRate)
+const ALIGN_SAMPLE_RATE = 16000;
+
+// Matches avatar::LookAtMode
+const LOOK_AT_OFF = 0;
+const LOOK_AT_POINT = 1;
+const LOOK_AT_SCREEN = 2;
+
+// State names by graph index for the built-in graph (avatar-anim-graph.h)
+const ANIMATION_STATE_IDS: AnimationState[] = ["idle", "listening", "speaking"];
+
+type ExportFn = (...args: number[]) => number;
+
+/**
+ * Audio-to-mouth latency stages (matches avatar::LatencyStage)
+ * Each sample lands in either "analysis" or "analysisAhead", depending on
+ * whether the analyser ran after or before the audio was audible.
+ */
+export type LatencyStage =
+  | "total"
+  | "analysis"
+  | "bridge"
+  | "present"
+  | "analysisAhead";
+
+const LATENCY_STAGE_INDEX: Record<LatencyStage, number> = {
+  total: 0,
+  analysis: 1,
+  bridge: 2,
+  present: 3,
+  analysisAhead: 4,
+};
+
+/**
+ * Engine memory usage by category in bytes (matches avatar::MemoryCategory)
+ */
+export interface EngineMemoryStats {
+  heap: number;
+  geometry: number;
+  textures: number;
+  animation: number;
+  engine: number;
+}
+
+const MEMORY_CATEGORIES: (keyof EngineMemoryStats)[] = [
+  "heap",
+  "geometry",
+  "textures",
+  "animation",
+  "engine",
+];
+
 export interface AvatarControllerConfig {
   canvasId: string;
   wasmModule?: WebAssembly.Module;
@@ -27,6 +233,7 @@ export interface AvatarInstance {
   // Scene management
   initScene: () => void;
   loadAvatarModel: (glbUrl: string) => Promise<void>;
+  loadAnimationGraph: (graphUrl: string) => Promise<void>;
   updateFrame: () => void;
   cleanup: () => void;
 
@@ -37,6 +244,21 @@ export interface AvatarInstance {
   // Morph target control (for lip-sync)
   updateMorphTargets: (targets: MorphTargets) => void;
 
+  // Procedural look-at (head and eyes)
+  lookAtPoint: (x: number, y: number, z: number, weight?: number) => void;
+  lookAtScreenPoint: (clientX: number, clientY: number, weight?: number) => void;
+  clearLookAt: () => void;
+
+  // Provisional lip-sync planned from reply text before its audio arrives
+  planSpeech: (text: string) => number;
+  alignSpeech: (audio: Blob) => Promise<number>;
+  getSpeechTiming: () => Float32Array | null;
+  applySpeechTiming: (timing: Float32Array) => boolean;
+  playSpeechStream: (stream: ReadableStream<Uint8Array>) => Promise<boolean>;
+
+  // Microphone voice activity (enters listening on speech)
+  setMicrophoneStream: (stream: MediaStream | null) => void;
+
   // Canvas management
   setCanvasSize: (width: number, height: number) => void;
   getCanvasSize: () => { width: number; height: number };
@@ -44,6 +266,18 @@ export interface AvatarInstance {
   // Performance monitoring
   getFrameRate: () => number;
   getMemoryUsage: () => number;
+  getFrameTimeStats: (phase?: FramePhase) => FrameTimeStats;
+  resetFrameTimeStats: () => void;
+  getFrameCounters: () => FrameCounters | null;
+  getAudioLatencyStats: (stage?: LatencyStage) => FrameTimeStats;
+  getAudioLatencySamples: () => number[];
+  resetAudioLatencyStats: () => void;
+  getEngineMemoryStats: () => EngineMemoryStats | null;
+  setPerfHudEnabled: (enabled: boolean) => void;
+  getEngineState: () => EngineState | null;
+
+  // Engine logging
+  drainEngineLog: () => EngineLogRecord[];
 }
 
 class AvatarController implements AvatarInstance {
@@ -52,9 +286,32 @@ class AvatarController implements AvatarInstance {
   private canvasElement: HTMLCanvasElement | null = null;
   private isInitialized = false;
   private animationState: AnimationState = "idle";
+  private animationStateIds: AnimationState[] = ANIMATION_STATE_IDS;
   private frameRate = 0;
   private frameCount = 0;
   private lastFrameTime = performance.now();
+  private logFormatCache = new Map<number, string>();
+
+  // Resolved exports, so per-frame calls skip the string lookup
+  private exportCache = new Map<string, ExportFn>();
+
+  // Typed views over engine-owned memory, recreated when memory grows
+  private viewBuffer: ArrayBuffer | null = null;
+  private stateU32: Uint32Array | null = null;
+  private stateF32: Float32Array | null = null;
+  private morphInput: Float32Array | null = null;
+  private controlU32: Uint32Array | null = null;
+  private controlF32: Float32Array | null = null;
+  private audioInput: Float32Array | null = null;
+  private micU32: Uint32Array | null = null;
+  private micF32: Float32Array | null = null;
+  private micSamples: Float32Array | null = null;
+  private micFeed: MicrophoneFeed | null = null;
+  private speechPlanId = 0;  // bumped by planSpeech; stale alignments skip
+  private streamedPlanId = -1;  // plan aligned by its own stream
+  private timedPlanId = -1;  // plan retimed from cached timing
+  private speechPlayer: SpeechStreamPlayer | null = null;
+  private speechPlayback = 0;  // counts playSpeechStream calls
 
   constructor(private config: AvatarControllerConfig) {}
 
@@ -97,6 +354,8 @@ class AvatarController implements AvatarInstance {
       });
 
       this.isInitialized = true;
+      this.exportCache.clear();
+      this.viewBuffer = null;
 
       // Initialize scene
       this.callExport("initScene", []);
@@ -105,12 +364,13 @@ class AvatarController implements AvatarInstance {
       const width = this.canvasElement.clientWidth;
       const height = this.canvasElement.clientHeight;
       this.callExport("setCanvasSize", [width, height]);
+      this.flushEngineLog();
 
       // Start render loop
       this.startRenderLoop();
 
       // Handle window resize
-      window.addEventListener("resize", () => this.handleResize());
+      window.addEventListener("resize", this.handleResize);
 
       this.config.onReady?.();
     } catch (error) {
@@ -180,15 +440,20 @@ class AvatarController implements AvatarInstance {
 
       // Write GLB data to WebAssembly memory
       const bufferPtr = this.allocateWasmMemory(glbBuffer.byteLength);
-      const wasmMemoryView = new Uint8Array(
-        this.wasmMemory!.buffer,
-        bufferPtr,
-        glbBuffer.byteLength
-      );
-      wasmMemoryView.set(new Uint8Array(glbBuffer));
-
-      // Call C++ function to load model
-      this.callExport("loadAvatarModel", [bufferPtr, glbBuffer.byteLength]);
+      try {
+        const wasmMemoryView = new Uint8Array(
+          this.wasmMemory!.buffer,
+          bufferPtr,
+          glbBuffer.byteLength
+        );
+        wasmMemoryView.set(new Uint8Array(glbBuffer));
+
+        // Call C++ function to load model (it copies what it keeps)
+        this.callExport("loadAvatarModel", [bufferPtr, glbBuffer.byteLength]);
+      } finally {
+        this.freeWasmMemory(bufferPtr);
+      }
+      this.flushEngineLog();
     } catch (error) {
       const err =
         error instanceof Error ? error : new Error(String(error));
@@ -198,7 +463,42 @@ class AvatarController implements AvatarInstance {
   }
 
   /**
-   * Set animation state (idle, listening, speaking)
+   * Load an animation graph asset (states, transitions, layers)
+   * The engine compiles it into flat tables; on rejection the previous
+   * graph stays active and the engine log says why.
+   */
+  async loadAnimationGraph(graphUrl: string): Promise<void> {
+    if (!this.isInitialized) {
+      throw new Error("AvatarController not initialized");
+    }
+
+    const response = await fetch(graphUrl);
+    if (!response.ok) {
+      throw new Error(`Failed to fetch animation graph: ${response.statusText}`);
+    }
+    const text = await response.text();
+    const states: AnimationState[] = (JSON.parse(text).states ?? []).map(
+      (state: { name: string }) => state.name
+    );
+
+    const encoded = new TextEncoder().encode(text);
+    const ptr = this.allocateWasmMemory(encoded.length);
+    let loaded = 0;
+    try {
+      new Uint8Array(this.wasmMemory!.buffer, ptr, encoded.length).set(encoded);
+      loaded = this.callExport("loadAnimationGraph", [ptr, encoded.length]);
+    } finally {
+      this.freeWasmMemory(ptr);
+    }
+    this.flushEngineLog();
+    if (!loaded) {
+      throw new Error(`Animation graph rejected by engine: ${graphUrl}`);
+    }
+    this.animationStateIds = states;
+  }
+
+  /**
+   * Set animation state (idle, listening, speaking, or a graph state)
    */
   setAnimationState(state: AnimationState): void {
     if (!this.isInitialized) {
@@ -208,9 +508,21 @@ class AvatarController implements AvatarInstance {
 
     this.animationState = state;
 
+    // Known states go by graph index, skipping string marshalling
+    const index = this.animationStateIds.indexOf(state);
+    const setByIndex = index >= 0 ? this.resolveExport("setAnimationStateIndex") : null;
+    if (setByIndex) {
+      setByIndex(index);
+      return;
+    }
+
     // Write state string to memory and call C++ function
     const statePtr = this.writeStringToWasm(state);
-    this.callExport("setAnimationState", [statePtr]);
+    try {
+      this.callExport("setAnimationState", [statePtr]);
+    } finally {
+      this.freeWasmMemory(statePtr);
+    }
   }
 
   /**
@@ -231,30 +543,321 @@ class AvatarController implements AvatarInstance {
     }
 
     try {
-      // Write morph targets to memory as packed float32 values
+      // Write morph targets as packed float32 values into the engine-owned
+      // input buffer; older engines without one get a temporary allocation
       // Layout: [mouthOpen, mouthRound, eyesLookUp, eyesClose]
-      const targetsPtr = this.allocateWasmMemory(16); // 4 * 4 bytes (float32)
-      const floatView = new Float32Array(
-        this.wasmMemory!.buffer,
-        targetsPtr,
-        4
-      );
+      this.refreshViews();
+      const persistent = this.morphInput !== null;
+      const floatView =
+        this.morphInput ??
+        new Float32Array(this.wasmMemory!.buffer, this.allocateWasmMemory(16), 4);
+      const targetsPtr = floatView.byteOffset;
 
       floatView[0] = Math.max(0, Math.min(1, targets.mouthOpen));
       floatView[1] = Math.max(0, Math.min(1, targets.mouthRound));
       floatView[2] = Math.max(0, Math.min(1, targets.eyesLookUp));
       floatView[3] = Math.max(0, Math.min(1, targets.eyesClose));
 
-      // Call C++ function to update morph targets
-      this.callExport("updateMorphTargets", [targetsPtr]);
+      // Call C++ function to update morph targets, carrying the audio
+      // timestamps for latency measurement (0 = not audio-driven)
+      this.callExport("updateMorphTargets", [
+        targetsPtr,
+        targets.audioTimeMs ?? 0,
+        targets.analysisTimeMs ?? 0,
+      ]);
+
+      if (!persistent) this.freeWasmMemory(targetsPtr);
 
-      // Free allocated memory
-      this.freeWasmMemory(targetsPtr);
+      if (targets.audioSamples && targets.audioSampleRate) {
+        this.pushAudioSamples(targets.audioSamples, targets.audioSampleRate);
+      }
+
+      if (targets.speechTimeSeconds !== undefined) {
+        this.resolveExport("syncSpeechPlan")?.(
+          targets.speechTimeSeconds,
+          targets.speechDurationSeconds ?? 0
+        );
+      }
     } catch (error) {
       console.error("Error updating morph targets:", error);
     }
   }
 
+  /**
+   * Copy speech PCM into the engine-owned input buffer and analyse it
+   * Engines without the buffer (older builds, the mock) skip prosody.
+   */
+  private pushAudioSamples(samples: Float32Array, sampleRate: number): void {
+    const input = this.audioInput;
+    if (!input) return;
+    const count = Math.min(samples.length, input.length);
+    input.set(samples.subarray(samples.length - count));
+    this.callExport("pushAudioSamples", [input.byteOffset, count, sampleRate]);
+  }
+
+  /**
+   * Plan mouth shapes for an utterance from its text, before the audio
+   * exists; playback syncs it through speechTimeSeconds in
+   * updateMorphTargets. Returns the estimated duration in seconds (0 if
+   * the engine has no planner).
+   */
+  planSpeech(text: string): number {
+    if (!this.isInitialized || !this.resolveExport("planSpeechText")) return 0;
+    this.speechPlanId++;
+    const encoded = new TextEncoder().encode(text);
+    const ptr = this.allocateWasmMemory(Math.max(1, encoded.length));
+    try {
+      new Uint8Array(this.wasmMemory!.buffer, ptr, encoded.length).set(encoded);
+      return this.callExport("planSpeechText", [ptr, encoded.length]);
+    } finally {
+      this.freeWasmMemory(ptr);
+    }
+  }
+
+  /**
+   * Retime the current speech plan to its synthesized audio by forced
+   * alignment, replacing the uniform stretch to the audio duration.
+   * Decodes at 16 kHz, the rate the aligner analyses. Skipped if a newer
+   * plan replaced this one while decoding. Returns the number of keys
+   * aligned (0 if nothing was).
+   */
+  async alignSpeech(audio: Blob): Promise<number> {
+    if (!this.isInitialized || !this.resolveExport("alignSpeechPlan")) return 0;
+    const planId = this.speechPlanId;
+    let samples: Float32Array;
+    try {
+      const context = new OfflineAudioContext(1, 1, ALIGN_SAMPLE_RATE);
+      const decoded = await context.decodeAudioData(await audio.arrayBuffer());
+      samples = decoded.getChannelData(0);
+    } catch (error) {
+      console.warn("[AvatarController] Cannot decode speech for alignment:", error);
+      return 0;
+    }
+    if (!this.isInitialized || planId !== this.speechPlanId) return 0;
+    if (planId === this.streamedPlanId) return 0;  // the stream aligns it
+    if (planId === this.timedPlanId) return 0;  // cached timing did
+
+    const ptr = this.allocateWasmMemory(Math.max(4, samples.byteLength));
+    try {
+      new Float32Array(this.wasmMemory!.buffer, ptr, samples.length).set(samples);
+      return this.callExport("alignSpeechPlan", [ptr, samples.length, ALIGN_SAMPLE_RATE]);
+    } finally {
+      this.freeWasmMemory(ptr);
+    }
+  }
+
+  /**
+   * Timing of the current plan once aligned (key starts, then the end;
+   * see speechTiming.ts), for the speech cache; null before that
+   */
+  getSpeechTiming(): Float32Array | null {
+    if (!this.isInitialized || !this.resolveExport("getSpeechPlanTiming")) {
+      return null;
+    }
+    const ptr = this.allocateWasmMemory(MAX_TIMING_VALUES * 4);
+    try {
+      const count = this.callExport("getSpeechPlanTiming", [ptr, MAX_TIMING_VALUES]);
+      if (count === 0) return null;
+      return new Float32Array(this.wasmMemory!.buffer, ptr, count).slice();
+    } finally {
+      this.freeWasmMemory(ptr);
+    }
+  }
+
+  /**
+   * Retime the current plan from timing cached with its audio instead of
+   * aligning it; false if the timing doesn't fit this plan, in which
+   * case alignment runs as usual
+   */
+  applySpeechTiming(timing: Float32Array): boolean {
+    if (!this.isInitialized || !this.resolveExport("setSpeechPlanTiming")) {
+      return false;
+    }
+    const ptr = this.allocateWasmMemory(Math.max(4, timing.byteLength));
+    try {
+      new Float32Array(this.wasmMemory!.buffer, ptr, timing.length).set(timing);
+      if (this.callExport("setSpeechPlanTiming", [ptr, timing.length]) === 0) {
+        return false;
+      }
+    } finally {
+      this.freeWasmMemory(ptr);
+    }
+    this.timedPlanId = this.speechPlanId;
+    return true;
+  }
+
+  /**
+   * Play a synthesized MP3 reply while it downloads: the engine frames
+   * the stream, WebCodecs decodes it, and an AudioWorklet plays it. The
+   * engine sees the decoded audio ahead of the playhead and aligns the
+   * speech plan once decoding completes. Resolves false if this browser
+   * or engine can't stream (the stream is left unread), true once
+   * playback ends.
+   */
+  async playSpeechStream(stream: ReadableStream<Uint8Array>): Promise<boolean> {
+    if (!this.isInitialized || !SpeechStreamPlayer.isSupported()) return false;
+    if (this.tryCallExport("getSpeechByteInput") === 0) return false;  // mock
+
+    this.speechPlayer ??= new SpeechStreamPlayer();
+    this.streamedPlanId = this.speechPlanId;
+    const playback = ++this.speechPlayback;
+    this.callExport("beginSpeechStream", []);
+    this.setAnimationState("speaking");
+    try {
+      await this.speechPlayer.play(stream, this.speechSink);
+    } catch (error) {
+      console.error("[AvatarController] Speech stream failed:", error);
+    } finally {
+      // A newer stream has already begun when this one was cut short
+      if (this.isInitialized && playback === this.speechPlayback) {
+        this.callExport("endSpeechPlayback", []);
+      }
+      if (this.isInitialized && this.animationState === "speaking") {
+        this.setAnimationState("idle");
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Engine side of the speech stream: bytes and PCM go through the
+   * engine-owned input buffers, frames come back as views
+   */
+  private speechSink: SpeechStreamSink = {
+    pushBytes: (bytes) => {
+      const ptr = this.callExport("getSpeechByteInput", []);
+      const capacity = this.callExport("getSpeechByteCapacity", []);
+      for (let at = 0; at < bytes.length; at += capacity) {
+        const piece = bytes.subarray(at, at + capacity);
+        new Uint8Array(this.wasmMemory!.buffer, ptr, piece.length).set(piece);
+        this.callExport("pushSpeechBytes", [ptr, piece.length]);
+      }
+    },
+    endBytes: () => {
+      this.callExport("endSpeechBytes", []);
+    },
+    nextFrame: () => {
+      const bytes = this.callExport("nextSpeechFrame", []);
+      if (bytes === 0) return null;
+      const ptr = this.callExport("getSpeechFrame", []);
+      return new Uint8Array(this.wasmMemory!.buffer, ptr, bytes);
+    },
+    format: () => {
+      const sampleRate = this.callExport("getSpeechSampleRate", []);
+      if (sampleRate === 0) return null;
+      return { sampleRate, channels: this.callExport("getSpeechChannels", []) };
+    },
+    pushPcm: (samples) => {
+      if (!this.isInitialized) return;
+      const ptr = this.callExport("getSpeechPcmInput", []);
+      for (let at = 0; at < samples.length; at += SPEECH_PCM_CAPACITY) {
+        const piece = samples.subarray(at, at + SPEECH_PCM_CAPACITY);
+        new Float32Array(this.wasmMemory!.buffer, ptr, piece.length).set(piece);
+        this.callExport("pushSpeechPcm", [ptr, piece.length]);
+      }
+    },
+    endPcm: () => {
+      if (this.isInitialized) this.callExport("endSpeechStream", []);
+    },
+  };
+
+  /**
+   * Pass the streamed reply's playhead to the engine each frame
+   */
+  private feedSpeechPlayhead(): void {
+    const player = this.speechPlayer;
+    if (!player || !player.isPlaying) return;
+    this.callExport("setSpeechPlayhead", [player.playheadSeconds]);
+  }
+
+  /**
+   * Listen to a microphone stream for voice activity, or stop with null
+   * The engine switches to listening when speech starts and back to idle
+   * when it stops. The stream's tracks stay owned by the caller.
+   */
+  setMicrophoneStream(stream: MediaStream | null): void {
+    this.micFeed?.close();
+    this.micFeed = null;
+    if (!stream) return;
+    try {
+      this.micFeed = new MicrophoneFeed(stream);
+    } catch (error) {
+      console.error("Error opening microphone feed:", error);
+    }
+  }
+
+  /**
+   * Write microphone samples captured since the last frame into the
+   * engine's PCM ring; the engine drains it in updateFrame
+   */
+  private feedMicrophone(): void {
+    const feed = this.micFeed;
+    if (!feed) return;
+    this.refreshViews();
+    const u32 = this.micU32;
+    const ring = this.micSamples;
+    if (!u32 || !this.micF32 || !ring) return;  // engine without a ring
+
+    const samples = feed.read();
+    if (!samples) return;
+    const mask = ring.length - 1;
+    const write = u32[MIC_INDEX.writeIndex];
+    for (let i = 0; i < samples.length; i++) {
+      ring[(write + i) & mask] = samples[i];
+    }
+    this.micF32[MIC_INDEX.sampleRate] = feed.sampleRate;
+    u32[MIC_INDEX.writeIndex] = (write + samples.length) >>> 0;
+  }
+
+  /**
+   * Look at a point in model space (meters, avatar facing +Z)
+   * Written straight into the engine's control block; applied next frame.
+   */
+  lookAtPoint(x: number, y: number, z: number, weight = 1): void {
+    this.writeLookAt(LOOK_AT_POINT, x, y, z, weight);
+  }
+
+  /**
+   * Look toward a point on the canvas in client coordinates (e.g. the
+   * pointer), projected to the depth of the camera target
+   */
+  lookAtScreenPoint(clientX: number, clientY: number, weight = 1): void {
+    if (!this.canvasElement) return;
+    const rect = this.canvasElement.getBoundingClientRect();
+    if (rect.width <= 0 || rect.height <= 0) return;
+    const ndcX = ((clientX - rect.left) / rect.width) * 2 - 1;
+    const ndcY = 1 - ((clientY - rect.top) / rect.height) * 2;
+    this.writeLookAt(LOOK_AT_SCREEN, ndcX, ndcY, 0, weight);
+  }
+
+  /**
+   * Stop look-at; the head and eyes ease back to the animation
+   */
+  clearLookAt(): void {
+    this.writeLookAt(LOOK_AT_OFF, 0, 0, 0, 0);
+  }
+
+  private writeLookAt(
+    mode: number,
+    x: number,
+    y: number,
+    z: number,
+    weight: number
+  ): void {
+    if (!this.isInitialized) return;
+    this.refreshViews();
+    const u32 = this.controlU32;
+    const f32 = this.controlF32;
+    if (!u32 || !f32) return;  // engine without a control block
+
+    const target = CONTROL_INDEX.lookAtTarget;
+    f32[target] = x;
+    f32[target + 1] = y;
+    f32[target + 2] = z;
+    f32[CONTROL_INDEX.lookAtWeight] = Math.max(0, Math.min(1, weight));
+    u32[CONTROL_INDEX.lookAtMode] = mode;
+  }
+
   /**
    * Update canvas size
    */
@@ -284,6 +887,292 @@ class AvatarController implements AvatarInstance {
     return this.frameRate;
   }
 
+  /**
+   * Get frame time percentiles for a phase since the last reset
+   * Reads the engine's histogram snapshot (6 x float32) from WASM memory
+   */
+  getFrameTimeStats(phase: FramePhase = "frameInterval"): FrameTimeStats {
+    const empty = { p50: 0, p90: 0, p99: 0, p999: 0, max: 0, count: 0 };
+    if (!this.isInitialized || !this.wasmMemory) return empty;
+
+    const statsPtr = this.callExport("getFrameTimeStats", [
+      FRAME_PHASE_INDEX[phase],
+    ]);
+    if (!statsPtr) return empty;
+
+    const view = new Float32Array(this.wasmMemory.buffer, statsPtr, 6);
+    return {
+      p50: view[0],
+      p90: view[1],
+      p99: view[2],
+      p999: view[3],
+      max: view[4],
+      count: view[5],
+    };
+  }
+
+  /**
+   * Get audio-to-mouth latency percentiles for a stage since the last reset
+   */
+  getAudioLatencyStats(stage: LatencyStage = "total"): FrameTimeStats {
+    const empty = { p50: 0, p90: 0, p99: 0, p999: 0, max: 0, count: 0 };
+    if (!this.isInitialized || !this.wasmMemory) return empty;
+
+    const statsPtr = this.callExport("getAudioLatencyStats", [
+      LATENCY_STAGE_INDEX[stage],
+    ]);
+    if (!statsPtr) return empty;
+
+    const view = new Float32Array(this.wasmMemory.buffer, statsPtr, 6);
+    return {
+      p50: view[0],
+      p90: view[1],
+      p99: view[2],
+      p999: view[3],
+      max: view[4],
+      count: view[5],
+    };
+  }
+
+  /**
+   * Get recent per-frame audio-to-mouth latency samples (ms), oldest first
+   */
+  getAudioLatencySamples(): number[] {
+    if (!this.isInitialized || !this.wasmMemory) return [];
+
+    const count = this.callExport("getAudioLatencySampleCount", []);
+    if (!count) return [];
+
+    const samplesPtr = this.callExport("getAudioLatencySamples", []);
+    const head = this.callExport("getAudioLatencySampleHead", []);
+    const capacity = this.callExport("getAudioLatencySampleCapacity", []);
+    const ring = new Float32Array(this.wasmMemory.buffer, samplesPtr, capacity);
+
+    const samples: number[] = [];
+    const start = head - count;
+    for (let i = 0; i < count; i++) {
+      samples.push(ring[(start + i) % capacity]);
+    }
+    return samples;
+  }
+
+  /**
+   * Reset the engine's audio-to-mouth latency histograms
+   */
+  resetAudioLatencyStats(): void {
+    if (!this.isInitialized) return;
+    this.callExport("resetAudioLatencyStats", []);
+  }
+
+  /**
+   * Reset the engine's frame time histograms
+   */
+  resetFrameTimeStats(): void {
+    if (!this.isInitialized) return;
+    this.callExport("resetFrameTimeStats", []);
+  }
+
+  /**
+   * Get the engine's work counters for the last rendered frame
+   * Returns null if the engine doesn't expose a compatible counters struct
+   */
+  getFrameCounters(): FrameCounters | null {
+    if (!this.isInitialized || !this.wasmMemory) return null;
+
+    // Fast path: the counters are mirrored in the state block
+    this.refreshViews();
+    if (this.stateU32) {
+      const counters = {} as FrameCounters;
+      const base = STATE_INDEX.counters + 2; // skip version/sizeBytes
+      FRAME_COUNTER_FIELDS.forEach((name, i) => {
+        counters[name] = this.stateU32![base + i];
+      });
+      return counters;
+    }
+
+    const countersPtr = this.callExport("getFrameCounters", []);
+    if (!countersPtr) return null;
+
+    // Header: [version, sizeBytes], followed by the counters
+    const view = new Uint32Array(this.wasmMemory.buffer, countersPtr, 2);
+    if (view[0] < FRAME_COUNTERS_VERSION) return null;
+
+    const fieldCount = Math.min(
+      view[1] / 4 - 2,
+      FRAME_COUNTER_FIELDS.length
+    );
+    const fields = new Uint32Array(
+      this.wasmMemory.buffer,
+      countersPtr + 8,
+      fieldCount
+    );
+
+    const counters = {} as FrameCounters;
+    FRAME_COUNTER_FIELDS.forEach((name, i) => {
+      counters[name] = i < fieldCount ? fields[i] : 0;
+    });
+    return counters;
+  }
+
+  /**
+   * Get engine memory usage by category
+   */
+  getEngineMemoryStats(): EngineMemoryStats | null {
+    if (!this.isInitialized || !this.wasmMemory) return null;
+
+    const statsPtr = this.callExport("getMemoryStats", []);
+    if (!statsPtr) return null;
+
+    const view = new Uint32Array(
+      this.wasmMemory.buffer,
+      statsPtr,
+      MEMORY_CATEGORIES.length
+    );
+    const stats = {} as EngineMemoryStats;
+    MEMORY_CATEGORIES.forEach((name, i) => {
+      stats[name] = view[i];
+    });
+    return stats;
+  }
+
+  /**
+   * Toggle the engine-rendered perf HUD overlay
+   */
+  setPerfHudEnabled(enabled: boolean): void {
+    if (!this.isInitialized) return;
+    this.callExport("setPerfHudEnabled", [enabled ? 1 : 0]);
+  }
+
+  /**
+   * Read the engine state block published at the end of the last frame
+   */
+  getEngineState(): EngineState | null {
+    if (!this.isInitialized) return null;
+    this.refreshViews();
+    const u32 = this.stateU32;
+    const f32 = this.stateF32;
+    if (!u32 || !f32) return null;
+
+    const lastFrameMs = {} as Record<FramePhase, number>;
+    (Object.keys(FRAME_PHASE_INDEX) as FramePhase[]).forEach((phase) => {
+      lastFrameMs[phase] = f32[STATE_INDEX.lastFrameMs + FRAME_PHASE_INDEX[phase]];
+    });
+    const w = STATE_INDEX.morphWeights;
+    return {
+      animationState:
+        this.animationStateIds[u32[STATE_INDEX.animationState]] ?? null,
+      frameRate: f32[STATE_INDEX.frameRate],
+      lastFrameMs,
+      morphWeights: [f32[w], f32[w + 1], f32[w + 2], f32[w + 3]],
+      qualityLevel: QUALITY_LEVELS[u32[STATE_INDEX.qualityLevel]] ?? "high",
+      springParticles: u32[STATE_INDEX.springParticles],
+      voiceActive: u32[STATE_INDEX.voiceActive] !== 0,
+    };
+  }
+
+  /**
+   * (Re)create typed views over the state and control blocks and the
+   * morph input buffer
+   * Views detach when linear memory grows, so compare against the buffer
+   * they were created on; cheap enough to call on every access.
+   */
+  private refreshViews(): void {
+    const buffer = this.wasmMemory?.buffer ?? null;
+    if (!buffer || buffer === this.viewBuffer) return;
+    this.viewBuffer = buffer;
+    this.stateU32 = null;
+    this.stateF32 = null;
+    this.morphInput = null;
+    this.controlU32 = null;
+    this.controlF32 = null;
+    this.audioInput = null;
+    this.micU32 = null;
+    this.micF32 = null;
+    this.micSamples = null;
+
+    const blockPtr = this.tryCallExport("getEngineStateBlock");
+    if (blockPtr) {
+      const header = new Uint32Array(buffer, blockPtr, 2);
+      if (
+        header[0] >= STATE_BLOCK_VERSION &&
+        header[1] >= STATE_BLOCK_WORDS * 4
+      ) {
+        this.stateU32 = new Uint32Array(buffer, blockPtr, STATE_BLOCK_WORDS);
+        this.stateF32 = new Float32Array(buffer, blockPtr, STATE_BLOCK_WORDS);
+      }
+    }
+
+    const morphPtr = this.tryCallExport("getMorphInputBuffer");
+    if (morphPtr) {
+      this.morphInput = new Float32Array(buffer, morphPtr, 4);
+    }
+
+    const audioPtr = this.tryCallExport("getAudioInputBuffer");
+    if (audioPtr) {
+      this.audioInput = new Float32Array(buffer, audioPtr, AUDIO_INPUT_CAPACITY);
+    }
+
+    const micPtr = this.tryCallExport("getMicrophoneRing");
+    if (micPtr) {
+      const header = new Uint32Array(buffer, micPtr, 2);
+      if (
+        header[0] >= MIC_RING_VERSION &&
+        header[1] === MIC_RING_CAPACITY
+      ) {
+        this.micU32 = new Uint32Array(buffer, micPtr, MIC_RING_HEADER_WORDS);
+        this.micF32 = new Float32Array(buffer, micPtr, MIC_RING_HEADER_WORDS);
+        this.micSamples = new Float32Array(
+          buffer,
+          micPtr + MIC_RING_HEADER_WORDS * 4,
+          MIC_RING_CAPACITY
+        );
+      }
+    }
+
+    const controlPtr = this.tryCallExport("getEngineControlBlock");
+    if (controlPtr) {
+      const header = new Uint32Array(buffer, controlPtr, 2);
+      if (
+        header[0] >= CONTROL_BLOCK_VERSION &&
+        header[1] >= CONTROL_BLOCK_WORDS * 4
+      ) {
+        this.controlU32 = new Uint32Array(buffer, controlPtr, CONTROL_BLOCK_WORDS);
+        this.controlF32 = new Float32Array(buffer, controlPtr, CONTROL_BLOCK_WORDS);
+      }
+    }
+  }
+
+  /**
+   * Drain and decode the engine's buffered log records
+   */
+  drainEngineLog(): EngineLogRecord[] {
+    if (!this.isInitialized || !this.wasmMemory) return [];
+
+    const count = this.callExport("drainLog", []);
+    if (!count) return [];
+
+    const recordsPtr = this.callExport("getLogBuffer", []);
+    const records = decodeLogRecords(
+      this.wasmMemory.buffer,
+      recordsPtr,
+      count,
+      this.logFormatCache
+    );
+
+    const dropped = this.callExport("getLogDroppedCount", []);
+    if (dropped > 0) {
+      console.warn(`[Avatar Engine] ${dropped} log records dropped`);
+    }
+    return records;
+  }
+
+  /**
+   * Drain the engine log and print it to the console
+   */
+  private flushEngineLog(): void {
+    printLogRecords(this.drainEngineLog());
+  }
+
   /**
    * Get approximate memory usage
    */
@@ -330,9 +1219,17 @@ class AvatarController implements AvatarInstance {
         this.lastFrameTime = now;
       }
 
-      // Call C++ update and render
+      // Call C++ update and render, then print any engine log records;
+      // the state block says whether there are any, so idle frames make
+      // exactly one call across the bridge
       try {
+        this.feedMicrophone();
+        this.feedSpeechPlayhead();
         this.callExport("updateFrame", []);
+        this.refreshViews();
+        if (!this.stateU32 || this.stateU32[STATE_INDEX.logPending] > 0) {
+          this.flushEngineLog();
+        }
       } catch (error) {
         console.error("Error in render loop:", error);
       }
@@ -346,28 +1243,62 @@ class AvatarController implements AvatarInstance {
   /**
    * Handle window resize
    */
-  private handleResize(): void {
+  private handleResize = (): void => {
     if (!this.canvasElement) return;
 
     const width = this.canvasElement.clientWidth;
     const height = this.canvasElement.clientHeight;
     this.setCanvasSize(width, height);
-  }
+  };
 
   /**
    * Call exported C++ function via WebAssembly
    */
   private callExport(name: string, args: number[]): number {
+    const fn = this.resolveExport(name);
+    if (!fn) {
+      throw new Error(`Exported function "${name}" not found`);
+    }
+
+    // Avoid spread: it allocates and defeats call-site inlining
+    switch (args.length) {
+      case 0:
+        return fn();
+      case 1:
+        return fn(args[0]);
+      case 2:
+        return fn(args[0], args[1]);
+      case 3:
+        return fn(args[0], args[1], args[2]);
+      default:
+        return fn(...args);
+    }
+  }
+
+  /**
+   * Call an optional export; returns 0 if the engine doesn't provide it
+   */
+  private tryCallExport(name: string): number {
+    const fn = this.resolveExport(name);
+    return fn ? fn() : 0;
+  }
+
+  /**
+   * Look up an export once and cache the function
+   */
+  private resolveExport(name: string): ExportFn | null {
     if (!this.wasmInstance || !this.wasmInstance.exports) {
       throw new Error("WebAssembly instance not initialized");
     }
 
-    const fn = (this.wasmInstance.exports as any)[name];
-    if (typeof fn !== "function") {
-      throw new Error(`Exported function "${name}" not found`);
+    let fn = this.exportCache.get(name);
+    if (fn === undefined) {
+      const candidate = (this.wasmInstance.exports as any)[name];
+      if (typeof candidate !== "function") return null;
+      fn = candidate as ExportFn;
+      this.exportCache.set(name, fn);
     }
-
-    return fn(...args) as number;
+    return fn;
   }
 
   /**
@@ -407,12 +1338,7 @@ class AvatarController implements AvatarInstance {
    * Log error from WebAssembly
    */
   private logError(msgPtr: number): void {
-    const wasmMemoryView = new Uint8Array(this.wasmMemory!.buffer);
-    let msg = "";
-    for (let i = msgPtr; wasmMemoryView[i] !== 0; i++) {
-      msg += String.fromCharCode(wasmMemoryView[i]);
-    }
-    console.error("[Avatar Engine]", msg);
+    console.error("[Avatar Engine]", readCString(this.wasmMemory!.buffer, msgPtr));
   }
 
   /**
@@ -430,16 +1356,33 @@ class AvatarController implements AvatarInstance {
     if (this.isInitialized) {
       try {
         this.callExport("cleanup", []);
+        this.flushEngineLog();
       } catch (error) {
         console.error("Error during cleanup:", error);
       }
     }
 
     this.isInitialized = false;
+    this.animationStateIds = ANIMATION_STATE_IDS;
     this.wasmInstance = null;
     this.wasmMemory = null;
-
-    window.removeEventListener("resize", () => this.handleResize());
+    this.exportCache.clear();
+    this.viewBuffer = null;
+    this.stateU32 = null;
+    this.stateF32 = null;
+    this.morphInput = null;
+    this.controlU32 = null;
+    this.controlF32 = null;
+    this.audioInput = null;
+    this.micU32 = null;
+    this.micF32 = null;
+    this.micSamples = null;
+    this.micFeed?.close();
+    this.micFeed = null;
+    this.speechPlayer?.close();
+    this.speechPlayer = null;
+
+    window.removeEventListener("resize", this.handleResize);
   }
 
   /**
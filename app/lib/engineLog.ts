@@ -0,0 +1,156 @@
+/**
+ * Engine Log - Decodes the WebAssembly engine's ring-buffered log
+ *
+ * The C++ side (avatar-log.h) stores a static format string pointer plus
+ * unformatted arguments per record. AvatarController drains the ring once
+ * per frame; this module turns the drained records into console messages.
+ */
+
+export type EngineLogLevel = "debug" | "info" | "warn" | "error";
+
+export interface EngineLogRecord {
+  timeMs: number;
+  level: EngineLogLevel;
+  message: string;
+}
+
+// wasm32 layout of avatar::log::LogRecord
+export const LOG_RECORD_SIZE = 120;
+const OFFSET_TIME = 0;
+const OFFSET_FORMAT = 8;
+const OFFSET_LEVEL = 12;
+const OFFSET_ARG_COUNT = 16;
+const OFFSET_ARG_KINDS = 20;
+const OFFSET_ARGS = 24;
+const OFFSET_TEXT = 56;
+const TEXT_SLOTS = 2;
+const TEXT_SIZE = 32;
+
+export const ARG_KIND_INT = 0;
+export const ARG_KIND_DOUBLE = 1;
+export const ARG_KIND_STRING = 2;
+
+const LEVELS: EngineLogLevel[] = ["debug", "info", "warn", "error"];
+
+let decoder: TextDecoder | null = null;
+
+function decodeUtf8(bytes: Uint8Array): string {
+  if (typeof TextDecoder === "undefined") {
+    // Test environments without TextDecoder: engine strings are ASCII
+    return String.fromCharCode(...bytes);
+  }
+  decoder ??= new TextDecoder();
+  return decoder.decode(bytes);
+}
+
+/**
+ * Read a null-terminated UTF-8 string from WebAssembly memory
+ */
+export function readCString(
+  buffer: ArrayBuffer,
+  ptr: number,
+  maxLength = 4096
+): string {
+  const bytes = new Uint8Array(buffer, ptr, Math.min(maxLength, buffer.byteLength - ptr));
+  let end = bytes.indexOf(0);
+  if (end < 0) end = bytes.length;
+  return decodeUtf8(bytes.subarray(0, end));
+}
+
+/**
+ * Expand printf-style conversions (%d %u %f %.Nf %s %%) with stored arguments
+ * String arguments take the texts in order.
+ */
+export function formatLogMessage(
+  format: string,
+  args: number[],
+  kinds: number[],
+  texts: string[]
+): string {
+  let argIndex = 0;
+  let textIndex = 0;
+  return format.replace(/%(\.\d+)?([dufs%])/g, (match, precision, conv) => {
+    if (conv === "%") return "%";
+    if (argIndex >= args.length) return match;
+
+    const i = argIndex++;
+    if (kinds[i] === ARG_KIND_STRING) return texts[textIndex++] ?? "";
+    if (conv === "s") return String(args[i]);
+    if (conv === "f") {
+      const digits = precision ? Number(precision.slice(1)) : 6;
+      return args[i].toFixed(digits);
+    }
+    return String(Math.trunc(args[i]));
+  });
+}
+
+/**
+ * Decode drained log records from WebAssembly memory
+ * Format strings live in the module's static data, so they are cached by
+ * pointer and decoded only once.
+ */
+export function decodeLogRecords(
+  buffer: ArrayBuffer,
+  ptr: number,
+  count: number,
+  formatCache: Map<number, string>
+): EngineLogRecord[] {
+  const view = new DataView(buffer);
+  const records: EngineLogRecord[] = [];
+
+  for (let r = 0; r < count; r++) {
+    const base = ptr + r * LOG_RECORD_SIZE;
+
+    const formatPtr = view.getUint32(base + OFFSET_FORMAT, true);
+    let format = formatCache.get(formatPtr);
+    if (format === undefined) {
+      format = readCString(buffer, formatPtr);
+      formatCache.set(formatPtr, format);
+    }
+
+    const argCount = view.getUint32(base + OFFSET_ARG_COUNT, true);
+    const argKinds = view.getUint32(base + OFFSET_ARG_KINDS, true);
+    const args: number[] = [];
+    const kinds: number[] = [];
+    for (let i = 0; i < argCount; i++) {
+      args.push(view.getFloat64(base + OFFSET_ARGS + i * 8, true));
+      kinds.push((argKinds >> (i * 2)) & 3);
+    }
+
+    const texts: string[] = [];
+    for (const kind of kinds) {
+      if (kind !== ARG_KIND_STRING || texts.length === TEXT_SLOTS) continue;
+      const slot = base + OFFSET_TEXT + texts.length * TEXT_SIZE;
+      texts.push(readCString(buffer, slot, TEXT_SIZE));
+    }
+
+    records.push({
+      timeMs: view.getFloat64(base + OFFSET_TIME, true),
+      level: LEVELS[view.getUint32(base + OFFSET_LEVEL, true)] ?? "info",
+      message: formatLogMessage(format, args, kinds, texts),
+    });
+  }
+
+  return records;
+}
+
+/**
+ * Write decoded records to the browser console
+ */
+export function printLogRecords(records: EngineLogRecord[]): void {
+  for (const record of records) {
+    switch (record.level) {
+      case "error":
+        console.error("[LIT-LAND Avatar]", record.message);
+        break;
+      case "warn":
+        console.warn("[LIT-LAND Avatar]", record.message);
+        break;
+      case "debug":
+        console.debug("[LIT-LAND Avatar]", record.message);
+        break;
+      default:
+        console.log("[LIT-LAND Avatar]", record.message);
+    }
+  }
+}
@@ -1,3 +1,4 @@
+import { getMemoryIndex, type MemoryIndex } from "@/app/lib/memoryIndex";
 import { getPool } from "@/app/lib/pg";
 
 export type MemoryPack = {
@@ -101,13 +102,74 @@ function patternsFromTokens(tokens: string[]): string[] {
   return tokens.map((t) => `%${t}%`);
 }
 
-export async function getMemoryPack(query: string): Promise<MemoryPack> {
-  const db = getPool();
+const SELF_FACT_LIMIT = 12;
+const SELF_FACT_LIMIT_UNMATCHED = 8;
+const STORY_LIMIT = 6;
+const INTEREST_LIMIT = 10;
+
+function toMemoryPack(
+  selfFacts: SelfFactRow[],
+  stories: StoryRow[],
+  interests: InterestRow[]
+): MemoryPack {
+  return {
+    selfFacts: selfFacts.map((r: SelfFactRow) => ({
+      predicate: String(r.predicate ?? ""),
+      object: String(r.object ?? ""),
+      confidence: Number(r.confidence ?? 0.5)
+    })),
+    stories: stories.map((r: StoryRow) => ({
+      title: String(r.title ?? ""),
+      summary: String(r.summary ?? ""),
+      namespace: String(r.namespace ?? ""),
+      confidence: Number(r.confidence ?? 0.5)
+    })),
+    interestQueries: interests.map((r: InterestRow) => ({
+      query: String(r.query ?? ""),
+      createdAt: r.created_at ? String(r.created_at) : null
+    }))
+  };
+}
 
+/**
+ * Same limits as the queries below, ranked by BM25 and confidence; a
+ * query without tokens gets the most confident facts and stories and
+ * the newest interests, as before
+ */
+function memoryPackFromIndex(
+  index: MemoryIndex,
+  query: string,
+  hasPatterns: boolean
+): MemoryPack {
+  if (!hasPatterns) {
+    return toMemoryPack(
+      index.selfFacts.top(SELF_FACT_LIMIT_UNMATCHED),
+      index.stories.top(STORY_LIMIT),
+      index.interests.top(INTEREST_LIMIT, true)
+    );
+  }
+  return toMemoryPack(
+    index.selfFacts.search(query, SELF_FACT_LIMIT),
+    index.stories.search(query, STORY_LIMIT),
+    index.interests.search(query, INTEREST_LIMIT)
+  );
+}
+
+export async function getMemoryPack(query: string): Promise<MemoryPack> {
   const tokens = tokensFromText(query);
   const patterns = patternsFromTokens(tokens);
   const hasPatterns = patterns.length > 0;
 
+  const index = getMemoryIndex();
+  if (index) {
+    try {
+      return memoryPackFromIndex(index, query, hasPatterns);
+    } catch (error) {
+      console.error("[MemoryIndex] Search failed; querying Postgres", error);
+    }
+  }
+
+  const db = getPool();
   const selfFactsQuery = hasPatterns
     ? db.query(
         `
@@ -123,7 +185,7 @@ export async function getMemoryPack(query: string): Promise<MemoryPack> {
           )
           and coalesce(nullif(trim(object_text), ''), object_json::text, object_date::text, object_number::text, object_bool::text) is not null
         order by confidence desc, created_at desc
-        limit 12
+        limit ${SELF_FACT_LIMIT}
         `,
         [patterns]
       )
@@ -137,7 +199,7 @@ export async function getMemoryPack(query: string): Promise<MemoryPack> {
         where namespace = 'self'
           and coalesce(nullif(trim(object_text), ''), object_json::text, object_date::text, object_number::text, object_bool::text) is not null
         order by confidence desc, created_at desc
-        limit 8
+        limit ${SELF_FACT_LIMIT_UNMATCHED}
         `
       );
 
@@ -149,7 +211,7 @@ export async function getMemoryPack(query: string): Promise<MemoryPack> {
         where title ilike any($1::text[])
            or summary ilike any($1::text[])
         order by confidence desc, created_at desc
-        limit 6
+        limit ${STORY_LIMIT}
         `,
         [patterns]
       )
@@ -158,7 +220,7 @@ export async function getMemoryPack(query: string): Promise<MemoryPack> {
         select title, summary, namespace, confidence
         from mind.story
         order by confidence desc, created_at desc
-        limit 6
+        limit ${STORY_LIMIT}
         `
       );
 
@@ -171,7 +233,7 @@ export async function getMemoryPack(query: string): Promise<MemoryPack> {
           and object_text is not null
           and object_text ilike any($1::text[])
         order by created_at desc
-        limit 10
+        limit ${INTEREST_LIMIT}
         `,
         [patterns]
       )
@@ -182,7 +244,7 @@ export async function getMemoryPack(query: string): Promise<MemoryPack> {
         where namespace = 'interest'
           and object_text is not null
         order by created_at desc
-        limit 10
+        limit ${INTEREST_LIMIT}
         `
       );
 
@@ -192,21 +254,9 @@ export async function getMemoryPack(query: string): Promise<MemoryPack> {
     interestQuery
   ]);
 
-  return {
-    selfFacts: (selfFactsRes.rows as SelfFactRow[]).map((r: SelfFactRow) => ({
-      predicate: String(r.predicate ?? ""),
-      object: String(r.object ?? ""),
-      confidence: Number(r.confidence ?? 0.5)
-    })),
-    stories: (storiesRes.rows as StoryRow[]).map((r: StoryRow) => ({
-      title: String(r.title ?? ""),
-      summary: String(r.summary ?? ""),
-      namespace: String(r.namespace ?? ""),
-      confidence: Number(r.confidence ?? 0.5)
-    })),
-    interestQueries: (interestRes.rows as InterestRow[]).map((r: InterestRow) => ({
-      query: String(r.query ?? ""),
-      createdAt: r.created_at ? String(r.created_at) : null
-    }))
-  };
+  return toMemoryPack(
+    selfFactsRes.rows as SelfFactRow[],
+    storiesRes.rows as StoryRow[],
+    interestRes.rows as InterestRow[]
+  );
 }
@@ -0,0 +1,200 @@
+import { getPool } from "@/app/lib/pg";
+
+/**
+ * In-memory retrieval over the mind DB (native/memory-index-addon.cpp)
+ *
+ * Server-side only. Set MEMORY_INDEX_ADDON to the built addon
+ * (build-native/memory-index.node) to enable it. The self facts, stories
+ * and interests are loaded once into three BM25 indexes and reloaded in
+ * the background once a minute. Without the addon, or until a load
+ * succeeds, getMemoryIndex() returns null and getMemoryPack queries
+ * Postgres as before.
+ */
+
+export type IndexedSelfFact = {
+  predicate: string | null;
+  object: string | null;
+  confidence: number | string | null;
+};
+
+export type IndexedStory = {
+  title: string | null;
+  summary: string | null;
+  namespace: string | null;
+  confidence: number | string | null;
+};
+
+export type IndexedInterest = {
+  query: string | null;
+  created_at: string | null;
+};
+
+type Timestamped = { created_at: string | Date | null };
+
+type NativeIndex = {
+  search(query: string, k: number, confidenceWeight?: number): Uint32Array;
+  top(k: number, byRecency?: boolean): Uint32Array;
+};
+
+type Addon = {
+  MemoryIndex: new (
+    texts: string[],
+    confidence: Float32Array,
+    createdAt: Float64Array
+  ) => NativeIndex;
+};
+
+/**
+ * Rows plus their index; results come back as the rows themselves
+ */
+export class MemoryCorpus<Row> {
+  private readonly index: NativeIndex;
+
+  constructor(
+    addon: Addon,
+    private readonly rows: Row[],
+    text: (row: Row) => string,
+    confidence: (row: Row) => unknown,
+    createdAt: (row: Row) => unknown
+  ) {
+    this.index = new addon.MemoryIndex(
+      rows.map(text),
+      Float32Array.from(rows, (row) => toNumber(confidence(row), 0.5)),
+      Float64Array.from(rows, (row) => toTime(createdAt(row)))
+    );
+  }
+
+  /**
+   * Best k rows for the query: BM25 over tokensFromText's tokens,
+   * blended with confidence
+   */
+  search(query: string, k: number): Row[] {
+    return Array.from(this.index.search(query, k), (i) => this.rows[i]);
+  }
+
+  /**
+   * Most confident rows, or the newest ones
+   */
+  top(k: number, byRecency = false): Row[] {
+    return Array.from(this.index.top(k, byRecency), (i) => this.rows[i]);
+  }
+}
+
+export type MemoryIndex = {
+  selfFacts: MemoryCorpus<IndexedSelfFact>;
+  stories: MemoryCorpus<IndexedStory>;
+  interests: MemoryCorpus<IndexedInterest>;
+};
+
+// Facts written mid-conversation show up within this long
+const REFRESH_MS = 60_000;
+
+let addon: Addon | null | undefined;
+let current: MemoryIndex | null = null;
+let attemptedAt = -Infinity;
+
+function toNumber(value: unknown, fallback: number): number {
+  const n = Number(value ?? fallback);
+  return Number.isFinite(n) ? n : fallback;
+}
+
+function toTime(value: unknown): number {
+  if (value == null) return 0;
+  const t = new Date(value as string | Date).getTime();
+  return Number.isFinite(t) ? t : 0;
+}
+
+function loadAddon(): Addon | null {
+  if (addon !== undefined) return addon;
+  const path = process.env.MEMORY_INDEX_ADDON;
+  addon = null;
+  if (!path) return addon;
+  try {
+    // dlopen keeps the bundler away from the .node file
+    const loaded = { exports: {} as Addon };
+    process.dlopen(loaded, path);
+    addon = loaded.exports;
+  } catch (error) {
+    console.error(`[MemoryIndex] Failed to load addon: ${path}`, error);
+  }
+  return addon;
+}
+
+async function build(native: Addon): Promise<MemoryIndex> {
+  const db = getPool();
+  const [selfFacts, stories, interests] = await Promise.all([
+    db.query<IndexedSelfFact & Timestamped & { object_text: string | null }>(
+      `
+      select
+        predicate,
+        object_text,
+        coalesce(nullif(trim(object_text), ''), object_json::text, object_date::text, object_number::text, object_bool::text) as object,
+        confidence,
+        created_at
+      from mind.fact
+      where namespace = 'self'
+        and coalesce(nullif(trim(object_text), ''), object_json::text, object_date::text, object_number::text, object_bool::text) is not null
+      `
+    ),
+    db.query<IndexedStory & Timestamped>(
+      `
+      select title, summary, namespace, confidence, created_at
+      from mind.story
+      `
+    ),
+    db.query<IndexedInterest & { confidence: number | string | null }>(
+      `
+      select object_text as query, confidence, created_at
+      from mind.fact
+      where namespace = 'interest'
+        and object_text is not null
+      `
+    )
+  ]);
+
+  // Indexed text is what the ilike queries matched
+  return {
+    selfFacts: new MemoryCorpus(
+      native,
+      selfFacts.rows,
+      (r) => `${r.predicate ?? ""}\n${r.object_text ?? ""}`,
+      (r) => r.confidence,
+      (r) => r.created_at
+    ),
+    stories: new MemoryCorpus(
+      native,
+      stories.rows,
+      (r) => `${r.title ?? ""}\n${r.summary ?? ""}`,
+      (r) => r.confidence,
+      (r) => r.created_at
+    ),
+    interests: new MemoryCorpus(
+      native,
+      interests.rows,
+      (r) => String(r.query ?? ""),
+      (r) => r.confidence,
+      (r) => r.created_at
+    )
+  };
+}
+
+/**
+ * The latest index, starting a reload at most once per REFRESH_MS; null
+ * while unavailable
+ */
+export function getMemoryIndex(): MemoryIndex | null {
+  const native = loadAddon();
+  if (!native) return null;
+  const now = Date.now();
+  if (now - attemptedAt > REFRESH_MS) {
+    attemptedAt = now;
+    build(native)
+      .then((index) => {
+        current = index;
+      })
+      .catch((error) => {
+        console.error("[MemoryIndex] Failed to build index", error);
+      });
+  }
+  return current;
+}
@@ -0,0 +1,100 @@
+/**
+ * MicrophoneFeed - Raw PCM from a microphone MediaStream, read per frame
+ *
+ * Taps the stream with an AudioWorklet (not routed to the speakers) that
+ * posts every captured sample, downmixed to mono, in fixed-size blocks.
+ * read() returns the samples received since the previous read, for the
+ * engine's voice activity detector, with nothing duplicated or skipped.
+ * Reads reuse one buffer, so callers must copy the result before reading
+ * again.
+ *
+ * Browsers without AudioWorklet are not supported: the constructor
+ * throws.
+ */
+
+const WORKLET_URL = "/lit-land/microphone-capture-worklet.js";
+
+// Samples held between reads (a multiple of the worklet's block size).
+// A longer gap, e.g. a hidden tab, keeps only the newest; the engine's
+// PCM ring (avatar::PcmRing::kCapacity) would drop the rest anyway.
+const MAX_BACKLOG = 8192;
+
+export class MicrophoneFeed {
+  private audioContext: AudioContext;
+  private source: MediaStreamAudioSourceNode;
+  private node: AudioWorkletNode | null = null;
+  private blocks: Float32Array[] = [];
+  private queued = 0;
+  private buffer = new Float32Array(MAX_BACKLOG);
+  private closed = false;
+
+  constructor(stream: MediaStream) {
+    if (typeof AudioWorkletNode === "undefined") {
+      throw new Error("AudioWorklet is not supported");
+    }
+    this.audioContext = new (window.AudioContext || (window as any).webkitAudioContext)();
+    this.source = this.audioContext.createMediaStreamSource(stream);
+    this.audioContext.audioWorklet
+      .addModule(WORKLET_URL)
+      .then(() => {
+        if (this.closed) return;
+        const node = new AudioWorkletNode(this.audioContext, "microphone-capture", {
+          numberOfOutputs: 0,
+          channelCount: 1,
+          channelCountMode: "explicit",
+        });
+        node.port.onmessage = (event) => {
+          if (event.data.type === "pcm") this.enqueue(event.data.samples);
+        };
+        this.source.connect(node);
+        this.node = node;
+      })
+      .catch((error) => {
+        console.error("[MicrophoneFeed] Failed to load capture worklet", error);
+      });
+  }
+
+  get sampleRate(): number {
+    return this.audioContext.sampleRate;
+  }
+
+  /**
+   * Samples captured since the last call (newest MAX_BACKLOG at most)
+   */
+  read(): Float32Array | undefined {
+    const ctx = this.audioContext;
+    if (ctx.state === "suspended") {
+      ctx.resume().catch(() => {});
+      return undefined;
+    }
+    if (this.queued === 0) return undefined;
+
+    let offset = 0;
+    for (const block of this.blocks) {
+      this.buffer.set(block, offset);
+      offset += block.length;
+    }
+    this.blocks = [];
+    this.queued = 0;
+    return this.buffer.subarray(0, offset);
+  }
+
+  /**
+   * Disconnect and close the context; the stream's tracks are left to
+   * their owner
+   */
+  close(): void {
+    this.closed = true;
+    if (this.node) this.node.port.onmessage = null;
+    this.source.disconnect();
+    this.audioContext.close().catch(() => {});
+  }
+
+  private enqueue(samples: Float32Array): void {
+    this.blocks.push(samples);
+    this.queued += samples.length;
+    while (this.queued > MAX_BACKLOG) {
+      this.queued -= this.blocks.shift()!.length;
+    }
+  }
+}
@@ -20,6 +20,12 @@ export interface PerformanceMetrics {
   animationFPS?: number;
   morphTargetUpdateTime?: number;
 
+  // Engine Frame Time Percentiles (from WASM histograms, ms)
+  engineFrameTimeP50?: number;
+  engineFrameTimeP99?: number;
+  engineFrameTimeP999?: number;
+  engineFrameTimeMax?: number;
+
   // Memory Metrics
   heapSizeUsed?: number;
   heapSizeTotal?: number;
@@ -145,6 +151,32 @@ class PerformanceMonitor {
     this.metrics.morphTargetUpdateTime = duration;
   }
 
+  /**
+   * Record engine frame time percentiles
+   * Sampled periodically from AvatarController.getFrameTimeStats()
+   */
+  recordEngineFrameTimes(stats: {
+    p50: number;
+    p99: number;
+    p999: number;
+    max: number;
+  }) {
+    if (!this.enabled) return;
+
+    this.metrics.engineFrameTimeP50 = stats.p50;
+    this.metrics.engineFrameTimeP99 = stats.p99;
+    this.metrics.engineFrameTimeP999 = stats.p999;
+    this.metrics.engineFrameTimeMax = stats.max;
+  }
+
+  /**
+   * Record median audio-to-mouth latency (ms) measured by the engine
+   */
+  recordAudioLatency(latencyMs: number) {
+    if (!this.enabled) return;
+    this.metrics.audioLatency = latencyMs;
+  }
+
   /**
    * Record memory usage
    */
@@ -288,6 +320,13 @@ class PerformanceMonitor {
       );
     }
 
+    // Check engine frame time tail (stutters hidden by average FPS)
+    if (metrics.engineFrameTimeP99 && metrics.engineFrameTimeP99 > 33) {
+      issues.push(
+        `Engine p99 frame time too high: ${metrics.engineFrameTimeP99.toFixed(1)}ms (target: <33ms)`
+      );
+    }
+
     // Check audio analysis time
     if (metrics.audioAnalysisTime && metrics.audioAnalysisTime > 5) {
       issues.push(
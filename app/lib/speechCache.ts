@@ -0,0 +1,133 @@
+import { connect } from "node:net";
+
+/**
+ * Client for the native speech cache (native/speech-cache-server.cpp)
+ *
+ * Server-side only. Set SPEECH_CACHE_SOCKET to the service's Unix
+ * socket to enable it. Without it, or while the service is down or
+ * slow, lookups report the cache as unavailable and stores are skipped,
+ * so synthesis behaves exactly as it did without a cache.
+ */
+
+export type CachedSpeech = {
+  key: string;  // content address: the service's key digest
+  audio: Uint8Array | null;  // MP3; null on a miss
+  timing: Uint8Array | null;  // see speechTiming.ts; null until uploaded
+};
+
+// The cache must never be what makes a reply slow
+const REQUEST_TIMEOUT_MS = 250;
+
+type Reply = { line: string; payload: Buffer };
+
+/**
+ * Send one request and read the reply line plus the payload bytes the
+ * line announces; null if the service can't be reached in time
+ */
+function request(
+  head: string,
+  fields: Uint8Array[],
+  payloadBytes: (line: string) => number
+): Promise<Reply | null> {
+  const socketPath = process.env.SPEECH_CACHE_SOCKET;
+  if (!socketPath) return Promise.resolve(null);
+
+  return new Promise((resolve) => {
+    const socket = connect(socketPath);
+    let received = Buffer.alloc(0);
+    let settled = false;
+    const finish = (reply: Reply | null) => {
+      if (settled) return;
+      settled = true;
+      socket.destroy();
+      resolve(reply);
+    };
+
+    socket.setTimeout(REQUEST_TIMEOUT_MS, () => finish(null));
+    socket.on("error", () => finish(null));
+    socket.on("close", () => finish(null));
+    socket.on("connect", () => {
+      socket.write(head + "\n");
+      for (const field of fields) socket.write(field);
+    });
+    socket.on("data", (chunk: Buffer) => {
+      received = Buffer.concat([received, chunk]);
+      const newline = received.indexOf(0x0a);
+      if (newline < 0) return;
+      const line = received.subarray(0, newline).toString("latin1");
+      const wanted = payloadBytes(line);
+      if (received.length - newline - 1 < wanted) return;
+      finish({ line, payload: received.subarray(newline + 1, newline + 1 + wanted) });
+    });
+  });
+}
+
+const encoder = new TextEncoder();
+
+function keyFields(voiceId: string, emotion: string, text: string): Uint8Array[] {
+  return [encoder.encode(voiceId), encoder.encode(emotion), encoder.encode(text)];
+}
+
+/**
+ * Look up synthesized speech; null if the cache is unavailable
+ */
+export async function lookupSpeech(
+  voiceId: string,
+  emotion: string,
+  text: string
+): Promise<CachedSpeech | null> {
+  const fields = keyFields(voiceId, emotion, text);
+  const reply = await request(
+    `GET ${fields.map((field) => field.length).join(" ")}`,
+    fields,
+    (line) => {
+      const [verb, , audio, timing] = line.split(" ");
+      return verb === "HIT" ? Number(audio) + Number(timing) : 0;
+    }
+  );
+  if (!reply) return null;
+
+  const [verb, key, audioBytes, timingBytes] = reply.line.split(" ");
+  if (verb === "MISS") return { key, audio: null, timing: null };
+  if (verb !== "HIT") return null;
+  const audioLength = Number(audioBytes);
+  return {
+    key,
+    audio: new Uint8Array(reply.payload.subarray(0, audioLength)),
+    timing:
+      Number(timingBytes) > 0
+        ? new Uint8Array(reply.payload.subarray(audioLength))
+        : null,
+  };
+}
+
+/**
+ * Store synthesized speech; resolves its key, or null if not stored
+ */
+export async function storeSpeech(
+  voiceId: string,
+  emotion: string,
+  text: string,
+  audio: Uint8Array
+): Promise<string | null> {
+  const fields = keyFields(voiceId, emotion, text);
+  const reply = await request(
+    `PUT ${fields.map((field) => field.length).join(" ")} ${audio.length}`,
+    [...fields, audio],
+    () => 0
+  );
+  const [verb, key] = reply?.line.split(" ") ?? [];
+  return verb === "OK" ? key : null;
+}
+
+/**
+ * Attach aligned viseme timing (speechTiming.ts layout) to a stored
+ * entry; false if the entry is gone or the cache is unavailable
+ */
+export async function storeSpeechTiming(
+  key: string,
+  timing: Uint8Array
+): Promise<boolean> {
+  const reply = await request(`TIMING ${key} ${timing.length}`, [timing], () => 0);
+  return reply?.line.startsWith("OK ") ?? false;
+}
@@ -0,0 +1,219 @@
+/**
+ * SpeechStreamPlayer - Decode and play an MP3 speech stream as it arrives
+ *
+ * Fetch chunks go to the engine, which cuts them into whole MP3 frames
+ * (avatar-speech-stream.h). Each frame is decoded with WebCodecs as soon
+ * as it is complete. The decoded PCM, downmixed to mono, goes both back
+ * to the engine (analysis ahead of the playhead) and to an AudioWorklet
+ * that plays it. The worklet reports its position, from which the
+ * playhead is extrapolated on the audio clock each frame. The engine
+ * analyses the mouth from that PCM ahead of time and samples it at the
+ * playhead (avatar-lookahead-lipsync.h).
+ *
+ * Browsers without AudioDecoder or AudioWorklet are not supported; the
+ * caller falls back to the <audio> element path.
+ */
+
+const WORKLET_URL = "/lit-land/speech-player-worklet.js";
+
+/**
+ * The engine side of the stream (implemented by AvatarController)
+ */
+export interface SpeechStreamSink {
+  /** Copy encoded bytes into the engine */
+  pushBytes(bytes: Uint8Array): void;
+  /** The byte stream ended; releases the last frame */
+  endBytes(): void;
+  /** Next whole frame, a view valid until the next pushBytes, or null */
+  nextFrame(): Uint8Array | null;
+  /** Stream format, once the first frame has been found */
+  format(): { sampleRate: number; channels: number } | null;
+  /** Decoded mono PCM at format().sampleRate, in order */
+  pushPcm(samples: Float32Array): void;
+  /** Every frame has been decoded */
+  endPcm(): void;
+}
+
+export class SpeechStreamPlayer {
+  private audioContext: AudioContext | null = null;
+  private workletReady: Promise<void> | null = null;
+  private node: AudioWorkletNode | null = null;
+  private decoder: AudioDecoder | null = null;
+  private reader: ReadableStreamDefaultReader<Uint8Array> | null = null;
+  private sourceRate = 0;
+  private frameSamples = 0;
+  private framesQueued = 0;
+  private playedSamples = 0;
+  private reportTime = 0;
+  private playing = false;
+  private stopWaiting: (() => void) | null = null;
+
+  static isSupported(): boolean {
+    return typeof AudioDecoder !== "undefined" && typeof AudioWorkletNode !== "undefined";
+  }
+
+  /**
+   * Seconds of the current stream audible now, extrapolated from the last
+   * worklet report on the audio clock, less the output latency the
+   * rendered samples still have to go through (0 when nothing is playing)
+   */
+  get playheadSeconds(): number {
+    const context = this.audioContext;
+    if (!this.playing || !context || this.sourceRate <= 0) return 0;
+    const since = Math.max(0, context.currentTime - this.reportTime);
+    const latency = (context.baseLatency || 0) + (context.outputLatency || 0);
+    return Math.max(0, this.playedSamples / this.sourceRate + Math.min(since, 0.05) - latency);
+  }
+
+  get isPlaying(): boolean {
+    return this.playing;
+  }
+
+  /**
+   * Decode and play a stream to the end; resolves when playback finishes
+   * or stop() is called. A new play() stops the previous one.
+   */
+  async play(stream: ReadableStream<Uint8Array>, sink: SpeechStreamSink): Promise<void> {
+    this.stop();
+    const context = await this.ensureContext();
+    const reader = stream.getReader();
+    this.reader = reader;
+    this.playing = true;
+    this.playedSamples = 0;
+    this.reportTime = context.currentTime;
+    this.sourceRate = 0;
+    this.framesQueued = 0;
+
+    const node = new AudioWorkletNode(context, "speech-player", {
+      numberOfInputs: 0,
+      outputChannelCount: [1],
+    });
+    node.connect(context.destination);
+    this.node = node;
+    const done = new Promise<void>((resolve) => {
+      node.port.onmessage = (event) => {
+        const message = event.data;
+        if (message.type === "position") {
+          this.playedSamples = message.played;
+          this.reportTime = message.time;
+        } else if (message.type === "done") {
+          resolve();
+        }
+      };
+      this.stopWaiting = resolve;
+    });
+
+    try {
+      for (;;) {
+        const { value, done: ended } = await reader.read();
+        if (ended || this.reader !== reader) break;
+        sink.pushBytes(value);
+        this.decodeFrames(sink, node);
+      }
+      if (this.reader === reader) {
+        sink.endBytes();
+        this.decodeFrames(sink, node);
+        if (this.decoder && this.decoder.state === "configured") {
+          await this.decoder.flush();
+        }
+        sink.endPcm();
+        node.port.postMessage({ type: "end" });
+        await done;
+      }
+    } finally {
+      if (this.node === node) this.stop();
+    }
+  }
+
+  /**
+   * Stop playback and decoding; the stream is cancelled
+   */
+  stop(): void {
+    this.reader?.cancel().catch(() => {});
+    this.reader = null;
+    if (this.decoder && this.decoder.state !== "closed") this.decoder.close();
+    this.decoder = null;
+    if (this.node) {
+      this.node.port.postMessage({ type: "stop" });
+      this.node.disconnect();
+      this.node = null;
+    }
+    this.playing = false;
+    this.stopWaiting?.();
+    this.stopWaiting = null;
+  }
+
+  close(): void {
+    this.stop();
+    this.audioContext?.close().catch(() => {});
+    this.audioContext = null;
+    this.workletReady = null;
+  }
+
+  private async ensureContext(): Promise<AudioContext> {
+    if (!this.audioContext) {
+      this.audioContext = new AudioContext();
+      this.workletReady = this.audioContext.audioWorklet.addModule(WORKLET_URL);
+    }
+    await this.workletReady;
+    if (this.audioContext.state === "suspended") {
+      await this.audioContext.resume().catch(() => {});
+    }
+    return this.audioContext;
+  }
+
+  /**
+   * Hand every complete frame to the decoder, configuring it (and the
+   * worklet) from the stream format on the first one
+   */
+  private decodeFrames(sink: SpeechStreamSink, node: AudioWorkletNode): void {
+    for (let frame = sink.nextFrame(); frame; frame = sink.nextFrame()) {
+      if (!this.decoder) {
+        const format = sink.format();
+        if (!format) return;
+        this.sourceRate = format.sampleRate;
+        this.frameSamples = format.sampleRate >= 32000 ? 1152 : 576;
+        node.port.postMessage({ type: "format", sampleRate: format.sampleRate });
+        this.decoder = new AudioDecoder({
+          output: (data) => this.deliver(data, sink, node),
+          error: (error) => console.error("[SpeechStreamPlayer] Decode error:", error),
+        });
+        this.decoder.configure({
+          codec: "mp3",
+          sampleRate: format.sampleRate,
+          numberOfChannels: format.channels,
+        });
+      }
+      // EncodedAudioChunk copies the frame out of engine memory
+      this.decoder.decode(
+        new EncodedAudioChunk({
+          type: "key",
+          timestamp: (this.framesQueued * this.frameSamples * 1e6) / this.sourceRate,
+          data: frame,
+        })
+      );
+      this.framesQueued++;
+    }
+  }
+
+  private deliver(data: AudioData, sink: SpeechStreamSink, node: AudioWorkletNode): void {
+    try {
+      const frames = data.numberOfFrames;
+      const mono = new Float32Array(frames);
+      const plane = new Float32Array(frames);
+      for (let c = 0; c < data.numberOfChannels; c++) {
+        data.copyTo(plane, { planeIndex: c, format: "f32-planar" });
+        for (let i = 0; i < frames; i++) mono[i] += plane[i];
+      }
+      if (data.numberOfChannels > 1) {
+        const scale = 1 / data.numberOfChannels;
+        for (let i = 0; i < frames; i++) mono[i] *= scale;
+      }
+      if (this.node !== node) return;  // stopped meanwhile
+      sink.pushPcm(mono);
+      node.port.postMessage({ type: "pcm", samples: mono }, [mono.buffer]);
+    } finally {
+      data.close();
+    }
+  }
+}
@@ -0,0 +1,75 @@
+/**
+ * Viseme timing cached with synthesized speech
+ *
+ * The engine's aligned plan as keys + 1 values in seconds: each key's
+ * start, then the end of the last key (getSpeechPlanTiming's layout).
+ * It travels as base64 little-endian float32, in the X-Viseme-Timing
+ * header of a cache hit and in uploads to /api/voice/synthesize/timing.
+ */
+
+export const SPEECH_CACHE_KEY_HEADER = "X-Speech-Cache-Key";
+export const SPEECH_TIMING_HEADER = "X-Viseme-Timing";
+
+/**
+ * The speech cache entry behind a synthesized reply: its key, and its
+ * timing when a hit carried one
+ */
+export type SpeechCacheEntry = {
+  key: string;
+  timing: Float32Array | null;
+};
+
+// Key starts plus the end; a 1000-character reply plans far fewer keys
+export const MAX_TIMING_VALUES = 4096;
+
+// Synthesis is capped at 1000 characters, well under ten minutes
+const MAX_TIMING_SECONDS = 600;
+
+/**
+ * Cache keys are the service's 64-bit key digest in lowercase hex
+ */
+export function isSpeechCacheKey(key: unknown): key is string {
+  return typeof key === "string" && /^[0-9a-f]{16}$/.test(key);
+}
+
+/**
+ * Ascending, finite, within the synthesis limits
+ */
+export function isValidTiming(values: Float32Array): boolean {
+  if (values.length < 2 || values.length > MAX_TIMING_VALUES) return false;
+  for (let i = 0; i < values.length; i++) {
+    const value = values[i];
+    if (!Number.isFinite(value) || value < 0 || value > MAX_TIMING_SECONDS) {
+      return false;
+    }
+    if (i > 0 && value < values[i - 1]) return false;
+  }
+  return true;
+}
+
+export function encodeSpeechTiming(values: Float32Array): string {
+  const bytes = new Uint8Array(values.length * 4);
+  const view = new DataView(bytes.buffer);
+  values.forEach((value, i) => view.setFloat32(i * 4, value, true));
+  let binary = "";
+  for (let i = 0; i < bytes.length; i++) binary += String.fromCharCode(bytes[i]);
+  return btoa(binary);
+}
+
+/**
+ * Decode and validate; null if the text is not well-formed timing
+ */
+export function decodeSpeechTiming(encoded: string): Float32Array | null {
+  let binary: string;
+  try {
+    binary = atob(encoded);
+  } catch {
+    return null;
+  }
+  if (binary.length % 4 !== 0) return null;
+  const view = new DataView(new ArrayBuffer(binary.length));
+  for (let i = 0; i < binary.length; i++) view.setUint8(i, binary.charCodeAt(i));
+  const values = new Float32Array(binary.length / 4);
+  for (let i = 0; i < values.length; i++) values[i] = view.getFloat32(i * 4, true);
+  return isValidTiming(values) ? values : null;
+}
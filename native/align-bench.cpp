@@ -0,0 +1,325 @@
+/**
+ * align-bench.cpp - Forced alignment accuracy and cost
+ *
+ * Plans a viseme timeline from text, then renders "true" audio from a
+ * copy whose keys are individually 0.6-1.5x their planned length, with
+ * silence before and after. Vowels and sonorants are glottal pulses
+ * through two formants, fricatives shaped noise, stops a closure and a
+ * burst. Aligning the plan to that audio should recover the true key
+ * starts far better than stretching the whole plan to the audio length,
+ * which is what playback does without alignment. The check runs over a
+ * few seeds. Then a 30 s utterance is aligned repeatedly for cost.
+ *
+ * Usage: align-bench [speech.wav "spoken text"]
+ *   With a recording, prints the aligned keys instead of the synthetic
+ *   checks.
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative native/align-bench.cpp \
+ *     -o build-native/align-bench
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "avatar-align.h"
+#include "avatar-g2p.h"
+#include "avatar-simd.h"
+#include "avatar-visemes.h"
+#include "synthetic-speech.h"
+#include "wav-io.h"
+
+namespace {
+  using avatar::synthetic::detail::Resonator;
+  using avatar::synthetic::detail::Rng;
+
+  constexpr uint32_t kRate = 48000;
+  constexpr float kLeadIn = 0.25f;
+  constexpr float kTail = 0.3f;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectBelow(const char* name, double actual, double limit) {
+    if (!(actual < limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected < %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  struct Voice {
+    float f1, f2, gain;  // gain 0: unvoiced
+  };
+
+  Voice voiceFor(uint8_t viseme) {
+    switch (viseme) {
+      case avatar::kVisAA: return {700, 1200, 1.0f};
+      case avatar::kVisE: return {500, 1800, 1.0f};
+      case avatar::kVisIH: return {300, 2200, 0.9f};
+      case avatar::kVisOH: return {500, 900, 1.0f};
+      case avatar::kVisOU: return {320, 800, 0.9f};
+      case avatar::kVisRR: return {450, 1300, 0.8f};
+      case avatar::kVisNN: return {250, 1200, 0.6f};
+      default: return {0, 0, 0.0f};
+    }
+  }
+
+  /**
+   * Audio for a timeline (seconds relative to speech start) placed after
+   * kLeadIn, with kTail of silence after the last key
+   */
+  std::vector<float> render(const avatar::VisemeTimeline& timeline,
+                            uint32_t seed) {
+    const float rate = static_cast<float>(kRate);
+    std::vector<float> out(
+        static_cast<size_t>((kLeadIn + timeline.seconds() + kTail) * rate),
+        0.0f);
+    Rng rng{seed * 2654435761u + 7u};
+    Resonator f1, f2, hiss;
+    float phase = 0.0f, previousPulse = 0.0f, noiseState = 0.0f;
+    for (size_t k = 0; k < timeline.size(); ++k) {
+      const auto& key = timeline.key(k);
+      const size_t begin = static_cast<size_t>((kLeadIn + key.start) * rate);
+      const size_t end = static_cast<size_t>((kLeadIn + key.end) * rate);
+      const float length = static_cast<float>(end - begin);
+      const Voice voice = voiceFor(key.viseme);
+      if (voice.gain > 0.0f) {
+        f1.tune(voice.f1, 80.0f, rate);
+        f2.tune(voice.f2, 120.0f, rate);
+      }
+      const uint8_t v = key.viseme;
+      if (v == avatar::kVisSS) hiss.tune(6000.0f, 2500.0f, rate);
+      if (v == avatar::kVisCH) hiss.tune(3000.0f, 1500.0f, rate);
+      if (v == avatar::kVisFF || v == avatar::kVisTH) {
+        hiss.tune(5000.0f, 5000.0f, rate);
+      }
+      for (size_t i = begin; i < end && i < out.size(); ++i) {
+        const float u = static_cast<float>(i - begin) / length;
+        const float edge = std::min({1.0f, u * length / (0.01f * rate),
+                                     (1.0f - u) * length / (0.01f * rate)});
+        const float noise = rng.uniform(-1.0f, 1.0f);
+        float s = 0.0f;
+        if (voice.gain > 0.0f) {
+          phase += 120.0f * (1.0f + 0.05f * std::sin(6.0f * u)) / rate;
+          if (phase >= 1.0f) phase -= 1.0f;
+          const float pulse = avatar::synthetic::detail::glottalPulse(phase);
+          const float source = pulse - previousPulse;
+          previousPulse = pulse;
+          s = voice.gain * (f1.process(source) + 0.5f * f2.process(source));
+        } else if (v == avatar::kVisSS || v == avatar::kVisCH) {
+          s = 0.05f * hiss.process(noise - noiseState);
+        } else if (v == avatar::kVisFF || v == avatar::kVisTH) {
+          s = 0.015f * hiss.process(noise - noiseState);
+        } else if (v != avatar::kVisSil && u > 0.75f) {
+          s = 0.02f * (noise - noiseState);  // stop release burst
+        }
+        noiseState = noise;
+        out[i] = edge * s;
+      }
+    }
+    float maxAbs = 1e-9f;
+    for (float s : out) maxAbs = std::max(maxAbs, std::fabs(s));
+    for (float& s : out) s *= 0.5f / maxAbs;
+    return out;
+  }
+
+  /** Planned timeline with each key 0.6-1.5x as long */
+  avatar::VisemeTimeline perturb(const avatar::VisemeTimeline& plan,
+                                 uint32_t seed) {
+    Rng rng{seed * 747796405u + 3u};
+    std::vector<float> starts(plan.size());
+    float t = 0.0f;
+    for (size_t k = 0; k < plan.size(); ++k) {
+      starts[k] = t;
+      const auto& key = plan.key(k);
+      t += (key.end - key.start) * rng.uniform(0.6f, 1.5f);
+    }
+    avatar::VisemeTimeline truth = plan;
+    truth.retime(starts.data(), t);
+    return truth;
+  }
+
+  avatar::VisemeTimeline planText(const avatar::GraphemeToPhoneme& g2p,
+                                  const std::string& text) {
+    std::vector<uint8_t> phonemes;
+    g2p.convert(text.data(), text.size(), phonemes);
+    avatar::VisemeTimeline timeline;
+    timeline.build(phonemes);
+    return timeline;
+  }
+
+  void accuracyTest(const avatar::GraphemeToPhoneme& g2p) {
+    const std::string text =
+        "Hello! I can help you map out the problem, then we build it step "
+        "by step. Measure first, and keep the design simple.";
+    const avatar::VisemeTimeline plan = planText(g2p, text);
+    avatar::SpeechAligner aligner;
+
+    double alignedError = 0.0, stretchedError = 0.0, worst = 0.0;
+    size_t boundaries = 0;
+    bool ordered = true;
+    for (uint32_t seed = 1; seed <= 5; ++seed) {
+      const avatar::VisemeTimeline truth = perturb(plan, seed);
+      const std::vector<float> audio = render(truth, seed);
+      const float audioSeconds =
+          static_cast<float>(audio.size()) / static_cast<float>(kRate);
+
+      avatar::VisemeTimeline aligned = plan;
+      if (!aligner.align(aligned, audio.data(), audio.size(),
+                         static_cast<float>(kRate))) {
+        expectTrue("alignment succeeds", false);
+        return;
+      }
+      // Without alignment, sync() stretches the plan over the whole audio
+      const float scale = audioSeconds / plan.seconds();
+      for (size_t k = 0; k < plan.size(); ++k) {
+        const double actual = kLeadIn + truth.key(k).start;
+        const double error = std::fabs(aligned.key(k).start - actual);
+        alignedError += error;
+        worst = std::max(worst, error);
+        stretchedError += std::fabs(plan.key(k).start * scale - actual);
+        ordered &= aligned.key(k).end > aligned.key(k).start;
+        ++boundaries;
+      }
+    }
+    alignedError /= static_cast<double>(boundaries);
+    stretchedError /= static_cast<double>(boundaries);
+    std::printf("     %zu keys x 5 utterances: aligned %.1f ms mean (worst "
+                "%.0f ms), stretched %.1f ms mean\n",
+                plan.size(), alignedError * 1e3, worst * 1e3,
+                stretchedError * 1e3);
+    expectTrue("aligned keys ascending", ordered);
+    expectBelow("mean aligned key start error (s)", alignedError, 0.025);
+    expectBelow("aligned error / stretched error",
+                alignedError / stretchedError, 0.25);
+  }
+
+  void degenerateTest(const avatar::GraphemeToPhoneme& g2p) {
+    avatar::VisemeTimeline plan = planText(g2p, "ok");
+    const avatar::VisemeTimeline before = plan;
+    avatar::SpeechAligner aligner;
+    const std::vector<float> blip(100, 0.1f);
+    expectTrue("too little audio leaves the plan alone",
+               !aligner.align(plan, blip.data(), blip.size(), 48000.0f) &&
+                   plan.key(0).start == before.key(0).start &&
+                   plan.seconds() == before.seconds());
+
+    // Silent audio still gives a valid, ascending timeline
+    const std::vector<float> silence(kRate, 0.0f);
+    bool ordered = aligner.align(plan, silence.data(), silence.size(),
+                                 static_cast<float>(kRate));
+    for (size_t k = 0; k < plan.size(); ++k) {
+      ordered &= plan.key(k).end > plan.key(k).start;
+    }
+    expectTrue("silence aligns to an ascending timeline", ordered);
+
+    avatar::VisemeTimeline empty;
+    expectTrue("empty plan refused",
+               !aligner.align(empty, silence.data(), silence.size(),
+                              static_cast<float>(kRate)));
+  }
+
+  void bench(const avatar::GraphemeToPhoneme& g2p) {
+    const std::string sentence =
+        "Let me help you turn confusion into clarity, one question at a "
+        "time. The best code is the code you can delete. ";
+    std::string text;
+    avatar::VisemeTimeline plan;
+    while (plan.seconds() < 30.0f - kLeadIn - kTail) {
+      text += sentence;
+      plan = planText(g2p, text);
+    }
+    const std::vector<float> audio = render(perturb(plan, 11), 11);
+    const double audioSeconds =
+        static_cast<double>(audio.size()) / static_cast<double>(kRate);
+
+    avatar::SpeechAligner aligner;
+    const int repeats = 10;
+    double featureMs = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+      avatar::VisemeTimeline aligned = plan;
+      aligner.align(aligned, audio.data(), audio.size(),
+                    static_cast<float>(kRate));
+    }
+    const double ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      repeats;
+    {
+      avatar::SpeechFeatures features;
+      const auto t0 = std::chrono::steady_clock::now();
+      for (int r = 0; r < repeats; ++r) {
+        features.extract(audio.data(), audio.size(),
+                         static_cast<float>(kRate));
+      }
+      featureMs = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - t0)
+                      .count() /
+                  repeats;
+    }
+    const double cells = static_cast<double>(aligner.dtw().cells());
+    std::printf("     [%s] %.1f s utterance, %zu keys, %u frames: %.2f ms "
+                "(features %.2f ms, DTW %.2f ms, %.2f ns/cell), %.0fx "
+                "real time, %zu KB\n",
+                avatar::simd::backendName(), audioSeconds, plan.size(),
+                aligner.features().frames(), ms, featureMs, ms - featureMs,
+                (ms - featureMs) * 1e6 / cells, audioSeconds * 1e3 / ms,
+                aligner.memoryBytes() / 1024);
+    expectBelow("alignment time / audio duration",
+                ms / (audioSeconds * 1e3), 0.05);
+  }
+
+  int alignRecording(const avatar::GraphemeToPhoneme& g2p, const char* path,
+                     const char* text) {
+    avatar::wav::Audio audio;
+    std::string error;
+    if (!avatar::wav::read(path, audio, &error)) {
+      std::fprintf(stderr, "Cannot read %s: %s\n", path, error.c_str());
+      return 1;
+    }
+    avatar::VisemeTimeline timeline = planText(g2p, text);
+    avatar::SpeechAligner aligner;
+    if (!aligner.align(timeline, audio.samples.data(), audio.samples.size(),
+                       static_cast<float>(audio.sampleRate))) {
+      std::fprintf(stderr, "Nothing to align\n");
+      return 1;
+    }
+    for (size_t k = 0; k < timeline.size(); ++k) {
+      const auto& key = timeline.key(k);
+      std::printf("%7.3f %7.3f %u\n", key.start, key.end, key.viseme);
+    }
+    return 0;
+  }
+}
+
+int main(int argc, char** argv) {
+  avatar::GraphemeToPhoneme g2p;
+  if (argc == 3) return alignRecording(g2p, argv[1], argv[2]);
+
+  accuracyTest(g2p);
+  degenerateTest(g2p);
+  bench(g2p);
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d alignment checks failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All alignment checks passed\n");
+  return 0;
+}
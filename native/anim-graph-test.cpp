@@ -0,0 +1,275 @@
+/**
+ * anim-graph-test.cpp - Animation graph compiler checks
+ *
+ * Compiles the built-in graph and the shipped asset
+ * (public/lit-land/animation-graph.json) and checks the flat tables:
+ * layer mixes, procedural weights, blend times with wildcard overrides,
+ * forbidden transitions, automatic exits and the no-skeleton fallback
+ * clip. Malformed assets must be rejected without replacing the graph
+ * that is already compiled. Also covers next-state prediction for clip
+ * preloading, and a few JSON reader edge cases.
+ *
+ * Usage: anim-graph-test [path/to/animation-graph.json]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib native/anim-graph-test.cpp \
+ *     -o build-native/anim-graph-test
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "avatar-anim-graph.h"
+#include "avatar-anim-predict.h"
+#include "avatar-state-block.h"
+
+namespace {
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance = 1e-6) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.3f, got %.3f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.3f\n", name, actual);
+    }
+  }
+
+  bool compile(avatar::AnimationGraph& graph, const std::string& text,
+               std::string* error = nullptr) {
+    return graph.compile(text.data(), text.size(), error);
+  }
+
+  uint32_t state(const avatar::AnimationGraph& graph, const char* name) {
+    return static_cast<uint32_t>(graph.findState(name));
+  }
+
+  void defaultGraphTest() {
+    avatar::AnimationGraph graph;
+    std::string error;
+    expectTrue("default graph compiles",
+               graph.compile(avatar::kDefaultAnimationGraph,
+                             std::strlen(avatar::kDefaultAnimationGraph),
+                             &error));
+    expectTrue("default has 3 states", graph.stateCount() == 3);
+    // Indices must match AnimationStateId and ANIMATION_STATE_IDS in JS
+    expectTrue("idle is 0", graph.findState("idle") == avatar::kStateIdle);
+    expectTrue("listening is 1",
+               graph.findState("listening") == avatar::kStateListening);
+    expectTrue("speaking is 2",
+               graph.findState("speaking") == avatar::kStateSpeaking);
+    expectTrue("unknown state", graph.findState("dancing") ==
+                                    avatar::AnimationGraph::kNoState);
+
+    const uint32_t listening = state(graph, "listening");
+    const float* mix = graph.targetWeights(listening);
+    expectNear("listening idle weight", mix[0], 1.0);
+    expectNear("listening headTilt weight", mix[1], 1.0);
+    expectNear("listening talking weight", mix[2], 0.0);
+    expectTrue("headTilt is additive head-only restart",
+               graph.layer(1).mode == avatar::kLayerAdditive &&
+                   graph.layer(1).headOnly && graph.layer(1).restart &&
+                   !graph.layer(1).loop);
+    expectTrue("fallback clips match the original single-clip states",
+               graph.layer(graph.fallbackLayer(0)).clip ==
+                       "Armature|ArmatureAction" &&
+                   graph.layer(graph.fallbackLayer(1)).clip == "HeadTilt" &&
+                   graph.layer(graph.fallbackLayer(2)).clip == "Talking");
+    expectNear("listening lookAt",
+               graph.procedural(listening)[avatar::kProcLookAt], 1.0);
+    expectNear("idle springBones",
+               graph.procedural(0)[avatar::kProcSpringBones], 1.0);
+    expectNear("speaking headNod",
+               graph.procedural(2)[avatar::kProcHeadNod], 1.0);
+    expectNear("default blend", graph.blendSeconds(0, 2), 0.25);
+    expectNear("no auto exit", graph.exitAfter(0), 0.0);
+  }
+
+  void assetTest(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      std::printf("skip asset test (%s not found)\n", path);
+      return;
+    }
+    std::stringstream text;
+    text << in.rdbuf();
+
+    avatar::AnimationGraph graph;
+    std::string error;
+    expectTrue("asset compiles", compile(graph, text.str(), &error));
+    if (!error.empty()) std::fprintf(stderr, "  %s\n", error.c_str());
+    if (graph.empty()) return;
+
+    expectTrue("built-in states keep their indices",
+               graph.findState("idle") == 0 &&
+                   graph.findState("listening") == 1 &&
+                   graph.findState("speaking") == 2);
+    const uint32_t idle = state(graph, "idle");
+    const uint32_t listening = state(graph, "listening");
+    const uint32_t speaking = state(graph, "speaking");
+    const uint32_t laughing = state(graph, "laughing");
+    const uint32_t nodding = state(graph, "nodding");
+
+    expectNear("* -> speaking blend", graph.blendSeconds(idle, speaking),
+               0.15);
+    expectNear("speaking -> listening overrides wildcard",
+               graph.blendSeconds(speaking, listening), 0.4);
+    expectNear("unlisted pair uses default",
+               graph.blendSeconds(listening, idle), 0.25);
+    expectNear("laughing -> * blend", graph.blendSeconds(laughing, idle), 0.5);
+    expectTrue("laughing -> nodding forbidden",
+               graph.blendSeconds(laughing, nodding) < 0.0f);
+    expectNear("nodding exits after", graph.exitAfter(nodding), 1.2);
+    expectTrue("nodding exits to listening",
+               graph.exitState(nodding) == listening);
+    expectNear("speaking brows", graph.procedural(speaking)[avatar::kProcBrows],
+               1.0);
+    expectNear("idle lookAt", graph.procedural(idle)[avatar::kProcLookAt], 0.5);
+    expectTrue("laughing falls back to the laughing clip",
+               graph.layer(graph.fallbackLayer(laughing)).clip == "Laughing");
+  }
+
+  void rejectTest() {
+    avatar::AnimationGraph graph;
+    compile(graph, avatar::kDefaultAnimationGraph);
+
+    struct Case {
+      const char* name;
+      const char* json;
+    };
+    const Case cases[] = {
+        {"rejects bad JSON", "{\"layers\": [}"},
+        {"rejects trailing data", "{} {}"},
+        {"rejects missing states", "{\"layers\": []}"},
+        {"rejects unknown layer",
+         R"({"layers": [{"name": "a", "clip": "A"}],
+             "states": [{"name": "s", "layers": {"b": 1}}]})"},
+        {"rejects duplicate state",
+         R"({"layers": [{"name": "a", "clip": "A"}],
+             "states": [{"name": "s"}, {"name": "s"}]})"},
+        {"rejects unknown transition state",
+         R"({"layers": [{"name": "a", "clip": "A"}],
+             "states": [{"name": "s"}],
+             "transitions": [{"from": "s", "to": "t"}]})"},
+        {"rejects bad exit",
+         R"({"layers": [{"name": "a", "clip": "A"}],
+             "states": [{"name": "s", "exit": {"after": 1, "to": "x"}}]})"},
+        {"rejects unknown procedural channel",
+         R"({"layers": [{"name": "a", "clip": "A"}],
+             "states": [{"name": "s", "procedural": {"wings": 1}}]})"},
+        {"rejects unknown mode",
+         R"({"layers": [{"name": "a", "clip": "A", "mode": "multiply"}],
+             "states": [{"name": "s"}]})"},
+    };
+    for (const Case& c : cases) {
+      std::string error;
+      expectTrue(c.name, !compile(graph, c.json, &error) && !error.empty());
+    }
+    expectTrue("rejected assets keep the previous graph",
+               graph.stateCount() == 3 && graph.findState("speaking") == 2);
+  }
+
+  void predictorTest() {
+    avatar::AnimationGraph graph;
+    compile(graph, R"({
+      "layers": [{"name": "a", "clip": "A"}],
+      "states": [{"name": "idle"}, {"name": "listening"},
+                 {"name": "speaking"}, {"name": "nodding",
+                  "exit": {"after": 1, "to": "listening"}},
+                 {"name": "laughing"}],
+      "transitions": [{"from": "*", "to": "speaking"},
+                      {"from": "listening", "to": "nodding"},
+                      {"from": "listening", "to": "laughing",
+                       "allowed": false}]})");
+
+    const uint32_t idle = state(graph, "idle");
+    const uint32_t listening = state(graph, "listening");
+    const uint32_t speaking = state(graph, "speaking");
+    const uint32_t nodding = state(graph, "nodding");
+    const uint32_t laughing = state(graph, "laughing");
+    expectTrue("hint: exit", graph.transitionHint(nodding, listening) == 3);
+    expectTrue("hint: explicit pair",
+               graph.transitionHint(listening, nodding) == 2);
+    expectTrue("hint: wildcard", graph.transitionHint(idle, speaking) == 1);
+    expectTrue("hint: default", graph.transitionHint(idle, listening) == 0);
+    expectTrue("hint: forbidden",
+               graph.transitionHint(listening, laughing) == 0);
+
+    avatar::TransitionPredictor predictor;
+    predictor.reset(graph.stateCount());
+    uint32_t next[3];
+    uint32_t n = predictor.predict(graph, listening, next, 2);
+    expectTrue("cold start follows hints",
+               n == 2 && next[0] == nodding && next[1] == speaking);
+    n = predictor.predict(graph, listening, next, 3);
+    bool forbidden = false;
+    for (uint32_t i = 0; i < n; ++i) forbidden |= next[i] == laughing;
+    expectTrue("forbidden transitions never predicted", !forbidden);
+
+    predictor.observe(listening, idle);
+    predictor.observe(listening, idle);
+    predictor.observe(listening, listening);  // self-transitions ignored
+    n = predictor.predict(graph, listening, next, 2);
+    expectTrue("observed transitions rank first",
+               n == 2 && next[0] == idle && next[1] == nodding);
+    expectTrue("self transition not counted",
+               predictor.observed(listening, listening) == 0);
+  }
+
+  void jsonTest() {
+    avatar::json::Value v;
+    const std::string text =
+        R"({"s": "a\"b\u00e9\ud83d\ude00", "n": -1.5e2, "t": true,
+            "z": null, "a": [1, [2], {}]})";
+    expectTrue("json parses", avatar::json::parse(text.data(), text.size(), v));
+    expectTrue("json escapes", v.find("s") &&
+                                   v.find("s")->string ==
+                                       "a\"b\xC3\xA9\xF0\x9F\x98\x80");
+    expectNear("json number", v.find("n")->numberOr(0.0), -150.0);
+    expectTrue("json bool/null",
+               v.find("t")->boolOr(false) && v.find("z")->isNull());
+    expectTrue("json nested", v.find("a")->items.size() == 3 &&
+                                  v.find("a")->items[1].items[0].number == 2.0);
+
+    // Input is a length-delimited slice, not a C string
+    const char slice[] = "[1, 2]garbage";
+    expectTrue("json respects length",
+               avatar::json::parse(slice, 6, v) && v.items.size() == 2);
+
+    std::string deep(100, '[');
+    deep += std::string(100, ']');
+    std::string error;
+    expectTrue("json depth limit",
+               !avatar::json::parse(deep.data(), deep.size(), v, &error));
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  defaultGraphTest();
+  assetTest(argc > 1 ? argv[1] : "public/lit-land/animation-graph.json");
+  rejectTest();
+  predictorTest();
+  jsonTest();
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d animation graph check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All animation graph checks passed\n");
+  return 0;
+}
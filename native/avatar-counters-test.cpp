@@ -0,0 +1,79 @@
+/**
+ * avatar-counters-test.cpp - Frame counter check against the reference avatar
+ *
+ * Compiles the avatar scene natively, loads the reference avatar from
+ * reference-avatar.h and checks the counters reported by getFrameCounters()
+ * after a frame is rendered.
+ *
+ * Build command (desktop LIT-LAND build in $LITLAND_ROOT):
+ *   g++ -std=c++17 -O2 -DAVATAR_NATIVE_HARNESS -Iapp/lib -Inative \
+ *     -I$LITLAND_ROOT/include native/avatar-counters-test.cpp \
+ *     -L$LITLAND_ROOT/build -llitland -o build-native/avatar-counters-test
+ */
+
+#include <cstdio>
+
+#include "../app/lib/avatar-scene-template.cpp"
+#include "reference-avatar.h"
+
+namespace {
+  int g_failures = 0;
+
+  void expectEqual(const char* name, uint32_t actual, uint32_t expected) {
+    if (actual != expected) {
+      std::fprintf(stderr, "FAIL %s: expected %u, got %u\n", name, expected,
+                   actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %u\n", name, actual);
+    }
+  }
+}
+
+int main() {
+  using namespace avatar::reference;
+
+  initScene();
+
+  std::vector<uint8_t> glb = buildReferenceAvatar();
+  loadAvatarModel(glb.data(), glb.size());
+
+  // Two active morphs: mouthOpen and eyesLookUp
+  const float morphs[4] = {0.6f, 0.0f, 0.2f, 0.0f};
+  updateMorphTargets(morphs, 0.0, 0.0);
+
+  // First frame uploads static geometry; the second is steady state
+  updateFrame();
+  const uint32_t firstUpload = getFrameCounters()->bytesUploaded;
+  updateFrame();
+  const avatar::FrameCounters& c = *getFrameCounters();
+
+  expectEqual("version", c.version, avatar::FrameCounters::kVersion);
+  expectEqual("sizeBytes", c.sizeBytes, sizeof(avatar::FrameCounters));
+  expectEqual("frameIndex", c.frameIndex, 2);
+  expectEqual("drawCalls", c.drawCalls, kPrimitiveCount);
+  expectEqual("triangles", c.triangles, kTriangleCount);
+  expectEqual("skinnedVertices", c.skinnedVertices, kVertexCount);
+  expectEqual("activeMorphs", c.activeMorphs, 2);
+  expectEqual("bonesEvaluated", c.bonesEvaluated, kBoneCount);
+  expectEqual("pipelineBinds", c.pipelineBinds, 1);
+  expectEqual("culledPrimitives", c.culledPrimitives, 0);
+
+  // Steady-state frames only upload bone matrices and morph weights
+  const uint32_t steadyUpload =
+      kBoneCount * 16 * sizeof(float) + kMorphTargetCount * sizeof(float);
+  expectEqual("bytesUploaded", c.bytesUploaded, steadyUpload);
+  if (firstUpload <= steadyUpload) {
+    std::fprintf(stderr, "FAIL first frame should upload geometry\n");
+    ++g_failures;
+  }
+
+  cleanup();
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d counter check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All counter checks passed\n");
+  return 0;
+}
@@ -0,0 +1,179 @@
+/**
+ * avatar-latency-test.cpp - Synthetic audio-to-mouth latency check
+ *
+ * 1. Impulse test: a click at a known sample is "played" through a
+ *    simulated output with fixed latency and analysed with the same window
+ *    and timestamp maths as AudioAnalyzer.getAudibleTimeMs(). The latency
+ *    reported by avatar::AudioMouthLatency must match the true
+ *    click-to-present time within half an analysis window.
+ * 2. Ahead test: an analysis that comes before the audio is audible is
+ *    recorded as a lead in kLatencyAnalysisAhead, not as 0 ms.
+ * 3. Scene test: updateMorphTargets() with timestamps a known distance in
+ *    the past must show up in getAudioLatencyStats() after one frame.
+ *
+ * Build command (desktop LIT-LAND build in $LITLAND_ROOT):
+ *   g++ -std=c++17 -O2 -DAVATAR_NATIVE_HARNESS -Iapp/lib -Inative \
+ *     -I$LITLAND_ROOT/include native/avatar-latency-test.cpp \
+ *     -L$LITLAND_ROOT/build -llitland -o build-native/avatar-latency-test
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../app/lib/avatar-scene-template.cpp"
+#include "reference-avatar.h"
+
+namespace {
+  int g_failures = 0;
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.3f +/- %.3f, got %.3f\n",
+                   name, expected, tolerance, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.3f\n", name, actual);
+    }
+  }
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  constexpr double kSampleRate = 48000.0;
+  constexpr int kWindow = 1024;            // analyser fftSize, > one frame hop
+  constexpr int kImpulseSample = 12000;    // 250 ms into the clip
+  constexpr double kPlayStartMs = 1000.0;  // context time 0 in wall time
+  constexpr double kOutputLatencyMs = 5.0;
+  constexpr double kFramePeriodMs = 1000.0 / 60.0;
+  constexpr double kBridgeMs = 1.0;        // analysis -> engine receive
+  constexpr double kRenderMs = 4.0;        // receive -> present
+
+  void impulseTest() {
+    std::vector<float> pcm(48000, 0.0f);
+    pcm[kImpulseSample] = 1.0f;
+
+    avatar::AudioMouthLatency latency;
+    const double impulseAudibleMs =
+        kPlayStartMs + kOutputLatencyMs + kImpulseSample / kSampleRate * 1000.0;
+
+    double truePresentMs = -1.0;
+    for (int frame = 0; frame < 60; ++frame) {
+      const double wallMs = kPlayStartMs + frame * kFramePeriodMs;
+
+      // The analyser window ends at the context's current sample
+      const int end = static_cast<int>((wallMs - kPlayStartMs) *
+                                       kSampleRate / 1000.0);
+      float energy = 0.0f;
+      for (int i = end - kWindow; i < end; ++i) {
+        if (i >= 0 && i < static_cast<int>(pcm.size())) {
+          energy += pcm[i] * pcm[i];
+        }
+      }
+      if (energy <= 0.0f) continue;
+
+      // Same estimate AudioAnalyzer makes: window centre plus output latency
+      const double audioTimeMs =
+          wallMs - kWindow / 2 / kSampleRate * 1000.0 + kOutputLatencyMs;
+      const double receivedMs = wallMs + kBridgeMs;
+      const double presentMs = receivedMs + kRenderMs;
+
+      latency.onMorphUpdate(audioTimeMs, wallMs, receivedMs);
+      latency.onPresent(presentMs);
+      truePresentMs = presentMs;
+      break;
+    }
+
+    expectTrue("impulse detected", truePresentMs > 0.0);
+    const double trueLatencyMs = truePresentMs - impulseAudibleMs;
+    const double halfWindowMs = kWindow / 2 / kSampleRate * 1000.0;
+    // Histogram buckets are ~6% wide on top of the window uncertainty
+    const double tolerance = halfWindowMs + trueLatencyMs * 0.07;
+    expectTrue("impulse heard before mouth moves", trueLatencyMs > 0.0);
+
+    expectNear("impulse total latency",
+               latency.stage(avatar::kLatencyTotal).maxMicros() / 1000.0,
+               trueLatencyMs, tolerance);
+    expectNear("impulse analysis latency",
+               latency.stage(avatar::kLatencyAnalysis).maxMicros() / 1000.0,
+               halfWindowMs - kOutputLatencyMs, 0.01);
+    expectNear("impulse bridge latency",
+               latency.stage(avatar::kLatencyBridge).maxMicros() / 1000.0,
+               kBridgeMs, 0.01);
+    expectNear("impulse present latency",
+               latency.stage(avatar::kLatencyPresent).maxMicros() / 1000.0,
+               kRenderMs, 0.01);
+    expectTrue("impulse sample recorded", latency.recentCount() == 1);
+  }
+
+  void aheadTest() {
+    avatar::AudioMouthLatency latency;
+    // Analysed 20 ms before audible, presented 10 ms before audible
+    latency.onMorphUpdate(100.0, 80.0, 81.0);
+    latency.onPresent(90.0);
+    expectNear("ahead analysis lead",
+               latency.stage(avatar::kLatencyAnalysisAhead).maxMicros() /
+                   1000.0,
+               20.0, 0.01);
+    expectTrue("ahead sample not in the analysis stage",
+               latency.stage(avatar::kLatencyAnalysis).count() == 0);
+    expectTrue("early present counted", latency.earlyCount() == 1);
+
+    latency.onMorphUpdate(100.0, 103.0, 104.0);
+    latency.onPresent(110.0);
+    expectTrue("late analysis in the analysis stage",
+               latency.stage(avatar::kLatencyAnalysis).count() == 1 &&
+                   latency.stage(avatar::kLatencyAnalysisAhead).count() == 1);
+  }
+
+  void sceneTest() {
+    initScene();
+    std::vector<uint8_t> glb = avatar::reference::buildReferenceAvatar();
+    loadAvatarModel(glb.data(), glb.size());
+    resetAudioLatencyStats();
+
+    const double kAudioAgoMs = 30.0;
+    const double kAnalysisAgoMs = 5.0;
+    const float morphs[4] = {0.8f, 0.1f, 0.2f, 0.0f};
+
+    const double now = emscripten_get_now();
+    updateMorphTargets(morphs, now - kAudioAgoMs, now - kAnalysisAgoMs);
+    updateFrame();
+    const double frameDoneMs = emscripten_get_now() - now;
+
+    const avatar::FrameTimePercentiles total = *getAudioLatencyStats(
+        avatar::kLatencyTotal);
+    expectTrue("scene sample count", total.count == 1.0f);
+    expectTrue("scene latency lower bound", total.max >= kAudioAgoMs * 0.94);
+    expectTrue("scene latency upper bound",
+               total.max <= (kAudioAgoMs + frameDoneMs) * 1.07);
+
+    // Non-audio updates must not produce samples
+    updateMorphTargets(morphs, 0.0, 0.0);
+    updateFrame();
+    expectTrue("idle updates ignored",
+               getAudioLatencyStats(avatar::kLatencyTotal)->count == 1.0f);
+
+    cleanup();
+  }
+}
+
+int main() {
+  impulseTest();
+  aheadTest();
+  sceneTest();
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d latency check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All latency checks passed\n");
+  return 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * avatar-scaling-bench.cpp - Loader / animation / skinning cost curves
+ *
+ * Sweeps one synthetic-avatar parameter at a time from a mid-sized base
+ * spec and, for each point, measures load time (loadAvatarModel) and steady
+ * frame cost split by phase, next to the generated model's exact work
+ * counts and the engine's counters and memory categories. Output is CSV
+ * on stdout, one row per point, ready to plot cost against the swept
+ * parameter.
+ *
+ * Usage: avatar-scaling-bench [sweep] [frames]
+ *   sweep: all (default), vertices, bones, depth, morphs, density, clip,
+ *          texture
+ *
+ * Build command (desktop LIT-LAND build in $LITLAND_ROOT):
+ *   g++ -std=c++17 -O2 -DAVATAR_NATIVE_HARNESS -Iapp/lib -Inative \
+ *     -I$LITLAND_ROOT/include native/avatar-scaling-bench.cpp \
+ *     -L$LITLAND_ROOT/build -llitland -o build-native/avatar-scaling-bench
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../app/lib/avatar-scene-template.cpp"
+#include "synthetic-avatar.h"
+
+namespace {
+  constexpr int kLoadRepeats = 5;
+  constexpr int kWarmupFrames = 30;
+  constexpr int kDefaultFrames = 300;
+
+  avatar::synthetic::AvatarSpec baseSpec() {
+    avatar::synthetic::AvatarSpec spec;
+    spec.vertexCount = 16384;
+    spec.boneCount = 64;
+    spec.hierarchyDepth = 8;
+    spec.morphCount = 52;
+    spec.morphDensity = 0.1f;
+    spec.clipSeconds = 4.0f;
+    spec.textureSize = 1024;
+    spec.textureCount = 1;
+    return spec;
+  }
+
+  double median(std::vector<double>& values) {
+    std::sort(values.begin(), values.end());
+    return values.empty() ? 0.0 : values[values.size() / 2];
+  }
+
+  void printHeader() {
+    std::printf("sweep,value,vertices,triangles,bones,depth,morphs,"
+                "morph_deltas,keyframes,texture_bytes,glb_bytes,load_ms,"
+                "frame_p50_ms,anim_p50_ms,scene_p50_ms,render_p50_ms,"
+                "skinned_vertices,bones_evaluated,active_morphs,geo_bytes,"
+                "tex_bytes,anim_bytes\n");
+  }
+
+  void runPoint(const char* sweep, double value,
+                const avatar::synthetic::AvatarSpec& spec, int frames) {
+    avatar::synthetic::SyntheticStats stats;
+    std::vector<uint8_t> glb =
+        avatar::synthetic::buildSyntheticAvatar(spec, &stats);
+
+    // Load: fresh scene per repeat so caches from the last load don't help
+    std::vector<double> loadMs;
+    for (int r = 0; r < kLoadRepeats; ++r) {
+      initScene();
+      const double start = emscripten_get_now();
+      loadAvatarModel(glb.data(), glb.size());
+      loadMs.push_back(emscripten_get_now() - start);
+      if (r + 1 < kLoadRepeats) cleanup();
+    }
+
+    // Steady state: speaking with all lip-sync morphs active
+    setAnimationState("speaking");
+    const float morphs[4] = {0.7f, 0.3f, 0.1f, 0.05f};
+    for (int f = 0; f < kWarmupFrames; ++f) {
+      updateMorphTargets(morphs, 0.0, 0.0);
+      updateFrame();
+    }
+    resetFrameTimeStats();
+    for (int f = 0; f < frames; ++f) {
+      updateMorphTargets(morphs, 0.0, 0.0);
+      updateFrame();
+    }
+
+    const float frameP50 = getFrameTimeStats(avatar::kFrameCpu)->p50;
+    const float animP50 = getFrameTimeStats(avatar::kPhaseAnimation)->p50;
+    const float sceneP50 = getFrameTimeStats(avatar::kPhaseSceneUpdate)->p50;
+    const float renderP50 = getFrameTimeStats(avatar::kPhaseRender)->p50;
+    const avatar::FrameCounters counters = *getFrameCounters();
+    const avatar::MemoryStats memory = *getMemoryStats();
+
+    std::printf("%s,%g,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,"
+                "%u,%u,%u,%u,%u,%u\n",
+                sweep, value, stats.vertexCount, stats.triangleCount,
+                stats.boneCount, stats.hierarchyDepth, stats.morphCount,
+                stats.morphDeltas, stats.keyframes, stats.textureBytes,
+                stats.glbBytes, median(loadMs), frameP50, animP50, sceneP50,
+                renderP50, counters.skinnedVertices, counters.bonesEvaluated,
+                counters.activeMorphs, memory.bytes[avatar::kMemGeometry],
+                memory.bytes[avatar::kMemTextures],
+                memory.bytes[avatar::kMemAnimation]);
+    std::fflush(stdout);
+
+    avatar::log::ring().clear();
+    cleanup();
+  }
+
+  bool wants(const char* selected, const char* sweep) {
+    return !std::strcmp(selected, "all") || !std::strcmp(selected, sweep);
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* selected = argc > 1 ? argv[1] : "all";
+  const int frames = argc > 2 ? std::atoi(argv[2]) : kDefaultFrames;
+  printHeader();
+
+  if (wants(selected, "vertices")) {
+    for (uint32_t v : {1024u, 4096u, 16384u, 65536u, 262144u}) {
+      auto spec = baseSpec();
+      spec.vertexCount = v;
+      runPoint("vertices", v, spec, frames);
+    }
+  }
+  if (wants(selected, "bones")) {
+    for (uint32_t b : {16u, 32u, 64u, 128u, 256u, 512u}) {
+      auto spec = baseSpec();
+      spec.boneCount = b;
+      runPoint("bones", b, spec, frames);
+    }
+  }
+  if (wants(selected, "depth")) {
+    for (uint32_t d : {2u, 4u, 8u, 32u, 128u}) {
+      auto spec = baseSpec();
+      spec.boneCount = 128;
+      spec.hierarchyDepth = d;
+      runPoint("depth", d, spec, frames);
+    }
+  }
+  if (wants(selected, "morphs")) {
+    for (uint32_t m : {0u, 4u, 16u, 52u, 128u}) {
+      auto spec = baseSpec();
+      spec.morphCount = m;
+      runPoint("morphs", m, spec, frames);
+    }
+  }
+  if (wants(selected, "density")) {
+    for (float d : {0.01f, 0.05f, 0.25f, 1.0f}) {
+      auto spec = baseSpec();
+      spec.morphDensity = d;
+      runPoint("density", d, spec, frames);
+    }
+  }
+  if (wants(selected, "clip")) {
+    for (float s : {1.0f, 4.0f, 16.0f, 60.0f}) {
+      auto spec = baseSpec();
+      spec.clipSeconds = s;
+      runPoint("clip", s, spec, frames);
+    }
+  }
+  if (wants(selected, "texture")) {
+    for (uint32_t t : {0u, 256u, 1024u, 2048u}) {
+      auto spec = baseSpec();
+      spec.textureSize = t;
+      spec.textureCount = 3;
+      runPoint("texture", t, spec, frames);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,199 @@
+/**
+ * avatar-soak-test.cpp - Init/cleanup cycle soak test
+ *
+ * Runs thousands of initScene / loadAvatarModel / updateFrame / cleanup
+ * cycles, the pattern a long session with repeated remounts produces, and
+ * fails if process RSS, malloc'd heap or any engine memory category keeps
+ * growing. A warm-up phase runs first so allocator pools, lazily created
+ * singletons (log ring, HUD atlas) and driver caches are excluded from the
+ * baseline. Also checks that cleanup() returns the scene to its initial
+ * state, so a re-init is indistinguishable from a fresh module; the
+ * reference avatar's Hair chain makes that cover the spring bones.
+ *
+ * Usage: avatar-soak-test [cycles] [frames-per-cycle]
+ *
+ * Build command (desktop LIT-LAND build in $LITLAND_ROOT):
+ *   g++ -std=c++17 -O2 -DAVATAR_NATIVE_HARNESS -Iapp/lib -Inative \
+ *     -I$LITLAND_ROOT/include native/avatar-soak-test.cpp \
+ *     -L$LITLAND_ROOT/build -llitland -o build-native/avatar-soak-test
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../app/lib/avatar-scene-template.cpp"
+#include "reference-avatar.h"
+
+namespace {
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  constexpr int kWarmupCycles = 50;
+  constexpr int kDefaultCycles = 2000;
+  constexpr int kDefaultFrames = 3;
+
+  // Growth allowed between the post-warm-up baseline and the final sample.
+  // RSS moves in pages and the allocator may keep freed arenas mapped, so it
+  // gets an absolute slack plus a fraction; the heap should return exactly
+  // to baseline apart from fragmentation.
+  constexpr double kRssSlackBytes = 2.0 * 1024 * 1024;
+  constexpr double kRssSlackFraction = 0.05;
+  constexpr double kHeapSlackBytes = 64.0 * 1024;
+  constexpr double kCategorySlackBytes = 4.0 * 1024;
+
+  uint32_t g_loadedSpringChains = 0;
+
+  /**
+   * Resident set size in bytes, from /proc/self/statm (0 if unavailable)
+   */
+  size_t residentBytes() {
+    std::FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    unsigned long pages = 0, resident = 0;
+    const int n = std::fscanf(f, "%lu %lu", &pages, &resident);
+    std::fclose(f);
+    return n == 2 ? resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+  }
+
+  struct Sample {
+    int cycle;
+    size_t rss;
+    avatar::MemoryStats engine;
+  };
+
+  /**
+   * One mount/unmount: what AvatarCanvas does on every remount
+   */
+  void runCycle(const std::vector<uint8_t>& glb, int frames,
+                avatar::MemoryStats* loaded) {
+    static const char* const kStates[] = {"idle", "listening", "speaking"};
+    static const float kMorphs[4] = {0.6f, 0.2f, 0.1f, 0.0f};
+
+    initScene();
+    setCanvasSize(640, 480);
+    loadAvatarModel(const_cast<uint8_t*>(glb.data()), glb.size());
+    for (int f = 0; f < frames; ++f) {
+      setAnimationState(kStates[f % 3]);
+      updateMorphTargets(kMorphs, 0.0, 0.0);
+      updateFrame();
+    }
+    if (loaded) {
+      *loaded = *getMemoryStats();
+      g_loadedSpringChains = g_scene.springBones.chainCount();
+    }
+    avatar::log::ring().clear();
+    cleanup();
+    avatar::log::ring().clear();
+  }
+
+  Sample takeSample(int cycle) {
+    Sample s{cycle, residentBytes(), *getMemoryStats()};
+    return s;
+  }
+
+  void printSample(const Sample& s) {
+    std::printf("cycle %6d  rss %8.1f KB", s.cycle, s.rss / 1024.0);
+    for (int i = 0; i < avatar::kMemoryCategoryCount; ++i) {
+      std::printf("  %s %8.1f KB", avatar::memoryCategoryName(i),
+                  s.engine.bytes[i] / 1024.0);
+    }
+    std::printf("\n");
+  }
+
+  /**
+   * cleanup() must leave nothing from the session behind
+   */
+  void checkCleanState(const avatar::MemoryStats& loaded) {
+    expectTrue("model memory reported while loaded",
+               loaded.bytes[avatar::kMemGeometry] > 0);
+    expectTrue("spring chains built while loaded",
+               g_loadedSpringChains == avatar::reference::kSpringChainCount);
+
+    const avatar::MemoryStats& stats = *getMemoryStats();
+    expectTrue("geometry released",
+               stats.bytes[avatar::kMemGeometry] == 0);
+    expectTrue("textures released", stats.bytes[avatar::kMemTextures] == 0);
+    expectTrue("animation released",
+               stats.bytes[avatar::kMemAnimation] == 0);
+    expectTrue("spring bones released",
+               g_scene.springBones.empty() &&
+                   g_scene.springBones.memoryBytes() == 0);
+    expectTrue("animation state reset",
+               std::strcmp(getAnimationState(), "idle") == 0);
+
+    const avatar::EngineStateBlock& block = *getEngineStateBlock();
+    expectTrue("state block reset",
+               block.animationState == avatar::kStateIdle &&
+                   block.counters.frameIndex == 0 &&
+                   block.morphWeights[0] == 0.0f);
+    expectTrue("frame stats reset",
+               getFrameTimeStats(avatar::kFrameInterval)->count == 0.0f);
+    expectTrue("latency stats reset",
+               getAudioLatencyStats(avatar::kLatencyTotal)->count == 0.0f);
+  }
+}
+
+int main(int argc, char** argv) {
+  const int cycles = argc > 1 ? std::atoi(argv[1]) : kDefaultCycles;
+  const int frames = argc > 2 ? std::atoi(argv[2]) : kDefaultFrames;
+  const std::vector<uint8_t> glb = avatar::reference::buildReferenceAvatar();
+
+  avatar::MemoryStats loaded{};
+  for (int c = 0; c < kWarmupCycles; ++c) runCycle(glb, frames, &loaded);
+  checkCleanState(loaded);
+
+  const Sample baseline = takeSample(0);
+  printSample(baseline);
+
+  // Peak over the run catches growth that is later trimmed back
+  Sample peak = baseline;
+  const int reportEvery = cycles >= 10 ? cycles / 10 : 1;
+  for (int c = 1; c <= cycles; ++c) {
+    runCycle(glb, frames, nullptr);
+    if (c % reportEvery == 0 || c == cycles) {
+      const Sample s = takeSample(c);
+      printSample(s);
+      if (s.rss > peak.rss) peak.rss = s.rss;
+    }
+  }
+  const Sample last = takeSample(cycles);
+
+  const double rssGrowth =
+      static_cast<double>(last.rss) - static_cast<double>(baseline.rss);
+  const double rssLimit = kRssSlackBytes + baseline.rss * kRssSlackFraction;
+  std::printf("rss growth %.1f KB (limit %.1f KB, peak %.1f KB)\n",
+              rssGrowth / 1024.0, rssLimit / 1024.0, peak.rss / 1024.0);
+  expectTrue("rss growth within tolerance", rssGrowth <= rssLimit);
+
+  for (int i = 0; i < avatar::kMemoryCategoryCount; ++i) {
+    const double growth = static_cast<double>(last.engine.bytes[i]) -
+                          static_cast<double>(baseline.engine.bytes[i]);
+    const double limit =
+        i == avatar::kMemHeap ? kHeapSlackBytes : kCategorySlackBytes;
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s growth %.1f KB within %.1f KB",
+                  avatar::memoryCategoryName(i), growth / 1024.0,
+                  limit / 1024.0);
+    expectTrue(name, growth <= limit);
+  }
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d soak check(s) failed after %d cycles\n",
+                 g_failures, cycles);
+    return 1;
+  }
+  std::printf("Soak passed: %d cycles x %d frames\n", cycles, frames);
+  return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ * bridge-bench.mjs - JS <-> WASM bridge overhead microbenchmark
+ *
+ * Compares the calling patterns AvatarController used per frame against
+ * the ones it uses now:
+ *   - export lookup by name + spread call vs. a cached function reference
+ *   - one export call per counter vs. reading a bulk typed view
+ *   - String.fromCharCode loop vs. TextDecoder for engine strings
+ *   - malloc/free per morph update vs. a persistent engine-owned buffer
+ *
+ * With a path to the built avatar.wasm the real exports are measured
+ * (missing imports are stubbed); otherwise a tiny hand-assembled module
+ * exporting add(i32, i32) and memory stands in for the engine.
+ *
+ * Usage:
+ *   node native/bridge-bench.mjs [path/to/avatar.wasm] [iterations]
+ */
+
+import { readFileSync } from "node:fs";
+import { performance } from "node:perf_hooks";
+
+const wasmPath = process.argv[2];
+const iterations = Number(process.argv[3] ?? 1_000_000);
+
+// (module (memory (export "memory") 1)
+//   (func (export "add") (param i32 i32) (result i32)
+//     local.get 0 local.get 1 i32.add))
+const SYNTHETIC_MODULE = new Uint8Array([
+  0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00,
+  0x01, 0x07, 0x01, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f,
+  0x03, 0x02, 0x01, 0x00,
+  0x05, 0x03, 0x01, 0x00, 0x01,
+  0x07, 0x10, 0x02,
+  0x03, 0x61, 0x64, 0x64, 0x00, 0x00,
+  0x06, 0x6d, 0x65, 0x6d, 0x6f, 0x72, 0x79, 0x02, 0x00,
+  0x0a, 0x09, 0x01, 0x07, 0x00, 0x20, 0x00, 0x20, 0x01, 0x6a, 0x0b,
+]);
+
+/**
+ * Instantiate a module, satisfying every import with a harmless stub
+ */
+function instantiate(bytes) {
+  const module = new WebAssembly.Module(bytes);
+  const memory = new WebAssembly.Memory({ initial: 256, maximum: 512 });
+  const imports = {};
+  for (const entry of WebAssembly.Module.imports(module)) {
+    imports[entry.module] ??= {};
+    if (entry.kind === "memory") {
+      imports[entry.module][entry.name] = memory;
+    } else if (entry.kind === "function") {
+      imports[entry.module][entry.name] =
+        entry.name === "emscripten_get_now" ? () => performance.now() : () => 0;
+    } else if (entry.kind === "table") {
+      imports[entry.module][entry.name] = new WebAssembly.Table({
+        initial: 0,
+        element: "anyfunc",
+      });
+    } else if (entry.kind === "global") {
+      imports[entry.module][entry.name] = new WebAssembly.Global(
+        { value: "i32", mutable: true },
+        0
+      );
+    }
+  }
+  const instance = new WebAssembly.Instance(module, imports);
+  return {
+    exports: instance.exports,
+    memory: instance.exports.memory ?? memory,
+  };
+}
+
+function bench(name, fn) {
+  // A fresh loop per case keeps each call site monomorphic
+  const loop = new Function(
+    "fn",
+    "n",
+    "let sink = 0; for (let i = 0; i < n; i++) sink += fn(i) | 0; return sink;"
+  );
+  loop(fn, Math.min(iterations, 10_000)); // warm up the JIT
+  const start = performance.now();
+  const sink = loop(fn, iterations);
+  const ns = ((performance.now() - start) * 1e6) / iterations;
+  console.log(`${name.padEnd(44)} ${ns.toFixed(1).padStart(8)} ns/op`);
+  return sink;
+}
+
+const { exports, memory } = instantiate(
+  wasmPath ? readFileSync(wasmPath) : SYNTHETIC_MODULE
+);
+const real = typeof exports.updateFrame === "function";
+console.log(
+  `bridge-bench: ${real ? wasmPath : "synthetic module"}, ${iterations} iterations\n`
+);
+
+// 1. Export dispatch
+const callName = real ? "getFrameRate" : "add";
+const args = real ? [] : [1, 2];
+const cached = exports[callName];
+bench("export lookup + spread", () => exports[callName](...args));
+bench("cached reference, fixed arity", () =>
+  real ? cached() : cached(args[0], args[1])
+);
+
+// 2. Counters: one call per field vs. one view over a bulk block
+const COUNTER_FIELDS = 11;
+let blockPtr = real && exports.getEngineStateBlock?.();
+if (!blockPtr) blockPtr = 1024; // synthetic: any aligned scratch address
+const perField = real ? exports.getFrameRate : exports.add;
+bench(`${COUNTER_FIELDS} export calls`, () => {
+  let sum = 0;
+  for (let f = 0; f < COUNTER_FIELDS; f++) sum += perField(f, 0);
+  return sum;
+});
+// The controller checks memory.buffer for growth once per frame, not per read
+const view = new Uint32Array(memory.buffer, blockPtr, 26);
+bench(`bulk view over ${COUNTER_FIELDS} fields`, () => {
+  let sum = 0;
+  for (let f = 0; f < COUNTER_FIELDS; f++) sum += view[15 + f];
+  return sum;
+});
+
+// 3. Engine strings
+const message = "Avatar model loaded: 12 primitives, 54 bones";
+const bytes = new Uint8Array(memory.buffer);
+const strPtr = 4096;
+for (let i = 0; i < message.length; i++) bytes[strPtr + i] = message.charCodeAt(i);
+bytes[strPtr + message.length] = 0;
+const heap = new Uint8Array(memory.buffer);
+bench("fromCharCode loop", () => {
+  let s = "";
+  for (let i = strPtr; heap[i] !== 0; i++) s += String.fromCharCode(heap[i]);
+  return s.length;
+});
+const decoder = new TextDecoder();
+bench("TextDecoder", () => {
+  const end = heap.indexOf(0, strPtr);
+  return decoder.decode(heap.subarray(strPtr, end)).length;
+});
+
+// 4. Morph uploads
+if (real && exports.malloc && exports.free) {
+  bench("malloc + view + write + free", (i) => {
+    const ptr = exports.malloc(16);
+    const f = new Float32Array(memory.buffer, ptr, 4);
+    f[0] = i & 1;
+    exports.free(ptr);
+    return ptr;
+  });
+}
+const morphPtr = (real && exports.getMorphInputBuffer?.()) || 8192;
+const morphs = new Float32Array(memory.buffer, morphPtr, 4);
+bench("persistent buffer write", (i) => {
+  morphs[0] = i & 1;
+  return morphPtr;
+});
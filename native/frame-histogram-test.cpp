@@ -0,0 +1,141 @@
+/**
+ * frame-histogram-test.cpp - Frame time histogram bucket and quantile checks
+ *
+ * Exercises avatar-frame-histogram.h:
+ *
+ *   - every value up to 2^20 lands in a bucket whose bounds hold it, at
+ *     most 1/16 of the value wide; the largest value has a bucket
+ *   - quantiles are nearest rank over known samples: p50 and p99 of
+ *     1..20 are 10 and 20, and of 1..100 fall in the buckets of 50 and 99
+ *   - millisecond recording rounds, clamps bad input and tracks the max
+ *   - reset empties the histogram
+ *
+ * Usage: frame-histogram-test
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative \
+ *     native/frame-histogram-test.cpp -o build-native/frame-histogram-test
+ */
+
+#include <cmath>
+#include <cstdio>
+
+#include "avatar-frame-histogram.h"
+
+namespace {
+  using avatar::FrameHistogram;
+
+  int g_failures = 0;
+
+  void expectEqual(const char* name, uint32_t actual, uint32_t expected) {
+    if (actual != expected) {
+      std::fprintf(stderr, "FAIL %s: expected %u, got %u\n", name, expected,
+                   actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %u\n", name, actual);
+    }
+  }
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void bucketTest() {
+    bool contained = true;
+    bool narrow = true;
+    for (uint32_t v = 0; v <= (1u << 20); ++v) {
+      const uint32_t i = FrameHistogram::bucketIndex(v);
+      const uint32_t upper = FrameHistogram::bucketUpperBound(i);
+      const uint32_t lower =
+          i == 0 ? 0 : FrameHistogram::bucketUpperBound(i - 1) + 1;
+      if (v < lower || v > upper) contained = false;
+      if (upper - lower + 1 > 1 + v / FrameHistogram::kSubBuckets) {
+        narrow = false;
+      }
+    }
+    expectTrue("each value lies within its bucket's bounds", contained);
+    expectTrue("buckets are at most 1/16 of the value wide", narrow);
+    expectEqual("last linear bucket", FrameHistogram::bucketIndex(31), 31);
+    expectEqual("first log bucket upper bound",
+                FrameHistogram::bucketUpperBound(
+                    FrameHistogram::bucketIndex(32)),
+                33);
+    expectTrue("the largest value has a bucket",
+               FrameHistogram::bucketIndex(0xFFFFFFFFu) <
+                   FrameHistogram::kBucketCount);
+    expectEqual("the last bucket ends at the largest value",
+                FrameHistogram::bucketUpperBound(
+                    FrameHistogram::kBucketCount - 1),
+                0xFFFFFFFFu);
+  }
+
+  void quantileTest() {
+    FrameHistogram h;
+    expectEqual("empty p50", h.valueAtQuantile(0.5), 0);
+
+    for (uint32_t v = 1; v <= 20; ++v) h.recordMicros(v);
+    expectEqual("p50 of 1..20", h.valueAtQuantile(0.5), 10);
+    // Rank ceil(19.8) = 20; flooring would have reported 19
+    expectEqual("p99 of 1..20", h.valueAtQuantile(0.99), 20);
+    expectEqual("p0 of 1..20", h.valueAtQuantile(0.0), 1);
+    expectEqual("p100 of 1..20", h.valueAtQuantile(1.0), 20);
+
+    h.reset();
+    for (uint32_t v = 100; v >= 1; --v) h.recordMicros(v);
+    expectEqual("p50 of 1..100 (bucket 50..51)", h.valueAtQuantile(0.5), 51);
+    expectEqual("p99 of 1..100 (bucket 96..99)", h.valueAtQuantile(0.99),
+                99);
+    expectEqual("p7 of 1..100 is rank 7", h.valueAtQuantile(0.07), 7);
+
+    h.reset();
+    h.recordMicros(5);
+    h.recordMicros(1000);
+    expectEqual("p99 of two samples is the larger",
+                h.valueAtQuantile(0.99), 1000);
+    expectEqual("p50 of two samples is the smaller", h.valueAtQuantile(0.5),
+                5);
+
+    avatar::FrameTimePercentiles out{};
+    h.percentiles(out);
+    expectTrue("percentiles report milliseconds",
+               std::fabs(out.p99 - 1.0f) < 1e-6f && out.count == 2.0f &&
+                   std::fabs(out.max - 1.0f) < 1e-6f);
+  }
+
+  void recordAndResetTest() {
+    FrameHistogram h;
+    h.recordMillis(16.6667);
+    h.recordMillis(-3.0);
+    h.recordMillis(std::nan(""));
+    h.recordMillis(1e12);
+    expectEqual("recorded samples", static_cast<uint32_t>(h.count()), 4);
+    expectEqual("huge values clamp", h.maxMicros(), 0xFFFFFFFFu);
+    expectEqual("negative and NaN record as zero", h.valueAtQuantile(0.5), 0);
+
+    h.reset();
+    expectEqual("reset count", static_cast<uint32_t>(h.count()), 0);
+    expectEqual("reset max", h.maxMicros(), 0);
+    expectEqual("reset p99", h.valueAtQuantile(0.99), 0);
+    h.recordMillis(16.6667);
+    expectEqual("rounds to the nearest microsecond", h.maxMicros(), 16667);
+  }
+}  // namespace
+
+int main() {
+  bucketTest();
+  quantileTest();
+  recordAndResetTest();
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All frame histogram checks passed\n");
+  return 0;
+}
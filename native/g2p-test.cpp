@@ -0,0 +1,243 @@
+/**
+ * g2p-test.cpp - Grapheme-to-phoneme and viseme timeline checks
+ *
+ * Checks that the exception dictionary and rule tables compile, that the
+ * perfect hash finds every entry in one probe and rejects other words,
+ * and that common words come out of the letter-to-sound rules right.
+ * Then plans a few sentences and checks the timeline: bilabials close the
+ * mouth, pauses follow punctuation, the speaking rate is plausible, and
+ * sync() stretches the plan to the audio and fades out without syncs.
+ * Ends with conversion cost per character.
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib native/g2p-test.cpp -o build-native/g2p-test
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "avatar-g2p.h"
+#include "avatar-visemes.h"
+
+namespace {
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.3f, got %.3f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.3f\n", name, actual);
+    }
+  }
+
+  std::string phonemeString(const std::vector<uint8_t>& phonemes) {
+    std::string out;
+    for (uint8_t p : phonemes) {
+      if (p >= avatar::kPhonemeCount) continue;
+      if (!out.empty()) out += ' ';
+      out += avatar::kPhonemeNames[p];
+    }
+    return out;
+  }
+
+  std::string convert(const avatar::GraphemeToPhoneme& g2p, const char* text) {
+    std::vector<uint8_t> out;
+    g2p.convert(text, std::strlen(text), out);
+    return phonemeString(out);
+  }
+
+  void dictionaryTest(const avatar::GraphemeToPhoneme& g2p) {
+    const auto& dict = g2p.dictionary();
+    const uint32_t count = sizeof(avatar::kG2pExceptions) /
+                           sizeof(avatar::kG2pExceptions[0]);
+    expectTrue("tables compile", g2p.tablesOk());
+    expectTrue("every exception stored", dict.size() == count);
+
+    uint32_t hits = 0;
+    for (const auto& entry : avatar::kG2pExceptions) {
+      const uint8_t* phonemes = nullptr;
+      uint32_t n = 0;
+      if (!dict.find(entry.word, static_cast<uint32_t>(std::strlen(entry.word)),
+                     &phonemes, &n)) {
+        continue;
+      }
+      std::vector<uint8_t> expected;
+      avatar::parsePhonemes(entry.phonemes, expected);
+      if (expected == std::vector<uint8_t>(phonemes, phonemes + n)) ++hits;
+    }
+    expectTrue("every exception found with its phonemes", hits == count);
+
+    const uint8_t* phonemes = nullptr;
+    uint32_t n = 0;
+    bool falseHit = false;
+    for (const char* word : {"cat", "thee", "tho", "wha", "", "ones", "xyz"}) {
+      falseHit |= dict.find(word, static_cast<uint32_t>(std::strlen(word)),
+                            &phonemes, &n);
+    }
+    expectTrue("non-entries miss", !falseHit);
+    std::printf("     %u words in %u slots\n", dict.size(), dict.slotCount());
+  }
+
+  void rulesTest(const avatar::GraphemeToPhoneme& g2p) {
+    struct Case {
+      const char* word;
+      const char* phonemes;
+    };
+    const Case cases[] = {
+        {"cat", "K AE T"},          {"ship", "SH IH P"},
+        {"make", "M EY K"},         {"phone", "F OW N"},
+        {"thing", "TH IH NG"},      {"night", "N AY T"},
+        {"knee", "N IY"},           {"boat", "B OW T"},
+        {"city", "S IH T IY"},      {"judge", "JH AH JH"},
+        {"nation", "N EY SH AH N"}, {"wrote", "R OW T"},
+        {"chip", "CH IH P"},        {"moon", "M UW N"},
+        {"speech", "S P IY CH"},    {"plan", "P L AE N"},
+        {"voice", "V OY S"},        {"mouth", "M AW TH"},
+    };
+    for (const Case& c : cases) {
+      const std::string got = convert(g2p, c.word);
+      const std::string name = std::string("rules ") + c.word + " -> " + got;
+      expectTrue(name.c_str(), got == c.phonemes);
+    }
+
+    expectTrue("case and contractions",
+               convert(g2p, "I'M here, Don't") == "AY M HH IY R D OW N T");
+    expectTrue("numbers read as cardinals",
+               convert(g2p, "42") == convert(g2p, "forty two"));
+    expectTrue("thousands separator and decimals",
+               convert(g2p, "1,500 3.5") ==
+                   convert(g2p, "one thousand five hundred three point five"));
+
+    std::vector<uint8_t> out;
+    const char* text = "Hi. Well, ok";
+    g2p.convert(text, std::strlen(text), out);
+    int shortPauses = 0, longPauses = 0;
+    for (uint8_t p : out) {
+      shortPauses += p == avatar::kPhShortPause;
+      longPauses += p == avatar::kPhLongPause;
+    }
+    expectTrue("punctuation pauses", shortPauses == 1 && longPauses == 1);
+  }
+
+  void timelineTest(const avatar::GraphemeToPhoneme& g2p) {
+    avatar::VisemeTrack track;
+    const char* text =
+        "Hello! I can help you map out the problem, then we build it "
+        "step by step.";
+    const float estimate = track.plan(g2p, text, std::strlen(text));
+    const auto& timeline = track.timeline();
+
+    // 16 words: conversational English is roughly 140-200 words/minute
+    const double wordsPerMinute = 16.0 / estimate * 60.0;
+    expectTrue("speaking rate plausible",
+               wordsPerMinute > 130.0 && wordsPerMinute < 220.0);
+    std::printf("     %.2f s, %.0f words/min, %zu keys\n", estimate,
+                wordsPerMinute, timeline.size());
+
+    bool ordered = true, merged = true, closes = false, pauses = false;
+    for (size_t i = 0; i < timeline.size(); ++i) {
+      const auto& k = timeline.key(i);
+      ordered &= k.end > k.start &&
+                 (i == 0 || k.start == timeline.key(i - 1).end);
+      if (i > 0) merged &= k.viseme != timeline.key(i - 1).viseme;
+      if (k.viseme == avatar::kVisPP) {
+        const float mid = 0.5f * (k.start + k.end);
+        closes |= timeline.sample(mid).open < 0.05f;
+      }
+      pauses |= k.viseme == avatar::kVisSil &&
+                k.end - k.start >= avatar::VisemeTimeline::kShortPauseSeconds;
+    }
+    expectTrue("keys contiguous", ordered);
+    expectTrue("repeated visemes merged", merged);
+    expectTrue("bilabials close the mouth", closes);
+    expectTrue("pauses at punctuation", pauses);
+    expectTrue("no trailing silence",
+               timeline.key(timeline.size() - 1).viseme != avatar::kVisSil);
+
+    // Nothing until synced
+    for (int i = 0; i < 10; ++i) track.update(1.0f / 60.0f);
+    expectNear("silent before sync", track.weight(), 0.0, 1e-6);
+
+    // Audio turns out 20% slower than planned
+    const float duration = estimate * 1.2f;
+    float clock = 0.0f;
+    float peakOpen = 0.0f;
+    for (int frame = 0; clock < duration * 0.5f; ++frame) {
+      if (frame % 6 == 0) track.sync(clock, duration);
+      track.update(1.0f / 60.0f);
+      clock += 1.0f / 60.0f;
+      peakOpen = std::max(peakOpen, track.pose().open);
+    }
+    expectNear("plan stretched to audio", track.scale(), 1.2, 1e-3);
+    expectNear("owns the mouth while synced", track.weight(), 1.0, 1e-6);
+    expectTrue("mouth opens", peakOpen > 0.5f);
+
+    // Player stalls: no more syncs
+    for (int i = 0; i < 60; ++i) track.update(1.0f / 60.0f);
+    expectNear("fades out without syncs", track.weight(), 0.0, 1e-6);
+
+    // Sync past the end also releases the mouth
+    track.sync(duration + 0.1f, duration);
+    for (int i = 0; i < 30; ++i) track.update(1.0f / 60.0f);
+    expectNear("released after the end", track.weight(), 0.0, 1e-6);
+
+    expectNear("empty text plans nothing", track.plan(g2p, " ... ", 5), 0.0,
+               1e-6);
+  }
+
+  void bench(const avatar::GraphemeToPhoneme& g2p) {
+    const std::string text =
+        "Let me help you turn confusion into clarity, one question at a "
+        "time. The best code is the code you can delete; keep systems "
+        "simple, and measure 3 times before you cut 1,000 lines. ";
+    std::vector<uint8_t> out;
+    avatar::VisemeTimeline timeline;
+    const int iterations = 20000;
+    const auto start = std::chrono::steady_clock::now();
+    size_t sink = 0;
+    for (int i = 0; i < iterations; ++i) {
+      out.clear();
+      g2p.convert(text.data(), text.size(), out);
+      timeline.build(out);
+      sink += timeline.size();
+    }
+    const double ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    std::printf("     %.0f ns per character text -> timeline (%zu chars, "
+                "sink %zu)\n",
+                ns / iterations / static_cast<double>(text.size()),
+                text.size(), sink);
+  }
+}
+
+int main() {
+  avatar::GraphemeToPhoneme g2p;
+  dictionaryTest(g2p);
+  rulesTest(g2p);
+  timelineTest(g2p);
+  bench(g2p);
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d g2p check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All g2p checks passed\n");
+  return 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * glb-writer.h - Minimal binary glTF (GLB) writer for native harnesses
+ *
+ * Builds the JSON and BIN chunks for test and benchmark avatars entirely
+ * in memory, so harnesses don't depend on checked-in model files. Only the
+ * subset of glTF the avatar loader consumes is supported: one buffer,
+ * tightly packed (optionally sparse) accessors, nodes, meshes with morph
+ * targets, skins, animations and embedded images.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace avatar {
+namespace glb {
+
+// glTF componentType values
+constexpr int kUnsignedShort = 5123;
+constexpr int kUnsignedInt = 5125;
+constexpr int kFloat = 5126;
+
+// glTF bufferView targets
+constexpr int kArrayBuffer = 34962;
+constexpr int kElementArrayBuffer = 34963;
+
+class GlbWriter {
+ public:
+  /**
+   * Append raw data as a bufferView + accessor, returns the accessor index
+   * `type` is the glTF accessor type ("SCALAR", "VEC3", "MAT4", ...).
+   * minMax, when given, is written as "min"/"max" JSON arrays verbatim.
+   */
+  int addAccessor(const void* data, size_t byteLength, int componentType,
+                  size_t count, const char* type, int target = 0,
+                  const std::string& minMax = std::string()) {
+    align(4);
+    const size_t offset = bin_.size();
+    bin_.resize(offset + byteLength);
+    std::memcpy(bin_.data() + offset, data, byteLength);
+
+    std::ostringstream view;
+    view << "{\"buffer\":0,\"byteOffset\":" << offset
+         << ",\"byteLength\":" << byteLength;
+    if (target) view << ",\"target\":" << target;
+    view << "}";
+    bufferViews_.push_back(view.str());
+
+    std::ostringstream accessor;
+    accessor << "{\"bufferView\":" << bufferViews_.size() - 1
+             << ",\"componentType\":" << componentType
+             << ",\"count\":" << count << ",\"type\":\"" << type << "\"";
+    if (!minMax.empty()) accessor << "," << minMax;
+    accessor << "}";
+    accessors_.push_back(accessor.str());
+    return static_cast<int>(accessors_.size() - 1);
+  }
+
+  /**
+   * Append a sparse accessor with an implicit all-zero base
+   * Used for morph targets that only touch a fraction of the vertices;
+   * `indices` are vertex indices (ascending), `values` hold one element of
+   * `type` per index. Returns the accessor index.
+   */
+  int addSparseAccessor(size_t count, const char* type,
+                        const std::vector<uint32_t>& indices,
+                        const std::vector<float>& values,
+                        const std::string& minMax = std::string()) {
+    const int indexView =
+        addBufferView(indices.data(), indices.size() * sizeof(uint32_t));
+    const int valueView =
+        addBufferView(values.data(), values.size() * sizeof(float));
+
+    std::ostringstream accessor;
+    accessor << "{\"componentType\":" << kFloat << ",\"count\":" << count
+             << ",\"type\":\"" << type << "\"";
+    if (!minMax.empty()) accessor << "," << minMax;
+    accessor << ",\"sparse\":{\"count\":" << indices.size()
+             << ",\"indices\":{\"bufferView\":" << indexView
+             << ",\"componentType\":" << kUnsignedInt
+             << "},\"values\":{\"bufferView\":" << valueView << "}}}";
+    accessors_.push_back(accessor.str());
+    return static_cast<int>(accessors_.size() - 1);
+  }
+
+  template <typename T>
+  int addAccessor(const std::vector<T>& values, int componentType,
+                  size_t count, const char* type, int target = 0,
+                  const std::string& minMax = std::string()) {
+    return addAccessor(values.data(), values.size() * sizeof(T),
+                       componentType, count, type, target, minMax);
+  }
+
+  // Each add* takes a complete JSON object and returns its index
+  int addNode(const std::string& json) { return push(nodes_, json); }
+  int addMesh(const std::string& json) { return push(meshes_, json); }
+  int addSkin(const std::string& json) { return push(skins_, json); }
+  int addAnimation(const std::string& json) {
+    return push(animations_, json);
+  }
+  int addImage(const std::string& json) { return push(images_, json); }
+  int addTexture(const std::string& json) { return push(textures_, json); }
+  int addMaterial(const std::string& json) { return push(materials_, json); }
+
+  /**
+   * Append raw bytes as a bufferView without an accessor (e.g. images)
+   * Returns the bufferView index.
+   */
+  int addBufferView(const void* data, size_t byteLength) {
+    align(4);
+    const size_t offset = bin_.size();
+    bin_.resize(offset + byteLength);
+    std::memcpy(bin_.data() + offset, data, byteLength);
+
+    std::ostringstream view;
+    view << "{\"buffer\":0,\"byteOffset\":" << offset
+         << ",\"byteLength\":" << byteLength << "}";
+    bufferViews_.push_back(view.str());
+    return static_cast<int>(bufferViews_.size() - 1);
+  }
+
+  void setSceneRoots(const std::vector<int>& roots) { sceneRoots_ = roots; }
+
+  /**
+   * Serialize to a GLB container (header + JSON chunk + BIN chunk)
+   */
+  std::vector<uint8_t> finish() {
+    align(4);
+
+    std::ostringstream json;
+    json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"avatar-glb-writer\"}"
+         << ",\"scene\":0,\"scenes\":[{\"nodes\":" << intArray(sceneRoots_)
+         << "}]";
+    writeArray(json, "nodes", nodes_);
+    writeArray(json, "meshes", meshes_);
+    writeArray(json, "skins", skins_);
+    writeArray(json, "animations", animations_);
+    writeArray(json, "materials", materials_);
+    writeArray(json, "textures", textures_);
+    writeArray(json, "images", images_);
+    writeArray(json, "accessors", accessors_);
+    writeArray(json, "bufferViews", bufferViews_);
+    json << ",\"buffers\":[{\"byteLength\":" << bin_.size() << "}]}";
+
+    std::string jsonText = json.str();
+    while (jsonText.size() % 4) jsonText.push_back(' ');
+
+    std::vector<uint8_t> out;
+    const uint32_t totalLength = static_cast<uint32_t>(
+        12 + 8 + jsonText.size() + 8 + bin_.size());
+    put32(out, 0x46546C67);  // "glTF"
+    put32(out, 2);
+    put32(out, totalLength);
+
+    put32(out, static_cast<uint32_t>(jsonText.size()));
+    put32(out, 0x4E4F534A);  // "JSON"
+    out.insert(out.end(), jsonText.begin(), jsonText.end());
+
+    put32(out, static_cast<uint32_t>(bin_.size()));
+    put32(out, 0x004E4942);  // "BIN\0"
+    out.insert(out.end(), bin_.begin(), bin_.end());
+    return out;
+  }
+
+  static std::string intArray(const std::vector<int>& values) {
+    std::ostringstream out;
+    out << "[";
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (i) out << ",";
+      out << values[i];
+    }
+    out << "]";
+    return out.str();
+  }
+
+  static std::string floatArray(const float* values, size_t count) {
+    std::ostringstream out;
+    out << "[";
+    for (size_t i = 0; i < count; ++i) {
+      if (i) out << ",";
+      out << values[i];
+    }
+    out << "]";
+    return out.str();
+  }
+
+ private:
+  static int push(std::vector<std::string>& list, const std::string& json) {
+    list.push_back(json);
+    return static_cast<int>(list.size() - 1);
+  }
+
+  static void writeArray(std::ostringstream& json, const char* name,
+                         const std::vector<std::string>& items) {
+    if (items.empty()) return;
+    json << ",\"" << name << "\":[";
+    for (size_t i = 0; i < items.size(); ++i) {
+      if (i) json << ",";
+      json << items[i];
+    }
+    json << "]";
+  }
+
+  static void put32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back((value >> (8 * i)) & 0xFF);
+  }
+
+  void align(size_t alignment) {
+    while (bin_.size() % alignment) bin_.push_back(0);
+  }
+
+  std::vector<uint8_t> bin_;
+  std::vector<std::string> bufferViews_;
+  std::vector<std::string> accessors_;
+  std::vector<std::string> nodes_;
+  std::vector<std::string> meshes_;
+  std::vector<std::string> skins_;
+  std::vector<std::string> animations_;
+  std::vector<std::string> images_;
+  std::vector<std::string> textures_;
+  std::vector<std::string> materials_;
+  std::vector<int> sceneRoots_;
+};
+
+}  // namespace glb
+}  // namespace avatar
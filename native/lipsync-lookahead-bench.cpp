@@ -0,0 +1,411 @@
+/**
+ * lipsync-lookahead-bench.cpp - Lookahead lip-sync latency and jitter
+ *
+ * Plays synthetic speech, whose pauses are exact silence, through two
+ * mouth analysers, sampled at 240 Hz for timing resolution:
+ *
+ *   causal     the <audio> path: a window ending at the playhead, then
+ *              an EMA of 0.3 per 60 Hz frame (optimistic: the browser's
+ *              own spectral smoothing is left out)
+ *   lookahead  LookaheadLipSync fed decoded PCM in jittery bursts 60-400
+ *              ms ahead of the playhead, sampled at the playhead
+ *
+ * The lag of each against the track of where there is sound comes from
+ * the peak of their cross-correlation. Lookahead must be within 10 ms of
+ * zero and no rougher than the causal path. It then checks the jitter buffer:
+ * interpolation, a decode stall (counted, pose relaxes closed), the end
+ * of the stream, release when playback stops short of the end, and
+ * reset. Finally it times analysis per 10 ms hop.
+ *
+ * Usage: lipsync-lookahead-bench
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative \
+ *     native/lipsync-lookahead-bench.cpp \
+ *     -o build-native/lipsync-lookahead-bench
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "avatar-lookahead-lipsync.h"
+#include "synthetic-speech.h"
+
+namespace {
+  using avatar::LookaheadLipSync;
+  using avatar::MouthFrame;
+  using avatar::MouthFrameBuffer;
+
+  constexpr double kSampleHz = 240.0;
+  constexpr double kFrameHz = 60.0;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.4f, got %.4f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  void expectBelow(const char* name, double actual, double limit) {
+    if (!(actual < limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected < %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  void expectAbove(const char* name, double actual, double limit) {
+    if (!(actual > limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected > %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  struct Rng {
+    uint32_t state;
+    float uniform(float lo, float hi) {
+      state = state * 1664525u + 1013904223u;
+      return lo + (hi - lo) * static_cast<float>(state >> 8) / 16777216.0f;
+    }
+  };
+
+  /**
+   * The <audio> path's mouthOpen: loudness of the window that ends at the
+   * playhead, on the same dB scale as the lookahead analyser, then an EMA
+   */
+  class CausalMouth {
+   public:
+    explicit CausalMouth(float sampleRate) : rate_(sampleRate) {
+      uint32_t n = 64;
+      while (n < sampleRate * 0.02f) n <<= 1;
+      fft_.configure(n);
+      frame_.assign(n, 0.0f);
+      power_.assign(n / 2 + 1, 0.0f);
+      lo_ = static_cast<uint32_t>(100.0f * n / sampleRate + 0.5f);
+      hi_ = static_cast<uint32_t>(4000.0f * n / sampleRate + 0.5f);
+    }
+
+    float update(const std::vector<float>& pcm, double t) {
+      const size_t n = fft_.size();
+      const long end = static_cast<long>(t * rate_);
+      for (size_t i = 0; i < n; ++i) {
+        const long at = end - static_cast<long>(n) + static_cast<long>(i);
+        frame_[i] = at >= 0 && at < static_cast<long>(pcm.size())
+                        ? pcm[at] : 0.0f;
+      }
+      fft_.powerSpectrum(frame_.data(), power_.data());
+      float voice = 0.0f;
+      for (uint32_t k = lo_; k < hi_; ++k) voice += power_[k];
+      const float db = 10.0f * std::log10(
+          voice * 8.0f / (3.0f * static_cast<float>(n * n)) + 1e-10f);
+      peak_ = std::max({db, peak_ - 0.03f, -50.0f});
+      const float open = std::clamp((db - peak_ + 30.0f) / 30.0f, 0.0f, 1.0f);
+      smoothed_ = smoothed_ * 0.7f + open * 0.3f;
+      return smoothed_;
+    }
+
+   private:
+    float rate_;
+    avatar::Fft fft_;
+    std::vector<float> frame_, power_;
+    uint32_t lo_{0}, hi_{0};
+    float peak_{-50.0f};
+    float smoothed_{0.0f};
+  };
+
+  /**
+   * Lag (seconds) that best aligns a mouth series with the sound track,
+   * and the correlation there; positive = the mouth trails the voice
+   */
+  void bestLag(const std::vector<float>& truth,
+               const std::vector<float>& mouth, double& lag, double& peak) {
+    const auto centred = [](std::vector<float> v) {
+      double mean = 0.0;
+      for (float x : v) mean += x;
+      mean /= static_cast<double>(v.size());
+      double norm = 0.0;
+      for (float& x : v) {
+        x -= static_cast<float>(mean);
+        norm += static_cast<double>(x) * x;
+      }
+      const float scale = static_cast<float>(1.0 / std::sqrt(norm + 1e-12));
+      for (float& x : v) x *= scale;
+      return v;
+    };
+    const std::vector<float> a = centred(truth), b = centred(mouth);
+    const int range = static_cast<int>(0.2 * kSampleHz);
+    peak = -2.0;
+    for (int shift = -range; shift <= range; ++shift) {
+      double sum = 0.0;
+      for (size_t i = 0; i < a.size(); ++i) {
+        const long j = static_cast<long>(i) + shift;
+        if (j >= 0 && j < static_cast<long>(b.size())) sum += a[i] * b[j];
+      }
+      if (sum > peak) {
+        peak = sum;
+        lag = shift / kSampleHz;
+      }
+    }
+  }
+
+  double roughness(const std::vector<float>& v) {
+    double sum = 0.0;
+    for (size_t i = 2; i < v.size(); ++i) {
+      sum += std::fabs(v[i] - 2.0f * v[i - 1] + v[i - 2]);
+    }
+    return sum / static_cast<double>(v.size());
+  }
+
+  void latencyTest(uint32_t sampleRate) {
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = sampleRate;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    const double seconds =
+        static_cast<double>(speech.samples.size()) / sampleRate;
+
+    CausalMouth causal(static_cast<float>(sampleRate));
+    LookaheadLipSync lookahead;
+    lookahead.configure(static_cast<float>(sampleRate));
+
+    // Decoded audio arrives in bursts, 60-400 ms ahead of the playhead
+    Rng rng{sampleRate};
+    std::vector<float> decoded;
+    double decodedUntil = 0.0;
+    const auto decodeTo = [&](double t) {
+      const size_t end = std::min(speech.samples.size(),
+                                  static_cast<size_t>(t * sampleRate));
+      if (end > decoded.size()) {
+        decoded.insert(decoded.end(), speech.samples.begin() + decoded.size(),
+                       speech.samples.begin() + end);
+      }
+    };
+
+    std::vector<float> truth, causalOpen, lookaheadOpen;
+    float held = 0.0f;
+    float minLookahead = 1.0f;
+    const int perFrame = static_cast<int>(kSampleHz / kFrameHz);
+    for (int step = 0; step / kSampleHz < seconds; ++step) {
+      const double t = step / kSampleHz;
+      if (decodedUntil < t + 0.06) {
+        decodedUntil = t + rng.uniform(0.06f, 0.4f);
+        decodeTo(decodedUntil);
+      }
+      const bool complete = decoded.size() == speech.samples.size();
+      lookahead.analyse(decoded.data(), decoded.size(), complete, 48);
+      const float at = static_cast<float>(t);
+      lookaheadOpen.push_back(lookahead.sample(at).open);
+      if (t > 0.3 && !complete) {
+        minLookahead = std::min(minLookahead, lookahead.lookaheadSeconds(at));
+      }
+      // The causal path only updates on 60 Hz frames
+      if (step % perFrame == 0) held = causal.update(speech.samples, t);
+      causalOpen.push_back(held);
+      const size_t index = std::min(speech.f0.size() - 1,
+                                    static_cast<size_t>(t * sampleRate));
+      truth.push_back(
+          speech.f0[index] > 0.0f || speech.samples[index] != 0.0f ? 1.0f
+                                                                   : 0.0f);
+    }
+
+    double causalLag = 0.0, causalPeak = 0.0;
+    double lookLag = 0.0, lookPeak = 0.0;
+    bestLag(truth, causalOpen, causalLag, causalPeak);
+    bestLag(truth, lookaheadOpen, lookLag, lookPeak);
+    std::printf("%u Hz: causal lag %.1f ms (r %.3f), lookahead lag %.1f ms "
+                "(r %.3f), min lookahead %.0f ms\n",
+                sampleRate, causalLag * 1e3, causalPeak, lookLag * 1e3,
+                lookPeak, minLookahead * 1e3);
+
+    char name[96];
+    std::snprintf(name, sizeof(name), "%u Hz lookahead lag (s)", sampleRate);
+    expectNear(name, lookLag, 0.0, 0.010);
+    std::snprintf(name, sizeof(name), "%u Hz causal lag (s)", sampleRate);
+    expectAbove(name, causalLag, 0.025);
+    std::snprintf(name, sizeof(name), "%u Hz lookahead correlation",
+                  sampleRate);
+    expectAbove(name, lookPeak, causalPeak);
+    std::snprintf(name, sizeof(name),
+                  "%u Hz lookahead roughness / causal", sampleRate);
+    expectBelow(name, roughness(lookaheadOpen) / roughness(causalOpen), 1.0);
+    std::snprintf(name, sizeof(name), "%u Hz no underruns while ahead",
+                  sampleRate);
+    expectTrue(name, lookahead.buffer().underruns() == 0);
+  }
+
+  void bufferTest() {
+    MouthFrameBuffer buffer;
+    buffer.push({0.00f, 0.0f, 0.0f});
+    buffer.push({0.01f, 1.0f, 0.5f});
+    buffer.push({0.02f, 0.5f, 0.0f});
+    expectNear("before the first frame holds it", buffer.sample(-0.1f).open,
+               0.0, 1e-6);
+    expectNear("interpolated open", buffer.sample(0.005f).open, 0.5, 1e-5);
+    expectNear("interpolated round", buffer.sample(0.015f).round, 0.25,
+               1e-5);
+    expectNear("lookahead past t", buffer.lookahead(0.015f), 0.005, 1e-6);
+    expectTrue("older frames released", buffer.size() == 2);
+
+    // Run dry before the end: held, relaxing, counted once
+    const float dry = buffer.sample(0.02f + MouthFrameBuffer::kUnderrunRelease)
+                          .open;
+    expectNear("held pose relaxes", dry, 0.5 * std::exp(-1.0), 1e-4);
+    buffer.sample(0.2f);
+    expectTrue("one underrun for one stall", buffer.underruns() == 1);
+    buffer.push({0.21f, 0.8f, 0.0f});
+    buffer.push({0.22f, 0.8f, 0.0f});
+    expectNear("recovers when frames arrive", buffer.sample(0.215f).open,
+               0.8, 1e-5);
+    buffer.sample(0.3f);
+    expectTrue("second stall counted", buffer.underruns() == 2);
+
+    // After the end the mouth just closes, without an underrun
+    buffer.push({0.31f, 0.6f, 0.0f});
+    buffer.end();
+    expectNear("closed past the end", buffer.sample(0.5f).open, 0.0, 1e-6);
+    expectTrue("the end is not an underrun", buffer.underruns() == 2);
+  }
+
+  void stallTest() {
+    const uint32_t rate = 24000;
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = rate;
+    spec.seconds = 3.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+
+    LookaheadLipSync lipSync;
+    lipSync.configure(static_cast<float>(rate));
+    // Decode stops at 1.0 s; play on to 1.5 s
+    const size_t decoded = rate;
+    lipSync.analyse(speech.samples.data(), decoded, false, 1000);
+    float lastOpen = 1.0f;
+    for (float t = 0.0f; t < 1.5f; t += 1.0f / 60.0f) {
+      lastOpen = lipSync.sample(t).open;
+    }
+    expectTrue("decode stall is an underrun",
+               lipSync.buffer().underruns() == 1);
+    expectBelow("stalled mouth relaxes closed", lastOpen, 0.01);
+    expectTrue("still owning during a stall", lipSync.owning());
+
+    // Catch up and finish
+    lipSync.analyse(speech.samples.data(), speech.samples.size(), true, 1000);
+    lipSync.sample(1.6f);
+    expectTrue("resumes after the stall", lipSync.buffer().size() > 0);
+    lipSync.sample(3.0f + LookaheadLipSync::kReleaseSeconds + 0.05f);
+    expectTrue("lets go after the end", !lipSync.owning());
+
+    lipSync.reset();
+    expectNear("reset closes the mouth", lipSync.sample(0.5f).open, 0.0,
+               1e-6);
+    expectTrue("reset lets go", !lipSync.owning());
+    expectTrue("reset clears underruns", lipSync.buffer().underruns() == 0);
+  }
+
+  /**
+   * The player's lifecycle: its playhead runs at most 50 ms past the
+   * last report, less output latency, and stops advancing when playback
+   * ends, so it never reaches the release time. release() lets go.
+   */
+  void playbackEndTest() {
+    const uint32_t rate = 24000;
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = rate;
+    spec.seconds = 2.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    const float seconds =
+        static_cast<float>(speech.samples.size()) / static_cast<float>(rate);
+
+    LookaheadLipSync lipSync;
+    lipSync.configure(static_cast<float>(rate));
+    lipSync.analyse(speech.samples.data(), speech.samples.size(), true,
+                    1u << 30);
+    const float latency = 0.02f;
+    const float lastPlayhead = seconds + 0.05f - latency;
+    for (float t = 0.0f; t < lastPlayhead; t += 1.0f / 60.0f) {
+      lipSync.sample(t);
+    }
+    // Playback ended; frames keep sampling the frozen playhead
+    for (int frame = 0; frame < 60; ++frame) lipSync.sample(lastPlayhead);
+    expectTrue("a frozen playhead never reaches the release",
+               lipSync.owning());
+
+    lipSync.release();
+    expectTrue("release lets go", !lipSync.owning());
+    for (int frame = 0; frame < 60; ++frame) lipSync.sample(lastPlayhead);
+    expectTrue("stays released while frames go on", !lipSync.owning());
+
+    lipSync.reset();
+    lipSync.analyse(speech.samples.data(), speech.samples.size(), true,
+                    1u << 30);
+    lipSync.sample(0.5f);
+    expectTrue("the next stream owns the mouth again", lipSync.owning());
+  }
+
+  void timingTest(uint32_t sampleRate) {
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = sampleRate;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    LookaheadLipSync lipSync;
+    lipSync.configure(static_cast<float>(sampleRate));
+
+    const int repeats = 20;
+    uint64_t hops = 0;
+    const double start = nowNs();
+    for (int r = 0; r < repeats; ++r) {
+      lipSync.reset();
+      hops += lipSync.analyse(speech.samples.data(), speech.samples.size(),
+                              true, 1u << 30);
+    }
+    const double ns = (nowNs() - start) / static_cast<double>(hops);
+    std::printf("%u Hz: %.0f ns per hop (%u-sample hop), %.2f%% of one core "
+                "per second of audio\n",
+                sampleRate, ns, lipSync.hopSamples(),
+                ns * 100.0 / LookaheadLipSync::kHopSeconds / 1e9);
+  }
+}  // namespace
+
+int main() {
+  latencyTest(24000);
+  latencyTest(48000);
+  bufferTest();
+  stallTest();
+  playbackEndTest();
+  timingTest(24000);
+  timingTest(44100);
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All lookahead lip-sync checks passed\n");
+  return 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * look-at-bench.cpp - Look-at solver checks and per-frame cost
+ *
+ * Builds a spine -> neck -> head chain with two eyes and a block of
+ * facial joints under the head (the subtree the solver must refresh),
+ * then checks the solver against the analytic answer: the head chain
+ * converges on the target's yaw and pitch within its limits, the eyes
+ * cover the remainder within theirs, the eyes lead the head, a turned
+ * parent does not skew the model-space aim, weight 0 relaxes back to
+ * the animated pose, and a nod gesture moves the head but not the gaze.
+ * Finally times one apply() per frame, next to the
+ * full computeWorld() pass it follows.
+ *
+ * Usage: look-at-bench [iterations]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib native/look-at-bench.cpp \
+ *     -o build-native/look-at-bench
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "avatar-look-at.h"
+
+namespace {
+  using avatar::BoneTransform;
+  using avatar::FlatSkeleton;
+  using avatar::LookAtSolver;
+  namespace simd = avatar::simd;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance = 1e-3) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.4f, got %.4f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Flat (pre-order) indices of the test rig
+  enum : int32_t { kHips, kSpine, kNeck, kHead, kLeftEye, kRightEye, kFace };
+  constexpr uint32_t kFaceJoints = 24;
+  constexpr float kDt = 1.0f / 60.0f;
+
+  struct Rig {
+    FlatSkeleton skeleton;
+    std::vector<BoneTransform> animated;  // the pose clips would produce
+  };
+
+  Rig buildRig(float spineYaw) {
+    std::vector<int32_t> parents = {FlatSkeleton::kNoParent, kHips, kSpine,
+                                    kNeck, kHead, kHead};
+    for (uint32_t i = 0; i < kFaceJoints; ++i) parents.push_back(kHead);
+
+    Rig rig;
+    rig.skeleton.build(parents.data(), parents.size());
+    rig.animated.resize(parents.size());
+    auto at = [&](int32_t j, float x, float y, float z) {
+      rig.animated[j].translation = simd::Vec4::make(x, y, z, 0.0f);
+    };
+    at(kHips, 0.0f, 1.0f, 0.0f);
+    at(kSpine, 0.0f, 0.4f, 0.0f);
+    at(kNeck, 0.0f, 0.15f, 0.0f);
+    at(kHead, 0.0f, 0.1f, 0.0f);
+    at(kLeftEye, 0.03f, 0.07f, 0.08f);
+    at(kRightEye, -0.03f, 0.07f, 0.08f);
+    for (uint32_t i = 0; i < kFaceJoints; ++i) {
+      at(kFace + static_cast<int32_t>(i), 0.01f * static_cast<float>(i % 6),
+         0.02f * static_cast<float>(i / 6), 0.09f);
+    }
+    rig.animated[kSpine].rotation =
+        simd::fromAxisAngle(0.0f, 1.0f, 0.0f, spineYaw);
+    return rig;
+  }
+
+  /**
+   * One frame as evaluateSkeleton() runs it: animated pose, world pass,
+   * look-at on top
+   */
+  void frame(Rig& rig, LookAtSolver& solver, const float* target,
+             float weight) {
+    BoneTransform* local = rig.skeleton.localPose();
+    for (size_t i = 0; i < rig.animated.size(); ++i) local[i] = rig.animated[i];
+    rig.skeleton.computeWorld();
+    solver.apply(rig.skeleton, target, weight, kDt);
+  }
+
+  float column(const FlatSkeleton& skeleton, int32_t joint, int col,
+               int row) {
+    float v[4];
+    simd::store(v, skeleton.world()[joint].col[col]);
+    return v[row];
+  }
+
+  // Model-space yaw and pitch of a joint's +Z axis
+  float forwardYaw(const FlatSkeleton& skeleton, int32_t joint) {
+    return std::atan2(column(skeleton, joint, 2, 0),
+                      column(skeleton, joint, 2, 2));
+  }
+
+  float forwardPitch(const FlatSkeleton& skeleton, int32_t joint) {
+    const float x = column(skeleton, joint, 2, 0);
+    const float y = column(skeleton, joint, 2, 1);
+    const float z = column(skeleton, joint, 2, 2);
+    return std::atan2(y, std::sqrt(x * x + z * z));
+  }
+
+  void settle(Rig& rig, LookAtSolver& solver, const float* target,
+              float weight = 1.0f) {
+    for (int i = 0; i < 600; ++i) frame(rig, solver, target, weight);
+  }
+
+  void solverTest() {
+    Rig rig = buildRig(0.0f);
+    LookAtSolver solver;
+    solver.bind(kNeck, kHead, kLeftEye, kRightEye);
+    const float headHeight = 1.65f;
+
+    const float ahead[3] = {0.0f, headHeight, 2.0f};
+    settle(rig, solver, ahead);
+    expectNear("straight ahead: no head yaw", solver.headYaw(), 0.0);
+    expectNear("straight ahead: head faces +Z", forwardYaw(rig.skeleton, kHead),
+               0.0);
+
+    // 45 degrees right and 20 degrees up, inside the head limits
+    const float right[3] = {1.0f, headHeight + std::tan(0.35f) * std::sqrt(2.0f),
+                            1.0f};
+    settle(rig, solver, right);
+    expectNear("head yaw converges", solver.headYaw(), 0.785398);
+    expectNear("head pitch converges", solver.headPitch(), 0.35);
+    expectNear("head aims at target (yaw)", forwardYaw(rig.skeleton, kHead),
+               0.785398);
+    expectNear("head aims at target (pitch)",
+               forwardPitch(rig.skeleton, kHead), 0.35);
+    expectNear("eyes centered once head arrives", solver.eyeYaw(), 0.0);
+    expectNear("neck takes its share", forwardYaw(rig.skeleton, kNeck),
+               0.785398 * solver.params().neckShare);
+
+    // Behind and to the left: head and eyes both hit their limits
+    const float behind[3] = {-1.0f, headHeight, -1.0f};
+    settle(rig, solver, behind);
+    expectNear("head yaw clamped", solver.headYaw(),
+               -solver.params().headYawLimit);
+    expectNear("eye yaw clamped", solver.eyeYaw(),
+               -solver.params().eyeYawLimit);
+    expectNear("eyes add to the head", forwardYaw(rig.skeleton, kLeftEye),
+               -(solver.params().headYawLimit + solver.params().eyeYawLimit));
+
+    // Eyes lead: after one frame toward a new target they have moved more
+    solver.reset();
+    frame(rig, solver, right, 1.0f);
+    expectTrue("eyes lead the head",
+               std::fabs(solver.eyeYaw()) > 2.0f * std::fabs(solver.headYaw()));
+
+    // Weight 0 relaxes back to the animated pose
+    settle(rig, solver, right, 0.0f);
+    expectTrue("weight 0 relaxes",
+               std::fabs(solver.headYaw()) + std::fabs(solver.eyeYaw()) < 1e-4f);
+    expectNear("relaxed head faces +Z", forwardYaw(rig.skeleton, kHead), 0.0);
+
+    // Half weight aims half way
+    settle(rig, solver, right, 0.5f);
+    expectNear("half weight", solver.headYaw(), 0.5 * 0.785398);
+
+    // A nod gesture dips the head while the eyes hold the gaze
+    settle(rig, solver, ahead);
+    solver.setGesture(0.0f, -0.1f);
+    frame(rig, solver, ahead, 1.0f);
+    expectNear("gesture dips the head", forwardPitch(rig.skeleton, kHead),
+               -0.1);
+    expectNear("eyes hold the gaze through a gesture",
+               forwardPitch(rig.skeleton, kLeftEye), 0.0);
+    solver.setGesture(0.0f, 0.0f);
+    settle(rig, solver, ahead, 0.0f);
+    frame(rig, solver, ahead, 0.0f);
+    solver.setGesture(0.0f, -0.1f);
+    frame(rig, solver, ahead, 0.0f);
+    expectNear("gesture applies with look-at relaxed",
+               forwardPitch(rig.skeleton, kHead), -0.1);
+    solver.setGesture(0.0f, 0.0f);
+  }
+
+  void turnedBodyTest() {
+    // A clip turning the spine: look-at adds on top, in model space
+    Rig rig = buildRig(0.5f);
+    LookAtSolver solver;
+    solver.bind(kNeck, kHead, kLeftEye, kRightEye);
+    float head[4];
+    frame(rig, solver, nullptr, 0.0f);
+    simd::store(head, rig.skeleton.world()[kHead].col[3]);
+    const float target[3] = {head[0] + 1.0f, head[1], head[2] + 1.0f};
+    settle(rig, solver, target);
+    expectNear("turned body: yaw adds to the animation",
+               forwardYaw(rig.skeleton, kHead), 0.5 + 0.785398);
+    expectNear("turned body: no pitch from the parent frame",
+               forwardPitch(rig.skeleton, kHead), 0.0);
+  }
+
+  void missingJointsTest() {
+    Rig rig = buildRig(0.0f);
+    LookAtSolver solver;
+    solver.bind(LookAtSolver::kNone, kHead, LookAtSolver::kNone,
+                LookAtSolver::kNone);
+    const float right[3] = {1.0f, 1.65f, 1.0f};
+    settle(rig, solver, right);
+    expectNear("no neck: head takes it all", forwardYaw(rig.skeleton, kHead),
+               0.785398);
+
+    LookAtSolver unbound;
+    frame(rig, unbound, right, 1.0f);
+    expectTrue("unbound solver is a no-op", !unbound.bound() &&
+                                                unbound.headYaw() == 0.0f);
+  }
+
+  void timing(int iterations) {
+    Rig rig = buildRig(0.0f);
+    LookAtSolver solver;
+    solver.bind(kNeck, kHead, kLeftEye, kRightEye);
+    BoneTransform* local = rig.skeleton.localPose();
+    float sink = 0.0f;
+
+    double worldNs = 0.0, lookNs = 0.0;
+    for (int i = 0; i < iterations; ++i) {
+      // Moving target so the solver never short-circuits
+      const float t = static_cast<float>(i) * kDt;
+      const float target[3] = {std::sin(t), 1.6f + 0.2f * std::cos(t * 0.7f),
+                               1.5f};
+      for (size_t j = 0; j < rig.animated.size(); ++j) local[j] = rig.animated[j];
+      double start = nowNs();
+      rig.skeleton.computeWorld();
+      double mid = nowNs();
+      solver.apply(rig.skeleton, target, 1.0f, kDt);
+      double end = nowNs();
+      worldNs += mid - start;
+      lookNs += end - mid;
+      sink += column(rig.skeleton, kLeftEye, 3, 0);
+    }
+    std::printf("backend: %s\n", simd::backendName());
+    std::printf("%zu joints (%u under the head): computeWorld %.0f ns, "
+                "look-at %.0f ns per frame (sink %.1f)\n",
+                rig.skeleton.size(), kFaceJoints + 2, worldNs / iterations,
+                lookNs / iterations, sink);
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+  solverTest();
+  turnedBodyTest();
+  missingJointsTest();
+  if (g_failures) {
+    std::fprintf(stderr, "%d look-at check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All look-at checks passed\n");
+  timing(iterations);
+  return 0;
+}
@@ -0,0 +1,390 @@
+/**
+ * mel-test.cpp - Mel feature accuracy against reference values, and cost
+ *
+ * Checks avatar-mel.h against closed-form values and against a plain
+ * double-precision reference (direct DFT, librosa's filterbank formula,
+ * DCT-II by definition):
+ *
+ *   mel scale     Slaney anchors (1 kHz = 15, 6.4 kHz = 42), HTK at 1 kHz,
+ *                 round trips
+ *   STFT          a bin-centred tone of amplitude A has |X|^2 = (A n / 4)^2
+ *                 under the periodic Hann window
+ *   filterbank    unit area in Hz per band (Slaney norm), peaks at the
+ *                 band centres
+ *   log-mel/MFCC  within 0.01 dB / 0.01 of the reference on speech frames
+ *   DCT           a constant maps to c0 = sqrt(M) v; energy is preserved
+ *
+ * Then the streaming API must reproduce batch frames exactly for any
+ * chunking, centred batch framing must match librosa's frame count, and
+ * top_db must clamp. Finally it times one frame of log-mel + MFCC at two
+ * configurations.
+ *
+ * Usage: mel-test
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative native/mel-test.cpp \
+ *     -o build-native/mel-test
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "avatar-mel.h"
+#include "synthetic-speech.h"
+
+namespace {
+  using avatar::FeatureMatrix;
+  using avatar::MelConfig;
+  using avatar::MelExtractor;
+  using avatar::MelScale;
+
+  constexpr double kPi = 3.141592653589793;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.6f, got %.6f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.6f\n", name, actual);
+    }
+  }
+
+  void expectBelow(const char* name, double actual, double limit) {
+    if (!(actual < limit)) {
+      std::fprintf(stderr, "FAIL %s: %.6f, expected < %.6f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.6f\n", name, actual);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /**
+   * Double-precision reference of one frame's log-mel and MFCC
+   */
+  struct Reference {
+    std::vector<double> logMel, mfcc;
+    double peakMel{0.0};
+  };
+
+  Reference reference(const float* frame, const MelConfig& c) {
+    const size_t n = c.fftSize, bins = n / 2 + 1;
+    std::vector<double> power(bins);
+    for (size_t k = 0; k < bins; ++k) {
+      double re = 0.0, im = 0.0;
+      for (size_t i = 0; i < n; ++i) {
+        const double w = 0.5 - 0.5 * std::cos(2.0 * kPi * i / n);
+        re += w * frame[i] * std::cos(2.0 * kPi * k * i / n);
+        im -= w * frame[i] * std::sin(2.0 * kPi * k * i / n);
+      }
+      power[k] = re * re + im * im;
+    }
+
+    // librosa.filters.mel, written out
+    const double fMax = c.fMax > 0.0f ? c.fMax : c.sampleRate / 2.0;
+    const double lo = avatar::hzToMel(c.fMin, c.scale);
+    const double hi = avatar::hzToMel(fMax, c.scale);
+    std::vector<double> edges(c.melBands + 2);
+    for (uint32_t m = 0; m < c.melBands + 2; ++m) {
+      edges[m] = avatar::melToHz(lo + (hi - lo) * m / (c.melBands + 1),
+                                 c.scale);
+    }
+    Reference out;
+    out.logMel.resize(c.melBands);
+    for (uint32_t m = 0; m < c.melBands; ++m) {
+      double sum = 0.0;
+      for (size_t k = 0; k < bins; ++k) {
+        const double hz = static_cast<double>(k) * c.sampleRate / n;
+        const double lower = (hz - edges[m]) / (edges[m + 1] - edges[m]);
+        const double upper =
+            (edges[m + 2] - hz) / (edges[m + 2] - edges[m + 1]);
+        const double weight = std::max(0.0, std::min(lower, upper)) *
+                              (c.areaNorm ? 2.0 / (edges[m + 2] - edges[m])
+                                          : 1.0);
+        sum += weight * power[k];
+      }
+      out.peakMel = std::max(out.peakMel, sum);
+      out.logMel[m] = 10.0 * std::log10(std::max(sum, double{c.floor}));
+    }
+    out.mfcc.resize(c.mfccCount);
+    for (uint32_t k = 0; k < c.mfccCount; ++k) {
+      double sum = 0.0;
+      for (uint32_t i = 0; i < c.melBands; ++i) {
+        sum += out.logMel[i] *
+               std::cos(kPi * k * (2.0 * i + 1.0) / (2.0 * c.melBands));
+      }
+      out.mfcc[k] = sum * std::sqrt((k == 0 ? 1.0 : 2.0) / c.melBands);
+    }
+    return out;
+  }
+
+  void scaleTest() {
+    expectNear("Slaney mel(1 kHz)", avatar::hzToMel(1000.0, MelScale::kSlaney),
+               15.0, 1e-9);
+    expectNear("Slaney mel(6.4 kHz)",
+               avatar::hzToMel(6400.0, MelScale::kSlaney), 42.0, 1e-9);
+    expectNear("Slaney mel(500 Hz)", avatar::hzToMel(500.0, MelScale::kSlaney),
+               7.5, 1e-9);
+    expectNear("HTK mel(1 kHz)", avatar::hzToMel(1000.0, MelScale::kHtk),
+               999.9855, 1e-3);
+    double worst = 0.0;
+    for (double hz = 0.0; hz <= 24000.0; hz += 97.0) {
+      for (MelScale s : {MelScale::kSlaney, MelScale::kHtk}) {
+        worst = std::max(worst, std::fabs(avatar::melToHz(
+                                              avatar::hzToMel(hz, s), s) -
+                                          hz));
+      }
+    }
+    expectBelow("mel round trip (Hz)", worst, 1e-6);
+  }
+
+  void stftTest() {
+    MelConfig c;
+    MelExtractor extractor;
+    extractor.configure(c);
+    const uint32_t k0 = 37;
+    const double amplitude = 0.25;
+    std::vector<float> frame(c.fftSize);
+    for (uint32_t i = 0; i < c.fftSize; ++i) {
+      frame[i] = static_cast<float>(
+          amplitude * std::cos(2.0 * kPi * k0 * i / c.fftSize));
+    }
+    extractor.analyse(frame.data());
+    const double expected = std::pow(amplitude * c.fftSize / 4.0, 2.0);
+    expectNear("bin-centred tone power (relative)",
+               extractor.power()[k0] / expected, 1.0, 1e-4);
+    expectNear("Hann leakage to the next bin (relative)",
+               extractor.power()[k0 + 1] / expected, 0.25, 1e-4);
+    expectBelow("no leakage two bins away (relative)",
+                extractor.power()[k0 + 2] / expected, 1e-8);
+  }
+
+  void filterbankTest() {
+    MelConfig c;
+    c.sampleRate = 32000.0f;
+    c.fftSize = 1024;
+    c.melBands = 80;
+    MelExtractor extractor;
+    extractor.configure(c);
+    const auto& bank = extractor.filterbank();
+    const double binHz = c.sampleRate / c.fftSize;
+    const double lo = avatar::hzToMel(0.0, c.scale);
+    const double hi = avatar::hzToMel(c.sampleRate / 2.0, c.scale);
+
+    double worstArea = 0.0;
+    bool peaks = true;
+    for (uint32_t m = 0; m < c.melBands; ++m) {
+      const double left = avatar::melToHz(lo + (hi - lo) * m / 81.0, c.scale);
+      const double right =
+          avatar::melToHz(lo + (hi - lo) * (m + 2) / 81.0, c.scale);
+      const double centre =
+          avatar::melToHz(lo + (hi - lo) * (m + 1) / 81.0, c.scale);
+      double area = 0.0;
+      uint32_t best = 0;
+      for (uint32_t k = 0; k <= c.fftSize / 2; ++k) {
+        area += bank.weight(m, k) * binHz;
+        if (bank.weight(m, k) > bank.weight(m, best)) best = k;
+      }
+      // Only bands several bins wide integrate cleanly
+      if (right - left > 8.0 * binHz) {
+        worstArea = std::max(worstArea, std::fabs(area - 1.0));
+      }
+      if (std::fabs(best * binHz - centre) > binHz) peaks = false;
+    }
+    expectBelow("Slaney norm: unit area per band", worstArea, 0.02);
+    expectTrue("band peaks at their centres", peaks);
+  }
+
+  void accuracyTest(const MelConfig& c, const char* label) {
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = static_cast<uint32_t>(c.sampleRate);
+    spec.seconds = 3.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    MelExtractor extractor;
+    extractor.configure(c);
+
+    double worstMel = 0.0, worstMfcc = 0.0;
+    const size_t step = speech.samples.size() / 24;
+    for (size_t start = step; start + c.fftSize < speech.samples.size();
+         start += step) {
+      const float* frame = speech.samples.data() + start;
+      extractor.analyse(frame);
+      const Reference ref = reference(frame, c);
+      for (uint32_t m = 0; m < c.melBands; ++m) {
+        // Bands 80 dB under the frame's peak are float noise either way
+        if (ref.logMel[m] < 10.0 * std::log10(ref.peakMel) - 80.0) continue;
+        worstMel = std::max(worstMel,
+                            std::fabs(extractor.logMel()[m] - ref.logMel[m]));
+      }
+      for (uint32_t k = 0; k < c.mfccCount; ++k) {
+        worstMfcc = std::max(worstMfcc,
+                             std::fabs(extractor.mfcc()[k] - ref.mfcc[k]));
+      }
+    }
+    char name[96];
+    std::snprintf(name, sizeof(name), "%s log-mel vs reference (dB)", label);
+    expectBelow(name, worstMel, 0.01);
+    std::snprintf(name, sizeof(name), "%s MFCC vs reference", label);
+    expectBelow(name, worstMfcc, 0.01);
+  }
+
+  void dctTest() {
+    avatar::OrthoDct dct;
+    dct.configure(40, 40);
+    std::vector<float> in(dct.stride(), 0.0f), out(40);
+    std::fill(in.begin(), in.begin() + 40, -12.5f);
+    dct.apply(in.data(), out.data());
+    expectNear("constant: c0 = sqrt(M) v", out[0], std::sqrt(40.0) * -12.5,
+               1e-4);
+    double rest = 0.0;
+    for (int k = 1; k < 40; ++k) {
+      rest = std::max(rest, double{std::fabs(out[k])});
+    }
+    expectBelow("constant: higher coefficients", rest, 1e-4);
+
+    uint32_t state = 12345;
+    double energyIn = 0.0, energyOut = 0.0;
+    for (int i = 0; i < 40; ++i) {
+      state = state * 1664525u + 1013904223u;
+      in[i] = static_cast<float>(state >> 8) / 16777216.0f - 0.5f;
+      energyIn += in[i] * in[i];
+    }
+    dct.apply(in.data(), out.data());
+    for (float v : out) energyOut += v * v;
+    expectNear("orthonormal: energy preserved", energyOut / energyIn, 1.0,
+               1e-5);
+  }
+
+  void streamingTest() {
+    MelConfig c;
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = 16000;
+    spec.seconds = 2.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    const size_t count = speech.samples.size();
+
+    FeatureMatrix batch;
+    avatar::computeLogMel(speech.samples.data(), count, c, batch, false);
+    expectTrue("uncentred frame count",
+               batch.frames == 1 + (count - c.fftSize) / c.hop);
+
+    for (uint32_t chunk : {1u, 37u, 1000u}) {
+      avatar::MelStream stream;
+      stream.configure(c, 1u << 20);
+      uint32_t frame = 0;
+      bool same = true;
+      for (size_t at = 0; at < count; at += chunk) {
+        const uint32_t n =
+            static_cast<uint32_t>(std::min<size_t>(chunk, count - at));
+        stream.push(speech.samples.data() + at, n,
+                    [&](const MelExtractor& e) {
+                      if (frame >= batch.frames) {
+                        same = false;
+                        return;
+                      }
+                      same = same && std::equal(e.logMel(),
+                                                e.logMel() + c.melBands,
+                                                batch.row(frame));
+                      ++frame;
+                    });
+      }
+      char name[96];
+      std::snprintf(name, sizeof(name),
+                    "stream in %u-sample chunks matches batch", chunk);
+      expectTrue(name, same && frame == batch.frames);
+    }
+
+    FeatureMatrix centred;
+    avatar::computeLogMel(speech.samples.data(), count, c, centred, true,
+                          80.0f);
+    expectTrue("centred frame count (1 + n / hop)",
+               centred.frames == 1 + count / c.hop);
+    const float peak = *std::max_element(centred.data.begin(),
+                                         centred.data.end());
+    const float low = *std::min_element(centred.data.begin(),
+                                        centred.data.end());
+    expectTrue("top_db clamps", low >= peak - 80.0f - 1e-4f);
+
+    FeatureMatrix mfcc;
+    avatar::computeMfcc(speech.samples.data(), count, c, mfcc);
+    expectTrue("MFCC matrix shape",
+               mfcc.frames == centred.frames && mfcc.columns == c.mfccCount);
+  }
+
+  void timingTest(const MelConfig& c, const char* label) {
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = static_cast<uint32_t>(c.sampleRate);
+    spec.seconds = 10.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    MelExtractor extractor;
+    extractor.configure(c);
+    const size_t frames = (speech.samples.size() - c.fftSize) / c.hop;
+    const int repeats = 5;
+    float sink = 0.0f;
+    const double start = nowNs();
+    for (int r = 0; r < repeats; ++r) {
+      for (size_t f = 0; f < frames; ++f) {
+        extractor.analyse(speech.samples.data() + f * c.hop);
+        sink += extractor.mfcc()[1];
+      }
+    }
+    const double ns = (nowNs() - start) / (frames * repeats);
+    std::printf("%s (%s): %.2f us per frame, %.0fx realtime (%.1f)\n", label,
+                avatar::simd::backendName(), ns / 1e3,
+                c.hop / c.sampleRate * 1e9 / ns, sink * 0.0f);
+  }
+}  // namespace
+
+int main() {
+  MelConfig runtime;  // 16 kHz, 512-point, 40 bands, 13 MFCCs
+  MelConfig training;
+  training.sampleRate = 32000.0f;
+  training.fftSize = 1024;
+  training.hop = 320;
+  training.melBands = 80;
+  training.fMax = 8000.0f;
+  MelConfig htk = runtime;
+  htk.scale = MelScale::kHtk;
+  htk.areaNorm = false;
+
+  scaleTest();
+  stftTest();
+  filterbankTest();
+  accuracyTest(runtime, "16 kHz/512/40");
+  accuracyTest(training, "32 kHz/1024/80");
+  accuracyTest(htk, "HTK 16 kHz/512/40");
+  dctTest();
+  streamingTest();
+  timingTest(runtime, "16 kHz/512/40 + 13 MFCC");
+  timingTest(training, "32 kHz/1024/80 + 13 MFCC");
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All mel feature checks passed\n");
+  return 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * memory-index-addon.cpp - memory-index.h as a Node addon
+ *
+ * Loaded by app/lib/memoryIndex.ts with process.dlopen. Plain N-API, so
+ * one build serves every Node release since 12:
+ *
+ *   new MemoryIndex(texts, confidence, createdAt)
+ *       texts: string[]; confidence, createdAt: number arrays or typed
+ *       arrays of the same length (createdAt in any monotonic unit)
+ *   index.search(query, k, confidenceWeight = 0.3) -> Uint32Array
+ *       row numbers of the best k matches, best first
+ *   index.top(k, byRecency = false) -> Uint32Array
+ *       most confident rows (newest first among equals), or newest rows
+ *   index.stats() -> { documents, terms, postings, bytes }
+ *   MemoryIndex.tokens(text) -> string[]
+ *       the query tokens search() uses, as tokensFromText returns them
+ *
+ * An index is immutable once built; rebuild it to pick up new rows.
+ * Calls run on the JS thread and take microseconds, so none are async.
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -shared -fPIC -Inative \
+ *     -I"$(dirname "$(which node)")/../include/node" \
+ *     native/memory-index-addon.cpp -o build-native/memory-index.node
+ */
+
+#define NAPI_VERSION 4
+#include <node_api.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "memory-index.h"
+
+// Return at the first failed call; N-API has set the pending exception
+#define NAPI_CHECK(call)     \
+  do {                       \
+    if ((call) != napi_ok) { \
+      return nullptr;        \
+    }                        \
+  } while (0)
+
+namespace {
+  namespace mi = avatar::memoryindex;
+
+  constexpr size_t kMaxResults = 1000;
+
+  bool readString(napi_env env, napi_value value, std::string& out) {
+    size_t length = 0;
+    if (napi_get_value_string_utf8(env, value, nullptr, 0, &length) !=
+        napi_ok) {
+      return false;
+    }
+    out.resize(length + 1);
+    if (napi_get_value_string_utf8(env, value, out.data(), out.size(),
+                                   &length) != napi_ok) {
+      return false;
+    }
+    out.resize(length);
+    return true;
+  }
+
+  /**
+   * Element i of an array or typed array as a double; fallback when it
+   * is missing or not a number
+   */
+  double numberAt(napi_env env, napi_value array, uint32_t i,
+                  double fallback) {
+    napi_value element;
+    double value = fallback;
+    if (napi_get_element(env, array, i, &element) != napi_ok ||
+        napi_get_value_double(env, element, &value) != napi_ok) {
+      napi_value ignored;
+      napi_get_and_clear_last_exception(env, &ignored);
+      return fallback;
+    }
+    return value;
+  }
+
+  uint32_t arrayLength(napi_env env, napi_value value) {
+    bool isArray = false, isTyped = false;
+    napi_is_array(env, value, &isArray);
+    napi_is_typedarray(env, value, &isTyped);
+    if (!isArray && !isTyped) return 0;
+    napi_value lengthValue;
+    uint32_t length = 0;
+    if (napi_get_named_property(env, value, "length", &lengthValue) ==
+        napi_ok) {
+      napi_get_value_uint32(env, lengthValue, &length);
+    }
+    return length;
+  }
+
+  napi_value rowArray(napi_env env, const uint32_t* rows, size_t count) {
+    napi_value buffer, result;
+    void* data = nullptr;
+    NAPI_CHECK(napi_create_arraybuffer(env, count * sizeof(uint32_t), &data,
+                                       &buffer));
+    std::copy_n(rows, count, static_cast<uint32_t*>(data));
+    NAPI_CHECK(napi_create_typedarray(env, napi_uint32_array, count, buffer,
+                                      0, &result));
+    return result;
+  }
+
+  mi::MemoryIndex* unwrap(napi_env env, napi_callback_info info,
+                          size_t* argc, napi_value* argv) {
+    napi_value self;
+    void* index = nullptr;
+    if (napi_get_cb_info(env, info, argc, argv, &self, nullptr) != napi_ok ||
+        napi_unwrap(env, self, &index) != napi_ok) {
+      napi_throw_type_error(env, nullptr, "not a MemoryIndex");
+      return nullptr;
+    }
+    return static_cast<mi::MemoryIndex*>(index);
+  }
+
+  size_t resultCount(napi_env env, napi_value value) {
+    double k = 0;
+    napi_get_value_double(env, value, &k);
+    if (!(k > 0)) return 0;
+    return k < kMaxResults ? static_cast<size_t>(k) : kMaxResults;
+  }
+
+  napi_value construct(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3], self;
+    NAPI_CHECK(napi_get_cb_info(env, info, &argc, argv, &self, nullptr));
+    bool isArray = false;
+    if (argc < 1 || napi_is_array(env, argv[0], &isArray) != napi_ok ||
+        !isArray) {
+      napi_throw_type_error(env, nullptr, "texts must be an array");
+      return nullptr;
+    }
+
+    const uint32_t count = arrayLength(env, argv[0]);
+    std::vector<std::string> texts(count);
+    std::vector<float> confidence(count, 0.5f);
+    std::vector<double> createdAt(count, 0.0);
+    const uint32_t confidenceCount = argc > 1 ? arrayLength(env, argv[1]) : 0;
+    const uint32_t createdCount = argc > 2 ? arrayLength(env, argv[2]) : 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      napi_value text;
+      NAPI_CHECK(napi_get_element(env, argv[0], i, &text));
+      napi_valuetype type;
+      NAPI_CHECK(napi_typeof(env, text, &type));
+      if (type == napi_string && !readString(env, text, texts[i])) {
+        return nullptr;
+      }
+      if (i < confidenceCount) {
+        confidence[i] = static_cast<float>(numberAt(env, argv[1], i, 0.5));
+      }
+      if (i < createdCount) createdAt[i] = numberAt(env, argv[2], i, 0.0);
+    }
+
+    auto* index = new mi::MemoryIndex();
+    index->build(std::vector<std::string_view>(texts.begin(), texts.end()),
+                 confidence, createdAt);
+    const napi_status wrapped = napi_wrap(
+        env, self, index,
+        [](napi_env env, void* data, void*) {
+          auto* index = static_cast<mi::MemoryIndex*>(data);
+          int64_t adjusted;
+          napi_adjust_external_memory(
+              env, -static_cast<int64_t>(index->memoryBytes()), &adjusted);
+          delete index;
+        },
+        nullptr, nullptr);
+    if (wrapped != napi_ok) {
+      delete index;
+      return nullptr;
+    }
+    // Tell the GC what a dropped index would free
+    int64_t adjusted;
+    napi_adjust_external_memory(
+        env, static_cast<int64_t>(index->memoryBytes()), &adjusted);
+    return self;
+  }
+
+  napi_value search(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value argv[3];
+    mi::MemoryIndex* index = unwrap(env, info, &argc, argv);
+    if (!index) return nullptr;
+    std::string query;
+    if (argc < 2 || !readString(env, argv[0], query)) {
+      napi_throw_type_error(env, nullptr, "search(query: string, k: number)");
+      return nullptr;
+    }
+    mi::SearchParams params;
+    if (argc > 2) {
+      double weight = params.confidenceWeight;
+      if (napi_get_value_double(env, argv[2], &weight) == napi_ok) {
+        params.confidenceWeight = static_cast<float>(weight);
+      }
+    }
+    std::vector<uint32_t> rows(resultCount(env, argv[1]));
+    rows.resize(index->search(query, rows.size(), rows.data(), params));
+    return rowArray(env, rows.data(), rows.size());
+  }
+
+  napi_value top(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    mi::MemoryIndex* index = unwrap(env, info, &argc, argv);
+    if (!index) return nullptr;
+    bool byRecency = false;
+    if (argc > 1) napi_get_value_bool(env, argv[1], &byRecency);
+    std::vector<uint32_t> rows(argc > 0 ? resultCount(env, argv[0]) : 0);
+    rows.resize(byRecency ? index->mostRecent(rows.size(), rows.data())
+                          : index->mostConfident(rows.size(), rows.data()));
+    return rowArray(env, rows.data(), rows.size());
+  }
+
+  napi_value stats(napi_env env, napi_callback_info info) {
+    size_t argc = 0;
+    mi::MemoryIndex* index = unwrap(env, info, &argc, nullptr);
+    if (!index) return nullptr;
+    napi_value result;
+    NAPI_CHECK(napi_create_object(env, &result));
+    const std::pair<const char*, size_t> fields[] = {
+        {"documents", index->documents()},
+        {"terms", index->terms()},
+        {"postings", index->postings()},
+        {"bytes", index->memoryBytes()}};
+    for (const auto& [name, value] : fields) {
+      napi_value number;
+      NAPI_CHECK(napi_create_double(env, static_cast<double>(value), &number));
+      NAPI_CHECK(napi_set_named_property(env, result, name, number));
+    }
+    return result;
+  }
+
+  napi_value tokens(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value argv[1];
+    NAPI_CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+    std::string text;
+    if (argc < 1 || !readString(env, argv[0], text)) {
+      napi_throw_type_error(env, nullptr, "tokens(text: string)");
+      return nullptr;
+    }
+    const std::vector<std::string> found = mi::queryTokens(text);
+    napi_value result;
+    NAPI_CHECK(napi_create_array_with_length(env, found.size(), &result));
+    for (uint32_t i = 0; i < found.size(); ++i) {
+      napi_value token;
+      NAPI_CHECK(napi_create_string_utf8(env, found[i].data(),
+                                         found[i].size(), &token));
+      NAPI_CHECK(napi_set_element(env, result, i, token));
+    }
+    return result;
+  }
+}  // namespace
+
+NAPI_MODULE_INIT() {
+  const napi_property_descriptor properties[] = {
+      {"search", nullptr, search, nullptr, nullptr, nullptr, napi_default,
+       nullptr},
+      {"top", nullptr, top, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"stats", nullptr, stats, nullptr, nullptr, nullptr, napi_default,
+       nullptr},
+      {"tokens", nullptr, tokens, nullptr, nullptr, nullptr, napi_static,
+       nullptr}};
+  napi_value constructor;
+  NAPI_CHECK(napi_define_class(env, "MemoryIndex", NAPI_AUTO_LENGTH,
+                               construct, nullptr, std::size(properties),
+                               properties, &constructor));
+  NAPI_CHECK(napi_set_named_property(env, exports, "MemoryIndex",
+                                     constructor));
+  return exports;
+}
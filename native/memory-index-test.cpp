@@ -0,0 +1,324 @@
+/**
+ * memory-index-test.cpp - Memory index ranking checks and query cost
+ *
+ * Exercises memory-index.h:
+ *
+ *   - tokens match tokensFromText: case, separators, length, stopwords,
+ *     the two non-ASCII letters that lower-case to ASCII, and the
+ *     eight-distinct-token query cap
+ *   - search scores equal a double-precision BM25 computed by brute
+ *     force over a generated corpus, prefix matches included
+ *   - confidence blending and tie-breaking by recency
+ *   - queries without tokens match nothing; best/most recent orders
+ *
+ * Ends with build time and microseconds per top-k query over 50k rows.
+ *
+ * Usage: memory-index-test
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative \
+ *     native/memory-index-test.cpp -o build-native/memory-index-test
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "memory-index.h"
+
+namespace {
+  namespace mi = avatar::memoryindex;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  std::vector<std::string> docTokens(const std::string& text) {
+    std::vector<std::string> tokens;
+    mi::forEachToken(text, [&](std::string_view token) {
+      tokens.emplace_back(token);
+    });
+    return tokens;
+  }
+
+  std::string joined(const std::vector<std::string>& tokens) {
+    std::string out;
+    for (const std::string& token : tokens) {
+      if (!out.empty()) out += ' ';
+      out += token;
+    }
+    return out;
+  }
+
+  void tokenizerTest() {
+    expectTrue("lower-cases and splits on non-alphanumerics",
+               joined(mi::queryTokens("Hiking, CAMPING & kayak-trips!")) ==
+                   "hiking camping kayak trips");
+    expectTrue("drops short tokens and stopwords",
+               joined(mi::queryTokens("I would like to be in Tokyo soon")) ==
+                   "tokyo soon");
+    expectTrue("keeps digits",
+               joined(mi::queryTokens("born 1989 in room 42b")) ==
+                   "born 1989 room");
+    expectTrue("non-ASCII letters separate tokens",
+               joined(mi::queryTokens("caf\xC3\xA9s na\xC3\xAFve")) == "");
+    expectTrue("U+0130 lower-cases to i and then separates",
+               joined(mi::queryTokens("\xC4\xB0STANBUL \xC4\xB0stan")) ==
+                   "stanbul stan");
+    expectTrue("the Kelvin sign lower-cases to k",
+               joined(mi::queryTokens("\xE2\x84\xAAnitting")) == "knitting");
+    expectTrue("a truncated sequence at the end is a separator",
+               joined(mi::queryTokens("jazz\xE2\x84")) == "jazz");
+    expectTrue("query keeps eight distinct tokens",
+               joined(mi::queryTokens("aaaa bbbb aaaa cccc dddd eeee ffff "
+                                      "gggg hhhh iiii jjjj")) ==
+                   "aaaa bbbb cccc dddd eeee ffff gggg hhhh");
+    expectTrue("documents keep repeats",
+               joined(docTokens("Ramen ramen RAMEN")) == "ramen ramen ramen");
+  }
+
+  /**
+   * BM25 by definition, in double, prefix terms merged per query token
+   */
+  std::vector<double> referenceBm25(const std::vector<std::string>& texts,
+                                    const std::string& query,
+                                    const mi::SearchParams& p) {
+    std::vector<std::vector<std::string>> docs;
+    double totalLength = 0;
+    for (const std::string& text : texts) {
+      docs.push_back(docTokens(text));
+      totalLength += docs.back().size();
+    }
+    const double n = static_cast<double>(docs.size());
+    const double average = std::max(1.0, totalLength / n);
+    std::vector<double> scores(docs.size(), 0.0);
+    for (const std::string& q : mi::queryTokens(query)) {
+      std::vector<double> tf(docs.size(), 0.0);
+      double df = 0;
+      for (size_t d = 0; d < docs.size(); ++d) {
+        for (const std::string& token : docs[d]) {
+          if (token.compare(0, q.size(), q) == 0) tf[d] += 1;
+        }
+        if (tf[d] > 0) df += 1;
+      }
+      const double idf = std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+      for (size_t d = 0; d < docs.size(); ++d) {
+        if (tf[d] == 0) continue;
+        const double norm =
+            p.k1 * (1.0 - p.b + p.b * docs[d].size() / average);
+        scores[d] += idf * tf[d] * (p.k1 + 1.0) / (tf[d] + norm);
+      }
+    }
+    return scores;
+  }
+
+  const char* kWords[] = {
+      "garden",  "gardening", "guitar",  "guitars", "travel",  "traveled",
+      "travelling", "coffee", "cooking", "cookbook", "running", "runner",
+      "painting", "poetry",  "python",  "pythons", "sailing", "salsa",
+      "hiking",  "history",  "chess",   "chemistry", "family", "friends",
+      "music",   "museum",   "ocean",   "octopus", "winter",  "window"};
+
+  std::string randomText(uint32_t& state, int words) {
+    std::string text;
+    for (int w = 0; w < words; ++w) {
+      state = state * 1664525u + 1013904223u;
+      if (!text.empty()) text += (state & 0x100) ? " " : ", ";
+      text += kWords[(state >> 16) % (sizeof(kWords) / sizeof(*kWords))];
+    }
+    return text;
+  }
+
+  void rankingTest() {
+    std::vector<std::string> texts;
+    std::vector<float> confidence;
+    std::vector<double> createdAt;
+    uint32_t state = 7;
+    for (int d = 0; d < 400; ++d) {
+      texts.push_back(randomText(state, 2 + d % 11));
+      confidence.push_back(static_cast<float>(d % 10) / 9.0f);
+      createdAt.push_back(d);
+    }
+    std::vector<std::string_view> views(texts.begin(), texts.end());
+    mi::MemoryIndex index;
+    index.build(views, confidence, createdAt);
+
+    const char* queries[] = {"garden", "travel plans for winter",
+                             "guitar music", "chess and chemistry",
+                             "python cooking runner", "zebra"};
+    mi::SearchParams bm25Only;
+    bm25Only.confidenceWeight = 0.0f;
+    double worstError = 0;
+    bool sameMatches = true;
+    bool ordered = true;
+    for (const char* query : queries) {
+      const std::vector<double> reference =
+          referenceBm25(texts, query, bm25Only);
+      double best = 0;
+      size_t matching = 0;
+      for (double s : reference) {
+        best = std::max(best, s);
+        if (s > 0) ++matching;
+      }
+      std::vector<uint32_t> ids(texts.size());
+      std::vector<float> scores(texts.size());
+      const size_t n = index.search(query, texts.size(), ids.data(),
+                                    bm25Only, scores.data());
+      sameMatches = sameMatches && n == matching;
+      for (size_t i = 0; i < n; ++i) {
+        worstError = std::max(
+            worstError, std::abs(scores[i] - reference[ids[i]] / best));
+        if (i > 0 && scores[i] > scores[i - 1]) ordered = false;
+      }
+    }
+    expectTrue("search matches the same documents as brute force",
+               sameMatches);
+    expectTrue("normalised BM25 within 1e-5 of the reference",
+               worstError < 1e-5);
+    expectTrue("results come best first", ordered);
+
+    uint32_t id = 0;
+    expectTrue("prefix matches longer terms",
+               index.search("travell", 1, &id) == 1 &&
+                   texts[id].find("travelling") != std::string::npos);
+    expectTrue("a query without tokens matches nothing",
+               index.search("the and of", 5, &id) == 0);
+    expectTrue("an unknown term matches nothing",
+               index.search("zebra", 5, &id) == 0);
+  }
+
+  void blendTest() {
+    const std::vector<std::string_view> texts = {
+        "loves sailing", "loves sailing", "loves sailing", "sailing sailing"};
+    const std::vector<float> confidence = {0.2f, 0.9f, 0.9f, 0.1f};
+    const std::vector<double> createdAt = {10, 20, 30, 40};
+    mi::MemoryIndex index;
+    index.build(texts, confidence, createdAt);
+
+    uint32_t ids[4] = {};
+    mi::SearchParams p;
+    p.confidenceWeight = 0.0f;
+    index.search("sailing", 4, ids, p);
+    expectTrue("without confidence, term frequency wins", ids[0] == 3);
+
+    p.confidenceWeight = 0.5f;
+    index.search("sailing", 4, ids, p);
+    expectTrue("confidence lifts the confident rows",
+               ids[0] != 3 && ids[1] != 3);
+    expectTrue("equal scores rank newest first",
+               ids[0] == 2 && ids[1] == 1);
+
+    p.confidenceWeight = 1.0f;
+    index.search("sailing", 4, ids, p);
+    expectTrue("full weight ranks by confidence alone",
+               ids[0] == 2 && ids[1] == 1 && ids[2] == 0 && ids[3] == 3);
+
+    index.mostConfident(4, ids);
+    expectTrue("most confident, newest first among equals",
+               ids[0] == 2 && ids[1] == 1 && ids[2] == 0 && ids[3] == 3);
+    index.mostRecent(4, ids);
+    expectTrue("most recent", ids[0] == 3 && ids[3] == 0);
+    expectTrue("k beyond the corpus returns every row",
+               index.mostRecent(10, ids) == 4);
+
+    mi::MemoryIndex empty;
+    empty.build({}, {}, {});
+    expectTrue("an empty index answers nothing",
+               empty.search("sailing", 4, ids) == 0 &&
+                   empty.mostConfident(4, ids) == 0);
+  }
+
+  /**
+   * A made-up word for rank r: rank 0 is the most common
+   */
+  std::string syntheticWord(uint32_t r) {
+    std::string word = "w";
+    do {
+      word += static_cast<char>('a' + r % 26);
+      r /= 26;
+    } while (r > 0);
+    return word + "ing";
+  }
+
+  void timingTest() {
+    // Word ranks drawn roughly Zipf-like from a 20k vocabulary, as in
+    // prose; a few hundred words show up in a sizeable share of rows
+    constexpr int kDocs = 50000;
+    constexpr double kVocabulary = 20000;
+    std::vector<std::string> texts;
+    std::vector<float> confidence;
+    std::vector<double> createdAt;
+    uint32_t state = 11;
+    for (int d = 0; d < kDocs; ++d) {
+      std::string text;
+      for (int w = 0; w < 6 + d % 24; ++w) {
+        state = state * 1664525u + 1013904223u;
+        const double u = (state >> 8) / 16777216.0;
+        if (!text.empty()) text += ' ';
+        text += syntheticWord(
+            static_cast<uint32_t>(std::pow(kVocabulary, u)) - 1);
+      }
+      texts.push_back(std::move(text));
+      confidence.push_back(static_cast<float>(d % 100) / 99.0f);
+      createdAt.push_back(d);
+    }
+    std::vector<std::string_view> views(texts.begin(), texts.end());
+    mi::MemoryIndex index;
+    const double buildStart = nowNs();
+    index.build(views, confidence, createdAt);
+    const double buildMs = (nowNs() - buildStart) / 1e6;
+
+    const std::string queries[] = {
+        "what about " + syntheticWord(3) + " " + syntheticWord(250),
+        syntheticWord(40) + " stories from " + syntheticWord(900),
+        syntheticWord(7) + " " + syntheticWord(60) + " " + syntheticWord(5000),
+        "favourite " + syntheticWord(1500) + " to " + syntheticWord(12000)};
+    uint32_t ids[12];
+    constexpr int kRounds = 200;
+    size_t found = 0;
+    const double start = nowNs();
+    for (int r = 0; r < kRounds; ++r) {
+      for (const std::string& query : queries) {
+        found += index.search(query, 12, ids);
+      }
+    }
+    const double perQueryUs =
+        (nowNs() - start) / (kRounds * std::size(queries)) / 1e3;
+    std::printf(
+        "%d docs, %zu terms, %zu postings, %.1f MB: build %.1f ms, "
+        "%.1f us per top-12 query\n",
+        kDocs, index.terms(), index.postings(),
+        index.memoryBytes() / 1048576.0, buildMs, perQueryUs);
+    expectTrue("timed queries found matches", found > 0);
+  }
+}  // namespace
+
+int main() {
+  tokenizerTest();
+  rankingTest();
+  blendTest();
+  timingTest();
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All memory index checks passed\n");
+  return 0;
+}
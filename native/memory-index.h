@@ -0,0 +1,414 @@
+/**
+ * memory-index.h - Inverted index over the mind DB's facts and stories
+ *
+ * getMemoryPack (app/lib/memory.ts) found memories for each chat message
+ * with `ilike any('%token%')` queries, and each was a full scan. This
+ * index holds the same rows in memory and ranks matches by BM25 blended
+ * with each row's confidence, in microseconds.
+ *
+ * Tokens follow tokensFromText:
+ *   - lower-cased, split on anything but a-z and 0-9;
+ *   - at least four characters, with stopwords dropped;
+ *   - a query keeps its first eight distinct tokens.
+ * As with String.toLowerCase, U+0130 folds to "i" and the Kelvin sign to
+ * "k"; every other non-ASCII character separates tokens. A query token
+ * matches each indexed term it is a prefix of ("travel" finds
+ * "travelling"), which keeps most of what the substring match found.
+ *
+ * Postings are flat arrays per term (CSR). The dictionary is sorted, so
+ * a prefix is one binary search. A search accumulates into a dense score
+ * array, records which documents it touched, and partially sorts those.
+ * search() reuses that scratch space, so one index serves one thread.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace avatar {
+namespace memoryindex {
+
+// As in memory.ts; only the four-letter and longer ones can ever match
+inline constexpr std::string_view kStopwords[] = {
+    "the",    "a",     "an",    "and",   "or",    "to",    "of",   "in",
+    "on",     "for",   "with",  "is",    "are",   "was",   "were", "be",
+    "been",   "being", "i",     "me",    "my",    "you",   "your", "it",
+    "that",   "this",  "as",    "at",    "by",    "from",  "we",   "they",
+    "he",     "she",   "them",  "us",    "do",    "does",  "did",  "can",
+    "could",  "should", "would", "will", "just",  "like",  "lol"};
+
+constexpr size_t kMinTokenLength = 4;
+constexpr size_t kMaxQueryTokens = 8;
+
+inline bool isStopword(std::string_view token) {
+  return std::find(std::begin(kStopwords), std::end(kStopwords), token) !=
+         std::end(kStopwords);
+}
+
+/**
+ * Call onToken(std::string_view) for each token of UTF-8 text, in order,
+ * repeats included
+ */
+template <typename OnToken>
+void forEachToken(std::string_view text, OnToken&& onToken) {
+  std::string token;
+  auto flush = [&] {
+    if (token.size() >= kMinTokenLength && !isStopword(token)) {
+      onToken(std::string_view(token));
+    }
+    token.clear();
+  };
+  for (size_t i = 0; i < text.size(); ++i) {
+    const auto c = static_cast<unsigned char>(text[i]);
+    if (c >= 'a' && c <= 'z') {
+      token.push_back(static_cast<char>(c));
+    } else if (c >= 'A' && c <= 'Z') {
+      token.push_back(static_cast<char>(c - 'A' + 'a'));
+    } else if (c >= '0' && c <= '9') {
+      token.push_back(static_cast<char>(c));
+    } else if (c == 0xC4 && i + 1 < text.size() &&
+               static_cast<unsigned char>(text[i + 1]) == 0xB0) {
+      // U+0130 lowers to "i" plus a combining dot, which separates
+      token.push_back('i');
+      flush();
+      ++i;
+    } else if (c == 0xE2 && i + 2 < text.size() &&
+               static_cast<unsigned char>(text[i + 1]) == 0x84 &&
+               static_cast<unsigned char>(text[i + 2]) == 0xAA) {
+      token.push_back('k');  // U+212A KELVIN SIGN
+      i += 2;
+    } else {
+      flush();
+    }
+  }
+  flush();
+}
+
+/**
+ * tokensFromText: the first kMaxQueryTokens distinct tokens
+ */
+inline std::vector<std::string> queryTokens(std::string_view text) {
+  std::vector<std::string> tokens;
+  forEachToken(text, [&](std::string_view token) {
+    if (tokens.size() < kMaxQueryTokens &&
+        std::find(tokens.begin(), tokens.end(), token) == tokens.end()) {
+      tokens.emplace_back(token);
+    }
+  });
+  return tokens;
+}
+
+struct SearchParams {
+  float k1 = 1.2f;
+  float b = 0.75f;
+  // Final score = (1 - w) * BM25 / best BM25 + w * confidence
+  float confidenceWeight = 0.3f;
+};
+
+class MemoryIndex {
+ public:
+  /**
+   * Index count documents. confidence is clamped to 0..1; createdAt
+   * (any monotonic unit) breaks ties, newest first.
+   */
+  void build(const std::vector<std::string_view>& texts,
+             const std::vector<float>& confidence,
+             const std::vector<double>& createdAt) {
+    const auto count = static_cast<uint32_t>(texts.size());
+    confidence_.assign(count, 0.5f);
+    createdAt_.assign(count, 0.0);
+    for (uint32_t d = 0; d < count; ++d) {
+      if (d < confidence.size() && std::isfinite(confidence[d])) {
+        confidence_[d] = std::clamp(confidence[d], 0.0f, 1.0f);
+      }
+      if (d < createdAt.size()) createdAt_[d] = createdAt[d];
+    }
+
+    // Term ids in first-seen order, and each document's (term, tf) runs
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+    std::vector<uint32_t> docTerms, docTf, docStart(count + 1, 0);
+    std::vector<uint32_t> seen;
+    docLength_.assign(count, 0);
+    uint64_t totalLength = 0;
+    for (uint32_t d = 0; d < count; ++d) {
+      seen.clear();
+      forEachToken(texts[d], [&](std::string_view token) {
+        auto [it, added] = ids.try_emplace(std::string(token),
+                                           static_cast<uint32_t>(names.size()));
+        if (added) names.push_back(it->first);
+        seen.push_back(it->second);
+      });
+      docLength_[d] = static_cast<uint32_t>(seen.size());
+      totalLength += seen.size();
+      std::sort(seen.begin(), seen.end());
+      for (size_t i = 0; i < seen.size();) {
+        size_t j = i;
+        while (j < seen.size() && seen[j] == seen[i]) ++j;
+        docTerms.push_back(seen[i]);
+        docTf.push_back(static_cast<uint32_t>(j - i));
+        i = j;
+      }
+      docStart[d + 1] = static_cast<uint32_t>(docTerms.size());
+    }
+    averageLength_ =
+        count > 0 ? std::max(1.0f, static_cast<float>(totalLength) / count)
+                  : 1.0f;
+
+    // Dictionary in sorted order, then postings in that order
+    const auto termCount = static_cast<uint32_t>(names.size());
+    std::vector<uint32_t> order(termCount), rank(termCount);
+    for (uint32_t t = 0; t < termCount; ++t) order[t] = t;
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b) { return names[a] < names[b]; });
+    termText_.clear();
+    termOffset_.assign(termCount + 1, 0);
+    for (uint32_t r = 0; r < termCount; ++r) {
+      rank[order[r]] = r;
+      termText_ += names[order[r]];
+      termOffset_[r + 1] = static_cast<uint32_t>(termText_.size());
+    }
+
+    postingStart_.assign(termCount + 1, 0);
+    for (uint32_t term : docTerms) ++postingStart_[rank[term] + 1];
+    for (uint32_t r = 0; r < termCount; ++r) {
+      postingStart_[r + 1] += postingStart_[r];
+    }
+    postingDoc_.resize(docTerms.size());
+    postingTf_.resize(docTerms.size());
+    std::vector<uint32_t> fill(postingStart_.begin(), postingStart_.end() - 1);
+    for (uint32_t d = 0; d < count; ++d) {
+      for (uint32_t i = docStart[d]; i < docStart[d + 1]; ++i) {
+        const uint32_t at = fill[rank[docTerms[i]]]++;
+        postingDoc_[at] = d;
+        postingTf_[at] = static_cast<uint16_t>(std::min(docTf[i], 65535u));
+      }
+    }
+
+    byConfidence_.resize(count);
+    byRecency_.resize(count);
+    for (uint32_t d = 0; d < count; ++d) byConfidence_[d] = byRecency_[d] = d;
+    std::stable_sort(byConfidence_.begin(), byConfidence_.end(),
+                     [&](uint32_t a, uint32_t b) {
+                       if (confidence_[a] != confidence_[b]) {
+                         return confidence_[a] > confidence_[b];
+                       }
+                       return createdAt_[a] > createdAt_[b];
+                     });
+    std::stable_sort(byRecency_.begin(), byRecency_.end(),
+                     [&](uint32_t a, uint32_t b) {
+                       return createdAt_[a] > createdAt_[b];
+                     });
+
+    norm_.clear();
+    score_.assign(count, 0.0f);
+    tf_.assign(count, 0);
+    touched_.clear();
+    touched_.reserve(count);
+  }
+
+  /**
+   * Best k matches for query text, written to out (best first); returns
+   * how many matched. A query without tokens matches nothing.
+   */
+  size_t search(std::string_view query, size_t k, uint32_t* out,
+                const SearchParams& params = {}, float* scores = nullptr) {
+    touched_.clear();
+    prepareNorms(params);
+    for (const std::string& token : queryTokens(query)) {
+      const auto [first, last] = prefixRange(token);
+      if (first == last) continue;
+      if (last - first == 1) {
+        addTerm(postingStart_[first], postingStart_[first + 1], params);
+      } else {
+        addPrefix(first, last, params);
+      }
+    }
+
+    float best = 0.0f;
+    for (uint32_t d : touched_) best = std::max(best, score_[d]);
+    const float w =
+        std::isfinite(params.confidenceWeight)
+            ? std::clamp(params.confidenceWeight, 0.0f, 1.0f)
+            : SearchParams{}.confidenceWeight;
+    const float scale = best > 0.0f ? (1.0f - w) / best : 0.0f;
+
+    // Keep the k best in a heap whose front is the worst of them
+    top_.clear();
+    for (uint32_t d : touched_) {
+      const Hit hit{scale * score_[d] + w * confidence_[d], createdAt_[d], d};
+      score_[d] = 0.0f;
+      if (top_.size() < k) {
+        top_.push_back(hit);
+        std::push_heap(top_.begin(), top_.end(), ranksBefore);
+      } else if (k > 0 && ranksBefore(hit, top_.front())) {
+        std::pop_heap(top_.begin(), top_.end(), ranksBefore);
+        top_.back() = hit;
+        std::push_heap(top_.begin(), top_.end(), ranksBefore);
+      }
+    }
+    touched_.clear();
+    std::sort_heap(top_.begin(), top_.end(), ranksBefore);
+    for (size_t i = 0; i < top_.size(); ++i) {
+      out[i] = top_[i].doc;
+      if (scores) scores[i] = top_[i].score;
+    }
+    return top_.size();
+  }
+
+  /**
+   * The k most confident documents, newest first among equals
+   */
+  size_t mostConfident(size_t k, uint32_t* out) const {
+    const size_t n = std::min(k, byConfidence_.size());
+    std::copy_n(byConfidence_.begin(), n, out);
+    return n;
+  }
+
+  /**
+   * The k newest documents
+   */
+  size_t mostRecent(size_t k, uint32_t* out) const {
+    const size_t n = std::min(k, byRecency_.size());
+    std::copy_n(byRecency_.begin(), n, out);
+    return n;
+  }
+
+  size_t documents() const { return docLength_.size(); }
+  size_t terms() const {
+    return termOffset_.empty() ? 0 : termOffset_.size() - 1;
+  }
+  size_t postings() const { return postingDoc_.size(); }
+
+  std::string_view term(size_t i) const {
+    return std::string_view(termText_).substr(
+        termOffset_[i], termOffset_[i + 1] - termOffset_[i]);
+  }
+
+  size_t memoryBytes() const {
+    return termText_.capacity() +
+           (termOffset_.capacity() + postingStart_.capacity() +
+            postingDoc_.capacity() + docLength_.capacity() +
+            byConfidence_.capacity() + byRecency_.capacity() +
+            tf_.capacity() + touched_.capacity() + matched_.capacity()) *
+               sizeof(uint32_t) +
+           postingTf_.capacity() * sizeof(uint16_t) +
+           (confidence_.capacity() + norm_.capacity() + score_.capacity()) *
+               sizeof(float) +
+           createdAt_.capacity() * sizeof(double) +
+           top_.capacity() * sizeof(Hit);
+  }
+
+ private:
+  /**
+   * Sorted-dictionary rows [first, last) of terms starting with prefix
+   */
+  std::pair<uint32_t, uint32_t> prefixRange(std::string_view prefix) const {
+    uint32_t lo = 0, hi = static_cast<uint32_t>(terms());
+    while (lo < hi) {
+      const uint32_t mid = lo + (hi - lo) / 2;
+      if (term(mid) < prefix) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    uint32_t end = lo;
+    while (end < terms() && term(end).substr(0, prefix.size()) == prefix) {
+      ++end;
+    }
+    return {lo, end};
+  }
+
+  float idf(size_t df) const {
+    const double n = static_cast<double>(documents());
+    return static_cast<float>(std::log(1.0 + (n - df + 0.5) / (df + 0.5)));
+  }
+
+  /**
+   * Each document's BM25 length normalisation for p, kept between calls
+   */
+  void prepareNorms(const SearchParams& p) {
+    if (normK1_ == p.k1 && normB_ == p.b && norm_.size() == documents()) {
+      return;
+    }
+    norm_.resize(documents());
+    for (size_t d = 0; d < norm_.size(); ++d) {
+      norm_[d] = p.k1 * (1.0f - p.b + p.b * docLength_[d] / averageLength_);
+    }
+    normK1_ = p.k1;
+    normB_ = p.b;
+  }
+
+  void addPosting(uint32_t d, uint32_t tf, float weight) {
+    if (score_[d] == 0.0f) touched_.push_back(d);
+    score_[d] += weight * tf / (tf + norm_[d]);
+  }
+
+  void addTerm(uint32_t begin, uint32_t end, const SearchParams& p) {
+    const float weight = idf(end - begin) * (p.k1 + 1.0f);
+    for (uint32_t i = begin; i < end; ++i) {
+      addPosting(postingDoc_[i], postingTf_[i], weight);
+    }
+  }
+
+  /**
+   * Terms sharing the prefix count as one: their frequencies add up per
+   * document, and the union of their documents is its df
+   */
+  void addPrefix(uint32_t first, uint32_t last, const SearchParams& p) {
+    matched_.clear();
+    for (uint32_t t = first; t < last; ++t) {
+      for (uint32_t i = postingStart_[t]; i < postingStart_[t + 1]; ++i) {
+        const uint32_t d = postingDoc_[i];
+        if (tf_[d] == 0) matched_.push_back(d);
+        tf_[d] += postingTf_[i];
+      }
+    }
+    const float weight = idf(matched_.size()) * (p.k1 + 1.0f);
+    for (uint32_t d : matched_) {
+      addPosting(d, tf_[d], weight);
+      tf_[d] = 0;
+    }
+  }
+
+  struct Hit {
+    float score;
+    double createdAt;
+    uint32_t doc;
+  };
+
+  static bool ranksBefore(const Hit& a, const Hit& b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.createdAt != b.createdAt) return a.createdAt > b.createdAt;
+    return a.doc < b.doc;
+  }
+
+  std::string termText_;
+  std::vector<uint32_t> termOffset_;  // terms + 1, into termText_
+  std::vector<uint32_t> postingStart_;  // terms + 1
+  std::vector<uint32_t> postingDoc_;  // ascending per term
+  std::vector<uint16_t> postingTf_;
+  std::vector<uint32_t> docLength_;  // tokens per document
+  float averageLength_{1.0f};
+  std::vector<float> confidence_;
+  std::vector<double> createdAt_;
+  std::vector<uint32_t> byConfidence_, byRecency_;
+
+  // Search scratch
+  std::vector<float> norm_;
+  float normK1_{0.0f}, normB_{0.0f};
+  std::vector<float> score_;
+  std::vector<uint32_t> tf_;
+  std::vector<uint32_t> touched_, matched_;
+  std::vector<Hit> top_;
+};
+
+}  // namespace memoryindex
+}  // namespace avatar
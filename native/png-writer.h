@@ -0,0 +1,102 @@
+/**
+ * png-writer.h - Uncompressed PNG encoder for synthetic textures
+ *
+ * Emits RGBA8 PNGs using stored (uncompressed) deflate blocks, so no zlib
+ * dependency is needed. Files are large but valid, and decode cost in the
+ * loader scales with pixel count the same way a real texture's would.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace avatar {
+namespace png {
+
+inline uint32_t crc32(const uint8_t* data, size_t length,
+                      uint32_t crc = 0xFFFFFFFFu) {
+  static uint32_t table[256];
+  static bool initialized = false;
+  if (!initialized) {
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[n] = c;
+    }
+    initialized = true;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+namespace detail {
+
+inline void putBE32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int i = 3; i >= 0; --i) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+inline void chunk(std::vector<uint8_t>& out, const char* type,
+                  const std::vector<uint8_t>& data) {
+  putBE32(out, static_cast<uint32_t>(data.size()));
+  const size_t start = out.size();
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), data.begin(), data.end());
+  putBE32(out, crc32(out.data() + start, out.size() - start) ^ 0xFFFFFFFFu);
+}
+
+}  // namespace detail
+
+/**
+ * Encode width x height RGBA8 pixels (row-major, top row first)
+ */
+inline std::vector<uint8_t> encodeRgba(int width, int height,
+                                       const uint8_t* rgba) {
+  std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+  std::vector<uint8_t> header;
+  detail::putBE32(header, static_cast<uint32_t>(width));
+  detail::putBE32(header, static_cast<uint32_t>(height));
+  header.insert(header.end(), {8, 6, 0, 0, 0});  // 8-bit RGBA, no interlace
+  detail::chunk(out, "IHDR", header);
+
+  // Scanlines with filter type 0, wrapped in stored deflate blocks
+  const size_t rowBytes = static_cast<size_t>(width) * 4;
+  std::vector<uint8_t> raw;
+  raw.reserve((rowBytes + 1) * height);
+  for (int y = 0; y < height; ++y) {
+    raw.push_back(0);
+    raw.insert(raw.end(), rgba + y * rowBytes, rgba + (y + 1) * rowBytes);
+  }
+
+  std::vector<uint8_t> zlib = {0x78, 0x01};
+  uint32_t a = 1, b = 0;  // Adler-32
+  size_t offset = 0;
+  do {
+    const size_t block = raw.size() - offset < 65535 ? raw.size() - offset
+                                                     : 65535;
+    const bool last = offset + block == raw.size();
+    zlib.push_back(last ? 1 : 0);
+    zlib.push_back(block & 0xFF);
+    zlib.push_back((block >> 8) & 0xFF);
+    zlib.push_back(~block & 0xFF);
+    zlib.push_back((~block >> 8) & 0xFF);
+    for (size_t i = 0; i < block; ++i) {
+      const uint8_t byte = raw[offset + i];
+      zlib.push_back(byte);
+      a = (a + byte) % 65521;
+      b = (b + a) % 65521;
+    }
+    offset += block;
+  } while (offset < raw.size());
+  detail::putBE32(zlib, (b << 16) | a);
+  detail::chunk(out, "IDAT", zlib);
+
+  detail::chunk(out, "IEND", {});
+  return out;
+}
+
+}  // namespace png
+}  // namespace avatar
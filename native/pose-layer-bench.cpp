@@ -0,0 +1,224 @@
+/**
+ * pose-layer-bench.cpp - Cost of layered pose blending per layer
+ *
+ * Blends a base pose with override and additive layers (full body and
+ * bone-masked) for skeletons from synthetic-avatar.h, two ways:
+ *   seq:   one pass per layer over AoS BoneTransforms (sequential
+ *          blending, the pose round-trips through memory every layer)
+ *   fused: avatar::blendPoseLayers(), all layers per 4-joint block in
+ *          registers over SoA pose buffers
+ * Both produce the same pose; the bench checks they agree before
+ * timing. The mask covers one limb chain (the subtree a face/head layer
+ * would touch).
+ *
+ * Usage: pose-layer-bench [iterations]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative native/pose-layer-bench.cpp \
+ *     -o build-native/pose-layer-bench
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "avatar-pose-layers.h"
+#include "synthetic-avatar.h"
+
+namespace {
+  using avatar::BoneTransform;
+  using avatar::PoseBuffer;
+  using avatar::PoseLayer;
+  namespace simd = avatar::simd;
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void randomPose(std::mt19937& rng, PoseBuffer& pose) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (size_t j = 0; j < pose.size(); ++j) {
+      const float t[3] = {0.1f * unit(rng), 0.1f * unit(rng), 0.1f * unit(rng)};
+      float q[4] = {unit(rng), unit(rng), unit(rng), unit(rng)};
+      const float len =
+          std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+      for (float& c : q) c /= len;
+      const float s[3] = {1.0f + 0.1f * unit(rng), 1.0f, 1.0f};
+      pose.setJoint(j, t, q, s);
+    }
+  }
+
+  std::vector<BoneTransform> toAos(const PoseBuffer& pose) {
+    std::vector<BoneTransform> out(pose.size());
+    pose.toTransforms(out.data());
+    return out;
+  }
+
+  struct AosLayer {
+    const PoseLayer* layer;
+    std::vector<BoneTransform> pose;
+    std::vector<BoneTransform> reference;
+  };
+
+  /**
+   * Reference: one full pass over the AoS pose per layer
+   */
+  void blendSequential(const std::vector<BoneTransform>& base,
+                       const std::vector<AosLayer>& layers,
+                       std::vector<BoneTransform>& out) {
+    out = base;
+    const simd::f32x4 conjSign = simd::set(-1.0f, -1.0f, -1.0f, 1.0f);
+    for (const AosLayer& aos : layers) {
+      const PoseLayer& layer = *aos.layer;
+      size_t begin = 0, end = out.size();
+      if (layer.mask) {
+        begin = layer.mask->begin;
+        end = layer.mask->end;
+      }
+      for (size_t j = begin; j < end; ++j) {
+        const float w =
+            layer.weight * (layer.mask ? layer.mask->weights[j] : 1.0f);
+        BoneTransform& o = out[j];
+        const BoneTransform& p = aos.pose[j];
+        if (layer.mode == avatar::kLayerOverride) {
+          o.translation = simd::lerp(o.translation, p.translation, w);
+          o.scale = simd::lerp(o.scale, p.scale, w);
+          o.rotation = simd::nlerp(o.rotation, p.rotation, w);
+        } else {
+          const BoneTransform& r = aos.reference[j];
+          o.translation = o.translation + (p.translation - r.translation) * w;
+          o.scale = o.scale + (p.scale - r.scale) * w;
+          const simd::Quat conj{simd::mul(r.rotation.v, conjSign)};
+          o.rotation = o.rotation * simd::nlerp(simd::Quat::identity(),
+                                                conj * p.rotation, w);
+        }
+      }
+    }
+  }
+
+  float maxError(const std::vector<BoneTransform>& a,
+                 const std::vector<BoneTransform>& b) {
+    float err = 0.0f;
+    for (size_t j = 0; j < a.size(); ++j) {
+      float va[12], vb[12];
+      simd::store(va, a[j].translation.v);
+      simd::store(va + 4, a[j].rotation.v);
+      simd::store(va + 8, a[j].scale.v);
+      simd::store(vb, b[j].translation.v);
+      simd::store(vb + 4, b[j].rotation.v);
+      simd::store(vb + 8, b[j].scale.v);
+      for (int k = 0; k < 12; ++k) err = std::fmax(err, std::fabs(va[k] - vb[k]));
+    }
+    return err;
+  }
+
+  struct Case {
+    const char* name;
+    int overrides;
+    int additives;
+    bool masked;
+  };
+
+  const Case kCases[] = {
+      {"base", 0, 0, false},
+      {"+override", 1, 0, false},
+      {"+override/mask", 1, 0, true},
+      {"+additive", 0, 1, false},
+      {"+additive/mask", 0, 1, true},
+      {"+2 mixed", 1, 1, false},
+      {"+4 mixed", 2, 2, false},
+      {"+8 mixed", 4, 4, false},
+  };
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+  std::printf("backend: %s\n", simd::backendName());
+  std::printf("%6s %6s %-16s %10s %10s %10s %8s\n", "bones", "masked",
+              "layers", "seq ns", "fused ns", "+ns/layer", "speedup");
+
+  std::mt19937 rng(7);
+  for (const uint32_t bones : {54u, 128u, 256u}) {
+    const std::vector<int32_t> parents =
+        avatar::synthetic::boneParents(bones, 8);
+    avatar::FlatSkeleton skeleton;
+    if (!skeleton.build(parents.data(), parents.size())) {
+      std::fprintf(stderr, "build failed for %u bones\n", bones);
+      return 1;
+    }
+    const avatar::BoneMask mask = avatar::BoneMask::subtree(skeleton, 1);
+
+    PoseBuffer base, reference, out;
+    base.resize(bones);
+    reference.resize(bones);
+    out.resize(bones);
+    randomPose(rng, base);
+    randomPose(rng, reference);
+    std::vector<PoseBuffer> poses(8);
+    for (PoseBuffer& pose : poses) {
+      pose.resize(bones);
+      randomPose(rng, pose);
+    }
+    const std::vector<BoneTransform> baseAos = toAos(base);
+    std::vector<BoneTransform> seqOut;
+
+    double baseFusedNs = 0.0;
+    for (const Case& c : kCases) {
+      std::vector<PoseLayer> layers;
+      for (int i = 0; i < c.overrides + c.additives; ++i) {
+        PoseLayer layer;
+        layer.mode = i < c.overrides ? avatar::kLayerOverride
+                                     : avatar::kLayerAdditive;
+        layer.weight = 0.3f + 0.1f * static_cast<float>(i);
+        layer.pose = &poses[i];
+        layer.reference = &reference;
+        layer.mask = c.masked ? &mask : nullptr;
+        layers.push_back(layer);
+      }
+      std::vector<AosLayer> aosLayers;
+      for (const PoseLayer& layer : layers) {
+        aosLayers.push_back({&layer, toAos(*layer.pose), toAos(reference)});
+      }
+
+      avatar::blendPoseLayers(base, layers.data(),
+                              static_cast<int>(layers.size()), out);
+      blendSequential(baseAos, aosLayers, seqOut);
+      const float err = maxError(toAos(out), seqOut);
+      if (err > 1e-4f) {
+        std::fprintf(stderr, "%u bones, %s: fused/seq mismatch %g\n", bones,
+                     c.name, err);
+        return 1;
+      }
+
+      float sink = 0.0f;
+      double start = nowNs();
+      for (int it = 0; it < iterations; ++it) {
+        blendSequential(baseAos, aosLayers, seqOut);
+        sink += simd::lane<0>(seqOut[it % bones].rotation.v);
+      }
+      const double seqNs = (nowNs() - start) / iterations;
+
+      start = nowNs();
+      for (int it = 0; it < iterations; ++it) {
+        avatar::blendPoseLayers(base, layers.data(),
+                                static_cast<int>(layers.size()), out);
+        sink += out.stream(avatar::kPoseRw)[it % bones];
+      }
+      const double fusedNs = (nowNs() - start) / iterations;
+      if (layers.empty()) baseFusedNs = fusedNs;
+      const double perLayer =
+          layers.empty() ? 0.0 : (fusedNs - baseFusedNs) / layers.size();
+
+      std::printf("%6u %6u %-16s %10.1f %10.1f %10.1f %7.2fx%s\n", bones,
+                  c.masked ? mask.end - mask.begin : 0u, c.name, seqNs,
+                  fusedNs, perLayer, seqNs / fusedNs, sink == 12345.0f ? "!" : "");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,310 @@
+/**
+ * prosody-bench.cpp - Pitch tracker and prosody checks, per-hop cost
+ *
+ * Scores the YIN tracker against synthetic speech with a known f0 at
+ * 48 kHz and 16 kHz: gross pitch error (off by more than 20%), voicing
+ * recall, and false voicing in pauses. It then plays the speech at 60 Hz
+ * frames through ProsodyAnalyzer and checks that pitch accents are found
+ * near the true onsets, nods and brows move while speaking and relax in
+ * silence, and a stalled backlog is dropped rather than analysed. Finally
+ * it times the analyser per 10 ms hop and reports CPU per second of audio.
+ *
+ * With a WAV argument (16-bit PCM or float32, any rate) the recording is
+ * timed and summarised instead of the synthetic signal; it has no ground
+ * truth, so only the synthetic checks gate the exit code.
+ *
+ * Usage: prosody-bench [speech.wav] [repeats]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative native/prosody-bench.cpp \
+ *     -o build-native/prosody-bench
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "avatar-prosody.h"
+#include "synthetic-speech.h"
+#include "wav-io.h"
+
+namespace {
+  using avatar::ProsodyAnalyzer;
+  namespace simd = avatar::simd;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.4f, got %.4f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  void expectBelow(const char* name, double actual, double limit) {
+    if (!(actual < limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected < %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  void expectAbove(const char* name, double actual, double limit) {
+    if (!(actual > limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected > %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Input samples per decimated analysis sample
+  uint32_t decimation(const ProsodyAnalyzer& analyzer, uint32_t sampleRate) {
+    return static_cast<uint32_t>(std::lround(
+        static_cast<double>(sampleRate) / analyzer.tracker().sampleRate()));
+  }
+
+  /**
+   * Push one hop of input at a time so every hop's frame position is known
+   */
+  void pitchTest(uint32_t sampleRate) {
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = sampleRate;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+
+    ProsodyAnalyzer analyzer;
+    analyzer.configure(static_cast<float>(sampleRate));
+    const uint32_t factor = decimation(analyzer, sampleRate);
+    const size_t hopIn = static_cast<size_t>(
+        analyzer.tracker().sampleRate() * ProsodyAnalyzer::kHopSeconds) *
+        factor;
+    const size_t frameIn =
+        static_cast<size_t>(analyzer.tracker().frameSize()) * factor;
+
+    uint32_t voiced = 0, detected = 0, gross = 0, pauses = 0, falseVoiced = 0;
+    uint64_t hops = 0;
+    for (size_t pushed = 0; pushed + hopIn <= speech.samples.size();) {
+      analyzer.push(speech.samples.data() + pushed,
+                    static_cast<uint32_t>(hopIn));
+      pushed += hopIn;
+      if (analyzer.hops() == hops) continue;
+      hops = analyzer.hops();
+
+      // Score frames that are wholly voiced or wholly silent
+      const size_t end = pushed - pushed % factor;
+      const size_t start = end - frameIn;
+      const float truth = speech.f0[start + frameIn / 2];
+      const bool allVoiced = speech.f0[start] > 0.0f && truth > 0.0f &&
+                             speech.f0[end - 1] > 0.0f;
+      const bool allSilent = speech.f0[start] == 0.0f && truth == 0.0f &&
+                             speech.f0[end - 1] == 0.0f;
+      const float hz = analyzer.pitchHz();
+      if (allVoiced) {
+        ++voiced;
+        if (hz > 0.0f) {
+          ++detected;
+          if (std::fabs(hz / truth - 1.0f) > 0.2f) ++gross;
+        }
+      } else if (allSilent) {
+        ++pauses;
+        if (hz > 0.0f) ++falseVoiced;
+      }
+    }
+
+    char name[96];
+    std::snprintf(name, sizeof(name), "%u Hz voicing recall", sampleRate);
+    expectAbove(name, static_cast<double>(detected) / voiced, 0.9);
+    std::snprintf(name, sizeof(name), "%u Hz gross pitch error", sampleRate);
+    expectBelow(name, static_cast<double>(gross) / std::max(detected, 1u),
+                0.02);
+    std::snprintf(name, sizeof(name), "%u Hz false voicing", sampleRate);
+    expectBelow(name, static_cast<double>(falseVoiced) / std::max(pauses, 1u),
+                0.05);
+  }
+
+  /**
+   * Play speech in 60 Hz frames the way the template does; returns
+   * detection times (seconds) of each accent
+   */
+  std::vector<float> play(ProsodyAnalyzer& analyzer, const float* samples,
+                          size_t count, uint32_t sampleRate, float* maxNod,
+                          float* maxBrows) {
+    std::vector<float> accents;
+    const size_t frame = sampleRate / 60;
+    uint32_t seen = analyzer.accents();
+    for (size_t pushed = 0; pushed < count; pushed += frame) {
+      const size_t n = std::min(frame, count - pushed);
+      analyzer.push(samples + pushed, static_cast<uint32_t>(n));
+      analyzer.update(1.0f / 60.0f);
+      if (analyzer.accents() != seen) {
+        seen = analyzer.accents();
+        accents.push_back(static_cast<float>(pushed + n) /
+                          static_cast<float>(sampleRate));
+      }
+      if (maxNod) *maxNod = std::max(*maxNod, analyzer.nod());
+      if (maxBrows) *maxBrows = std::max(*maxBrows, analyzer.brows());
+    }
+    return accents;
+  }
+
+  void accentTest() {
+    avatar::synthetic::SpeechSpec spec;
+    spec.seconds = 20.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+
+    ProsodyAnalyzer analyzer;
+    analyzer.configure(static_cast<float>(spec.sampleRate));
+    float maxNod = 0.0f, maxBrows = 0.0f;
+    const std::vector<float> found =
+        play(analyzer, speech.samples.data(), speech.samples.size(),
+             spec.sampleRate, &maxNod, &maxBrows);
+
+    // A detection counts if it lands within the accented vowel
+    uint32_t hits = 0;
+    std::vector<bool> used(found.size(), false);
+    for (float onset : speech.accentOnsets) {
+      for (size_t i = 0; i < found.size(); ++i) {
+        if (!used[i] && found[i] >= onset && found[i] <= onset + 0.3f) {
+          used[i] = true;
+          ++hits;
+          break;
+        }
+      }
+    }
+    std::printf("     %zu accents, %zu detections, %u matched\n",
+                speech.accentOnsets.size(), found.size(), hits);
+    expectAbove("accent recall",
+                static_cast<double>(hits) / speech.accentOnsets.size(), 0.8);
+    expectAbove("accent precision",
+                static_cast<double>(hits) / std::max<size_t>(found.size(), 1),
+                0.8);
+    expectNear("baseline tracks the speaker",
+               analyzer.baselineHz(), spec.baseHz, spec.baseHz * 0.1);
+    expectAbove("nods while speaking", maxNod, 0.3);
+    expectAbove("brows rise while speaking", maxBrows, 0.3);
+
+    // One second of silence relaxes both
+    const std::vector<float> silence(spec.sampleRate, 0.0f);
+    play(analyzer, silence.data(), silence.size(), spec.sampleRate, nullptr,
+         nullptr);
+    expectBelow("nod relaxes in silence", analyzer.nod(), 0.01);
+    expectBelow("brows relax in silence", analyzer.brows(), 0.01);
+  }
+
+  void backlogTest() {
+    avatar::synthetic::SpeechSpec spec;
+    spec.seconds = 2.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    ProsodyAnalyzer analyzer;
+    analyzer.configure(static_cast<float>(spec.sampleRate));
+    // A stalled tab hands over a whole second at once
+    analyzer.push(speech.samples.data(), spec.sampleRate);
+    expectTrue("backlog analyses at most kMaxHopsPerPush hops",
+               analyzer.hops() == ProsodyAnalyzer::kMaxHopsPerPush);
+    expectTrue("backlog hops are counted as dropped",
+               analyzer.hops() + analyzer.droppedHops() >= 90);
+    // Hops continue seamlessly after the drop
+    const uint64_t before = analyzer.hops();
+    analyzer.push(speech.samples.data() + spec.sampleRate,
+                  spec.sampleRate / 20);
+    expectTrue("next push continues at one hop per 10 ms",
+               analyzer.hops() - before == 5);
+  }
+
+  void bench(const char* label, const std::vector<float>& samples,
+             uint32_t sampleRate, int repeats) {
+    ProsodyAnalyzer analyzer;
+    analyzer.configure(static_cast<float>(sampleRate));
+    // Warm up, then time whole passes at 60 Hz frames
+    play(analyzer, samples.data(), samples.size(), sampleRate, nullptr,
+         nullptr);
+    analyzer.reset();
+    const double start = nowNs();
+    for (int r = 0; r < repeats; ++r) {
+      play(analyzer, samples.data(), samples.size(), sampleRate, nullptr,
+           nullptr);
+    }
+    const double elapsed = nowNs() - start;
+    const double hops = static_cast<double>(analyzer.hops());
+    const double audioSeconds = static_cast<double>(samples.size()) *
+                                repeats / sampleRate;
+    std::printf(
+        "%s: %.1f s at %u Hz (analysis %.0f Hz), %.0f hops\n"
+        "  %.0f ns per hop, %.3f ms CPU per second of audio (%.2f%%)\n"
+        "  %u accents, baseline %.0f Hz, %llu dropped hops, %zu bytes\n",
+        label, audioSeconds / repeats, sampleRate,
+        analyzer.tracker().sampleRate(), hops / repeats, elapsed / hops,
+        elapsed / audioSeconds / 1e6, elapsed / audioSeconds / 1e7,
+        analyzer.accents() / repeats, analyzer.baselineHz(),
+        static_cast<unsigned long long>(analyzer.droppedHops()),
+        analyzer.memoryBytes());
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* wavPath = nullptr;
+  int repeats = 20;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.size() > 4 && arg.compare(arg.size() - 4, 4, ".wav") == 0) {
+      wavPath = argv[i];
+    } else {
+      repeats = std::max(1, std::atoi(argv[i]));
+    }
+  }
+
+  std::printf("SIMD backend: %s\n", simd::backendName());
+  pitchTest(48000);
+  pitchTest(16000);
+  accentTest();
+  backlogTest();
+
+  if (wavPath) {
+    avatar::wav::Audio audio;
+    std::string error;
+    if (!avatar::wav::read(wavPath, audio, &error)) {
+      std::fprintf(stderr, "Cannot read %s: %s\n", wavPath, error.c_str());
+      return 1;
+    }
+    bench(wavPath, audio.samples, audio.sampleRate, repeats);
+  } else {
+    avatar::synthetic::SpeechSpec spec;
+    spec.seconds = 20.0f;
+    bench("synthetic speech",
+          avatar::synthetic::generateSpeech(spec).samples, spec.sampleRate,
+          repeats);
+  }
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d prosody checks failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All prosody checks passed\n");
+  return 0;
+}
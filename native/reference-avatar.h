@@ -0,0 +1,112 @@
+/**
+ * reference-avatar.h - Tiny skinned avatar with known work counts
+ *
+ * One quad (4 vertices, 2 triangles) skinned to a two-bone chain
+ * (Hips -> Head) with the four lip-sync morph targets, plus a two-joint
+ * Hair chain under the Head that the engine simulates as spring bones.
+ * Native harnesses load it through loadAvatarModel() and compare the
+ * engine's counters against the constants below.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glb-writer.h"
+
+namespace avatar {
+namespace reference {
+
+constexpr uint32_t kVertexCount = 4;
+constexpr uint32_t kTriangleCount = 2;
+constexpr uint32_t kBoneCount = 4;
+constexpr uint32_t kMorphTargetCount = 4;
+constexpr uint32_t kPrimitiveCount = 1;
+constexpr uint32_t kSpringChainCount = 1;
+
+inline std::vector<uint8_t> buildReferenceAvatar() {
+  glb::GlbWriter writer;
+
+  const std::vector<float> positions = {
+      -0.5f, 0.0f, 0.0f,  0.5f, 0.0f, 0.0f,
+       0.5f, 1.6f, 0.0f, -0.5f, 1.6f, 0.0f};
+  const std::vector<float> normals = {
+      0, 0, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1};
+  const std::vector<uint16_t> joints = {
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0};
+  const std::vector<float> weights = {
+      1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0};
+  const std::vector<uint16_t> indices = {0, 1, 2, 0, 2, 3};
+
+  const int position = writer.addAccessor(
+      positions, glb::kFloat, kVertexCount, "VEC3", glb::kArrayBuffer,
+      "\"min\":[-0.5,0,0],\"max\":[0.5,1.6,0]");
+  const int normal = writer.addAccessor(normals, glb::kFloat, kVertexCount,
+                                        "VEC3", glb::kArrayBuffer);
+  const int joint = writer.addAccessor(joints, glb::kUnsignedShort,
+                                       kVertexCount, "VEC4",
+                                       glb::kArrayBuffer);
+  const int weight = writer.addAccessor(weights, glb::kFloat, kVertexCount,
+                                        "VEC4", glb::kArrayBuffer);
+  const int index = writer.addAccessor(indices, glb::kUnsignedShort,
+                                       indices.size(), "SCALAR",
+                                       glb::kElementArrayBuffer);
+
+  // Morph targets: each one raises one of the top vertices
+  std::vector<int> targets;
+  for (uint32_t m = 0; m < kMorphTargetCount; ++m) {
+    const float offset = 0.05f * static_cast<float>(m + 1);
+    std::vector<float> delta(kVertexCount * 3, 0.0f);
+    delta[(2 + m % 2) * 3 + 1] = offset;
+
+    std::ostringstream bounds;
+    bounds << "\"min\":[0,0,0],\"max\":[0," << offset << ",0]";
+    targets.push_back(writer.addAccessor(delta, glb::kFloat, kVertexCount,
+                                         "VEC3", glb::kArrayBuffer,
+                                         bounds.str()));
+  }
+
+  std::ostringstream mesh;
+  mesh << "{\"name\":\"AvatarMesh\",\"primitives\":[{\"attributes\":{"
+       << "\"POSITION\":" << position << ",\"NORMAL\":" << normal
+       << ",\"JOINTS_0\":" << joint << ",\"WEIGHTS_0\":" << weight
+       << "},\"indices\":" << index << ",\"targets\":[";
+  for (uint32_t m = 0; m < kMorphTargetCount; ++m) {
+    if (m) mesh << ",";
+    mesh << "{\"POSITION\":" << targets[m] << "}";
+  }
+  mesh << "]}],\"weights\":[0,0,0,0],\"extras\":{\"targetNames\":"
+       << "[\"mouthOpen\",\"mouthRound\",\"eyesLookUp\",\"eyesClose\"]}}";
+  writer.addMesh(mesh.str());
+
+  // Column-major inverse bind matrices: Hips at origin, Head at y = 1.5,
+  // Hair1 at y = 1.6 and Hair2 hanging below it at y = 1.4
+  const std::vector<float> inverseBind = {
+      1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0,    0, 1,
+      1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, -1.5f, 0, 1,
+      1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, -1.6f, 0, 1,
+      1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, -1.4f, 0, 1};
+  const int ibm = writer.addAccessor(inverseBind, glb::kFloat, kBoneCount,
+                                     "MAT4");
+
+  writer.addNode("{\"name\":\"Armature\",\"children\":[1,3]}");
+  writer.addNode("{\"name\":\"Hips\",\"children\":[2]}");
+  writer.addNode(
+      "{\"name\":\"Head\",\"translation\":[0,1.5,0],\"children\":[4]}");
+  writer.addNode("{\"name\":\"AvatarMesh\",\"mesh\":0,\"skin\":0}");
+  writer.addNode(
+      "{\"name\":\"Hair1\",\"translation\":[0,0.1,0],\"children\":[5]}");
+  writer.addNode("{\"name\":\"Hair2\",\"translation\":[0,-0.2,0]}");
+
+  std::ostringstream skin;
+  skin << "{\"inverseBindMatrices\":" << ibm
+       << ",\"joints\":[1,2,4,5],\"skeleton\":1}";
+  writer.addSkin(skin.str());
+
+  writer.setSceneRoots({0});
+  return writer.finish();
+}
+
+}  // namespace reference
+}  // namespace avatar
@@ -0,0 +1,362 @@
+/**
+ * simd-math-bench.cpp - avatar::simd vs. scalar reference microbenchmarks
+ *
+ * Covers the core ops the engine's hot paths use: mat4 * mat4, mat4 *
+ * vec4 over a point batch, TRS compose, quaternion multiply, nlerp pose
+ * blending and sphere-frustum tests. Each op is first checked against a
+ * plain scalar implementation (what glm compiles to without SIMD), then
+ * both are timed over the same data.
+ *
+ * Usage: simd-math-bench [iterations]
+ *
+ * Build commands:
+ *   g++ -std=c++17 -O2 -Iapp/lib native/simd-math-bench.cpp \
+ *     -o build-native/simd-math-bench
+ *   em++ -std=c++17 -O2 -msimd128 -Iapp/lib native/simd-math-bench.cpp \
+ *     -o build-native/simd-math-bench.js   # run with node
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "avatar-simd.h"
+
+namespace {
+  using namespace avatar::simd;
+
+  int g_failures = 0;
+  volatile float g_sink = 0.0f;
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Scalar reference -----------------------------------------------------------
+
+  struct ScalarMat4 {
+    float m[16];  // column-major
+  };
+
+  void scalarMul(const ScalarMat4& a, const ScalarMat4& b, ScalarMat4& r) {
+    for (int c = 0; c < 4; ++c) {
+      for (int row = 0; row < 4; ++row) {
+        float sum = 0.0f;
+        for (int k = 0; k < 4; ++k) sum += a.m[k * 4 + row] * b.m[c * 4 + k];
+        r.m[c * 4 + row] = sum;
+      }
+    }
+  }
+
+  void scalarTransform(const ScalarMat4& a, const float* v, float* r) {
+    for (int row = 0; row < 4; ++row) {
+      r[row] = a.m[row] * v[0] + a.m[4 + row] * v[1] + a.m[8 + row] * v[2] +
+               a.m[12 + row] * v[3];
+    }
+  }
+
+  void scalarQuatMul(const float* a, const float* b, float* r) {
+    r[0] = a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1];
+    r[1] = a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0];
+    r[2] = a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3];
+    r[3] = a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2];
+  }
+
+  void scalarNlerp(const float* a, const float* b, float t, float* r) {
+    const float d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    const float sign = d < 0.0f ? -1.0f : 1.0f;
+    float len2 = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+      r[i] = a[i] + (b[i] * sign - a[i]) * t;
+      len2 += r[i] * r[i];
+    }
+    const float inv = 1.0f / std::sqrt(len2);
+    for (int i = 0; i < 4; ++i) r[i] *= inv;
+  }
+
+  void scalarCompose(const float* t, const float* q, const float* s,
+                     ScalarMat4& m) {
+    const float x = q[0], y = q[1], z = q[2], w = q[3];
+    const float xx = x * x, yy = y * y, zz = z * z;
+    const float xy = x * y, xz = x * z, yz = y * z;
+    const float wx = w * x, wy = w * y, wz = w * z;
+    const float r[9] = {1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy),
+                        2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx),
+                        2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy)};
+    for (int c = 0; c < 3; ++c) {
+      for (int row = 0; row < 3; ++row) m.m[c * 4 + row] = r[c * 3 + row] * s[c];
+      m.m[c * 4 + 3] = 0.0f;
+    }
+    m.m[12] = t[0], m.m[13] = t[1], m.m[14] = t[2], m.m[15] = 1.0f;
+  }
+
+  bool scalarSphereVisible(const float planes[6][4], const float* c,
+                           float radius) {
+    for (int p = 0; p < 6; ++p) {
+      const float d = planes[p][0] * c[0] + planes[p][1] * c[1] +
+                      planes[p][2] * c[2] + planes[p][3];
+      if (d < -radius) return false;
+    }
+    return true;
+  }
+
+  // Helpers --------------------------------------------------------------------
+
+  void expectClose(const char* name, const float* a, const float* b, int n,
+                   float tolerance = 1e-4f) {
+    for (int i = 0; i < n; ++i) {
+      if (std::fabs(a[i] - b[i]) > tolerance) {
+        std::fprintf(stderr, "FAIL %s: element %d %.6f vs %.6f\n", name, i,
+                     a[i], b[i]);
+        ++g_failures;
+        return;
+      }
+    }
+  }
+
+  float frand(unsigned& state) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / 16777216.0f * 2.0f - 1.0f;
+  }
+
+  void randomQuat(unsigned& state, float* q) {
+    float len2 = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+      q[i] = frand(state);
+      len2 += q[i] * q[i];
+    }
+    const float inv = 1.0f / std::sqrt(len2);
+    for (int i = 0; i < 4; ++i) q[i] *= inv;
+  }
+
+  template <typename F>
+  double timeNs(int iterations, int opsPerIteration, F&& body) {
+    body();  // warm up
+    const double start = nowNs();
+    for (int i = 0; i < iterations; ++i) body();
+    return (nowNs() - start) / (static_cast<double>(iterations) *
+                                opsPerIteration);
+  }
+
+  void report(const char* op, double scalarNs, double simdNs) {
+    std::printf("%-22s %9.2f %9.2f %8.2fx\n", op, scalarNs, simdNs,
+                scalarNs / simdNs);
+  }
+}
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+  constexpr int kCount = 1024;
+  unsigned state = 12345u;
+
+  // Shared inputs
+  std::vector<float> translations(kCount * 4), rotations(kCount * 4),
+      rotationsB(kCount * 4), scales(kCount * 4), points(kCount * 4);
+  for (int i = 0; i < kCount; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      translations[i * 4 + k] = frand(state);
+      scales[i * 4 + k] = 1.0f + 0.1f * frand(state);
+      points[i * 4 + k] = 5.0f * frand(state);
+    }
+    translations[i * 4 + 3] = 0.0f;
+    scales[i * 4 + 3] = 0.0f;
+    points[i * 4 + 3] = 1.0f;
+    randomQuat(state, &rotations[i * 4]);
+    randomQuat(state, &rotationsB[i * 4]);
+  }
+
+  std::vector<ScalarMat4> scalarMats(kCount), scalarOut(kCount);
+  std::vector<Mat4> simdMats(kCount), simdOut(kCount);
+  for (int i = 0; i < kCount; ++i) {
+    scalarCompose(&translations[i * 4], &rotations[i * 4], &scales[i * 4],
+                  scalarMats[i]);
+    simdMats[i] = compose(Vec4::load(&translations[i * 4]),
+                          Quat{load(&rotations[i * 4])},
+                          Vec4::load(&scales[i * 4]));
+  }
+
+  // Correctness -----------------------------------------------------------------
+  {
+    float simdFloats[16];
+    simdMats[7].store(simdFloats);
+    expectClose("compose", scalarMats[7].m, simdFloats, 16);
+
+    ScalarMat4 sr;
+    scalarMul(scalarMats[3], scalarMats[9], sr);
+    (simdMats[3] * simdMats[9]).store(simdFloats);
+    expectClose("mat4 mul", sr.m, simdFloats, 16);
+
+    float sv[4], vv[4];
+    scalarTransform(scalarMats[5], &points[20], sv);
+    (simdMats[5] * Vec4::load(&points[20])).store(vv);
+    expectClose("mat4 * vec4", sv, vv, 4);
+
+    float sq[4], vq[4];
+    scalarQuatMul(&rotations[0], &rotationsB[0], sq);
+    store(vq, (Quat{load(&rotations[0])} * Quat{load(&rotationsB[0])}).v);
+    expectClose("quat mul", sq, vq, 4);
+
+    scalarNlerp(&rotations[4], &rotationsB[4], 0.3f, sq);
+    store(vq, nlerp(Quat{load(&rotations[4])}, Quat{load(&rotationsB[4])},
+                    0.3f)
+                  .v);
+    expectClose("nlerp", sq, vq, 4);
+  }
+
+  // A camera looking down -z from z = 5: perspective(50deg, 4:3, 0.1, 100)
+  const float f = 1.0f / std::tan(0.5f * 50.0f * 3.14159265f / 180.0f);
+  const float proj[16] = {f / (4.0f / 3.0f), 0, 0, 0, 0, f, 0, 0,
+                          0, 0, -100.1f / 99.9f, -1,
+                          0, 0, -20.0f / 99.9f, 0};
+  const float view[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, -5, 1};
+  const Mat4 viewProjection = Mat4::load(proj) * Mat4::load(view);
+  const Frustum frustum = Frustum::fromViewProjection(viewProjection);
+  float scalarPlanes[6][4];
+  {
+    float vp[16];
+    viewProjection.store(vp);
+    for (int i = 0; i < 4; ++i) {
+      const float r0 = vp[i * 4], r1 = vp[i * 4 + 1], r2 = vp[i * 4 + 2],
+                  r3 = vp[i * 4 + 3];
+      scalarPlanes[0][i] = r3 + r0, scalarPlanes[1][i] = r3 - r0;
+      scalarPlanes[2][i] = r3 + r1, scalarPlanes[3][i] = r3 - r1;
+      scalarPlanes[4][i] = r3 + r2, scalarPlanes[5][i] = r3 - r2;
+    }
+    for (auto& p : scalarPlanes) {
+      const float inv = 1.0f / std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+      for (float& x : p) x *= inv;
+    }
+    int mismatches = 0;
+    for (int i = 0; i < kCount; ++i) {
+      const float* c = &points[i * 4];
+      mismatches += scalarSphereVisible(scalarPlanes, c, 0.5f) !=
+                    frustum.sphereVisible(c[0], c[1], c[2], 0.5f);
+    }
+    if (mismatches) {
+      std::fprintf(stderr, "FAIL frustum: %d mismatches\n", mismatches);
+      ++g_failures;
+    }
+    if (!frustum.sphereVisible(0, 0, 0, 0.1f) ||
+        frustum.sphereVisible(0, 0, 20, 0.1f)) {
+      std::fprintf(stderr, "FAIL frustum: known points misclassified\n");
+      ++g_failures;
+    }
+  }
+
+  if (g_failures) {
+    std::fprintf(stderr, "%d correctness check(s) failed\n", g_failures);
+    return 1;
+  }
+
+  // Timing ----------------------------------------------------------------------
+  std::printf("backend: %s, %d x %d ops\n", backendName(), iterations, kCount);
+  std::printf("%-22s %9s %9s %9s\n", "op", "scalar ns", "simd ns", "speedup");
+
+  report("mat4 * mat4",
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             scalarMul(scalarMats[i], scalarMats[(i + 1) % kCount],
+                       scalarOut[i]);
+           }
+           g_sink = g_sink + scalarOut[kCount / 2].m[5];
+         }),
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             simdOut[i] = simdMats[i] * simdMats[(i + 1) % kCount];
+           }
+           g_sink = g_sink + lane<1>(simdOut[kCount / 2].col[1]);
+         }));
+
+  std::vector<float> outPoints(kCount * 4);
+  report("mat4 * vec4 batch",
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             scalarTransform(scalarMats[0], &points[i * 4], &outPoints[i * 4]);
+           }
+           g_sink = g_sink + outPoints[7];
+         }),
+         timeNs(iterations, kCount, [&] {
+           const Mat4& m = simdMats[0];
+           for (int i = 0; i < kCount; ++i) {
+             store(&outPoints[i * 4], transform(m, load(&points[i * 4])));
+           }
+           g_sink = g_sink + outPoints[7];
+         }));
+
+  report("TRS compose",
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             scalarCompose(&translations[i * 4], &rotations[i * 4],
+                           &scales[i * 4], scalarOut[i]);
+           }
+           g_sink = g_sink + scalarOut[3].m[0];
+         }),
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             simdOut[i] = compose(Vec4::load(&translations[i * 4]),
+                                  Quat{load(&rotations[i * 4])},
+                                  Vec4::load(&scales[i * 4]));
+           }
+           g_sink = g_sink + lane<0>(simdOut[3].col[0]);
+         }));
+
+  std::vector<float> outQuats(kCount * 4);
+  report("quat * quat",
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             scalarQuatMul(&rotations[i * 4], &rotationsB[i * 4],
+                           &outQuats[i * 4]);
+           }
+           g_sink = g_sink + outQuats[5];
+         }),
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             store(&outQuats[i * 4], (Quat{load(&rotations[i * 4])} *
+                                      Quat{load(&rotationsB[i * 4])})
+                                         .v);
+           }
+           g_sink = g_sink + outQuats[5];
+         }));
+
+  report("nlerp (pose blend)",
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             scalarNlerp(&rotations[i * 4], &rotationsB[i * 4], 0.25f,
+                         &outQuats[i * 4]);
+           }
+           g_sink = g_sink + outQuats[5];
+         }),
+         timeNs(iterations, kCount, [&] {
+           for (int i = 0; i < kCount; ++i) {
+             store(&outQuats[i * 4], nlerp(Quat{load(&rotations[i * 4])},
+                                           Quat{load(&rotationsB[i * 4])},
+                                           0.25f)
+                                         .v);
+           }
+           g_sink = g_sink + outQuats[5];
+         }));
+
+  report("sphere vs frustum",
+         timeNs(iterations, kCount, [&] {
+           int visible = 0;
+           for (int i = 0; i < kCount; ++i) {
+             visible += scalarSphereVisible(scalarPlanes, &points[i * 4], 0.5f);
+           }
+           g_sink = g_sink + static_cast<float>(visible);
+         }),
+         timeNs(iterations, kCount, [&] {
+           int visible = 0;
+           for (int i = 0; i < kCount; ++i) {
+             const float* c = &points[i * 4];
+             visible += frustum.sphereVisible(c[0], c[1], c[2], 0.5f);
+           }
+           g_sink = g_sink + static_cast<float>(visible);
+         }));
+
+  return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * skeleton-bench.cpp - Flat skeleton vs. pointer hierarchy world pass
+ *
+ * Times the world-matrix pass for skeletons of increasing size and depth
+ * (hierarchies from synthetic-avatar.h) two ways:
+ *   tree: heap-allocated nodes linked by child pointers, allocated in
+ *         shuffled order with interleaved allocations so they scatter the
+ *         way a loader's incremental node creation does, walked
+ *         recursively
+ *   flat: avatar::FlatSkeleton::computeWorld(), one forward pass
+ * Both compute the same matrices; the bench checks they agree before
+ * timing.
+ *
+ * Usage: skeleton-bench [iterations]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative native/skeleton-bench.cpp \
+ *     -o build-native/skeleton-bench
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "avatar-skeleton.h"
+#include "synthetic-avatar.h"
+
+namespace {
+  struct Node {
+    avatar::BoneTransform local;
+    avatar::simd::Mat4 world = avatar::simd::Mat4::identity();
+    std::vector<Node*> children;
+  };
+
+  void updateTree(Node* node, const avatar::simd::Mat4& parentWorld) {
+    node->world = parentWorld * avatar::composeTransform(node->local);
+    for (Node* child : node->children) updateTree(child, node->world);
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  avatar::BoneTransform samplePose(uint32_t joint) {
+    avatar::BoneTransform t;
+    const float angle = 0.05f * static_cast<float>(joint % 17);
+    t.translation = avatar::simd::Vec4::make(0.01f * (joint % 5), 0.1f, 0.0f,
+                                             0.0f);
+    t.rotation =
+        avatar::simd::Quat::make(0.0f, 0.0f, std::sin(angle), std::cos(angle));
+    return t;
+  }
+
+  void runCase(uint32_t bones, uint32_t depth, int iterations) {
+    const std::vector<int> parents =
+        avatar::synthetic::boneParents(bones, depth);
+    std::vector<int32_t> parents32(parents.begin(), parents.end());
+
+    // Pointer tree, nodes allocated in shuffled order among decoys
+    std::mt19937 rng(bones * 131 + depth);
+    std::vector<uint32_t> order(bones);
+    for (uint32_t i = 0; i < bones; ++i) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<std::unique_ptr<Node>> nodes(bones);
+    std::vector<std::unique_ptr<char[]>> decoys;
+    for (uint32_t i : order) {
+      nodes[i] = std::make_unique<Node>();
+      nodes[i]->local = samplePose(i);
+      decoys.emplace_back(new char[64 + rng() % 512]);
+    }
+    for (uint32_t i = 1; i < bones; ++i) {
+      nodes[parents[i]]->children.push_back(nodes[i].get());
+    }
+
+    avatar::FlatSkeleton flat;
+    if (!flat.build(parents32.data(), parents32.size())) {
+      std::fprintf(stderr, "build failed for %u bones\n", bones);
+      std::exit(1);
+    }
+    std::vector<avatar::BoneTransform> pose(bones);
+    for (uint32_t i = 0; i < bones; ++i) pose[i] = samplePose(i);
+    flat.setLocalPose(pose.data());
+
+    // Agreement check
+    const avatar::simd::Mat4 root = avatar::simd::Mat4::identity();
+    updateTree(nodes[0].get(), root);
+    flat.computeWorld(root);
+    for (uint32_t i = 0; i < bones; ++i) {
+      float a[16], b[16];
+      nodes[i]->world.store(a);
+      flat.world()[flat.flatIndex(i)].store(b);
+      for (int k = 0; k < 16; ++k) {
+        if (std::fabs(a[k] - b[k]) > 1e-4f) {
+          std::fprintf(stderr, "mismatch at joint %u\n", i);
+          std::exit(1);
+        }
+      }
+    }
+
+    double start = nowNs();
+    for (int it = 0; it < iterations; ++it) updateTree(nodes[0].get(), root);
+    const double treeNs = (nowNs() - start) / iterations;
+
+    start = nowNs();
+    for (int it = 0; it < iterations; ++it) flat.computeWorld(root);
+    const double flatNs = (nowNs() - start) / iterations;
+
+    std::printf("%6u %6u %6u %10.1f %10.1f %8.2fx\n", bones, flat.maxDepth(),
+                static_cast<uint32_t>(flat.size()), treeNs / bones,
+                flatNs / bones, treeNs / flatNs);
+  }
+}
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+  std::printf("%6s %6s %6s %10s %10s %9s\n", "bones", "depth", "flat",
+              "tree ns/b", "flat ns/b", "speedup");
+  for (uint32_t bones : {64u, 256u, 1024u}) {
+    uint32_t previous = 0;
+    for (uint32_t depth : {4u, 16u, 64u, bones}) {
+      if (depth > bones || depth == previous) continue;
+      previous = depth;
+      runCase(bones, depth, iterations);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,296 @@
+/**
+ * speech-cache-server.cpp - Speech cache service on a Unix socket
+ *
+ * Owns one speech-cache.h store and serves it to the Next.js routes
+ * (app/lib/speechCache.ts), one thread per connection. Lookups run
+ * concurrently; stores and compaction take the store exclusively. Each
+ * request is one ASCII line, then its binary fields back to back:
+ *
+ *   GET <voice> <emotion> <text>\n voice emotion text
+ *       -> HIT <key> <audio> <timing>\n audio timing  |  MISS <key>\n
+ *   PUT <voice> <emotion> <text> <audio>\n voice emotion text audio
+ *       -> OK <key>\n
+ *   TIMING <key> <timing>\n timing
+ *       -> OK <key>\n  |  MISS <key>\n
+ *   STATS\n
+ *       -> STATS entries=N timings=N live_bytes=N file_bytes=N hits=N
+ *          misses=N evictions=N compactions=N\n
+ *
+ * Numbers in a request line are field lengths in bytes; key is the
+ * 16-hex-digit key digest. Errors answer ERR <reason>\n and close the
+ * connection. A connection may send any number of requests.
+ *
+ * Usage:
+ *   speech-cache-server <store file> <socket path> [--max-mb N]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -pthread -Iapp/lib -Inative \
+ *     native/speech-cache-server.cpp -o build-native/speech-cache-server
+ */
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "speech-cache.h"
+
+namespace {
+  namespace sc = avatar::speechcache;
+
+  constexpr size_t kMaxLine = 256;
+  constexpr uint32_t kMaxVoiceBytes = 256;
+  constexpr uint32_t kMaxEmotionBytes = 64;
+  constexpr uint32_t kMaxTextBytes = 4096;
+
+  volatile sig_atomic_t g_stop = 0;
+
+  void onSignal(int) { g_stop = 1; }
+
+  /**
+   * Buffered reads from a connected socket
+   */
+  class SocketReader {
+   public:
+    explicit SocketReader(int fd) : fd_(fd) {}
+
+    bool line(std::string& out) {
+      out.clear();
+      for (;;) {
+        if (at_ == end_ && !fill()) return false;
+        const char c = static_cast<char>(buffer_[at_++]);
+        if (c == '\n') return true;
+        if (out.size() >= kMaxLine) return false;
+        out.push_back(c);
+      }
+    }
+
+    bool bytes(void* out, size_t count) {
+      auto* dst = static_cast<uint8_t*>(out);
+      while (count > 0) {
+        if (at_ == end_ && !fill()) return false;
+        const size_t n = std::min(count, end_ - at_);
+        std::memcpy(dst, buffer_ + at_, n);
+        at_ += n;
+        dst += n;
+        count -= n;
+      }
+      return true;
+    }
+
+   private:
+    bool fill() {
+      ssize_t n;
+      do {
+        n = ::read(fd_, buffer_, sizeof(buffer_));
+      } while (n < 0 && errno == EINTR);
+      if (n <= 0) return false;
+      at_ = 0;
+      end_ = static_cast<size_t>(n);
+      return true;
+    }
+
+    int fd_;
+    uint8_t buffer_[64 * 1024];
+    size_t at_{0}, end_{0};
+  };
+
+  bool writeAll(int fd, const void* data, size_t count) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    while (count > 0) {
+      const ssize_t n = ::send(fd, p, count, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) return false;
+      p += n;
+      count -= static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  bool reply(int fd, const std::string& line) {
+    return writeAll(fd, line.data(), line.size());
+  }
+
+  void serve(int fd, sc::SpeechCache& cache) {
+    SocketReader in(fd);
+    std::string line, fields, error;
+    std::vector<uint8_t> audio, timing;
+    while (in.line(line)) {
+      char verb[8] = {};
+      unsigned long a = 0, b = 0, c = 0, d = 0;
+      char key[17] = {};
+      uint64_t digest = 0;
+
+      if (std::sscanf(line.c_str(), "%7s", verb) != 1) break;
+      if (!std::strcmp(verb, "GET") || !std::strcmp(verb, "PUT")) {
+        const bool put = verb[0] == 'P';
+        const int want = put ? 4 : 3;
+        if (std::sscanf(line.c_str() + 3, "%lu %lu %lu %lu", &a, &b, &c,
+                        &d) != want ||
+            a > kMaxVoiceBytes || b > kMaxEmotionBytes ||
+            c > kMaxTextBytes ||
+            (put && d > sc::SpeechCache::kMaxAudioBytes)) {
+          reply(fd, "ERR bad request\n");
+          break;
+        }
+        fields.resize(a + b + c);
+        audio.resize(d);
+        if (!in.bytes(fields.data(), fields.size()) ||
+            !in.bytes(audio.data(), audio.size())) {
+          break;
+        }
+        const std::string_view all(fields);
+        const sc::CacheKey cacheKey{all.substr(0, a), all.substr(a, b),
+                                    all.substr(a + b, c)};
+        const std::string hex = sc::digestHex(sc::keyDigest(cacheKey));
+        if (put) {
+          if (!cache.put(cacheKey, audio.data(), audio.size(), &error)) {
+            reply(fd, "ERR " + error + "\n");
+            break;
+          }
+          if (!reply(fd, "OK " + hex + "\n")) break;
+          continue;
+        }
+
+        // Copy out so a slow client never holds writers off
+        {
+          const sc::SpeechCache::Entry entry = cache.find(cacheKey);
+          if (entry) {
+            audio.assign(entry.audio, entry.audio + entry.audioBytes);
+            timing.assign(entry.timing, entry.timing + entry.timingBytes);
+          } else {
+            audio.clear();
+          }
+        }
+        if (audio.empty()) {
+          if (!reply(fd, "MISS " + hex + "\n")) break;
+          continue;
+        }
+        if (!reply(fd, "HIT " + hex + " " + std::to_string(audio.size()) +
+                           " " + std::to_string(timing.size()) + "\n") ||
+            !writeAll(fd, audio.data(), audio.size()) ||
+            !writeAll(fd, timing.data(), timing.size())) {
+          break;
+        }
+      } else if (!std::strcmp(verb, "TIMING")) {
+        if (std::sscanf(line.c_str() + 6, "%16s %lu", key, &a) != 2 ||
+            !sc::parseDigest(key, digest) ||
+            a > sc::SpeechCache::kMaxTimingBytes) {
+          reply(fd, "ERR bad request\n");
+          break;
+        }
+        timing.resize(a);
+        if (!in.bytes(timing.data(), timing.size())) break;
+        const bool ok =
+            cache.attachTiming(digest, timing.data(), timing.size());
+        if (!reply(fd, std::string(ok ? "OK " : "MISS ") + key + "\n")) {
+          break;
+        }
+      } else if (!std::strcmp(verb, "STATS")) {
+        const sc::Stats s = cache.stats();
+        char text[256];
+        std::snprintf(text, sizeof(text),
+                      "STATS entries=%zu timings=%zu live_bytes=%llu "
+                      "file_bytes=%llu hits=%llu misses=%llu evictions=%llu "
+                      "compactions=%llu\n",
+                      s.entries, s.timings,
+                      static_cast<unsigned long long>(s.liveBytes),
+                      static_cast<unsigned long long>(s.fileBytes),
+                      static_cast<unsigned long long>(s.hits),
+                      static_cast<unsigned long long>(s.misses),
+                      static_cast<unsigned long long>(s.evictions),
+                      static_cast<unsigned long long>(s.compactions));
+        if (!reply(fd, text)) break;
+      } else {
+        reply(fd, "ERR unknown request\n");
+        break;
+      }
+    }
+    ::close(fd);
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  sc::Options options;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--max-mb") && i + 1 < argc) {
+      options.maxLiveBytes = std::strtoull(argv[++i], nullptr, 10) << 20;
+    } else if (argv[i][0] != '-') {
+      positional.push_back(argv[i]);
+    } else {
+      positional.clear();
+      break;
+    }
+  }
+  if (positional.size() != 2 || options.maxLiveBytes == 0) {
+    std::fprintf(stderr, "usage: speech-cache-server <store file> "
+                         "<socket path> [--max-mb N]\n");
+    return 2;
+  }
+
+  sc::SpeechCache cache;
+  std::string error;
+  if (!cache.open(positional[0], options, &error)) {
+    std::fprintf(stderr, "Cannot open %s: %s\n", positional[0].c_str(),
+                 error.c_str());
+    return 1;
+  }
+
+  const std::string& socketPath = positional[1];
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    std::fprintf(stderr, "Socket path too long\n");
+    return 1;
+  }
+  std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ::unlink(socketPath.c_str());
+  if (listener < 0 ||
+      ::bind(listener, reinterpret_cast<sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(listener, 64) != 0) {
+    std::fprintf(stderr, "Cannot listen on %s: %s\n", socketPath.c_str(),
+                 std::strerror(errno));
+    return 1;
+  }
+
+  // No SA_RESTART, so a signal interrupts accept() and ends the loop
+  struct sigaction action{};
+  action.sa_handler = onSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  const sc::Stats opened = cache.stats();
+  std::printf("Serving %s on %s: %zu entries, %.1f MB live\n",
+              positional[0].c_str(), socketPath.c_str(), opened.entries,
+              opened.liveBytes / 1048576.0);
+  std::fflush(stdout);
+  while (!g_stop) {
+    const int fd = ::accept(listener, nullptr, nullptr);
+    if (fd < 0) continue;
+    std::thread(serve, fd, std::ref(cache)).detach();
+  }
+  ::close(listener);
+  ::unlink(socketPath.c_str());
+
+  const sc::Stats s = cache.stats();
+  std::printf("%zu entries (%zu with timing), %llu hits, %llu misses, "
+              "%llu evictions, %llu compactions\n",
+              s.entries, s.timings, static_cast<unsigned long long>(s.hits),
+              static_cast<unsigned long long>(s.misses),
+              static_cast<unsigned long long>(s.evictions),
+              static_cast<unsigned long long>(s.compactions));
+  return 0;
+}
@@ -0,0 +1,384 @@
+/**
+ * speech-cache-test.cpp - Speech cache store checks and lookup cost
+ *
+ * Exercises speech-cache.h on a scratch file:
+ *
+ *   - round trips: audio by full key, timing by digest, replacement
+ *   - other keys miss, and field boundaries are part of the key
+ *   - entries and timing survive a reopen; a damaged tail is dropped
+ *     and overwritten
+ *   - over budget, compaction evicts least recently used entries and
+ *     keeps the ones just looked up; rewriting one key stays bounded
+ *   - a read-only reader picks up appends and compactions on refresh,
+ *     and its old view stays readable until then
+ *   - reader threads verify every hit while a writer stores, attaches
+ *     timing and compacts underneath them
+ *
+ * Ends with lookup and store throughput.
+ *
+ * Usage: speech-cache-test
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -pthread -Iapp/lib -Inative \
+ *     native/speech-cache-test.cpp -o build-native/speech-cache-test
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "speech-cache.h"
+
+namespace {
+  namespace fs = std::filesystem;
+  namespace sc = avatar::speechcache;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  /**
+   * Stand-in MP3: bytes derived from the key's text, so any hit can be
+   * checked against the key that found it
+   */
+  std::vector<uint8_t> audioFor(const std::string& text, size_t bytes) {
+    std::vector<uint8_t> audio(bytes);
+    uint64_t state = sc::fnv1a(text.data(), text.size());
+    for (uint8_t& b : audio) {
+      state = state * 6364136223846793005ull + 1442695040888963407ull;
+      b = static_cast<uint8_t>(state >> 56);
+    }
+    return audio;
+  }
+
+  bool holds(const sc::SpeechCache::Entry& entry,
+             const std::vector<uint8_t>& audio) {
+    return entry && entry.audioBytes == audio.size() &&
+           std::equal(audio.begin(), audio.end(), entry.audio);
+  }
+
+  std::string phrase(int i) {
+    return "canned reply number " + std::to_string(i);
+  }
+
+  struct ScratchFile {
+    fs::path path;
+    explicit ScratchFile(const char* name)
+        : path(fs::temp_directory_path() / name) {
+      remove();
+    }
+    ~ScratchFile() { remove(); }
+    void remove() {
+      std::error_code ec;
+      fs::remove(path, ec);
+      fs::remove(path.string() + ".compact", ec);
+    }
+  };
+
+  void roundTripTest() {
+    uint64_t digest = 0;
+    const uint64_t key = sc::keyDigest({"voice", "neutral", "Hello there"});
+    expectTrue("digest hex round trip",
+               sc::parseDigest(sc::digestHex(key), digest) && digest == key);
+    expectTrue("malformed digests rejected",
+               !sc::parseDigest("12345", digest) &&
+                   !sc::parseDigest("0123456789ABCDEF", digest));
+    expectTrue("fields are separated in the digest",
+               sc::keyDigest({"ab", "c", "d"}) !=
+                   sc::keyDigest({"a", "bc", "d"}));
+
+    ScratchFile file("speech-cache-test-roundtrip.bin");
+    sc::SpeechCache cache;
+    std::string error;
+    expectTrue("create store", cache.open(file.path.string(), {}, &error));
+
+    const auto hello = audioFor("Hello there", 30000);
+    const sc::CacheKey helloKey{"voice", "neutral", "Hello there"};
+    expectTrue("put", cache.put(helloKey, hello.data(), hello.size()));
+    {
+      auto entry = cache.find(helloKey);
+      expectTrue("find returns the audio", holds(entry, hello));
+      expectTrue("no timing yet", entry.timing == nullptr);
+    }
+    expectTrue("other emotion misses",
+               !cache.find({"voice", "happy", "Hello there"}));
+    expectTrue("other text misses",
+               !cache.find({"voice", "neutral", "Hello there!"}));
+    expectTrue("empty fields miss cleanly", !cache.find({"", "", ""}));
+
+    const float timing[4] = {0.0f, 0.12f, 0.31f, 0.58f};
+    const auto* timingBytes = reinterpret_cast<const uint8_t*>(timing);
+    expectTrue("attach timing",
+               cache.attachTiming(key, timingBytes, sizeof(timing)));
+    expectTrue("timing for an unknown key refused",
+               !cache.attachTiming(key ^ 1, timingBytes, sizeof(timing)));
+    {
+      auto entry = cache.find(helloKey);
+      expectTrue("find returns the timing",
+                 entry.timingBytes == sizeof(timing) &&
+                     std::equal(timingBytes, timingBytes + sizeof(timing),
+                                entry.timing));
+    }
+
+    const auto shorter = audioFor("Hello again", 12000);
+    cache.put(helloKey, shorter.data(), shorter.size());
+    {
+      auto entry = cache.find(helloKey);
+      expectTrue("put replaces the audio", holds(entry, shorter));
+      expectTrue("replacing drops stale timing", entry.timing == nullptr);
+    }
+    cache.attachTiming(key, timingBytes, sizeof(timing));
+
+    const sc::Stats before = cache.stats();
+    cache.close();
+    expectTrue("reopen", cache.open(file.path.string(), {}, &error));
+    const sc::Stats after = cache.stats();
+    {
+      auto entry = cache.find(helloKey);
+      expectTrue("entry and timing survive a reopen",
+                 holds(entry, shorter) && entry.timingBytes == sizeof(timing));
+    }
+    expectTrue("live bytes restored", after.liveBytes == before.liveBytes &&
+                                          after.fileBytes == before.fileBytes);
+
+    // A crash between writing a record and publishing it leaves junk
+    // past the committed length; pretend it got published
+    const uint64_t committed = after.fileBytes;
+    cache.close();
+    {
+      std::FILE* f = std::fopen(file.path.string().c_str(), "r+b");
+      const uint64_t torn = committed + 40;
+      const uint8_t junk[40] = {0x53, 0x52, 0x45, 0x43, 1};
+      std::fseek(f, static_cast<long>(committed), SEEK_SET);
+      std::fwrite(junk, 1, sizeof(junk), f);
+      std::fseek(f, 8, SEEK_SET);
+      std::fwrite(&torn, sizeof(torn), 1, f);
+      std::fclose(f);
+    }
+    expectTrue("open with a damaged tail",
+               cache.open(file.path.string(), {}, &error));
+    expectTrue("damaged tail dropped",
+               cache.stats().fileBytes == committed &&
+                   holds(cache.find(helloKey), shorter));
+    const auto next = audioFor("After the crash", 5000);
+    cache.put({"voice", "neutral", "After the crash"}, next.data(),
+              next.size());
+    cache.close();
+    cache.open(file.path.string(), {}, &error);
+    expectTrue("appends after recovery are readable",
+               holds(cache.find({"voice", "neutral", "After the crash"}),
+                     next) &&
+                   holds(cache.find(helloKey), shorter));
+  }
+
+  void evictionTest() {
+    ScratchFile file("speech-cache-test-lru.bin");
+    sc::Options options;
+    options.maxLiveBytes = 200000;  // about 19 entries of 10 kB
+    sc::SpeechCache cache;
+    std::string error;
+    cache.open(file.path.string(), options, &error);
+
+    for (int i = 0; i < 16; ++i) {
+      const auto audio = audioFor(phrase(i), 10000);
+      cache.put({"voice", "neutral", phrase(i)}, audio.data(), audio.size());
+    }
+    // The oldest three are used again, so they are now the most recent
+    for (int i = 0; i < 3; ++i) cache.find({"voice", "neutral", phrase(i)});
+    for (int i = 16; i < 24; ++i) {
+      const auto audio = audioFor(phrase(i), 10000);
+      cache.put({"voice", "neutral", phrase(i)}, audio.data(), audio.size());
+    }
+
+    const sc::Stats s = cache.stats();
+    expectTrue("over budget: compacted and evicted",
+               s.compactions >= 1 && s.evictions > 0);
+    expectTrue("live bytes within budget", s.liveBytes <= 200000);
+    bool recentKept = true;
+    for (int i : {0, 1, 2, 21, 22, 23}) {
+      recentKept = recentKept &&
+                   holds(cache.find({"voice", "neutral", phrase(i)}),
+                         audioFor(phrase(i), 10000));
+    }
+    expectTrue("recently used entries kept", recentKept);
+    expectTrue("least recently used entry evicted",
+               !cache.find({"voice", "neutral", phrase(3)}));
+
+    cache.close();
+    cache.open(file.path.string(), options, &error);
+    expectTrue("compacted store reopens with the same entries",
+               cache.stats().entries == s.entries &&
+                   holds(cache.find({"voice", "neutral", phrase(22)}),
+                         audioFor(phrase(22), 10000)));
+
+    // Rewriting one key leaves dead records; they are reclaimed
+    const auto audio = audioFor("again", 20000);
+    for (int i = 0; i < 300; ++i) {
+      cache.put({"voice", "neutral", "again"}, audio.data(), audio.size());
+    }
+    expectTrue("dead records reclaimed",
+               cache.stats().fileBytes < 2 * (1u << 20) + 200000);
+  }
+
+  void readerTest() {
+    ScratchFile file("speech-cache-test-reader.bin");
+    sc::SpeechCache writer, reader;
+    std::string error;
+    writer.open(file.path.string(), {}, &error);
+    const auto first = audioFor(phrase(0), 8000);
+    writer.put({"voice", "neutral", phrase(0)}, first.data(), first.size());
+
+    sc::Options readOnly;
+    readOnly.readOnly = true;
+    expectTrue("open read-only",
+               reader.open(file.path.string(), readOnly, &error));
+    expectTrue("reader sees existing entries",
+               holds(reader.find({"voice", "neutral", phrase(0)}), first));
+    expectTrue("reader cannot write",
+               !reader.put({"voice", "neutral", "x"}, first.data(), 1));
+
+    // Enough to grow the file past the reader's mapping
+    for (int i = 1; i < 200; ++i) {
+      const auto audio = audioFor(phrase(i), 8000);
+      writer.put({"voice", "neutral", phrase(i)}, audio.data(), audio.size());
+    }
+    expectTrue("appends invisible before refresh",
+               !reader.find({"voice", "neutral", phrase(150)}));
+    expectTrue("refresh", reader.refresh(&error));
+    expectTrue("appends visible after refresh",
+               holds(reader.find({"voice", "neutral", phrase(150)}),
+                     audioFor(phrase(150), 8000)));
+
+    writer.put({"voice", "neutral", phrase(0)}, first.data(), first.size());
+    writer.compact();
+    expectTrue("old view readable after the writer compacts",
+               holds(reader.find({"voice", "neutral", phrase(7)}),
+                     audioFor(phrase(7), 8000)));
+    const auto late = audioFor("late", 8000);
+    writer.put({"voice", "neutral", "late"}, late.data(), late.size());
+    expectTrue("refresh after compaction", reader.refresh(&error));
+    expectTrue("reader follows the compacted file",
+               holds(reader.find({"voice", "neutral", "late"}), late) &&
+                   reader.stats().entries == writer.stats().entries);
+  }
+
+  void concurrencyTest() {
+    ScratchFile file("speech-cache-test-threads.bin");
+    sc::Options options;
+    options.maxLiveBytes = 2u << 20;  // evicts and compacts under load
+    sc::SpeechCache cache;
+    std::string error;
+    cache.open(file.path.string(), options, &error);
+
+    constexpr int kKeys = 400;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> hits{0}, wrong{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([&, t] {
+        uint32_t state = 7u + t;
+        while (!done.load(std::memory_order_relaxed)) {
+          state = state * 1664525u + 1013904223u;
+          const std::string text = phrase(static_cast<int>(state >> 8) %
+                                          kKeys);
+          auto entry = cache.find({"voice", "neutral", text});
+          if (!entry) continue;
+          hits.fetch_add(1, std::memory_order_relaxed);
+          const auto expected = audioFor(text, entry.audioBytes);
+          const bool timingOk =
+              !entry.timing || (entry.timingBytes == 8 &&
+                                entry.timing[0] == entry.audio[0]);
+          if (!holds(entry, expected) || !timingOk) {
+            wrong.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      });
+    }
+
+    for (int round = 0; round < 6; ++round) {
+      for (int i = 0; i < kKeys; ++i) {
+        const std::string text = phrase(i);
+        const auto audio = audioFor(text, 4000 + (i * 37 + round) % 9000);
+        const sc::CacheKey key{"voice", "neutral", text};
+        cache.put(key, audio.data(), audio.size());
+        const uint8_t timing[8] = {audio[0]};
+        cache.attachTiming(sc::keyDigest(key), timing, sizeof(timing));
+      }
+    }
+    done = true;
+    for (std::thread& reader : readers) reader.join();
+
+    const sc::Stats s = cache.stats();
+    std::printf("     %llu reader hits, %llu compactions, %llu evictions\n",
+                static_cast<unsigned long long>(hits.load()),
+                static_cast<unsigned long long>(s.compactions),
+                static_cast<unsigned long long>(s.evictions));
+    expectTrue("concurrent readers saw hits", hits.load() > 0);
+    expectTrue("every concurrent hit intact", wrong.load() == 0);
+    expectTrue("evictions ran under readers",
+               s.compactions > 0 && s.evictions > 0);
+  }
+
+  void timingTest() {
+    ScratchFile file("speech-cache-test-timing.bin");
+    sc::SpeechCache cache;
+    std::string error;
+    cache.open(file.path.string(), {}, &error);
+    constexpr int kKeys = 2000;
+    const auto audio = audioFor("typical reply", 60000);  // ~4 s at 128 kb/s
+
+    double start = nowNs();
+    for (int i = 0; i < kKeys; ++i) {
+      cache.put({"voice", "neutral", phrase(i)}, audio.data(), audio.size());
+    }
+    const double putNs = (nowNs() - start) / kKeys;
+
+    std::vector<std::string> texts;
+    for (int i = 0; i < kKeys; ++i) texts.push_back(phrase(i * 7 % kKeys));
+    constexpr int kLookups = 200000;
+    uint64_t sink = 0;
+    start = nowNs();
+    for (int i = 0; i < kLookups; ++i) {
+      auto entry = cache.find({"voice", "neutral", texts[i % kKeys]});
+      sink += entry.audioBytes;
+    }
+    const double findNs = (nowNs() - start) / kLookups;
+    std::printf("put: %.1f us per 60 kB entry (%.0f MB/s); find: %.0f ns "
+                "(%llu)\n",
+                putNs / 1e3, 60000.0 / putNs * 1e3, findNs,
+                static_cast<unsigned long long>(sink % 10));
+  }
+}  // namespace
+
+int main() {
+  roundTripTest();
+  evictionTest();
+  readerTest();
+  concurrencyTest();
+  timingTest();
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All speech cache checks passed\n");
+  return 0;
+}
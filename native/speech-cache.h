@@ -0,0 +1,710 @@
+/**
+ * speech-cache.h - Content-addressed store for synthesized speech
+ *
+ * Replies the twin repeats (greetings, canned answers) only need to be
+ * synthesized once. Each entry is keyed by (voice, emotion, text) and
+ * holds the MP3 the TTS service returned. Once a client has aligned its
+ * mouth to that audio, the entry also holds the viseme timing, so a hit
+ * skips both synthesis and alignment.
+ *
+ * The store is one append-only file, memory mapped:
+ *
+ *   header (64 bytes) | record | record | ...    records 8-byte aligned
+ *   record = RecordHeader | key bytes | payload
+ *
+ * An audio record carries the full key (voice \0 emotion \0 text) and
+ * the MP3. A timing record carries only the key digest and the timing.
+ * An append writes the record first and then publishes it by advancing
+ * the header's committed length, so a crash leaves at most an unpublished
+ * tail that the next open ignores. The in-memory index maps the 64-bit
+ * key digest (FNV-1a) to the newest audio and timing records. Lookups
+ * compare the full key, so a digest collision is a miss, never the wrong
+ * audio.
+ *
+ * Any number of readers share a lock and read straight from the mapping;
+ * put, attachTiming and compaction take it exclusively, and new readers
+ * wait behind a waiting writer. Recency is a
+ * per-entry tick that readers bump atomically under the shared lock.
+ * When live bytes exceed the budget, or dead records outweigh live ones,
+ * the store is compacted: the most recently used entries, up to
+ * keepFraction of the budget, are copied to a new file that is renamed
+ * over the old one. Another process can open the same file read-only
+ * and call refresh() to pick up appends; after a compaction it reopens
+ * the new file, and its old mapping stays valid until it does.
+ *
+ * Appends are not fsynced, so a power cut can lose recent entries; for
+ * a cache that only costs a resynthesis. POSIX only (mmap, rename): this
+ * backs the cache service, not the engine.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace avatar {
+namespace speechcache {
+
+struct CacheKey {
+  std::string_view voice;
+  std::string_view emotion;
+  std::string_view text;
+};
+
+inline uint64_t fnv1a(const void* data, size_t size,
+                      uint64_t hash = 14695981039346656037ull) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+  }
+  return hash;
+}
+
+/**
+ * Digest of the key as stored: voice \0 emotion \0 text
+ */
+inline uint64_t keyDigest(const CacheKey& key) {
+  const char zero = 0;
+  uint64_t hash = fnv1a(key.voice.data(), key.voice.size());
+  hash = fnv1a(&zero, 1, hash);
+  hash = fnv1a(key.emotion.data(), key.emotion.size(), hash);
+  hash = fnv1a(&zero, 1, hash);
+  return fnv1a(key.text.data(), key.text.size(), hash);
+}
+
+inline std::string digestHex(uint64_t digest) {
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx",
+                static_cast<unsigned long long>(digest));
+  return hex;
+}
+
+inline bool parseDigest(std::string_view hex, uint64_t& digest) {
+  if (hex.size() != 16) return false;
+  digest = 0;
+  for (char c : hex) {
+    int value;
+    if (c >= '0' && c <= '9') {
+      value = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      value = c - 'a' + 10;
+    } else {
+      return false;
+    }
+    digest = digest << 4 | static_cast<uint64_t>(value);
+  }
+  return true;
+}
+
+namespace detail {
+
+constexpr char kFileMagic[8] = {'A', 'V', 'S', 'P', 'C', 'H', '0', '1'};
+constexpr uint32_t kRecordMagic = 0x43455253;  // "SREC"
+constexpr uint32_t kAudioRecord = 1;
+constexpr uint32_t kTimingRecord = 2;
+constexpr uint64_t kGrowBytes = 1u << 20;
+
+struct FileHeader {
+  char magic[8];
+  uint64_t committed;  // end of the last published record
+  uint64_t generation;  // bumped by each compaction
+  uint8_t reserved[40];
+};
+static_assert(sizeof(FileHeader) == 64, "header is one cache line");
+
+struct RecordHeader {
+  uint32_t magic;
+  uint32_t kind;
+  uint64_t digest;
+  uint32_t keyBytes;
+  uint32_t payloadBytes;
+  uint32_t checksum;  // of key and payload
+  uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) == 32, "record header is 8-aligned");
+
+inline uint64_t recordBytes(uint64_t keyBytes, uint64_t payloadBytes) {
+  return (sizeof(RecordHeader) + keyBytes + payloadBytes + 7) & ~7ull;
+}
+
+inline uint32_t checksum(const uint8_t* data, size_t size) {
+  const uint64_t hash = fnv1a(data, size);
+  return static_cast<uint32_t>(hash ^ hash >> 32);
+}
+
+}  // namespace detail
+
+struct Options {
+  uint64_t maxLiveBytes = 256ull << 20;  // entries kept before evicting
+  float keepFraction = 0.75f;  // of maxLiveBytes, kept by an eviction
+  bool readOnly = false;  // another process owns the file
+};
+
+struct Stats {
+  size_t entries{0}, timings{0};
+  uint64_t liveBytes{0}, fileBytes{0};
+  uint64_t hits{0}, misses{0}, evictions{0}, compactions{0};
+};
+
+class SpeechCache {
+ public:
+  static constexpr uint32_t kMaxKeyBytes = 8192;
+  static constexpr uint32_t kMaxAudioBytes = 32u << 20;
+  static constexpr uint32_t kMaxTimingBytes = 64u << 10;
+
+  /**
+   * A found entry. The views point into the mapping; writers wait while
+   * any Entry is alive, so copy out and drop it promptly, and never look
+   * up again on the same thread while holding one.
+   */
+  class Entry {
+   public:
+    explicit operator bool() const { return audio != nullptr; }
+
+    uint64_t digest{0};
+    const uint8_t* audio{nullptr};
+    uint32_t audioBytes{0};
+    const uint8_t* timing{nullptr};  // null until attached
+    uint32_t timingBytes{0};
+
+   private:
+    friend class SpeechCache;
+    std::shared_lock<std::shared_mutex> lock_;
+  };
+
+  SpeechCache() = default;
+  SpeechCache(const SpeechCache&) = delete;
+  SpeechCache& operator=(const SpeechCache&) = delete;
+  ~SpeechCache() { close(); }
+
+  /**
+   * Open or create the store at path and index it; false with a reason
+   * on error. A read-only open needs an existing store.
+   */
+  bool open(const std::string& path, const Options& options,
+            std::string* error = nullptr) {
+    auto lock = lockForWrite();
+    closeLocked();
+    path_ = path;
+    options_ = options;
+    return openLocked(error);
+  }
+
+  void close() {
+    auto lock = lockForWrite();
+    closeLocked();
+  }
+
+  bool isOpen() const { return map_ != nullptr; }
+
+  /**
+   * Look an entry up by its full key; counts a hit or a miss and marks
+   * the entry most recently used
+   */
+  Entry find(const CacheKey& key) {
+    Entry entry;
+    entry.lock_ = lockForRead();
+    const uint64_t digest = keyDigest(key);
+    auto it = map_ ? index_.find(digest) : index_.end();
+    if (it == index_.end() || !keyMatches(it->second.audio, key)) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      entry.lock_.unlock();
+      return entry;
+    }
+    Slot& slot = it->second;
+    slot.lastUse.store(clock_.fetch_add(1, std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    entry.digest = digest;
+    const auto* audio = record(slot.audio);
+    entry.audio = payload(slot.audio);
+    entry.audioBytes = audio->payloadBytes;
+    if (slot.timing != 0) {
+      entry.timing = payload(slot.timing);
+      entry.timingBytes = record(slot.timing)->payloadBytes;
+    }
+    return entry;
+  }
+
+  /**
+   * Store the audio for key, replacing any previous entry (and its
+   * timing); may evict and compact
+   */
+  bool put(const CacheKey& key, const uint8_t* audio, size_t bytes,
+           std::string* error = nullptr) {
+    auto lock = lockForWrite();
+    if (!writable(error)) return false;
+    const size_t keyBytes =
+        key.voice.size() + key.emotion.size() + key.text.size() + 2;
+    if (keyBytes > kMaxKeyBytes || bytes == 0 || bytes > kMaxAudioBytes) {
+      return fail(error, "key or audio size out of range");
+    }
+    std::string joined;
+    joined.reserve(keyBytes);
+    joined.append(key.voice).append(1, '\0');
+    joined.append(key.emotion).append(1, '\0');
+    joined.append(key.text);
+
+    const uint64_t digest = keyDigest(key);
+    uint64_t offset;
+    if (!append(detail::kAudioRecord, digest,
+                reinterpret_cast<const uint8_t*>(joined.data()), keyBytes,
+                audio, bytes, offset, error)) {
+      return false;
+    }
+    indexRecord(offset);
+    maybeCompact();
+    return true;
+  }
+
+  /**
+   * Attach viseme timing to the entry with this digest, replacing any
+   * earlier timing; false if there is no such entry
+   */
+  bool attachTiming(uint64_t digest, const uint8_t* timing, size_t bytes,
+                    std::string* error = nullptr) {
+    auto lock = lockForWrite();
+    if (!writable(error)) return false;
+    if (bytes == 0 || bytes > kMaxTimingBytes) {
+      return fail(error, "timing size out of range");
+    }
+    if (index_.find(digest) == index_.end()) {
+      return fail(error, "no such entry");
+    }
+    uint64_t offset;
+    if (!append(detail::kTimingRecord, digest, nullptr, 0, timing, bytes,
+                offset, error)) {
+      return false;
+    }
+    indexRecord(offset);
+    maybeCompact();
+    return true;
+  }
+
+  /**
+   * Pick up records another process appended, reopening the file if it
+   * was compacted; read-only stores only
+   */
+  bool refresh(std::string* error = nullptr) {
+    auto lock = lockForWrite();
+    if (!map_ || !options_.readOnly) return fail(error, "not a reader");
+    struct stat now;
+    if (::stat(path_.c_str(), &now) != 0) return fail(error, "store gone");
+    if (now.st_ino != inode_ || now.st_dev != device_) {
+      closeLocked();
+      return openLocked(error);
+    }
+    const uint64_t committed = committedLength();
+    if (committed > mapBytes_ && !remap(committed, error)) return false;
+    scan(scanned_, committedLength());
+    return true;
+  }
+
+  /**
+   * Drop dead records and, above the budget, the least recently used
+   * entries; readers of the old file in other processes keep their view
+   */
+  bool compact(std::string* error = nullptr) {
+    auto lock = lockForWrite();
+    if (!writable(error)) return false;
+    return compactLocked(liveBytes_ > options_.maxLiveBytes, error);
+  }
+
+  Stats stats() const {
+    auto lock = lockForRead();
+    Stats s;
+    s.entries = index_.size();
+    for (const auto& [digest, slot] : index_) {
+      if (slot.timing != 0) ++s.timings;
+    }
+    s.liveBytes = liveBytes_;
+    s.fileBytes = map_ ? committedLength() : 0;
+    s.hits = hits_.load(std::memory_order_relaxed);
+    s.misses = misses_.load(std::memory_order_relaxed);
+    s.evictions = evictions_;
+    s.compactions = compactions_;
+    return s;
+  }
+
+ private:
+  struct Slot {
+    uint64_t audio{0};  // record offsets; 0 = none
+    uint64_t timing{0};
+    uint64_t bytes{0};  // both records as stored
+    std::atomic<uint64_t> lastUse{0};
+  };
+
+  /**
+   * std::shared_mutex may prefer readers, which would starve stores on a
+   * busy service; readers hold off while a writer waits
+   */
+  std::unique_lock<std::shared_mutex> lockForWrite() {
+    writersWaiting_.fetch_add(1, std::memory_order_acquire);
+    std::unique_lock lock(mutex_);
+    writersWaiting_.fetch_sub(1, std::memory_order_release);
+    return lock;
+  }
+
+  std::shared_lock<std::shared_mutex> lockForRead() const {
+    while (writersWaiting_.load(std::memory_order_acquire) > 0) {
+      std::this_thread::yield();
+    }
+    return std::shared_lock(mutex_);
+  }
+
+  static bool fail(std::string* error, const char* reason) {
+    if (error) *error = reason;
+    return false;
+  }
+
+  bool writable(std::string* error) const {
+    if (!map_) return fail(error, "store not open");
+    if (options_.readOnly) return fail(error, "store is read-only");
+    return true;
+  }
+
+  detail::FileHeader* header() const {
+    return reinterpret_cast<detail::FileHeader*>(map_);
+  }
+
+  uint64_t committedLength() const {
+    return __atomic_load_n(&header()->committed, __ATOMIC_ACQUIRE);
+  }
+
+  const detail::RecordHeader* record(uint64_t offset) const {
+    return reinterpret_cast<const detail::RecordHeader*>(map_ + offset);
+  }
+
+  const uint8_t* payload(uint64_t offset) const {
+    return map_ + offset + sizeof(detail::RecordHeader) +
+           record(offset)->keyBytes;
+  }
+
+  bool keyMatches(uint64_t offset, const CacheKey& key) const {
+    const auto* r = record(offset);
+    if (r->keyBytes !=
+        key.voice.size() + key.emotion.size() + key.text.size() + 2) {
+      return false;
+    }
+    const char* p =
+        reinterpret_cast<const char*>(map_ + offset + sizeof(*r));
+    const std::string_view parts[3] = {key.voice, key.emotion, key.text};
+    for (int i = 0; i < 3; ++i) {
+      if (std::memcmp(p, parts[i].data(), parts[i].size()) != 0) {
+        return false;
+      }
+      p += parts[i].size();
+      if (i < 2 && *p++ != '\0') return false;
+    }
+    return true;
+  }
+
+  bool openLocked(std::string* error) {
+    const bool readOnly = options_.readOnly;
+    fd_ = ::open(path_.c_str(), readOnly ? O_RDONLY : O_RDWR | O_CREAT,
+                 0644);
+    if (fd_ < 0) return fail(error, "cannot open store");
+    struct stat info;
+    if (::fstat(fd_, &info) != 0) {
+      closeLocked();
+      return fail(error, "cannot stat store");
+    }
+    inode_ = info.st_ino;
+    device_ = info.st_dev;
+    uint64_t size = static_cast<uint64_t>(info.st_size);
+    const bool fresh = size == 0 && !readOnly;
+    if (fresh) {
+      size = detail::kGrowBytes;
+      if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        closeLocked();
+        return fail(error, "cannot size store");
+      }
+    }
+    if (size < sizeof(detail::FileHeader) || !mapFile(size)) {
+      closeLocked();
+      return fail(error, "cannot map store");
+    }
+    if (fresh) {
+      std::memcpy(header()->magic, detail::kFileMagic, 8);
+      header()->generation = 0;
+      __atomic_store_n(&header()->committed, sizeof(detail::FileHeader),
+                       __ATOMIC_RELEASE);
+    }
+    const uint64_t committed = committedLength();
+    if (std::memcmp(header()->magic, detail::kFileMagic, 8) != 0 ||
+        committed < sizeof(detail::FileHeader) || committed > size) {
+      closeLocked();
+      return fail(error, "not a speech cache");
+    }
+    scan(sizeof(detail::FileHeader), committed);
+    // A damaged tail is dropped; the next append overwrites it
+    if (!readOnly && scanned_ < committed) {
+      __atomic_store_n(&header()->committed, scanned_, __ATOMIC_RELEASE);
+    }
+    return true;
+  }
+
+  void closeLocked() {
+    if (map_) ::munmap(map_, mapBytes_);
+    if (fd_ >= 0) ::close(fd_);
+    map_ = nullptr;
+    mapBytes_ = 0;
+    fd_ = -1;
+    index_.clear();
+    liveBytes_ = 0;
+    scanned_ = 0;
+  }
+
+  bool mapFile(uint64_t bytes) {
+    const int prot = options_.readOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* map = ::mmap(nullptr, bytes, prot, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) return false;
+    map_ = static_cast<uint8_t*>(map);
+    mapBytes_ = bytes;
+    return true;
+  }
+
+  /**
+   * Map at least bytes of the file, growing it first if this process
+   * writes it; callers hold the lock exclusively
+   */
+  bool remap(uint64_t bytes, std::string* error) {
+    uint64_t size = bytes;
+    if (!options_.readOnly) {
+      size = std::max(mapBytes_ * 2, (bytes + detail::kGrowBytes - 1) &
+                                         ~(detail::kGrowBytes - 1));
+      if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        return fail(error, "cannot grow store");
+      }
+    } else {
+      struct stat info;
+      if (::fstat(fd_, &info) != 0) return fail(error, "cannot stat store");
+      size = static_cast<uint64_t>(info.st_size);
+    }
+    ::munmap(map_, mapBytes_);
+    map_ = nullptr;
+    if (!mapFile(size)) {
+      closeLocked();
+      return fail(error, "cannot map store");
+    }
+    return true;
+  }
+
+  /**
+   * Index the published records in [from, to); stops at the first one
+   * that does not check out
+   */
+  void scan(uint64_t from, uint64_t to) {
+    uint64_t offset = from;
+    while (offset + sizeof(detail::RecordHeader) <= to) {
+      const auto* r = record(offset);
+      const uint64_t bytes = detail::recordBytes(r->keyBytes, r->payloadBytes);
+      const bool valid =
+          r->magic == detail::kRecordMagic &&
+          (r->kind == detail::kAudioRecord ||
+           r->kind == detail::kTimingRecord) &&
+          r->keyBytes <= kMaxKeyBytes && r->payloadBytes <= kMaxAudioBytes &&
+          offset + bytes <= to &&
+          r->checksum ==
+              detail::checksum(map_ + offset + sizeof(*r),
+                               r->keyBytes + r->payloadBytes);
+      if (!valid) break;
+      indexRecord(offset);
+      offset += bytes;
+    }
+    scanned_ = offset;
+  }
+
+  void indexRecord(uint64_t offset) {
+    const auto* r = record(offset);
+    const uint64_t bytes = detail::recordBytes(r->keyBytes, r->payloadBytes);
+    if (r->kind == detail::kAudioRecord) {
+      Slot& slot = index_[r->digest];
+      liveBytes_ -= slot.bytes;
+      slot.audio = offset;
+      slot.timing = 0;
+      slot.bytes = bytes;
+      liveBytes_ += bytes;
+      slot.lastUse.store(clock_.fetch_add(1, std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+      return;
+    }
+    auto it = index_.find(r->digest);
+    if (it == index_.end()) return;  // its audio was evicted
+    Slot& slot = it->second;
+    if (slot.timing != 0) {
+      const auto* old = record(slot.timing);
+      const uint64_t oldBytes =
+          detail::recordBytes(old->keyBytes, old->payloadBytes);
+      slot.bytes -= oldBytes;
+      liveBytes_ -= oldBytes;
+    }
+    slot.timing = offset;
+    slot.bytes += bytes;
+    liveBytes_ += bytes;
+  }
+
+  bool append(uint32_t kind, uint64_t digest, const uint8_t* key,
+              size_t keyBytes, const uint8_t* data, size_t dataBytes,
+              uint64_t& offset, std::string* error) {
+    offset = committedLength();
+    const uint64_t bytes = detail::recordBytes(keyBytes, dataBytes);
+    if (offset + bytes > mapBytes_ && !remap(offset + bytes, error)) {
+      return false;
+    }
+    detail::RecordHeader r{};
+    r.magic = detail::kRecordMagic;
+    r.kind = kind;
+    r.digest = digest;
+    r.keyBytes = static_cast<uint32_t>(keyBytes);
+    r.payloadBytes = static_cast<uint32_t>(dataBytes);
+    uint8_t* out = map_ + offset;
+    if (keyBytes) std::memcpy(out + sizeof(r), key, keyBytes);
+    std::memcpy(out + sizeof(r) + keyBytes, data, dataBytes);
+    std::memset(out + sizeof(r) + keyBytes + dataBytes, 0,
+                bytes - sizeof(r) - keyBytes - dataBytes);
+    r.checksum = detail::checksum(out + sizeof(r), keyBytes + dataBytes);
+    std::memcpy(out, &r, sizeof(r));
+    __atomic_store_n(&header()->committed, offset + bytes, __ATOMIC_RELEASE);
+    scanned_ = offset + bytes;
+    return true;
+  }
+
+  void maybeCompact() {
+    const uint64_t dead =
+        committedLength() - sizeof(detail::FileHeader) - liveBytes_;
+    const bool overBudget = liveBytes_ > options_.maxLiveBytes;
+    if (overBudget || (dead > liveBytes_ && dead > detail::kGrowBytes)) {
+      compactLocked(overBudget, nullptr);
+    }
+  }
+
+  /**
+   * Copy the kept entries, least recent first so a reopen restores the
+   * order, to path.compact and rename it over the store
+   */
+  bool compactLocked(bool evict, std::string* error) {
+    std::vector<std::pair<uint64_t, uint64_t>> order;  // lastUse, digest
+    order.reserve(index_.size());
+    for (const auto& [digest, slot] : index_) {
+      order.emplace_back(slot.lastUse.load(std::memory_order_relaxed),
+                         digest);
+    }
+    std::sort(order.begin(), order.end());
+    const uint64_t budget =
+        evict ? static_cast<uint64_t>(options_.maxLiveBytes *
+                                      options_.keepFraction)
+              : UINT64_MAX;
+    size_t first = order.size();
+    uint64_t kept = 0;
+    while (first > 0 && kept + index_[order[first - 1].second].bytes <=
+                            budget) {
+      kept += index_[order[--first].second].bytes;
+    }
+
+    const std::string temp = path_ + ".compact";
+    const int fd = ::open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return fail(error, "cannot create compacted store");
+    const uint64_t used = sizeof(detail::FileHeader) + kept;
+    const uint64_t size = (used + detail::kGrowBytes - 1) &
+                          ~(detail::kGrowBytes - 1);
+    void* map = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+      map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      ::unlink(temp.c_str());
+      return fail(error, "cannot map compacted store");
+    }
+
+    auto* out = static_cast<uint8_t*>(map);
+    auto* outHeader = reinterpret_cast<detail::FileHeader*>(out);
+    std::memset(outHeader, 0, sizeof(*outHeader));
+    std::memcpy(outHeader->magic, detail::kFileMagic, 8);
+    outHeader->generation = header()->generation + 1;
+    uint64_t at = sizeof(detail::FileHeader);
+    auto copy = [&](uint64_t& offset) {
+      if (offset == 0) return;
+      const auto* r = record(offset);
+      const uint64_t bytes = detail::recordBytes(r->keyBytes, r->payloadBytes);
+      std::memcpy(out + at, map_ + offset, bytes);
+      offset = at;
+      at += bytes;
+    };
+    std::unordered_map<uint64_t, std::pair<uint64_t, uint64_t>> moved;
+    for (size_t i = first; i < order.size(); ++i) {
+      const Slot& slot = index_[order[i].second];
+      uint64_t audio = slot.audio, timing = slot.timing;
+      copy(audio);
+      copy(timing);
+      moved.emplace(order[i].second, std::make_pair(audio, timing));
+    }
+    outHeader->committed = at;
+    const bool synced = ::msync(map, size, MS_SYNC) == 0 && ::fsync(fd) == 0;
+    if (!synced || ::rename(temp.c_str(), path_.c_str()) != 0) {
+      ::munmap(map, size);
+      ::close(fd);
+      ::unlink(temp.c_str());
+      return fail(error, "cannot replace store");
+    }
+
+    ::munmap(map_, mapBytes_);
+    ::close(fd_);
+    map_ = out;
+    mapBytes_ = size;
+    fd_ = fd;
+    struct stat info;
+    if (::fstat(fd_, &info) == 0) {
+      inode_ = info.st_ino;
+      device_ = info.st_dev;
+    }
+    evictions_ += first;
+    for (size_t i = 0; i < first; ++i) index_.erase(order[i].second);
+    for (auto& [digest, slot] : index_) {
+      const auto& offsets = moved[digest];
+      slot.audio = offsets.first;
+      slot.timing = offsets.second;
+    }
+    liveBytes_ = kept;
+    scanned_ = at;
+    ++compactions_;
+    return true;
+  }
+
+  std::string path_;
+  Options options_;
+  int fd_{-1};
+  uint8_t* map_{nullptr};
+  uint64_t mapBytes_{0};
+  ino_t inode_{0};
+  dev_t device_{0};
+  uint64_t scanned_{0};  // end of the records indexed so far
+
+  mutable std::shared_mutex mutex_;
+  std::atomic<uint32_t> writersWaiting_{0};
+  std::unordered_map<uint64_t, Slot> index_;
+  uint64_t liveBytes_{0};
+  std::atomic<uint64_t> clock_{0};
+  std::atomic<uint64_t> hits_{0}, misses_{0};
+  uint64_t evictions_{0}, compactions_{0};
+};
+
+}  // namespace speechcache
+}  // namespace avatar
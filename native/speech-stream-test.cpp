@@ -0,0 +1,350 @@
+/**
+ * speech-stream-test.cpp - Streaming MP3 framing and speech PCM checks
+ *
+ * Builds Layer III streams with known frame boundaries: an ID3v2 tag, a
+ * Xing header frame, frames of varying size (padding, VBR), and junk in
+ * the middle. Each stream is pushed in random chunk sizes, as fetch
+ * delivers them. Every audio frame must come back byte-exact and in
+ * order, the Xing frame must be skipped with its frame count read, and
+ * sync must be regained after the junk. Also checks header arithmetic,
+ * rejection of other layers and free format, and the decoded PCM
+ * playhead/lookahead bookkeeping. Ends with framing throughput.
+ *
+ * Usage: speech-stream-test [speech.mp3]
+ *   With a file, also frames it and prints what was found.
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative native/speech-stream-test.cpp \
+ *     -o build-native/speech-stream-test
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "avatar-speech-stream.h"
+#include "synthetic-speech.h"
+
+namespace {
+  using avatar::Mp3FrameHeader;
+  using avatar::SpeechStream;
+  using avatar::synthetic::detail::Rng;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.4f, got %.4f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  struct StreamSpec {
+    bool mpeg1 = true;
+    bool mono = true;
+    uint8_t rateIndex = 0;  // 44.1 kHz (MPEG-1), 22.05 kHz (MPEG-2)
+    uint32_t frames = 200;
+    bool id3 = true;
+    bool xing = true;
+    bool junk = true;
+    uint32_t seed = 1;
+  };
+
+  struct TestStream {
+    std::vector<uint8_t> bytes;
+    std::vector<std::vector<uint8_t>> frames;  // audio frames, in order
+    uint32_t sampleRate = 0;
+    uint32_t samplesPerFrame = 0;
+  };
+
+  std::vector<uint8_t> frameBytes(const StreamSpec& spec, uint8_t bitrate,
+                                  bool padding, Rng& rng, bool xing,
+                                  uint32_t xingFrames) {
+    uint8_t header[4] = {
+        0xFF, static_cast<uint8_t>(spec.mpeg1 ? 0xFB : 0xF3),
+        static_cast<uint8_t>(bitrate << 4 | spec.rateIndex << 2 |
+                             (padding ? 2 : 0)),
+        static_cast<uint8_t>(spec.mono ? 0xC4 : 0x04)};
+    Mp3FrameHeader h;
+    avatar::parseMp3Header(header, h);
+    std::vector<uint8_t> out(header, header + 4);
+    out.resize(h.bytes);
+    for (size_t i = 4; i < out.size(); ++i) {
+      out[i] = xing ? 0 : static_cast<uint8_t>(rng.next());
+    }
+    if (xing) {
+      const size_t at = 4 + (spec.mpeg1 ? (spec.mono ? 17 : 32)
+                                        : (spec.mono ? 9 : 17));
+      const uint8_t tag[12] = {'X', 'i', 'n', 'g', 0, 0, 0, 1,
+                               static_cast<uint8_t>(xingFrames >> 24),
+                               static_cast<uint8_t>(xingFrames >> 16),
+                               static_cast<uint8_t>(xingFrames >> 8),
+                               static_cast<uint8_t>(xingFrames)};
+      std::copy(tag, tag + 12, out.begin() + at);
+    }
+    return out;
+  }
+
+  TestStream makeStream(const StreamSpec& spec) {
+    TestStream out;
+    Rng rng{spec.seed * 2654435761u + 5u};
+    if (spec.id3) {
+      // 300-byte tag; syncsafe size; contents include a fake sync word
+      const uint8_t id3[10] = {'I', 'D', '3', 4, 0, 0, 0, 0, 2, 44};
+      out.bytes.assign(id3, id3 + 10);
+      for (int i = 0; i < 300; ++i) out.bytes.push_back(i % 7 ? 0xFF : 0xFB);
+    }
+    if (spec.xing) {
+      const auto xing = frameBytes(spec, 9, false, rng, true, spec.frames);
+      out.bytes.insert(out.bytes.end(), xing.begin(), xing.end());
+    }
+    for (uint32_t f = 0; f < spec.frames; ++f) {
+      const uint8_t bitrate = static_cast<uint8_t>(5 + rng.next() % 9);
+      const auto frame = frameBytes(spec, bitrate, rng.next() % 2, rng,
+                                    false, 0);
+      out.bytes.insert(out.bytes.end(), frame.begin(), frame.end());
+      out.frames.push_back(frame);
+      if (spec.junk && f == spec.frames / 2) {
+        // Junk with a false sync word whose "frame" is not followed by one
+        const uint8_t junk[] = {0x00, 0xFF, 0xFB, 0x90, 0xC4, 0x12, 0x34};
+        out.bytes.insert(out.bytes.end(), std::begin(junk), std::end(junk));
+        for (int i = 0; i < 200; ++i) {
+          out.bytes.push_back(static_cast<uint8_t>(rng.next() % 0xFF));
+        }
+      }
+    }
+    Mp3FrameHeader h;
+    avatar::parseMp3Header(out.frames[0].data(), h);
+    out.sampleRate = h.sampleRate;
+    out.samplesPerFrame = h.samples;
+    return out;
+  }
+
+  // Push in random chunks, draining frames as the decoder would
+  std::vector<std::vector<uint8_t>> frameStream(SpeechStream& stream,
+                                                const TestStream& test,
+                                                uint32_t seed,
+                                                uint32_t maxChunk) {
+    std::vector<std::vector<uint8_t>> frames;
+    Rng rng{seed * 747796405u + 1u};
+    SpeechStream::Frame frame;
+    auto drain = [&] {
+      while (stream.nextFrame(frame)) {
+        frames.emplace_back(frame.data, frame.data + frame.bytes);
+      }
+    };
+    stream.reset();
+    size_t at = 0;
+    while (at < test.bytes.size()) {
+      const size_t chunk = std::min<size_t>(test.bytes.size() - at,
+                                            1 + rng.next() % maxChunk);
+      stream.pushBytes(test.bytes.data() + at, chunk);
+      at += chunk;
+      if (rng.next() % 3) drain();  // sometimes leave frames queued
+    }
+    stream.endBytes();
+    drain();
+    return frames;
+  }
+
+  void headerTest() {
+    Mp3FrameHeader h;
+    const uint8_t v1[4] = {0xFF, 0xFB, 0x90, 0xC4};  // 128k 44.1k mono
+    expectTrue("MPEG-1 128 kbps 44.1 kHz",
+               avatar::parseMp3Header(v1, h) && h.bytes == 417 &&
+                   h.samples == 1152 && h.channels == 1 &&
+                   h.sampleRate == 44100);
+    const uint8_t padded[4] = {0xFF, 0xFB, 0x92, 0x04};
+    expectTrue("padding adds a byte, stereo",
+               avatar::parseMp3Header(padded, h) && h.bytes == 418 &&
+                   h.channels == 2);
+    const uint8_t v2[4] = {0xFF, 0xF3, 0x84, 0xC4};  // 64k 24 kHz
+    expectTrue("MPEG-2 64 kbps 24 kHz",
+               avatar::parseMp3Header(v2, h) && h.bytes == 192 &&
+                   h.samples == 576 && h.sampleRate == 24000);
+    const uint8_t v25[4] = {0xFF, 0xE3, 0x88, 0xC4};  // 64k 8 kHz
+    expectTrue("MPEG-2.5 8 kHz",
+               avatar::parseMp3Header(v25, h) && h.sampleRate == 8000 &&
+                   h.bytes == 576);
+    const uint8_t layer2[4] = {0xFF, 0xFD, 0x90, 0xC4};
+    const uint8_t freeFormat[4] = {0xFF, 0xFB, 0x00, 0xC4};
+    const uint8_t badRate[4] = {0xFF, 0xFB, 0x9C, 0xC4};
+    const uint8_t reserved[4] = {0xFF, 0xEB, 0x90, 0xC4};
+    expectTrue("other layers, free format and reserved fields rejected",
+               !avatar::parseMp3Header(layer2, h) &&
+                   !avatar::parseMp3Header(freeFormat, h) &&
+                   !avatar::parseMp3Header(badRate, h) &&
+                   !avatar::parseMp3Header(reserved, h));
+  }
+
+  void framingTest() {
+    const StreamSpec specs[] = {
+        {true, true, 0, 200, true, true, true, 1},
+        {false, false, 2, 300, true, true, true, 2},   // 16 kHz stereo
+        {false, true, 1, 150, false, false, true, 3},  // 24 kHz, bare
+        {true, false, 1, 100, true, false, false, 4},  // 48 kHz stereo
+    };
+    bool exact = true, rates = true, xingDuration = true;
+    SpeechStream stream;
+    for (const StreamSpec& spec : specs) {
+      const TestStream test = makeStream(spec);
+      for (uint32_t maxChunk : {1u, 7u, 600u, 4096u}) {
+        const auto frames = frameStream(stream, test, spec.seed, maxChunk);
+        exact &= frames == test.frames;
+        rates &= stream.sampleRate() == test.sampleRate &&
+                 stream.channels() == (spec.mono ? 1u : 2u);
+        if (spec.xing) {
+          xingDuration &=
+              std::fabs(stream.durationSeconds() -
+                        static_cast<double>(spec.frames) *
+                            test.samplesPerFrame / test.sampleRate) < 1e-9;
+        } else {
+          xingDuration &= stream.durationSeconds() == 0.0;
+        }
+      }
+    }
+    expectTrue("every audio frame recovered byte-exact, in order", exact);
+    expectTrue("format from the first frame", rates);
+    expectTrue("duration from the Xing header before decoding", xingDuration);
+
+    // A stream cut mid-frame: the partial frame is never emitted
+    StreamSpec spec;
+    const TestStream test = makeStream(spec);
+    TestStream cut = test;
+    cut.bytes.resize(cut.bytes.size() - 100);
+    cut.frames.pop_back();
+    expectTrue("truncated last frame dropped",
+               frameStream(stream, cut, 9, 500) == cut.frames);
+
+    // Without a trusted frame before it, a frame is held until the next
+    // header confirms it; after that, frames are released as they end
+    StreamSpec bare;
+    bare.id3 = bare.xing = bare.junk = false;
+    const TestStream plain = makeStream(bare);
+    const size_t first = plain.frames[0].size();
+    const size_t second = plain.frames[1].size();
+    stream.reset();
+    stream.pushBytes(plain.bytes.data(), first);
+    const bool held = stream.framesReady() == 0;
+    stream.pushBytes(plain.bytes.data() + first, 4);
+    const bool confirmed = stream.framesReady() == 1;
+    stream.pushBytes(plain.bytes.data() + first + 4, second - 4);
+    expectTrue("first frame held until the next header agrees",
+               held && confirmed);
+    expectTrue("following frames released as they complete",
+               stream.framesReady() == 2);
+  }
+
+  void pcmTest() {
+    SpeechStream stream;
+    StreamSpec spec;
+    spec.mpeg1 = false;
+    spec.rateIndex = 1;  // 24 kHz
+    spec.xing = false;
+    const TestStream test = makeStream(spec);
+    stream.pushBytes(test.bytes.data(), test.bytes.size());
+    std::vector<float> frame(test.samplesPerFrame, 0.25f);
+    for (int i = 0; i < 100; ++i) stream.pushPcm(frame.data(), frame.size());
+    const double decoded = 100.0 * 576 / 24000.0;  // 2.4 s
+
+    expectNear("duration unknown until decoded", stream.durationSeconds(),
+               0.0, 1e-12);
+    stream.setPlayhead(1.0);
+    expectNear("lookahead = decoded - played", stream.lookaheadSeconds(),
+               decoded - 1.0, 1e-9);
+    stream.setPlayhead(10.0);
+    expectTrue("played clamps to decoded",
+               stream.playedSamples() == stream.decodedSamples());
+    stream.endPcm();
+    expectNear("exact duration once complete", stream.durationSeconds(),
+               decoded, 1e-9);
+    stream.reset();
+    expectTrue("reset clears the stream",
+               !stream.active() && stream.decodedSamples() == 0 &&
+                   stream.framesReady() == 0);
+  }
+
+  void bench() {
+    StreamSpec spec;
+    spec.frames = 2000;  // ~52 s at 44.1 kHz
+    const TestStream test = makeStream(spec);
+    SpeechStream stream;
+    const int repeats = 20;
+    size_t frames = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+      stream.reset();
+      SpeechStream::Frame frame;
+      for (size_t at = 0; at < test.bytes.size(); at += 4096) {
+        stream.pushBytes(test.bytes.data() + at,
+                         std::min<size_t>(4096, test.bytes.size() - at));
+        while (stream.nextFrame(frame)) ++frames;
+      }
+      stream.endBytes();
+      while (stream.nextFrame(frame)) ++frames;
+    }
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    const double megabytes =
+        static_cast<double>(test.bytes.size()) * repeats / 1e6;
+    std::printf("     framing: %.0f MB/s, %.0f ns per frame (%zu frames)\n",
+                megabytes / seconds, seconds * 1e9 / frames, frames);
+  }
+
+  int frameFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      std::fprintf(stderr, "Cannot read %s\n", path);
+      return 1;
+    }
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                                     std::istreambuf_iterator<char>());
+    SpeechStream stream;
+    for (size_t at = 0; at < bytes.size(); at += 4096) {
+      stream.pushBytes(bytes.data() + at,
+                       std::min<size_t>(4096, bytes.size() - at));
+      SpeechStream::Frame frame;
+      while (stream.nextFrame(frame)) {
+      }
+    }
+    stream.endBytes();
+    std::printf("%s: %u frames, %u Hz, %u channel(s), %zu junk bytes, "
+                "declared %.2f s\n",
+                path, stream.framesFound(), stream.sampleRate(),
+                stream.channels(), stream.junkBytes(),
+                stream.durationSeconds());
+    return 0;
+  }
+}
+
+int main(int argc, char** argv) {
+  headerTest();
+  framingTest();
+  pcmTest();
+  bench();
+  if (argc > 1 && frameFile(argv[1]) != 0) return 1;
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d speech stream checks failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All speech stream checks passed\n");
+  return 0;
+}
@@ -0,0 +1,304 @@
+/**
+ * spring-bones-bench.cpp - Spring-bone checks, clock/governor checks, cost
+ *
+ * Hangs hair and skirt chains from a head and hips and checks the
+ * simulator: a chain at rest stays at rest, bone lengths hold while the
+ * anchor swings, the tip lags the anchor and then settles back onto the
+ * animation, the collider spheres keep particles out, and the written
+ * rotations put each joint where the particle is. Also checks the
+ * fixed-step clock (step counts, cap, frame-rate independence) and the
+ * quality governor's hysteresis. It then times simulate + apply per
+ * frame at the template's 120 Hz substep.
+ *
+ * Usage: spring-bones-bench [frames]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib native/spring-bones-bench.cpp \
+ *     -o build-native/spring-bones-bench
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "avatar-quality.h"
+#include "avatar-sim-clock.h"
+#include "avatar-spring-bones.h"
+
+namespace {
+  using avatar::BoneTransform;
+  using avatar::FlatSkeleton;
+  using avatar::SpringBones;
+  namespace simd = avatar::simd;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.4f, got %.4f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  constexpr float kStep = 1.0f / 120.0f;
+  constexpr float kSegment = 0.05f;
+
+  /**
+   * Hips -> spine -> head with `hair` chains on the head and `skirt`
+   * chains on the hips, each `length` joints hanging straight down
+   */
+  struct Rig {
+    FlatSkeleton skeleton;
+    std::vector<BoneTransform> animated;
+    std::vector<int32_t> roots;
+    int32_t hips{0}, head{2};
+  };
+
+  Rig buildRig(int hair, int skirt, int length) {
+    std::vector<int32_t> parents = {FlatSkeleton::kNoParent, 0, 1};
+    std::vector<simd::Vec4> offsets = {simd::Vec4::make(0, 1.0f, 0, 0),
+                                       simd::Vec4::make(0, 0.5f, 0, 0),
+                                       simd::Vec4::make(0, 0.2f, 0, 0)};
+    Rig rig;
+    auto addChain = [&](int32_t parent, float x, float z) {
+      rig.roots.push_back(static_cast<int32_t>(parents.size()));
+      for (int j = 0; j < length; ++j) {
+        parents.push_back(j == 0 ? parent
+                                 : static_cast<int32_t>(parents.size()) - 1);
+        offsets.push_back(j == 0 ? simd::Vec4::make(x, 0.0f, z, 0.0f)
+                                 : simd::Vec4::make(0.0f, -kSegment, 0.0f,
+                                                    0.0f));
+      }
+    };
+    for (int i = 0; i < hair; ++i) {
+      const float a = 6.2831853f * static_cast<float>(i) / hair;
+      addChain(rig.head, 0.12f * std::sin(a), 0.12f * std::cos(a) - 0.02f);
+    }
+    for (int i = 0; i < skirt; ++i) {
+      const float a = 6.2831853f * static_cast<float>(i) / skirt;
+      addChain(rig.hips, 0.18f * std::sin(a), 0.18f * std::cos(a));
+    }
+    rig.skeleton.build(parents.data(), parents.size());
+    rig.animated.resize(parents.size());
+    for (size_t i = 0; i < parents.size(); ++i) {
+      rig.animated[i].translation = offsets[i];
+    }
+    return rig;
+  }
+
+  void pose(Rig& rig, float hipsX) {
+    rig.animated[rig.hips].translation = simd::Vec4::make(hipsX, 1.0f, 0, 0);
+    BoneTransform* local = rig.skeleton.localPose();
+    for (size_t i = 0; i < rig.animated.size(); ++i) local[i] = rig.animated[i];
+    rig.skeleton.computeWorld();
+  }
+
+  void frame(Rig& rig, SpringBones& springs, float hipsX, uint32_t steps) {
+    pose(rig, hipsX);
+    springs.simulate(rig.skeleton, kStep, steps);
+    springs.apply(rig.skeleton, 1.0f);
+  }
+
+  simd::Vec4 position(const FlatSkeleton& skeleton, int32_t joint) {
+    return {skeleton.world()[joint].col[3]};
+  }
+
+  float distance(simd::Vec4 a, simd::Vec4 b) {
+    const simd::Vec4 d = a - b;
+    return std::sqrt(d.x() * d.x() + d.y() * d.y() + d.z() * d.z());
+  }
+
+  void restTest() {
+    Rig rig = buildRig(1, 0, 6);
+    SpringBones springs;
+    springs.params().gravity = 0.0f;
+    expectTrue("one chain built",
+               springs.build(rig.skeleton, rig.roots.data(), 1) == 1 &&
+                   springs.particleCount() == 5);
+    const int32_t tip = rig.roots[0] + 5;
+    pose(rig, 0.0f);
+    const simd::Vec4 animatedTip = position(rig.skeleton, tip);
+    for (int i = 0; i < 240; ++i) frame(rig, springs, 0.0f, 2);
+    expectNear("still chain stays on the animation",
+               distance(position(rig.skeleton, tip), animatedTip), 0.0, 1e-4);
+  }
+
+  void swingTest() {
+    Rig rig = buildRig(1, 0, 6);
+    SpringBones springs;
+    springs.build(rig.skeleton, rig.roots.data(), 1);
+    const int32_t root = rig.roots[0], tip = root + 5;
+    frame(rig, springs, 0.0f, 2);
+
+    // Whip the body sideways for a few frames
+    float maxLag = 0.0f, maxStretch = 0.0f;
+    for (int i = 0; i < 30; ++i) {
+      const float x = 0.3f * std::sin(static_cast<float>(i) * 0.3f);
+      frame(rig, springs, x, 2);
+      maxLag = std::max(maxLag, std::fabs(position(rig.skeleton, tip).x() -
+                                          position(rig.skeleton, root).x()));
+      for (int32_t j = root + 1; j <= tip; ++j) {
+        maxStretch = std::max(
+            maxStretch, std::fabs(distance(position(rig.skeleton, j),
+                                           position(rig.skeleton, j - 1)) -
+                                  kSegment));
+      }
+    }
+    expectTrue("tip lags the anchor", maxLag > 0.02f);
+    expectNear("bone lengths hold", maxStretch, 0.0, 1e-4);
+
+    float particle[3]{};
+    springs.particlePosition(tip, particle);
+    const simd::Vec4 written = position(rig.skeleton, tip);
+    expectNear("written pose reaches the particle",
+               distance(written, simd::Vec4::make(particle[0], particle[1],
+                                                  particle[2], 1.0f)),
+               0.0, 1e-4);
+
+    // Stop: the chain settles back to hanging under the anchor
+    for (int i = 0; i < 600; ++i) frame(rig, springs, 0.0f, 2);
+    expectNear("settles under the anchor",
+               position(rig.skeleton, tip).x() -
+                   position(rig.skeleton, root).x(),
+               0.0, 2e-3);
+  }
+
+  void colliderTest() {
+    // A chain from the crown whose animated pose hangs through the head
+    Rig rig = buildRig(1, 0, 6);
+    rig.animated[rig.roots[0]].translation =
+        simd::Vec4::make(0.0f, 0.12f, 0.03f, 0.0f);
+    SpringBones springs;
+    springs.params().gravity = 0.0f;
+    springs.build(rig.skeleton, rig.roots.data(), 1);
+    springs.addCollider(rig.head, 0.0f, 0.0f, 0.0f, 0.1f);
+    for (int i = 0; i < 240; ++i) frame(rig, springs, 0.0f, 2);
+    float inside = 0.0f;
+    const simd::Vec4 head = position(rig.skeleton, rig.head);
+    for (int j = 1; j < 6; ++j) {
+      float p[3]{};
+      springs.particlePosition(rig.roots[0] + j, p);
+      const float d =
+          distance(simd::Vec4::make(p[0], p[1], p[2], 1.0f), head);
+      inside = std::max(inside, 0.1f + springs.params().radius - d);
+    }
+    // The final length projection may dip slightly back in
+    expectTrue("particles stay outside the collider (1 mm)", inside < 1e-3f);
+  }
+
+  void clockTest() {
+    avatar::SimClock clock(kStep, 4);
+    expectTrue("60 Hz frame = 2 steps", clock.advance(1.0f / 60.0f) == 2);
+    uint32_t steps = 0;
+    for (int i = 0; i < 144; ++i) steps += clock.advance(1.0f / 144.0f);
+    expectNear("144 Hz: 120 steps per second", steps, 120.0, 1.0);
+    expectTrue("stall capped", clock.advance(1.0f) == 4 &&
+                                   clock.droppedSteps() > 100 &&
+                                   clock.alpha() < 1.0f);
+
+    // Same simulated time, different frame rates: same result
+    Rig a = buildRig(1, 0, 6), b = buildRig(1, 0, 6);
+    SpringBones sa, sb;
+    sa.build(a.skeleton, a.roots.data(), 1);
+    sb.build(b.skeleton, b.roots.data(), 1);
+    avatar::SimClock ca(kStep, 8), cb(kStep, 8);
+    frame(a, sa, 0.2f, 0);
+    frame(b, sb, 0.2f, 0);
+    for (int i = 0; i < 30; ++i) frame(a, sa, 0.2f, ca.advance(1.0f / 30.0f));
+    for (int i = 0; i < 60; ++i) frame(b, sb, 0.2f, cb.advance(1.0f / 60.0f));
+    expectNear("frame-rate independent",
+               distance(position(a.skeleton, a.roots[0] + 5),
+                        position(b.skeleton, b.roots[0] + 5)),
+               0.0, 1e-4);
+  }
+
+  void governorTest() {
+    avatar::QualityGovernor governor;
+    bool dropped = false;
+    for (int i = 0; i < 29; ++i) dropped |= governor.update(20.0f);
+    expectTrue("short spike tolerated",
+               !dropped && governor.level() == avatar::kQualityHigh);
+    for (int i = 0; i < 5; ++i) governor.update(20.0f);
+    expectTrue("sustained overrun lowers quality",
+               governor.level() == avatar::kQualityMedium);
+    for (int i = 0; i < 100; ++i) governor.update(10.0f);
+    expectTrue("no flapping inside the band",
+               governor.level() == avatar::kQualityMedium &&
+                   governor.raises() == 0);
+    for (int i = 0; i < 400; ++i) governor.update(3.0f);
+    expectTrue("headroom raises quality",
+               governor.level() == avatar::kQualityHigh &&
+                   governor.raises() == 1);
+  }
+
+  void timing(int frames) {
+    std::printf("backend: %s\n", simd::backendName());
+    std::printf("%7s %9s %10s %10s %8s\n", "chains", "particles",
+                "sim ns", "apply ns", "ns/p/st");
+    for (const int hair : {4, 16, 32}) {
+      Rig rig = buildRig(hair, 8, 6);
+      SpringBones springs;
+      springs.build(rig.skeleton, rig.roots.data(),
+                    static_cast<uint32_t>(rig.roots.size()));
+      springs.addCollider(rig.head, 0.0f, 0.09f, 0.01f, 0.1f);
+      springs.addCollider(1, -0.18f, 0.4f, 0.0f, 0.06f);
+      springs.addCollider(1, 0.18f, 0.4f, 0.0f, 0.06f);
+      frame(rig, springs, 0.0f, 0);
+
+      double simNs = 0.0, applyNs = 0.0;
+      float sink = 0.0f;
+      for (int i = 0; i < frames; ++i) {
+        pose(rig, 0.1f * std::sin(static_cast<float>(i) * 0.05f));
+        const double start = nowNs();
+        springs.simulate(rig.skeleton, kStep, 2);
+        const double mid = nowNs();
+        springs.apply(rig.skeleton, 1.0f);
+        applyNs += nowNs() - mid;
+        simNs += mid - start;
+        sink += position(rig.skeleton, rig.roots[0] + 5).x();
+      }
+      std::printf("%7u %9u %10.0f %10.0f %8.2f%s\n", springs.chainCount(),
+                  springs.particleCount(), simNs / frames, applyNs / frames,
+                  simNs / frames / springs.particleCount() / 2.0,
+                  sink == 12345.0f ? "*" : "");
+    }
+  }
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int frames = argc > 1 ? std::atoi(argv[1]) : 20000;
+  restTest();
+  swingTest();
+  colliderTest();
+  clockTest();
+  governorTest();
+  if (g_failures) {
+    std::fprintf(stderr, "%d spring-bone check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All spring-bone checks passed\n");
+  timing(frames);
+  return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * synthetic-avatar-gen.cpp - Write parameterised avatar GLBs to disk
+ *
+ * Command-line front end for synthetic-avatar.h, for feeding the browser
+ * build or external tools the same models the native benchmarks use.
+ * Prints the exact work counts of the generated model as one CSV row.
+ *
+ * Usage:
+ *   synthetic-avatar-gen [--vertices N] [--bones N] [--depth N]
+ *     [--morphs N] [--morph-density F] [--clip-seconds F] [--fps F]
+ *     [--texture-size N] [--textures N] -o out.glb
+ *
+ * Build command (no engine dependency):
+ *   g++ -std=c++17 -O2 -Inative native/synthetic-avatar-gen.cpp \
+ *     -o build-native/synthetic-avatar-gen
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "synthetic-avatar.h"
+
+namespace {
+  void usage() {
+    std::fprintf(stderr,
+                 "usage: synthetic-avatar-gen [--vertices N] [--bones N] "
+                 "[--depth N] [--morphs N]\n"
+                 "         [--morph-density F] [--clip-seconds F] [--fps F] "
+                 "[--texture-size N]\n"
+                 "         [--textures N] -o out.glb\n");
+  }
+}
+
+int main(int argc, char** argv) {
+  avatar::synthetic::AvatarSpec spec;
+  std::string output;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    auto takeUint = [&](uint32_t& out) {
+      if (!value) return false;
+      out = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+      ++i;
+      return true;
+    };
+    auto takeFloat = [&](float& out) {
+      if (!value) return false;
+      out = std::strtof(value, nullptr);
+      ++i;
+      return true;
+    };
+
+    bool ok = true;
+    if (!std::strcmp(arg, "--vertices")) {
+      ok = takeUint(spec.vertexCount);
+    } else if (!std::strcmp(arg, "--bones")) {
+      ok = takeUint(spec.boneCount);
+    } else if (!std::strcmp(arg, "--depth")) {
+      ok = takeUint(spec.hierarchyDepth);
+    } else if (!std::strcmp(arg, "--morphs")) {
+      ok = takeUint(spec.morphCount);
+    } else if (!std::strcmp(arg, "--morph-density")) {
+      ok = takeFloat(spec.morphDensity);
+    } else if (!std::strcmp(arg, "--clip-seconds")) {
+      ok = takeFloat(spec.clipSeconds);
+    } else if (!std::strcmp(arg, "--fps")) {
+      ok = takeFloat(spec.clipFps);
+    } else if (!std::strcmp(arg, "--texture-size")) {
+      ok = takeUint(spec.textureSize);
+    } else if (!std::strcmp(arg, "--textures")) {
+      ok = takeUint(spec.textureCount);
+    } else if (!std::strcmp(arg, "-o") && value) {
+      output = value;
+      ++i;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      usage();
+      return 2;
+    }
+  }
+  if (output.empty()) {
+    usage();
+    return 2;
+  }
+
+  avatar::synthetic::SyntheticStats stats;
+  const std::vector<uint8_t> glb =
+      avatar::synthetic::buildSyntheticAvatar(spec, &stats);
+
+  std::FILE* f = std::fopen(output.c_str(), "wb");
+  if (!f || std::fwrite(glb.data(), 1, glb.size(), f) != glb.size()) {
+    std::fprintf(stderr, "Failed to write %s\n", output.c_str());
+    if (f) std::fclose(f);
+    return 1;
+  }
+  std::fclose(f);
+
+  std::printf("vertices,triangles,bones,depth,morphs,morph_deltas,keyframes,"
+              "channels,texture_bytes,glb_bytes\n");
+  std::printf("%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", stats.vertexCount,
+              stats.triangleCount, stats.boneCount, stats.hierarchyDepth,
+              stats.morphCount, stats.morphDeltas, stats.keyframes,
+              stats.channels, stats.textureBytes, stats.glbBytes);
+  return 0;
+}
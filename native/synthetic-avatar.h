@@ -0,0 +1,407 @@
+/**
+ * synthetic-avatar.h - Parameterised skinned avatar GLBs for scaling runs
+ *
+ * Generates valid GLBs whose cost drivers can be dialled independently:
+ * vertex count, bone count, hierarchy depth, morph target count and
+ * density (fraction of vertices each target moves), animation clip length
+ * and embedded texture sizes. Output is deterministic for a given spec, so
+ * loader, animation and skinning benchmarks can sweep one parameter and
+ * plot a cost curve against the exact work counts in SyntheticStats.
+ *
+ * Geometry is a cylinder-like grid: rows run up the skeleton's branches,
+ * columns pick the branch, and each vertex blends the two nearest bones on
+ * its branch. The first four morph targets carry the lip-sync names so the
+ * engine's morph lookups resolve exactly as for a production avatar.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "glb-writer.h"
+#include "png-writer.h"
+
+namespace avatar {
+namespace synthetic {
+
+struct AvatarSpec {
+  uint32_t vertexCount = 4096;  // rounded up to a full grid
+  uint32_t boneCount = 54;
+  uint32_t hierarchyDepth = 8;  // longest root-to-leaf chain, in bones
+  uint32_t morphCount = 52;
+  float morphDensity = 0.1f;    // fraction of vertices each target moves
+  float clipSeconds = 4.0f;     // 0 = no animation
+  float clipFps = 30.0f;
+  uint32_t textureSize = 1024;  // square, 0 = untextured
+  uint32_t textureCount = 1;    // base colour, normal, metallic-roughness
+};
+
+struct SyntheticStats {
+  uint32_t vertexCount = 0;
+  uint32_t triangleCount = 0;
+  uint32_t boneCount = 0;
+  uint32_t hierarchyDepth = 0;
+  uint32_t morphCount = 0;
+  uint32_t morphDeltas = 0;  // non-zero vertex deltas over all targets
+  uint32_t keyframes = 0;    // per channel
+  uint32_t channels = 0;
+  uint32_t textureBytes = 0; // decoded RGBA8 bytes
+  uint32_t glbBytes = 0;
+};
+
+/**
+ * Parent index per bone, parent-before-child; bone 0 is the root
+ * Bones hang off the root in chains of (depth - 1), giving the requested
+ * longest chain; the last chain may be shorter.
+ */
+inline std::vector<int> boneParents(uint32_t boneCount, uint32_t depth) {
+  std::vector<int> parents(boneCount, -1);
+  const uint32_t chain = depth > 1 ? depth - 1 : 1;
+  for (uint32_t i = 1; i < boneCount; ++i) {
+    const uint32_t level = (i - 1) % chain;
+    parents[i] = level == 0 ? 0 : static_cast<int>(i - 1);
+  }
+  return parents;
+}
+
+inline std::vector<uint8_t> buildSyntheticAvatar(const AvatarSpec& spec,
+                                                 SyntheticStats* statsOut =
+                                                     nullptr) {
+  glb::GlbWriter writer;
+  SyntheticStats stats;
+
+  // Skeleton -----------------------------------------------------------------
+  // JOINTS_0 is unsigned short
+  const uint32_t boneCount =
+      std::min<uint32_t>(65535, std::max<uint32_t>(1, spec.boneCount));
+  const uint32_t depth =
+      boneCount > 1
+          ? std::min(std::max<uint32_t>(2, spec.hierarchyDepth), boneCount)
+          : 1;
+  const uint32_t chain = depth > 1 ? depth - 1 : 1;
+  const uint32_t branches =
+      boneCount > 1 ? (boneCount - 1 + chain - 1) / chain : 1;
+  const std::vector<int> parents = boneParents(boneCount, depth);
+  const float height = 1.7f;
+  const float segment = height / static_cast<float>(chain + 1);
+
+  // World-space bone heads: branches fan out around the root
+  std::vector<float> world(boneCount * 3, 0.0f);
+  for (uint32_t i = 1; i < boneCount; ++i) {
+    const uint32_t branch = (i - 1) / chain;
+    const uint32_t level = (i - 1) % chain + 1;
+    const float angle = 6.2831853f * branch / static_cast<float>(branches);
+    const float radius = 0.02f * static_cast<float>(level);
+    world[i * 3 + 0] = radius * std::cos(angle);
+    world[i * 3 + 1] = segment * static_cast<float>(level);
+    world[i * 3 + 2] = radius * std::sin(angle);
+  }
+
+  // Geometry -----------------------------------------------------------------
+  const uint32_t columns = std::max<uint32_t>(
+      2, static_cast<uint32_t>(std::sqrt(static_cast<double>(
+             std::max<uint32_t>(4, spec.vertexCount)))));
+  const uint32_t rows =
+      std::max<uint32_t>(2, (spec.vertexCount + columns - 1) / columns);
+  const uint32_t vertexCount = rows * columns;
+
+  std::vector<float> positions(vertexCount * 3);
+  std::vector<float> normals(vertexCount * 3);
+  std::vector<float> uvs(vertexCount * 2);
+  std::vector<uint16_t> joints(vertexCount * 4, 0);
+  std::vector<float> weights(vertexCount * 4, 0.0f);
+  float minPos[3] = {1e30f, 1e30f, 1e30f};
+  float maxPos[3] = {-1e30f, -1e30f, -1e30f};
+
+  for (uint32_t r = 0; r < rows; ++r) {
+    const float t = static_cast<float>(r) / static_cast<float>(rows - 1);
+    for (uint32_t c = 0; c < columns; ++c) {
+      const uint32_t v = r * columns + c;
+      const float angle = 6.2831853f * c / static_cast<float>(columns);
+      const float x = 0.2f * std::cos(angle);
+      const float z = 0.2f * std::sin(angle);
+      const float y = t * height;
+      positions[v * 3 + 0] = x;
+      positions[v * 3 + 1] = y;
+      positions[v * 3 + 2] = z;
+      normals[v * 3 + 0] = std::cos(angle);
+      normals[v * 3 + 1] = 0.0f;
+      normals[v * 3 + 2] = std::sin(angle);
+      uvs[v * 2 + 0] = static_cast<float>(c) / static_cast<float>(columns);
+      uvs[v * 2 + 1] = 1.0f - t;
+      for (int k = 0; k < 3; ++k) {
+        minPos[k] = std::min(minPos[k], positions[v * 3 + k]);
+        maxPos[k] = std::max(maxPos[k], positions[v * 3 + k]);
+      }
+
+      // Blend the two bones bracketing this height on the column's branch
+      if (boneCount == 1) {
+        weights[v * 4] = 1.0f;
+        continue;
+      }
+      const uint32_t branch = c % branches;
+      const float level = t * static_cast<float>(chain);
+      const uint32_t lower = static_cast<uint32_t>(level);
+      const float blend = level - static_cast<float>(lower);
+      auto boneAt = [&](uint32_t lvl) -> uint32_t {
+        if (lvl == 0) return 0;
+        const uint32_t bone = 1 + branch * chain + (lvl - 1);
+        return std::min(bone, boneCount - 1);
+      };
+      const uint32_t a = boneAt(std::min(lower, chain));
+      const uint32_t b = boneAt(std::min(lower + 1, chain));
+      joints[v * 4 + 0] = static_cast<uint16_t>(a);
+      joints[v * 4 + 1] = static_cast<uint16_t>(b);
+      weights[v * 4 + 0] = a == b ? 1.0f : 1.0f - blend;
+      weights[v * 4 + 1] = a == b ? 0.0f : blend;
+    }
+  }
+
+  std::vector<uint32_t> indices;
+  indices.reserve((rows - 1) * columns * 6);
+  for (uint32_t r = 0; r + 1 < rows; ++r) {
+    for (uint32_t c = 0; c < columns; ++c) {
+      const uint32_t c1 = (c + 1) % columns;
+      const uint32_t i0 = r * columns + c, i1 = r * columns + c1;
+      const uint32_t i2 = (r + 1) * columns + c1, i3 = (r + 1) * columns + c;
+      indices.insert(indices.end(), {i0, i1, i2, i0, i2, i3});
+    }
+  }
+
+  std::ostringstream bounds;
+  bounds << "\"min\":" << glb::GlbWriter::floatArray(minPos, 3)
+         << ",\"max\":" << glb::GlbWriter::floatArray(maxPos, 3);
+  const int position =
+      writer.addAccessor(positions, glb::kFloat, vertexCount, "VEC3",
+                         glb::kArrayBuffer, bounds.str());
+  const int normal = writer.addAccessor(normals, glb::kFloat, vertexCount,
+                                        "VEC3", glb::kArrayBuffer);
+  const int texcoord = writer.addAccessor(uvs, glb::kFloat, vertexCount,
+                                          "VEC2", glb::kArrayBuffer);
+  const int joint = writer.addAccessor(joints, glb::kUnsignedShort,
+                                       vertexCount, "VEC4",
+                                       glb::kArrayBuffer);
+  const int weight = writer.addAccessor(weights, glb::kFloat, vertexCount,
+                                        "VEC4", glb::kArrayBuffer);
+  const int index = writer.addAccessor(indices, glb::kUnsignedInt,
+                                       indices.size(), "SCALAR",
+                                       glb::kElementArrayBuffer);
+
+  // Morph targets: sparse windows of vertices, spread over the mesh ----------
+  const float density = std::min(1.0f, std::max(0.0f, spec.morphDensity));
+  const uint32_t touched = std::max<uint32_t>(
+      1, static_cast<uint32_t>(std::lround(density * vertexCount)));
+  std::vector<int> targets;
+  for (uint32_t m = 0; m < spec.morphCount; ++m) {
+    const uint32_t start =
+        static_cast<uint32_t>((static_cast<uint64_t>(m) * vertexCount) /
+                              std::max<uint32_t>(1, spec.morphCount));
+    std::vector<uint32_t> sparseIndices;
+    sparseIndices.reserve(touched);
+    for (uint32_t i = 0; i < touched; ++i) {
+      sparseIndices.push_back((start + i) % vertexCount);
+    }
+    std::sort(sparseIndices.begin(), sparseIndices.end());
+
+    // Push vertices outward along their normal, scaled per target
+    const float amount = 0.005f + 0.0005f * static_cast<float>(m % 16);
+    std::vector<float> values(touched * 3);
+    float lo[3] = {0, 0, 0}, hi[3] = {0, 0, 0};
+    for (uint32_t i = 0; i < touched; ++i) {
+      for (int k = 0; k < 3; ++k) {
+        const float d = normals[sparseIndices[i] * 3 + k] * amount;
+        values[i * 3 + k] = d;
+        lo[k] = std::min(lo[k], d);
+        hi[k] = std::max(hi[k], d);
+      }
+    }
+    std::ostringstream targetBounds;
+    targetBounds << "\"min\":" << glb::GlbWriter::floatArray(lo, 3)
+                 << ",\"max\":" << glb::GlbWriter::floatArray(hi, 3);
+    targets.push_back(writer.addSparseAccessor(
+        vertexCount, "VEC3", sparseIndices, values, targetBounds.str()));
+    stats.morphDeltas += touched;
+  }
+
+  // Textures -------------------------------------------------------------------
+  const uint32_t textureCount =
+      spec.textureSize ? std::min<uint32_t>(spec.textureCount, 3) : 0;
+  for (uint32_t t = 0; t < textureCount; ++t) {
+    const uint32_t size = spec.textureSize;
+    std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+    for (uint32_t y = 0; y < size; ++y) {
+      for (uint32_t x = 0; x < size; ++x) {
+        uint8_t* p = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+        const bool checker = ((x / 32) + (y / 32)) % 2 == 0;
+        if (t == 1) {  // flat tangent-space normal
+          p[0] = 128, p[1] = 128, p[2] = 255;
+        } else {
+          p[0] = checker ? 200 : 90;
+          p[1] = static_cast<uint8_t>(x * 255 / size);
+          p[2] = static_cast<uint8_t>(y * 255 / size);
+        }
+        p[3] = 255;
+      }
+    }
+    const std::vector<uint8_t> png = png::encodeRgba(
+        static_cast<int>(size), static_cast<int>(size), pixels.data());
+    const int view = writer.addBufferView(png.data(), png.size());
+    std::ostringstream image;
+    image << "{\"bufferView\":" << view << ",\"mimeType\":\"image/png\"}";
+    writer.addImage(image.str());
+    std::ostringstream texture;
+    texture << "{\"source\":" << t << "}";
+    writer.addTexture(texture.str());
+    stats.textureBytes += size * size * 4;
+  }
+
+  std::ostringstream material;
+  material << "{\"name\":\"SyntheticSkin\",\"pbrMetallicRoughness\":{";
+  if (textureCount > 0) material << "\"baseColorTexture\":{\"index\":0},";
+  if (textureCount > 2) {
+    material << "\"metallicRoughnessTexture\":{\"index\":2},";
+  }
+  material << "\"metallicFactor\":0,\"roughnessFactor\":0.8}";
+  if (textureCount > 1) material << ",\"normalTexture\":{\"index\":1}";
+  material << "}";
+  writer.addMaterial(material.str());
+
+  // Mesh -----------------------------------------------------------------------
+  static const char* const kLipSyncNames[4] = {"mouthOpen", "mouthRound",
+                                               "eyesLookUp", "eyesClose"};
+  std::ostringstream mesh;
+  mesh << "{\"name\":\"AvatarMesh\",\"primitives\":[{\"attributes\":{"
+       << "\"POSITION\":" << position << ",\"NORMAL\":" << normal
+       << ",\"TEXCOORD_0\":" << texcoord << ",\"JOINTS_0\":" << joint
+       << ",\"WEIGHTS_0\":" << weight << "},\"indices\":" << index
+       << ",\"material\":0";
+  if (!targets.empty()) {
+    mesh << ",\"targets\":[";
+    for (size_t m = 0; m < targets.size(); ++m) {
+      if (m) mesh << ",";
+      mesh << "{\"POSITION\":" << targets[m] << "}";
+    }
+    mesh << "]";
+  }
+  mesh << "}]";
+  if (!targets.empty()) {
+    mesh << ",\"weights\":[";
+    for (size_t m = 0; m < targets.size(); ++m) mesh << (m ? ",0" : "0");
+    mesh << "],\"extras\":{\"targetNames\":[";
+    for (size_t m = 0; m < targets.size(); ++m) {
+      if (m) mesh << ",";
+      if (m < 4) {
+        mesh << "\"" << kLipSyncNames[m] << "\"";
+      } else {
+        mesh << "\"morph" << m << "\"";
+      }
+    }
+    mesh << "]}";
+  }
+  mesh << "}";
+  writer.addMesh(mesh.str());
+
+  // Nodes: 0 = Armature, 1..boneCount = bones, boneCount + 1 = mesh ---------
+  std::vector<std::vector<int>> children(boneCount);
+  for (uint32_t i = 1; i < boneCount; ++i) {
+    children[parents[i]].push_back(static_cast<int>(i) + 1);
+  }
+  const int meshNode = static_cast<int>(boneCount) + 1;
+  writer.addNode("{\"name\":\"Armature\",\"children\":" +
+                 glb::GlbWriter::intArray({1, meshNode}) + "}");
+  for (uint32_t i = 0; i < boneCount; ++i) {
+    float local[3];
+    for (int k = 0; k < 3; ++k) {
+      local[k] = world[i * 3 + k] -
+                 (parents[i] >= 0 ? world[parents[i] * 3 + k] : 0.0f);
+    }
+    std::ostringstream node;
+    node << "{\"name\":\"Bone" << i << "\",\"translation\":"
+         << glb::GlbWriter::floatArray(local, 3);
+    if (!children[i].empty()) {
+      node << ",\"children\":" << glb::GlbWriter::intArray(children[i]);
+    }
+    node << "}";
+    writer.addNode(node.str());
+  }
+  writer.addNode("{\"name\":\"AvatarMesh\",\"mesh\":0,\"skin\":0}");
+
+  // Column-major inverse bind matrices: bones are translation-only
+  std::vector<float> inverseBind(boneCount * 16, 0.0f);
+  std::vector<int> jointNodes(boneCount);
+  for (uint32_t i = 0; i < boneCount; ++i) {
+    float* m = &inverseBind[i * 16];
+    m[0] = m[5] = m[10] = m[15] = 1.0f;
+    m[12] = -world[i * 3 + 0];
+    m[13] = -world[i * 3 + 1];
+    m[14] = -world[i * 3 + 2];
+    jointNodes[i] = static_cast<int>(i) + 1;
+  }
+  const int ibm =
+      writer.addAccessor(inverseBind, glb::kFloat, boneCount, "MAT4");
+  std::ostringstream skin;
+  skin << "{\"inverseBindMatrices\":" << ibm
+       << ",\"joints\":" << glb::GlbWriter::intArray(jointNodes)
+       << ",\"skeleton\":1}";
+  writer.addSkin(skin.str());
+
+  // Animation: one rotation channel per bone, a slow sway ----------------------
+  if (spec.clipSeconds > 0.0f && spec.clipFps > 0.0f) {
+    const uint32_t keys = std::max<uint32_t>(
+        2, static_cast<uint32_t>(std::ceil(spec.clipSeconds * spec.clipFps)) +
+               1);
+    std::vector<float> times(keys);
+    for (uint32_t k = 0; k < keys; ++k) {
+      times[k] = spec.clipSeconds * k / static_cast<float>(keys - 1);
+    }
+    std::ostringstream timeBounds;
+    timeBounds << "\"min\":[0],\"max\":[" << spec.clipSeconds << "]";
+    const int input = writer.addAccessor(times, glb::kFloat, keys, "SCALAR",
+                                         0, timeBounds.str());
+
+    std::ostringstream samplers, channels;
+    for (uint32_t i = 0; i < boneCount; ++i) {
+      std::vector<float> rotations(keys * 4);
+      const float phase = 0.37f * static_cast<float>(i);
+      for (uint32_t k = 0; k < keys; ++k) {
+        const float angle =
+            0.1f * std::sin(6.2831853f * times[k] / spec.clipSeconds + phase);
+        rotations[k * 4 + 0] = 0.0f;
+        rotations[k * 4 + 1] = 0.0f;
+        rotations[k * 4 + 2] = std::sin(angle * 0.5f);
+        rotations[k * 4 + 3] = std::cos(angle * 0.5f);
+      }
+      const int output =
+          writer.addAccessor(rotations, glb::kFloat, keys, "VEC4");
+      if (i) samplers << ",", channels << ",";
+      samplers << "{\"input\":" << input << ",\"output\":" << output
+               << ",\"interpolation\":\"LINEAR\"}";
+      channels << "{\"sampler\":" << i << ",\"target\":{\"node\":" << i + 1
+               << ",\"path\":\"rotation\"}}";
+    }
+    writer.addAnimation("{\"name\":\"idle\",\"samplers\":[" + samplers.str() +
+                        "],\"channels\":[" + channels.str() + "]}");
+    stats.keyframes = keys;
+    stats.channels = boneCount;
+  }
+
+  writer.setSceneRoots({0});
+  std::vector<uint8_t> out = writer.finish();
+
+  stats.vertexCount = vertexCount;
+  stats.triangleCount = static_cast<uint32_t>(indices.size() / 3);
+  stats.boneCount = boneCount;
+  stats.hierarchyDepth = depth;
+  stats.morphCount = spec.morphCount;
+  stats.glbBytes = static_cast<uint32_t>(out.size());
+  if (statsOut) *statsOut = stats;
+  return out;
+}
+
+}  // namespace synthetic
+}  // namespace avatar
@@ -0,0 +1,166 @@
+/**
+ * synthetic-speech.h - Speech-like test signal with known pitch and accents
+ *
+ * Generates phrases of syllables: a short noise burst (unvoiced consonant)
+ * then a voiced vowel. The vowel is a glottal pulse train at a known f0
+ * through two formant resonators. Pitch falls across each phrase
+ * (declination), and every few syllables an accent raises it by a few
+ * semitones mid-vowel. The exact f0 per sample and the accent onsets are
+ * returned with the audio, so pitch and prosody trackers can be scored
+ * without hand-labelled recordings. Output is deterministic for a spec.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace avatar {
+namespace synthetic {
+
+struct SpeechSpec {
+  uint32_t sampleRate = 48000;
+  float seconds = 10.0f;
+  float baseHz = 120.0f;          // speaker's mean f0
+  float declination = 3.0f;       // semitones lost across a phrase
+  float accentSemitones = 4.0f;   // peak rise of an accented vowel
+  uint32_t accentEvery = 4;       // one accent per this many syllables
+  uint32_t seed = 1;
+};
+
+struct SyntheticSpeech {
+  uint32_t sampleRate = 0;
+  std::vector<float> samples;       // mono, peak 0.5
+  std::vector<float> f0;            // Hz per sample, 0 = unvoiced
+  std::vector<float> accentOnsets;  // seconds, start of each accented vowel
+};
+
+namespace detail {
+
+struct Rng {
+  uint32_t state;
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+  float uniform(float lo, float hi) {
+    return lo + (hi - lo) * static_cast<float>(next() >> 8) / 16777216.0f;
+  }
+};
+
+// Two-pole resonator with unit gain near its centre frequency
+struct Resonator {
+  float a1 = 0.0f, a2 = 0.0f, gain = 0.0f, y1 = 0.0f, y2 = 0.0f;
+
+  void tune(float hz, float bandwidth, float sampleRate) {
+    const float kPi = 3.14159265f;
+    const float r = std::exp(-kPi * bandwidth / sampleRate);
+    a1 = 2.0f * r * std::cos(2.0f * kPi * hz / sampleRate);
+    a2 = -r * r;
+    gain = 1.0f - r;
+  }
+
+  float process(float x) {
+    const float y = gain * x + a1 * y1 + a2 * y2;
+    y2 = y1;
+    y1 = y;
+    return y;
+  }
+};
+
+// Rosenberg glottal pulse over one period, phase in [0, 1)
+inline float glottalPulse(float phase) {
+  const float kPi = 3.14159265f;
+  if (phase < 0.4f) return 0.5f * (1.0f - std::cos(kPi * phase / 0.4f));
+  if (phase < 0.56f) return std::cos(kPi * (phase - 0.4f) / 0.32f);
+  return 0.0f;
+}
+
+}  // namespace detail
+
+inline SyntheticSpeech generateSpeech(const SpeechSpec& spec) {
+  const float kVowels[5][2] = {
+      {700, 1200}, {500, 1800}, {300, 2200}, {600, 1000}, {400, 900}};
+  const float rate = static_cast<float>(spec.sampleRate);
+  const size_t total = static_cast<size_t>(spec.seconds * rate);
+
+  SyntheticSpeech out;
+  out.sampleRate = spec.sampleRate;
+  out.samples.assign(total, 0.0f);
+  out.f0.assign(total, 0.0f);
+
+  detail::Rng rng{spec.seed * 2654435761u + 1u};
+  detail::Resonator f1, f2;
+  float phase = 0.0f, previousPulse = 0.0f, noiseState = 0.0f;
+  uint32_t syllable = 0;
+  float t = 0.2f;  // lead-in silence
+  while (t < spec.seconds - 0.6f) {
+    const uint32_t syllables = 5 + rng.next() % 5;
+    for (uint32_t s = 0; s < syllables && t < spec.seconds - 0.4f; ++s) {
+      const float consonant = rng.uniform(0.03f, 0.05f);
+      const float vowel = rng.uniform(0.13f, 0.22f);
+      const bool accent = syllable++ % spec.accentEvery == spec.accentEvery / 2;
+      const float progress =
+          static_cast<float>(s) / static_cast<float>(syllables);
+      const float semitones =
+          -spec.declination * progress + rng.uniform(-0.5f, 0.5f);
+      const float* formants = kVowels[rng.next() % 5];
+      f1.tune(formants[0], 80.0f, rate);
+      f2.tune(formants[1], 120.0f, rate);
+
+      const size_t consonantStart = static_cast<size_t>(t * rate);
+      const size_t vowelStart = static_cast<size_t>((t + consonant) * rate);
+      const size_t vowelEnd =
+          std::min(total, static_cast<size_t>((t + consonant + vowel) * rate));
+      if (accent) out.accentOnsets.push_back(t + consonant);
+
+      // Consonant: high-passed noise burst
+      for (size_t i = consonantStart; i < vowelStart; ++i) {
+        const float noise = rng.uniform(-1.0f, 1.0f);
+        out.samples[i] = 0.08f * (noise - noiseState);
+        noiseState = noise;
+      }
+
+      // Vowel: differentiated glottal pulses through F1 and F2
+      const float length = static_cast<float>(vowelEnd - vowelStart);
+      const float peak = accent ? 1.6f : 1.0f;
+      for (size_t i = vowelStart; i < vowelEnd; ++i) {
+        const float u = static_cast<float>(i - vowelStart) / length;
+        // Accent: raised-cosine rise peaking 60% into the vowel
+        const float lift =
+            accent ? 0.5f * (1.0f - std::cos(6.2831853f *
+                                              std::min(u / 1.2f, 0.5f)))
+                   : 0.0f;
+        const float hz = spec.baseHz *
+                         std::exp2((semitones + spec.accentSemitones * lift) /
+                                   12.0f);
+        phase += hz / rate;
+        if (phase >= 1.0f) phase -= 1.0f;
+        const float pulse = detail::glottalPulse(phase);
+        const float source = pulse - previousPulse;
+        previousPulse = pulse;
+
+        const float envelope =
+            std::min({1.0f, u * length / (0.02f * rate),
+                      (1.0f - u) * length / (0.03f * rate)});
+        out.samples[i] =
+            peak * envelope * (f1.process(source) + 0.5f * f2.process(source));
+        out.f0[i] = hz;
+      }
+      t += consonant + vowel + rng.uniform(0.0f, 0.04f);
+    }
+    t += rng.uniform(0.35f, 0.6f);  // phrase pause
+  }
+
+  float maxAbs = 1e-9f;
+  for (float s : out.samples) maxAbs = std::max(maxAbs, std::fabs(s));
+  for (float& s : out.samples) s *= 0.5f / maxAbs;
+  return out;
+}
+
+}  // namespace synthetic
+}  // namespace avatar
@@ -0,0 +1,338 @@
+/**
+ * vad-bench.cpp - Voice activity detector and PCM ring checks, per-hop cost
+ *
+ * Mixes synthetic speech (known voiced spans) with white noise and checks
+ * the detector: it starts within 100 ms of the first voiced sample, covers
+ * the voiced spans, releases after the hangover, stays off through a
+ * steady noise step-up, and still finds speech at 10 dB SNR. Also checks
+ * the PCM ring's wrap-around spans and overrun accounting. Finally it feeds
+ * the signal through the ring at 60 Hz frames, as the template does, and
+ * reports cost per 10 ms hop and CPU per second of audio.
+ *
+ * Usage: vad-bench [mic.wav] [repeats]
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -Iapp/lib -Inative native/vad-bench.cpp \
+ *     -o build-native/vad-bench
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "avatar-pcm-ring.h"
+#include "avatar-vad.h"
+#include "synthetic-speech.h"
+#include "wav-io.h"
+
+namespace {
+  using avatar::PcmRing;
+  using avatar::VoiceActivityDetector;
+
+  constexpr uint32_t kRate = 48000;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectBelow(const char* name, double actual, double limit) {
+    if (!(actual < limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected < %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  void expectAbove(const char* name, double actual, double limit) {
+    if (!(actual > limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected > %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  double nowNs() {
+    using namespace std::chrono;
+    return duration<double, std::nano>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  struct Noise {
+    uint32_t state = 12345;
+    float next() {
+      state = state * 1664525u + 1013904223u;
+      return static_cast<float>(state >> 8) / 8388608.0f - 1.0f;
+    }
+  };
+
+  // White noise whose RMS is rmsDb dBFS (uniform: rms = amplitude / sqrt 3)
+  void addNoise(std::vector<float>& out, size_t begin, size_t end,
+                float rmsDb, Noise& noise) {
+    const float amplitude = std::pow(10.0f, rmsDb / 20.0f) * std::sqrt(3.0f);
+    for (size_t i = begin; i < end && i < out.size(); ++i) {
+      out[i] += amplitude * noise.next();
+    }
+  }
+
+  float rmsDb(const std::vector<float>& x) {
+    double sum = 0.0;
+    size_t n = 0;
+    for (float v : x) {
+      if (v != 0.0f) {
+        sum += static_cast<double>(v) * v;
+        ++n;
+      }
+    }
+    return 10.0f * static_cast<float>(std::log10(sum / std::max<size_t>(n, 1)));
+  }
+
+  /**
+   * Per-sample activity, pushing one 60 Hz frame at a time
+   */
+  std::vector<bool> run(VoiceActivityDetector& vad,
+                        const std::vector<float>& signal) {
+    std::vector<bool> active(signal.size(), false);
+    const size_t frame = kRate / 60;
+    for (size_t pushed = 0; pushed < signal.size(); pushed += frame) {
+      const size_t n = std::min(frame, signal.size() - pushed);
+      vad.push(signal.data() + pushed, static_cast<uint32_t>(n));
+      for (size_t i = pushed; i < pushed + n; ++i) active[i] = vad.active();
+    }
+    return active;
+  }
+
+  /**
+   * Speech placed at offset seconds in noise; scores voiced coverage
+   */
+  void speechTest() {
+    avatar::synthetic::SpeechSpec spec;
+    spec.seconds = 6.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    const size_t offset = 2 * kRate;
+    std::vector<float> signal(offset + speech.samples.size() + 3 * kRate,
+                              0.0f);
+    std::vector<float> f0(signal.size(), 0.0f);
+    for (size_t i = 0; i < speech.samples.size(); ++i) {
+      signal[offset + i] = 0.3f * speech.samples[i];
+      f0[offset + i] = speech.f0[i];
+    }
+    const float speechDb = rmsDb(signal);
+    Noise noise;
+    addNoise(signal, 0, signal.size(), speechDb - 30.0f, noise);
+
+    VoiceActivityDetector vad;
+    vad.configure(static_cast<float>(kRate));
+    const std::vector<bool> active = run(vad, signal);
+
+    size_t firstVoiced = 0, lastVoiced = 0, voiced = 0, covered = 0;
+    for (size_t i = 0; i < f0.size(); ++i) {
+      if (f0[i] <= 0.0f) continue;
+      if (voiced++ == 0) firstVoiced = i;
+      lastVoiced = i;
+      if (active[i]) ++covered;
+    }
+    size_t onset = firstVoiced;
+    while (onset < active.size() && !active[onset]) ++onset;
+    size_t release = lastVoiced;
+    while (release < active.size() && active[release]) ++release;
+
+    // The speech opens with a consonant burst, so only the lead-in counts
+    bool quietBefore = true;
+    for (size_t i = 0; i < offset; ++i) quietBefore &= !active[i];
+    expectTrue("no activity in leading noise", quietBefore);
+    expectBelow("onset latency (s)",
+                static_cast<double>(onset - firstVoiced) / kRate, 0.1);
+    expectAbove("voiced coverage", static_cast<double>(covered) / voiced,
+                0.95);
+    const double hangover = vad.params().hangoverSeconds;
+    expectBelow("release after last voice (s)",
+                static_cast<double>(release - lastVoiced) / kRate,
+                hangover + 0.1);
+    expectTrue("inactive at the end", !vad.active());
+  }
+
+  void noiseStepTest() {
+    // 2 s of quiet room, then a fan 15 dB louder for 6 s: steady and
+    // flat, so it must not count as speech while the floor relearns it
+    std::vector<float> signal(8 * kRate, 0.0f);
+    Noise noise;
+    addNoise(signal, 0, 2 * kRate, -55.0f, noise);
+    addNoise(signal, 2 * kRate, signal.size(), -40.0f, noise);
+    VoiceActivityDetector vad;
+    vad.configure(static_cast<float>(kRate));
+    const std::vector<float> quiet(signal.begin(), signal.begin() + 2 * kRate);
+    run(vad, quiet);
+    const float quietFloor = vad.noiseFloorDb();
+    const std::vector<float> fan(signal.begin() + 2 * kRate, signal.end());
+    run(vad, fan);
+    expectTrue("noise step does not start activity", vad.onsets() == 0);
+    expectAbove("noise floor relearned (dB gained of 15)",
+                vad.noiseFloorDb() - quietFloor, 12.0);
+  }
+
+  void lowSnrTest() {
+    avatar::synthetic::SpeechSpec spec;
+    spec.seconds = 6.0f;
+    spec.seed = 7;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    const size_t offset = kRate;
+    std::vector<float> signal(offset + speech.samples.size(), 0.0f);
+    for (size_t i = 0; i < speech.samples.size(); ++i) {
+      signal[offset + i] = 0.3f * speech.samples[i];
+    }
+    const float speechDb = rmsDb(signal);
+    Noise noise;
+    addNoise(signal, 0, signal.size(), speechDb - 10.0f, noise);
+
+    VoiceActivityDetector vad;
+    vad.configure(static_cast<float>(kRate));
+    const std::vector<bool> active = run(vad, signal);
+    size_t voiced = 0, covered = 0;
+    for (size_t i = 0; i < speech.f0.size(); ++i) {
+      if (speech.f0[i] <= 0.0f) continue;
+      ++voiced;
+      if (active[offset + i]) ++covered;
+    }
+    expectAbove("10 dB SNR voiced coverage",
+                static_cast<double>(covered) / voiced, 0.85);
+  }
+
+  void ringTest() {
+    auto ring = std::make_unique<PcmRing>();
+    std::vector<float> data(PcmRing::kCapacity + 1000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<float>(i);
+
+    // Wrap: start near the end so the read splits into two spans
+    ring->readIndex = ring->writeIndex = 0xFFFFFFFFu - 99;
+    ring->write(data.data(), 300);
+    std::vector<float> got;
+    int spans = 0;
+    ring->consume(PcmRing::kCapacity, [&](const float* p, uint32_t n) {
+      got.insert(got.end(), p, p + n);
+      ++spans;
+    });
+    bool inOrder = got.size() == 300;
+    for (size_t i = 0; inOrder && i < got.size(); ++i) inOrder = got[i] == i;
+    expectTrue("ring reads across the index wrap in order", inOrder);
+    expectTrue("ring wrap splits into two spans", spans == 2);
+
+    // Lapped: the oldest samples are skipped and counted
+    ring->write(data.data(), static_cast<uint32_t>(data.size()));
+    got.clear();
+    ring->consume(PcmRing::kCapacity, [&](const float* p, uint32_t n) {
+      got.insert(got.end(), p, p + n);
+    });
+    expectTrue("lapped ring counts overruns", ring->overruns == 1000);
+    expectTrue("lapped ring keeps the newest samples",
+               got.size() == PcmRing::kCapacity && got.front() == 1000.0f &&
+                   got.back() == static_cast<float>(data.size() - 1));
+    expectTrue("ring drained", ring->available() == 0);
+  }
+
+  void backlogTest() {
+    std::vector<float> second(kRate, 0.0f);
+    Noise noise;
+    addNoise(second, 0, second.size(), -50.0f, noise);
+    VoiceActivityDetector vad;
+    vad.configure(static_cast<float>(kRate));
+    vad.push(second.data(), kRate);
+    expectTrue("backlog analyses at most kMaxHopsPerPush hops",
+               vad.hops() == VoiceActivityDetector::kMaxHopsPerPush);
+    expectTrue("backlog hops are counted as dropped",
+               vad.hops() + vad.droppedHops() >= 95);
+  }
+
+  void bench(const char* label, const std::vector<float>& samples,
+             uint32_t sampleRate, int repeats) {
+    auto ring = std::make_unique<PcmRing>();
+    ring->sampleRate = static_cast<float>(sampleRate);
+    VoiceActivityDetector vad;
+    vad.configure(ring->sampleRate);
+    const size_t frame = sampleRate / 60;
+    auto pass = [&] {
+      for (size_t pushed = 0; pushed < samples.size(); pushed += frame) {
+        const uint32_t n =
+            static_cast<uint32_t>(std::min(frame, samples.size() - pushed));
+        ring->write(samples.data() + pushed, n);
+        ring->consume(PcmRing::kCapacity, [&](const float* p, uint32_t c) {
+          vad.push(p, c);
+        });
+      }
+    };
+    pass();  // warm up
+    vad.reset();
+    const double start = nowNs();
+    for (int r = 0; r < repeats; ++r) pass();
+    const double elapsed = nowNs() - start;
+    const double hops = static_cast<double>(vad.hops());
+    const double audioSeconds =
+        static_cast<double>(samples.size()) * repeats / sampleRate;
+    std::printf(
+        "%s: %.1f s at %u Hz, %.0f hops\n"
+        "  %.0f ns per hop, %.3f ms CPU per second of audio (%.3f%%)\n"
+        "  %u onsets, noise floor %.1f dB, %zu bytes (+%zu ring)\n",
+        label, audioSeconds / repeats, sampleRate, hops / repeats,
+        elapsed / hops, elapsed / audioSeconds / 1e6,
+        elapsed / audioSeconds / 1e7, vad.onsets() / repeats,
+        vad.noiseFloorDb(), vad.memoryBytes(), sizeof(PcmRing));
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* wavPath = nullptr;
+  int repeats = 20;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.size() > 4 && arg.compare(arg.size() - 4, 4, ".wav") == 0) {
+      wavPath = argv[i];
+    } else {
+      repeats = std::max(1, std::atoi(argv[i]));
+    }
+  }
+
+  ringTest();
+  speechTest();
+  noiseStepTest();
+  lowSnrTest();
+  backlogTest();
+
+  if (wavPath) {
+    avatar::wav::Audio audio;
+    std::string error;
+    if (!avatar::wav::read(wavPath, audio, &error)) {
+      std::fprintf(stderr, "Cannot read %s: %s\n", wavPath, error.c_str());
+      return 1;
+    }
+    bench(wavPath, audio.samples, audio.sampleRate, repeats);
+  } else {
+    avatar::synthetic::SpeechSpec spec;
+    spec.seconds = 20.0f;
+    std::vector<float> signal = avatar::synthetic::generateSpeech(spec).samples;
+    Noise noise;
+    addNoise(signal, 0, signal.size(), -50.0f, noise);
+    bench("synthetic speech in noise", signal, spec.sampleRate, repeats);
+  }
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d VAD checks failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All VAD checks passed\n");
+  return 0;
+}
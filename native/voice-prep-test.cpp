@@ -0,0 +1,340 @@
+/**
+ * voice-prep-test.cpp - Training-clip preprocessing checks and throughput
+ *
+ * Resampler: a 1 kHz tone through the common rate pairs must match the
+ * ideal tone to better than -70 dB, a tone above the output Nyquist must
+ * be removed to below -60 dB, and equal rates pass through untouched.
+ * Loudness: BS.1770 reference tones (1 kHz at 0 dBFS reads -3.01 LUFS)
+ * at several rates, gating of silence, and normalisation to the target
+ * under the peak ceiling. Slicing: synthetic speech with known voicing
+ * must be cut only in pauses, into segments within the length limits,
+ * keeping the voiced audio. Finally a batch of clips runs serially and
+ * on a thread pool; the outputs must match bit for bit, and both
+ * throughputs are printed.
+ *
+ * Usage: voice-prep-test
+ *
+ * Build command:
+ *   g++ -std=c++17 -O2 -pthread -Iapp/lib -Inative \
+ *     native/voice-prep-test.cpp -o build-native/voice-prep-test
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "synthetic-speech.h"
+#include "voice-prep.h"
+
+namespace {
+  namespace vp = avatar::voiceprep;
+
+  int g_failures = 0;
+
+  void expectTrue(const char* name, bool condition) {
+    if (!condition) {
+      std::fprintf(stderr, "FAIL %s\n", name);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s\n", name);
+    }
+  }
+
+  void expectNear(const char* name, double actual, double expected,
+                  double tolerance) {
+    if (std::fabs(actual - expected) > tolerance) {
+      std::fprintf(stderr, "FAIL %s: expected %.4f, got %.4f\n", name,
+                   expected, actual);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  void expectBelow(const char* name, double actual, double limit) {
+    if (!(actual < limit)) {
+      std::fprintf(stderr, "FAIL %s: %.4f, expected < %.4f\n", name, actual,
+                   limit);
+      ++g_failures;
+    } else {
+      std::printf("ok   %s = %.4f\n", name, actual);
+    }
+  }
+
+  double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  std::vector<float> tone(double hz, double amplitude, uint32_t rate,
+                          double seconds) {
+    std::vector<float> out(static_cast<size_t>(seconds * rate));
+    for (size_t i = 0; i < out.size(); ++i) {
+      out[i] = static_cast<float>(
+          amplitude * std::sin(6.283185307179586 * hz * i / rate));
+    }
+    return out;
+  }
+
+  void resamplerTest() {
+    const uint32_t pairs[][2] = {{48000, 32000}, {44100, 32000},
+                                 {22050, 32000}, {16000, 32000},
+                                 {24000, 16000}, {96000, 44100}};
+    for (const auto& pair : pairs) {
+      const uint32_t in = pair[0], out = pair[1];
+      vp::PolyphaseResampler resampler;
+      char name[96];
+      std::snprintf(name, sizeof(name), "%u -> %u configures", in, out);
+      expectTrue(name, resampler.configure(in, out));
+
+      const std::vector<float> x = tone(1000.0, 0.5, in, 1.0);
+      std::vector<float> y;
+      resampler.process(x.data(), x.size(), y);
+      std::snprintf(name, sizeof(name), "%u -> %u length", in, out);
+      expectTrue(name, y.size() == resampler.outputLength(x.size()) &&
+                           std::llabs(static_cast<long long>(y.size()) -
+                                      static_cast<long long>(out)) <= 1);
+
+      // Away from the edges, against the ideal tone at the new rate
+      const std::vector<float> ideal = tone(1000.0, 0.5, out, 1.0);
+      double err = 0.0, sig = 0.0;
+      for (size_t i = out / 10; i < out - out / 10; ++i) {
+        const double d = y[i] - ideal[i];
+        err += d * d;
+        sig += static_cast<double>(ideal[i]) * ideal[i];
+      }
+      std::snprintf(name, sizeof(name), "%u -> %u tone error (dB, %u taps)",
+                    in, out, resampler.taps());
+      expectBelow(name, 10.0 * std::log10(err / sig), -70.0);
+    }
+
+    // Above the output Nyquist: must not alias back in
+    vp::PolyphaseResampler down;
+    down.configure(48000, 32000);
+    const std::vector<float> high = tone(18000.0, 0.5, 48000, 1.0);
+    std::vector<float> y;
+    down.process(high.data(), high.size(), y);
+    double power = 0.0;
+    for (size_t i = 3200; i < y.size() - 3200; ++i) power += y[i] * y[i];
+    power /= static_cast<double>(y.size() - 6400);
+    expectBelow("18 kHz removed at 32 kHz (dB)",
+                10.0 * std::log10(power / 0.125 + 1e-30), -60.0);
+
+    vp::PolyphaseResampler same;
+    same.configure(32000, 32000);
+    const std::vector<float> x = tone(440.0, 0.3, 32000, 0.1);
+    same.process(x.data(), x.size(), y);
+    expectTrue("equal rates pass through", y == x);
+    expectTrue("unsupported ratio refused",
+               !same.configure(48000, 44101));
+  }
+
+  void loudnessTest() {
+    for (uint32_t rate : {48000u, 44100u, 32000u}) {
+      const std::vector<float> full = tone(1000.0, 1.0, rate, 5.0);
+      char name[96];
+      std::snprintf(name, sizeof(name), "%u Hz 1 kHz 0 dBFS (LUFS)", rate);
+      expectNear(name, vp::integratedLoudness(full.data(), full.size(), rate),
+                 -3.01, 0.05);
+    }
+    std::vector<float> quiet = tone(1000.0, 0.1, 48000, 5.0);
+    expectNear("1 kHz -20 dBFS (LUFS)",
+               vp::integratedLoudness(quiet.data(), quiet.size(), 48000),
+               -23.01, 0.05);
+    quiet.resize(quiet.size() + 48000 * 10, 0.0f);
+    // Only the blocks straddling the end of the tone still count
+    expectNear("trailing silence is gated out",
+               vp::integratedLoudness(quiet.data(), quiet.size(), 48000),
+               -23.01, 0.2);
+    const std::vector<float> silence(48000, 0.0f);
+    expectTrue("silence has no loudness",
+               vp::integratedLoudness(silence.data(), silence.size(),
+                                      48000) <= -200.0);
+
+    // Normalise speech to the target
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = 44100;
+    spec.seconds = 12.0f;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    std::vector<float> soft(speech.samples);
+    for (float& s : soft) s *= 0.05f;
+    vp::PrepSpec prep;
+    vp::PolyphaseResampler resampler;
+    vp::PreparedClip clip;
+    vp::prepareClip(soft.data(), soft.size(), 44100, prep, resampler, clip);
+    expectNear("normalised to target (LUFS)",
+               vp::integratedLoudness(clip.audio.data(), clip.audio.size(),
+                                      clip.sampleRate),
+               prep.targetLufs, 0.2);
+
+    // A click train has far more peak than loudness: the ceiling wins
+    std::vector<float> clicks(44100 * 2, 0.0f);
+    for (size_t i = 0; i < clicks.size(); i += 4410) clicks[i] = 0.2f;
+    vp::prepareClip(clicks.data(), clicks.size(), 44100, prep, resampler,
+                    clip);
+    float peak = 0.0f;
+    for (float s : clip.audio) peak = std::max(peak, std::fabs(s));
+    expectBelow("peak ceiling holds", peak, prep.peakCeiling + 1e-4);
+  }
+
+  void sliceTest() {
+    avatar::synthetic::SpeechSpec spec;
+    spec.sampleRate = 32000;
+    spec.seconds = 40.0f;
+    spec.seed = 7;
+    const auto speech = avatar::synthetic::generateSpeech(spec);
+    std::vector<float> clip(speech.samples);
+    // Pad with a second of silence each side to be trimmed
+    clip.insert(clip.begin(), 32000, 0.0f);
+    clip.resize(clip.size() + 32000, 0.0f);
+    const size_t offset = 32000;
+
+    vp::SliceSpec slice;
+    const auto segments = vp::sliceSpeech(clip.data(), clip.size(), 32000,
+                                          slice);
+    std::printf("%zu segments:", segments.size());
+    for (const auto& s : segments) {
+      std::printf(" %.2f", (s.end - s.start) / 32000.0);
+    }
+    std::printf("\n");
+    expectTrue("several segments", segments.size() >= 4);
+
+    bool ordered = true, lengths = true, quietEdges = true;
+    for (size_t i = 0; i < segments.size(); ++i) {
+      const auto& s = segments[i];
+      if (i > 0 && s.start < segments[i - 1].end) ordered = false;
+      const double seconds = (s.end - s.start) / 32000.0;
+      if (seconds < slice.minKeep || seconds > slice.maxSegment + 0.5) {
+        lengths = false;
+      }
+      // Cut in silence: no voicing within 5 ms of either edge
+      for (size_t edge : {s.start, s.end}) {
+        for (size_t k = edge > 160 ? edge - 160 : 0;
+             k < std::min(clip.size(), edge + 160); ++k) {
+          if (k >= offset && k - offset < speech.f0.size() &&
+              speech.f0[k - offset] > 0.0f) {
+            quietEdges = false;
+          }
+        }
+      }
+    }
+    expectTrue("segments ordered and disjoint", ordered);
+    expectTrue("segment lengths within limits", lengths);
+    expectTrue("cuts fall in pauses", quietEdges);
+
+    size_t voiced = 0, covered = 0;
+    for (size_t i = 0; i < speech.f0.size(); ++i) {
+      if (speech.f0[i] <= 0.0f) continue;
+      ++voiced;
+      const size_t at = i + offset;
+      for (const auto& s : segments) {
+        if (at >= s.start && at < s.end) {
+          ++covered;
+          break;
+        }
+      }
+    }
+    const double coverage = static_cast<double>(covered) / voiced;
+    expectTrue("voiced audio kept (>= 97%)", coverage >= 0.97);
+    std::printf("     coverage %.4f\n", coverage);
+    expectBelow("leading silence trimmed (s)",
+                segments.front().start / 32000.0, 1.2 + 0.01);
+    expectTrue("leading silence mostly gone",
+               segments.front().start / 32000.0 > 1.0);
+
+    const std::vector<float> silence(32000 * 5, 0.0f);
+    expectTrue("silence gives no segments",
+               vp::sliceSpeech(silence.data(), silence.size(), 32000, slice)
+                   .empty());
+  }
+
+  void batchTest() {
+    const uint32_t rates[] = {44100, 48000, 22050, 24000};
+    const int kClips = 16;
+    std::vector<avatar::synthetic::SyntheticSpeech> clips;
+    double audioSeconds = 0.0;
+    for (int i = 0; i < kClips; ++i) {
+      avatar::synthetic::SpeechSpec spec;
+      spec.sampleRate = rates[i % 4];
+      spec.seconds = 20.0f;
+      spec.seed = static_cast<uint32_t>(100 + i);
+      clips.push_back(avatar::synthetic::generateSpeech(spec));
+      audioSeconds += spec.seconds;
+    }
+    const vp::PrepSpec prep;
+
+    std::vector<vp::PreparedClip> serial(kClips), parallel(kClips);
+    double start = nowMs();
+    {
+      vp::PolyphaseResampler resampler;
+      for (int i = 0; i < kClips; ++i) {
+        vp::prepareClip(clips[i].samples.data(), clips[i].samples.size(),
+                        clips[i].sampleRate, prep, resampler, serial[i]);
+      }
+    }
+    const double serialMs = nowMs() - start;
+
+    const unsigned threads =
+        std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+    std::atomic<int> next{0};
+    start = nowMs();
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) {
+      pool.emplace_back([&] {
+        vp::PolyphaseResampler resampler;
+        for (int i = next++; i < kClips; i = next++) {
+          vp::prepareClip(clips[i].samples.data(), clips[i].samples.size(),
+                          clips[i].sampleRate, prep, resampler, parallel[i]);
+        }
+      });
+    }
+    for (auto& worker : pool) worker.join();
+    const double parallelMs = nowMs() - start;
+
+    bool same = true;
+    for (int i = 0; i < kClips; ++i) {
+      same = same && serial[i].audio == parallel[i].audio &&
+             serial[i].segments.size() == parallel[i].segments.size();
+      for (size_t s = 0; same && s < serial[i].segments.size(); ++s) {
+        same = serial[i].segments[s].start == parallel[i].segments[s].start &&
+               serial[i].segments[s].end == parallel[i].segments[s].end;
+      }
+    }
+    expectTrue("thread pool output matches serial", same);
+
+    double resampleMs = 0.0, loudnessMs = 0.0, sliceMs = 0.0;
+    for (const auto& c : serial) {
+      resampleMs += c.times.resampleMs;
+      loudnessMs += c.times.loudnessMs;
+      sliceMs += c.times.sliceMs;
+    }
+    std::printf("%d clips, %.0f s of audio (%s): serial %.1f ms (%.0fx "
+                "realtime), %u threads %.1f ms (%.0fx realtime, %.1fx)\n",
+                kClips, audioSeconds, avatar::simd::backendName(), serialMs,
+                audioSeconds * 1e3 / serialMs, threads, parallelMs,
+                audioSeconds * 1e3 / parallelMs, serialMs / parallelMs);
+    std::printf("serial stages: resample %.1f ms, loudness %.1f ms, "
+                "slice %.1f ms\n",
+                resampleMs, loudnessMs, sliceMs);
+  }
+}  // namespace
+
+int main() {
+  resamplerTest();
+  loudnessTest();
+  sliceTest();
+  batchTest();
+
+  if (g_failures > 0) {
+    std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+    return 1;
+  }
+  std::printf("All voice-prep checks passed\n");
+  return 0;
+}
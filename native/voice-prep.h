@@ -0,0 +1,477 @@
+/**
+ * voice-prep.h - Training-clip preprocessing for voice cloning
+ *
+ * The stages the voice backend expects of its reference audio, done
+ * natively:
+ *
+ *   decoded mono -> resample (polyphase, SIMD) -> loudness normalise
+ *                -> trim and slice at pauses -> fades -> segments
+ *
+ * PolyphaseResampler converts between any pair of common rates with a
+ * Kaiser-windowed sinc, one phase per output position, as dot products
+ * four taps at a time. Loudness is ITU-R BS.1770 integrated loudness
+ * (K-weighting, 400 ms blocks, absolute and relative gates), with the
+ * gain capped so the sample peak stays under a ceiling. Slicing follows
+ * the usual slicer for voice datasets: silence is measured in 10 ms hops
+ * after normalisation, leading and trailing silence is trimmed, pauses
+ * of at least minSilence become cut points, short pieces are merged up
+ * to minSegment and long ones split at their quietest hop.
+ *
+ * Everything here is single-threaded and allocates per clip; the batch
+ * tool (voice-prep.cpp) runs clips on a thread pool.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "avatar-simd.h"
+
+namespace avatar {
+namespace voiceprep {
+
+/**
+ * Rational-ratio resampler; taps per phase are a multiple of four
+ */
+class PolyphaseResampler {
+ public:
+  static constexpr uint32_t kMaxPhases = 4096;
+
+  /**
+   * Design the filter; false if the rate ratio needs more than
+   * kMaxPhases phases. zeroCrossings sets the sinc length per side
+   * (at the narrower of the two bandwidths), rolloff the passband edge
+   * as a fraction of the lower Nyquist.
+   */
+  bool configure(uint32_t inRate, uint32_t outRate,
+                 uint32_t zeroCrossings = 16, float rolloff = 0.92f,
+                 float kaiserBeta = 8.6f) {
+    if (inRate == 0 || outRate == 0) return false;
+    const uint32_t g = std::gcd(inRate, outRate);
+    const uint32_t up = outRate / g;
+    const uint32_t down = inRate / g;
+    if (up > kMaxPhases) return false;
+    inRate_ = inRate;
+    outRate_ = outRate;
+    up_ = up;
+    down_ = down;
+    if (up == 1 && down == 1) {
+      taps_ = 0;
+      return true;
+    }
+
+    const double scale = std::min(1.0, static_cast<double>(up) / down);
+    const double cutoff = rolloff * scale;
+    const uint32_t half = static_cast<uint32_t>(
+        std::ceil(zeroCrossings / scale));
+    taps_ = (2 * half + 3) & ~3u;
+    centre_ = taps_ / 2 - 1;
+    const double kPi = 3.141592653589793;
+    const double reach = static_cast<double>(taps_) / 2.0;
+    const double norm = besselI0(kaiserBeta);
+    coefficients_.assign(static_cast<size_t>(up) * taps_, 0.0f);
+    for (uint32_t p = 0; p < up; ++p) {
+      float* h = coefficients_.data() + static_cast<size_t>(p) * taps_;
+      double sum = 0.0;
+      std::vector<double> phase(taps_);
+      for (uint32_t k = 0; k < taps_; ++k) {
+        // Input sample k sits d samples from the output position
+        const double d = static_cast<double>(k) - centre_ -
+                         static_cast<double>(p) / up;
+        const double u = d / reach;
+        const double window =
+            std::fabs(u) < 1.0
+                ? besselI0(kaiserBeta * std::sqrt(1.0 - u * u)) / norm
+                : 0.0;
+        const double x = cutoff * d;
+        const double sinc =
+            std::fabs(x) < 1e-9 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+        phase[k] = cutoff * sinc * window;
+        sum += phase[k];
+      }
+      // Unity gain at DC in every phase
+      for (uint32_t k = 0; k < taps_; ++k) {
+        h[k] = static_cast<float>(phase[k] / sum);
+      }
+    }
+    return true;
+  }
+
+  /** Output samples produced for count input samples */
+  size_t outputLength(size_t count) const {
+    return static_cast<size_t>(
+        (static_cast<uint64_t>(count) * up_ + down_ - 1) / down_);
+  }
+
+  /**
+   * Resample a whole clip (zero beyond both ends) into out
+   */
+  void process(const float* in, size_t count, std::vector<float>& out) {
+    const size_t produced = outputLength(count);
+    out.resize(produced);
+    if (taps_ == 0) {
+      std::copy(in, in + count, out.begin());
+      return;
+    }
+    // Zero padding so every window reads inside the buffer
+    padded_.assign(count + 2 * taps_, 0.0f);
+    std::copy(in, in + count, padded_.begin() + taps_);
+
+    size_t index = 0;  // input sample at or before the output position
+    uint32_t phase = 0;
+    for (size_t n = 0; n < produced; ++n) {
+      const float* x = padded_.data() + taps_ + index - centre_;
+      const float* h =
+          coefficients_.data() + static_cast<size_t>(phase) * taps_;
+      simd::f32x4 acc = simd::splat(0.0f);
+      for (uint32_t k = 0; k < taps_; k += 4) {
+        acc = simd::madd(simd::load(h + k), simd::load(x + k), acc);
+      }
+      out[n] = simd::lane<0>(simd::hsum(acc));
+      phase += down_;
+      index += phase / up_;
+      phase %= up_;
+    }
+  }
+
+  uint32_t inRate() const { return inRate_; }
+  uint32_t outRate() const { return outRate_; }
+  uint32_t phases() const { return up_; }
+  uint32_t taps() const { return taps_; }
+
+ private:
+  static double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    const double q = x * x / 4.0;
+    for (int k = 1; k < 64 && term > 1e-12 * sum; ++k) {
+      term *= q / (static_cast<double>(k) * k);
+      sum += term;
+    }
+    return sum;
+  }
+
+  uint32_t inRate_{0}, outRate_{0};
+  uint32_t up_{1}, down_{1};
+  uint32_t taps_{0};
+  uint32_t centre_{0};
+  std::vector<float> coefficients_;  // [phase][tap]
+  std::vector<float> padded_;
+};
+
+/**
+ * Direct form I biquad, run in double for the low shelf corner
+ */
+struct Biquad {
+  double b0{1}, b1{0}, b2{0}, a1{0}, a2{0};
+  double x1{0}, x2{0}, y1{0}, y2{0};
+
+  double process(double x) {
+    double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+    // A decaying tail in digital silence would otherwise go subnormal
+    if (std::fabs(y) < 1e-30) y = 0.0;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    return y;
+  }
+};
+
+/**
+ * BS.1770 integrated loudness in LUFS of a mono clip; -inf (as -200)
+ * when every block is under the absolute gate
+ */
+inline double integratedLoudness(const float* x, size_t count,
+                                 uint32_t sampleRate) {
+  const double kPi = 3.141592653589793;
+  const double fs = static_cast<double>(sampleRate);
+  // K-weighting: the high shelf and RLB high-pass of BS.1770, designed
+  // for this rate (constants as in libebur128)
+  Biquad shelf, highpass;
+  {
+    const double f0 = 1681.974450955533, gainDb = 3.999843853973347;
+    const double q = 0.7071752369554196;
+    const double k = std::tan(kPi * f0 / fs);
+    const double vh = std::pow(10.0, gainDb / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + k / q + k * k;
+    shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    shelf.b1 = 2.0 * (k * k - vh) / a0;
+    shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    shelf.a2 = (1.0 - k / q + k * k) / a0;
+  }
+  {
+    const double f0 = 38.13547087602444, q = 0.5003270373238773;
+    const double k = std::tan(kPi * f0 / fs);
+    const double a0 = 1.0 + k / q + k * k;
+    highpass.b0 = 1.0;
+    highpass.b1 = -2.0;
+    highpass.b2 = 1.0;
+    highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    highpass.a2 = (1.0 - k / q + k * k) / a0;
+  }
+
+  // Mean square per 100 ms step; blocks are four steps (75% overlap)
+  const size_t step = std::max<size_t>(1, sampleRate / 10);
+  std::vector<double> steps;
+  double acc = 0.0;
+  size_t inStep = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const double y = highpass.process(shelf.process(x[i]));
+    acc += y * y;
+    if (++inStep == step) {
+      steps.push_back(acc / static_cast<double>(step));
+      acc = 0.0;
+      inStep = 0;
+    }
+  }
+  std::vector<double> blocks;
+  if (steps.size() >= 4) {
+    for (size_t i = 0; i + 4 <= steps.size(); ++i) {
+      blocks.push_back(
+          (steps[i] + steps[i + 1] + steps[i + 2] + steps[i + 3]) / 4.0);
+    }
+  } else if (count > 0) {
+    // Shorter than one block: the whole clip is the block
+    double total = acc;
+    for (double s : steps) total += s * static_cast<double>(step);
+    blocks.push_back(total / static_cast<double>(count));
+  }
+
+  const auto lufs = [](double power) {
+    return -0.691 + 10.0 * std::log10(power);
+  };
+  const double kAbsoluteGate = -70.0;
+  double sum = 0.0;
+  size_t kept = 0;
+  for (double b : blocks) {
+    if (b > 0.0 && lufs(b) > kAbsoluteGate) {
+      sum += b;
+      ++kept;
+    }
+  }
+  if (kept == 0) return -200.0;
+  const double relativeGate = lufs(sum / kept) - 10.0;
+  double gated = 0.0;
+  size_t passed = 0;
+  for (double b : blocks) {
+    if (b > 0.0 && lufs(b) > kAbsoluteGate && lufs(b) > relativeGate) {
+      gated += b;
+      ++passed;
+    }
+  }
+  return lufs(gated / passed);
+}
+
+struct SliceSpec {
+  float thresholdDb = -40.0f;   // hop RMS under this is silence (dBFS)
+  float minSilence = 0.3f;      // pauses this long become cut points
+  float keepSilence = 0.15f;    // silence kept at each segment edge
+  float minSegment = 3.0f;      // shorter pieces are merged
+  float maxSegment = 10.0f;     // longer ones are split
+  float maxMergeGap = 1.0f;     // never merge across a longer pause
+  float minKeep = 1.0f;         // shorter segments are dropped
+};
+
+struct Segment {
+  size_t start;
+  size_t end;  // exclusive
+};
+
+/**
+ * Cut a (normalised) clip into segments at its pauses
+ */
+inline std::vector<Segment> sliceSpeech(const float* x, size_t count,
+                                        uint32_t sampleRate,
+                                        const SliceSpec& spec) {
+  const size_t hop = std::max<size_t>(1, sampleRate / 100);
+  const size_t hops = count / hop;
+  std::vector<float> db(hops);
+  for (size_t h = 0; h < hops; ++h) {
+    // 20 ms window centred on the hop
+    const size_t a = h * hop >= hop / 2 ? h * hop - hop / 2 : 0;
+    const size_t b = std::min(count, h * hop + hop + hop / 2);
+    double energy = 0.0;
+    for (size_t i = a; i < b; ++i) energy += static_cast<double>(x[i]) * x[i];
+    db[h] = static_cast<float>(
+        10.0 * std::log10(energy / static_cast<double>(b - a) + 1e-12));
+  }
+  const auto seconds = [&](float s) {
+    return static_cast<size_t>(s * 100.0f + 0.5f);
+  };
+  const size_t minSilence = std::max<size_t>(1, seconds(spec.minSilence));
+  const size_t keep = seconds(spec.keepSilence);
+
+  // Sounding pieces between cut points, in hops
+  struct Piece {
+    size_t start, end;
+  };
+  std::vector<Piece> pieces;
+  size_t h = 0;
+  while (h < hops && db[h] < spec.thresholdDb) ++h;
+  size_t pieceStart = h;
+  size_t lastSound = h;
+  while (h < hops) {
+    if (db[h] >= spec.thresholdDb) {
+      lastSound = h++;
+      continue;
+    }
+    size_t run = h;
+    while (run < hops && db[run] < spec.thresholdDb) ++run;
+    if (run == hops) break;  // trailing silence
+    if (run - h >= minSilence) {
+      pieces.push_back({pieceStart, lastSound + 1});
+      pieceStart = run;
+    }
+    h = run;
+  }
+  if (pieceStart < hops && lastSound >= pieceStart) {
+    pieces.push_back({pieceStart, lastSound + 1});
+  }
+
+  // Merge up to minSegment, across short enough pauses
+  const size_t minSegment = seconds(spec.minSegment);
+  const size_t maxSegment = std::max(seconds(spec.maxSegment), minSegment);
+  const size_t maxGap = seconds(spec.maxMergeGap);
+  std::vector<Piece> merged;
+  for (const Piece& p : pieces) {
+    if (!merged.empty()) {
+      Piece& last = merged.back();
+      if (last.end - last.start < minSegment &&
+          p.start - last.end <= maxGap && p.end - last.start <= maxSegment) {
+        last.end = p.end;
+        continue;
+      }
+    }
+    merged.push_back(p);
+  }
+
+  // Split what is still too long at the quietest hop that leaves both
+  // sides at least minSegment (or anywhere, if it cannot)
+  std::vector<Piece> split;
+  for (Piece p : merged) {
+    while (p.end - p.start > maxSegment) {
+      size_t lo = p.start + minSegment, hi = p.end - minSegment;
+      if (lo >= hi) {
+        lo = p.start + 1;
+        hi = p.end - 1;
+      }
+      hi = std::min(hi, p.start + maxSegment);
+      size_t cut = lo;
+      for (size_t c = lo; c < hi; ++c) {
+        if (db[c] < db[cut]) cut = c;
+      }
+      split.push_back({p.start, cut});
+      p.start = cut;
+    }
+    split.push_back(p);
+  }
+
+  std::vector<Segment> out;
+  const size_t minKeep = seconds(spec.minKeep);
+  for (size_t i = 0; i < split.size(); ++i) {
+    const Piece& p = split[i];
+    if (p.end - p.start < minKeep) continue;
+    // Keep a little of the surrounding silence, never past a neighbour
+    const size_t before = i > 0 ? split[i - 1].end : 0;
+    const size_t after = i + 1 < split.size() ? split[i + 1].start : hops;
+    const size_t start =
+        std::max(before + (p.start - before) / 2,
+                 p.start >= keep ? p.start - keep : 0);
+    const size_t end = std::min(after - (after - p.end) / 2, p.end + keep);
+    out.push_back({start * hop, std::min(count, end * hop)});
+  }
+  return out;
+}
+
+struct PrepSpec {
+  uint32_t sampleRate = 32000;  // output rate
+  float targetLufs = -20.0f;
+  float peakCeiling = 0.95f;    // linear sample peak after gain
+  float fadeSeconds = 0.005f;   // at each segment edge
+  SliceSpec slice;
+};
+
+struct StageTimes {
+  double resampleMs{0}, loudnessMs{0}, sliceMs{0};
+};
+
+struct PreparedClip {
+  uint32_t sampleRate{0};
+  std::vector<float> audio;  // resampled and normalised
+  std::vector<Segment> segments;
+  double inputLufs{-200.0};
+  float gainDb{0.0f};
+  StageTimes times;
+};
+
+/**
+ * Run the pipeline on one decoded clip; resampler is reconfigured when
+ * the clip's rate differs from the last one. False if the rate pair is
+ * unsupported.
+ */
+inline bool prepareClip(const float* samples, size_t count,
+                        uint32_t sampleRate, const PrepSpec& spec,
+                        PolyphaseResampler& resampler, PreparedClip& out) {
+  using Clock = std::chrono::steady_clock;
+  const auto ms = [](Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+  };
+
+  auto t0 = Clock::now();
+  if (resampler.inRate() != sampleRate ||
+      resampler.outRate() != spec.sampleRate) {
+    if (!resampler.configure(sampleRate, spec.sampleRate)) return false;
+  }
+  out.sampleRate = spec.sampleRate;
+  resampler.process(samples, count, out.audio);
+  auto t1 = Clock::now();
+  out.times.resampleMs = ms(t0, t1);
+
+  std::vector<float>& audio = out.audio;
+  out.inputLufs =
+      integratedLoudness(audio.data(), audio.size(), spec.sampleRate);
+  float peak = 0.0f;
+  for (float s : audio) peak = std::max(peak, std::fabs(s));
+  double gainDb = out.inputLufs > -200.0
+                      ? spec.targetLufs - out.inputLufs
+                      : 0.0;
+  if (peak > 0.0f) {
+    gainDb = std::min(gainDb,
+                      20.0 * std::log10(spec.peakCeiling / peak));
+  }
+  out.gainDb = static_cast<float>(gainDb);
+  const simd::f32x4 gain =
+      simd::splat(static_cast<float>(std::pow(10.0, gainDb / 20.0)));
+  size_t i = 0;
+  for (; i + 4 <= audio.size(); i += 4) {
+    simd::store(audio.data() + i,
+                simd::mul(simd::load(audio.data() + i), gain));
+  }
+  for (; i < audio.size(); ++i) audio[i] *= simd::lane<0>(gain);
+  auto t2 = Clock::now();
+  out.times.loudnessMs = ms(t1, t2);
+
+  out.segments =
+      sliceSpeech(audio.data(), audio.size(), spec.sampleRate, spec.slice);
+  const size_t fade = static_cast<size_t>(spec.fadeSeconds * spec.sampleRate);
+  for (const Segment& s : out.segments) {
+    const size_t n = std::min(fade, (s.end - s.start) / 2);
+    for (size_t k = 0; k < n; ++k) {
+      const float ramp = static_cast<float>(k) / static_cast<float>(n);
+      audio[s.start + k] *= ramp;
+      audio[s.end - 1 - k] *= ramp;
+    }
+  }
+  out.times.sliceMs = ms(t2, Clock::now());
+  return true;
+}
+
+}  // namespace voiceprep
+}  // namespace avatar
@@ -0,0 +1,178 @@
+/**
+ * wav-io.h - Minimal RIFF/WAVE reader and writer for the audio tools
+ *
+ * Reads 16/24/32-bit PCM and 32-bit float files (plain or
+ * WAVE_FORMAT_EXTENSIBLE)
+ * and mixes them down to mono floats in -1..1, which is what the engine's
+ * audio paths take. Writes mono 16-bit PCM. No resampling.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace avatar {
+namespace wav {
+
+struct Audio {
+  uint32_t sampleRate = 0;
+  std::vector<float> samples;  // mono
+};
+
+namespace detail {
+
+inline uint32_t le32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+inline uint16_t le16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+inline void putLE32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+inline void putLE16(std::vector<uint8_t>& out, uint16_t value) {
+  out.push_back(value & 0xFF);
+  out.push_back(value >> 8);
+}
+
+}  // namespace detail
+
+/**
+ * Decode a WAV file held in memory; false with a reason on error
+ */
+inline bool decode(const uint8_t* data, size_t size, Audio& out,
+                   std::string* error) {
+  auto fail = [error](const char* reason) {
+    if (error) *error = reason;
+    return false;
+  };
+  if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 ||
+      std::memcmp(data + 8, "WAVE", 4) != 0) {
+    return fail("not a RIFF/WAVE file");
+  }
+
+  uint16_t format = 0, channels = 0, bits = 0;
+  const uint8_t* samples = nullptr;
+  size_t pcmBytes = 0;
+  for (size_t offset = 12; offset + 8 <= size;) {
+    const uint8_t* chunk = data + offset;
+    const size_t length = detail::le32(chunk + 4);
+    const size_t available = std::min(length, size - offset - 8);
+    if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+      format = detail::le16(chunk + 8);
+      channels = detail::le16(chunk + 10);
+      out.sampleRate = detail::le32(chunk + 12);
+      bits = detail::le16(chunk + 22);
+      // Extensible: the real format is the subformat GUID's first word
+      if (format == 0xFFFE && available >= 40) {
+        format = detail::le16(chunk + 32);
+      }
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      samples = chunk + 8;
+      pcmBytes = available;
+    }
+    offset += 8 + length + (length & 1);  // chunks are word aligned
+  }
+
+  if (!samples || channels == 0 || out.sampleRate == 0) {
+    return fail("missing fmt or data chunk");
+  }
+  const bool pcm = format == 1 && (bits == 16 || bits == 24 || bits == 32);
+  const bool float32 = format == 3 && bits == 32;
+  if (!pcm && !float32) {
+    return fail("only 16/24/32-bit PCM and float32 supported");
+  }
+
+  const size_t frameBytes = static_cast<size_t>(channels) * bits / 8;
+  const size_t frames = pcmBytes / frameBytes;
+  out.samples.assign(frames, 0.0f);
+  const float scale = 1.0f / static_cast<float>(channels);
+  for (size_t i = 0; i < frames; ++i) {
+    const uint8_t* frame = samples + i * frameBytes;
+    float sum = 0.0f;
+    for (uint16_t c = 0; c < channels; ++c) {
+      const uint8_t* p = frame + c * (bits / 8);
+      if (float32) {
+        const uint32_t word = detail::le32(p);
+        float value;
+        std::memcpy(&value, &word, sizeof(value));
+        sum += value;
+      } else if (bits == 16) {
+        sum += static_cast<int16_t>(detail::le16(p)) / 32768.0f;
+      } else if (bits == 24) {
+        // Sign-extend through the top of a 32-bit word
+        const uint32_t word = uint32_t{p[0]} << 8 | uint32_t{p[1]} << 16 |
+                              uint32_t{p[2]} << 24;
+        sum += static_cast<float>(static_cast<int32_t>(word)) / 2147483648.0f;
+      } else {
+        sum += static_cast<float>(static_cast<int32_t>(detail::le32(p))) /
+               2147483648.0f;
+      }
+    }
+    out.samples[i] = sum * scale;
+  }
+  return true;
+}
+
+inline bool read(const char* path, Audio& out, std::string* error) {
+  FILE* file = std::fopen(path, "rb");
+  if (!file) {
+    if (error) *error = "cannot open file";
+    return false;
+  }
+  std::vector<uint8_t> bytes;
+  uint8_t buffer[65536];
+  size_t n;
+  while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    bytes.insert(bytes.end(), buffer, buffer + n);
+  }
+  std::fclose(file);
+  return decode(bytes.data(), bytes.size(), out, error);
+}
+
+/**
+ * Encode mono samples (-1..1, clipped) as 16-bit PCM
+ */
+inline std::vector<uint8_t> encodePcm16(const float* samples, size_t count,
+                                        uint32_t sampleRate) {
+  std::vector<uint8_t> out = {'R', 'I', 'F', 'F'};
+  detail::putLE32(out, static_cast<uint32_t>(36 + count * 2));
+  out.insert(out.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+  detail::putLE32(out, 16);
+  detail::putLE16(out, 1);  // PCM
+  detail::putLE16(out, 1);  // mono
+  detail::putLE32(out, sampleRate);
+  detail::putLE32(out, sampleRate * 2);
+  detail::putLE16(out, 2);
+  detail::putLE16(out, 16);
+  out.insert(out.end(), {'d', 'a', 't', 'a'});
+  detail::putLE32(out, static_cast<uint32_t>(count * 2));
+  for (size_t i = 0; i < count; ++i) {
+    const float clipped = std::max(-1.0f, std::min(1.0f, samples[i]));
+    detail::putLE16(out, static_cast<uint16_t>(
+                             static_cast<int16_t>(clipped * 32767.0f)));
+  }
+  return out;
+}
+
+inline bool writePcm16(const char* path, const float* samples, size_t count,
+                       uint32_t sampleRate) {
+  const std::vector<uint8_t> bytes = encodePcm16(samples, count, sampleRate);
+  FILE* file = std::fopen(path, "wb");
+  if (!file) return false;
+  const bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) ==
+                  bytes.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+}  // namespace wav
+}  // namespace avatar
@@ -150,10 +150,59 @@ function createMockWasmModule() {
         initScene: () => instance.initScene(),
         loadAvatarModel: (ptr, size) => instance.loadAvatarModel(ptr, size),
         setAnimationState: (ptr) => instance.setAnimationState(ptr),
+        // Graph accepted but not compiled; no setAnimationStateIndex, so
+        // the controller keeps passing state names the mock can log
+        loadAnimationGraph: () => 1,
         updateFrame: () => instance.updateFrame(),
         setCanvasSize: (w, h) => instance.setCanvasSize(w, h),
         getAnimationState: () => instance.getAnimationState(),
         getFrameRate: () => instance.getFrameRate(),
+        // Mock has no histograms: null pointer means "no stats"
+        getFrameTimeStats: () => 0,
+        resetFrameTimeStats: () => {},
+        getFrameCounters: () => 0,
+        updateMorphTargets: () => {},
+        getAudioLatencyStats: () => 0,
+        getAudioLatencySamples: () => 0,
+        getAudioLatencySampleCapacity: () => 256,
+        getAudioLatencySampleCount: () => 0,
+        getAudioLatencySampleHead: () => 0,
+        resetAudioLatencyStats: () => {},
+        getMemoryStats: () => 0,
+        setPerfHudEnabled: () => {},
+        // No state/control blocks or morph buffer: controller falls back to calls
+        getEngineStateBlock: () => 0,
+        getMorphInputBuffer: () => 0,
+        getEngineControlBlock: () => 0,
+        // No PCM buffer either: the controller skips prosody pushes
+        getAudioInputBuffer: () => 0,
+        pushAudioSamples: () => {},
+        getMicrophoneRing: () => 0,
+        // No viseme planner: the mouth follows audio analysis only
+        planSpeechText: () => 0,
+        syncSpeechPlan: () => {},
+        alignSpeechPlan: () => 0,
+        getSpeechPlanTiming: () => 0,
+        setSpeechPlanTiming: () => 0,
+        // No speech stream input: replies play through the <audio> element
+        beginSpeechStream: () => {},
+        getSpeechByteInput: () => 0,
+        getSpeechByteCapacity: () => 0,
+        pushSpeechBytes: () => 0,
+        endSpeechBytes: () => 0,
+        nextSpeechFrame: () => 0,
+        getSpeechFrame: () => 0,
+        getSpeechSampleRate: () => 0,
+        getSpeechChannels: () => 0,
+        getSpeechPcmInput: () => 0,
+        pushSpeechPcm: () => {},
+        endSpeechStream: () => 0,
+        setSpeechPlayhead: () => {},
+        endSpeechPlayback: () => {},
+        // Mock logs straight to the console, so the ring is always empty
+        drainLog: () => 0,
+        getLogBuffer: () => 0,
+        getLogDroppedCount: () => 0,
         cleanup: () => instance.cleanup(),
         malloc: (size) => instance.malloc(size),
         free: (ptr) => instance.free(ptr),
@@ -0,0 +1,44 @@
+/**
+ * Microphone Capture Worklet - Forwards microphone PCM off the audio thread
+ *
+ * The node is created with one explicit channel, so the input arrives
+ * downmixed to mono. Every render quantum is copied into a batch, and
+ * each full batch is posted to the main thread, so every captured sample
+ * arrives there exactly once and in order.
+ *
+ * Messages out: { type: "pcm", samples } with BATCH_SAMPLES samples
+ *               (the buffer is transferred)
+ */
+
+const BATCH_SAMPLES = 512;
+
+class MicrophoneCaptureProcessor extends AudioWorkletProcessor {
+  constructor() {
+    super();
+    this.batch = new Float32Array(BATCH_SAMPLES);
+    this.filled = 0;
+  }
+
+  process(inputs) {
+    const input = inputs[0][0];
+    if (!input) return true;  // nothing connected (or the track ended)
+
+    let offset = 0;
+    while (offset < input.length) {
+      const count = Math.min(input.length - offset, BATCH_SAMPLES - this.filled);
+      this.batch.set(input.subarray(offset, offset + count), this.filled);
+      this.filled += count;
+      offset += count;
+      if (this.filled === BATCH_SAMPLES) {
+        this.port.postMessage({ type: "pcm", samples: this.batch }, [
+          this.batch.buffer,
+        ]);
+        this.batch = new Float32Array(BATCH_SAMPLES);
+        this.filled = 0;
+      }
+    }
+    return true;
+  }
+}
+
+registerProcessor("microphone-capture", MicrophoneCaptureProcessor);
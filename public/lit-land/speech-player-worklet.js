@@ -0,0 +1,99 @@
+/**
+ * Speech Player Worklet - Plays streamed speech PCM on the audio thread
+ *
+ * The main thread posts decoded mono chunks at the stream's sample rate
+ * as they come out of the decoder; this processor resamples them
+ * (linear) to the context rate. Playback starts once START_SECONDS are
+ * buffered, or the stream has ended, so a slow network does not stutter
+ * at the start. An underrun plays silence and holds the position.
+ *
+ * Messages in:  { type: "format", sampleRate }, { type: "pcm", samples },
+ *               { type: "end" }, { type: "stop" }
+ * Messages out: { type: "position", played, time } about every 20 ms,
+ *               played in source samples at context time `time`;
+ *               { type: "done" } after the last sample.
+ */
+
+const START_SECONDS = 0.1;
+const REPORT_SECONDS = 0.02;
+
+class SpeechPlayerProcessor extends AudioWorkletProcessor {
+  constructor() {
+    super();
+    this.chunks = [];
+    this.buffered = 0;     // source samples queued
+    this.position = 0;     // fractional read position in chunks[0]
+    this.consumed = 0;     // source samples of chunks already dropped
+    this.step = 1;         // source samples per output sample
+    this.sourceRate = sampleRate;
+    this.started = false;
+    this.ended = false;
+    this.sinceReport = 0;
+
+    this.port.onmessage = (event) => {
+      const message = event.data;
+      if (message.type === "format") {
+        this.sourceRate = message.sampleRate;
+        this.step = message.sampleRate / sampleRate;
+      } else if (message.type === "pcm") {
+        this.chunks.push(message.samples);
+        this.buffered += message.samples.length;
+      } else if (message.type === "end") {
+        this.ended = true;
+      } else if (message.type === "stop") {
+        this.chunks = [];
+        this.buffered = 0;
+        this.ended = true;
+      }
+    };
+  }
+
+  process(inputs, outputs) {
+    const out = outputs[0][0];
+    if (!this.started) {
+      this.started =
+        this.ended || this.buffered >= START_SECONDS * this.sourceRate;
+      if (!this.started) return true;
+    }
+
+    for (let i = 0; i < out.length; i++) {
+      const chunk = this.chunks[0];
+      if (!chunk) {
+        out[i] = 0;  // underrun (or finished): hold the position
+        continue;
+      }
+      const index = Math.floor(this.position);
+      const frac = this.position - index;
+      const a = chunk[index];
+      const next = index + 1 < chunk.length ? chunk[index + 1] : this.chunks[1]?.[0];
+      out[i] = next === undefined ? a : a + (next - a) * frac;
+
+      this.position += this.step;
+      while (this.chunks.length > 0 && this.position >= this.chunks[0].length) {
+        const done = this.chunks.shift();
+        this.position -= done.length;
+        this.consumed += done.length;
+        this.buffered -= done.length;
+      }
+    }
+    for (let c = 1; c < outputs[0].length; c++) outputs[0][c].set(out);
+
+    const finished = this.ended && this.chunks.length === 0;
+    this.sinceReport += out.length / sampleRate;
+    if (this.sinceReport >= REPORT_SECONDS || finished) {
+      this.sinceReport = 0;
+      this.port.postMessage({
+        type: "position",
+        played: this.consumed + this.position,
+        time: currentTime,
+      });
+    }
+    if (finished) {
+      this.port.postMessage({ type: "done" });
+      return false;
+    }
+    return true;
+  }
+}
+
+registerProcessor("speech-player", SpeechPlayerProcessor);